@@ -166,6 +166,11 @@ void CacheBase::updateCompactCacheStats(const std::string& statPrefix,
   counters_.updateDelta(prefix + "timeout.lock", stats.lockTimeout);
   counters_.updateDelta(prefix + "timeout.promote", stats.promoteTimeout);
 
+  counters_.updateDelta(prefix + "resize.lazy_migrations",
+                        stats.resizeLazyMigrations);
+  counters_.updateDelta(prefix + "resize.sweep_migrations",
+                        stats.resizeSweepMigrations);
+
   const double hitRate =
       util::hitRatioCalc(counters_.getDelta(prefix + "get.total"),
                          counters_.getDelta(prefix + "get.miss"));
@@ -194,6 +199,16 @@ void CacheBase::updateNvmCacheStats(const std::string& statPrefix) const {
   }
 }
 
+void CacheBase::updateContentStats(const std::string& statPrefix) const {
+  const auto stats = getContentStats();
+  if (stats.sampleTime == 0) {
+    return;
+  }
+  stats.visit({[this, &statPrefix](folly::StringPiece name, double val) {
+    counters_.updateCount(statPrefix + name.str(), static_cast<uint64_t>(val));
+  }});
+}
+
 void CacheBase::updateGlobalCacheStats(const std::string& statPrefix) const {
   auto getPct = [](uint64_t s, uint64_t d) {
     double res = d == 0 ? 0.0 : (s * 100.0 / d);
@@ -332,6 +347,23 @@ void CacheBase::updateGlobalCacheStats(const std::string& statPrefix) const {
   counters_.updateDelta(statPrefix + "reaper.skipped_slabs",
                         stats.numReaperSkippedSlabs);
 
+  counters_.updateDelta(statPrefix + "compression.compressed_items",
+                        stats.numItemsCompressed);
+  counters_.updateDelta(statPrefix + "compression.skipped_items",
+                        stats.numItemCompressSkipped);
+  counters_.updateDelta(statPrefix + "compression.decompressed_items",
+                        stats.numItemsDecompressed);
+  counters_.updateDelta(statPrefix + "compression.decompress_failures",
+                        stats.numItemDecompressFailures);
+  counters_.updateDelta(statPrefix + "compression.input_bytes",
+                        stats.itemCompressInputBytes);
+  counters_.updateDelta(statPrefix + "compression.output_bytes",
+                        stats.itemCompressOutputBytes);
+  counters_.updateDelta(statPrefix + "compression.compress_time_ns",
+                        stats.itemCompressTimeNs);
+  counters_.updateDelta(statPrefix + "compression.decompress_time_ns",
+                        stats.itemDecompressTimeNs);
+
   counters_.updateDelta(statPrefix + "rebalancer.runs",
                         stats.rebalancerStats.numRuns);
   counters_.updateDelta(statPrefix + "rebalancer.rebalanced_slabs",
@@ -388,6 +420,8 @@ void CacheBase::updateGlobalCacheStats(const std::string& statPrefix) const {
                         stats.cacheInstanceUpTime);
   counters_.updateCount(statPrefix + "ram.uptime", stats.ramUpTime);
   counters_.updateCount(statPrefix + "nvm.uptime", stats.nvmUpTime);
+  counters_.updateCount(statPrefix + "ram.prefault_time_ms",
+                        stats.ramPrefaultTimeMs);
   counters_.updateCount(statPrefix + "ram.new_cache", stats.isNewRamCache);
   counters_.updateCount(statPrefix + "nvm.new_cache", stats.isNewNvmCache);
   counters_.updateCount(statPrefix + "cache.new_cache",
@@ -426,6 +460,14 @@ void CacheBase::updateGlobalCacheStats(const std::string& statPrefix) const {
                           stats.numNvmAbortedPutOnInflightGet);
     counters_.updateDelta(statPrefix + "nvm.puts.encode_failure",
                           stats.numNvmPutEncodeFailure);
+    counters_.updateDelta(statPrefix + "nvm.puts.async",
+                          stats.numNvmAsyncPuts);
+    counters_.updateDelta(statPrefix + "nvm.puts.async_dropped",
+                          stats.numNvmAsyncPutDrops);
+    counters_.updateDelta(statPrefix + "nvm.puts.async_failed",
+                          stats.numNvmAsyncPutFailures);
+    counters_.updateDelta(statPrefix + "nvm.puts.async_queue_delay_ns",
+                          stats.nvmAsyncPutQueueDelayNs);
 
     counters_.updateDelta(statPrefix + "nvm.evictions.clean",
                           stats.numNvmCleanEvict);
@@ -538,6 +580,7 @@ void CacheBase::exportStats(
   updateGlobalCacheStats(statPrefix);
   updateNvmCacheStats(statPrefix);
   updateEventTrackerStats(statPrefix);
+  updateContentStats(statPrefix);
 
   for (const auto pid : getRegularPoolIds()) {
     updatePoolStats(statPrefix, pid);
@@ -23,6 +23,7 @@
 
 #include "cachelib/allocator/CacheDetails.h"
 #include "cachelib/allocator/CacheStats.h"
+#include "cachelib/allocator/ContentSampling.h"
 #include "cachelib/allocator/ICompactCache.h"
 #include "cachelib/allocator/memory/MemoryAllocator.h"
 #include "cachelib/common/Hash.h"
@@ -137,6 +138,9 @@ class CacheBase {
   // @return the slab release stats.
   virtual SlabReleaseStats getSlabReleaseStats() const = 0;
 
+  // @return the report of the last run of the content sampler, if any
+  virtual CacheContentStats getContentStats() const { return {}; }
+
   // export stats via callback. This function is not thread safe
   //
   // @param statPrefix prefix to be added for stat names
@@ -317,6 +321,9 @@ class CacheBase {
   // Update object cache stats
   void updateObjectCacheStats(const std::string& statPrefix) const;
 
+  // Update the content distributions of the pools
+  void updateContentStats(const std::string& statPrefix) const;
+
   // Util method to visit estimates
   static void visitEstimates(const util::CounterVisitor& v,
                              const util::PercentileStats::Estimates& est,
@@ -26,12 +26,19 @@
 #include <folly/synchronization/SanitizeThread.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstring>
+#include <exception>
 #include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <queue>
 #include <stdexcept>
+#include <thread>
 #include <utility>
 
 #pragma GCC diagnostic push
@@ -51,6 +58,7 @@
 #include "cachelib/allocator/CacheTraits.h"
 #include "cachelib/allocator/CacheVersion.h"
 #include "cachelib/allocator/ChainedAllocs.h"
+#include "cachelib/allocator/ContentSampler.h"
 #include "cachelib/allocator/ICompactCache.h"
 #include "cachelib/allocator/KAllocation.h"
 #include "cachelib/allocator/MemoryMonitor.h"
@@ -61,6 +69,7 @@
 #include "cachelib/allocator/PoolRebalancer.h"
 #include "cachelib/allocator/PoolResizer.h"
 #include "cachelib/allocator/ReadOnlySharedCacheView.h"
+#include "cachelib/allocator/ItemCompressor.h"
 #include "cachelib/allocator/Reaper.h"
 #include "cachelib/allocator/RebalanceStrategy.h"
 #include "cachelib/allocator/Refcount.h"
@@ -93,6 +102,9 @@ class FbInternalRuntimeUpdateWrapper;
 template <typename K, typename V, typename C>
 class ReadOnlyMap;
 
+template <typename C>
+struct ValueDedupAPIWrapper;
+
 namespace objcache {
 template <typename CacheDescriptor, typename AllocatorRes>
 class deprecated_ObjectCache;
@@ -263,6 +275,31 @@ class CacheAllocator : public CacheBase {
     bool fromNvm_ = false;
   };
 
+  // a record for bulkInsert() and exportHotItems(). The memory backing the
+  // key and the value is owned by the caller.
+  struct BulkInsertRecord {
+    folly::StringPiece key;
+    folly::StringPiece value;
+
+    // Time To Live(second) for the item, 0 means no expiration time.
+    uint32_t ttlSecs{0};
+
+    // hotness of the item, 0 being the hottest. Hotter items end up closer
+    // to the head of their MMContainer.
+    uint32_t rank{0};
+  };
+
+  struct BulkInsertResult {
+    // number of items inserted and accessible now
+    uint64_t numInserted{0};
+
+    // number of records skipped since the key was already in the cache
+    uint64_t numExisting{0};
+
+    // number of records that could not be allocated
+    uint64_t numAllocFailures{0};
+  };
+
   // holds information about removal, used in RemoveCb
   struct RemoveCbData {
     // remove or eviction
@@ -532,6 +569,47 @@ class CacheAllocator : public CacheBase {
   // @return handle to the old item that had been replaced
   WriteHandle insertOrReplace(const WriteHandle& handle);
 
+  // Inserts many items at once, e.g. to warm up a new cache with the items
+  // exported from another one through exportHotItems(). This is much faster
+  // than allocate() and insert() for every item:
+  //  - records are grouped by allocation class and the classes are spread
+  //    over @numThreads threads, so threads do not contend on the allocation
+  //    class and MMContainer locks.
+  //  - items of a class are allocated in batches of about a slab and each
+  //    batch is added to the MMContainer with one lock acquisition, coldest
+  //    first so that the hottest ones end up at the head.
+  //  - a batch is inserted into the hash table in the order of its buckets.
+  //
+  // Like insert(), existing keys are not replaced. Items that are not
+  // inserted are freed. Large inputs can be passed in chunks, from the
+  // coldest to the hottest one.
+  //
+  // @param pid         the pool to insert the items into
+  // @param records     the items to insert
+  // @param numThreads  number of threads to insert with
+  //
+  // @return the number of records inserted, skipped or failed
+  // @throw std::invalid_argument if nvmCache is enabled, if numThreads is 0 or
+  //        if any of the records is invalid for allocate(). Nothing is
+  //        inserted in that case.
+  // @throw any exception raised while inserting, on the calling thread after
+  //        all the threads are done. The items inserted until then are kept.
+  BulkInsertResult bulkInsert(PoolId pid,
+                              folly::Range<const BulkInsertRecord*> records,
+                              unsigned int numThreads = 1);
+
+  // Walks the cache and passes up to @maxItems of the most recently accessed
+  // items of pool @pid to @fn, to be loaded into another cache by
+  // bulkInsert(). Items are passed from the coldest to the hottest one, with
+  // their rank and remaining TTL. The record points into the item, which is
+  // only guaranteed to be alive during the call. Expired items and items
+  // with chained allocations are skipped.
+  //
+  // Keys of the exported items are held in memory while walking the cache.
+  void exportHotItems(PoolId pid,
+                      size_t maxItems,
+                      const std::function<void(const BulkInsertRecord&)>& fn);
+
   // look up an item by its key across the nvm cache as well if enabled.
   //
   // @param key       the key for lookup
@@ -623,6 +701,9 @@ class CacheAllocator : public CacheBase {
   // currently. The iterator internally holds a Handle to the item and hence
   // the keys that the iterator holds reference to, will not be evictable
   // until the iterator is destroyed.
+  //
+  // Items compressed by the item compressor are skipped, since their memory
+  // does not hold the value. They are accessible with find().
   AccessIterator begin() { return accessContainer_->begin(); }
 
   // return an iterator with a throttler for throttled iteration
@@ -726,6 +807,27 @@ class CacheAllocator : public CacheBase {
   //         Should be checked with SampleItem.isValid() before use
   SampleItem getSampleItem();
 
+  // Sample random allocations of the regular pools and build the
+  // distributions of the age, idle time, remaining TTL and size of the items
+  // in them, by pool and allocation class. The items are only read, they are
+  // neither locked nor promoted.
+  //
+  // @param config        number of samples and throttling
+  // @param shouldStop    checked while sampling to abort early
+  //
+  // @return the distributions of this run
+  // @throw std::invalid_argument if the config is invalid
+  CacheContentStats sampleContent(
+      const ContentSamplingConfig& config,
+      const std::function<bool()>& shouldStop = nullptr) const;
+
+  // @return the report of the last run of the background content sampler,
+  //         empty if it is not enabled. See
+  //         CacheAllocatorConfig::enableContentSampling
+  CacheContentStats getContentStats() const override {
+    return contentSampler_ ? contentSampler_->getStats() : CacheContentStats{};
+  }
+
   // Convert a Read Handle to an IOBuf. The returned IOBuf gives a
   // read-only view to the user. The item's ownership is retained by
   // the IOBuf until its destruction.
@@ -1083,6 +1185,18 @@ class CacheAllocator : public CacheBase {
   bool startNewReaper(std::chrono::milliseconds interval,
                       util::Throttler::Config reaperThrottleConfig);
 
+  // start item compressor
+  // @param interval                the period this worker fires
+  // @param config                  which items to compress and how
+  bool startNewItemCompressor(std::chrono::milliseconds interval,
+                              ItemCompressionConfig config);
+
+  // start content sampler
+  // @param interval                the period this worker fires
+  // @param config                  how many allocations to sample
+  bool startNewContentSampler(std::chrono::milliseconds interval,
+                              ContentSamplingConfig config);
+
   // start background promoter, starting/stopping of this worker
   // should not be done concurrently with addPool
   // @param interval                the period this worker fires
@@ -1111,6 +1225,10 @@ class CacheAllocator : public CacheBase {
                              0});
   bool stopMemMonitor(std::chrono::seconds timeout = std::chrono::seconds{0});
   bool stopReaper(std::chrono::seconds timeout = std::chrono::seconds{0});
+  bool stopItemCompressor(
+      std::chrono::seconds timeout = std::chrono::seconds{0});
+  bool stopContentSampler(
+      std::chrono::seconds timeout = std::chrono::seconds{0});
   bool stopBackgroundEvictor(
       std::chrono::seconds timeout = std::chrono::seconds{0});
   bool stopBackgroundPromoter(
@@ -1545,6 +1663,24 @@ class CacheAllocator : public CacheBase {
   //        creating this item handle.
   WriteHandle findInternalWithExpiration(Key key, AllocatorApiEvent event);
 
+  // Replace a compressed item with an inflated copy so that the caller can
+  // access the value. If another thread replaced or removed the item in the
+  // meantime, returns whatever the key maps to now.
+  //
+  // @param handle  handle to a compressed item
+  //
+  // @return handle to the uncompressed item, or nullptr if the key is gone or
+  //         there is no memory to inflate the item.
+  WriteHandle decompressItem(WriteHandle handle);
+
+  // Inflate a compressed item into a new item that is not inserted in the
+  // cache, for the APIs that return an item without looking it up:
+  // insertOrReplace(), inspectCache() and getSampleItem().
+  //
+  // @return handle to the uncompressed copy, or nullptr if there is no
+  //         memory for it.
+  WriteHandle copyDecompressed(const Item& item);
+
   // look up an item by its key across the nvm cache as well if enabled.
   //
   // @param key         the key for lookup
@@ -1719,6 +1855,20 @@ class CacheAllocator : public CacheBase {
   // @throw std::invalid_argument if the handle is already accessible or invalid
   bool insertImpl(const WriteHandle& handle, AllocatorApiEvent event);
 
+  // Inserts the records of one allocation class for bulkInsert(), in the
+  // order of @indices.
+  //
+  // @param pid      the pool to insert the items into
+  // @param cid      the allocation class of all the records
+  // @param records  all the records passed to bulkInsert()
+  // @param indices  the indices of the records of this class
+  // @param result   updated with the outcome of every record
+  void bulkInsertClass(PoolId pid,
+                       ClassId cid,
+                       folly::Range<const BulkInsertRecord*> records,
+                       const std::vector<size_t>& indices,
+                       BulkInsertResult& result);
+
   // Removes an item from the access container and MM container.
   //
   // @param hk               the hashed key for the item
@@ -1797,6 +1947,16 @@ class CacheAllocator : public CacheBase {
     return config_.eventTracker.get();
   }
 
+  FOLLY_ALWAYS_INLINE LatencyTracer* getLatencyTracer() const {
+    return config_.latencyTracer.get();
+  }
+
+  LockProfiler* getLockProfiler() const { return config_.lockProfiler.get(); }
+
+  // Hands the stats of their locks to the MM containers and allocation
+  // classes of the pool, if lock profiling is enabled.
+  void initPoolLockProfiling(PoolId pid);
+
   // Releases a slab from a pool into its corresponding memory pool
   // or back to the slab allocator, depending on SlabReleaseMode.
   //  SlabReleaseMode::kRebalance -> back to the pool
@@ -1880,6 +2040,13 @@ class CacheAllocator : public CacheBase {
   // @return true if it item expire and removed successfully.
   bool removeIfExpired(const ReadHandle& handle);
 
+  // exposed for the Reaper to drop the expired items at the tail of the TTL
+  // bands of the eviction queues in bulk, without walking the slabs. See
+  // MMLru::Config::ttlBandSecs.
+  //
+  // @return number of items removed
+  uint64_t reapExpiredTtlBands();
+
   // exposed for the Reaper to iterate through the memory and find items to
   // reap under the super charged mode. This is faster if there are lots of
   // items in cache and only a small fraction of them are expired at any given
@@ -1896,6 +2063,18 @@ class CacheAllocator : public CacheBase {
     stats().numReaperSkippedSlabs.add(slabsSkipped);
   }
 
+  // exposed for the ItemCompressor to compress up to batch cold items from
+  // the tail of the allocation class.
+  //
+  // @return number of items compressed
+  size_t compressColdItems(PoolId pid, ClassId cid, size_t batch);
+
+  // Replace an item marked as moving with a compressed copy. The item is
+  // unmarked and left in place if it is not worth compressing.
+  //
+  // @return true if the item was compressed
+  bool compressItem(Item& oldItem);
+
   // exposed for the background evictor to iterate through the memory and evict
   // in batch. This should improve insertion path for tiered memory config
   size_t traverseAndEvictItems(unsigned int /* pid */,
@@ -1939,11 +2118,14 @@ class CacheAllocator : public CacheBase {
         config.lockMemory};
   }
 
-  // starts one of the cache workers passing the current instance and the args
+  // starts one of the cache workers passing the current instance and the args.
+  // The worker runs on the background executor with the given priority if
+  // one is configured.
   template <typename T, typename... Args>
   bool startNewWorker(folly::StringPiece name,
                       std::unique_ptr<T>& worker,
                       std::chrono::milliseconds interval,
+                      BackgroundExecutor::Priority priority,
                       Args&&... args);
 
   // stops one of the workers belonging to this instance.
@@ -2018,6 +2200,10 @@ class CacheAllocator : public CacheBase {
   void initNvmCache(bool dramCacheAttached);
   void initWorkers();
 
+  // fault in the slab memory and the hash tables using
+  // config_.memoryPrefaultThreads threads. Blocks until done.
+  void prefaultMemory();
+
   // @param type        the type of initialization
   // @return nullptr if the type is invalid
   // @return pointer to memory allocator
@@ -2325,6 +2511,9 @@ class CacheAllocator : public CacheBase {
   // re-attach cache, this will be reset as well)
   const uint32_t cacheInstanceCreationTime_{0};
 
+  // time spent in prefaultMemory() when this instance was created
+  std::chrono::milliseconds memoryPrefaultTime_{0};
+
   // thread local accumulation of handle counts
   mutable util::FastStats<int64_t> handleCount_{};
 
@@ -2332,6 +2521,12 @@ class CacheAllocator : public CacheBase {
   // allocator's items reaper to evict expired items in bg checking
   std::unique_ptr<Reaper<CacheT>> reaper_;
 
+  // compresses cold items in the background
+  std::unique_ptr<ItemCompressor<CacheT>> itemCompressor_;
+
+  // samples the content of the cache in the background
+  std::unique_ptr<ContentSampler<CacheT>> contentSampler_;
+
   class DummyTlsActiveItemRingTag {};
   folly::ThreadLocal<TlsActiveItemRing, DummyTlsActiveItemRingTag> ring_;
 
@@ -2349,6 +2544,8 @@ class CacheAllocator : public CacheBase {
   // Make this friend to give access to acquire and release
   friend ReadHandle;
   friend ReaperAPIWrapper<CacheT>;
+  friend ItemCompressorAPIWrapper<CacheT>;
+  friend ValueDedupAPIWrapper<CacheT>;
   friend BackgroundMoverAPIWrapper<CacheT>;
   friend class CacheAPIWrapperForNvm<CacheT>;
   friend class FbInternalRuntimeUpdateWrapper<CacheT>;
@@ -2489,6 +2686,7 @@ ShmSegmentOpts CacheAllocator<CacheTrait>::createShmCacheOpts() {
     throw std::invalid_argument("CacheLib only supports a single memory tier");
   }
   opts.memBindNumaNodes = config_.memoryTierConfigs[0].getMemBind();
+  opts.filePath = config_.memoryTierConfigs[0].getFilePath();
   return opts;
 }
 
@@ -2544,6 +2742,22 @@ void CacheAllocator<CacheTrait>::initCommon(bool dramCacheAttached) {
     }
   }
   initStats();
+  if (auto* profiler = getLockProfiler()) {
+    accessContainer_->setLockStats(profiler->getStats("access_container"));
+    chainedItemAccessContainer_->setLockStats(
+        profiler->getStats("chained_item_access_container"));
+    // the pools restored from a previous instance
+    for (auto pid : allocator_->getPoolIds()) {
+      initPoolLockProfiling(pid);
+    }
+  }
+  // The memory of a compressed item does not hold its value, so iterators
+  // skip them. They can outlive the compressor across a restart.
+  accessContainer_->setIterationSkip(
+      [](const Item& item) { return item.isCompressed(); });
+  if (config_.memoryPrefaultThreads > 0) {
+    prefaultMemory();
+  }
   initNvmCache(dramCacheAttached);
 
   if (!config_.delayCacheWorkersStart) {
@@ -2551,6 +2765,48 @@ void CacheAllocator<CacheTrait>::initCommon(bool dramCacheAttached) {
   }
 }
 
+template <typename CacheTrait>
+void CacheAllocator<CacheTrait>::prefaultMemory() {
+  // Spread the workers across the NUMA nodes the cache memory is bound to so
+  // that the pages are zeroed by cpus local to the memory.
+  std::vector<int> numaNodes;
+  const auto& memBind = config_.memoryTierConfigs[0].getMemBind();
+  if (!memBind.empty()) {
+    for (int node = 0; node <= numa_max_node(); node++) {
+      if (numa_bitmask_isbitset(memBind.getNativeBitmask(), node)) {
+        numaNodes.push_back(node);
+      }
+    }
+  }
+  auto threadInit = [&numaNodes](unsigned int idx) {
+    if (!numaNodes.empty()) {
+      numa_run_on_node(numaNodes[idx % numaNodes.size()]);
+    }
+  };
+
+  util::Timer timer;
+  timer.startOrResume();
+  const auto numThreads = config_.memoryPrefaultThreads;
+  size_t bytes = allocator_->prefaultMemory(numThreads, threadInit);
+
+  // the hash tables are heap allocated and already written to when the cache
+  // is not on shared memory.
+  if (shmManager_) {
+    for (const auto& name :
+         {detail::kShmHashTableName, detail::kShmChainedItemHashTableName}) {
+      const auto& mapping = shmManager_->getShmByName(name).getCurrentMapping();
+      util::prefaultMemoryParallel(mapping.addr, mapping.size, numThreads,
+                                   threadInit);
+      bytes += mapping.size;
+    }
+  }
+
+  timer.pause();
+  memoryPrefaultTime_ = std::chrono::milliseconds{timer.getDurationMs()};
+  XLOGF(INFO, "Prefaulted {} bytes of cache memory in {} ms using {} threads",
+        bytes, memoryPrefaultTime_.count(), numThreads);
+}
+
 template <typename CacheTrait>
 void CacheAllocator<CacheTrait>::initNvmCache(bool dramCacheAttached) {
   if (!config_.nvmConfig.has_value()) {
@@ -2605,6 +2861,16 @@ void CacheAllocator<CacheTrait>::initWorkers() {
     startNewReaper(config_.reaperInterval, config_.reaperConfig);
   }
 
+  if (config_.itemCompressionEnabled() && !itemCompressor_) {
+    startNewItemCompressor(config_.itemCompressionInterval,
+                           config_.itemCompressionConfig);
+  }
+
+  if (config_.contentSamplingEnabled() && !contentSampler_) {
+    startNewContentSampler(config_.contentSamplingInterval,
+                           config_.contentSamplingConfig);
+  }
+
   if (config_.poolOptimizerEnabled() && !poolOptimizer_) {
     startNewPoolOptimizer(config_.regularPoolOptimizeInterval,
                           config_.compactCacheOptimizeInterval,
@@ -2629,6 +2895,10 @@ template <typename CacheTrait>
 std::unique_ptr<MemoryAllocator> CacheAllocator<CacheTrait>::initAllocator(
     InitMemType type) {
   if (type == InitMemType::kNone) {
+    if (config_.memoryTierConfigs[0].isFileBacked()) {
+      throw std::invalid_argument(
+          "File backed memory tiers need a shared memory backed cache.");
+    }
     if (isOnShm_ == true) {
       return std::make_unique<MemoryAllocator>(getAllocatorConfig(config_),
                                                tempShm_->getAddr(),
@@ -3433,12 +3703,22 @@ bool CacheAllocator<CacheTrait>::insertImpl(const WriteHandle& handle,
     throw std::invalid_argument("Can't use insert API with nvmCache enabled");
   }
 
+  ScopedTrace trace{getLatencyTracer(), TraceOp::kInsert, handle->getKey()};
+
   // insert into the MM container before we make it accessible. Find will
   // return this item as soon as it is accessible.
-  insertInMMContainer(*(handle.getInternal()));
+  {
+    ScopedTraceStage stage{TraceStage::kMMContainer};
+    insertInMMContainer(*(handle.getInternal()));
+  }
 
   AllocatorApiResult result;
-  if (!accessContainer_->insert(*(handle.getInternal()))) {
+  bool inserted;
+  {
+    ScopedTraceStage stage{TraceStage::kAccessContainer};
+    inserted = accessContainer_->insert(*(handle.getInternal()));
+  }
+  if (!inserted) {
     // this should destroy the handle and release it back to the allocator.
     removeFromMMContainer(*(handle.getInternal()));
     result = AllocatorApiResult::FAILED;
@@ -3464,13 +3744,18 @@ CacheAllocator<CacheTrait>::insertOrReplace(const WriteHandle& handle) {
   }
 
   HashedKey hk{handle->getKey()};
+  ScopedTrace trace{getLatencyTracer(), TraceOp::kInsert, hk.key()};
 
-  insertInMMContainer(*(handle.getInternal()));
+  {
+    ScopedTraceStage stage{TraceStage::kMMContainer};
+    insertInMMContainer(*(handle.getInternal()));
+  }
   WriteHandle replaced;
   try {
     auto lock = nvmCache_ ? nvmCache_->getItemDestructorLock(hk)
                           : std::unique_lock<TimedMutex>();
 
+    ScopedTraceStage stage{TraceStage::kAccessContainer};
     replaced = accessContainer_->insertOrReplace(*(handle.getInternal()));
 
     if (replaced && replaced->isNvmClean() && !replaced->isNvmEvicted()) {
@@ -3515,9 +3800,214 @@ CacheAllocator<CacheTrait>::insertOrReplace(const WriteHandle& handle) {
                          handle->getConfiguredTTL().count());
   }
 
+  if (UNLIKELY(replaced && replaced->isCompressed())) {
+    // the caller gets the value it replaced. The compressed item is freed
+    // once the handle is dropped.
+    replaced = copyDecompressed(*replaced);
+  }
   return replaced;
 }
 
+template <typename CacheTrait>
+typename CacheAllocator<CacheTrait>::BulkInsertResult
+CacheAllocator<CacheTrait>::bulkInsert(
+    PoolId pid,
+    folly::Range<const BulkInsertRecord*> records,
+    unsigned int numThreads) {
+  if (nvmCache_ != nullptr) {
+    throw std::invalid_argument("Can't use bulkInsert API with nvmCache enabled");
+  }
+  if (numThreads == 0) {
+    throw std::invalid_argument("bulkInsert needs at least one thread");
+  }
+
+  // group the records by allocation class. This also validates all of them
+  // before anything is allocated.
+  std::map<ClassId, std::vector<size_t>> classes;
+  for (size_t i = 0; i < records.size(); i++) {
+    const auto& record = records[i];
+    KAllocation::throwIfKeyInvalid(record.key);
+    const auto requiredSize = Item::getRequiredSize(
+        record.key, static_cast<uint32_t>(record.value.size()));
+    classes[allocator_->getAllocationClassId(pid, requiredSize)].push_back(i);
+  }
+
+  std::vector<std::pair<ClassId, std::vector<size_t>>> work;
+  work.reserve(classes.size());
+  for (auto& [cid, indices] : classes) {
+    // coldest first. Records of the same rank keep their order.
+    std::stable_sort(indices.begin(), indices.end(),
+                     [&records](size_t l, size_t r) {
+                       return records[l].rank > records[r].rank;
+                     });
+    work.emplace_back(cid, std::move(indices));
+  }
+  // start with the largest classes to balance the threads
+  std::sort(work.begin(), work.end(), [](const auto& l, const auto& r) {
+    return l.second.size() > r.second.size();
+  });
+
+  std::atomic<size_t> next{0};
+  std::vector<BulkInsertResult> results(
+      std::min<size_t>(numThreads, std::max<size_t>(work.size(), 1)));
+  // the first exception of every worker, rethrown by the calling thread once
+  // all the workers have joined
+  std::vector<std::exception_ptr> errors(results.size());
+  auto worker = [&](size_t t) {
+    try {
+      for (auto i = next++; i < work.size(); i = next++) {
+        bulkInsertClass(pid, work[i].first, records, work[i].second,
+                        results[t]);
+      }
+    } catch (...) {
+      errors[t] = std::current_exception();
+      // the other workers stop after their current class
+      next = work.size();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < results.size(); t++) {
+    threads.emplace_back(worker, t);
+  }
+  worker(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  BulkInsertResult total;
+  for (const auto& result : results) {
+    total.numInserted += result.numInserted;
+    total.numExisting += result.numExisting;
+    total.numAllocFailures += result.numAllocFailures;
+  }
+  return total;
+}
+
+template <typename CacheTrait>
+void CacheAllocator<CacheTrait>::bulkInsertClass(
+    PoolId pid,
+    ClassId cid,
+    folly::Range<const BulkInsertRecord*> records,
+    const std::vector<size_t>& indices,
+    BulkInsertResult& result) {
+  const size_t batchSize =
+      std::max<size_t>(1, Slab::kSize / allocator_->getAllocSize(pid, cid));
+  auto& mmContainer = getMMContainer(pid, cid);
+  auto eventTracker = getEventTracker();
+
+  std::vector<WriteHandle> handles;
+  std::vector<Item*> items;
+  handles.reserve(batchSize);
+  items.reserve(batchSize);
+  for (size_t start = 0; start < indices.size(); start += batchSize) {
+    const auto end = std::min(indices.size(), start + batchSize);
+    handles.clear();
+    items.clear();
+    for (size_t i = start; i < end; i++) {
+      const auto& record = records[indices[i]];
+      auto handle =
+          allocate(pid, record.key, static_cast<uint32_t>(record.value.size()),
+                   record.ttlSecs);
+      if (!handle) {
+        result.numAllocFailures++;
+        continue;
+      }
+      std::memcpy(handle->getMemory(), record.value.data(),
+                  record.value.size());
+      items.push_back(handle.getInternal());
+      handles.push_back(std::move(handle));
+    }
+
+    // same as insert(): the items go into the MMContainer before they are
+    // accessible. None of them can be there already.
+    const auto numAdded = mmContainer.addBatch(items.begin(), items.end());
+    if (numAdded != items.size()) {
+      throw std::runtime_error(folly::sformat(
+          "Invalid state. {} of {} nodes were already in the container.",
+          items.size() - numAdded, items.size()));
+    }
+
+    std::sort(handles.begin(), handles.end(),
+              [this](const WriteHandle& l, const WriteHandle& r) {
+                return accessContainer_->getBucketIdx(l->getKey()) <
+                       accessContainer_->getBucketIdx(r->getKey());
+              });
+    for (auto& handle : handles) {
+      AllocatorApiResult apiResult;
+      if (!accessContainer_->insert(*handle.getInternal())) {
+        // the allocation is released with the handle
+        removeFromMMContainer(*handle.getInternal());
+        result.numExisting++;
+        apiResult = AllocatorApiResult::FAILED;
+      } else {
+        handle.unmarkNascent();
+        result.numInserted++;
+        apiResult = AllocatorApiResult::INSERTED;
+      }
+      if (eventTracker) {
+        eventTracker->record(AllocatorApiEvent::INSERT, handle->getKey(),
+                             apiResult, handle->getSize(),
+                             handle->getConfiguredTTL().count());
+      }
+    }
+  }
+}
+
+template <typename CacheTrait>
+void CacheAllocator<CacheTrait>::exportHotItems(
+    PoolId pid,
+    size_t maxItems,
+    const std::function<void(const BulkInsertRecord&)>& fn) {
+  if (maxItems == 0) {
+    return;
+  }
+
+  // min-heap on the last access time that keeps the hottest items seen
+  using Entry = std::pair<uint32_t, std::string>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> hottest;
+  for (auto it = begin(); it != end(); ++it) {
+    if (it->isExpired() || it->hasChainedItem() ||
+        allocator_->getAllocInfo(it->getMemory()).poolId != pid) {
+      continue;
+    }
+    const auto accessTime = it->getLastAccessTime();
+    if (hottest.size() < maxItems) {
+      hottest.emplace(accessTime, it->getKey().str());
+    } else if (hottest.top().first < accessTime) {
+      hottest.pop();
+      hottest.emplace(accessTime, it->getKey().str());
+    }
+  }
+
+  // the heap pops the coldest item first
+  auto rank = static_cast<uint32_t>(hottest.size());
+  while (!hottest.empty()) {
+    rank--;
+    auto handle = peek(hottest.top().second);
+    hottest.pop();
+    const auto now = util::getCurrentTimeSec();
+    if (!handle || handle->isExpired(now)) {
+      continue;
+    }
+
+    BulkInsertRecord record;
+    record.key = handle->getKey();
+    record.value = folly::StringPiece{
+        reinterpret_cast<const char*>(handle->getMemory()), handle->getSize()};
+    if (handle->getExpiryTime() != 0) {
+      record.ttlSecs = std::max<uint32_t>(1, handle->getExpiryTime() - now);
+    }
+    record.rank = rank;
+    fn(record);
+  }
+}
+
 /* Next two methods are used to asynchronously move Item between Slabs.
  *
  * The thread, which moves Item, allocates new Item in the tier we are moving to
@@ -3593,14 +4083,22 @@ bool CacheAllocator<CacheTrait>::moveRegularItem(Item& oldItem,
     newItemHdl->markNvmClean();
   }
 
-  // Execute the move callback. We cannot make any guarantees about the
-  // consistency of the old item beyond this point, because the callback can
-  // do more than a simple memcpy() e.g. update external references. If there
-  // are any remaining handles to the old item, it is the caller's
-  // responsibility to invalidate them. The move can only fail after this
-  // statement if the old item has been removed or replaced, in which case it
-  // should be fine for it to be left in an inconsistent state.
-  config_.moveCb(oldItem, *newItemHdl, nullptr);
+  if (oldItem.isCompressed()) {
+    // The value is codec output that only the cache can interpret. Copy it
+    // as is instead of handing it to the move callback.
+    std::memcpy(newItemHdl->getMemory(), oldItem.getMemory(),
+                oldItem.getSize());
+    newItemHdl->markCompressed();
+  } else {
+    // Execute the move callback. We cannot make any guarantees about the
+    // consistency of the old item beyond this point, because the callback can
+    // do more than a simple memcpy() e.g. update external references. If
+    // there are any remaining handles to the old item, it is the caller's
+    // responsibility to invalidate them. The move can only fail after this
+    // statement if the old item has been removed or replaced, in which case
+    // it should be fine for it to be left in an inconsistent state.
+    config_.moveCb(oldItem, *newItemHdl, nullptr);
+  }
 
   // Adding the item to mmContainer has to succeed since no one can remove the
   // item
@@ -4151,7 +4649,12 @@ std::pair<typename CacheAllocator<CacheTrait>::ReadHandle,
           typename CacheAllocator<CacheTrait>::ReadHandle>
 CacheAllocator<CacheTrait>::inspectCache(typename Item::Key key) {
   std::pair<ReadHandle, ReadHandle> res;
-  res.first = findInternal(key);
+  auto handle = findInternal(key);
+  if (UNLIKELY(handle && handle->isCompressed())) {
+    // inspecting leaves the item compressed in the cache
+    handle = copyDecompressed(*handle);
+  }
+  res.first = std::move(handle);
   res.second = nvmCache_ ? nvmCache_->peek(key) : nullptr;
   return res;
 }
@@ -4172,7 +4675,11 @@ CacheAllocator<CacheTrait>::findInternalWithExpiration(
           event == AllocatorApiEvent::PEEK)
       << toString(event);
 
-  auto handle = findInternal(key);
+  WriteHandle handle;
+  {
+    ScopedTraceStage stage{TraceStage::kAccessContainer};
+    handle = findInternal(key);
+  }
   if (UNLIKELY(!handle)) {
     if (needToBumpStats) {
       stats_.numCacheGetMiss.inc();
@@ -4206,6 +4713,19 @@ CacheAllocator<CacheTrait>::findInternalWithExpiration(
     return ret;
   }
 
+  if (UNLIKELY(handle->isCompressed())) {
+    handle = decompressItem(std::move(handle));
+    if (!handle) {
+      if (needToBumpStats) {
+        stats_.numCacheGetMiss.inc();
+      }
+      if (eventTracker) {
+        eventTracker->record(event, key, AllocatorApiResult::NOT_FOUND);
+      }
+      return handle;
+    }
+  }
+
   if (eventTracker) {
     eventTracker->record(event, key, AllocatorApiResult::FOUND,
                          folly::Optional<uint32_t>(handle->getSize()),
@@ -4214,10 +4734,185 @@ CacheAllocator<CacheTrait>::findInternalWithExpiration(
   return handle;
 }
 
+template <typename CacheTrait>
+typename CacheAllocator<CacheTrait>::WriteHandle
+CacheAllocator<CacheTrait>::decompressItem(WriteHandle handle) {
+  while (handle && handle->isCompressed()) {
+    Item& item = *handle;
+    auto newItemHdl = copyDecompressed(item);
+    if (!newItemHdl) {
+      return WriteHandle{};
+    }
+
+    if (replaceIfAccessible(item, *newItemHdl)) {
+      newItemHdl.unmarkNascent();
+      stats_.numItemsDecompressed.inc();
+      return newItemHdl;
+    }
+
+    // Another thread inflated, replaced or removed the item before us. Use
+    // whatever is in the cache now.
+    handle = findInternal(item.getKey());
+  }
+  return handle;
+}
+
+template <typename CacheTrait>
+typename CacheAllocator<CacheTrait>::WriteHandle
+CacheAllocator<CacheTrait>::copyDecompressed(const Item& item) {
+  XDCHECK(item.isCompressed());
+  const folly::ByteRange compressed{
+      reinterpret_cast<const uint8_t*>(item.getMemory()), item.getSize()};
+  const auto allocInfo =
+      allocator_->getAllocInfo(static_cast<const void*>(&item));
+
+  auto newItemHdl = allocateInternal(allocInfo.poolId,
+                                     item.getKey(),
+                                     detail::getUncompressedSize(compressed),
+                                     item.getCreationTime(),
+                                     item.getExpiryTime());
+  if (!newItemHdl) {
+    stats_.numItemDecompressFailures.inc();
+    return newItemHdl;
+  }
+
+  const auto startTime = std::chrono::steady_clock::now();
+  detail::decompressItemValue(
+      compressed,
+      folly::MutableByteRange{
+          reinterpret_cast<uint8_t*>(newItemHdl->getMemory()),
+          newItemHdl->getSize()});
+  stats_.itemDecompressTimeNs.add(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - startTime)
+          .count());
+  return newItemHdl;
+}
+
+template <typename CacheTrait>
+size_t CacheAllocator<CacheTrait>::compressColdItems(PoolId pid,
+                                                     ClassId cid,
+                                                     size_t batch) {
+  const auto& compressionConfig = config_.itemCompressionConfig;
+  if (getPool(pid).getAllocSizes()[cid] < compressionConfig.minValueSize) {
+    // nothing in this allocation class is large enough to compress
+    return 0;
+  }
+
+  // Mark candidates from the tail as moving under the container lock so that
+  // nobody can hold a handle to them (and mutate them) while we compress,
+  // and readers wait for us to finish. Same as we do for slab release.
+  std::vector<Item*> candidates;
+  candidates.reserve(batch);
+  auto& mmContainer = getMMContainer(pid, cid);
+  mmContainer.withEvictionIterator([&](auto&& itr) {
+    for (size_t visited = 0; itr && visited < batch; ++itr, ++visited) {
+      Item* item = itr.get();
+      if (item->isChainedItem() || item->hasChainedItem() ||
+          item->isCompressed() ||
+          item->getSize() < compressionConfig.minValueSize) {
+        continue;
+      }
+      if (item->markMoving()) {
+        candidates.push_back(item);
+      }
+    }
+  });
+
+  size_t numCompressed = 0;
+  for (Item* item : candidates) {
+    if (compressItem(*item)) {
+      ++numCompressed;
+    }
+  }
+  return numCompressed;
+}
+
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::compressItem(Item& oldItem) {
+  XDCHECK(oldItem.isMoving());
+  const auto& compressionConfig = config_.itemCompressionConfig;
+  const auto allocInfo =
+      allocator_->getAllocInfo(static_cast<const void*>(&oldItem));
+
+  WriteHandle newItemHdl;
+  if (!oldItem.isExpired()) {
+    const auto startTime = std::chrono::steady_clock::now();
+    auto compressed = detail::compressItemValue(
+        compressionConfig.codec,
+        folly::ByteRange{reinterpret_cast<const uint8_t*>(oldItem.getMemory()),
+                         oldItem.getSize()},
+        static_cast<size_t>(oldItem.getSize() *
+                            compressionConfig.maxCompressionRatio));
+    stats_.itemCompressTimeNs.add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - startTime)
+            .count());
+
+    if (compressed) {
+      // Since oldItem has the moving bit set, it won't be picked for eviction
+      // to make room for its compressed copy.
+      newItemHdl = allocateInternal(allocInfo.poolId,
+                                    oldItem.getKey(),
+                                    compressed->length(),
+                                    oldItem.getCreationTime(),
+                                    oldItem.getExpiryTime(),
+                                    true /* fromBgThread */);
+    }
+    if (newItemHdl) {
+      std::memcpy(newItemHdl->getMemory(), compressed->data(),
+                  compressed->length());
+      newItemHdl->markCompressed();
+
+      auto& newContainer = getMMContainer(*newItemHdl);
+      auto mmContainerAdded = newContainer.add(*newItemHdl);
+      XDCHECK(mmContainerAdded);
+
+      if (accessContainer_->replaceIfAccessible(oldItem, *newItemHdl)) {
+        newItemHdl.unmarkNascent();
+        stats_.numItemsCompressed.inc();
+        stats_.itemCompressInputBytes.add(oldItem.getSize());
+        stats_.itemCompressOutputBytes.add(compressed->length());
+      } else {
+        // the item was removed or replaced while we were compressing it.
+        // Proceed the same way as a failed move for slab release.
+        newContainer.remove(*newItemHdl);
+        evictForSlabRelease(oldItem);
+        return false;
+      }
+    } else {
+      stats_.numItemCompressSkipped.inc();
+    }
+  }
+
+  if (!newItemHdl) {
+    // Leave the item in place. Hand waiters whatever the key maps to now,
+    // which is the item itself unless it got removed concurrently.
+    const std::string key = oldItem.getKey().str();
+    const auto ref = oldItem.unmarkMoving();
+    wakeUpWaiters(key, findInternal(key));
+    if (ref == 0) {
+      const auto res =
+          releaseBackToAllocator(oldItem, RemoveContext::kNormal, false);
+      XDCHECK(res == ReleaseRes::kReleased);
+    }
+    return false;
+  }
+
+  removeFromMMContainer(oldItem);
+  auto ref = unmarkMovingAndWakeUpWaiters(oldItem, std::move(newItemHdl));
+  XDCHECK_EQ(0u, ref);
+  (*stats_.fragmentationSize)[allocInfo.poolId][allocInfo.classId].sub(
+      util::getFragmentation(*this, oldItem));
+  allocator_->free(&oldItem);
+  return true;
+}
+
 template <typename CacheTrait>
 typename CacheAllocator<CacheTrait>::WriteHandle
 CacheAllocator<CacheTrait>::findFastImpl(typename Item::Key key,
                                          AccessMode mode) {
+  ScopedTrace trace{getLatencyTracer(), TraceOp::kFind, key};
   auto handle = findInternalWithExpiration(key, AllocatorApiEvent::FIND_FAST);
   if (!handle) {
     return handle;
@@ -4248,6 +4943,7 @@ CacheAllocator<CacheTrait>::findFastToWrite(typename Item::Key key) {
 template <typename CacheTrait>
 typename CacheAllocator<CacheTrait>::WriteHandle
 CacheAllocator<CacheTrait>::findImpl(typename Item::Key key, AccessMode mode) {
+  ScopedTrace trace{getLatencyTracer(), TraceOp::kFind, key};
   auto handle = findInternalWithExpiration(key, AllocatorApiEvent::FIND);
   if (handle) {
     markUseful(handle, mode);
@@ -4289,6 +4985,7 @@ void CacheAllocator<CacheTrait>::markUseful(const ReadHandle& handle,
     return;
   }
 
+  ScopedTraceStage stage{TraceStage::kMMContainer};
   auto& item = *(handle.getInternal());
   bool recorded = recordAccessInMMContainer(item, mode);
 
@@ -4353,6 +5050,16 @@ CacheAllocator<CacheTrait>::getSampleItem() {
     return SampleItem{false /* fromNvm */};
   }
 
+  if (UNLIKELY(item->isCompressed())) {
+    // sample the value rather than the codec output
+    auto copy = copyDecompressed(*item);
+    if (!copy) {
+      return SampleItem{false /* fromNvm */};
+    }
+    *sharedHdl = std::move(copy);
+    item = sharedHdl->get();
+  }
+
   const auto allocInfo = allocator_->getAllocInfo(item->getMemory());
 
   // Convert the Item to IOBuf to make SampleItem
@@ -4370,6 +5077,101 @@ CacheAllocator<CacheTrait>::getSampleItem() {
   return SampleItem(std::move(iobuf), allocInfo, false /* fromNvm */);
 }
 
+template <typename CacheTrait>
+CacheContentStats CacheAllocator<CacheTrait>::sampleContent(
+    const ContentSamplingConfig& config,
+    const std::function<bool()>& shouldStop) const {
+  config.validate();
+
+  CacheContentStats result;
+  const auto regularPoolIds = getRegularPoolIds();
+  for (const auto pid : regularPoolIds) {
+    result.poolStats[pid].poolName = getPoolName(pid);
+  }
+
+  // memory of a class and age of the tail of its eviction queue, looked up
+  // the first time the class is sampled
+  auto getClassStats = [&](const AllocInfo& info) -> ClassContentStats& {
+    auto& classStats = result.poolStats[info.poolId].classStats;
+    auto it = classStats.find(info.classId);
+    if (it == classStats.end()) {
+      it = classStats.emplace(info.classId, ClassContentStats{}).first;
+      it->second.allocSize = info.allocSize;
+      it->second.memorySize = allocator_->getPool(info.poolId)
+                                  .getAllocationClass(info.classId)
+                                  .getStats()
+                                  .totalSlabs() *
+                              Slab::kSize;
+    }
+    return it->second;
+  };
+  std::map<std::pair<PoolId, ClassId>, uint64_t> tailAgeSecs;
+  auto getTailAgeSecs = [&](const AllocInfo& info) {
+    auto key = std::make_pair(info.poolId, info.classId);
+    auto it = tailAgeSecs.find(key);
+    if (it == tailAgeSecs.end()) {
+      const auto age = getMMContainer(info.poolId, info.classId)
+                           .getEvictionAgeStat(0)
+                           .warmQueueStat.oldestElementAge;
+      it = tailAgeSecs.emplace(key, age).first;
+    }
+    return it->second;
+  };
+
+  // Like the reaper, we read the headers of random allocations without
+  // holding any locks. The item can be freed or moved while we look at it,
+  // which only skews the stats.
+  folly::annotate_ignore_thread_sanitizer_guard g(__FILE__, __LINE__);
+  util::Throttler t(config.throttlerConfig);
+  const auto now = util::getCurrentTimeSec();
+  for (uint32_t i = 0; i < config.samplesPerRun; i++) {
+    if (t.throttle() && shouldStop && shouldStop()) {
+      break;
+    }
+    result.numSamples++;
+    const auto* memory = allocator_->getRandomAlloc();
+    if (memory == nullptr) {
+      continue;
+    }
+    const auto allocInfo = allocator_->getAllocInfo(memory);
+    if (regularPoolIds.count(allocInfo.poolId) == 0) {
+      continue;
+    }
+    auto& stats = getClassStats(allocInfo);
+    stats.numSamples++;
+
+    const auto& item = *reinterpret_cast<const Item*>(memory);
+    if (!item.isAccessible() || item.isChainedItem() ||
+        Item::getRequiredSize(item.getKey(), 0 /* value size */) >
+            allocInfo.allocSize) {
+      continue;
+    }
+    stats.numItems++;
+
+    const auto creationTime = item.getCreationTime();
+    const auto lastAccessTime =
+        std::max(item.getLastAccessTime(), creationTime);
+    const auto idleSecs = now > lastAccessTime ? now - lastAccessTime : 0;
+    stats.ageSecs.add(now > creationTime ? now - creationTime : 0);
+    stats.idleSecs.add(idleSecs);
+    stats.itemSizeBytes.add(item.getTotalSize());
+    if (lastAccessTime == creationTime) {
+      stats.numNeverAccessed++;
+    }
+    if (item.isExpired(now)) {
+      stats.numExpired++;
+    } else if (item.getExpiryTime() != 0) {
+      stats.ttlRemainingSecs.add(item.getExpiryTime() - now);
+    }
+    if (idleSecs >= config.nearEvictionFraction * getTailAgeSecs(allocInfo)) {
+      stats.numNearEviction++;
+    }
+  }
+
+  result.sampleTime = now;
+  return result;
+}
+
 template <typename CacheTrait>
 std::vector<std::string> CacheAllocator<CacheTrait>::dumpEvictionIterator(
     PoolId pid, ClassId cid, size_t numItems) {
@@ -4700,6 +5502,24 @@ void CacheAllocator<CacheTrait>::createMMContainers(const PoolId pid,
             : 0);
     mmContainers_[pid][cid].reset(new MMContainer(config, compressor_));
   }
+  initPoolLockProfiling(pid);
+}
+
+template <typename CacheTrait>
+void CacheAllocator<CacheTrait>::initPoolLockProfiling(PoolId pid) {
+  auto* profiler = getLockProfiler();
+  if (profiler == nullptr) {
+    return;
+  }
+  const auto& pool = allocator_->getPool(pid);
+  for (unsigned int cid = 0; cid < pool.getNumClassId(); ++cid) {
+    mmContainers_[pid][cid]->setLockStats(profiler->getStats(
+        folly::sformat("mm_container.pool_{}.class_{}", pid, cid)));
+    allocator_->setLockStats(
+        pid, static_cast<ClassId>(cid),
+        profiler->getStats(
+            folly::sformat("allocation_class.pool_{}.class_{}", pid, cid)));
+  }
 }
 
 template <typename CacheTrait>
@@ -5010,7 +5830,8 @@ CacheAllocator<CacheTrait>::unmarkMovingAndWakeUpWaiters(Item& item,
 
 template <typename CacheTrait>
 bool CacheAllocator<CacheTrait>::moveForSlabRelease(Item& oldItem) {
-  if (!config_.moveCb) {
+  // compressed items are moved by the cache itself
+  if (!config_.moveCb && !oldItem.isCompressed()) {
     return false;
   }
 
@@ -5183,6 +6004,34 @@ bool CacheAllocator<CacheTrait>::removeIfExpired(const ReadHandle& handle) {
   return false;
 }
 
+template <typename CacheTrait>
+uint64_t CacheAllocator<CacheTrait>::reapExpiredTtlBands() {
+  // keys are collected under the container lock and the items are removed
+  // after releasing it.
+  constexpr size_t kBatchSize = 1024;
+  uint64_t numReaped = 0;
+  for (const auto pid : getRegularPoolIds()) {
+    const auto& pool = allocator_->getPool(pid);
+    for (unsigned int cid = 0; cid < pool.getNumClassId(); ++cid) {
+      auto& mmContainer = *mmContainers_[pid][cid];
+      uint64_t numReapedInBatch = 0;
+      std::vector<std::string> keys;
+      do {
+        numReapedInBatch = 0;
+        keys = mmContainer.getExpiredTtlBandKeys(kBatchSize);
+        for (const auto& key : keys) {
+          // items still in use are left to the regular reaping
+          if (removeIfExpired(findInternal(key))) {
+            numReapedInBatch++;
+          }
+        }
+        numReaped += numReapedInBatch;
+      } while (keys.size() == kBatchSize && numReapedInBatch > 0);
+    }
+  }
+  return numReaped;
+}
+
 template <typename CacheTrait>
 bool CacheAllocator<CacheTrait>::markMovingForSlabRelease(
     const SlabReleaseContext& ctx, void* alloc, util::Throttler& throttler) {
@@ -5434,6 +6283,8 @@ bool CacheAllocator<CacheTrait>::stopWorkers(std::chrono::seconds timeout) {
   success &= stopPoolResizer(timeout);
   success &= stopMemMonitor(timeout);
   success &= stopReaper(timeout);
+  success &= stopItemCompressor(timeout);
+  success &= stopContentSampler(timeout);
   success &= stopBackgroundEvictor(timeout);
   success &= stopBackgroundPromoter(timeout);
   return success;
@@ -5691,12 +6542,16 @@ GlobalCacheStats CacheAllocator<CacheTrait>::getGlobalCacheStats() const {
   ret.cacheInstanceUpTime = currTime - cacheInstanceCreationTime_;
   ret.ramUpTime = currTime - cacheCreationTime_;
   ret.nvmUpTime = currTime - nvmCacheState_.getCreationTime();
+  ret.ramPrefaultTimeMs = memoryPrefaultTime_.count();
   ret.nvmCacheEnabled = nvmCache_ ? nvmCache_->isEnabled() : false;
   ret.reaperStats = getReaperStats();
   ret.rebalancerStats = getRebalancerStats();
   ret.evictionStats = getBackgroundMoverStats(MoverDir::Evict);
   ret.promotionStats = getBackgroundMoverStats(MoverDir::Promote);
   ret.numActiveHandles = getNumActiveHandles();
+  if (auto* profiler = getLockProfiler()) {
+    ret.lockContention = profiler->getContentionStats();
+  }
 
   ret.isNewRamCache = cacheCreationTime_ == cacheInstanceCreationTime_;
   // NVM cache is new either if newly created or started fresh with truncate
@@ -5768,14 +6623,21 @@ bool CacheAllocator<CacheTrait>::startNewWorker(
     folly::StringPiece name,
     std::unique_ptr<T>& worker,
     std::chrono::milliseconds interval,
+    BackgroundExecutor::Priority priority,
     Args&&... args) {
   if (worker && !stopWorker(name, worker)) {
     return false;
   }
 
+  // the executor may be shared by several caches, tell their workers apart
+  const auto workerName =
+      config_.backgroundExecutor && !config_.cacheName.empty()
+          ? folly::sformat("{}.{}", config_.cacheName, name)
+          : name.str();
   std::lock_guard<std::mutex> l(workersMutex_);
-  return util::startPeriodicWorker(name, worker, interval,
-                                   std::forward<Args>(args)...);
+  return util::startPeriodicWorkerOnExecutor(
+      workerName, worker, interval, config_.backgroundExecutor, priority,
+      std::forward<Args>(args)...);
 }
 
 template <typename CacheTrait>
@@ -5783,8 +6645,9 @@ bool CacheAllocator<CacheTrait>::startNewPoolRebalancer(
     std::chrono::milliseconds interval,
     std::shared_ptr<RebalanceStrategy> strategy,
     unsigned int freeAllocThreshold) {
-  if (!startNewWorker("PoolRebalancer", poolRebalancer_, interval, *this,
-                      strategy, freeAllocThreshold)) {
+  if (!startNewWorker("PoolRebalancer", poolRebalancer_, interval,
+                      BackgroundExecutor::Priority::kNormal, *this, strategy,
+                      freeAllocThreshold)) {
     return false;
   }
 
@@ -5800,7 +6663,8 @@ bool CacheAllocator<CacheTrait>::startNewPoolResizer(
     std::chrono::milliseconds interval,
     unsigned int poolResizeSlabsPerIter,
     std::shared_ptr<RebalanceStrategy> strategy) {
-  if (!startNewWorker("PoolResizer", poolResizer_, interval, *this,
+  if (!startNewWorker("PoolResizer", poolResizer_, interval,
+                      BackgroundExecutor::Priority::kNormal, *this,
                       poolResizeSlabsPerIter, strategy)) {
     return false;
   }
@@ -5821,8 +6685,9 @@ bool CacheAllocator<CacheTrait>::startNewPoolOptimizer(
   // it should do actual size optimization. Probably need to move to using
   // the same interval for both, with confirmation of further experiments.
   const auto workerInterval = std::chrono::seconds(1);
-  if (!startNewWorker("PoolOptimizer", poolOptimizer_, workerInterval, *this,
-                      strategy, regularInterval.count(), ccacheInterval.count(),
+  if (!startNewWorker("PoolOptimizer", poolOptimizer_, workerInterval,
+                      BackgroundExecutor::Priority::kLow, *this, strategy,
+                      regularInterval.count(), ccacheInterval.count(),
                       ccacheStepSizePercent)) {
     return false;
   }
@@ -5840,7 +6705,8 @@ bool CacheAllocator<CacheTrait>::startNewMemMonitor(
     std::chrono::milliseconds interval,
     MemoryMonitor::Config config,
     std::shared_ptr<RebalanceStrategy> strategy) {
-  if (!startNewWorker("MemoryMonitor", memMonitor_, interval, *this, config,
+  if (!startNewWorker("MemoryMonitor", memMonitor_, interval,
+                      BackgroundExecutor::Priority::kHigh, *this, config,
                       strategy)) {
     return false;
   }
@@ -5855,7 +6721,8 @@ template <typename CacheTrait>
 bool CacheAllocator<CacheTrait>::startNewReaper(
     std::chrono::milliseconds interval,
     util::Throttler::Config reaperThrottleConfig) {
-  if (!startNewWorker("Reaper", reaper_, interval, *this,
+  if (!startNewWorker("Reaper", reaper_, interval,
+                      BackgroundExecutor::Priority::kNormal, *this,
                       reaperThrottleConfig)) {
     return false;
   }
@@ -5880,6 +6747,33 @@ auto CacheAllocator<CacheTrait>::createBgWorkerMemoryAssignments(
   return asssignedMemory;
 }
 
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::startNewItemCompressor(
+    std::chrono::milliseconds interval, ItemCompressionConfig config) {
+  if (!startNewWorker("ItemCompressor", itemCompressor_, interval,
+                      BackgroundExecutor::Priority::kLow, *this, config)) {
+    return false;
+  }
+
+  config_.itemCompressionInterval = interval;
+  config_.itemCompressionConfig = config;
+  return true;
+}
+
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::startNewContentSampler(
+    std::chrono::milliseconds interval, ContentSamplingConfig config) {
+  config.validate();
+  if (!startNewWorker("ContentSampler", contentSampler_, interval,
+                      BackgroundExecutor::Priority::kLow, *this, config)) {
+    return false;
+  }
+
+  config_.contentSamplingInterval = interval;
+  config_.contentSamplingConfig = config;
+  return true;
+}
+
 template <typename CacheTrait>
 bool CacheAllocator<CacheTrait>::startNewBackgroundEvictor(
     std::chrono::milliseconds interval,
@@ -5892,8 +6786,9 @@ bool CacheAllocator<CacheTrait>::startNewBackgroundEvictor(
   auto memoryAssignments = createBgWorkerMemoryAssignments(threads);
   for (size_t i = 0; i < threads; i++) {
     auto ret = startNewWorker("BackgroundEvictor" + std::to_string(i),
-                              backgroundEvictor_[i], interval, *this, strategy,
-                              MoverDir::Evict);
+                              backgroundEvictor_[i], interval,
+                              BackgroundExecutor::Priority::kHigh, *this,
+                              strategy, MoverDir::Evict);
     result = result && ret;
 
     if (result) {
@@ -5915,8 +6810,9 @@ bool CacheAllocator<CacheTrait>::startNewBackgroundPromoter(
   auto memoryAssignments = createBgWorkerMemoryAssignments(threads);
   for (size_t i = 0; i < threads; i++) {
     auto ret = startNewWorker("BackgroundPromoter" + std::to_string(i),
-                              backgroundPromoter_[i], interval, *this, strategy,
-                              MoverDir::Promote);
+                              backgroundPromoter_[i], interval,
+                              BackgroundExecutor::Priority::kLow, *this,
+                              strategy, MoverDir::Promote);
     result = result && ret;
 
     if (result) {
@@ -5986,6 +6882,26 @@ bool CacheAllocator<CacheTrait>::stopBackgroundEvictor(
   return result;
 }
 
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::stopItemCompressor(
+    std::chrono::seconds timeout) {
+  auto res = stopWorker("ItemCompressor", itemCompressor_, timeout);
+  if (res) {
+    config_.itemCompressionInterval = std::chrono::seconds{0};
+  }
+  return res;
+}
+
+template <typename CacheTrait>
+bool CacheAllocator<CacheTrait>::stopContentSampler(
+    std::chrono::seconds timeout) {
+  auto res = stopWorker("ContentSampler", contentSampler_, timeout);
+  if (res) {
+    config_.contentSamplingInterval = std::chrono::seconds{0};
+  }
+  return res;
+}
+
 template <typename CacheTrait>
 bool CacheAllocator<CacheTrait>::stopBackgroundPromoter(
     std::chrono::seconds timeout) {
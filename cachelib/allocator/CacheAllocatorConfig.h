@@ -29,6 +29,8 @@
 
 #include "cachelib/allocator/BackgroundMoverStrategy.h"
 #include "cachelib/allocator/Cache.h"
+#include "cachelib/allocator/ContentSampling.h"
+#include "cachelib/allocator/ItemCompression.h"
 #include "cachelib/allocator/MM2Q.h"
 #include "cachelib/allocator/MemoryMonitor.h"
 #include "cachelib/allocator/MemoryTierCacheConfig.h"
@@ -36,7 +38,10 @@
 #include "cachelib/allocator/PoolOptimizeStrategy.h"
 #include "cachelib/allocator/RebalanceStrategy.h"
 #include "cachelib/allocator/Util.h"
+#include "cachelib/common/BackgroundExecutor.h"
 #include "cachelib/common/EventInterface.h"
+#include "cachelib/common/LatencyTracer.h"
+#include "cachelib/common/LockProfiler.h"
 #include "cachelib/common/Throttler.h"
 
 namespace facebook {
@@ -208,6 +213,16 @@ class CacheAllocatorConfig {
   // If memory monitor is enabled, this is not usually needed.
   CacheAllocatorConfig& setMemoryLocking(bool enable);
 
+  // Synchronously fault in all of the cache memory and the hash tables at
+  // startup using numThreads threads, before the cache is handed out to the
+  // application. This avoids paying for page faults on the allocation path
+  // while the cache fills up after a cold start. If the cache memory is bound
+  // to NUMA nodes, the threads are spread across those nodes.
+  //
+  // Unlike setMemoryLocking, the constructor of the cache blocks until all of
+  // the memory is resident. Time spent is reported as ram.prefault_time_ms.
+  CacheAllocatorConfig& enableMemoryPrefault(unsigned int numThreads);
+
   // This allows cache to be persisted across restarts. One example use case is
   // to preserve the cache when releasing a new version of your service. Refer
   // to our user guide for how to set up cache persistence.
@@ -237,6 +252,29 @@ class CacheAllocatorConfig {
   CacheAllocatorConfig& enableItemReaperInBackground(
       std::chrono::milliseconds interval, util::Throttler::Config config = {});
 
+  // This turns on a background worker that periodically compresses cold
+  // items near the tail of each allocation class into a smaller allocation.
+  // Compressed items are inflated back transparently when they are looked
+  // up. Items with chained allocations are never compressed.
+  //
+  // Compression is only supported for dram-only caches without a remove
+  // callback or item destructor, since those would observe the compressed
+  // value. Compressed items are moved as they are on slab release, without
+  // the move callback, so the callback only sees uncompressed items. Like
+  // compressing an item, this changes the address of an item without
+  // notifying the application.
+  CacheAllocatorConfig& enableItemCompression(
+      std::chrono::milliseconds interval, ItemCompressionConfig config = {});
+
+  // This turns on a background worker that periodically samples random
+  // allocations and builds per pool and per allocation class distributions
+  // of the age, idle time, remaining TTL and size of the items, along with
+  // estimates of the expired and never accessed bytes. The report of the last
+  // run is available through CacheAllocator::getContentStats and is exported
+  // with the cache counters.
+  CacheAllocatorConfig& enableContentSampling(
+      std::chrono::milliseconds interval, ContentSamplingConfig config = {});
+
   // When using free memory monitoring mode, CacheAllocator shrinks the cache
   // size when the system is under memory pressure. Cache will grow back when
   // the memory pressure goes down.
@@ -333,6 +371,26 @@ class CacheAllocatorConfig {
   // starts
   CacheAllocatorConfig& setEventTracker(EventTrackerSharedPtr&&);
 
+  // Runs the background workers (pool rebalancer, resizer, optimizer, memory
+  // monitor, reaper, item compressor and background movers) as tasks on the
+  // given executor instead of a thread each. The executor can be shared by
+  // several caches and caps the CPU time the workers use together, see
+  // BackgroundExecutor.
+  CacheAllocatorConfig& setBackgroundExecutor(
+      std::shared_ptr<BackgroundExecutor> executor);
+
+  // Traces a sample of the find and insert operations through the DRAM
+  // cache, NvmCache and navy down to the device. The tracer aggregates the
+  // time spent in each stage and keeps the slow traces, see LatencyTracer.
+  // It can be shared by several caches.
+  CacheAllocatorConfig& setLatencyTracer(std::shared_ptr<LatencyTracer> tracer);
+
+  // Profiles the contention of the cache locks: the MM container and
+  // allocation class locks of each pool and class, the access container
+  // bucket locks, the NvmCache fill locks and the navy BlockCache locks. The
+  // stats are in the profiler and in GlobalCacheStats::lockContention.
+  CacheAllocatorConfig& setLockProfiler(std::shared_ptr<LockProfiler> profiler);
+
   // Set the minimum TTL for an item to be admitted into NVM cache.
   // If nvmAdmissionMinTTL is set to be positive, any item with configured TTL
   // smaller than this will always be rejected by NvmAdmissionPolicy.
@@ -393,6 +451,16 @@ class CacheAllocatorConfig {
     return reaperInterval.count() > 0;
   }
 
+  // @return whether the item compressor is enabled
+  bool itemCompressionEnabled() const noexcept {
+    return itemCompressionInterval.count() > 0;
+  }
+
+  // @return whether the content sampler is enabled
+  bool contentSamplingEnabled() const noexcept {
+    return contentSamplingInterval.count() > 0;
+  }
+
   const std::string& getCacheDir() const noexcept { return cacheDir; }
 
   const std::string& getCacheName() const noexcept { return cacheName; }
@@ -531,6 +599,16 @@ class CacheAllocatorConfig {
   // Callback for initializing the eventTracker on CacheAllocator construction.
   EventTrackerSharedPtr eventTracker{nullptr};
 
+  // executor running the background workers. Each worker has its own thread
+  // if not set.
+  std::shared_ptr<BackgroundExecutor> backgroundExecutor{nullptr};
+
+  // tracer of sampled operations. No tracing if not set.
+  std::shared_ptr<LatencyTracer> latencyTracer{nullptr};
+
+  // profiler of the cache locks. No profiling if not set.
+  std::shared_ptr<LockProfiler> lockProfiler{nullptr};
+
   // whether to allow tracking tail hits in MM2Q
   bool trackTailHits{false};
 
@@ -547,6 +625,18 @@ class CacheAllocatorConfig {
   // time to sleep between each reaping period.
   std::chrono::milliseconds reaperInterval{5000};
 
+  // which items the item compressor compresses and how
+  ItemCompressionConfig itemCompressionConfig{};
+
+  // time to sleep between runs of the item compressor. 0 to disable
+  std::chrono::milliseconds itemCompressionInterval{0};
+
+  // how many allocations the content sampler looks at and how fast
+  ContentSamplingConfig contentSamplingConfig{};
+
+  // time to sleep between runs of the content sampler. 0 to disable
+  std::chrono::milliseconds contentSamplingInterval{0};
+
   // interval during which we adjust dynamically the refresh ratio.
   std::chrono::milliseconds mmReconfigureInterval{0};
 
@@ -637,6 +727,10 @@ class CacheAllocatorConfig {
   // This option has no effect when attaching to existing cache.
   bool lockMemory{false};
 
+  // Number of threads used to fault in the cache memory when the cache is
+  // created or attached. 0 disables prefaulting.
+  unsigned int memoryPrefaultThreads{0};
+
   // These configs configure how MemoryAllocator will be generating
   // allocation class sizes for each pool by default
   double allocationClassSizeFactor{1.25};
@@ -922,6 +1016,13 @@ CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::setMemoryLocking(
   return *this;
 }
 
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableMemoryPrefault(
+    unsigned int numThreads) {
+  memoryPrefaultThreads = numThreads;
+  return *this;
+}
+
 template <typename T>
 CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableCachePersistence(
     std::string cacheDirectory, void* baseAddr) {
@@ -948,6 +1049,22 @@ CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableItemReaperInBackground(
   return *this;
 }
 
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableItemCompression(
+    std::chrono::milliseconds interval, ItemCompressionConfig config) {
+  itemCompressionInterval = interval;
+  itemCompressionConfig = config;
+  return *this;
+}
+
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::enableContentSampling(
+    std::chrono::milliseconds interval, ContentSamplingConfig config) {
+  contentSamplingInterval = interval;
+  contentSamplingConfig = config;
+  return *this;
+}
+
 template <typename T>
 CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::configureMemoryTiers(
     const MemoryTierConfigs& config) {
@@ -1098,6 +1215,27 @@ CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::setEventTracker(
   return *this;
 }
 
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::setBackgroundExecutor(
+    std::shared_ptr<BackgroundExecutor> executor) {
+  backgroundExecutor = std::move(executor);
+  return *this;
+}
+
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::setLatencyTracer(
+    std::shared_ptr<LatencyTracer> tracer) {
+  latencyTracer = std::move(tracer);
+  return *this;
+}
+
+template <typename T>
+CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::setLockProfiler(
+    std::shared_ptr<LockProfiler> profiler) {
+  lockProfiler = std::move(profiler);
+  return *this;
+}
+
 template <typename T>
 CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::setNvmAdmissionMinTTL(
     uint64_t ttl) {
@@ -1147,6 +1285,27 @@ const CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::validate() const {
         "It's not allowed to enable both RemoveCB and ItemDestructor.");
   }
 
+  // an evicted item is released before its async put is done, so whether it
+  // needs its destructor is not known yet
+  if (nvmConfig && nvmConfig->asyncPutThreads > 0 && itemDestructor) {
+    throw std::invalid_argument(
+        "Async nvm puts cannot be enabled with ItemDestructor.");
+  }
+
+  if (contentSamplingEnabled()) {
+    contentSamplingConfig.validate();
+  }
+
+  if (itemCompressionEnabled()) {
+    itemCompressionConfig.validate();
+    // compressed items can be evicted or removed in their compressed form
+    if (nvmConfig || removeCb || itemDestructor) {
+      throw std::invalid_argument(
+          "Item compression cannot be enabled with NvmCache, RemoveCB or "
+          "ItemDestructor.");
+    }
+  }
+
   return validateMemoryTiers();
 }
 
@@ -1183,6 +1342,19 @@ const CacheAllocatorConfig<T>& CacheAllocatorConfig<T>::validateMemoryTiers()
       throw std::invalid_argument("Tier ratio must be an integer number >=1.");
     }
     parts += tierConfig.getRatio();
+
+    if (tierConfig.isFileBacked()) {
+      if (cacheDir.empty()) {
+        throw std::invalid_argument(folly::sformat(
+            "File backed tier {} requires cache persistence to be enabled.",
+            tierConfig.getFilePath()));
+      }
+      if (!tierConfig.getMemBind().empty()) {
+        throw std::invalid_argument(folly::sformat(
+            "File backed tier {} can not be bound to numa nodes.",
+            tierConfig.getFilePath()));
+      }
+    }
   }
 
   if (parts > size) {
@@ -1245,6 +1417,15 @@ std::map<std::string, std::string> CacheAllocatorConfig<T>::serialize() const {
   configMap["reclaimRateLimitWindowSecs"] =
       std::to_string(memMonitorConfig.reclaimRateLimitWindowSecs.count());
   configMap["reaperInterval"] = util::toString(reaperInterval);
+  configMap["itemCompressionInterval"] =
+      util::toString(itemCompressionInterval);
+  configMap["contentSamplingInterval"] =
+      util::toString(contentSamplingInterval);
+  configMap["backgroundExecutor"] = backgroundExecutor ? "set" : "empty";
+  configMap["latencyTracerSampleRate"] =
+      latencyTracer ? std::to_string(latencyTracer->getConfig().sampleRate)
+                    : "0";
+  configMap["lockProfiler"] = lockProfiler ? "set" : "empty";
   configMap["mmReconfigureInterval"] = util::toString(mmReconfigureInterval);
   configMap["evictionSearchTries"] = std::to_string(evictionSearchTries);
   configMap["thresholdForConvertingToIOBuf"] =
@@ -1257,6 +1438,7 @@ std::map<std::string, std::string> CacheAllocatorConfig<T>::serialize() const {
   configMap["moveCb"] = moveCb ? "set" : "empty";
   configMap["enableZeroedSlabAllocs"] = std::to_string(enableZeroedSlabAllocs);
   configMap["lockMemory"] = std::to_string(lockMemory);
+  configMap["memoryPrefaultThreads"] = std::to_string(memoryPrefaultThreads);
   configMap["allocationClassSizeFactor"] =
       std::to_string(allocationClassSizeFactor);
   configMap["maxAllocationClassSize"] = std::to_string(maxAllocationClassSize);
@@ -1280,6 +1462,10 @@ std::map<std::string, std::string> CacheAllocatorConfig<T>::serialize() const {
                   "chainedItemAccessConfig");
   mergeWithPrefix(configMap, accessConfig.serialize(), "accessConfig");
   mergeWithPrefix(configMap, reaperConfig.serialize(), "reaperConfig");
+  mergeWithPrefix(configMap, itemCompressionConfig.serialize(),
+                  "itemCompressionConfig");
+  mergeWithPrefix(configMap, contentSamplingConfig.serialize(),
+                  "contentSamplingConfig");
   if (nvmConfig)
     mergeWithPrefix(configMap, nvmConfig->serialize(), "nvmConfig");
 
@@ -239,6 +239,12 @@ class CACHELIB_PACKED_ATTR CacheItem {
   void unmarkNvmEvicted() noexcept;
   bool isNvmEvicted() const noexcept;
 
+  /**
+   * Whether the value of this item is compressed. Lookups never return
+   * compressed items, but iterators and the slab walk can see them.
+   */
+  bool isCompressed() const noexcept;
+
   /**
    * Function to set the timestamp for when to expire an item
    *
@@ -389,6 +395,7 @@ class CACHELIB_PACKED_ATTR CacheItem {
   void unmarkIsChainedItem() noexcept;
   void markHasChainedItem() noexcept;
   void unmarkHasChainedItem() noexcept;
+  void markCompressed() noexcept;
   ChainedItem& asChainedItem() noexcept;
   const ChainedItem& asChainedItem() const noexcept;
 
@@ -714,12 +721,12 @@ std::string CacheItem<CacheTrait>::toString() const {
         "isMoving={}:references={}:ctime="
         "{}:"
         "expTime={}:updateTime={}:isNvmClean={}:isNvmEvicted={}:hasChainedItem="
-        "{}",
+        "{}:isCompressed={}",
         this, getRefCountAndFlagsRaw(), getSize(),
         folly::humanify(getKey().str()), folly::hexlify(getKey()),
         isInMMContainer(), isAccessible(), isMarkedForEviction(), isMoving(),
         getRefCount(), getCreationTime(), getExpiryTime(), getLastAccessTime(),
-        isNvmClean(), isNvmEvicted(), hasChainedItem());
+        isNvmClean(), isNvmEvicted(), hasChainedItem(), isCompressed());
   }
 }
 
@@ -844,6 +851,16 @@ bool CacheItem<CacheTrait>::isNvmEvicted() const noexcept {
   return ref_.isNvmEvicted();
 }
 
+template <typename CacheTrait>
+bool CacheItem<CacheTrait>::isCompressed() const noexcept {
+  return ref_.isCompressed();
+}
+
+template <typename CacheTrait>
+void CacheItem<CacheTrait>::markCompressed() noexcept {
+  ref_.markCompressed();
+}
+
 template <typename CacheTrait>
 void CacheItem<CacheTrait>::markIsChainedItem() noexcept {
   XDCHECK(!hasChainedItem());
@@ -50,7 +50,7 @@ struct SizeVerify {};
 
 void Stats::populateGlobalCacheStats(GlobalCacheStats& ret) const {
 #ifndef SKIP_SIZE_VERIFY
-  SizeVerify<sizeof(Stats)> a = SizeVerify<16368>{};
+  SizeVerify<sizeof(Stats)> a = SizeVerify<16464>{};
   std::ignore = a;
 #endif
   ret.numCacheGets = numCacheGets.get();
@@ -83,6 +83,10 @@ void Stats::populateGlobalCacheStats(GlobalCacheStats& ret) const {
   ret.numNvmDestructorRefcountOverflow = numNvmDestructorRefcountOverflow.get();
   ret.numNvmExpiredEvict = numNvmExpiredEvict.get();
   ret.numNvmPutFromClean = numNvmPutFromClean.get();
+  ret.numNvmAsyncPuts = numNvmAsyncPuts.get();
+  ret.numNvmAsyncPutDrops = numNvmAsyncPutDrops.get();
+  ret.numNvmAsyncPutFailures = numNvmAsyncPutFailures.get();
+  ret.nvmAsyncPutQueueDelayNs = nvmAsyncPutQueueDelayNs.get();
   ret.numNvmEvictions = numNvmEvictions.get();
 
   ret.numNvmEncryptionErrors = numNvmEncryptionErrors.get();
@@ -141,6 +145,15 @@ void Stats::populateGlobalCacheStats(GlobalCacheStats& ret) const {
   ret.numAbortedSlabReleases = numAbortedSlabReleases.get();
   ret.numReaperSkippedSlabs = numReaperSkippedSlabs.get();
 
+  ret.numItemsCompressed = numItemsCompressed.get();
+  ret.numItemCompressSkipped = numItemCompressSkipped.get();
+  ret.numItemsDecompressed = numItemsDecompressed.get();
+  ret.numItemDecompressFailures = numItemDecompressFailures.get();
+  ret.itemCompressInputBytes = itemCompressInputBytes.get();
+  ret.itemCompressOutputBytes = itemCompressOutputBytes.get();
+  ret.itemCompressTimeNs = itemCompressTimeNs.get();
+  ret.itemDecompressTimeNs = itemDecompressTimeNs.get();
+
   ret.numHandleWaitBlocks = numHandleWaitBlocks.get();
   ret.numExpensiveStatsPolled = numExpensiveStatsPolled.get();
 }
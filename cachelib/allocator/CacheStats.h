@@ -19,6 +19,7 @@
 #include <folly/container/F14Map.h>
 
 #include <algorithm>
+#include <map>
 #include <numeric>
 
 #include "cachelib/allocator/Util.h"
@@ -26,6 +27,7 @@
 #include "cachelib/allocator/memory/MemoryAllocatorStats.h"
 #include "cachelib/allocator/memory/Slab.h"
 #include "cachelib/common/FastStats.h"
+#include "cachelib/common/LockProfiler.h"
 #include "cachelib/common/PercentileStats.h"
 #include "cachelib/common/Time.h"
 
@@ -444,6 +446,16 @@ struct GlobalCacheStats {
   // number of puts to nvm of a clean item in RAM due to nvm eviction.
   uint64_t numNvmPutFromClean{0};
 
+  // number of puts to nvm run by the background threads, the ones dropped
+  // because the threads were behind and the ones that failed in the
+  // background, after the item was released.
+  uint64_t numNvmAsyncPuts{0};
+  uint64_t numNvmAsyncPutDrops{0};
+  uint64_t numNvmAsyncPutFailures{0};
+
+  // total nanoseconds the async puts waited for a background thread
+  uint64_t nvmAsyncPutQueueDelayNs{0};
+
   // attempts made from nvm cache to allocate an item for promotion
   uint64_t numNvmAllocAttempts{0};
 
@@ -523,6 +535,10 @@ struct GlobalCacheStats {
   // time since the nvm cache was created in seconds
   uint64_t nvmUpTime{0};
 
+  // time spent faulting in the cache memory when this instance was created.
+  // 0 if memory prefaulting is disabled.
+  uint64_t ramPrefaultTimeMs{0};
+
   // If true, it means ram cache is brand new, or it was not restored from a
   // previous cache instance
   bool isNewRamCache{false};
@@ -554,6 +570,25 @@ struct GlobalCacheStats {
   // Number of times slab was skipped when reaper runs
   uint64_t numReaperSkippedSlabs{0};
 
+  // Number of cold items replaced by a compressed copy, and number of items
+  // the compressor looked at but left alone because they did not compress
+  // well enough or there was no memory for the compressed copy.
+  uint64_t numItemsCompressed{0};
+  uint64_t numItemCompressSkipped{0};
+
+  // Number of compressed items inflated back on lookup, and number of
+  // lookups that missed because there was no memory to inflate the item.
+  uint64_t numItemsDecompressed{0};
+  uint64_t numItemDecompressFailures{0};
+
+  // Value bytes before and after compression of the compressed items
+  uint64_t itemCompressInputBytes{0};
+  uint64_t itemCompressOutputBytes{0};
+
+  // cpu time spent compressing and decompressing item values
+  uint64_t itemCompressTimeNs{0};
+  uint64_t itemDecompressTimeNs{0};
+
   // current active handles outstanding. This stat should
   // not go to negative. If it's negative, it means we have
   // leaked handles (or some sort of accounting bug internally)
@@ -562,6 +597,9 @@ struct GlobalCacheStats {
   // This stat tracks how many times wait() on ItemHandle blocks
   uint64_t numHandleWaitBlocks{0};
 
+  // contention of the cache locks by owner, if lock profiling is enabled
+  std::map<std::string, LockContentionStats> lockContention;
+
   // Number of times "expensive" cachelib stats are polled. This is useful as
   // polling these stats can be expensive. We shouldn't do it too often.
   uint64_t numExpensiveStatsPolled{0};
@@ -632,6 +670,10 @@ struct CCacheStats {
   uint64_t lockTimeout;
   uint64_t promoteTimeout;
 
+  // buckets migrated during a resize by requests vs by the background sweep
+  uint64_t resizeLazyMigrations;
+  uint64_t resizeSweepMigrations;
+
   double hitRatio() const;
 
   CCacheStats& operator+=(const CCacheStats& other) {
@@ -657,6 +699,9 @@ struct CCacheStats {
     lockTimeout += other.lockTimeout;
     promoteTimeout += other.promoteTimeout;
 
+    resizeLazyMigrations += other.resizeLazyMigrations;
+    resizeSweepMigrations += other.resizeSweepMigrations;
+
     return *this;
   }
 };
@@ -129,6 +129,14 @@ struct Stats {
   // nvmcache because the nvmcache version was evicted
   AtomicCounter numNvmPutFromClean{0};
 
+  // puts handed to the background threads, the ones dropped because the
+  // threads were behind, and the ones that did not make it to navy
+  AtomicCounter numNvmAsyncPuts{0};
+  AtomicCounter numNvmAsyncPutDrops{0};
+  AtomicCounter numNvmAsyncPutFailures{0};
+  // total time the async puts waited for a background thread
+  AtomicCounter nvmAsyncPutQueueDelayNs{0};
+
   // Decryption and Encryption errors
   AtomicCounter numNvmEncryptionErrors{0};
   AtomicCounter numNvmDecryptionErrors{0};
@@ -183,6 +191,16 @@ struct Stats {
   // Flag indicating the slab release stuck
   AtomicCounter numSlabReleaseStuck{0};
 
+  // compression of cold items
+  AtomicCounter numItemsCompressed{0};
+  AtomicCounter numItemCompressSkipped{0};
+  AtomicCounter numItemsDecompressed{0};
+  AtomicCounter numItemDecompressFailures{0};
+  AtomicCounter itemCompressInputBytes{0};
+  AtomicCounter itemCompressOutputBytes{0};
+  AtomicCounter itemCompressTimeNs{0};
+  AtomicCounter itemDecompressTimeNs{0};
+
   // allocations with invalid parameters
   AtomicCounter invalidAllocs{0};
 
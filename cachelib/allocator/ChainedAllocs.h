@@ -16,6 +16,7 @@
 
 #pragma once
 #include <stdexcept>
+#include <vector>
 namespace facebook {
 namespace cachelib {
 
@@ -34,17 +35,25 @@ class CacheChainedAllocs {
 
   // return the parent of the chain.
   const Item& getParentItem() const noexcept { return *parent_; }
-  // iterate and compute the length of the chain. This is O(N) computation.
+  // compute the length of the chain. This is O(N) computation, or O(1) once
+  // indexChain() was called.
   //
   // @return the length of the chain
   size_t computeChainLength() const {
+    if (!index_.empty()) {
+      return index_.size();
+    }
     const auto chain = getChain();
     return std::distance(chain.begin(), chain.end());
   }
 
   // return the nTh in the chain from the beginning. n = 0 is the first in the
-  // chain and last inserted.
+  // chain and last inserted. This walks the chain up to n, unless
+  // indexChain() was called.
   ChainedItem* getNthInChain(size_t n) {
+    if (!index_.empty()) {
+      return n < index_.size() ? index_[n] : nullptr;
+    }
     size_t i = 0;
     for (auto& c : getChain()) {
       if (i++ == n) {
@@ -54,6 +63,34 @@ class CacheChainedAllocs {
     return nullptr;
   }
 
+  // walk the chain once and remember every allocation, so that
+  // getNthInChain() and computeChainLength() are O(1) afterwards instead of
+  // chasing pointers across cold memory on every call. This costs a walk of
+  // the whole chain and a vector allocation, and only pays off for a view
+  // that is used for several random accesses. See
+  // benchmarks/ChainedAllocsBench.cpp.
+  void indexChain() {
+    if (!index_.empty()) {
+      return;
+    }
+    for (auto& c : getChain()) {
+      index_.push_back(&c);
+    }
+  }
+
+  // issue prefetches for the memory of every allocation in the chain. Useful
+  // before touching the whole value, since the loads for different chunks can
+  // then overlap instead of being serialized by the pointer chase.
+  void prefetchChain() const {
+    for (auto& c : getChain()) {
+      const auto* mem = reinterpret_cast<const char*>(c.getMemory());
+      const auto* end = mem + c.getSize();
+      for (; mem < end; mem += kCacheLineSize) {
+        __builtin_prefetch(mem, 0, 3);
+      }
+    }
+  }
+
   folly::Range<Iter> getChain() const {
     return folly::Range<Iter>{Iter{&head_, compressor_}, Iter{}};
   }
@@ -64,6 +101,8 @@ class CacheChainedAllocs {
   using ReadLockHolder = typename LockType::ReadLockHolder;
   using PtrCompressor = typename Item::PtrCompressor;
 
+  static constexpr size_t kCacheLineSize = 64;
+
   CacheChainedAllocs(const CacheChainedAllocs&) = delete;
   CacheChainedAllocs& operator=(const CacheChainedAllocs&) = delete;
 
@@ -103,6 +142,13 @@ class CacheChainedAllocs {
 
   // pointer compressor to traverse the chain.
   const PtrCompressor& compressor_;
+
+  // allocations in the chain, in the order of getChain(). Empty until
+  // indexChain() is called. The chain can not change underneath since we
+  // hold the chained item lock for the lifetime of this object, which
+  // addChainedItem, popChainedItem and slab release moves of chained items
+  // all need exclusively.
+  std::vector<ChainedItem*> index_;
 };
 } // namespace cachelib
 } // namespace facebook
@@ -19,6 +19,7 @@
 #include <folly/Optional.h>
 
 #include <cstdint>
+#include <functional>
 #include <map>
 #include <stdexcept>
 #include <type_traits>
@@ -526,6 +527,10 @@ class ChainedHashTable {
       return config_.getBucketsPower();
     }
 
+    // returns the index of the bucket that @key belongs to. Useful to order a
+    // batch of keys by their position in the table.
+    size_t getBucketIdx(Key key) const noexcept { return ht_.getBucket(key); }
+
     // Iterator interface for the hashtable. Iterates over the hashtable
     // bucket by bucket and takes a snapshot of the bucket to iterate over. It
     // guarantees that all keys that were present when the iteration started
@@ -650,6 +655,19 @@ class ChainedHashTable {
       return numKeys_.load(std::memory_order_relaxed);
     }
 
+    // Records the acquisitions of the bucket locks in the stats. Must be set
+    // before the container is used.
+    void setLockStats(LockStats* stats) noexcept {
+      locks_.setLockStats(stats);
+    }
+
+    // Elements for which @skip returns true are not visited by the
+    // iterators. It is called under the bucket lock. Must be set before the
+    // container is iterated.
+    void setIterationSkip(std::function<bool(const T&)> skip) {
+      iterationSkip_ = std::move(skip);
+    }
+
    private:
     using Hashtable = Impl<T, HookPtr>;
 
@@ -665,6 +683,9 @@ class ChainedHashTable {
     // handle maker to convert the T* to T::Handle
     HandleMaker handleMaker_;
 
+    // elements not visited by the iterators, if set
+    std::function<bool(const T&)> iterationSkip_;
+
     // the hashtable buckets
     Hashtable ht_;
 
@@ -1173,6 +1194,9 @@ void ChainedHashTable::Container<T, HookPtr, LockT>::getBucketElems(
   ht_.forEachBucketElem(bucket, [this, &handles](T* e) {
     try {
       XDCHECK(e);
+      if (iterationSkip_ && iterationSkip_(*e)) {
+        return;
+      }
       auto h = handleMaker_(e);
       if (h) {
         handles.emplace_back(std::move(h));
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/logging/xlog.h>
+
+#include "cachelib/allocator/ContentSampling.h"
+#include "cachelib/common/AtomicCounter.h"
+#include "cachelib/common/PeriodicWorker.h"
+
+namespace facebook::cachelib {
+// Periodically samples random allocations of the cache and keeps the
+// distributions of the last run, so that they can be exported as counters
+// without sampling on the stats path.
+template <typename CacheT>
+class ContentSampler : public PeriodicWorker {
+ public:
+  using Cache = CacheT;
+  // @param cache   the cache interface
+  // @param config  how many allocations to sample and how fast
+  ContentSampler(Cache& cache, const ContentSamplingConfig& config)
+      : cache_(cache), config_(config) {}
+
+  ~ContentSampler() override { stop(std::chrono::seconds(0)); }
+
+  // @return the report of the last run
+  CacheContentStats getStats() const { return *stats_.rlock(); }
+
+  uint64_t getNumRuns() const noexcept { return numRuns_.get(); }
+
+ private:
+  // implements the actual logic of running the sampler
+  void work() override final {
+    try {
+      auto stats = cache_.sampleContent(config_, [this]() {
+        return shouldStopWork();
+      });
+      // keep the report of the last complete run
+      if (shouldStopWork()) {
+        return;
+      }
+      *stats_.wlock() = std::move(stats);
+      numRuns_.inc();
+    } catch (const std::exception& ex) {
+      XLOGF(ERR, "ContentSampler interrupted due to exception: {}", ex.what());
+    }
+  }
+
+  Cache& cache_;
+  const ContentSamplingConfig config_;
+  folly::Synchronized<CacheContentStats> stats_;
+  AtomicCounter numRuns_{0};
+};
+} // namespace facebook::cachelib
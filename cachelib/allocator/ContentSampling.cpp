@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/allocator/ContentSampling.h"
+
+#include <folly/Bits.h>
+#include <folly/Format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace facebook::cachelib {
+
+const ContentSamplingConfig& ContentSamplingConfig::validate() const {
+  if (samplesPerRun == 0) {
+    throw std::invalid_argument("Content sampling needs samplesPerRun > 0");
+  }
+  if (nearEvictionFraction <= 0 || nearEvictionFraction > 1) {
+    throw std::invalid_argument(folly::sformat(
+        "Content sampling near eviction fraction must be in (0, 1], got {}",
+        nearEvictionFraction));
+  }
+  return *this;
+}
+
+std::map<std::string, std::string> ContentSamplingConfig::serialize() const {
+  std::map<std::string, std::string> configMap;
+  configMap["samplesPerRun"] = std::to_string(samplesPerRun);
+  configMap["nearEvictionFraction"] = std::to_string(nearEvictionFraction);
+  for (const auto& [key, value] : throttlerConfig.serialize()) {
+    configMap["throttler." + key] = value;
+  }
+  return configMap;
+}
+
+size_t ContentHistogram::getBucket(uint64_t value) noexcept {
+  return std::min<size_t>(folly::findLastSet(value), kNumBuckets - 1);
+}
+
+void ContentHistogram::merge(const ContentHistogram& other) noexcept {
+  for (size_t i = 0; i < kNumBuckets; i++) {
+    counts[i] += other.counts[i];
+  }
+}
+
+uint64_t ContentHistogram::total() const noexcept {
+  uint64_t total = 0;
+  for (auto count : counts) {
+    total += count;
+  }
+  return total;
+}
+
+uint64_t ContentHistogram::percentile(double fraction) const noexcept {
+  const auto total = this->total();
+  if (total == 0) {
+    return 0;
+  }
+  // rank of the value, with some slack for the rounding of the fraction
+  const auto target = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(fraction * total - 1e-6)));
+  uint64_t seen = 0;
+  size_t i = 0;
+  for (; i < kNumBuckets - 1; i++) {
+    seen += counts[i];
+    if (seen >= target) {
+      break;
+    }
+  }
+  return (uint64_t{1} << i) - 1;
+}
+
+void ClassContentStats::merge(const ClassContentStats& other) noexcept {
+  memorySize += other.memorySize;
+  numSamples += other.numSamples;
+  numItems += other.numItems;
+  numExpired += other.numExpired;
+  numNeverAccessed += other.numNeverAccessed;
+  numNearEviction += other.numNearEviction;
+  ageSecs.merge(other.ageSecs);
+  idleSecs.merge(other.idleSecs);
+  ttlRemainingSecs.merge(other.ttlRemainingSecs);
+  itemSizeBytes.merge(other.itemSizeBytes);
+}
+
+ClassContentStats PoolContentStats::aggregate() const noexcept {
+  // The classes get samples in proportion to their memory, so the sum of
+  // their samples is a uniform sample of the pool. The byte estimates of the
+  // sum extrapolate to the memory of the whole pool.
+  ClassContentStats total;
+  for (const auto& [cid, stats] : classStats) {
+    total.merge(stats);
+  }
+  return total;
+}
+
+namespace {
+void visitClassStats(const util::CounterVisitor& visitor,
+                     const ClassContentStats& stats,
+                     const std::string& prefix,
+                     bool withDistributions) {
+  visitor(prefix + "samples", stats.numSamples);
+  visitor(prefix + "items", stats.numItems);
+  visitor(prefix + "expired_bytes", stats.expiredBytes());
+  visitor(prefix + "dead_bytes", stats.deadBytes());
+  visitor(prefix + "near_eviction_bytes", stats.nearEvictionBytes());
+  if (!withDistributions) {
+    return;
+  }
+  auto visitHistogram = [&](const ContentHistogram& histogram,
+                            folly::StringPiece name) {
+    visitor(folly::sformat("{}{}.p50", prefix, name),
+            histogram.percentile(0.5));
+    visitor(folly::sformat("{}{}.p90", prefix, name),
+            histogram.percentile(0.9));
+    visitor(folly::sformat("{}{}.p99", prefix, name),
+            histogram.percentile(0.99));
+  };
+  visitHistogram(stats.ageSecs, "age_secs");
+  visitHistogram(stats.idleSecs, "idle_secs");
+  visitHistogram(stats.ttlRemainingSecs, "ttl_remaining_secs");
+  visitHistogram(stats.itemSizeBytes, "item_size_bytes");
+}
+} // namespace
+
+void CacheContentStats::visit(const util::CounterVisitor& visitor) const {
+  for (const auto& [pid, pool] : poolStats) {
+    const auto prefix = folly::sformat("pool.{}.content.", pool.poolName);
+    visitClassStats(visitor, pool.aggregate(), prefix,
+                    true /* withDistributions */);
+    // the per class distributions rarely have enough samples to be worth a
+    // counter each
+    for (const auto& [cid, stats] : pool.classStats) {
+      visitClassStats(visitor, stats,
+                      folly::sformat("{}class_{}.", prefix, stats.allocSize),
+                      false /* withDistributions */);
+    }
+  }
+}
+
+} // namespace facebook::cachelib
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "cachelib/allocator/memory/Slab.h"
+#include "cachelib/common/Throttler.h"
+#include "cachelib/common/Utils.h"
+
+namespace facebook::cachelib {
+
+// Config for sampling the content of the cache. See
+// CacheAllocatorConfig::enableContentSampling
+struct ContentSamplingConfig {
+  // number of random allocations looked at each time the sampler runs. The
+  // allocations are picked uniformly over the cache memory, so every class
+  // gets a share of the samples proportional to its memory.
+  uint32_t samplesPerRun{10000};
+
+  // an item is reported as near eviction once it has been idle for this
+  // fraction of the age of the tail of its eviction queue.
+  double nearEvictionFraction{0.9};
+
+  // throttles the sampling so that a run does not hog a cpu
+  util::Throttler::Config throttlerConfig{};
+
+  // @throw std::invalid_argument if the config is invalid
+  const ContentSamplingConfig& validate() const;
+
+  std::map<std::string, std::string> serialize() const;
+};
+
+// Power of two histogram of a sampled quantity. Bucket 0 counts the zeros
+// and bucket i > 0 counts the values in [2^(i-1), 2^i).
+struct ContentHistogram {
+  static constexpr size_t kNumBuckets = 40;
+
+  std::array<uint64_t, kNumBuckets> counts{};
+
+  static size_t getBucket(uint64_t value) noexcept;
+
+  void add(uint64_t value) noexcept { counts[getBucket(value)]++; }
+
+  void merge(const ContentHistogram& other) noexcept;
+
+  uint64_t total() const noexcept;
+
+  // @return the upper bound of the bucket holding the value at this
+  //         fraction of the samples, or 0 without samples.
+  uint64_t percentile(double fraction) const noexcept;
+};
+
+// Distributions of the sampled allocations of one allocation class. The
+// counts are the raw samples. The byte estimates extrapolate them to the
+// memory of the class.
+struct ClassContentStats {
+  // size of the allocations of the class
+  uint32_t allocSize{0};
+
+  // memory held by the class when it was sampled
+  uint64_t memorySize{0};
+
+  // number of sampled allocations and how many of them held an item. The
+  // others were free or held chained items.
+  uint64_t numSamples{0};
+  uint64_t numItems{0};
+
+  // items past their expiry time that have not been reclaimed yet
+  uint64_t numExpired{0};
+
+  // items that were not accessed since they were inserted. Accesses are
+  // tracked at the granularity of the lru refresh time of the eviction
+  // queue, so items that were only hit shortly after their insertion are
+  // counted too.
+  uint64_t numNeverAccessed{0};
+
+  // items idle for at least ContentSamplingConfig::nearEvictionFraction of
+  // the age of the tail of their eviction queue
+  uint64_t numNearEviction{0};
+
+  // seconds since creation and since last access
+  ContentHistogram ageSecs;
+  ContentHistogram idleSecs;
+
+  // seconds until expiry, for the items with a TTL that are not expired
+  ContentHistogram ttlRemainingSecs;
+
+  // key, value and header bytes of the items
+  ContentHistogram itemSizeBytes;
+
+  // @return the estimated bytes of the class taken by numAllocs of its
+  //         sampled allocations.
+  uint64_t estimateBytes(uint64_t numAllocs) const noexcept {
+    return numSamples == 0 ? 0 : memorySize * numAllocs / numSamples;
+  }
+
+  uint64_t expiredBytes() const noexcept { return estimateBytes(numExpired); }
+
+  // bytes of the items never hit since they were inserted
+  uint64_t deadBytes() const noexcept {
+    return estimateBytes(numNeverAccessed);
+  }
+
+  uint64_t nearEvictionBytes() const noexcept {
+    return estimateBytes(numNearEviction);
+  }
+
+  void merge(const ClassContentStats& other) noexcept;
+};
+
+// Content distributions of a pool, by allocation class
+struct PoolContentStats {
+  std::string poolName;
+
+  std::map<ClassId, ClassContentStats> classStats;
+
+  // @return the distributions of all the classes of the pool together
+  ClassContentStats aggregate() const noexcept;
+};
+
+// Report of a run of the content sampler
+struct CacheContentStats {
+  // unix timestamp in seconds of the run, 0 if there was no run yet
+  uint32_t sampleTime{0};
+
+  // number of allocations sampled over the whole cache, including the ones
+  // that landed in unallocated slabs or in compact cache pools
+  uint64_t numSamples{0};
+
+  std::map<PoolId, PoolContentStats> poolStats;
+
+  // Visits the per pool and per class stats. Names are prefixed by
+  // "pool.<pool name>.content."
+  void visit(const util::CounterVisitor& visitor) const;
+};
+
+} // namespace facebook::cachelib
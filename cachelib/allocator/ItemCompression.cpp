@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/allocator/ItemCompression.h"
+
+#include <folly/Format.h>
+#include <folly/compression/Compression.h>
+#include <folly/io/Cursor.h>
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+namespace facebook::cachelib {
+
+const ItemCompressionConfig& ItemCompressionConfig::validate() const {
+  if (codec != ItemCompressionCodec::LZ4 &&
+      codec != ItemCompressionCodec::ZSTD) {
+    throw std::invalid_argument(folly::sformat(
+        "Unknown item compression codec: {}", static_cast<int>(codec)));
+  }
+  if (batchSize == 0) {
+    throw std::invalid_argument("Item compression batch size must be > 0");
+  }
+  if (maxCompressionRatio <= 0 || maxCompressionRatio >= 1) {
+    throw std::invalid_argument(folly::sformat(
+        "Item compression ratio must be in (0, 1), got {}",
+        maxCompressionRatio));
+  }
+  return *this;
+}
+
+std::map<std::string, std::string> ItemCompressionConfig::serialize() const {
+  std::map<std::string, std::string> configMap;
+  configMap["codec"] = codec == ItemCompressionCodec::ZSTD ? "zstd" : "lz4";
+  configMap["batchSize"] = std::to_string(batchSize);
+  configMap["minValueSize"] = std::to_string(minValueSize);
+  configMap["maxCompressionRatio"] = std::to_string(maxCompressionRatio);
+  return configMap;
+}
+
+namespace detail {
+namespace {
+// folly codecs keep per-instance contexts and are not thread-safe. Creating
+// one per call is expensive for zstd, so every thread keeps its own.
+folly::io::Codec& getCodec(ItemCompressionCodec codec) {
+  thread_local std::array<std::unique_ptr<folly::io::Codec>, 2> codecs;
+  auto& c = codecs.at(static_cast<size_t>(codec));
+  if (!c) {
+    c = folly::io::getCodec(codec == ItemCompressionCodec::ZSTD
+                                ? folly::io::CodecType::ZSTD
+                                : folly::io::CodecType::LZ4);
+  }
+  return *c;
+}
+
+CompressedValueHeader readHeader(folly::ByteRange compressed) {
+  CompressedValueHeader header;
+  if (compressed.size() < sizeof(header)) {
+    throw std::invalid_argument(folly::sformat(
+        "Compressed value too small: {} bytes", compressed.size()));
+  }
+  std::memcpy(&header, compressed.data(), sizeof(header));
+  if (header.codec != static_cast<uint8_t>(ItemCompressionCodec::LZ4) &&
+      header.codec != static_cast<uint8_t>(ItemCompressionCodec::ZSTD)) {
+    throw std::invalid_argument(
+        folly::sformat("Invalid compression codec: {}", header.codec));
+  }
+  return header;
+}
+} // namespace
+
+std::unique_ptr<folly::IOBuf> compressItemValue(ItemCompressionCodec codec,
+                                                folly::ByteRange value,
+                                                size_t maxSize) {
+  if (maxSize <= sizeof(CompressedValueHeader)) {
+    return nullptr;
+  }
+
+  std::unique_ptr<folly::IOBuf> out;
+  try {
+    const auto in = folly::IOBuf::wrapBufferAsValue(value);
+    out = getCodec(codec).compress(&in);
+  } catch (const std::exception&) {
+    return nullptr;
+  }
+  out->coalesce();
+  const size_t totalSize = sizeof(CompressedValueHeader) + out->length();
+  if (totalSize > maxSize) {
+    return nullptr;
+  }
+
+  CompressedValueHeader header{static_cast<uint32_t>(value.size()),
+                               static_cast<uint8_t>(codec)};
+  auto buf = folly::IOBuf::create(totalSize);
+  std::memcpy(buf->writableData(), &header, sizeof(header));
+  std::memcpy(buf->writableData() + sizeof(header), out->data(),
+              out->length());
+  buf->append(totalSize);
+  return buf;
+}
+
+uint32_t getUncompressedSize(folly::ByteRange compressed) {
+  return readHeader(compressed).uncompressedSize;
+}
+
+void decompressItemValue(folly::ByteRange compressed,
+                         folly::MutableByteRange out) {
+  const auto header = readHeader(compressed);
+  if (out.size() != header.uncompressedSize) {
+    throw std::invalid_argument(
+        folly::sformat("Output size {} does not match uncompressed size {}",
+                       out.size(), header.uncompressedSize));
+  }
+
+  compressed.advance(sizeof(header));
+  const auto in = folly::IOBuf::wrapBufferAsValue(compressed);
+  auto buf = getCodec(static_cast<ItemCompressionCodec>(header.codec))
+                 .uncompress(&in, header.uncompressedSize);
+  if (buf->computeChainDataLength() != out.size()) {
+    throw std::runtime_error(folly::sformat(
+        "Decompressed {} bytes, expected {}", buf->computeChainDataLength(),
+        out.size()));
+  }
+  folly::io::Cursor cursor{buf.get()};
+  cursor.pull(out.data(), out.size());
+}
+} // namespace detail
+} // namespace facebook::cachelib
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Portability.h>
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace facebook::cachelib {
+
+enum class ItemCompressionCodec : uint8_t { LZ4 = 0, ZSTD = 1 };
+
+// Config for compressing cold items in DRAM. See
+// CacheAllocatorConfig::enableItemCompression
+struct ItemCompressionConfig {
+  // codec used to compress new items. Items that are already compressed
+  // remember the codec they were compressed with.
+  ItemCompressionCodec codec{ItemCompressionCodec::LZ4};
+
+  // number of items to look at from the tail of every allocation class each
+  // time the compressor runs.
+  uint32_t batchSize{100};
+
+  // items with a value smaller than this are not worth compressing.
+  uint32_t minValueSize{256};
+
+  // only keep the compressed copy if it is at most this fraction of the
+  // original value size. Otherwise the item would likely land in the same
+  // allocation class and we would only burn cpu.
+  double maxCompressionRatio{0.8};
+
+  // @throw std::invalid_argument if the config is invalid
+  const ItemCompressionConfig& validate() const;
+
+  std::map<std::string, std::string> serialize() const;
+};
+
+namespace detail {
+// Compressed item values are laid out as a small header followed by the
+// output of the codec. The header carries everything needed to inflate the
+// value back, so that a change of codec in the config does not break items
+// compressed before.
+struct FOLLY_PACK_ATTR CompressedValueHeader {
+  uint32_t uncompressedSize;
+  uint8_t codec;
+};
+
+// Compress the value. Returns nullptr if the codec fails or the result is
+// not smaller than maxSize bytes (header included).
+std::unique_ptr<folly::IOBuf> compressItemValue(ItemCompressionCodec codec,
+                                                folly::ByteRange value,
+                                                size_t maxSize);
+
+// @return the size of the value once decompressed
+// @throw std::invalid_argument if the buffer is not a compressed value
+uint32_t getUncompressedSize(folly::ByteRange compressed);
+
+// Inflate a compressed value into out, which must be exactly
+// getUncompressedSize() bytes.
+// @throw std::runtime_error on corrupted input
+void decompressItemValue(folly::ByteRange compressed,
+                         folly::MutableByteRange out);
+} // namespace detail
+} // namespace facebook::cachelib
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/logging/xlog.h>
+
+#include "cachelib/allocator/CacheStats.h"
+#include "cachelib/allocator/ItemCompression.h"
+#include "cachelib/common/AtomicCounter.h"
+#include "cachelib/common/PeriodicWorker.h"
+
+namespace facebook::cachelib {
+// wrapper that exposes the private APIs of CacheType that are specifically
+// needed for the ItemCompressor.
+template <typename C>
+struct ItemCompressorAPIWrapper {
+  static std::set<PoolId> getRegularPoolIds(C& cache) {
+    return cache.getRegularPoolIds();
+  }
+
+  static size_t compressColdItems(C& cache,
+                                  PoolId pid,
+                                  ClassId cid,
+                                  size_t batch) {
+    return cache.compressColdItems(pid, cid, batch);
+  }
+};
+
+// Periodically walks the tail of every allocation class in the regular pools
+// and replaces cold items with a compressed copy in a smaller allocation
+// class. The cache inflates compressed items back on lookup.
+template <typename CacheT>
+class ItemCompressor : public PeriodicWorker {
+ public:
+  using Cache = CacheT;
+  // @param cache   the cache interface
+  // @param config  how many and which items to compress
+  ItemCompressor(Cache& cache, const ItemCompressionConfig& config)
+      : cache_(cache), config_(config) {}
+
+  ~ItemCompressor() override { stop(std::chrono::seconds(0)); }
+
+  uint64_t getNumRuns() const noexcept { return numRuns_.get(); }
+
+ private:
+  // implements the actual logic of running the compressor
+  void work() override final {
+    try {
+      for (const auto pid :
+           ItemCompressorAPIWrapper<Cache>::getRegularPoolIds(cache_)) {
+        const auto numClasses = cache_.getPool(pid).getNumClassId();
+        for (ClassId cid = 0; cid < static_cast<ClassId>(numClasses); ++cid) {
+          if (shouldStopWork()) {
+            return;
+          }
+          ItemCompressorAPIWrapper<Cache>::compressColdItems(
+              cache_, pid, cid, config_.batchSize);
+        }
+      }
+      numRuns_.inc();
+    } catch (const std::exception& ex) {
+      XLOGF(ERR, "ItemCompressor interrupted due to exception: {}", ex.what());
+    }
+  }
+
+  Cache& cache_;
+  const ItemCompressionConfig config_;
+  AtomicCounter numRuns_{0};
+};
+} // namespace facebook::cachelib
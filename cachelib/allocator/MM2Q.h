@@ -17,6 +17,8 @@
 #pragma once
 
 #include <atomic>
+#include <string>
+#include <vector>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wconversion"
@@ -460,6 +462,16 @@ class MM2Q {
     //          is unchanged.
     bool add(T& node) noexcept;
 
+    // adds the given nodes into the container under a single lock
+    // acquisition. Nodes are added one after another as if by add(), so the
+    // last node of the range ends up closest to the head.
+    //
+    // @param begin, end  range of pointers to the nodes to be added.
+    // @return  number of nodes added. Nodes that were already in the
+    //          container are skipped and left unchanged.
+    template <typename It>
+    uint32_t addBatch(It begin, It end) noexcept;
+
     // removes the node from the lru and sets it previous and next to nullptr.
     //
     // @param node  The node to be removed from the container.
@@ -510,10 +522,20 @@ class MM2Q {
     // override the current config.
     void setConfig(const Config& newConfig);
 
+    // Records the acquisitions of the container lock in the stats. Must be
+    // set before the container is used.
+    void setLockStats(LockStats* stats) noexcept { lockStats_ = stats; }
+
     bool isEmpty() const noexcept { return size() == 0; }
 
     size_t size() const noexcept {
-      return lruMutex_->lock_combine([this]() { return lru_.size(); });
+      return lockCombine([this]() { return lru_.size(); });
+    }
+
+    // TTL bands are only supported by MMLru, see MMLru::Config::ttlBandSecs
+    std::vector<std::string> getExpiredTtlBandKeys(
+        size_t /* maxKeys */) const {
+      return {};
     }
 
     // Returns the eviction age stats. See CacheStats.h for details
@@ -554,6 +576,9 @@ class MM2Q {
       (node.*HookPtr).setUpdateTime(time);
     }
 
+    // adds the node to the container with the lock held. See add().
+    bool addLocked(T& node, Time currTime) noexcept;
+
     // remove node from lru and adjust insertion points
     //
     // @param node          node to remove
@@ -634,6 +659,20 @@ class MM2Q {
     // time.
     mutable folly::cacheline_aligned<Mutex> lruMutex_;
 
+    // stats of the acquisitions of lruMutex_, if profiled
+    LockStats* lockStats_{nullptr};
+
+    // Runs the function under lruMutex_ with lock_combine()
+    template <typename F>
+    auto lockCombine(F&& f) const -> decltype(f()) {
+      return util::lockCombineProfiled(*lruMutex_, lockStats_,
+                                       std::forward<F>(f));
+    }
+
+    LockHolder lockExclusive() const {
+      return util::lockProfiled<LockHolder>(*lruMutex_, lockStats_);
+    }
+
     // the lru
     LruList lru_{LruType::NumTypes, PtrCompressor{}};
 
@@ -766,7 +805,7 @@ bool MM2Q::Container<T, HookPtr>::recordAccess(T& node,
       return false;
     }
 
-    return lruMutex_->lock_combine(func);
+    return lockCombine(func);
   }
   return false;
 }
@@ -774,7 +813,7 @@ bool MM2Q::Container<T, HookPtr>::recordAccess(T& node,
 template <typename T, MM2Q::Hook<T> T::*HookPtr>
 cachelib::EvictionAgeStat MM2Q::Container<T, HookPtr>::getEvictionAgeStat(
     uint64_t projectedLength) const noexcept {
-  return lruMutex_->lock_combine([this, projectedLength]() {
+  return lockCombine([this, projectedLength]() {
     return getEvictionAgeStatLocked(projectedLength);
   });
 }
@@ -885,27 +924,47 @@ void MM2Q::Container<T, HookPtr>::rebalance() noexcept {
 template <typename T, MM2Q::Hook<T> T::*HookPtr>
 bool MM2Q::Container<T, HookPtr>::add(T& node) noexcept {
   const auto currTime = static_cast<Time>(util::getCurrentTimeSec());
-  return lruMutex_->lock_combine([this, &node, currTime]() {
-    if (node.isInMMContainer()) {
-      return false;
+  return lockCombine(
+      [this, &node, currTime]() { return addLocked(node, currTime); });
+}
+
+template <typename T, MM2Q::Hook<T> T::*HookPtr>
+template <typename It>
+uint32_t MM2Q::Container<T, HookPtr>::addBatch(It begin, It end) noexcept {
+  const auto currTime = static_cast<Time>(util::getCurrentTimeSec());
+  return lockCombine([this, begin, end, currTime]() {
+    uint32_t numAdded = 0;
+    for (auto it = begin; it != end; ++it) {
+      if (addLocked(**it, currTime)) {
+        numAdded++;
+      }
     }
+    return numAdded;
+  });
+}
 
-    markHot(node);
-    unmarkCold(node);
-    unmarkTail(node);
-    lru_.getList(LruType::Hot).linkAtHead(node);
-    rebalance();
+template <typename T, MM2Q::Hook<T> T::*HookPtr>
+bool MM2Q::Container<T, HookPtr>::addLocked(T& node,
+                                            Time currTime) noexcept {
+  if (node.isInMMContainer()) {
+    return false;
+  }
 
-    node.markInMMContainer();
-    setUpdateTime(node, currTime);
-    return true;
-  });
+  markHot(node);
+  unmarkCold(node);
+  unmarkTail(node);
+  lru_.getList(LruType::Hot).linkAtHead(node);
+  rebalance();
+
+  node.markInMMContainer();
+  setUpdateTime(node, currTime);
+  return true;
 }
 
 template <typename T, MM2Q::Hook<T> T::*HookPtr>
 typename MM2Q::Container<T, HookPtr>::LockedIterator
 MM2Q::Container<T, HookPtr>::getEvictionIterator() const noexcept {
-  LockHolder l(*lruMutex_);
+  auto l = lockExclusive();
   return LockedIterator{std::move(l), lru_.rbegin()};
 }
 
@@ -913,9 +972,9 @@ template <typename T, MM2Q::Hook<T> T::*HookPtr>
 template <typename F>
 void MM2Q::Container<T, HookPtr>::withEvictionIterator(F&& fun) {
   if (config_.useCombinedLockForIterators) {
-    lruMutex_->lock_combine([this, &fun]() { fun(Iterator{lru_.rbegin()}); });
+    lockCombine([this, &fun]() { fun(Iterator{lru_.rbegin()}); });
   } else {
-    LockHolder lck{*lruMutex_};
+    auto lck = lockExclusive();
     fun(Iterator{lru_.rbegin()});
   }
 }
@@ -923,7 +982,7 @@ void MM2Q::Container<T, HookPtr>::withEvictionIterator(F&& fun) {
 template <typename T, MM2Q::Hook<T> T::*HookPtr>
 template <typename F>
 void MM2Q::Container<T, HookPtr>::withContainerLock(F&& fun) {
-  lruMutex_->lock_combine([&fun]() { fun(); });
+  lockCombine([&fun]() { fun(); });
 }
 
 template <typename T, MM2Q::Hook<T> T::*HookPtr>
@@ -950,7 +1009,7 @@ void MM2Q::Container<T, HookPtr>::setConfig(const Config& newConfig) {
         "Cannot turn off tailHitsTracking (cache drop needed)");
   }
 
-  lruMutex_->lock_combine([this, &newConfig]() {
+  lockCombine([this, &newConfig]() {
     config_ = newConfig;
     lruRefreshTime_.store(config_.lruRefreshTime, std::memory_order_relaxed);
     nextReconfigureTime_ = config_.mmReconfigureIntervalSecs.count() == 0
@@ -962,12 +1021,12 @@ void MM2Q::Container<T, HookPtr>::setConfig(const Config& newConfig) {
 
 template <typename T, MM2Q::Hook<T> T::*HookPtr>
 typename MM2Q::Config MM2Q::Container<T, HookPtr>::getConfig() const {
-  return lruMutex_->lock_combine([this]() { return config_; });
+  return lockCombine([this]() { return config_; });
 }
 
 template <typename T, MM2Q::Hook<T> T::*HookPtr>
 bool MM2Q::Container<T, HookPtr>::remove(T& node) noexcept {
-  return lruMutex_->lock_combine([this, &node]() {
+  return lockCombine([this, &node]() {
     if (!node.isInMMContainer()) {
       return false;
     }
@@ -990,7 +1049,7 @@ void MM2Q::Container<T, HookPtr>::remove(Iterator& it) noexcept {
 
 template <typename T, MM2Q::Hook<T> T::*HookPtr>
 bool MM2Q::Container<T, HookPtr>::replace(T& oldNode, T& newNode) noexcept {
-  return lruMutex_->lock_combine([this, &oldNode, &newNode]() {
+  return lockCombine([this, &oldNode, &newNode]() {
     if (!oldNode.isInMMContainer() || newNode.isInMMContainer()) {
       return false;
     }
@@ -1070,7 +1129,7 @@ serialization::MM2QObject MM2Q::Container<T, HookPtr>::saveState()
 
 template <typename T, MM2Q::Hook<T> T::*HookPtr>
 MMContainerStat MM2Q::Container<T, HookPtr>::getStats() const noexcept {
-  return lruMutex_->lock_combine([this]() {
+  return lockCombine([this]() {
     auto* tail = lru_.size() == 0 ? nullptr : lru_.rbegin().get();
     auto computeWeightedAccesses = [&](size_t warm, size_t cold) {
       return (warm * config_.getWarmSizePercent() +
@@ -18,6 +18,8 @@
 
 #include <atomic>
 #include <cstring>
+#include <string>
+#include <vector>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wconversion"
@@ -70,7 +72,9 @@ class MMLru {
                  *configState.updateOnWrite(),
                  *configState.updateOnRead(),
                  *configState.tryLockUpdate(),
-                 static_cast<uint8_t>(*configState.lruInsertionPointSpec())) {}
+                 static_cast<uint8_t>(*configState.lruInsertionPointSpec())) {
+      ttlBandSecs = static_cast<uint32_t>(*configState.ttlBandSecs());
+    }
 
     // @param time        the LRU refresh time in seconds.
     //                    An item will be promoted only once in each lru refresh
@@ -234,6 +238,15 @@ class MMLru {
 
     // Whether to use combined locking for withEvictionIterator.
     bool useCombinedLockForIterators{false};
+
+    // Items added with a configured TTL of at most this many seconds are kept
+    // in a separate TTL band queue instead of the lru, so that they do not
+    // expire deep inside the lru and do not push out the items with longer
+    // TTLs. The eviction starts from the band once its tail is expired or
+    // expires sooner than the tail of the lru would age out. The band is
+    // picked when the item is added, so later TTL changes do not move it.
+    // 0 disables the band.
+    uint32_t ttlBandSecs{0};
   };
 
   // The container object which can be used to keep track of objects of type
@@ -257,6 +270,7 @@ class MMLru {
     Container(Config c, PtrCompressor compressor)
         : compressor_(std::move(compressor)),
           lru_(compressor_),
+          ttlBand_(compressor_),
           config_(std::move(c)) {
       lruRefreshTime_ = config_.lruRefreshTime;
       nextReconfigureTime_ =
@@ -270,7 +284,66 @@ class MMLru {
     Container(const Container&) = delete;
     Container& operator=(const Container&) = delete;
 
-    using Iterator = typename LruList::Iterator;
+    // Iterates the nodes from the tail of one queue, then from the tail of
+    // the other one. The queue visited first is picked when the iterator is
+    // created, see getEvictionIterator().
+    class Iterator {
+     public:
+      Iterator(const LruList& first, const LruList& second) noexcept
+          : curr_(first.rbegin()), first_(&first), second_(&second) {
+        skipToSecondIfDone();
+      }
+      virtual ~Iterator() = default;
+
+      // copyable and movable
+      Iterator(const Iterator&) = default;
+      Iterator& operator=(const Iterator&) = default;
+      Iterator(Iterator&&) noexcept = default;
+      Iterator& operator=(Iterator&&) noexcept = default;
+
+      // moves the iterator towards the head. Calling ++ once the iterator has
+      // reached the end is undefined.
+      Iterator& operator++() noexcept {
+        ++curr_;
+        skipToSecondIfDone();
+        return *this;
+      }
+
+      T* operator->() const noexcept { return curr_.operator->(); }
+      T& operator*() const noexcept { return *curr_; }
+
+      explicit operator bool() const noexcept {
+        return static_cast<bool>(curr_);
+      }
+
+      T* get() const noexcept { return curr_.get(); }
+
+      // Invalidates this iterator
+      void reset() noexcept {
+        curr_.reset();
+        inFirst_ = false;
+      }
+
+      // Reset the iterator back to the beginning
+      void resetToBegin() noexcept {
+        curr_ = first_->rbegin();
+        inFirst_ = true;
+        skipToSecondIfDone();
+      }
+
+     private:
+      void skipToSecondIfDone() noexcept {
+        if (inFirst_ && !curr_) {
+          inFirst_ = false;
+          curr_ = second_->rbegin();
+        }
+      }
+
+      typename LruList::Iterator curr_;
+      const LruList* first_{nullptr};
+      const LruList* second_{nullptr};
+      bool inFirst_{true};
+    };
 
     // context for iterating the MM container. At any given point of time,
     // there can be only one iterator active since we need to lock the LRU for
@@ -337,6 +410,16 @@ class MMLru {
     //          is unchanged.
     bool add(T& node) noexcept;
 
+    // adds the given nodes into the container under a single lock
+    // acquisition. Nodes are added one after another as if by add(), so the
+    // last node of the range ends up closest to the head.
+    //
+    // @param begin, end  range of pointers to the nodes to be added.
+    // @return  number of nodes added. Nodes that were already in the
+    //          container are skipped and left unchanged.
+    template <typename It>
+    uint32_t addBatch(It begin, It end) noexcept;
+
     // removes the node from the lru and sets it previous and next to nullptr.
     //
     // @param node  The node to be removed from the container.
@@ -384,6 +467,10 @@ class MMLru {
     // override the existing config with the new one.
     void setConfig(const Config& newConfig);
 
+    // Records the acquisitions of the container lock in the stats. Must be
+    // set before the container is used.
+    void setLockStats(LockStats* stats) noexcept { lockStats_ = stats; }
+
     bool isEmpty() const noexcept { return size() == 0; }
 
     // reconfigure the MMContainer: update refresh time according to current
@@ -392,9 +479,22 @@ class MMLru {
 
     // returns the number of elements in the container
     size_t size() const noexcept {
-      return lruMutex_->lock_combine([this]() { return lru_.size(); });
+      return lockCombine([this]() { return lru_.size() + ttlBand_.size(); });
     }
 
+    // returns the number of elements in the TTL band queue
+    size_t getTtlBandSize() const noexcept {
+      return lockCombine([this]() { return ttlBand_.size(); });
+    }
+
+    // Collects the keys of the expired nodes at the tail of the TTL band
+    // queue, stopping at the first node that is not expired. The nodes are
+    // not removed, the caller is expected to remove the items from the cache
+    // without holding the container lock.
+    //
+    // @param maxKeys   maximum number of keys to return
+    std::vector<std::string> getExpiredTtlBandKeys(size_t maxKeys) const;
+
     // Returns the eviction age stats. See CacheStats.h for details
     EvictionAgeStat getEvictionAgeStat(uint64_t projectedLength) const noexcept;
 
@@ -436,6 +536,28 @@ class MMLru {
     // to maintain the tailSize_, for the next insertion.
     void updateLruInsertionPoint() noexcept;
 
+    // adds the node to the container with the lock held. See add().
+    bool addLocked(T& node, Time currTime) noexcept;
+
+    // @return true if the node belongs to the TTL band when added
+    bool isTtlBandCandidate(const T& node) const noexcept {
+      if (config_.ttlBandSecs == 0) {
+        return false;
+      }
+      const auto ttl = node.getConfiguredTTL().count();
+      return ttl > 0 && static_cast<uint64_t>(ttl) <= config_.ttlBandSecs;
+    }
+
+    // @return true if the eviction should start from the tail of the TTL
+    //         band instead of the tail of the lru.
+    bool evictTtlBandFirst() const noexcept;
+
+    // creates the eviction iterator with the lock held
+    Iterator makeEvictionIterator() const noexcept {
+      return evictTtlBandFirst() ? Iterator{ttlBand_, lru_}
+                                 : Iterator{lru_, ttlBand_};
+    }
+
     // remove node from lru and adjust insertion points
     // @param node          node to remove
     void removeLocked(T& node);
@@ -469,16 +591,47 @@ class MMLru {
       return node.template isFlagSet<RefFlags::kMMFlag1>();
     }
 
+    // Bit MM_BIT_2 is used to record if the item is in the TTL band queue
+    // instead of the lru.
+    void markInTtlBand(T& node) noexcept {
+      node.template setFlag<RefFlags::kMMFlag2>();
+    }
+
+    void unmarkInTtlBand(T& node) noexcept {
+      node.template unSetFlag<RefFlags::kMMFlag2>();
+    }
+
+    bool isInTtlBand(const T& node) const noexcept {
+      return node.template isFlagSet<RefFlags::kMMFlag2>();
+    }
+
     // protects all operations on the lru. We never really just read the state
     // of the LRU. Hence we dont really require a RW mutex at this point of
     // time.
     mutable folly::cacheline_aligned<Mutex> lruMutex_;
 
+    // stats of the acquisitions of lruMutex_, if profiled
+    LockStats* lockStats_{nullptr};
+
+    // Runs the function under lruMutex_ with lock_combine()
+    template <typename F>
+    auto lockCombine(F&& f) const -> decltype(f()) {
+      return util::lockCombineProfiled(*lruMutex_, lockStats_,
+                                       std::forward<F>(f));
+    }
+
+    LockHolder lockExclusive() const {
+      return util::lockProfiled<LockHolder>(*lruMutex_, lockStats_);
+    }
+
     const PtrCompressor compressor_{};
 
     // the lru
     LruList lru_{};
 
+    // the items with a short TTL, see Config::ttlBandSecs
+    LruList ttlBand_{};
+
     // insertion point
     T* insertionPoint_{nullptr};
 
@@ -516,6 +669,9 @@ MMLru::Container<T, HookPtr>::Container(serialization::MMLruObject object,
                                         PtrCompressor compressor)
     : compressor_(std::move(compressor)),
       lru_(*object.lru(), compressor_),
+      ttlBand_(object.ttlBand().has_value()
+                   ? LruList(*object.ttlBand(), compressor_)
+                   : LruList(compressor_)),
       insertionPoint_(compressor_.unCompress(
           CompressedPtrType{*object.compressedInsertionPoint()})),
       tailSize_(*object.tailSize()),
@@ -549,7 +705,11 @@ bool MMLru::Container<T, HookPtr>::recordAccess(T& node,
       reconfigureLocked(curr);
       ensureNotInsertionPoint(node);
       if (node.isInMMContainer()) {
-        lru_.moveToHead(node);
+        if (isInTtlBand(node)) {
+          ttlBand_.moveToHead(node);
+        } else {
+          lru_.moveToHead(node);
+        }
         setUpdateTime(node, curr);
       }
       if (isTail(node)) {
@@ -574,7 +734,7 @@ bool MMLru::Container<T, HookPtr>::recordAccess(T& node,
       return false;
     }
 
-    lruMutex_->lock_combine(func);
+    lockCombine(func);
     return true;
   }
   return false;
@@ -583,7 +743,7 @@ bool MMLru::Container<T, HookPtr>::recordAccess(T& node,
 template <typename T, MMLru::Hook<T> T::*HookPtr>
 cachelib::EvictionAgeStat MMLru::Container<T, HookPtr>::getEvictionAgeStat(
     uint64_t projectedLength) const noexcept {
-  return lruMutex_->lock_combine([this, projectedLength]() {
+  return lockCombine([this, projectedLength]() {
     return getEvictionAgeStatLocked(projectedLength);
   });
 }
@@ -610,7 +770,7 @@ MMLru::Container<T, HookPtr>::getEvictionAgeStatLocked(
 
 template <typename T, MMLru::Hook<T> T::*HookPtr>
 void MMLru::Container<T, HookPtr>::setConfig(const Config& newConfig) {
-  lruMutex_->lock_combine([this, newConfig]() {
+  lockCombine([this, newConfig]() {
     config_ = newConfig;
     if (config_.lruInsertionPointSpec == 0 && insertionPoint_ != nullptr) {
       auto curr = insertionPoint_;
@@ -632,7 +792,7 @@ void MMLru::Container<T, HookPtr>::setConfig(const Config& newConfig) {
 
 template <typename T, MMLru::Hook<T> T::*HookPtr>
 typename MMLru::Config MMLru::Container<T, HookPtr>::getConfig() const {
-  return lruMutex_->lock_combine([this]() { return config_; });
+  return lockCombine([this]() { return config_; });
 }
 
 template <typename T, MMLru::Hook<T> T::*HookPtr>
@@ -680,46 +840,113 @@ void MMLru::Container<T, HookPtr>::updateLruInsertionPoint() noexcept {
 template <typename T, MMLru::Hook<T> T::*HookPtr>
 bool MMLru::Container<T, HookPtr>::add(T& node) noexcept {
   const auto currTime = static_cast<Time>(util::getCurrentTimeSec());
+  return lockCombine(
+      [this, &node, currTime]() { return addLocked(node, currTime); });
+}
 
-  return lruMutex_->lock_combine([this, &node, currTime]() {
-    if (node.isInMMContainer()) {
-      return false;
-    }
-    if (config_.lruInsertionPointSpec == 0 || insertionPoint_ == nullptr) {
-      lru_.linkAtHead(node);
-    } else {
-      lru_.insertBefore(*insertionPoint_, node);
+template <typename T, MMLru::Hook<T> T::*HookPtr>
+template <typename It>
+uint32_t MMLru::Container<T, HookPtr>::addBatch(It begin, It end) noexcept {
+  const auto currTime = static_cast<Time>(util::getCurrentTimeSec());
+  return lockCombine([this, begin, end, currTime]() {
+    uint32_t numAdded = 0;
+    for (auto it = begin; it != end; ++it) {
+      if (addLocked(**it, currTime)) {
+        numAdded++;
+      }
     }
+    return numAdded;
+  });
+}
+
+template <typename T, MMLru::Hook<T> T::*HookPtr>
+bool MMLru::Container<T, HookPtr>::addLocked(T& node,
+                                             Time currTime) noexcept {
+  if (node.isInMMContainer()) {
+    return false;
+  }
+  if (isTtlBandCandidate(node)) {
+    ttlBand_.linkAtHead(node);
+    markInTtlBand(node);
     node.markInMMContainer();
     setUpdateTime(node, currTime);
     unmarkAccessed(node);
-    updateLruInsertionPoint();
     return true;
-  });
+  }
+  if (config_.lruInsertionPointSpec == 0 || insertionPoint_ == nullptr) {
+    lru_.linkAtHead(node);
+  } else {
+    lru_.insertBefore(*insertionPoint_, node);
+  }
+  node.markInMMContainer();
+  setUpdateTime(node, currTime);
+  unmarkAccessed(node);
+  updateLruInsertionPoint();
+  return true;
 }
 
 template <typename T, MMLru::Hook<T> T::*HookPtr>
 typename MMLru::Container<T, HookPtr>::LockedIterator
 MMLru::Container<T, HookPtr>::getEvictionIterator() const noexcept {
-  LockHolder l(*lruMutex_);
-  return LockedIterator{std::move(l), lru_.rbegin()};
+  auto l = lockExclusive();
+  return LockedIterator{std::move(l), makeEvictionIterator()};
+}
+
+template <typename T, MMLru::Hook<T> T::*HookPtr>
+bool MMLru::Container<T, HookPtr>::evictTtlBandFirst() const noexcept {
+  const T* bandTail = ttlBand_.getTail();
+  if (bandTail == nullptr) {
+    return false;
+  }
+  const T* lruTail = lru_.getTail();
+  if (lruTail == nullptr) {
+    return true;
+  }
+
+  // the tail of the band is worth less than the tail of the lru if it
+  // expires before the tail of the lru would age out, assuming the lru tail
+  // stays idle for as long as it already has.
+  const auto currTime = static_cast<Time>(util::getCurrentTimeSec());
+  const auto lruTailTime = std::min(currTime, getUpdateTime(*lruTail));
+  const auto expiryTime = bandTail->getExpiryTime();
+  if (expiryTime != 0 && expiryTime <= currTime + (currTime - lruTailTime)) {
+    return true;
+  }
+  // otherwise keep the lru order across both queues
+  return getUpdateTime(*bandTail) <= lruTailTime;
+}
+
+template <typename T, MMLru::Hook<T> T::*HookPtr>
+std::vector<std::string> MMLru::Container<T, HookPtr>::getExpiredTtlBandKeys(
+    size_t maxKeys) const {
+  const auto currTime = static_cast<uint32_t>(util::getCurrentTimeSec());
+  return lockCombine([this, maxKeys, currTime]() {
+    std::vector<std::string> keys;
+    for (auto it = ttlBand_.rbegin(); it && keys.size() < maxKeys; ++it) {
+      if (!it->isExpired(currTime)) {
+        break;
+      }
+      keys.push_back(it->getKey().str());
+    }
+    return keys;
+  });
 }
 
 template <typename T, MMLru::Hook<T> T::*HookPtr>
 template <typename F>
 void MMLru::Container<T, HookPtr>::withEvictionIterator(F&& fun) {
   if (config_.useCombinedLockForIterators) {
-    lruMutex_->lock_combine([this, &fun]() { fun(Iterator{lru_.rbegin()}); });
+    lockCombine([this, &fun]() { fun(makeEvictionIterator()); });
   } else {
-    LockHolder lck{*lruMutex_};
-    fun(Iterator{lru_.rbegin()});
+    auto lck = lockExclusive();
+    fun(makeEvictionIterator());
   }
 }
 
 template <typename T, MMLru::Hook<T> T::*HookPtr>
 template <typename F>
 void MMLru::Container<T, HookPtr>::withContainerLock(F&& fun) {
-  lruMutex_->lock_combine([&fun]() { fun(); });
+  lockCombine([&fun]() { fun(); });
 }
 
 template <typename T, MMLru::Hook<T> T::*HookPtr>
@@ -739,6 +966,13 @@ void MMLru::Container<T, HookPtr>::ensureNotInsertionPoint(T& node) noexcept {
 
 template <typename T, MMLru::Hook<T> T::*HookPtr>
 void MMLru::Container<T, HookPtr>::removeLocked(T& node) {
+  if (isInTtlBand(node)) {
+    ttlBand_.remove(node);
+    unmarkInTtlBand(node);
+    unmarkAccessed(node);
+    node.unmarkInMMContainer();
+    return;
+  }
   ensureNotInsertionPoint(node);
   lru_.remove(node);
   unmarkAccessed(node);
@@ -753,7 +987,7 @@ void MMLru::Container<T, HookPtr>::removeLocked(T& node) {
 
 template <typename T, MMLru::Hook<T> T::*HookPtr>
 bool MMLru::Container<T, HookPtr>::remove(T& node) noexcept {
-  return lruMutex_->lock_combine([this, &node]() {
+  return lockCombine([this, &node]() {
     if (!node.isInMMContainer()) {
       return false;
     }
@@ -772,12 +1006,19 @@ void MMLru::Container<T, HookPtr>::remove(Iterator& it) noexcept {
 
 template <typename T, MMLru::Hook<T> T::*HookPtr>
 bool MMLru::Container<T, HookPtr>::replace(T& oldNode, T& newNode) noexcept {
-  return lruMutex_->lock_combine([this, &oldNode, &newNode]() {
+  return lockCombine([this, &oldNode, &newNode]() {
     if (!oldNode.isInMMContainer() || newNode.isInMMContainer()) {
       return false;
     }
     const auto updateTime = getUpdateTime(oldNode);
-    lru_.replace(oldNode, newNode);
+    if (isInTtlBand(oldNode)) {
+      ttlBand_.replace(oldNode, newNode);
+      unmarkInTtlBand(oldNode);
+      markInTtlBand(newNode);
+    } else {
+      lru_.replace(oldNode, newNode);
+      unmarkInTtlBand(newNode);
+    }
     oldNode.unmarkInMMContainer();
     newNode.markInMMContainer();
     setUpdateTime(newNode, updateTime);
@@ -811,6 +1052,7 @@ serialization::MMLruObject MMLru::Container<T, HookPtr>::saveState()
   *configObject.updateOnRead() = config_.updateOnRead;
   *configObject.tryLockUpdate() = config_.tryLockUpdate;
   *configObject.lruInsertionPointSpec() = config_.lruInsertionPointSpec;
+  *configObject.ttlBandSecs() = config_.ttlBandSecs;
 
   serialization::MMLruObject object;
   *object.config() = configObject;
@@ -818,13 +1060,21 @@ serialization::MMLruObject MMLru::Container<T, HookPtr>::saveState()
       compressor_.compress(insertionPoint_).saveState();
   *object.tailSize() = tailSize_;
   *object.lru() = lru_.saveState();
+  object.ttlBand() = ttlBand_.saveState();
   return object;
 }
 
 template <typename T, MMLru::Hook<T> T::*HookPtr>
 MMContainerStat MMLru::Container<T, HookPtr>::getStats() const noexcept {
-  auto stat = lruMutex_->lock_combine([this]() {
+  auto stat = lockCombine([this]() {
+    // the oldest of the tails of the lru and of the TTL band
     auto* tail = lru_.getTail();
+    auto* bandTail = ttlBand_.getTail();
+    if (tail == nullptr ||
+        (bandTail != nullptr &&
+         getUpdateTime(*bandTail) < getUpdateTime(*tail))) {
+      tail = bandTail;
+    }
 
     // we return by array here because DistributedMutex is fastest when the
     // output data fits within 48 bytes.  And the array is exactly 48 bytes, so
@@ -832,7 +1082,7 @@ MMContainerStat MMLru::Container<T, HookPtr>::getStats() const noexcept {
     //
     // the rest of the parameters are 0, so we don't need the critical section
     // to return them
-    return folly::make_array(lru_.size(),
+    return folly::make_array(lru_.size() + ttlBand_.size(),
                              tail == nullptr ? 0 : getUpdateTime(*tail),
                              lruRefreshTime_.load(std::memory_order_relaxed));
   });
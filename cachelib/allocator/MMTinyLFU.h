@@ -17,6 +17,8 @@
 #pragma once
 
 #include <atomic>
+#include <string>
+#include <vector>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wconversion"
@@ -377,6 +379,16 @@ class MMTinyLFU {
     //          is unchanged.
     bool add(T& node) noexcept;
 
+    // adds the given nodes into the container under a single lock
+    // acquisition. Nodes are added one after another as if by add(), so the
+    // last node of the range ends up closest to the head.
+    //
+    // @param begin, end  range of pointers to the nodes to be added.
+    // @return  number of nodes added. Nodes that were already in the
+    //          container are skipped and left unchanged.
+    template <typename It>
+    uint32_t addBatch(It begin, It end) noexcept;
+
     // removes the node from the lru and sets it previous and next to nullptr.
     //
     // @param node  The node to be removed from the container.
@@ -514,22 +526,32 @@ class MMTinyLFU {
 
     void setConfig(const Config& newConfig);
 
+    // Records the acquisitions of the container lock in the stats. Must be
+    // set before the container is used.
+    void setLockStats(LockStats* stats) noexcept { lockStats_ = stats; }
+
     bool isEmpty() const noexcept {
-      LockHolder l(lruMutex_);
+      auto l = lockExclusive();
       return lru_.size() == 0;
     }
 
     size_t size() const noexcept {
-      LockHolder l(lruMutex_);
+      auto l = lockExclusive();
       return lru_.size();
     }
 
+    // TTL bands are only supported by MMLru, see MMLru::Config::ttlBandSecs
+    std::vector<std::string> getExpiredTtlBandKeys(
+        size_t /* maxKeys */) const {
+      return {};
+    }
+
     // reconfigure the MMContainer: update refresh time according to current
     // tail age
     void reconfigureLocked(const Time& currTime);
 
     size_t counterSize() const noexcept {
-      LockHolder l(lruMutex_);
+      auto l = lockExclusive();
       return accessFreq_.getByteSize();
     }
 
@@ -607,6 +629,9 @@ class MMTinyLFU {
       }
     }
 
+    // adds the node to the container with the lock held. See add().
+    bool addLocked(T& node, Time currTime) noexcept;
+
     // remove node from lru and adjust insertion points
     //
     // @param node          node to remove
@@ -655,6 +680,13 @@ class MMTinyLFU {
     // time.
     mutable Mutex lruMutex_;
 
+    // stats of the acquisitions of lruMutex_, if profiled
+    LockStats* lockStats_{nullptr};
+
+    LockHolder lockExclusive() const {
+      return util::lockProfiled<LockHolder>(lruMutex_, lockStats_);
+    }
+
     // the lru
     LruList lru_;
 
@@ -752,12 +784,8 @@ bool MMTinyLFU::Container<T, HookPtr>::recordAccess(T& node,
     if (!isAccessed(node)) {
       markAccessed(node);
     }
-    LockHolder l(lruMutex_, std::defer_lock);
-    if (config_.tryLockUpdate) {
-      l.try_lock();
-    } else {
-      l.lock();
-    }
+    auto l = config_.tryLockUpdate ? LockHolder{lruMutex_, std::try_to_lock}
+                                   : lockExclusive();
     if (!l.owns_lock()) {
       return false;
     }
@@ -777,7 +805,7 @@ bool MMTinyLFU::Container<T, HookPtr>::recordAccess(T& node,
 template <typename T, MMTinyLFU::Hook<T> T::*HookPtr>
 cachelib::EvictionAgeStat MMTinyLFU::Container<T, HookPtr>::getEvictionAgeStat(
     uint64_t projectedLength) const noexcept {
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
   return getEvictionAgeStatLocked(projectedLength);
 }
 
@@ -852,7 +880,27 @@ void MMTinyLFU::Container<T, HookPtr>::maybePromoteTailLocked() noexcept {
 template <typename T, MMTinyLFU::Hook<T> T::*HookPtr>
 bool MMTinyLFU::Container<T, HookPtr>::add(T& node) noexcept {
   const auto currTime = static_cast<Time>(util::getCurrentTimeSec());
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
+  return addLocked(node, currTime);
+}
+
+template <typename T, MMTinyLFU::Hook<T> T::*HookPtr>
+template <typename It>
+uint32_t MMTinyLFU::Container<T, HookPtr>::addBatch(It begin, It end) noexcept {
+  const auto currTime = static_cast<Time>(util::getCurrentTimeSec());
+  auto l = lockExclusive();
+  uint32_t numAdded = 0;
+  for (auto it = begin; it != end; ++it) {
+    if (addLocked(**it, currTime)) {
+      numAdded++;
+    }
+  }
+  return numAdded;
+}
+
+template <typename T, MMTinyLFU::Hook<T> T::*HookPtr>
+bool MMTinyLFU::Container<T, HookPtr>::addLocked(T& node,
+                                                 Time currTime) noexcept {
   if (node.isInMMContainer()) {
     return false;
   }
@@ -890,7 +938,7 @@ bool MMTinyLFU::Container<T, HookPtr>::add(T& node) noexcept {
 template <typename T, MMTinyLFU::Hook<T> T::*HookPtr>
 typename MMTinyLFU::Container<T, HookPtr>::LockedIterator
 MMTinyLFU::Container<T, HookPtr>::getEvictionIterator() const noexcept {
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
   return LockedIterator{std::move(l), *this};
 }
 
@@ -904,7 +952,7 @@ void MMTinyLFU::Container<T, HookPtr>::withEvictionIterator(F&& fun) {
 template <typename T, MMTinyLFU::Hook<T> T::*HookPtr>
 template <typename F>
 void MMTinyLFU::Container<T, HookPtr>::withContainerLock(F&& fun) {
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
   fun();
 }
 
@@ -924,7 +972,7 @@ void MMTinyLFU::Container<T, HookPtr>::removeLocked(T& node) noexcept {
 
 template <typename T, MMTinyLFU::Hook<T> T::*HookPtr>
 bool MMTinyLFU::Container<T, HookPtr>::remove(T& node) noexcept {
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
   if (!node.isInMMContainer()) {
     return false;
   }
@@ -943,7 +991,7 @@ void MMTinyLFU::Container<T, HookPtr>::remove(LockedIterator& it) noexcept {
 template <typename T, MMTinyLFU::Hook<T> T::*HookPtr>
 bool MMTinyLFU::Container<T, HookPtr>::replace(T& oldNode,
                                                T& newNode) noexcept {
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
   if (!oldNode.isInMMContainer() || newNode.isInMMContainer()) {
     return false;
   }
@@ -970,13 +1018,13 @@ bool MMTinyLFU::Container<T, HookPtr>::replace(T& oldNode,
 
 template <typename T, MMTinyLFU::Hook<T> T::*HookPtr>
 typename MMTinyLFU::Config MMTinyLFU::Container<T, HookPtr>::getConfig() const {
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
   return config_;
 }
 
 template <typename T, MMTinyLFU::Hook<T> T::*HookPtr>
 void MMTinyLFU::Container<T, HookPtr>::setConfig(const Config& c) {
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
   config_ = c;
   lruRefreshTime_.store(config_.lruRefreshTime, std::memory_order_relaxed);
   nextReconfigureTime_ = config_.mmReconfigureIntervalSecs.count() == 0
@@ -1009,7 +1057,7 @@ serialization::MMTinyLFUObject MMTinyLFU::Container<T, HookPtr>::saveState()
 
 template <typename T, MMTinyLFU::Hook<T> T::*HookPtr>
 MMContainerStat MMTinyLFU::Container<T, HookPtr>::getStats() const noexcept {
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
   auto* tail = lru_.size() == 0 ? nullptr : lru_.rbegin().get();
   return {lru_.size(),
           tail == nullptr ? 0 : getUpdateTime(*tail),
@@ -17,6 +17,8 @@
 #pragma once
 
 #include <atomic>
+#include <string>
+#include <vector>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wconversion"
@@ -451,6 +453,16 @@ class MMWTinyLFU {
     //          is unchanged.
     bool add(T& node) noexcept;
 
+    // adds the given nodes into the container under a single lock
+    // acquisition. Nodes are added one after another as if by add(), so the
+    // last node of the range ends up closest to the head.
+    //
+    // @param begin, end  range of pointers to the nodes to be added.
+    // @return  number of nodes added. Nodes that were already in the
+    //          container are skipped and left unchanged.
+    template <typename It>
+    uint32_t addBatch(It begin, It end) noexcept;
+
     // removes the node from the lru and sets it previous and next to nullptr.
     //
     // @param node  The node to be removed from the container.
@@ -598,22 +610,32 @@ class MMWTinyLFU {
 
     void setConfig(const Config& newConfig);
 
+    // Records the acquisitions of the container lock in the stats. Must be
+    // set before the container is used.
+    void setLockStats(LockStats* stats) noexcept { lockStats_ = stats; }
+
     bool isEmpty() const noexcept {
-      LockHolder l(lruMutex_);
+      auto l = lockExclusive();
       return lru_.size() == 0;
     }
 
     size_t size() const noexcept {
-      LockHolder l(lruMutex_);
+      auto l = lockExclusive();
       return lru_.size();
     }
 
+    // TTL bands are only supported by MMLru, see MMLru::Config::ttlBandSecs
+    std::vector<std::string> getExpiredTtlBandKeys(
+        size_t /* maxKeys */) const {
+      return {};
+    }
+
     // reconfigure the MMContainer: update refresh time according to current
     // tail age
     void reconfigureLocked(const Time& currTime);
 
     size_t counterSize() const noexcept {
-      LockHolder l(lruMutex_);
+      auto l = lockExclusive();
       return accessFreq_.getByteSize();
     }
 
@@ -692,6 +714,9 @@ class MMWTinyLFU {
       }
     }
 
+    // adds the node to the container with the lock held. See add().
+    bool addLocked(T& node, Time currTime) noexcept;
+
     // remove node from lru and adjust insertion points
     //
     // @param node          node to remove
@@ -751,6 +776,13 @@ class MMWTinyLFU {
     // time.
     mutable Mutex lruMutex_;
 
+    // stats of the acquisitions of lruMutex_, if profiled
+    LockStats* lockStats_{nullptr};
+
+    LockHolder lockExclusive() const {
+      return util::lockProfiled<LockHolder>(lruMutex_, lockStats_);
+    }
+
     // the lru
     LruList lru_;
 
@@ -848,12 +880,8 @@ bool MMWTinyLFU::Container<T, HookPtr>::recordAccess(T& node,
     if (!isAccessed(node)) {
       markAccessed(node);
     }
-    LockHolder l(lruMutex_, std::defer_lock);
-    if (config_.tryLockUpdate) {
-      l.try_lock();
-    } else {
-      l.lock();
-    }
+    auto l = config_.tryLockUpdate ? LockHolder{lruMutex_, std::try_to_lock}
+                                   : lockExclusive();
     if (!l.owns_lock()) {
       return false;
     }
@@ -902,7 +930,7 @@ bool MMWTinyLFU::Container<T, HookPtr>::recordAccess(T& node,
 template <typename T, MMWTinyLFU::Hook<T> T::*HookPtr>
 cachelib::EvictionAgeStat MMWTinyLFU::Container<T, HookPtr>::getEvictionAgeStat(
     uint64_t projectedLength) const noexcept {
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
   return getEvictionAgeStatLocked(projectedLength);
 }
 
@@ -976,7 +1004,27 @@ void MMWTinyLFU::Container<T, HookPtr>::maybePromoteTailLocked() noexcept {
 template <typename T, MMWTinyLFU::Hook<T> T::*HookPtr>
 bool MMWTinyLFU::Container<T, HookPtr>::add(T& node) noexcept {
   const auto currTime = static_cast<Time>(util::getCurrentTimeSec());
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
+  return addLocked(node, currTime);
+}
+
+template <typename T, MMWTinyLFU::Hook<T> T::*HookPtr>
+template <typename It>
+uint32_t MMWTinyLFU::Container<T, HookPtr>::addBatch(It begin, It end) noexcept {
+  const auto currTime = static_cast<Time>(util::getCurrentTimeSec());
+  auto l = lockExclusive();
+  uint32_t numAdded = 0;
+  for (auto it = begin; it != end; ++it) {
+    if (addLocked(**it, currTime)) {
+      numAdded++;
+    }
+  }
+  return numAdded;
+}
+
+template <typename T, MMWTinyLFU::Hook<T> T::*HookPtr>
+bool MMWTinyLFU::Container<T, HookPtr>::addLocked(T& node,
+                                                  Time currTime) noexcept {
   if (node.isInMMContainer()) {
     return false;
   }
@@ -1014,7 +1062,7 @@ bool MMWTinyLFU::Container<T, HookPtr>::add(T& node) noexcept {
 template <typename T, MMWTinyLFU::Hook<T> T::*HookPtr>
 typename MMWTinyLFU::Container<T, HookPtr>::LockedIterator
 MMWTinyLFU::Container<T, HookPtr>::getEvictionIterator() const noexcept {
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
   return LockedIterator{std::move(l), *this};
 }
 
@@ -1028,7 +1076,7 @@ void MMWTinyLFU::Container<T, HookPtr>::withEvictionIterator(F&& fun) {
 template <typename T, MMWTinyLFU::Hook<T> T::*HookPtr>
 template <typename F>
 void MMWTinyLFU::Container<T, HookPtr>::withContainerLock(F&& fun) {
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
   fun();
 }
 
@@ -1051,7 +1099,7 @@ void MMWTinyLFU::Container<T, HookPtr>::removeLocked(T& node) noexcept {
 
 template <typename T, MMWTinyLFU::Hook<T> T::*HookPtr>
 bool MMWTinyLFU::Container<T, HookPtr>::remove(T& node) noexcept {
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
   if (!node.isInMMContainer()) {
     return false;
   }
@@ -1070,7 +1118,7 @@ void MMWTinyLFU::Container<T, HookPtr>::remove(LockedIterator& it) noexcept {
 template <typename T, MMWTinyLFU::Hook<T> T::*HookPtr>
 bool MMWTinyLFU::Container<T, HookPtr>::replace(T& oldNode,
                                                 T& newNode) noexcept {
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
   if (isTiny(newNode) || isProbation(newNode)) {
     return false;
   }
@@ -1106,13 +1154,13 @@ bool MMWTinyLFU::Container<T, HookPtr>::replace(T& oldNode,
 template <typename T, MMWTinyLFU::Hook<T> T::*HookPtr>
 typename MMWTinyLFU::Config MMWTinyLFU::Container<T, HookPtr>::getConfig()
     const {
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
   return config_;
 }
 
 template <typename T, MMWTinyLFU::Hook<T> T::*HookPtr>
 void MMWTinyLFU::Container<T, HookPtr>::setConfig(const Config& c) {
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
   config_ = c;
   lruRefreshTime_.store(config_.lruRefreshTime, std::memory_order_relaxed);
   nextReconfigureTime_ = config_.mmReconfigureIntervalSecs.count() == 0
@@ -1148,7 +1196,7 @@ serialization::MMTinyLFUObject MMWTinyLFU::Container<T, HookPtr>::saveState()
 
 template <typename T, MMWTinyLFU::Hook<T> T::*HookPtr>
 MMContainerStat MMWTinyLFU::Container<T, HookPtr>::getStats() const noexcept {
-  LockHolder l(lruMutex_);
+  auto l = lockExclusive();
   auto* tail = lru_.size() == 0 ? nullptr : lru_.rbegin().get();
   return {lru_.size(),
           tail == nullptr ? 0 : getUpdateTime(*tail),
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <string>
+
 #include "cachelib/shm/ShmCommon.h"
 
 namespace facebook {
@@ -25,6 +27,29 @@ class MemoryTierCacheConfig {
   // Creates instance of MemoryTierCacheConfig for Posix/SysV Shared memory.
   static MemoryTierCacheConfig fromShm() { return MemoryTierCacheConfig(); }
 
+  // Creates instance of MemoryTierCacheConfig for memory backed by the file at
+  // the given path. The path can be on tmpfs, on a DAX mounted file system
+  // for persistent or CXL memory, or on a regular file system in which case
+  // the memory is paged through the page cache. It can also be a devdax
+  // device, which must be at least as large as the tier and is used whole.
+  // The file is created when the cache is created and re-attached to when the
+  // cache is restored, so the cache must be shm backed (see
+  // CacheAllocatorConfig::enableCachePersistence)
+  static MemoryTierCacheConfig fromFile(const std::string& path) {
+    if (path.empty()) {
+      throw std::invalid_argument("Tier file path must not be empty.");
+    }
+    MemoryTierCacheConfig config;
+    config.filePath = path;
+    return config;
+  }
+
+  // true if this tier is backed by a file instead of shared memory
+  bool isFileBacked() const noexcept { return !filePath.empty(); }
+
+  // path of the backing file. empty for shared memory tiers
+  const std::string& getFilePath() const noexcept { return filePath; }
+
   // Specifies ratio of this memory tier to other tiers. Absolute size
   // of each tier can be calculated as:
   // cacheSize * tierRatio / Sum of ratios for all tiers.
@@ -73,8 +98,9 @@ class MemoryTierCacheConfig {
   // Numa node(s) to bind the tier
   NumaBitMask numaNodes;
 
-  // TODO: introduce a container for tier settings when adding support for
-  // file-mapped memory
+  // Path of the file backing this tier. Empty for shared memory.
+  std::string filePath;
+
   MemoryTierCacheConfig() = default;
 };
 } // namespace cachelib
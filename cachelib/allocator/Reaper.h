@@ -40,6 +40,10 @@ struct ReaperAPIWrapper {
     return cache.removeIfExpired(handle);
   }
 
+  static uint64_t reapExpiredTtlBands(C& cache) {
+    return cache.reapExpiredTtlBands();
+  }
+
   template <typename Fn>
   static void traverseAndExpireItems(C& cache, Fn&& f) {
     cache.traverseAndExpireItems(std::forward<Fn>(f));
@@ -113,6 +117,16 @@ class Reaper : public PeriodicWorker {
 
 template <typename CacheT>
 void Reaper<CacheT>::work() {
+  // the expired items at the tail of the TTL bands are found without
+  // walking the slabs, so they are dropped first.
+  try {
+    numReapedItems_.fetch_add(
+        ReaperAPIWrapper<CacheT>::reapExpiredTtlBands(cache_),
+        std::memory_order_relaxed);
+  } catch (const std::exception& e) {
+    numErrs_.fetch_add(1, std::memory_order_relaxed);
+    XLOGF(DBG, "Error while reaping TTL bands. Msg = {}", e.what());
+  }
   reapSlabWalkMode();
 }
 
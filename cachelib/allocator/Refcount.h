@@ -116,6 +116,9 @@ class FOLLY_PACK_ATTR RefcountWithFlags {
     // unevictable in the past.
     kUnevictable_NOOP,
 
+    // Value of the item is compressed (see ItemCompression.h)
+    kCompressed,
+
     // Unused. This is just to indciate the maximum number of flags
     kFlagMax,
   };
@@ -422,6 +425,14 @@ class FOLLY_PACK_ATTR RefcountWithFlags {
   void unmarkNvmEvicted() noexcept { return unSetFlag<kNvmEvicted>(); }
   bool isNvmEvicted() const noexcept { return isFlagSet<kNvmEvicted>(); }
 
+  /**
+   * Marks that the value of the item holds a compressed copy of the value
+   * the user wrote. The cache inflates it back before handing it out.
+   */
+  void markCompressed() noexcept { return setFlag<kCompressed>(); }
+  void unmarkCompressed() noexcept { return unSetFlag<kCompressed>(); }
+  bool isCompressed() const noexcept { return isFlagSet<kCompressed>(); }
+
   // Whether or not an item is completely drained of access
   // Refcount is 0 and the item is not linked, accessible, nor exclusive
   bool isDrained() const noexcept { return getRefWithAccessAndAdmin() == 0; }
@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Format.h>
+#include <folly/Portability.h>
+#include <folly/Random.h>
+#include <folly/Range.h>
+#include <folly/hash/SpookyHashV2.h>
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#include "cachelib/common/AtomicCounter.h"
+
+namespace facebook::cachelib {
+
+// Stats for a ValueDedup instance. Byte counts only cover values large enough
+// to be de-duplicated; small values are stored inline and not counted.
+struct ValueDedupStats {
+  // sum of the sizes of all values currently referencing a payload, as if
+  // every key held its own copy
+  uint64_t logicalBytes{0};
+
+  // bytes actually held by payload items
+  uint64_t storedBytes{0};
+
+  // number of payload items currently in the cache
+  uint64_t numPayloads{0};
+
+  // inserts that found an identical payload and only took a reference
+  uint64_t numDedupHits{0};
+
+  // inserts that had to store a new payload
+  uint64_t numDedupMisses{0};
+
+  // lookups whose payload had been evicted. These are reported as misses.
+  uint64_t numDanglingRefs{0};
+
+  // values that collided on fingerprint with different bytes and were stored
+  // inline instead
+  uint64_t numCollisions{0};
+
+  // logical bytes per stored byte. 1 means nothing is shared.
+  double dedupRatio() const {
+    return storedBytes == 0 ? 1.0
+                            : static_cast<double>(logicalBytes) / storedBytes;
+  }
+
+  // memory saved by sharing payloads across keys
+  uint64_t bytesSaved() const {
+    return logicalBytes > storedBytes ? logicalBytes - storedBytes : 0;
+  }
+};
+
+// wrapper that exposes the private APIs of CacheType that are specifically
+// needed for ValueDedup.
+template <typename C>
+struct ValueDedupAPIWrapper {
+  // look up without recording an access or checking the expiry
+  static typename C::WriteHandle findInternal(C& cache,
+                                              typename C::Item::Key key) {
+    return cache.findInternal(key);
+  }
+};
+
+// Content addressed de-duplication of values on top of a cache. Values at or
+// above a size threshold are fingerprinted and stored once as a payload item
+// keyed by their fingerprint. The item for the user key only carries a
+// reference to the payload, similar to how chained items hang off a parent.
+//
+// Payloads count the keys that reference them. The count is dropped when a
+// key item is freed, which requires the cache's remove callback to forward
+// to onRemove(). The callback is cache wide, and onRemove() only acts on
+// items of the pool given to ValueDedup:
+//
+//   std::unique_ptr<ValueDedup<LruAllocator>> dedup;
+//   config.setRemoveCallback([&](const auto& data) { dedup->onRemove(data); });
+//   auto cache = std::make_unique<LruAllocator>(config);
+//   dedup = std::make_unique<ValueDedup<LruAllocator>>(*cache, pid, {});
+//
+// The last key to go away removes the payload. Payloads are regular items
+// and are subject to eviction like any other item. Every lookup through any
+// referencing key bumps the payload in the eviction queue, so a payload
+// shared by many keys is charged once and stays as hot as its hottest key.
+// If a payload is evicted while still referenced, lookups of its keys are
+// treated as misses and the stale key is dropped. Every payload gets a
+// random id that its references carry, so that a payload stored again for
+// the same value is not mistaken for the evicted one.
+//
+// All keys written through this class must also be read and written through
+// it since the stored value carries a small header.
+template <typename CacheT>
+class ValueDedup {
+ public:
+  using Cache = CacheT;
+  using Item = typename Cache::Item;
+  using Key = typename Item::Key;
+  using ReadHandle = typename Cache::ReadHandle;
+  using WriteHandle = typename Cache::WriteHandle;
+  using RemoveCbData = typename Cache::RemoveCbData;
+
+  struct Config {
+    // values smaller than this are stored inline in the key item. The
+    // reference to a payload costs about 32 bytes, so very small values are
+    // never worth sharing.
+    uint32_t minValueSize{1024};
+  };
+
+  // Result of a lookup. The handle keeps the bytes of the value alive and
+  // may either be the key item or the shared payload.
+  struct ReadResult {
+    ReadHandle handle;
+    folly::ByteRange value;
+
+    explicit operator bool() const noexcept { return handle != nullptr; }
+  };
+
+  // @param cache   the cache to store keys and payloads in. Its remove
+  //                callback must forward to onRemove()
+  // @param pid     pool to allocate key and payload items from
+  // @param config  de-dup config
+  ValueDedup(Cache& cache, PoolId pid, Config config)
+      : cache_(cache), pid_(pid), config_(config) {}
+
+  // Insert or replace the value for the key.
+  //
+  // @return true if the value was stored, false if we could not allocate
+  // @throw std::invalid_argument if the key is invalid or the value too large
+  bool insertOrReplace(Key key, folly::ByteRange value) {
+    if (value.size() < config_.minValueSize) {
+      return insertInline(key, value);
+    }
+
+    auto ref = makeRef(value);
+    auto payload = acquirePayload(ref, value);
+    if (!payload) {
+      return insertInline(key, value);
+    }
+
+    auto handle = cache_.allocate(pid_, key, sizeof(Tag) + sizeof(DedupRef));
+    if (!handle) {
+      releasePayload(ref);
+      return false;
+    }
+    auto* mem = reinterpret_cast<uint8_t*>(handle->getMemory());
+    *mem = static_cast<uint8_t>(Tag::kRef);
+    std::memcpy(mem + sizeof(Tag), &ref, sizeof(ref));
+    // from here on, the reference is dropped through onRemove once the key
+    // item is freed, including when it is replaced or never made it in.
+    logicalBytes_.add(ref.size);
+    cache_.insertOrReplace(handle);
+    return true;
+  }
+
+  // Look up the value for the key.
+  //
+  // @return a result holding the value, or an empty result on a miss
+  ReadResult find(Key key) {
+    auto handle = cache_.find(key);
+    if (!handle) {
+      return {};
+    }
+
+    const auto* mem = reinterpret_cast<const uint8_t*>(handle->getMemory());
+    const auto size = handle->getSize();
+    if (size < sizeof(Tag) + sizeof(DedupRef) ||
+        static_cast<Tag>(mem[0]) != Tag::kRef) {
+      const folly::ByteRange value{mem + sizeof(Tag), size - sizeof(Tag)};
+      return ReadResult{std::move(handle), value};
+    }
+
+    DedupRef ref;
+    std::memcpy(&ref, mem + sizeof(Tag), sizeof(ref));
+    auto payload = cache_.find(makePayloadKey(ref));
+    if (!payload || !refersTo(ref, getPayloadHeader(*payload))) {
+      numDanglingRefs_.inc();
+      cache_.remove(handle);
+      return {};
+    }
+    const auto* bytes =
+        reinterpret_cast<const uint8_t*>(payload->getMemory()) +
+        sizeof(PayloadHeader);
+    return ReadResult{std::move(payload), folly::ByteRange{bytes, ref.size}};
+  }
+
+  // Remove the key. The payload goes away with its last reference.
+  typename Cache::RemoveRes remove(Key key) { return cache_.remove(key); }
+
+  // Must be called from the cache's remove callback for every item freed.
+  // Items of other pools are ignored, so that the callback can be shared with
+  // pools that do not use de-duplication.
+  void onRemove(const RemoveCbData& data) {
+    if (cache_.getAllocInfo(data.item.getMemory()).poolId != pid_) {
+      return;
+    }
+    const auto key = data.item.getKey();
+    if (isPayloadKey(key)) {
+      PayloadHeader header;
+      std::memcpy(&header, data.item.getMemory(), sizeof(header));
+      storedBytes_.sub(header.size);
+      numPayloads_.dec();
+      return;
+    }
+
+    const auto size = data.item.getSize();
+    const auto* mem = reinterpret_cast<const uint8_t*>(data.item.getMemory());
+    if (size < sizeof(Tag) + sizeof(DedupRef) ||
+        static_cast<Tag>(mem[0]) != Tag::kRef) {
+      return;
+    }
+    DedupRef ref;
+    std::memcpy(&ref, mem + sizeof(Tag), sizeof(ref));
+    logicalBytes_.sub(ref.size);
+    releasePayload(ref);
+  }
+
+  ValueDedupStats getStats() const {
+    ValueDedupStats stats;
+    stats.logicalBytes = logicalBytes_.get();
+    stats.storedBytes = storedBytes_.get();
+    stats.numPayloads = numPayloads_.get();
+    stats.numDedupHits = numDedupHits_.get();
+    stats.numDedupMisses = numDedupMisses_.get();
+    stats.numDanglingRefs = numDanglingRefs_.get();
+    stats.numCollisions = numCollisions_.get();
+    return stats;
+  }
+
+  // @return true if this key is used internally to hold a shared payload
+  static bool isPayloadKey(folly::StringPiece key) {
+    return key.startsWith(kPayloadKeyPrefix);
+  }
+
+ private:
+  enum class Tag : uint8_t { kInline = 0, kRef = 1 };
+
+  // what a key item holds for a de-duplicated value
+  struct FOLLY_PACK_ATTR DedupRef {
+    uint64_t hash1;
+    uint64_t hash2;
+    uint32_t size;
+    uint64_t payloadId;
+  };
+
+  // prefix of a payload item. The reference count is only read and written
+  // under the lock for its fingerprint.
+  struct FOLLY_PACK_ATTR PayloadHeader {
+    uint32_t numRefs;
+    uint32_t size;
+    uint64_t payloadId;
+  };
+
+  static constexpr folly::StringPiece kPayloadKeyPrefix{"__cachelib_dedup:"};
+  static constexpr size_t kNumLocks = 64;
+
+  // the payload id is filled in once the payload is acquired
+  static DedupRef makeRef(folly::ByteRange value) {
+    DedupRef ref{0, 0, static_cast<uint32_t>(value.size()), 0};
+    folly::hash::SpookyHashV2::Hash128(value.data(), value.size(), &ref.hash1,
+                                       &ref.hash2);
+    return ref;
+  }
+
+  static std::string makePayloadKey(const DedupRef& ref) {
+    return folly::sformat("{}{:016x}{:016x}{:08x}", kPayloadKeyPrefix,
+                          ref.hash1, ref.hash2, ref.size);
+  }
+
+  static bool refersTo(const DedupRef& ref, const PayloadHeader& header) {
+    return header.size == ref.size && header.payloadId == ref.payloadId;
+  }
+
+  static PayloadHeader getPayloadHeader(const Item& item) {
+    PayloadHeader header;
+    std::memcpy(&header, item.getMemory(), sizeof(header));
+    return header;
+  }
+
+  static void setPayloadHeader(Item& item, const PayloadHeader& header) {
+    std::memcpy(item.getMemory(), &header, sizeof(header));
+  }
+
+  static bool payloadMatches(const Item& item, folly::ByteRange value) {
+    return getPayloadHeader(item).size == value.size() &&
+           std::memcmp(reinterpret_cast<const uint8_t*>(item.getMemory()) +
+                           sizeof(PayloadHeader),
+                       value.data(), value.size()) == 0;
+  }
+
+  std::mutex& getLock(const DedupRef& ref) {
+    return locks_[ref.hash1 % kNumLocks];
+  }
+
+  // Take a reference on the payload holding value, storing it if needed,
+  // and set the id of the payload in ref.
+  // The lock is never held across an allocation since that can evict a key
+  // item and re-enter onRemove for the same lock.
+  //
+  // @return the payload or nullptr if we could not share the value
+  WriteHandle acquirePayload(DedupRef& ref, folly::ByteRange value) {
+    const auto key = makePayloadKey(ref);
+    {
+      std::lock_guard<std::mutex> l{getLock(ref)};
+      if (auto payload = tryAddRef(key, value, ref)) {
+        numDedupHits_.inc();
+        return payload;
+      }
+    }
+
+    auto handle =
+        cache_.allocate(pid_, key, sizeof(PayloadHeader) + value.size());
+    if (!handle) {
+      return nullptr;
+    }
+    const auto payloadId = folly::Random::rand64();
+    setPayloadHeader(*handle, PayloadHeader{1, ref.size, payloadId});
+    std::memcpy(reinterpret_cast<uint8_t*>(handle->getMemory()) +
+                    sizeof(PayloadHeader),
+                value.data(), value.size());
+
+    std::lock_guard<std::mutex> l{getLock(ref)};
+    if (auto payload = tryAddRef(key, value, ref)) {
+      // raced with another insert of the same value
+      numDedupHits_.inc();
+      return payload;
+    }
+    if (!cache_.insert(handle)) {
+      // the payload key is taken by a different value
+      return nullptr;
+    }
+    ref.payloadId = payloadId;
+    numDedupMisses_.inc();
+    numPayloads_.inc();
+    storedBytes_.add(ref.size);
+    return handle;
+  }
+
+  // Must be called with the lock for the payload held. Sets the id of the
+  // payload in ref.
+  //
+  // @return the payload with an extra reference, or nullptr if there is no
+  //         payload for the key or its bytes differ from value.
+  WriteHandle tryAddRef(folly::StringPiece key,
+                        folly::ByteRange value,
+                        DedupRef& ref) {
+    auto payload = ValueDedupAPIWrapper<Cache>::findInternal(cache_, key);
+    if (!payload) {
+      return nullptr;
+    }
+    if (!payloadMatches(*payload, value)) {
+      numCollisions_.inc();
+      return nullptr;
+    }
+    auto header = getPayloadHeader(*payload);
+    ++header.numRefs;
+    setPayloadHeader(*payload, header);
+    ref.payloadId = header.payloadId;
+    return payload;
+  }
+
+  // Drop a reference on the payload and remove it once unreferenced. A
+  // reference to a payload that was evicted, and stored again since, does
+  // not count towards the new payload and is ignored.
+  void releasePayload(const DedupRef& ref) {
+    const auto key = makePayloadKey(ref);
+    std::lock_guard<std::mutex> l{getLock(ref)};
+    auto payload = ValueDedupAPIWrapper<Cache>::findInternal(cache_, key);
+    if (!payload) {
+      return;
+    }
+    auto header = getPayloadHeader(*payload);
+    if (!refersTo(ref, header) || header.numRefs == 0) {
+      return;
+    }
+    if (--header.numRefs == 0) {
+      cache_.remove(payload);
+      return;
+    }
+    setPayloadHeader(*payload, header);
+  }
+
+  bool insertInline(Key key, folly::ByteRange value) {
+    auto handle = cache_.allocate(pid_, key, sizeof(Tag) + value.size());
+    if (!handle) {
+      return false;
+    }
+    auto* mem = reinterpret_cast<uint8_t*>(handle->getMemory());
+    *mem = static_cast<uint8_t>(Tag::kInline);
+    if (!value.empty()) {
+      std::memcpy(mem + sizeof(Tag), value.data(), value.size());
+    }
+    cache_.insertOrReplace(handle);
+    return true;
+  }
+
+  Cache& cache_;
+  const PoolId pid_;
+  const Config config_;
+
+  std::array<std::mutex, kNumLocks> locks_;
+
+  AtomicCounter logicalBytes_{0};
+  AtomicCounter storedBytes_{0};
+  AtomicCounter numPayloads_{0};
+  AtomicCounter numDedupHits_{0};
+  AtomicCounter numDedupMisses_{0};
+  AtomicCounter numDanglingRefs_{0};
+  AtomicCounter numCollisions_{0};
+};
+} // namespace facebook::cachelib
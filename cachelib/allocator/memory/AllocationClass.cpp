@@ -17,6 +17,7 @@
 #include "cachelib/allocator/memory/AllocationClass.h"
 
 #include <folly/Try.h>
+#include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
 
 #include "cachelib/allocator/memory/SlabAllocator.h"
@@ -30,17 +31,17 @@
 #pragma GCC diagnostic pop
 
 #include <algorithm>
-#include <chrono>
 #include <stdexcept>
-#include <thread>
+#include <tuple>
 
 #include "cachelib/allocator/memory/serialize/gen-cpp2/objects_types.h"
 
 using namespace facebook::cachelib;
 
-constexpr unsigned int AllocationClass::kFreeAllocsPruneLimit;
-constexpr unsigned int AllocationClass::kFreeAllocsPruneSleepMicroSecs;
 constexpr unsigned int AllocationClass::kForEachAllocPrefetchOffset;
+constexpr uint32_t AllocationClass::kBitsPerWord;
+constexpr uint32_t AllocationClass::kNotPartial;
+constexpr unsigned int AllocationClass::kPartialSlabCandidates;
 
 AllocationClass::AllocationClass(ClassId classId,
                                  PoolId poolId,
@@ -49,9 +50,7 @@ AllocationClass::AllocationClass(ClassId classId,
     : classId_(classId),
       poolId_(poolId),
       allocationSize_(allocSize),
-      slabAlloc_(s),
-      freedAllocations_{
-          slabAlloc_.createPtrCompressor<FreeAlloc, CompressedPtr4B>()} {
+      slabAlloc_(s) {
   checkState();
 }
 
@@ -102,14 +101,22 @@ AllocationClass::AllocationClass(
       currOffset_(static_cast<uint32_t>(*object.currOffset())),
       currSlab_(s.getSlabForIdx(*object.currSlabIdx())),
       slabAlloc_(s),
-      freedAllocations_(
-          *object.freedAllocationsObject(),
-          slabAlloc_.createPtrCompressor<FreeAlloc, CompressedPtr4B>()),
       canAllocate_(*object.canAllocate()) {
   if (!slabAlloc_.isRestorable()) {
     throw std::logic_error("The allocation class cannot be restored.");
   }
 
+  // rebuild the free bitmaps from the saved list of free allocations.
+  FreeList freedAllocations{
+      *object.freedAllocationsObject(),
+      slabAlloc_.createPtrCompressor<FreeAlloc, CompressedPtr4B>()};
+  while (!freedAllocations.empty()) {
+    void* alloc = reinterpret_cast<void*>(freedAllocations.getHead());
+    freedAllocations.pop();
+    auto* slab = slabAlloc_.getSlabForMemory(alloc);
+    markFreeLocked(getSlabFreeStateLocked(slab), getAllocIdx(slab, alloc));
+  }
+
   for (auto allocatedSlabIdx : *object.allocatedSlabIdxs()) {
     allocatedSlabs_.push_back(slabAlloc_.getSlabForIdx(allocatedSlabIdx));
   }
@@ -131,12 +138,12 @@ void AllocationClass::addSlabLocked(Slab* slab) {
 
 void AllocationClass::addSlab(Slab* slab) {
   XDCHECK_NE(nullptr, slab);
-  lock_->lock_combine([this, slab]() { addSlabLocked(slab); });
+  lockCombine([this, slab]() { addSlabLocked(slab); });
 }
 
 void* AllocationClass::addSlabAndAllocate(Slab* slab) {
   XDCHECK_NE(nullptr, slab);
-  return lock_->lock_combine([this, slab]() {
+  return lockCombine([this, slab]() {
     addSlabLocked(slab);
     return allocateLocked();
   });
@@ -158,12 +165,12 @@ void* AllocationClass::allocate() {
   if (!canAllocate_) {
     return nullptr;
   }
-  return lock_->lock_combine([this]() -> void* { return allocateLocked(); });
+  return lockCombine([this]() -> void* { return allocateLocked(); });
 }
 
 void* AllocationClass::allocateLocked() {
   // fast path for case when the cache is mostly full.
-  if (freedAllocations_.empty() && freeSlabs_.empty() &&
+  if (numFreeAllocs_ == 0 && freeSlabs_.empty() &&
       !canAllocateFromCurrentSlabLocked()) {
     canAllocate_ = false;
     return nullptr;
@@ -171,12 +178,9 @@ void* AllocationClass::allocateLocked() {
 
   XDCHECK(canAllocate_);
 
-  // grab from the free list if possible.
-  if (!freedAllocations_.empty()) {
-    FreeAlloc* ret = freedAllocations_.getHead();
-    XDCHECK(ret != nullptr);
-    freedAllocations_.pop();
-    return reinterpret_cast<void*>(ret);
+  // reuse a freed allocation if possible.
+  if (numFreeAllocs_ > 0) {
+    return allocateFromPartialSlabLocked();
   }
 
   // see if we have an active slab that is being used to carve the
@@ -192,6 +196,109 @@ void* AllocationClass::allocateLocked() {
   return allocateFromCurrentSlabLocked();
 }
 
+void* AllocationClass::allocateFromPartialSlabLocked() noexcept {
+  XDCHECK_GT(numFreeAllocs_, 0u);
+  if (allocSlab_ == nullptr || allocSlab_->numFree == 0) {
+    pickAllocSlabLocked();
+  }
+
+  auto& state = *allocSlab_;
+  XDCHECK_GT(state.numFree, 0u);
+  uint32_t word = state.firstWord;
+  while (state.bits[word] == 0) {
+    ++word;
+    XDCHECK_LT(word, state.bits.size());
+  }
+  const uint32_t bit = folly::findFirstSet(state.bits[word]) - 1;
+  state.bits[word] &= state.bits[word] - 1;
+  state.firstWord = word;
+  --state.numFree;
+  --numFreeAllocs_;
+  if (state.numFree == 0) {
+    removePartialSlabLocked(state);
+  }
+  return state.slab->memoryAtOffset((word * kBitsPerWord + bit) *
+                                    allocationSize_);
+}
+
+void AllocationClass::pickAllocSlabLocked() noexcept {
+  XDCHECK(!partialSlabs_.empty());
+  // look at a few slabs from the back since recently partial slabs are likely
+  // to be the fullest and still warm in the cpu cache.
+  const size_t n =
+      std::min<size_t>(kPartialSlabCandidates, partialSlabs_.size());
+  SlabFreeState* best = partialSlabs_.back();
+  for (size_t i = 1; i < n; i++) {
+    auto* candidate = partialSlabs_[partialSlabs_.size() - 1 - i];
+    if (candidate->numFree < best->numFree) {
+      best = candidate;
+    }
+  }
+  allocSlab_ = best;
+}
+
+void AllocationClass::addPartialSlabLocked(SlabFreeState& state) {
+  XDCHECK_EQ(state.partialIdx, kNotPartial);
+  state.partialIdx = static_cast<uint32_t>(partialSlabs_.size());
+  partialSlabs_.push_back(&state);
+}
+
+void AllocationClass::removePartialSlabLocked(SlabFreeState& state) {
+  XDCHECK_NE(state.partialIdx, kNotPartial);
+  auto* last = partialSlabs_.back();
+  last->partialIdx = state.partialIdx;
+  partialSlabs_[state.partialIdx] = last;
+  partialSlabs_.pop_back();
+  state.partialIdx = kNotPartial;
+  if (allocSlab_ == &state) {
+    allocSlab_ = nullptr;
+  }
+}
+
+AllocationClass::SlabFreeState& AllocationClass::getSlabFreeStateLocked(
+    Slab* slab) {
+  auto it = slabFreeStates_.find(slab);
+  if (it == slabFreeStates_.end()) {
+    it = slabFreeStates_
+             .emplace(std::piecewise_construct, std::forward_as_tuple(slab),
+                      std::forward_as_tuple(slab, getAllocsPerSlab()))
+             .first;
+  }
+  return it->second;
+}
+
+void AllocationClass::markFreeLocked(SlabFreeState& state, size_t idx) {
+  const auto word = static_cast<uint32_t>(idx / kBitsPerWord);
+  const uint64_t mask = 1ULL << (idx % kBitsPerWord);
+  if (state.bits[word] & mask) {
+    throw std::invalid_argument(
+        folly::sformat("Allocation {} is already marked as free",
+                       state.slab->memoryAtOffset(idx * allocationSize_)));
+  }
+  state.bits[word] |= mask;
+  state.firstWord = std::min(state.firstWord, word);
+  if (state.numFree++ == 0) {
+    addPartialSlabLocked(state);
+  }
+  ++numFreeAllocs_;
+}
+
+std::vector<uint64_t> AllocationClass::removeSlabFreeStateLocked(
+    const Slab* slab) {
+  auto it = slabFreeStates_.find(slab);
+  if (it == slabFreeStates_.end()) {
+    return {};
+  }
+  auto& state = it->second;
+  if (state.partialIdx != kNotPartial) {
+    removePartialSlabLocked(state);
+  }
+  numFreeAllocs_ -= state.numFree;
+  auto bits = std::move(state.bits);
+  slabFreeStates_.erase(it);
+  return bits;
+}
+
 void AllocationClass::setupCurrentSlabLocked() {
   XDCHECK(!freeSlabs_.empty());
   auto slab = freeSlabs_.back();
@@ -204,6 +311,13 @@ void AllocationClass::setupCurrentSlabLocked() {
 const Slab* AllocationClass::getSlabForReleaseLocked() const noexcept {
   if (!freeSlabs_.empty()) {
     return freeSlabs_.front();
+  } else if (!partialSlabs_.empty()) {
+    const auto it = std::max_element(
+        partialSlabs_.begin(), partialSlabs_.end(),
+        [](const SlabFreeState* a, const SlabFreeState* b) {
+          return a->numFree < b->numFree;
+        });
+    return (*it)->slab;
   } else if (!allocatedSlabs_.empty()) {
     auto idx =
         folly::Random::rand32(static_cast<uint32_t>(allocatedSlabs_.size()));
@@ -225,7 +339,8 @@ SlabReleaseContext AllocationClass::startSlabRelease(
   const Slab* slab;
   SlabHeader* header;
   {
-    std::unique_lock<folly::DistributedMutex> l(*lock_);
+    auto l = util::lockProfiled<std::unique_lock<folly::DistributedMutex>>(
+        *lock_, lockStats_);
     // if a hint is provided, use it. If not, try to get a free/allocated slab.
     slab = hint == nullptr ? getSlabForReleaseLocked() : hintSlab;
     if (slab == nullptr) {
@@ -292,17 +407,14 @@ SlabReleaseContext AllocationClass::startSlabRelease(
 
   auto results = pruneFreeAllocs(slab, shouldAbortFn);
   if (results.first) {
-    lock_->lock_combine([&]() {
-      header->setMarkedForRelease(false);
-      slabReleaseAllocMap_.erase(getSlabPtrValue(slab));
-    });
+    lockCombine([&]() { restoreSlabFromReleaseLocked(slab, header); });
     throw exception::SlabReleaseAborted(
         folly::sformat("Slab Release aborted "
                        "during pruning free allocs. Slab address: {}",
                        slab));
   }
   std::vector<void*> activeAllocations = std::move(results.second);
-  return lock_->lock_combine([&]() {
+  return lockCombine([&]() {
     if (activeAllocations.empty()) {
       header->classId = Slab::kInvalidClassId;
       header->allocSize = 0;
@@ -336,111 +448,19 @@ size_t AllocationClass::getAllocIdx(const Slab* slab,
   return offset / allocationSize_;
 }
 
-void AllocationClass::partitionFreeAllocs(const Slab* slab,
-                                          FreeList& freeAllocs,
-                                          FreeList& inSlab,
-                                          FreeList& notInSlab) {
-  for (unsigned int i = 0; i < kFreeAllocsPruneLimit && !freeAllocs.empty();
-       ++i) {
-    auto alloc = freeAllocs.getHead();
-    freeAllocs.pop();
-    if (slabAlloc_.isMemoryInSlab(reinterpret_cast<void*>(alloc), slab)) {
-      inSlab.insert(*alloc);
-    } else {
-      notInSlab.insert(*alloc);
-    }
-  }
-}
-
 std::pair<bool, std::vector<void*>> AllocationClass::pruneFreeAllocs(
     const Slab* slab, SlabReleaseAbortFn shouldAbortFn) {
-  // Find free allocations that belong to this active slab. If part of
-  // allocated slab, release any freed allocations belonging to this slab.
-  // Set the bit to true if the corresponding allocation is freed, false
-  // otherwise.
-  FreeList freeAllocs{
-      slabAlloc_.createPtrCompressor<FreeAlloc, CompressedPtr4B>()};
-  FreeList notInSlab{
-      slabAlloc_.createPtrCompressor<FreeAlloc, CompressedPtr4B>()};
-  FreeList inSlab{slabAlloc_.createPtrCompressor<FreeAlloc, CompressedPtr4B>()};
-
-  lock_->lock_combine([&]() {
-    // Take the allocation class free list offline
-    // This is because we need to process this free list in batches
-    // in order not to stall threads that need to allocate memory
-    std::swap(freeAllocs, freedAllocations_);
-
-    // Check up to kFreeAllocsPruneLimit while holding the lock. This limits
-    // the amount of time we hold the lock while also having a good chance
-    // of freedAllocations_ not being completely empty once we unlock.
-    partitionFreeAllocs(slab, freeAllocs, inSlab, notInSlab);
-  });
-
-  bool shouldAbort = false;
-  do {
-    if (shouldAbortFn()) {
-      shouldAbort = true;
-      break;
-    }
-    lock_->lock_combine([&]() {
-      // Put back allocs we checked while not holding the lock.
-      if (!notInSlab.empty()) {
-        freedAllocations_.splice(std::move(notInSlab));
-        canAllocate_ = true;
-      }
-
-      auto& allocState = getSlabReleaseAllocMapLocked(slab);
-      // Mark allocs we found while not holding the lock as freed.
-      while (!inSlab.empty()) {
-        auto alloc = inSlab.getHead();
-        inSlab.pop();
-        XDCHECK(
-            slabAlloc_.isMemoryInSlab(reinterpret_cast<void*>(alloc), slab));
-        const auto idx = getAllocIdx(slab, reinterpret_cast<void*>(alloc));
-        XDCHECK_LT(idx, allocState.size());
-        allocState[idx] = true;
-      }
-    }); // alloc lock scope
-
-    if (freeAllocs.empty()) {
-      XDCHECK(notInSlab.empty());
-      XDCHECK(inSlab.empty());
-      break;
-    }
-
-    // Scan the copied free list outside of lock. We place allocs into either
-    // 'inSlab' or 'notInSlab' to be dealt with next time we have the lock.
-    // NOTE: we limit to kFreeAllocsPruneLimit iterations so we can periodically
-    // return allocs from 'notInSlab' to 'freedAllocations_'.
-    partitionFreeAllocs(slab, freeAllocs, inSlab, notInSlab);
-
-    // Let other threads do some work since we will process lots of batches
-    /* sleep override */ std::this_thread::sleep_for(
-        std::chrono::microseconds(kFreeAllocsPruneSleepMicroSecs));
-  } while (true);
-
-  // Collect the list of active allocations
+  // The release alloc map was initialized from the slab's free bitmap, so
+  // whatever is not marked free there is an active allocation.
   std::vector<void*> activeAllocations;
-
-  // If shutdown is in progress, undo everything we did above and return
-  // empty active allocations
-  if (shouldAbort) {
-    lock_->lock_combine([&]() {
-      if (!notInSlab.empty()) {
-        freeAllocs.splice(std::move(notInSlab));
-      }
-      if (!inSlab.empty()) {
-        freeAllocs.splice(std::move(inSlab));
-      }
-      freedAllocations_.splice(std::move(freeAllocs));
-    });
-    return {shouldAbort, activeAllocations};
+  if (shouldAbortFn()) {
+    return {true, activeAllocations};
   }
 
   // reserve the maximum space for active allocations so we don't
   // malloc under the lock later
   activeAllocations.reserve(Slab::kSize / allocationSize_);
-  lock_->lock_combine([&]() {
+  lockCombine([&]() {
     const auto& allocState = getSlabReleaseAllocMapLocked(slab);
 
     // Iterating through a vector<bool>. Up to 65K iterations if
@@ -455,11 +475,11 @@ std::pair<bool, std::vector<void*>> AllocationClass::pruneFreeAllocs(
     }
   }); // alloc lock scope
 
-  return {shouldAbort, activeAllocations};
+  return {false, activeAllocations};
 }
 
 bool AllocationClass::allFreed(const Slab* slab) const {
-  return lock_->lock_combine([this, slab]() {
+  return lockCombine([this, slab]() {
     const auto it = slabReleaseAllocMap_.find(getSlabPtrValue(slab));
     if (it == slabReleaseAllocMap_.end()) {
       throw std::runtime_error(folly::sformat(
@@ -493,33 +513,35 @@ void AllocationClass::abortSlabRelease(const SlabReleaseContext& context) {
     throw std::invalid_argument(folly::sformat("context is already released"));
   }
   auto slab = context.getSlab();
-  const auto slabPtrVal = getSlabPtrValue(slab);
   auto header = slabAlloc_.getSlabHeader(slab);
 
-  lock_->lock_combine([&]() {
-    const auto it = slabReleaseAllocMap_.find(getSlabPtrValue(slab));
-    bool inserted = false;
-    if (it != slabReleaseAllocMap_.end()) {
-      const auto& allocState = it->second;
-      for (size_t idx = 0; idx < allocState.size(); idx++) {
-        if (allocState[idx]) {
-          auto alloc = getAllocForIdx(slab, idx);
-          freedAllocations_.insert(*reinterpret_cast<FreeAlloc*>(alloc));
-          inserted = true;
-        }
+  lockCombine([&]() {
+    restoreSlabFromReleaseLocked(slab, header);
+    --activeReleases_;
+  });
+}
+
+void AllocationClass::restoreSlabFromReleaseLocked(const Slab* slab,
+                                                   SlabHeader* header) {
+  const auto it = slabReleaseAllocMap_.find(getSlabPtrValue(slab));
+  if (it != slabReleaseAllocMap_.end()) {
+    const auto& allocState = it->second;
+    auto& state = getSlabFreeStateLocked(const_cast<Slab*>(slab));
+    for (size_t idx = 0; idx < allocState.size(); idx++) {
+      if (allocState[idx]) {
+        markFreeLocked(state, idx);
       }
     }
-    if (inserted) {
+    if (state.numFree > 0) {
       canAllocate_ = true;
     }
-    slabReleaseAllocMap_.erase(slabPtrVal);
-    allocatedSlabs_.push_back(const_cast<Slab*>(slab));
-    // restore the classId and allocSize
-    header->classId = classId_;
-    header->allocSize = allocationSize_;
-    header->setMarkedForRelease(false);
-    --activeReleases_;
-  });
+    slabReleaseAllocMap_.erase(it);
+  }
+  allocatedSlabs_.push_back(const_cast<Slab*>(slab));
+  // restore the classId and allocSize
+  header->classId = classId_;
+  header->allocSize = allocationSize_;
+  header->setMarkedForRelease(false);
 }
 
 void AllocationClass::completeSlabRelease(const SlabReleaseContext& context) {
@@ -531,7 +553,7 @@ void AllocationClass::completeSlabRelease(const SlabReleaseContext& context) {
   auto slab = context.getSlab();
   auto header = slabAlloc_.getSlabHeader(slab);
 
-  lock_->lock_combine([&]() {
+  lockCombine([&]() {
     // slab header must be valid and marked for release
     if (header == nullptr || header->classId != getId() ||
         !header->isMarkedForRelease()) {
@@ -548,7 +570,7 @@ void AllocationClass::completeSlabRelease(const SlabReleaseContext& context) {
   waitUntilAllFreed(slab);
 
   const auto slabPtrVal = getSlabPtrValue(slab);
-  lock_->lock_combine([&]() {
+  lockCombine([&]() {
     slabReleaseAllocMap_.erase(slabPtrVal);
 
     header->classId = Slab::kInvalidClassId;
@@ -610,7 +632,7 @@ bool AllocationClass::isAllocFreedLocked(const SlabReleaseContext& /*ctx*/,
 bool AllocationClass::isAllocFreed(const SlabReleaseContext& ctx,
                                    void* memory) const {
   checkSlabInRelease(ctx, memory);
-  return lock_->lock_combine(
+  return lockCombine(
       [this, &ctx, memory]() { return isAllocFreedLocked(ctx, memory); });
 }
 
@@ -619,7 +641,7 @@ void AllocationClass::processAllocForRelease(
     void* memory,
     const std::function<void(void*)>& callback) const {
   checkSlabInRelease(ctx, memory);
-  lock_->lock_combine([this, &ctx, memory, &callback]() {
+  lockCombine([this, &ctx, memory, &callback]() {
     if (!isAllocFreedLocked(ctx, memory)) {
       callback(memory);
     }
@@ -637,7 +659,7 @@ void AllocationClass::free(void* memory) {
   }
 
   const auto slabPtrVal = getSlabPtrValue(slab);
-  lock_->lock_combine([this, header, slab, memory, slabPtrVal]() {
+  lockCombine([this, header, slab, memory, slabPtrVal]() {
     // check under the lock we actually add the allocation back to the free list
     if (header->isMarkedForRelease()) {
       auto it = slabReleaseAllocMap_.find(slabPtrVal);
@@ -660,8 +682,7 @@ void AllocationClass::free(void* memory) {
       return;
     }
 
-    // TODO add checks here to ensure that we dont double free in debug mode.
-    freedAllocations_.insert(*reinterpret_cast<FreeAlloc*>(memory));
+    markFreeLocked(getSlabFreeStateLocked(slab), getAllocIdx(slab, memory));
     canAllocate_ = true;
   });
 }
@@ -686,20 +707,37 @@ serialization::AllocationClassObject AllocationClass::saveState() const {
   for (auto slab : freeSlabs_) {
     object.freeSlabIdxs()->push_back(slabAlloc_.slabIdx(slab));
   }
-  *object.freedAllocationsObject() = freedAllocations_.saveState();
+
+  // thread the free allocations into a list through their memory. This is
+  // the format the free allocations have always been saved in.
+  FreeList freedAllocations{
+      slabAlloc_.createPtrCompressor<FreeAlloc, CompressedPtr4B>()};
+  for (const auto& kv : slabFreeStates_) {
+    const auto& state = kv.second;
+    for (size_t word = 0; word < state.bits.size(); word++) {
+      auto bits = state.bits[word];
+      while (bits) {
+        const size_t idx = word * kBitsPerWord + folly::findFirstSet(bits) - 1;
+        bits &= bits - 1;
+        freedAllocations.insert(*reinterpret_cast<FreeAlloc*>(
+            state.slab->memoryAtOffset(idx * allocationSize_)));
+      }
+    }
+  }
+  *object.freedAllocationsObject() = freedAllocations.saveState();
   *object.canAllocate() = canAllocate_;
   return object;
 }
 
 ACStats AllocationClass::getStats() const {
-  return lock_->lock_combine([this]() -> ACStats {
+  return lockCombine([this]() -> ACStats {
     const auto freeAllocsInCurrSlab =
         canAllocateFromCurrentSlabLocked()
             ? (Slab::kSize - currOffset_) / allocationSize_
             : 0;
     const unsigned long long perSlab = getAllocsPerSlab();
     const unsigned long long nSlabsAllocated = allocatedSlabs_.size();
-    const unsigned long long nFreedAllocs = freedAllocations_.size();
+    const unsigned long long nFreedAllocs = numFreeAllocs_;
     const unsigned long long nActiveAllocs =
         nSlabsAllocated * perSlab - nFreedAllocs - freeAllocsInCurrSlab;
     return {allocationSize_, perSlab,       nSlabsAllocated, freeSlabs_.size(),
@@ -708,10 +746,15 @@ ACStats AllocationClass::getStats() const {
 }
 
 void AllocationClass::createSlabReleaseAllocMapLocked(const Slab* slab) {
-  // Initialize slab free state
+  // Initialize slab free state from the free bitmap of the slab.
   // Each bit represents whether or not an alloc has already been freed
   const auto slabPtrVal = getSlabPtrValue(slab);
   std::vector<bool> allocState(getAllocsPerSlab(), false);
+  const auto bits = removeSlabFreeStateLocked(slab);
+  for (size_t idx = 0; idx < allocState.size() && !bits.empty(); idx++) {
+    allocState[idx] =
+        bits[idx / kBitsPerWord] & (1ULL << (idx % kBitsPerWord));
+  }
   const auto res =
       slabReleaseAllocMap_.insert({slabPtrVal, std::move(allocState)});
   if (!res.second) {
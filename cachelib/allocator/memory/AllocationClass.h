@@ -16,10 +16,12 @@
 
 #pragma once
 
+#include <folly/container/F14Map.h>
 #include <folly/lang/Aligned.h>
 #include <folly/synchronization/DistributedMutex.h>
 
 #include <atomic>
+#include <limits>
 #include <mutex>
 #include <unordered_map>
 #include <vector>
@@ -30,6 +32,7 @@
 #include "cachelib/allocator/memory/Slab.h"
 #include "cachelib/allocator/memory/SlabAllocator.h"
 #include "cachelib/allocator/memory/serialize/gen-cpp2/objects_types.h"
+#include "cachelib/common/LockProfiler.h"
 
 namespace facebook {
 namespace cachelib {
@@ -166,7 +169,7 @@ class AllocationClass {
 
     // check for the header to be valid.
     using Return = folly::Optional<AllocInfo>;
-    auto allocInfo = lock_->lock_combine([this, slab]() -> Return {
+    auto allocInfo = lockCombine([this, slab]() -> Return {
       auto slabHdr = slabAlloc_.getSlabHeader(slab);
 
       if (!slabHdr || slabHdr->classId != classId_ ||
@@ -308,6 +311,10 @@ class AllocationClass {
   // @throw std::logic_error if the object state can not be serialized
   serialization::AllocationClassObject saveState() const;
 
+  // Records the acquisitions of the allocation class lock in the stats. Must
+  // be set before the allocation class is used.
+  void setLockStats(LockStats* stats) noexcept { lockStats_ = stats; }
+
  private:
   // check if the state of the AllocationClass is valid and if not, throws an
   // std::invalid_argument exception. This is intended for use in
@@ -326,14 +333,15 @@ class AllocationClass {
   void* allocateFromCurrentSlabLocked() noexcept;
 
   // get a suitable slab for being released from either the set of free slabs
-  // or the allocated slabs.
+  // or the allocated slabs. Among the allocated slabs, we prefer the one with
+  // the most free allocations since it has the fewest items to move or evict.
   const Slab* getSlabForReleaseLocked() const noexcept;
 
-  // prune the freeAllocs_ to eliminate any  allocs belonging to this slab and
-  // also return a list of active allocations. If there are any active
-  // allocations, it maintains the freeState for the slab release.
+  // return the list of active allocations of a slab being released. The free
+  // allocations of the slab are known from its free bitmap, so this does not
+  // need to walk any free list.
   //
-  // @param  slab   Eliminate allocs belonging to this slab
+  // @param  slab   the slab being released
   //
   // @param  shouldAbortFn  invoked in the code to see if this release slab
   //         process should be aborted
@@ -341,9 +349,6 @@ class AllocationClass {
   // @return a pair with
   //         a bool indicating if slab release should be aborted or not and
   //         a list of active allocations if should abort is false.
-  //
-  // @throw exception::SlabReleaseAborted if slab release is aborted due to
-  //        shouldAbortFn returning true.
   std::pair<bool, std::vector<void*>> pruneFreeAllocs(
       const Slab* slab,
       SlabReleaseAbortFn shouldAbortFn = []() { return false; });
@@ -385,11 +390,19 @@ class AllocationClass {
   void checkSlabInRelease(const SlabReleaseContext& ctx,
                           const void* memory) const;
 
+  // Create the release alloc map for a slab from its free bitmap. The slab
+  // stops being used for allocations.
+  //
   // @param slab    the slab to create a new release alloc map
   //
   // throw std::runtime_error if fail to create a new release alloc map
   void createSlabReleaseAllocMapLocked(const Slab* slab);
 
+  // Undo a slab release that has not completed. The allocations marked free
+  // in the release alloc map become available again and the slab goes back
+  // to the allocated slabs.
+  void restoreSlabFromReleaseLocked(const Slab* slab, SlabHeader* header);
+
   // @param slab    the slab associated with a release alloc map
   //
   // @return  std::vector<bool>&    this is the alloc state map
@@ -407,10 +420,71 @@ class AllocationClass {
   //          to this slab class to make further allocations out of it.
   void* allocateLocked();
 
+  // One bit per allocation in a slab, set if the allocation is free. Slabs
+  // that have at least one free allocation are tracked in partialSlabs_.
+  struct SlabFreeState {
+    explicit SlabFreeState(Slab* s, unsigned int allocsPerSlab)
+        : slab(s), bits((allocsPerSlab + kBitsPerWord - 1) / kBitsPerWord) {}
+
+    Slab* slab;
+    std::vector<uint64_t> bits;
+
+    // number of bits set
+    uint32_t numFree{0};
+
+    // lowest word that may have a bit set. Allocating the lowest free index
+    // first hands out adjacent allocations.
+    uint32_t firstWord{0};
+
+    // position in partialSlabs_ or kNotPartial
+    uint32_t partialIdx{kNotPartial};
+  };
+
+  static constexpr uint32_t kBitsPerWord = 64;
+  static constexpr uint32_t kNotPartial = std::numeric_limits<uint32_t>::max();
+
+  // number of partially free slabs to look at when picking the next one to
+  // allocate from
+  static constexpr unsigned int kPartialSlabCandidates = 8;
+
+  // @return  the free state of the slab, created if needed
+  SlabFreeState& getSlabFreeStateLocked(Slab* slab);
+
+  // mark the allocation at idx as free in the slab's bitmap.
+  //
+  // @throw std::invalid_argument on a double free
+  void markFreeLocked(SlabFreeState& state, size_t idx);
+
+  // returns an allocation from a partially free slab. Caller needs to ensure
+  // numFreeAllocs_ > 0.
+  void* allocateFromPartialSlabLocked() noexcept;
+
+  // pick the slab that the next allocations are served from. Slabs with fewer
+  // free allocations are preferred so that allocations pack into the same
+  // slabs and the others drain, making them cheap to release.
+  void pickAllocSlabLocked() noexcept;
+
+  void addPartialSlabLocked(SlabFreeState& state);
+  void removePartialSlabLocked(SlabFreeState& state);
+
+  // drop the free state of a slab that is leaving this allocation class.
+  //
+  // @return  the bitmap of free allocations in the slab
+  std::vector<uint64_t> removeSlabFreeStateLocked(const Slab* slab);
+
   // lock for serializing access to currSlab_, currOffset, allocatedSlabs_,
-  // freeSlabs_, freedAllocations_.
+  // freeSlabs_, slabFreeStates_, partialSlabs_.
   mutable folly::cacheline_aligned<folly::DistributedMutex> lock_;
 
+  // stats of the acquisitions of lock_, if profiled
+  LockStats* lockStats_{nullptr};
+
+  // Runs the function under lock_ with lock_combine()
+  template <typename F>
+  auto lockCombine(F&& f) const -> decltype(f()) {
+    return util::lockCombineProfiled(*lock_, lockStats_, std::forward<F>(f));
+  }
+
   // the allocation class id.
   const ClassId classId_{-1};
 
@@ -431,7 +505,7 @@ class AllocationClass {
   const SlabAllocator& slabAlloc_;
 
   // slabs that belong to this allocation class and are not entirely free. The
-  // un-used allocations in this are present in freedAllocations_.
+  // un-used allocations in this are tracked in slabFreeStates_.
   // TODO store the index of the slab instead of the actual pointer. Pointer
   // is 8byte vs index which can be half of it.
   std::vector<Slab*> allocatedSlabs_;
@@ -440,26 +514,30 @@ class AllocationClass {
   // TODO use an intrusive container on the freed slabs.
   std::vector<Slab*> freeSlabs_;
 
-  // void* is re-interpreted as FreeAlloc* before being stored in the free
-  // list.
+  // free allocations of the allocated slabs, keyed by slab. A slab gets an
+  // entry the first time one of its allocations is freed.
+  folly::F14NodeMap<const Slab*, SlabFreeState> slabFreeStates_;
+
+  // slabs with at least one free allocation, in no particular order.
+  std::vector<SlabFreeState*> partialSlabs_;
+
+  // the partially free slab we are currently allocating from.
+  SlabFreeState* allocSlab_{nullptr};
+
+  // total number of free allocations across slabFreeStates_.
+  size_t numFreeAllocs_{0};
+
+  // Free allocations are saved as an intrusive list threaded through their
+  // memory so that the serialized format does not depend on the in-memory
+  // bitmaps. void* is re-interpreted as FreeAlloc* before being stored in
+  // the list.
   struct CACHELIB_PACKED_ATTR FreeAlloc {
     using CompressedPtrType = facebook::cachelib::CompressedPtr4B;
     using PtrCompressor = facebook::cachelib::
         PtrCompressor<FreeAlloc, SlabAllocator, CompressedPtrType>;
     SListHook<FreeAlloc> hook_{};
   };
-
-  // list of freed allocations for this allocation class.
   using FreeList = SList<FreeAlloc, &FreeAlloc::hook_>;
-  FreeList freedAllocations_;
-
-  // Partition the 'freeAllocs' into two different SList depending on whether
-  // they are in slab memory or outside. Does not take a lock. If access to
-  // 'freeAllocs' requires a lock, it should be taken by the caller.
-  void partitionFreeAllocs(const Slab* slab,
-                           FreeList& freeAllocs,
-                           FreeList& inSlab,
-                           FreeList& notInSlab);
 
   // if this is false, then we have run out of memory to do any more
   // allocations. Reading this outside the lock_ will be racy.
@@ -477,14 +555,6 @@ class AllocationClass {
   // complete the slab release
   std::mutex startSlabReleaseLock_;
 
-  // maximum number of free allocs to walk through during pruning
-  // before dropping the lock
-  static constexpr unsigned int kFreeAllocsPruneLimit = 4 * 1024;
-
-  // Number of micro seconds to sleep between the batches during pruning.
-  // This is needed to avoid other threads from starving for lock.
-  static constexpr unsigned int kFreeAllocsPruneSleepMicroSecs = 1000;
-
   // Numer of allocations ahead to prefetch when iterating over each allocation
   // in a slab.
   static constexpr unsigned int kForEachAllocPrefetchOffset = 16;
@@ -378,6 +378,24 @@ class MemoryAllocator {
     return pool.reclaimSlabsAndGrow(numSlabs);
   }
 
+  // Records the acquisitions of the lock of an allocation class in the
+  // stats, see AllocationClass::setLockStats.
+  //
+  // @throw std::invalid_argument if the pool or class id is invalid.
+  void setLockStats(PoolId pid, ClassId cid, LockStats* stats) {
+    memoryPoolManager_.getPoolById(pid).setLockStats(cid, stats);
+  }
+
+  // Fault in all of the memory managed by this allocator in parallel. See
+  // SlabAllocator::prefaultMemory.
+  //
+  // @return the number of bytes that were faulted in
+  size_t prefaultMemory(
+      unsigned int numThreads,
+      const std::function<void(unsigned int)>& threadInit = {}) {
+    return slabAllocator_.prefaultMemory(numThreads, threadInit);
+  }
+
   // Number of slabs that are advised away and can be reclaimed.
   size_t numSlabsReclaimable() const noexcept {
     return slabAllocator_.numSlabsReclaimable();
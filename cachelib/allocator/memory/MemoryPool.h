@@ -283,6 +283,14 @@ class MemoryPool {
   // @throw std::invalid_argument if the ClassId is invalid.
   const AllocationClass& getAllocationClass(ClassId cid) const;
 
+  // Records the acquisitions of the lock of an allocation class in the
+  // stats, see AllocationClass::setLockStats.
+  //
+  // @throw std::invalid_argument if the ClassId is invalid.
+  void setLockStats(ClassId cid, LockStats* stats) {
+    getAllocationClassFor(cid).setLockStats(stats);
+  }
+
   // return the number of  allocation ClassIds for this pool based on the
   // allocation sizes that it was configured with. All allocations from this
   // pool will have ClassId from [0 .. numClassId - 1] (inclusive).
@@ -23,6 +23,7 @@
 #include <sys/mman.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <chrono>
 #include <memory>
 #include <stdexcept>
@@ -276,6 +277,48 @@ void SlabAllocator::lockMemoryAsync() noexcept {
   }
 }
 
+size_t SlabAllocator::prefaultMemory(
+    unsigned int numThreads,
+    const std::function<void(unsigned int)>& threadInit) {
+  // Header slabs are included so that the first lookup of a slab header does
+  // not take a fault either.
+  const size_t totalSlabs = memorySize_ / sizeof(Slab);
+  numThreads = static_cast<unsigned int>(
+      std::max<size_t>(1, std::min<size_t>(numThreads, totalSlabs)));
+  const size_t slabsPerThread = util::getDivCeiling(totalSlabs, numThreads);
+
+  std::atomic<size_t> bytesFaulted{0};
+  std::vector<std::thread> workers;
+  workers.reserve(numThreads);
+  for (unsigned int i = 0; i < numThreads; i++) {
+    const size_t begin = std::min(totalSlabs, i * slabsPerThread);
+    const size_t end = std::min(totalSlabs, (i + 1) * slabsPerThread);
+    workers.emplace_back([this, i, begin, end, &threadInit, &bytesFaulted]() {
+      if (threadInit) {
+        threadInit(i);
+      }
+      auto* slabs = reinterpret_cast<Slab*>(memoryStart_);
+      size_t faulted = 0;
+      for (size_t idx = begin; idx < end; idx++) {
+        // Avoid touching advised away slabs so that we don't undo the work
+        // of the memory monitor.
+        const auto header = getSlabHeader(&slabs[idx]);
+        if (header && header->isAdvised()) {
+          continue;
+        }
+        util::prefaultMemory(&slabs[idx], sizeof(Slab));
+        faulted += sizeof(Slab);
+      }
+      bytesFaulted += faulted;
+    });
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  return bytesFaulted;
+}
+
 namespace {
 unsigned int numSlabs(size_t memorySize) noexcept {
   return static_cast<unsigned int>(memorySize / sizeof(Slab));
@@ -19,6 +19,7 @@
 #include <sys/mman.h>
 
 #include <atomic>
+#include <functional>
 #include <mutex>
 #include <thread>
 #include <unordered_map>
@@ -149,6 +150,21 @@ class SlabAllocator {
   // madvised away for the given pool.
   Slab* reclaimSlab(PoolId id);
 
+  // Synchronously fault in all of the slab memory, including the slab
+  // headers, using numThreads threads. Slabs that are advised away are left
+  // untouched. Unlike lockMemory, this blocks the caller until the memory is
+  // resident so that the first allocations out of each slab do not pay for
+  // page faults.
+  //
+  // @param numThreads  number of threads to spread the page faults over
+  // @param threadInit  optional callback invoked on each worker with its
+  //                    index before it starts faulting
+  //
+  // @return the number of bytes that were faulted in
+  size_t prefaultMemory(
+      unsigned int numThreads,
+      const std::function<void(unsigned int)>& threadInit = {});
+
   // Number of advised away slabs that can be reclaimed by calling reclaimSlab()
   size_t numSlabsReclaimable() const noexcept {
     LockHolder l(lock_);
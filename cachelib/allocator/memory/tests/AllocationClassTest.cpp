@@ -632,14 +632,15 @@ TEST_F(AllocationClassTest, ReleaseSlabWithActiveAllocations) {
 
 // 1. Add two slabs to the AC
 // 2. Allocate until full for each slab
-// 3. Free 2 * kFreeAllocsPruneLimit from each slab
+// 3. Free 2 * kNumFrees from each slab
 // 4. Asynchronously free 500 allocs from first slab
 // 5. Release slab and check the active allocations are
 //    GREATER or EQUAL to
-//    (total allocs - 2 * kFreeAllocsPruneLimit - 500)
+//    (total allocs - 2 * kNumFrees - 500)
 // 6. Verify the source of truth "slabReleaseAllocMap" that the freed allocs
-//    are indeed 2 * kFreeAllocsPruneLimit + 500
+//    are indeed 2 * kNumFrees + 500
 TEST_F(AllocationClassTest, ReleaseSlabMultithread) {
+  constexpr unsigned int kNumFrees = 4 * 1024;
   // allocate one slab. allocate some memory and release the slab.
   // we should get back a list of memory allocs that have been
   // previously allocated.
@@ -687,14 +688,11 @@ TEST_F(AllocationClassTest, ReleaseSlabMultithread) {
     secondSlabAllocations.push_back(alloc);
   }
 
-  // release 4 * kPruneFreeAllocsLimit
+  // release 4 * kNumFrees
   // 2 from each slab.
-  ASSERT_LT(4 * AllocationClass::kFreeAllocsPruneLimit,
-            firstSlabAllocations.size());
-  ASSERT_LT(4 * AllocationClass::kFreeAllocsPruneLimit,
-            secondSlabAllocations.size());
-  for (unsigned int i = 0; i < 4 * AllocationClass::kFreeAllocsPruneLimit;
-       ++i) {
+  ASSERT_LT(4 * kNumFrees, firstSlabAllocations.size());
+  ASSERT_LT(4 * kNumFrees, secondSlabAllocations.size());
+  for (unsigned int i = 0; i < 4 * kNumFrees; ++i) {
     bool freeFirstSlab = i % 2;
     auto alloc = freeFirstSlab ? firstSlabAllocations.back()
                                : secondSlabAllocations.back();
@@ -720,7 +718,7 @@ TEST_F(AllocationClassTest, ReleaseSlabMultithread) {
   // release first slab, we once `freeThread` is done, we should
   // see the number of active allocations is greater or equal to
   // the number of total allocations per slab
-  // minus (2 * kPruneFreeAllocsLimit + 50)
+  // minus (2 * kNumFrees + 500)
   //
   // But the alloc state should match exactly the number of allocs freed
   auto firstSlabReleaseContext = ac.startSlabRelease(
@@ -731,9 +729,8 @@ TEST_F(AllocationClassTest, ReleaseSlabMultithread) {
   ASSERT_FALSE(firstSlabReleaseContext.isReleased());
   const auto& firstSlabActiveAllocs =
       firstSlabReleaseContext.getActiveAllocations();
-  ASSERT_LE(
-      ac.getAllocsPerSlab() - 2 * AllocationClass::kFreeAllocsPruneLimit - 500,
-      firstSlabActiveAllocs.size());
+  ASSERT_LE(ac.getAllocsPerSlab() - 2 * kNumFrees - 500,
+            firstSlabActiveAllocs.size());
   ASSERT_LE(firstSlabAllocations.size(), firstSlabActiveAllocs.size());
 
   auto& allocState = ac.getSlabReleaseAllocMapLocked(firstSlab);
@@ -743,7 +740,7 @@ TEST_F(AllocationClassTest, ReleaseSlabMultithread) {
       ++freedAllocs;
     }
   }
-  ASSERT_EQ(2 * AllocationClass::kFreeAllocsPruneLimit + 500, freedAllocs);
+  ASSERT_EQ(2 * kNumFrees + 500, freedAllocs);
 }
 
 // 1. allocate 10 slabs
@@ -1294,11 +1291,67 @@ TEST_F(AllocationClassTest, RestoreFreedAllocations) {
   // no further allocations should be possible.
   ASSERT_EQ(ac.allocate(), nullptr);
 
-  // The intrusive list contains freed allocations in the reverse order.
-  reverse(newAllocations.begin(), newAllocations.end());
+  // Freed allocations are handed out lowest address first.
   ASSERT_EQ(newAllocations, freedAllocations);
 }
 
+// Freed allocations are reused from the fullest slab first, in address order,
+// and slab release picks the slab with the most free allocations.
+TEST_F(AllocationClassTest, FreeAllocLocality) {
+  auto slabAlloc = createSlabAllocator(10);
+  const PoolId pid = 0;
+  const ClassId cid = 0;
+  const auto allocSize = 1 << 10;
+  AllocationClass ac(cid, pid, allocSize, *slabAlloc);
+
+  auto slab1 = slabAlloc->makeNewSlab(pid);
+  auto slab2 = slabAlloc->makeNewSlab(pid);
+  ac.addSlab(slab1);
+  ac.addSlab(slab2);
+
+  std::vector<void*> allocations;
+  while (auto alloc = ac.allocate()) {
+    allocations.push_back(alloc);
+  }
+  ASSERT_EQ(2 * ac.getAllocsPerSlab(), allocations.size());
+
+  // free most of one slab and a few scattered allocations of the other.
+  std::vector<void*> freedMostly;
+  std::vector<void*> freedFew;
+  for (auto alloc : allocations) {
+    const auto idx =
+        (reinterpret_cast<uintptr_t>(alloc) & (Slab::kSize - 1)) / allocSize;
+    if (slabAlloc->getSlabForMemory(alloc) == slab1) {
+      if (idx % 2 == 0) {
+        ac.free(alloc);
+        freedMostly.push_back(alloc);
+      }
+    } else if (idx % 512 == 7) {
+      ac.free(alloc);
+      freedFew.push_back(alloc);
+    }
+  }
+  std::sort(freedFew.begin(), freedFew.end());
+
+  // double free is caught
+  ASSERT_THROW(ac.free(freedFew[0]), std::invalid_argument);
+
+  // the fuller slab is drained first, lowest address first
+  for (auto expected : freedFew) {
+    ASSERT_EQ(expected, ac.allocate());
+  }
+  ASSERT_EQ(freedMostly.size(), ac.getStats().freeAllocs);
+
+  // releasing without a hint picks the slab with the fewest live allocations
+  auto context = ac.startSlabRelease(SlabReleaseMode::kRebalance, nullptr);
+  ASSERT_EQ(slab1, context.getSlab());
+  ASSERT_EQ(ac.getAllocsPerSlab() - freedMostly.size(),
+            context.getActiveAllocations().size());
+  ASSERT_EQ(0, ac.getStats().freeAllocs);
+  ac.abortSlabRelease(context);
+  ASSERT_EQ(freedMostly.size(), ac.getStats().freeAllocs);
+}
+
 TEST_F(AllocationClassTest, forEachAllocationBasicSmallAlloc) {
   // create a dummy allocator to instantiate the AllocationClass.
   const auto slabAlloc = createSlabAllocator(1);
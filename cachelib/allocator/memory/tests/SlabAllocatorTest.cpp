@@ -533,6 +533,43 @@ TEST_F(SlabAllocatorTest, LockMemory) {
   }
 }
 
+TEST_F(SlabAllocatorTest, PrefaultMemory) {
+  const size_t numSlabs = 20;
+  const size_t numAdviseSlabs = 5;
+  const size_t size = numSlabs * Slab::kSize;
+  size_t allocSize = size + sizeof(Slab);
+
+  void* memory = mmap(nullptr, allocSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(memory, MAP_FAILED);
+  void* alignedMem = util::align(sizeof(Slab), size, memory, allocSize);
+  ASSERT_TRUE(util::isPageAlignedAddr(alignedMem));
+  SCOPE_EXIT { munmap(memory, allocSize); };
+
+  SlabAllocator s(alignedMem, size, getDefaultConfig());
+  ASSERT_EQ(0, util::getNumResidentPages(alignedMem, size));
+
+  // advise away a few slabs. they must not be paged back in.
+  std::vector<Slab*> advised;
+  for (size_t i = 0; i < numAdviseSlabs; i++) {
+    auto slab = s.makeNewSlab(0);
+    ASSERT_NE(nullptr, slab);
+    ASSERT_TRUE(s.adviseSlab(slab));
+    advised.push_back(slab);
+  }
+
+  std::atomic<unsigned int> numWorkers{0};
+  const size_t bytes = s.prefaultMemory(
+      4, [&numWorkers](unsigned int) { ++numWorkers; });
+  ASSERT_EQ(4, numWorkers);
+  ASSERT_EQ(size - numAdviseSlabs * Slab::kSize, bytes);
+  ASSERT_EQ(util::getNumPages(bytes),
+            util::getNumResidentPages(alignedMem, size));
+  for (auto slab : advised) {
+    ASSERT_EQ(0, util::getNumResidentPages(slab, Slab::kSize));
+  }
+}
+
 // ensure that we can call save state and have the memory locker thread
 // be shut down appropriately.
 TEST_F(SlabAllocatorTest, LockMemorySaveState) {
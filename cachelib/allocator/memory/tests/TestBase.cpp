@@ -58,7 +58,29 @@ bool AllocTestBase::isSameAllocationClass(const AllocationClass& ac1,
                         ac2.allocatedSlabs_, ac2.slabAlloc_) &&
          isSameSlabList(ac1.freeSlabs_, ac1.slabAlloc_, ac2.freeSlabs_,
                         ac2.slabAlloc_) &&
-         ac1.freedAllocations_ == ac2.freedAllocations_;
+         isSameFreeAllocs(ac1, ac2);
+}
+
+/* static */
+bool AllocTestBase::isSameFreeAllocs(const AllocationClass& ac1,
+                                     const AllocationClass& ac2) {
+  if (ac1.numFreeAllocs_ != ac2.numFreeAllocs_) {
+    return false;
+  }
+  // slabs without any free allocation may or may not have a free state
+  for (const auto& kv : ac1.slabFreeStates_) {
+    const auto& state1 = kv.second;
+    if (state1.numFree == 0) {
+      continue;
+    }
+    const auto* slab2 =
+        ac2.slabAlloc_.getSlabForIdx(ac1.slabAlloc_.slabIdx(state1.slab));
+    const auto it = ac2.slabFreeStates_.find(slab2);
+    if (it == ac2.slabFreeStates_.end() || it->second.bits != state1.bits) {
+      return false;
+    }
+  }
+  return true;
 }
 
 /* static */
@@ -102,6 +102,9 @@ class AllocTestBase : public testing::Test {
   static bool isSameAllocationClass(const AllocationClass& ac1,
                                     const AllocationClass& ac2);
 
+  static bool isSameFreeAllocs(const AllocationClass& ac1,
+                               const AllocationClass& ac2);
+
   static bool isSameMemoryPool(const MemoryPool& mp1, const MemoryPool& mp2);
 
   static bool isSameMemoryPoolManager(const MemoryPoolManager& m1,
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "cachelib/allocator/nvmcache/AsyncPutPool.h"
+
+#include <folly/Format.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+
+#include <stdexcept>
+
+namespace facebook {
+namespace cachelib {
+
+AsyncPutPool::AsyncPutPool(uint32_t numThreads, uint32_t queueSize)
+    : queue_(queueSize == 0 ? 1 : queueSize) {
+  if (numThreads == 0 || queueSize == 0) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid async put pool, threads: {}, queue size: {}", numThreads,
+        queueSize));
+  }
+  threads_.reserve(numThreads);
+  for (uint32_t i = 0; i < numThreads; i++) {
+    threads_.emplace_back([this, i]() {
+      folly::setThreadName(folly::sformat("nvm_put_{}", i));
+      run();
+    });
+  }
+}
+
+AsyncPutPool::~AsyncPutPool() {
+  // the stop tasks queue behind the pending ones
+  for (size_t i = 0; i < threads_.size(); i++) {
+    queue_.blockingWrite(nullptr);
+  }
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+bool AsyncPutPool::tryAdd(Task task) {
+  numPending_.fetch_add(1, std::memory_order_relaxed);
+  if (queue_.write(std::move(task))) {
+    return true;
+  }
+  onTaskDone();
+  return false;
+}
+
+void AsyncPutPool::drain() {
+  std::unique_lock<std::mutex> l{drainMutex_};
+  drained_.wait(l, [this]() { return numPending_.load() == 0; });
+}
+
+uint64_t AsyncPutPool::getNumPending() const { return numPending_.load(); }
+
+void AsyncPutPool::run() {
+  while (true) {
+    Task task;
+    queue_.blockingRead(task);
+    if (!task) {
+      return;
+    }
+    try {
+      task();
+    } catch (const std::exception& e) {
+      XLOG_EVERY_N(ERR, 100) << "Async nvm put failed: " << e.what();
+    }
+    // release what the task holds before it counts as done
+    task = nullptr;
+    onTaskDone();
+  }
+}
+
+void AsyncPutPool::onTaskDone() {
+  if (numPending_.fetch_sub(1) == 1) {
+    // taking the lock orders the notification after a drain() that checked
+    // the count and is about to wait
+    std::lock_guard<std::mutex> l{drainMutex_};
+    drained_.notify_all();
+  }
+}
+
+} // namespace cachelib
+} // namespace facebook
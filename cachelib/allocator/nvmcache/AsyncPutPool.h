@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <folly/Function.h>
+#include <folly/MPMCQueue.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace facebook {
+namespace cachelib {
+
+// A small thread pool with a bounded queue that NvmCache uses to encode and
+// submit puts off the eviction path. Adding a task never blocks: when the
+// queue is full the task is rejected and the caller drops the put.
+class AsyncPutPool {
+ public:
+  using Task = folly::Function<void()>;
+
+  // @param numThreads  threads running the tasks
+  // @param queueSize   max number of tasks waiting for a thread
+  //
+  // @throw std::invalid_argument if either is 0
+  AsyncPutPool(uint32_t numThreads, uint32_t queueSize);
+
+  AsyncPutPool(const AsyncPutPool&) = delete;
+  AsyncPutPool& operator=(const AsyncPutPool&) = delete;
+
+  // Runs the tasks still queued and stops the threads.
+  ~AsyncPutPool();
+
+  // @return false if the queue is full. The task is not run then.
+  bool tryAdd(Task task);
+
+  // Blocks until all the tasks added so far have run.
+  void drain();
+
+  // @return number of tasks added and not done yet
+  uint64_t getNumPending() const;
+
+ private:
+  void run();
+
+  void onTaskDone();
+
+  // null tasks stop the threads
+  folly::MPMCQueue<Task> queue_;
+  std::vector<std::thread> threads_;
+
+  std::atomic<uint64_t> numPending_{0};
+
+  // wakes up drain() once there is nothing pending
+  std::mutex drainMutex_;
+  std::condition_variable drained_;
+};
+
+} // namespace cachelib
+} // namespace facebook
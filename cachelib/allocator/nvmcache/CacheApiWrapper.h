@@ -18,6 +18,8 @@
 
 #include <folly/Range.h>
 
+#include "cachelib/common/LockProfiler.h"
+
 namespace facebook {
 namespace cachelib {
 
@@ -140,6 +142,10 @@ class CacheAPIWrapperForNvm {
   static EventTracker* getEventTracker(C& cache) {
     return cache.getEventTracker();
   }
+
+  static LockProfiler* getLockProfiler(C& cache) {
+    return cache.getLockProfiler();
+  }
 };
 
 } // namespace cachelib
@@ -116,6 +116,20 @@ class alignas(folly::hardware_destructive_interference_size) InFlightPuts {
     // reflect if the token was invalidated after construction.
     bool isValid() const noexcept { return puts_ != nullptr; }
 
+    // Points the token at another copy of its key, so that it can outlive
+    // the memory of the key it was acquired with. The validity of the token
+    // is preserved.
+    //
+    // @param key   the same key, in memory owned by the caller for the
+    //              lifetime of the token
+    void rebindKey(folly::StringPiece key) {
+      XDCHECK_EQ(key_, key);
+      if (isValid()) {
+        puts_->rebindKey(key_, key);
+        key_ = key;
+      }
+    }
+
     // executes the fn if the token is valid and the there has been no
     // invalidation. destroys the token state accordingly.
     template <typename F>
@@ -168,6 +182,16 @@ class alignas(folly::hardware_destructive_interference_size) InFlightPuts {
     return false;
   }
 
+  // re-inserts the record of the key under a different copy of it
+  void rebindKey(folly::StringPiece oldKey, folly::StringPiece newKey) {
+    LockGuard l(mutex_);
+    auto it = keys_.find(oldKey);
+    XDCHECK(it != keys_.end());
+    const bool valid = it->second;
+    keys_.erase(it);
+    keys_.emplace(newKey, valid);
+  }
+
   // erases the record from inflight map.
   void removeToken(folly::StringPiece key) {
     LockGuard l(mutex_);
@@ -20,6 +20,8 @@
 #include <string>
 #include <vector>
 
+#include "cachelib/navy/common/SimulatedDevice.h"
+
 namespace facebook {
 namespace cachelib {
 namespace navy {
@@ -85,6 +87,16 @@ void NavyConfig::setSimpleFile(const std::string& fileName,
   truncateFile_ = truncateFile;
 }
 
+void NavyConfig::setSimulatedDevice(uint64_t fileSize,
+                                    const SimulatedDeviceConfig& config) {
+  if (usesSimpleFile() || usesRaidFiles()) {
+    throw std::invalid_argument("already set a simple file or RAID files");
+  }
+  simulatedDevice_ =
+      std::make_shared<const SimulatedDeviceConfig>(config.validate());
+  fileSize_ = fileSize;
+}
+
 void NavyConfig::setRaidFiles(std::vector<std::string> raidPaths,
                               uint64_t fileSize,
                               bool truncateFile) {
@@ -126,6 +138,14 @@ BlockCacheConfig& BlockCacheConfig::enableCustomReinsertion(
   return *this;
 }
 
+BlockCacheConfig& BlockCacheConfig::enablePromotion(uint8_t hitsThreshold,
+                                                    uint64_t maxBytesPerSec,
+                                                    bool reinsertPromoted) {
+  reinsertionConfig_.enablePromotion(hitsThreshold, maxBytesPerSec,
+                                     reinsertPromoted);
+  return *this;
+}
+
 BlockCacheConfig& BlockCacheConfig::setCleanRegions(
     uint32_t cleanRegions, uint32_t cleanRegionThreads) {
   if (!cleanRegionThreads || cleanRegionThreads > cleanRegions + 1) {
@@ -144,6 +164,21 @@ BlockCacheConfig& BlockCacheConfig::setCleanRegions(
   return *this;
 }
 
+BlockCacheConfig& BlockCacheConfig::enableFlashIndex(
+    uint64_t dramBudget, unsigned int flashSizePct) {
+  if (dramBudget == 0) {
+    throw std::invalid_argument("index DRAM budget should be > 0");
+  }
+  if (flashSizePct == 0 || flashSizePct > 50) {
+    throw std::invalid_argument(folly::sformat(
+        "index flash size pct should be in the range of [1, 50], but {} is set",
+        flashSizePct));
+  }
+  indexDramBudget_ = dramBudget;
+  indexFlashSizePct_ = flashSizePct;
+  return *this;
+}
+
 // BigHash settings
 BigHashConfig& BigHashConfig::setSizePctAndMaxItemSize(
     unsigned int sizePct, uint64_t smallItemMaxSize) {
@@ -223,6 +258,8 @@ std::map<std::string, std::string> EnginesConfig::serialize() const {
   // BlockCache settings
   configMap["navyConfig::blockCacheLru"] =
       blockCache().isLruEnabled() ? "true" : "false";
+  configMap["navyConfig::blockCacheClock"] =
+      blockCache().isClockEnabled() ? "true" : "false";
   configMap["navyConfig::blockCacheRegionSize"] =
       folly::to<std::string>(blockCache().getRegionSize());
   configMap["navyConfig::blockCacheCleanRegions"] =
@@ -235,12 +272,25 @@ std::map<std::string, std::string> EnginesConfig::serialize() const {
   configMap["navyConfig::blockCacheReinsertionPctThreshold"] =
       folly::to<std::string>(
           blockCache().getReinsertionConfig().getPctThreshold());
+  configMap["navyConfig::blockCachePromotionHitsThreshold"] =
+      folly::to<std::string>(
+          blockCache().getReinsertionConfig().getPromotionHitsThreshold());
+  configMap["navyConfig::blockCachePromotionMaxBytesPerSec"] =
+      folly::to<std::string>(
+          blockCache().getReinsertionConfig().getPromotionMaxBytesPerSec());
+  configMap["navyConfig::blockCacheReinsertPromoted"] =
+      blockCache().getReinsertionConfig().getReinsertPromoted() ? "true"
+                                                                : "false";
   configMap["navyConfig::blockCacheNumInMemBuffers"] =
       folly::to<std::string>(blockCache().getNumInMemBuffers());
   configMap["navyConfig::blockCacheDataChecksum"] =
       blockCache().getDataChecksum() ? "true" : "false";
   configMap["navyConfig::blockCacheSegmentedFifoSegmentRatio"] =
       folly::join(",", blockCache().getSFifoSegmentRatio());
+  configMap["navyConfig::blockCacheIndexDramBudget"] =
+      folly::to<std::string>(blockCache().getIndexDramBudget());
+  configMap["navyConfig::blockCacheIndexFlashSizePct"] =
+      folly::to<std::string>(blockCache().getIndexFlashSizePct());
 
   // BigHash settings
   configMap["navyConfig::bigHashSizePct"] =
@@ -287,6 +337,14 @@ std::map<std::string, std::string> NavyConfig::serialize() const {
   configMap["navyConfig::ioEngine"] = getIoEngineName(ioEngine_).str();
   configMap["navyConfig::QDepth"] = folly::to<std::string>(qDepth_);
   configMap["navyConfig::enableFDP"] = folly::to<std::string>(enableFDP_);
+  configMap["navyConfig::enableDiscard"] =
+      folly::to<std::string>(enableDiscard_);
+  configMap["navyConfig::maxDiscardBytesPerSec"] =
+      folly::to<std::string>(maxDiscardBytesPerSec_);
+  configMap["navyConfig::sparseMemoryFile"] =
+      folly::to<std::string>(sparseMemoryFile_);
+  configMap["navyConfig::simulatedDevice"] =
+      simulatedDevice_ ? simulatedDevice_->toString() : "";
 
   // Job scheduler settings
   configMap["navyConfig::readerThreads"] =
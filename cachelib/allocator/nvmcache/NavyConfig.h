@@ -19,6 +19,7 @@
 #include <folly/json/dynamic.h>
 #include <folly/logging/xlog.h>
 
+#include <memory>
 #include <stdexcept>
 
 #include "cachelib/allocator/nvmcache/BlockCacheReinsertionPolicy.h"
@@ -29,6 +30,7 @@ namespace cachelib {
 namespace navy {
 
 class Index;
+struct SimulatedDeviceConfig;
 
 /**
  * RandomAPConfig provides APIs for users to configure one of the admission
@@ -156,6 +158,7 @@ class DynamicRandomAPConfig {
  *
  * By this class, user can:
  * - enable hits-based OR probability based reinsertion policy (but not both)
+ * - promote hot items to the DRAM cache when their region is reclaimed
  */
 class BlockCacheReinsertionConfig {
  public:
@@ -211,10 +214,40 @@ class BlockCacheReinsertionConfig {
     return *this;
   }
 
+  // Promote the items accessed at least hitsThreshold times since they were
+  // written to BlockCache to the DRAM cache, when their region is reclaimed.
+  // A promoted item is removed from flash unless reinsertPromoted is set, in
+  // which case the reinsertion policy still decides whether to keep a copy.
+  // Items that the DRAM cache does not take are handled by the reinsertion
+  // policy as usual. The DRAM allocations, and the evictions, remove
+  // callbacks and item destructors they trigger, run on the reclaim thread.
+  // @param maxBytesPerSec  rate limit of the promotions, 0 for no limit
+  // @throw std::invalid_argument if hitsThreshold is 0
+  BlockCacheReinsertionConfig& enablePromotion(uint8_t hitsThreshold,
+                                               uint64_t maxBytesPerSec = 0,
+                                               bool reinsertPromoted = false) {
+    if (hitsThreshold == 0) {
+      throw std::invalid_argument(
+          "promotion hits threshold should be greater than 0");
+    }
+    promotionHitsThreshold_ = hitsThreshold;
+    promotionMaxBytesPerSec_ = maxBytesPerSec;
+    reinsertPromoted_ = reinsertPromoted;
+    return *this;
+  }
+
   uint8_t getHitsThreshold() const { return hitsThreshold_; }
 
   unsigned int getPctThreshold() const { return pctThreshold_; }
 
+  uint8_t getPromotionHitsThreshold() const { return promotionHitsThreshold_; }
+
+  uint64_t getPromotionMaxBytesPerSec() const {
+    return promotionMaxBytesPerSec_;
+  }
+
+  bool getReinsertPromoted() const { return reinsertPromoted_; }
+
   std::shared_ptr<BlockCacheReinsertionPolicy> getCustomPolicy(
       const Index& index) const {
     ensureCustomPolicy(index);
@@ -237,6 +270,12 @@ class BlockCacheReinsertionConfig {
       makeCustomPolicy_{nullptr};
   std::shared_ptr<BlockCacheReinsertionPolicy> createdCustomPolicy_{nullptr};
 
+  // Promotion to DRAM, independent of the reinsertion policy. Disabled if
+  // the threshold is 0.
+  uint8_t promotionHitsThreshold_{0};
+  uint64_t promotionMaxBytesPerSec_{0};
+  bool reinsertPromoted_{false};
+
   void ensureCustomPolicy(const Index& index) const {
     if (!createdCustomPolicy_ && makeCustomPolicy_) {
       const_cast<BlockCacheReinsertionConfig*>(this)->createdCustomPolicy_ =
@@ -250,12 +289,13 @@ class BlockCacheReinsertionConfig {
  * which is one part of NavyConfig.
  *
  * By this class, users can:
- * - enable FIFO or segmented FIFO eviction policy (default is LRU)
+ * - enable CLOCK, FIFO or segmented FIFO eviction policy (default is LRU)
  * - set number of clean regions
  * - enable in-mem buffer (once enabled, the number is 2 * clean regions)
  * - set size classes
  * - set region size
  * - set data checksum
+ * - keep the cold part of the index on flash
  * - get the values of all the above parameters
  */
 class BlockCacheConfig {
@@ -263,6 +303,17 @@ class BlockCacheConfig {
   // Enable FIFO eviction policy (LRU will be disabled).
   BlockCacheConfig& enableFifo() noexcept {
     lru_ = false;
+    clock_ = false;
+    return *this;
+  }
+
+  // Enable CLOCK eviction policy (LRU will be disabled). CLOCK approximates
+  // LRU but records region hits without taking a lock, which scales better
+  // with many reader threads.
+  BlockCacheConfig& enableClock() noexcept {
+    sFifoSegmentRatio_.clear();
+    lru_ = false;
+    clock_ = true;
     return *this;
   }
 
@@ -277,6 +328,7 @@ class BlockCacheConfig {
       std::vector<unsigned int> sFifoSegmentRatio) noexcept {
     sFifoSegmentRatio_ = std::move(sFifoSegmentRatio);
     lru_ = false;
+    clock_ = false;
     return *this;
   }
 
@@ -309,6 +361,13 @@ class BlockCacheConfig {
       std::function<std::shared_ptr<BlockCacheReinsertionPolicy>(const Index&)>
           makeCustomPolicy);
 
+  // Enable the promotion of hot items to the DRAM cache on region reclaim.
+  // See BlockCacheReinsertionConfig::enablePromotion.
+  // @throw std::invalid_argument if hitsThreshold is 0
+  BlockCacheConfig& enablePromotion(uint8_t hitsThreshold,
+                                    uint64_t maxBytesPerSec = 0,
+                                    bool reinsertPromoted = false);
+
   // Set number of clean regions that are maintained for incoming write and
   // whether the writes are buffered in-memory.
   // Navy needs to maintain sufficient buffers for each clean region that is
@@ -337,8 +396,23 @@ class BlockCacheConfig {
     return *this;
   }
 
+  // Limit the DRAM used by the BlockCache index. Once the index exceeds
+  // @dramBudget bytes, its least recently used partitions are written to a
+  // reserved part of the block cache space and looking them up costs one
+  // extra small read.
+  // @param dramBudget    DRAM budget of the index in bytes
+  // @param flashSizePct  percentage of the block cache space reserved for
+  //                      the index, in the range of [1, 50]. The index takes
+  //                      roughly 12 bytes per item on flash.
+  // @throw std::invalid_argument if @dramBudget is 0 or @flashSizePct is out
+  //        of range.
+  BlockCacheConfig& enableFlashIndex(uint64_t dramBudget,
+                                     unsigned int flashSizePct = 2);
+
   bool isLruEnabled() const { return lru_; }
 
+  bool isClockEnabled() const { return clock_; }
+
   const std::vector<unsigned int>& getSFifoSegmentRatio() const {
     return sFifoSegmentRatio_;
   }
@@ -361,9 +435,17 @@ class BlockCacheConfig {
 
   bool isPreciseRemove() const { return preciseRemove_; }
 
+  bool isFlashIndexEnabled() const { return indexFlashSizePct_ > 0; }
+
+  uint64_t getIndexDramBudget() const { return indexDramBudget_; }
+
+  unsigned int getIndexFlashSizePct() const { return indexFlashSizePct_; }
+
  private:
   // Whether Navy BlockCache will use region-based LRU eviction policy.
   bool lru_{true};
+  // Whether Navy BlockCache will use region-based CLOCK eviction policy.
+  bool clock_{false};
   // The ratio of segments for segmented FIFO eviction policy.
   // Once segmented FIFO is enabled, lru_ will be false.
   std::vector<unsigned int> sFifoSegmentRatio_;
@@ -385,6 +467,10 @@ class BlockCacheConfig {
   // Whether to remove an item by checking the key (true) or only the hash value
   // (false).
   bool preciseRemove_{false};
+  // DRAM budget of the index and the percentage of the block cache space
+  // for the index pages. The whole index is in DRAM if the percentage is 0.
+  uint64_t indexDramBudget_{0};
+  unsigned int indexFlashSizePct_{0};
 
   // Intended size of the block cache.
   // If 0, this block cache takes all the space left on the device.
@@ -519,10 +605,12 @@ class NavyConfig {
 
   bool usesSimpleFile() const noexcept { return !fileName_.empty(); }
   bool usesRaidFiles() const noexcept { return raidPaths_.size() > 0; }
+  bool usesSparseMemoryFile() const noexcept { return sparseMemoryFile_; }
   bool isBigHashEnabled() const {
     return enginesConfigs_[0].bigHash().getSizePct() > 0;
   }
   bool isFDPEnabled() const { return enableFDP_; }
+  bool isDiscardEnabled() const { return enableDiscard_; }
 
   std::map<std::string, std::string> serialize() const;
 
@@ -547,9 +635,14 @@ class NavyConfig {
   uint64_t getFileSize() const { return fileSize_; }
   bool getTruncateFile() const { return truncateFile_; }
   uint32_t getDeviceMaxWriteSize() const { return deviceMaxWriteSize_; }
+  uint64_t getMaxDiscardBytesPerSec() const { return maxDiscardBytesPerSec_; }
   IoEngine getIoEngine() const { return ioEngine_; }
   unsigned int getQDepth() const { return qDepth_; }
   BadDeviceStatus hasBadDeviceForTesting() const { return testingBadDevice_; }
+  // nullptr unless the in-memory file simulates an SSD
+  const SimulatedDeviceConfig* getSimulatedDevice() const {
+    return simulatedDevice_.get();
+  }
 
   // Return a const BlockCacheConfig to read values of its parameters.
   const BigHashConfig& bigHash() const {
@@ -612,6 +705,20 @@ class NavyConfig {
   // This function is only for cachebench and unit tests to create
   // a MemoryDevice when no file path is set.
   void setMemoryFile(uint64_t fileSize) noexcept { fileSize_ = fileSize; }
+  // Set the parameter for an in-memory file that only stores the pages that
+  // are not all zeros. This is for cachebench simulations that do not
+  // populate the item values.
+  void setSparseMemoryFile(uint64_t fileSize) noexcept {
+    fileSize_ = fileSize;
+    sparseMemoryFile_ = true;
+  }
+  // Set the parameters for an in-memory file with the latencies, parallelism
+  // and garbage collection of an SSD (see navy/common/SimulatedDevice.h).
+  // This is for cachebench and unit tests to approximate a real device.
+  // @throw std::invalid_argument if a simple file or RAID files have been
+  //        already set, or the config is invalid.
+  void setSimulatedDevice(uint64_t fileSize,
+                          const SimulatedDeviceConfig& config);
   // Set up a bad device backed by the existing device that user has configured.
   // This requires the user to have also set up a real device (one of the
   // above).
@@ -631,6 +738,17 @@ class NavyConfig {
   void setDeviceMaxWriteSize(uint32_t deviceMaxWriteSize) noexcept {
     deviceMaxWriteSize_ = deviceMaxWriteSize;
   }
+  // Discard (TRIM) the device ranges of reclaimed BlockCache regions and of
+  // both engines on reset, so that the SSD does not garbage collect stale
+  // data. Regular files get holes punched instead.
+  // @param maxDiscardBytesPerSec  rate limit for the discards of reclaimed
+  //                               regions. 0 means no limit. A rate below
+  //                               the region size discards a region every
+  //                               few seconds.
+  void enableDiscard(uint64_t maxDiscardBytesPerSec = 0) noexcept {
+    enableDiscard_ = true;
+    maxDiscardBytesPerSec_ = maxDiscardBytesPerSec;
+  }
 
   // Enable AsyncIo
   // If enabled already via job config settings, this will override
@@ -714,6 +832,10 @@ class NavyConfig {
   uint32_t deviceMaxWriteSize_{};
   // This controls if device is in bad status (for testing).
   BadDeviceStatus testingBadDevice_{BadDeviceStatus::None};
+  // Whether the in-memory file only stores the pages that are not all zeros.
+  bool sparseMemoryFile_{false};
+  // Performance model of the in-memory file, if it simulates an SSD.
+  std::shared_ptr<const SimulatedDeviceConfig> simulatedDevice_;
 
   // IoEngine type used for IO
   IoEngine ioEngine_{IoEngine::Sync};
@@ -762,6 +884,10 @@ class NavyConfig {
   // Whether Navy support the NVMe FDP data placement(TP4146) directives or not.
   // Reference: https://nvmexpress.org/nvmeflexible-data-placement-fdp-blog/
   bool enableFDP_{false};
+  // Whether to discard the device ranges that the engines no longer use and
+  // the rate limit for discarding reclaimed regions.
+  bool enableDiscard_{false};
+  uint64_t maxDiscardBytesPerSec_{0};
 };
 } // namespace navy
 } // namespace cachelib
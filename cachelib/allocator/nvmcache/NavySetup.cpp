@@ -21,6 +21,7 @@
 
 #include "cachelib/allocator/nvmcache/NavyConfig.h"
 #include "cachelib/navy/Factory.h"
+#include "cachelib/navy/common/SimulatedDevice.h"
 #include "cachelib/navy/scheduler/JobScheduler.h"
 #include "cachelib/navy/testing/MockDevice.h"
 
@@ -124,6 +125,7 @@ uint64_t setupBigHash(const navy::BigHashConfig& bigHashConfig,
 // @param useRaidFiles if set to true, the device will setup using raid.
 // @param itemDestructorEnabled
 // @param stackSize size of the stack used by the region_manager thread
+// @param lockProfiler records the contention of the block cache locks if set
 // @param proto
 //
 // @return The end offset (exclusive) of the setup blockcache.
@@ -134,6 +136,7 @@ uint64_t setupBlockCache(const navy::BlockCacheConfig& blockCacheConfig,
                          bool usesRaidFiles,
                          bool itemDestructorEnabled,
                          uint32_t stackSize,
+                         LockProfiler* lockProfiler,
                          cachelib::navy::EnginePairProto& proto) {
   auto regionSize = blockCacheConfig.getRegionSize();
   if (regionSize != alignUp(regionSize, ioAlignSize)) {
@@ -153,12 +156,33 @@ uint64_t setupBlockCache(const navy::BlockCacheConfig& blockCacheConfig,
     blockCacheOffset = adjustedBlockCacheOffset;
   }
   blockCacheSize = alignDown(blockCacheSize, regionSize);
+  const uint64_t endOffset = blockCacheOffset + blockCacheSize;
+
+  // The index pages take whole regions at the end of the block cache space
+  uint64_t indexFlashSize = 0;
+  if (blockCacheConfig.isFlashIndexEnabled()) {
+    indexFlashSize = alignUp(
+        blockCacheSize * blockCacheConfig.getIndexFlashSizePct() / 100,
+        regionSize);
+    if (indexFlashSize >= blockCacheSize) {
+      throw std::invalid_argument(folly::sformat(
+          "Block cache size {} is too small for an index of {} bytes",
+          blockCacheSize, indexFlashSize));
+    }
+    blockCacheSize -= indexFlashSize;
+  }
 
   XLOG(INFO) << "blockcache: starting offset: " << blockCacheOffset
-             << ", block cache size: " << blockCacheSize;
+             << ", block cache size: " << blockCacheSize
+             << ", index flash size: " << indexFlashSize;
 
   auto blockCache = cachelib::navy::createBlockCacheProto();
   blockCache->setLayout(blockCacheOffset, blockCacheSize, regionSize);
+  if (indexFlashSize > 0) {
+    blockCache->setIndexFlash(blockCacheOffset + blockCacheSize,
+                              indexFlashSize,
+                              blockCacheConfig.getIndexDramBudget());
+  }
   blockCache->setChecksum(blockCacheConfig.getDataChecksum());
 
   // set eviction policy
@@ -167,6 +191,8 @@ uint64_t setupBlockCache(const navy::BlockCacheConfig& blockCacheConfig,
     blockCache->setSegmentedFifoEvictionPolicy(std::move(segmentRatio));
   } else if (blockCacheConfig.isLruEnabled()) {
     blockCache->setLruEvictionPolicy();
+  } else if (blockCacheConfig.isClockEnabled()) {
+    blockCache->setClockEvictionPolicy();
   } else {
     blockCache->setFifoEvictionPolicy();
   }
@@ -179,9 +205,12 @@ uint64_t setupBlockCache(const navy::BlockCacheConfig& blockCacheConfig,
   blockCache->setItemDestructorEnabled(itemDestructorEnabled);
   blockCache->setStackSize(stackSize);
   blockCache->setPreciseRemove(blockCacheConfig.isPreciseRemove());
+  if (lockProfiler != nullptr) {
+    blockCache->setLockProfiler(lockProfiler);
+  }
 
   proto.setBlockCache(std::move(blockCache));
-  return blockCacheOffset + blockCacheSize;
+  return endOffset;
 }
 
 // Setup the CacheProto, includes BigHashProto and BlockCacheProto,
@@ -191,6 +220,7 @@ uint64_t setupBlockCache(const navy::BlockCacheConfig& blockCacheConfig,
 // @param config            the configured NavyConfig
 // @param device            the flash device
 // @param proto             the output CacheProto
+// @param lockProfiler      records the contention of the locks if set
 //
 // @throw std::invalid_argument if input arguments are invalid
 // Below is an illustration on how the cache engines anre metadata are laid out
@@ -201,7 +231,8 @@ uint64_t setupBlockCache(const navy::BlockCacheConfig& blockCacheConfig,
 void setupCacheProtos(const navy::NavyConfig& config,
                       const navy::Device& device,
                       cachelib::navy::CacheProto& proto,
-                      const bool itemDestructorEnabled) {
+                      const bool itemDestructorEnabled,
+                      LockProfiler* lockProfiler) {
   if (config.enginesConfigs()[config.enginesConfigs().size() - 1]
           .blockCache()
           .getSize() != 0) {
@@ -271,7 +302,7 @@ void setupCacheProtos(const navy::NavyConfig& config,
       blockCacheEndOffset = setupBlockCache(
           enginesConfig.blockCache(), blockCacheSize, ioAlignSize,
           blockCacheStartOffset, config.usesRaidFiles(), itemDestructorEnabled,
-          config.getStackSize(), *enginePairProto);
+          config.getStackSize(), lockProfiler, *enginePairProto);
     }
     if (blockCacheEndOffset > bigHashStartOffset) {
       throw std::invalid_argument(folly::sformat(
@@ -329,6 +360,7 @@ std::unique_ptr<cachelib::navy::Device> createDevice(
     std::shared_ptr<navy::DeviceEncryptor> encryptor) {
   auto blockSize = config.getBlockSize();
   auto maxDeviceWriteSize = config.getDeviceMaxWriteSize();
+  std::unique_ptr<cachelib::navy::Device> device;
   if (config.usesRaidFiles() || config.usesSimpleFile()) {
     auto stripeSize = 0;
     auto fileSize = config.getFileSize();
@@ -341,7 +373,7 @@ std::unique_ptr<cachelib::navy::Device> createDevice(
       fileSize = alignDown(fileSize, stripeSize);
     }
 
-    return cachelib::navy::createFileDevice(
+    device = cachelib::navy::createFileDevice(
         filePaths,
         fileSize,
         config.getTruncateFile(),
@@ -353,10 +385,24 @@ std::unique_ptr<cachelib::navy::Device> createDevice(
         config.isFDPEnabled(),
         std::move(encryptor),
         config.getExclusiveOwner());
+  } else if (config.usesSparseMemoryFile()) {
+    device = cachelib::navy::createSparseMemoryDevice(
+        config.getFileSize(), std::move(encryptor), blockSize);
+  } else if (config.getSimulatedDevice()) {
+    device = cachelib::navy::createSimulatedDevice(
+        config.getFileSize(), *config.getSimulatedDevice(),
+        std::move(encryptor), blockSize);
   } else {
-    return cachelib::navy::createMemoryDevice(config.getFileSize(),
-                                              std::move(encryptor), blockSize);
+    device = cachelib::navy::createMemoryDevice(
+        config.getFileSize(), std::move(encryptor), blockSize);
+  }
+
+  if (config.isDiscardEnabled()) {
+    // the rate limited discards are whole BlockCache regions
+    device->enableDiscard(config.getMaxDiscardBytesPerSec(),
+                          getRegionSize(config));
   }
+  return device;
 }
 
 std::unique_ptr<navy::AbstractCache> createNavyCache(
@@ -365,7 +411,9 @@ std::unique_ptr<navy::AbstractCache> createNavyCache(
     navy::DestructorCallback destructorCb,
     bool truncate,
     std::shared_ptr<navy::DeviceEncryptor> encryptor,
-    bool itemDestructorEnabled) {
+    bool itemDestructorEnabled,
+    LockProfiler* lockProfiler,
+    navy::PromotionCallback promotionCb) {
   auto device = createDevice(config, std::move(encryptor));
 
   std::unique_ptr<navy::MockDevice> mockDevice;
@@ -417,8 +465,10 @@ std::unique_ptr<navy::AbstractCache> createNavyCache(
   setAdmissionPolicy(config, *proto);
   proto->setExpiredCheck(checkExpired);
   proto->setDestructorCallback(destructorCb);
+  proto->setPromotionCallback(std::move(promotionCb));
 
-  setupCacheProtos(config, *devicePtr, *proto, itemDestructorEnabled);
+  setupCacheProtos(config, *devicePtr, *proto, itemDestructorEnabled,
+                   lockProfiler);
 
   auto cache = createCache(std::move(proto));
   XDCHECK(cache != nullptr);
@@ -18,18 +18,23 @@
 #include <folly/json/dynamic.h>
 
 #include "cachelib/allocator/nvmcache/NavyConfig.h"
+#include "cachelib/common/LockProfiler.h"
 #include "cachelib/navy/AbstractCache.h"
 namespace facebook {
 namespace cachelib {
 // return a navy cache which is created by CacheProto whose data is from
-// NavyConfig.
+// NavyConfig. The contention of the BlockCache locks is recorded in
+// @lockProfiler if set. @promotionCb is offered the hot items reclaimed by
+// BlockCache if promotion is enabled in the reinsertion config.
 std::unique_ptr<facebook::cachelib::navy::AbstractCache> createNavyCache(
     const navy::NavyConfig& config,
     facebook::cachelib::navy::ExpiredCheck checkExpired,
     facebook::cachelib::navy::DestructorCallback destructorCb,
     bool truncate,
     std::shared_ptr<navy::DeviceEncryptor> encryptor,
-    bool itemDestructorEnabled);
+    bool itemDestructorEnabled,
+    LockProfiler* lockProfiler = nullptr,
+    facebook::cachelib::navy::PromotionCallback promotionCb = {});
 
 // create a flash device for Navy engines to use
 // made public for testing purposes
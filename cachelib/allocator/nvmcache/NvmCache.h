@@ -19,14 +19,19 @@
 #include <folly/container/F14Map.h>
 #include <folly/container/F14Set.h>
 #include <folly/fibers/TimedMutex.h>
+#include <folly/ScopeGuard.h>
 #include <folly/hash/Hash.h>
 #include <folly/json/dynamic.h>
 #include <folly/json/json.h>
 
 #include <array>
+#include <chrono>
+#include <functional>
+#include <memory>
 #include <stdexcept>
 #include <vector>
 
+#include "cachelib/allocator/nvmcache/AsyncPutPool.h"
 #include "cachelib/allocator/nvmcache/CacheApiWrapper.h"
 #include "cachelib/allocator/nvmcache/InFlightPuts.h"
 #include "cachelib/allocator/nvmcache/NavyConfig.h"
@@ -39,6 +44,8 @@
 #include "cachelib/common/EventInterface.h"
 #include "cachelib/common/Exceptions.h"
 #include "cachelib/common/Hash.h"
+#include "cachelib/common/LatencyTracer.h"
+#include "cachelib/common/LockProfiler.h"
 #include "cachelib/common/Utils.h"
 #include "cachelib/navy/common/Device.h"
 #include "folly/Range.h"
@@ -150,6 +157,20 @@ class NvmCache {
     // in the future.
     bool disableNvmCacheOnBadState{true};
 
+    // (Optional) Number of threads that encode and submit the puts of evicted
+    // items. 0 runs them on the evicting thread. Otherwise the evicting
+    // thread copies the item once and the enqueueing into navy runs in the
+    // background. Without encodeCb and makeBlobCb, the copy is the NvmItem
+    // written to navy. With them, it is a copy of the item and its chained
+    // items that the callbacks run on in the background. Not supported with
+    // an item destructor, since the eviction cannot tell whether the item
+    // will make it to NVM.
+    uint32_t asyncPutThreads{0};
+
+    // Number of puts that can wait for a background thread. Puts beyond that
+    // are dropped, as if they were rejected by admission.
+    uint32_t asyncPutQueueSize{1024};
+
     // serialize the config for debugging purposes
     std::map<std::string, std::string> serialize() const;
 
@@ -340,10 +361,64 @@ class NvmCache {
 
   std::unique_ptr<NvmItem> makeNvmItem(const Item& item);
 
+  // Same as above for an item that does not have to live in the cache.
+  //
+  // @param poolId            pool of the item
+  // @param chainedItemRange  chained items of the item
+  // @param getStorageSize    bytes of value to store for an item, given its
+  //                          index: 0 for the parent, then the chained items
+  //                          in the order of the range
+  std::unique_ptr<NvmItem> makeNvmItem(
+      const Item& item,
+      PoolId poolId,
+      folly::Range<ChainedItemIter> chainedItemRange,
+      const std::function<uint32_t(const Item&, size_t)>& getStorageSize);
+
   // wrap an item into a blob for writing into navy.
-  Blob makeBlob(const Item& it);
+  Blob makeBlob(const Item& it, uint32_t storageSize);
   uint32_t getStorageSizeInNvm(const Item& it);
 
+  // Enqueues the insert of the item into navy if the token is still valid.
+  //
+  // @return true if navy accepted the insert
+  bool enqueuePut(HashedKey hk,
+                  std::unique_ptr<NvmItem> nvmItem,
+                  PutToken& token,
+                  util::LatencyTracker tracker);
+
+  // Copy of an evicted item that is put to navy in the background once the
+  // memory of the item has been reused. It holds either the NvmItem, or the
+  // item and its chained items when the encoding callbacks need them.
+  struct PutSnapshot {
+    std::string key;
+    // set if the item is encoded by the evicting thread
+    std::unique_ptr<NvmItem> nvmItem;
+    // otherwise the parent item followed by its chained items, each copied
+    // up to the end of the bytes that go to NVM
+    std::unique_ptr<folly::IOBuf> items;
+    // the bytes of value of each item to store
+    std::vector<uint32_t> storageSizes;
+    PoolId poolId;
+    PutToken token;
+    std::chrono::steady_clock::time_point enqueueTime;
+
+    const Item& getItem() const {
+      return *reinterpret_cast<const Item*>(items->data());
+    }
+  };
+
+  // Copies the item with a single copy of its bytes. The token is moved into
+  // the snapshot and bound to its copy of the key.
+  std::shared_ptr<PutSnapshot> makePutSnapshot(const Item& item,
+                                               PutToken token);
+
+  // Hands the put of the item to the background threads. The item is marked
+  // as being written to NVM right away.
+  void putAsync(Item& item, PutToken token);
+
+  // encodes and submits the put of a snapshot, on a background thread
+  void putSnapshot(PutSnapshot& snapshot);
+
   // Holds all the necessary data to do an async navy get
   // All of the supported operations aren't thread safe. The caller
   // needs to ensure thread safety
@@ -467,7 +542,8 @@ class NvmCache {
   }
 
   std::unique_lock<TimedMutex> getFillLockForShard(size_t shard) {
-    return std::unique_lock<TimedMutex>(fillLock_[shard].fillLock_);
+    return util::lockProfiled<std::unique_lock<TimedMutex>>(
+        fillLock_[shard].fillLock_, fillLockStats_);
   }
 
   std::unique_lock<TimedMutex> getFillLock(HashedKey hk) {
@@ -481,6 +557,14 @@ class NvmCache {
 
   void evictCB(HashedKey hk, navy::BufferView val, navy::DestructorEvent e);
 
+  // Inserts an item that navy is about to reclaim into the DRAM cache.
+  // @isCurrent is checked under the fill lock so that a remove or an
+  // overwrite that raced with the allocation does not resurrect the old
+  // value. Returns true if the item is now in DRAM.
+  bool promoteCB(HashedKey hk,
+                 navy::BufferView val,
+                 folly::FunctionRef<bool()> isCurrent);
+
   static navy::BufferView makeBufferView(folly::ByteRange b) {
     return navy::BufferView{b.size(), b.data()};
   }
@@ -504,6 +588,9 @@ class NvmCache {
     alignas(folly::hardware_destructive_interference_size) TimedMutex fillLock_;
   } fillLock_[kShards];
 
+  // stats of the acquisitions of the fill locks, if profiled
+  LockStats* fillLockStats_{nullptr};
+
   // currently queued put operations to navy.
   std::array<PutContexts, kShards> putContexts_;
 
@@ -528,6 +615,10 @@ class NvmCache {
 
   std::unique_ptr<cachelib::navy::AbstractCache> navyCache_;
 
+  // runs the puts in the background if enabled. Declared after navyCache_
+  // so that the queued puts finish before navy goes away.
+  std::unique_ptr<AsyncPutPool> asyncPuts_;
+
   friend class tests::NvmCacheTest;
   FRIEND_TEST(CachelibAdminTest, WorkingSetAnalysisLoggingTest);
 };
@@ -543,6 +634,8 @@ std::map<std::string, std::string> NvmCache<C>::Config::serialize() const {
       truncateItemToOriginalAllocSizeInNvm ? "true" : "false";
   configMap["disableNvmCacheOnBadState"] =
       disableNvmCacheOnBadState ? "true" : "false";
+  configMap["asyncPutThreads"] = std::to_string(asyncPutThreads);
+  configMap["asyncPutQueueSize"] = std::to_string(asyncPutQueueSize);
   return configMap;
 }
 
@@ -555,6 +648,11 @@ typename NvmCache<C>::Config NvmCache<C>::Config::validateAndSetDefaults() {
         "Encode and Decode CBs must be both specified or both empty.");
   }
 
+  if (asyncPutThreads > 0 && asyncPutQueueSize == 0) {
+    throw std::invalid_argument(
+        "Async nvm puts need a queue size greater than 0.");
+  }
+
   if (deviceEncryptor) {
     auto encryptionBlockSize = deviceEncryptor->encryptionBlockSize();
     auto blockSize = navyConfig.getBlockSize();
@@ -631,7 +729,10 @@ typename NvmCache<C>::WriteHandle NvmCache<C>::find(HashedKey hk) {
   GetCtx* ctx{nullptr};
   WriteHandle hdl{nullptr};
   {
-    auto lock = getFillLockForShard(shard);
+    auto lock = [this, shard]() {
+      ScopedTraceStage stage{TraceStage::kNvmFillLock};
+      return getFillLockForShard(shard);
+    }();
     // do not use the Cache::find() since that will call back into us.
     hdl = CacheAPIWrapperForNvm<C>::findInternal(cache_, hk.key());
     if (UNLIKELY(hdl != nullptr)) {
@@ -952,6 +1053,10 @@ NvmCache<C>::NvmCache(C& c,
         return nvmItem.isExpired();
       }),
       itemDestructor_(itemDestructor) {
+  auto* lockProfiler = CacheAPIWrapperForNvm<C>::getLockProfiler(cache_);
+  if (lockProfiler != nullptr) {
+    fillLockStats_ = lockProfiler->getStats("nvm_fill_lock");
+  }
   navyCache_ = createNavyCache(
       config_.navyConfig,
       checkExpired_,
@@ -960,17 +1065,27 @@ NvmCache<C>::NvmCache(C& c,
       },
       truncate,
       std::move(config.deviceEncryptor),
-      itemDestructor_ ? true : false);
+      itemDestructor_ ? true : false,
+      lockProfiler,
+      [this](HashedKey hk,
+             navy::BufferView v,
+             folly::FunctionRef<bool()> isCurrent) {
+        return this->promoteCB(hk, v, isCurrent);
+      });
+  if (config_.asyncPutThreads > 0) {
+    asyncPuts_ = std::make_unique<AsyncPutPool>(config_.asyncPutThreads,
+                                                config_.asyncPutQueueSize);
+  }
 }
 
 template <typename C>
-Blob NvmCache<C>::makeBlob(const Item& it) {
+Blob NvmCache<C>::makeBlob(const Item& it, uint32_t storageSize) {
   return Blob{
       // User requested size
       it.getSize(),
       // Storage size in NvmCache may be greater than user-requested-size
       // if nvmcache is configured with useTruncatedAllocSize == false
-      {reinterpret_cast<const char*>(it.getMemory()), getStorageSizeInNvm(it)}};
+      {reinterpret_cast<const char*>(it.getMemory()), storageSize}};
 }
 
 template <typename C>
@@ -991,6 +1106,18 @@ std::unique_ptr<NvmItem> NvmCache<C>::makeNvmItem(const Item& item) {
 
   auto chainedItemRange =
       CacheAPIWrapperForNvm<C>::viewAsChainedAllocsRange(cache_, item);
+  return makeNvmItem(item, poolId, chainedItemRange,
+                     [this](const Item& it, size_t) {
+                       return getStorageSizeInNvm(it);
+                     });
+}
+
+template <typename C>
+std::unique_ptr<NvmItem> NvmCache<C>::makeNvmItem(
+    const Item& item,
+    PoolId poolId,
+    folly::Range<ChainedItemIter> chainedItemRange,
+    const std::function<uint32_t(const Item&, size_t)>& getStorageSize) {
   if (config_.encodeCb && !config_.encodeCb(EncodeDecodeContext{
                               const_cast<Item&>(item), chainedItemRange})) {
     return nullptr;
@@ -1018,10 +1145,11 @@ std::unique_ptr<NvmItem> NvmCache<C>::makeNvmItem(const Item& item) {
   } else {
     if (item.hasChainedItem()) {
       std::vector<Blob> blobs;
-      blobs.push_back(makeBlob(item));
+      blobs.push_back(makeBlob(item, getStorageSize(item, 0)));
 
       for (auto& chainedItem : chainedItemRange) {
-        blobs.push_back(makeBlob(chainedItem));
+        blobs.push_back(
+            makeBlob(chainedItem, getStorageSize(chainedItem, blobs.size())));
       }
 
       const size_t bufSize = NvmItem::estimateVariableSize(blobs);
@@ -1030,7 +1158,7 @@ std::unique_ptr<NvmItem> NvmCache<C>::makeNvmItem(const Item& item) {
     } else {
       Blob blob;
       // Support object cache without chained items only.
-      blob = makeBlob(item);
+      blob = makeBlob(item, getStorageSize(item, 0));
       const size_t bufSize = NvmItem::estimateVariableSize(blob);
       return std::unique_ptr<NvmItem>(new (bufSize) NvmItem(
           poolId, item.getCreationTime(), item.getExpiryTime(), blob));
@@ -1067,6 +1195,11 @@ void NvmCache<C>::put(Item& item, PutToken token) {
     return;
   }
 
+  if (asyncPuts_) {
+    putAsync(item, std::move(token));
+    return;
+  }
+
   auto nvmItem = makeNvmItem(item);
   if (!nvmItem) {
     stats().numNvmPutEncodeFailure.inc();
@@ -1077,13 +1210,27 @@ void NvmCache<C>::put(Item& item, PutToken token) {
     stats().numNvmPutFromClean.inc();
   }
 
+  if (enqueuePut(hk, std::move(nvmItem), token, std::move(tracker))) {
+    // mark it as NvmClean and unNvmEvicted if we put it into the queue
+    // so handle destruction awares that there's a NVM copy (at least in the
+    // queue)
+    item.markNvmClean();
+    item.unmarkNvmEvicted();
+  }
+}
+
+template <typename C>
+bool NvmCache<C>::enqueuePut(HashedKey hk,
+                             std::unique_ptr<NvmItem> nvmItem,
+                             PutToken& token,
+                             util::LatencyTracker tracker) {
   auto iobuf = toIOBuf(std::move(nvmItem));
   const auto valSize = iobuf.length();
   auto val = folly::ByteRange{iobuf.data(), iobuf.length()};
 
   auto shard = getShardForKey(hk);
   auto& putContexts = putContexts_[shard];
-  auto& ctx = putContexts.createContext(item.getKey(), std::move(iobuf),
+  auto& ctx = putContexts.createContext(hk.key(), std::move(iobuf),
                                         std::move(tracker));
   // capture array reference for putContext. it is stable
   auto putCleanup = [&putContexts, &ctx]() { putContexts.destroyContext(ctx); };
@@ -1093,6 +1240,7 @@ void NvmCache<C>::put(Item& item, PutToken token) {
   // key not being present means a concurrent get happened with an inflight
   // eviction, and we should abandon this write to navy since we already
   // reported the key doesn't exist in the cache.
+  bool queued = false;
   const bool executed = token.executeIfValid([&]() {
     auto status = navyCache_->insertAsync(
         HashedKey::precomputed(ctx.key(), hk.keyHash()), makeBufferView(val),
@@ -1112,11 +1260,7 @@ void NvmCache<C>::put(Item& item, PutToken token) {
 
     if (status == navy::Status::Ok) {
       guard.dismiss();
-      // mark it as NvmClean and unNvmEvicted if we put it into the queue
-      // so handle destruction awares that there's a NVM copy (at least in the
-      // queue)
-      item.markNvmClean();
-      item.unmarkNvmEvicted();
+      queued = true;
     } else {
       stats().numNvmPutErrs.inc();
     }
@@ -1128,6 +1272,105 @@ void NvmCache<C>::put(Item& item, PutToken token) {
   if (!executed) {
     stats().numNvmAbortedPutOnInflightGet.inc();
   }
+  return queued;
+}
+
+template <typename C>
+std::shared_ptr<typename NvmCache<C>::PutSnapshot>
+NvmCache<C>::makePutSnapshot(const Item& item, PutToken token) {
+  auto snapshot = std::make_shared<PutSnapshot>();
+  snapshot->key = item.getKey().str();
+  snapshot->poolId = cache_.getAllocInfo((void*)(&item)).poolId;
+  snapshot->token = std::move(token);
+  // the token refers to the key of the item, which is about to be reused
+  snapshot->token.rebindKey(snapshot->key);
+  snapshot->enqueueTime = std::chrono::steady_clock::now();
+
+  if (!config_.encodeCb && !config_.makeBlobCb) {
+    // encoding is a copy of the value, so the NvmItem is the snapshot
+    snapshot->nvmItem = makeNvmItem(item);
+    return snapshot;
+  }
+
+  // copies the header, the key and the bytes of value that go to NVM
+  auto copy = [this, &snapshot](const Item& it) {
+    const auto storageSize = getStorageSizeInNvm(it);
+    snapshot->storageSizes.push_back(storageSize);
+    const auto* end =
+        reinterpret_cast<const uint8_t*>(it.getMemory()) + storageSize;
+    const auto* begin = reinterpret_cast<const uint8_t*>(&it);
+    return folly::IOBuf::copyBuffer(begin, end - begin);
+  };
+
+  snapshot->items = copy(item);
+  auto chainedItemRange =
+      CacheAPIWrapperForNvm<C>::viewAsChainedAllocsRange(cache_, item);
+  for (const auto& chainedItem : chainedItemRange) {
+    snapshot->items->prependChain(copy(chainedItem));
+  }
+  return snapshot;
+}
+
+template <typename C>
+void NvmCache<C>::putAsync(Item& item, PutToken token) {
+  auto snapshot = makePutSnapshot(item, std::move(token));
+  const bool added =
+      asyncPuts_->tryAdd([this, snapshot]() { putSnapshot(*snapshot); });
+  if (!added) {
+    stats().numNvmAsyncPutDrops.inc();
+    return;
+  }
+  stats().numNvmAsyncPuts.inc();
+  if (item.isNvmClean() && item.isNvmEvicted()) {
+    stats().numNvmPutFromClean.inc();
+  }
+  // The eviction cannot wait for the put to be queued in navy. The item is
+  // accounted as written to NVM, and a failed put accounts for the eviction
+  // instead.
+  item.markNvmClean();
+  item.unmarkNvmEvicted();
+}
+
+template <typename C>
+void NvmCache<C>::putSnapshot(PutSnapshot& snapshot) {
+  stats().nvmAsyncPutQueueDelayNs.add(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - snapshot.enqueueTime)
+          .count());
+  // the item was released as if it was written to NVM, so a put that does
+  // not make it is accounted for as the eviction it turned into
+  bool queued = false;
+  SCOPE_EXIT {
+    if (!queued) {
+      stats().numNvmAsyncPutFailures.inc();
+      stats().numCacheEvictions.inc();
+    }
+  };
+
+  util::LatencyTracker tracker(stats().nvmInsertLatency_);
+  HashedKey hk{snapshot.key};
+  if (!isEnabled()) {
+    return;
+  }
+  if (hasTombStone(hk)) {
+    stats().numNvmAbortedPutOnTombstone.inc();
+    return;
+  }
+
+  auto nvmItem = std::move(snapshot.nvmItem);
+  if (!nvmItem) {
+    auto chainedItemRange = viewAsChainedAllocsRange(snapshot.items.get());
+    nvmItem = makeNvmItem(snapshot.getItem(), snapshot.poolId,
+                          chainedItemRange, [&snapshot](const Item&, size_t i) {
+                            return snapshot.storageSizes[i];
+                          });
+  }
+  if (!nvmItem) {
+    stats().numNvmPutEncodeFailure.inc();
+    return;
+  }
+  queued =
+      enqueuePut(hk, std::move(nvmItem), snapshot.token, std::move(tracker));
 }
 
 template <typename C>
@@ -1175,7 +1418,11 @@ void NvmCache<C>::onGetComplete(GetCtx& ctx,
     return;
   }
 
-  auto it = createItem(hk.key(), *nvmItem);
+  WriteHandle it;
+  {
+    ScopedTraceStage stage{TraceStage::kNvmDecode};
+    it = createItem(hk.key(), *nvmItem);
+  }
   if (!it) {
     stats().numNvmGetMiss.inc();
     stats().numNvmGetMissErrs.inc();
@@ -1203,6 +1450,46 @@ void NvmCache<C>::onGetComplete(GetCtx& ctx,
   }
 } // namespace cachelib
 
+template <typename C>
+bool NvmCache<C>::promoteCB(HashedKey hk,
+                            navy::BufferView val,
+                            folly::FunctionRef<bool()> isCurrent) {
+  if (!isEnabled()) {
+    return false;
+  }
+
+  const auto& nvmItem = *reinterpret_cast<const NvmItem*>(val.data());
+  if (nvmItem.isExpired()) {
+    return false;
+  }
+
+  // already in DRAM, e.g. filled by a lookup. Nothing to promote.
+  try {
+    if (CacheAPIWrapperForNvm<C>::findInternal(cache_, hk.key())) {
+      return false;
+    }
+  } catch (const exception::RefcountOverflow&) {
+    return false;
+  }
+
+  // the item is allocated from its own pool, so DRAM admits it only if the
+  // pool can make room for it
+  auto it = createItem(hk.key(), nvmItem);
+  if (!it) {
+    return false;
+  }
+  XDCHECK(it->isNvmClean());
+
+  // removes and overwrites put a tombstone before they touch navy and take
+  // the fill lock to do so. Under the lock, either the tombstone is still
+  // there or navy has already dropped or replaced the entry.
+  auto lock = getFillLock(hk);
+  if (hasTombStone(hk) || !isCurrent()) {
+    return false;
+  }
+  return CacheAPIWrapperForNvm<C>::insertFromNvm(cache_, it);
+}
+
 template <typename C>
 typename NvmCache<C>::WriteHandle NvmCache<C>::createItem(
     folly::StringPiece key, const NvmItem& nvmItem) {
@@ -1463,6 +1750,10 @@ typename NvmCache<C>::SampleItem NvmCache<C>::getSampleItem() {
 
 template <typename C>
 bool NvmCache<C>::shutDown() {
+  // let the puts handed to the background threads reach navy
+  if (asyncPuts_) {
+    asyncPuts_->drain();
+  }
   navyEnabled_ = false;
   try {
     this->flushPendingOps();
@@ -1477,6 +1768,9 @@ bool NvmCache<C>::shutDown() {
 
 template <typename C>
 void NvmCache<C>::flushPendingOps() {
+  if (asyncPuts_) {
+    asyncPuts_->drain();
+  }
   navyCache_->flush();
 }
 
@@ -17,6 +17,8 @@
 #include <folly/Random.h>
 #include <gtest/gtest.h>
 
+#include <memory>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -65,6 +67,26 @@ TEST(InFlightPutsTest, TokenMove) {
   ASSERT_TRUE(token.isValid());
 }
 
+TEST(InFlightPutsTest, RebindKey) {
+  InFlightPuts p;
+  auto original = std::make_unique<std::string>("foobar");
+  auto token = *p.tryAcquireToken(*original, []() { return true; });
+
+  const std::string copy = *original;
+  token.rebindKey(copy);
+  original.reset();
+
+  // the token is still known under the copy of the key
+  ASSERT_FALSE(p.tryAcquireToken(copy, []() { return true; }));
+  p.invalidateToken(copy);
+  bool executed = false;
+  ASSERT_FALSE(token.executeIfValid([&]() { executed = true; }));
+  ASSERT_FALSE(executed);
+
+  token = InFlightPuts::PutToken{};
+  ASSERT_TRUE(p.tryAcquireToken(copy, []() { return true; }));
+}
+
 TEST(InFlightPutsTest, FunctionException) {
   InFlightPuts p;
   folly::StringPiece key = "foobar";
@@ -22,6 +22,7 @@
 #include "cachelib/allocator/nvmcache/BlockCacheReinsertionPolicy.h"
 #include "cachelib/allocator/nvmcache/NavyConfig.h"
 #include "cachelib/navy/block_cache/Index.h"
+#include "cachelib/navy/common/SimulatedDevice.h"
 
 namespace facebook {
 namespace cachelib {
@@ -46,6 +47,7 @@ const bool truncateFile = false;
 const uint32_t deviceMaxWriteSize = 4 * 1024 * 1024;
 const navy::IoEngine ioEngine = navy::IoEngine::IoUring;
 const unsigned int qDepth = 64;
+const uint64_t maxDiscardBytesPerSec = 100 * 1024 * 1024;
 
 // BlockCache settings
 const uint32_t blockCacheRegionSize = 16 * 1024 * 1024;
@@ -94,6 +96,7 @@ void setDeviceTestSettings(NavyConfig& config) {
   config.setDeviceMetadataSize(deviceMetadataSize);
   config.setDeviceMaxWriteSize(deviceMaxWriteSize);
   config.enableAsyncIo(qDepth, ioEngine == navy::IoEngine::IoUring);
+  config.enableDiscard(maxDiscardBytesPerSec);
 }
 
 void setBlockCacheTestSettings(NavyConfig& config) {
@@ -140,6 +143,8 @@ TEST(NavyConfigTest, DefaultVal) {
 
   const auto& blockCacheConfig = config.blockCache();
   EXPECT_EQ(blockCacheConfig.isLruEnabled(), true);
+  EXPECT_EQ(blockCacheConfig.isClockEnabled(), false);
+  EXPECT_FALSE(blockCacheConfig.isFlashIndexEnabled());
   EXPECT_EQ(blockCacheConfig.getRegionSize(), 16 * 1024 * 1024);
   EXPECT_EQ(blockCacheConfig.getCleanRegions(), 1);
   EXPECT_EQ(blockCacheConfig.getCleanRegionThreads(), 1);
@@ -164,6 +169,8 @@ TEST(NavyConfigTest, DefaultVal) {
   EXPECT_EQ(config.getDeviceMetadataSize(), 0);
   EXPECT_EQ(config.getFileSize(), 0);
   EXPECT_EQ(config.getDeviceMaxWriteSize(), 0);
+  EXPECT_EQ(config.isDiscardEnabled(), false);
+  EXPECT_EQ(config.getMaxDiscardBytesPerSec(), 0);
 
   EXPECT_EQ(config.usesSimpleFile(), false);
   EXPECT_EQ(config.usesRaidFiles(), false);
@@ -194,17 +201,27 @@ TEST(NavyConfigTest, Serialization) {
   expectedConfigMap["navyConfig::ioEngine"] = "io_uring";
   expectedConfigMap["navyConfig::QDepth"] = "64";
   expectedConfigMap["navyConfig::enableFDP"] = "0";
+  expectedConfigMap["navyConfig::enableDiscard"] = "1";
+  expectedConfigMap["navyConfig::maxDiscardBytesPerSec"] = "104857600";
+  expectedConfigMap["navyConfig::sparseMemoryFile"] = "0";
+  expectedConfigMap["navyConfig::simulatedDevice"] = "";
 
   expectedConfigMap["navyConfig::blockCacheLru"] = "false";
+  expectedConfigMap["navyConfig::blockCacheClock"] = "false";
   expectedConfigMap["navyConfig::blockCacheRegionSize"] = "16777216";
   expectedConfigMap["navyConfig::blockCacheCleanRegions"] = "4";
   expectedConfigMap["navyConfig::blockCacheCleanRegionThreads"] = "1";
   expectedConfigMap["navyConfig::blockCacheReinsertionHitsThreshold"] = "111";
   expectedConfigMap["navyConfig::blockCacheReinsertionPctThreshold"] = "0";
+  expectedConfigMap["navyConfig::blockCachePromotionHitsThreshold"] = "0";
+  expectedConfigMap["navyConfig::blockCachePromotionMaxBytesPerSec"] = "0";
+  expectedConfigMap["navyConfig::blockCacheReinsertPromoted"] = "false";
   expectedConfigMap["navyConfig::blockCacheNumInMemBuffers"] = "8";
   expectedConfigMap["navyConfig::blockCacheDataChecksum"] = "true";
   expectedConfigMap["navyConfig::blockCacheSegmentedFifoSegmentRatio"] =
       "111,222,333";
+  expectedConfigMap["navyConfig::blockCacheIndexDramBudget"] = "0";
+  expectedConfigMap["navyConfig::blockCacheIndexFlashSizePct"] = "0";
 
   expectedConfigMap["navyConfig::bigHashSizePct"] = "50";
   expectedConfigMap["navyConfig::bigHashBucketSize"] = "1024";
@@ -283,6 +300,23 @@ TEST(NavyConfigTest, Device) {
     EXPECT_EQ(config.getTruncateFile(), truncateFile);
     EXPECT_THROW(config.setSimpleFile(fileName, fileSize, truncateFile),
                  std::invalid_argument);
+    EXPECT_THROW(config.setSimulatedDevice(fileSize, {}),
+                 std::invalid_argument);
+  }
+  {
+    // set a simulated device
+    NavyConfig config{};
+    EXPECT_EQ(config.getSimulatedDevice(), nullptr);
+    navy::SimulatedDeviceConfig simConfig;
+    simConfig.numChannels = 0;
+    EXPECT_THROW(config.setSimulatedDevice(fileSize, simConfig),
+                 std::invalid_argument);
+    simConfig.numChannels = 4;
+    config.setSimulatedDevice(fileSize, simConfig);
+    ASSERT_NE(config.getSimulatedDevice(), nullptr);
+    EXPECT_EQ(config.getSimulatedDevice()->numChannels, 4);
+    EXPECT_EQ(config.getFileSize(), fileSize);
+    EXPECT_FALSE(config.usesSimpleFile());
   }
   {
     // set io engines
@@ -328,12 +362,29 @@ TEST(NavyConfigTest, BlockCache) {
   config.blockCache().enableFifo();
   EXPECT_EQ(config.blockCache().isLruEnabled(), false);
   EXPECT_TRUE(config.blockCache().getSFifoSegmentRatio().empty());
+  // test CLOCK eviction policy
+  config.blockCache().enableClock();
+  EXPECT_EQ(config.blockCache().isLruEnabled(), false);
+  EXPECT_EQ(config.blockCache().isClockEnabled(), true);
   // test segmented FIFO eviction policy
   config.blockCache().enableSegmentedFifo(blockCacheSegmentedFifoSegmentRatio);
   EXPECT_EQ(config.blockCache().isLruEnabled(), false);
+  EXPECT_EQ(config.blockCache().isClockEnabled(), false);
   EXPECT_EQ(config.blockCache().getSFifoSegmentRatio(),
             blockCacheSegmentedFifoSegmentRatio);
 
+  // test flash index
+  EXPECT_THROW(config.blockCache().enableFlashIndex(0), std::invalid_argument);
+  EXPECT_THROW(config.blockCache().enableFlashIndex(1024, 0),
+               std::invalid_argument);
+  EXPECT_THROW(config.blockCache().enableFlashIndex(1024, 51),
+               std::invalid_argument);
+  EXPECT_FALSE(config.blockCache().isFlashIndexEnabled());
+  config.blockCache().enableFlashIndex(1024);
+  EXPECT_TRUE(config.blockCache().isFlashIndexEnabled());
+  EXPECT_EQ(config.blockCache().getIndexDramBudget(), 1024);
+  EXPECT_EQ(config.blockCache().getIndexFlashSizePct(), 2);
+
   auto customPolicy = std::make_shared<DummyReinsertionPolicy>();
 
   navy::Index index;
@@ -383,6 +434,19 @@ TEST(NavyConfigTest, BlockCache) {
   EXPECT_EQ(config.blockCache().getReinsertionConfig().getHitsThreshold(), 0);
   EXPECT_EQ(config.blockCache().getReinsertionConfig().getCustomPolicy(index),
             customPolicy);
+
+  // promotion goes along with any reinsertion policy
+  config = NavyConfig{};
+  EXPECT_THROW(config.blockCache().enablePromotion(0), std::invalid_argument);
+  config.blockCache()
+      .enableHitsBasedReinsertion(blockCacheReinsertionHitsThreshold)
+      .enablePromotion(5, 1024 * 1024, true);
+  const auto& reinsertionConfig = config.blockCache().getReinsertionConfig();
+  EXPECT_EQ(reinsertionConfig.getHitsThreshold(),
+            blockCacheReinsertionHitsThreshold);
+  EXPECT_EQ(reinsertionConfig.getPromotionHitsThreshold(), 5);
+  EXPECT_EQ(reinsertionConfig.getPromotionMaxBytesPerSec(), 1024 * 1024);
+  EXPECT_TRUE(reinsertionConfig.getReinsertPromoted());
 }
 
 TEST(NavyConfigTest, BigHash) {
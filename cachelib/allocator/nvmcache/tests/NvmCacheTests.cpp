@@ -15,8 +15,10 @@
  */
 
 #include <folly/Random.h>
+#include <folly/synchronization/Baton.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <climits>
 #include <set>
 #include <thread>
@@ -1088,6 +1090,215 @@ TEST_F(NvmCacheTest, ChainedItems) {
   verifyChainedAllcos(it);
 }
 
+TEST_F(NvmCacheTest, AsyncPutChainedItems) {
+  auto& config = this->getConfig();
+  config.configureChainedItems();
+  config.nvmConfig->asyncPutThreads = 2;
+  auto& cache = this->makeCache();
+  auto pid = this->poolId();
+
+  const uint32_t allocSize = 15 * 1024 - 5;
+  const uint32_t nChained = 5;
+  std::string key = "foobar";
+  std::vector<std::string> vals;
+  {
+    auto it = cache.allocate(pid, key, allocSize);
+    ASSERT_NE(nullptr, it);
+
+    auto fillItem = [&](Item& item) {
+      const auto text = genRandomStr(cache.getUsableSize(item));
+      vals.push_back(text);
+      std::memcpy(reinterpret_cast<char*>(item.getMemory()), text.data(),
+                  text.size());
+    };
+
+    fillItem(*it);
+    for (unsigned int i = 0; i < nChained; i++) {
+      auto chainedIt = cache.allocateChainedItem(it, 100 * (i + 1));
+      ASSERT_TRUE(chainedIt);
+      fillItem(*chainedIt);
+      cache.addChainedItem(it, std::move(chainedIt));
+    }
+    cache.insertOrReplace(it);
+  }
+
+  ASSERT_TRUE(this->pushToNvmCacheFromRamForTesting(key));
+  // the item goes away before the background put is done
+  this->removeFromRamForTesting(key);
+  cache.flushNvmCache();
+
+  const auto stats = this->getStats();
+  EXPECT_EQ(1, stats.numNvmAsyncPuts);
+  EXPECT_EQ(0, stats.numNvmAsyncPutDrops);
+  EXPECT_EQ(0, stats.numNvmAsyncPutFailures);
+
+  auto it = this->fetch(key, false /* ramOnly */);
+  ASSERT_TRUE(it);
+  auto allocs = cache.viewAsChainedAllocs(it);
+  EXPECT_EQ(0, std::memcmp(allocs.getParentItem().getMemory(), vals[0].data(),
+                           vals[0].size()));
+  int index = 0;
+  for (const auto& c : allocs.getChain()) {
+    const auto& text = vals[nChained - index++];
+    ASSERT_EQ(cache.getUsableSize(c), text.size());
+    EXPECT_EQ(0, std::memcmp(c.getMemory(), text.data(), text.size()));
+  }
+}
+
+TEST_F(NvmCacheTest, AsyncPutEncodeCb) {
+  auto& config = this->getConfig();
+  config.nvmConfig->asyncPutThreads = 1;
+  // the callback runs on the copy of the item, in the background
+  std::atomic<int> numEncoded{0};
+  std::atomic<bool> onEvictingThread{false};
+  const auto evictingThread = std::this_thread::get_id();
+  config.nvmConfig->encodeCb = [&](NvmCacheT::EncodeDecodeContext ctx) {
+    numEncoded++;
+    onEvictingThread = std::this_thread::get_id() == evictingThread;
+    std::memset(ctx.item.getMemory(), 'b', ctx.item.getSize());
+    return true;
+  };
+  auto& cache = this->makeCache();
+
+  const std::string key = "foobar";
+  const uint32_t size = 1000;
+  {
+    auto it = cache.allocate(this->poolId(), key, size);
+    ASSERT_NE(nullptr, it);
+    std::memset(it->getMemory(), 'a', size);
+    cache.insertOrReplace(it);
+  }
+  ASSERT_TRUE(this->pushToNvmCacheFromRamForTesting(key));
+  ASSERT_TRUE(this->removeFromRamForTesting(key));
+  cache.flushNvmCache();
+
+  EXPECT_EQ(1, numEncoded);
+  EXPECT_FALSE(onEvictingThread);
+  EXPECT_EQ(0, this->getStats().numNvmAsyncPutFailures);
+  auto it = this->fetch(key, false /* ramOnly */);
+  ASSERT_TRUE(it);
+  EXPECT_EQ(std::string(size, 'b'),
+            std::string(reinterpret_cast<const char*>(it->getMemory()), size));
+}
+
+TEST_F(NvmCacheTest, AsyncPutQueueFull) {
+  auto& config = this->getConfig();
+  config.nvmConfig->asyncPutThreads = 1;
+  config.nvmConfig->asyncPutQueueSize = 1;
+  auto& cache = this->makeCache();
+  auto pid = this->poolId();
+
+  const std::vector<std::string> keys = {"queued", "dropped"};
+  for (const auto& key : keys) {
+    auto it = cache.allocate(pid, key, 100);
+    ASSERT_NE(nullptr, it);
+    cache.insertOrReplace(it);
+  }
+  cache.flushNvmCache();
+
+  // hold the only thread so that the queue fills up
+  folly::Baton<> started;
+  folly::Baton<> release;
+  ASSERT_TRUE(this->addAsyncPutTask([&]() {
+    started.post();
+    release.wait();
+  }));
+  started.wait();
+  for (const auto& key : keys) {
+    ASSERT_TRUE(this->pushToNvmCacheFromRamForTesting(key, false /* flush */));
+  }
+  release.post();
+  cache.flushNvmCache();
+
+  const auto stats = this->getStats();
+  EXPECT_EQ(1, stats.numNvmAsyncPuts);
+  EXPECT_EQ(1, stats.numNvmAsyncPutDrops);
+  EXPECT_EQ(0, stats.numNvmAsyncPutFailures);
+
+  // the dropped put is an eviction
+  for (const auto& key : keys) {
+    ASSERT_TRUE(this->removeFromRamForTesting(key));
+  }
+  EXPECT_TRUE(this->fetch("queued", false /* ramOnly */));
+  EXPECT_FALSE(this->fetch("dropped", false /* ramOnly */));
+}
+
+TEST_F(NvmCacheTest, AsyncPutRemoveWhileQueued) {
+  auto& config = this->getConfig();
+  config.nvmConfig->asyncPutThreads = 1;
+  auto& cache = this->makeCache();
+  auto pid = this->poolId();
+
+  const std::string key = "foobar";
+  {
+    auto it = cache.allocate(pid, key, 100);
+    ASSERT_NE(nullptr, it);
+    cache.insertOrReplace(it);
+  }
+  cache.flushNvmCache();
+
+  folly::Baton<> started;
+  folly::Baton<> release;
+  ASSERT_TRUE(this->addAsyncPutTask([&]() {
+    started.post();
+    release.wait();
+  }));
+  started.wait();
+  ASSERT_TRUE(this->pushToNvmCacheFromRamForTesting(key, false /* flush */));
+  // the remove invalidates the put still in the queue
+  ASSERT_EQ(AllocatorT::RemoveRes::kSuccess, cache.remove(key));
+  release.post();
+  cache.flushNvmCache();
+
+  const auto stats = this->getStats();
+  EXPECT_EQ(1, stats.numNvmAsyncPuts);
+  EXPECT_EQ(1, stats.numNvmAsyncPutFailures);
+  EXPECT_FALSE(this->fetch(key, false /* ramOnly */));
+}
+
+TEST_F(NvmCacheTest, AsyncPutLookupWhileQueued) {
+  auto& config = this->getConfig();
+  config.nvmConfig->asyncPutThreads = 1;
+  auto& cache = this->makeCache();
+  auto pid = this->poolId();
+
+  const std::string key = "foobar";
+  {
+    auto it = cache.allocate(pid, key, 100);
+    ASSERT_NE(nullptr, it);
+    cache.insertOrReplace(it);
+  }
+  cache.flushNvmCache();
+
+  folly::Baton<> started;
+  folly::Baton<> release;
+  ASSERT_TRUE(this->addAsyncPutTask([&]() {
+    started.post();
+    release.wait();
+  }));
+  started.wait();
+  ASSERT_TRUE(this->pushToNvmCacheFromRamForTesting(key, false /* flush */));
+  ASSERT_TRUE(this->removeFromRamForTesting(key));
+  // the lookup misses in navy and invalidates the put still in the queue, so
+  // that the miss it reported stays consistent
+  EXPECT_FALSE(this->fetch(key, false /* ramOnly */));
+  release.post();
+  cache.flushNvmCache();
+
+  const auto stats = this->getStats();
+  EXPECT_EQ(1, stats.numNvmAsyncPuts);
+  EXPECT_EQ(1, stats.numNvmAbortedPutOnInflightGet);
+  EXPECT_EQ(1, stats.numNvmAsyncPutFailures);
+  EXPECT_FALSE(this->fetch(key, false /* ramOnly */));
+}
+
+TEST_F(NvmCacheTest, AsyncPutConfig) {
+  auto& config = this->getConfig();
+  config.nvmConfig->asyncPutThreads = 1;
+  config.setItemDestructor([](const AllocatorT::DestructorData&) {});
+  EXPECT_THROW(config.validate(), std::invalid_argument);
+}
+
 TEST_F(NvmCacheTest, ChainedItemsModifyAccessible) {
   auto& config = this->getConfig();
   config.configureChainedItems();
@@ -2218,6 +2429,82 @@ TEST_F(NvmCacheTest, testEvictCB) {
   }
 }
 
+TEST_F(NvmCacheTest, PromoteRacingRemove) {
+  auto& cache = makeCache();
+  auto pid = poolId();
+  auto nvm = getNvmCache();
+  auto isCurrent = []() { return true; };
+  auto isStale = []() { return false; };
+
+  const std::string key = "key" + genRandomStr(10);
+  const std::string val = "val" + genRandomStr(10);
+  auto handle = cache.allocate(pid, key, 100);
+  ASSERT_NE(nullptr, handle.get());
+  std::memcpy(handle->getMemory(), val.data(), val.size());
+  auto buf = toIOBuf(makeNvmItem(*handle));
+  const navy::BufferView view{buf.length(), buf.data()};
+  handle.reset();
+
+  // 1. a remove is in progress, the item must not be brought back
+  {
+    auto tombstone = nvm->createDeleteTombStone(HashedKey{key});
+    ASSERT_FALSE(promoteCB(HashedKey{key}, view, isCurrent));
+    ASSERT_FALSE(checkKeyExists(key, true /* ramOnly */));
+  }
+
+  // 2. the remove already dropped the flash entry
+  ASSERT_FALSE(promoteCB(HashedKey{key}, view, isStale));
+  ASSERT_FALSE(checkKeyExists(key, true /* ramOnly */));
+
+  // 3. nothing raced with the promotion
+  ASSERT_TRUE(promoteCB(HashedKey{key}, view, isCurrent));
+  auto hdl = fetch(key, true /* ramOnly */);
+  ASSERT_NE(nullptr, hdl);
+  ASSERT_TRUE(hdl->isNvmClean());
+  ASSERT_EQ(0, std::memcmp(hdl->getMemory(), val.data(), val.size()));
+}
+
+TEST_F(NvmCacheTest, PromoteRacingOverwrite) {
+  auto& cache = makeCache();
+  auto pid = poolId();
+
+  const std::string key = "key" + genRandomStr(10);
+  const std::string oldVal = "old" + genRandomStr(10);
+  const std::string newVal = "new" + genRandomStr(10);
+  auto handle = cache.allocate(pid, key, 100);
+  ASSERT_NE(nullptr, handle.get());
+  std::memcpy(handle->getMemory(), oldVal.data(), oldVal.size());
+  auto buf = toIOBuf(makeNvmItem(*handle));
+  const navy::BufferView oldView{buf.length(), buf.data()};
+  handle.reset();
+
+  auto expectNewVal = [&]() {
+    auto hdl = fetch(key, false /* ramOnly */);
+    ASSERT_NE(nullptr, hdl);
+    ASSERT_EQ(0,
+              std::memcmp(hdl->getMemory(), newVal.data(), newVal.size()));
+  };
+
+  // 1. the new value is in DRAM
+  {
+    auto newHandle = cache.allocate(pid, key, 100);
+    ASSERT_NE(nullptr, newHandle.get());
+    std::memcpy(newHandle->getMemory(), newVal.data(), newVal.size());
+    insertOrReplace(newHandle);
+  }
+  ASSERT_FALSE(promoteCB(HashedKey{key}, oldView, []() { return true; }));
+  expectNewVal();
+
+  // 2. the new value was written to flash at another address and left DRAM,
+  // so navy reports the reclaimed old entry as stale
+  ASSERT_TRUE(pushToNvmCacheFromRamForTesting(key));
+  removeFromRamForTesting(key);
+  ASSERT_FALSE(checkKeyExists(key, true /* ramOnly */));
+  ASSERT_FALSE(promoteCB(HashedKey{key}, oldView, []() { return false; }));
+  ASSERT_FALSE(checkKeyExists(key, true /* ramOnly */));
+  expectNewVal();
+}
+
 void verifyItem(const Item& item, const Item& iobufItem) {
   ASSERT_EQ(item.isChainedItem(), iobufItem.isChainedItem());
   ASSERT_EQ(item.hasChainedItem(), iobufItem.hasChainedItem());
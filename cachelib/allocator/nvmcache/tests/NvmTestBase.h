@@ -146,6 +146,19 @@ class NvmCacheTest : public testing::Test {
     getNvmCache()->evictCB(std::forward<Params>(args)...);
   }
 
+  bool promoteCB(HashedKey hk,
+                 navy::BufferView val,
+                 folly::FunctionRef<bool()> isCurrent) {
+    return getNvmCache()->promoteCB(hk, val, isCurrent);
+  }
+
+  // Runs @task on the async put threads, e.g. to hold them while puts are
+  // queued behind it.
+  // @return false if the queue is full
+  bool addAsyncPutTask(folly::Function<void()> task) {
+    return getNvmCache()->asyncPuts_->tryAdd(std::move(task));
+  }
+
   folly::Range<ChainedItemIter> viewAsChainedAllocsRange(folly::IOBuf* parent) {
     return getNvmCache()->viewAsChainedAllocsRange(parent);
   }
@@ -65,6 +65,7 @@ struct MMLruConfig {
   4: bool updateOnRead = true;
   5: bool tryLockUpdate = false;
   6: double lruRefreshRatio = 0.0;
+  7: i32 ttlBandSecs = 0;
 }
 
 struct MMLruObject {
@@ -77,6 +78,10 @@ struct MMLruObject {
   7: required i64 tailSize;
   8: required DListObject lru;
   9: required i64 compressedInsertionPoint;
+
+  // items with a short TTL, kept apart from the lru. Absent when restoring
+  // from a version without TTL bands.
+  10: optional DListObject ttlBand;
 }
 
 struct MMLruCollection {
@@ -55,6 +55,12 @@ TYPED_TEST(BaseAllocatorTest, ReadWriteHandle) { this->testReadWriteHandle(); }
 // fetch them.
 TYPED_TEST(BaseAllocatorTest, Find) { this->testFind(); }
 
+// load items with bulkInsert and ensure that they are accessible.
+TYPED_TEST(BaseAllocatorTest, BulkInsert) { this->testBulkInsert(); }
+
+// export the hottest items and load them into another cache.
+TYPED_TEST(BaseAllocatorTest, ExportHotItems) { this->testExportHotItems(); }
+
 // make some allocations without evictions, remove them and ensure that they
 // cannot be accessed through find.
 TYPED_TEST(BaseAllocatorTest, Remove) { this->testRemove(); }
@@ -214,6 +220,22 @@ TYPED_TEST(BaseAllocatorTest, ReaperNoWaitUntilEvictions) {
   this->testReaperNoWaitUntilEvictions();
 }
 
+TYPED_TEST(BaseAllocatorTest, ItemCompression) {
+  this->testItemCompression();
+}
+
+TYPED_TEST(BaseAllocatorTest, ItemCompressionPaths) {
+  this->testItemCompressionPaths();
+}
+
+TYPED_TEST(BaseAllocatorTest, ItemCompressionSlabRelease) {
+  this->testItemCompressionSlabRelease();
+}
+
+TYPED_TEST(BaseAllocatorTest, ContentSampling) {
+  this->testContentSampling();
+}
+
 TYPED_TEST(BaseAllocatorTest, ReaperOutOfBound) {
   this->testReaperOutOfBound();
 }
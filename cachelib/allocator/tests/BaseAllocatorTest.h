@@ -800,6 +800,128 @@ class BaseAllocatorTest : public AllocatorTest<AllocatorT> {
     }
   }
 
+  // load items of various sizes with bulkInsert and ensure that they are
+  // accessible with the right value and TTL.
+  void testBulkInsert() {
+    typename AllocatorT::Config config;
+    config.setCacheSize(100 * Slab::kSize);
+    AllocatorT alloc(config);
+    const size_t numBytes = alloc.getCacheMemoryStats().ramCacheSize;
+    auto poolId = alloc.addPool("foobar", numBytes);
+
+    const size_t numRecords = 5000;
+    std::vector<std::string> keys;
+    std::vector<std::string> values;
+    for (size_t i = 0; i < numRecords; i++) {
+      keys.push_back(folly::sformat("key{}", i));
+      // spread the records over a few allocation classes
+      values.push_back(std::string(100 + (i % 5) * 1000, 'a' + i % 26));
+    }
+    std::vector<typename AllocatorT::BulkInsertRecord> records(numRecords);
+    for (size_t i = 0; i < numRecords; i++) {
+      records[i].key = keys[i];
+      records[i].value = values[i];
+      records[i].ttlSecs = i % 2 == 0 ? 3600 : 0;
+      records[i].rank = i;
+    }
+
+    // existing keys are not replaced
+    ASSERT_NE(nullptr, util::allocateAccessible(alloc, poolId, keys[0], 10));
+
+    auto res = alloc.bulkInsert(poolId, folly::range(records), 4);
+    EXPECT_EQ(numRecords - 1, res.numInserted);
+    EXPECT_EQ(1, res.numExisting);
+    EXPECT_EQ(0, res.numAllocFailures);
+
+    EXPECT_EQ(10, alloc.find(keys[0])->getSize());
+    for (size_t i = 1; i < numRecords; i++) {
+      auto handle = alloc.find(keys[i]);
+      ASSERT_NE(nullptr, handle);
+      ASSERT_EQ(values[i],
+                folly::StringPiece(
+                    reinterpret_cast<const char*>(handle->getMemory()),
+                    handle->getSize()));
+      ASSERT_EQ(i % 2 == 0 ? 3600 : 0, handle->getConfiguredTTL().count());
+    }
+
+    // an invalid record fails the whole call
+    std::vector<typename AllocatorT::BulkInsertRecord> badRecords(2);
+    badRecords[0].key = "newKey";
+    badRecords[0].value = values[0];
+    badRecords[1].value = values[1];
+    EXPECT_THROW(alloc.bulkInsert(poolId, folly::range(badRecords)),
+                 std::invalid_argument);
+    EXPECT_EQ(nullptr, alloc.find("newKey"));
+    EXPECT_THROW(alloc.bulkInsert(poolId, folly::range(records), 0),
+                 std::invalid_argument);
+  }
+
+  // export the hottest items of a pool and load them into another cache.
+  void testExportHotItems() {
+    typename AllocatorT::Config config;
+    config.setCacheSize(100 * Slab::kSize);
+    AllocatorT alloc(config);
+    const size_t numBytes = alloc.getCacheMemoryStats().ramCacheSize;
+    auto poolId = alloc.addPool("foobar", numBytes / 2);
+    auto otherPoolId = alloc.addPool("other", numBytes / 2);
+
+    const size_t numItems = 1000;
+    for (size_t i = 0; i < numItems; i++) {
+      const auto key = folly::sformat("key{}", i);
+      auto handle = util::allocateAccessible(alloc, poolId, key, 100,
+                                             i % 2 == 0 ? 3600 : 0);
+      ASSERT_NE(nullptr, handle);
+      std::memset(handle->getMemory(), 'a' + i % 26, 100);
+      ASSERT_NE(nullptr,
+                util::allocateAccessible(alloc, otherPoolId,
+                                         folly::sformat("other{}", i), 100));
+    }
+
+    // copy out the records since they point into the items
+    std::vector<std::string> keys;
+    std::vector<std::string> values;
+    std::vector<typename AllocatorT::BulkInsertRecord> records;
+    alloc.exportHotItems(
+        poolId, numItems / 2,
+        [&](const typename AllocatorT::BulkInsertRecord& record) {
+          keys.push_back(record.key.str());
+          values.push_back(record.value.str());
+          records.push_back(record);
+        });
+    ASSERT_EQ(numItems / 2, records.size());
+    for (size_t i = 0; i < records.size(); i++) {
+      // coldest first
+      EXPECT_EQ(records.size() - 1 - i, records[i].rank);
+      EXPECT_EQ(0, keys[i].find("key"));
+      records[i].key = keys[i];
+      records[i].value = values[i];
+      auto handle = alloc.peek(keys[i]);
+      EXPECT_EQ(handle->getConfiguredTTL().count() != 0,
+                records[i].ttlSecs != 0);
+      EXPECT_GE(3600, records[i].ttlSecs);
+    }
+
+    AllocatorT newAlloc(config);
+    auto newPoolId = newAlloc.addPool(
+        "foobar", newAlloc.getCacheMemoryStats().ramCacheSize);
+    auto res = newAlloc.bulkInsert(newPoolId, folly::range(records), 2);
+    EXPECT_EQ(records.size(), res.numInserted);
+    for (size_t i = 0; i < records.size(); i++) {
+      auto handle = newAlloc.find(keys[i]);
+      ASSERT_NE(nullptr, handle);
+      ASSERT_EQ(values[i],
+                folly::StringPiece(
+                    reinterpret_cast<const char*>(handle->getMemory()),
+                    handle->getSize()));
+    }
+
+    size_t numExported = 0;
+    alloc.exportHotItems(poolId, 0, [&](const auto&) { numExported++; });
+    alloc.exportHotItems(poolId, 2 * numItems,
+                         [&](const auto&) { numExported++; });
+    EXPECT_EQ(numItems, numExported);
+  }
+
   // make some allocations without evictions, remove them and ensure that they
   // cannot be accessed through find.
   void testRemove() {
@@ -2412,6 +2534,19 @@ class BaseAllocatorTest : public AllocatorTest<AllocatorT> {
       ASSERT_EQ(&c, chainedAllocs.getNthInChain(nChainedAllocs - i - 1));
       i--;
     }
+    ASSERT_EQ(nullptr, chainedAllocs.getNthInChain(nChainedAllocs));
+
+    // indexed access in any order
+    chainedAllocs.prefetchChain();
+    chainedAllocs.indexChain();
+    ASSERT_EQ(nChainedAllocs, chainedAllocs.computeChainLength());
+    ASSERT_EQ(nullptr, chainedAllocs.getNthInChain(nChainedAllocs));
+    for (size_t j = nChainedAllocs; j-- > 0;) {
+      auto* c = chainedAllocs.getNthInChain(j);
+      ASSERT_NE(nullptr, c);
+      ASSERT_EQ(*reinterpret_cast<const int*>(c->getMemory()),
+                static_cast<int>(nChainedAllocs - j - 1));
+    }
   }
 
   // create a chain of allocations, replace the allocation and ensure that the
@@ -4013,6 +4148,274 @@ class BaseAllocatorTest : public AllocatorTest<AllocatorT> {
     EXPECT_LE(stats.lastTraversalTimeMs, util::getCurrentTimeMs() - startTime);
   }
 
+  void testItemCompression() {
+    const int numSlabs = 4;
+
+    typename AllocatorT::Config config;
+    config.setCacheSize(numSlabs * Slab::kSize);
+    config.itemCompressionConfig.minValueSize = 1000;
+
+    AllocatorT allocator(config);
+    const size_t numBytes = allocator.getCacheMemoryStats().ramCacheSize;
+    auto poolId = allocator.addPool("default", numBytes);
+
+    // compressible values
+    const size_t kValueSize = 5000;
+    const int kNumItems = 10;
+    for (int i = 0; i < kNumItems; i++) {
+      auto handle = util::allocateAccessible(
+          allocator, poolId, folly::to<std::string>(i), kValueSize);
+      ASSERT_NE(nullptr, handle);
+      std::memset(handle->getMemory(), 'a' + i, kValueSize);
+    }
+    // one value that does not compress
+    {
+      auto handle = util::allocateAccessible(allocator, poolId, "random",
+                                             kValueSize);
+      ASSERT_NE(nullptr, handle);
+      auto* data = reinterpret_cast<uint8_t*>(handle->getMemory());
+      for (size_t j = 0; j < kValueSize; j++) {
+        data[j] = folly::Random::rand32() & 0xff;
+      }
+    }
+
+    const auto cid = allocator.getPool(poolId).getAllocationClassId(
+        AllocatorT::Item::getRequiredSize("0", kValueSize));
+    EXPECT_EQ(kNumItems, allocator.compressColdItems(poolId, cid, 100));
+    auto stats = allocator.getGlobalCacheStats();
+    EXPECT_EQ(kNumItems, stats.numItemsCompressed);
+    EXPECT_EQ(1, stats.numItemCompressSkipped);
+    EXPECT_EQ(kNumItems * kValueSize, stats.itemCompressInputBytes);
+    EXPECT_GT(stats.itemCompressInputBytes, stats.itemCompressOutputBytes);
+
+    // already compressed items are left alone
+    EXPECT_EQ(0, allocator.compressColdItems(poolId, cid, 100));
+
+    for (int i = 0; i < kNumItems; i++) {
+      auto handle = allocator.find(folly::to<std::string>(i));
+      ASSERT_NE(nullptr, handle);
+      EXPECT_FALSE(handle->isCompressed());
+      ASSERT_EQ(kValueSize, handle->getSize());
+      const auto* data = reinterpret_cast<const char*>(handle->getMemory());
+      EXPECT_EQ(std::string(kValueSize, 'a' + i),
+                std::string(data, kValueSize));
+    }
+    stats = allocator.getGlobalCacheStats();
+    EXPECT_EQ(kNumItems, stats.numItemsDecompressed);
+    EXPECT_EQ(0, stats.numItemDecompressFailures);
+
+    // compression is not supported alongside a remove callback
+    typename AllocatorT::Config badConfig;
+    badConfig.setCacheSize(numSlabs * Slab::kSize);
+    badConfig.enableItemCompression(std::chrono::seconds{1});
+    badConfig.setRemoveCallback([](const typename AllocatorT::RemoveCbData&) {});
+    EXPECT_THROW(badConfig.validate(), std::invalid_argument);
+  }
+
+  // Items are handed out uncompressed by the APIs that return an item
+  // without a lookup, and skipped by the iterators.
+  void testItemCompressionPaths() {
+    const int numSlabs = 4;
+
+    typename AllocatorT::Config config;
+    config.setCacheSize(numSlabs * Slab::kSize);
+    config.itemCompressionConfig.minValueSize = 1000;
+
+    AllocatorT allocator(config);
+    const size_t numBytes = allocator.getCacheMemoryStats().ramCacheSize;
+    auto poolId = allocator.addPool("default", numBytes);
+
+    const size_t kValueSize = 5000;
+    const int kNumItems = 10;
+    for (int i = 0; i < kNumItems; i++) {
+      auto handle = util::allocateAccessible(
+          allocator, poolId, folly::to<std::string>(i), kValueSize);
+      ASSERT_NE(nullptr, handle);
+      std::memset(handle->getMemory(), 'a' + i, kValueSize);
+    }
+    const auto cid = allocator.getPool(poolId).getAllocationClassId(
+        AllocatorT::Item::getRequiredSize("0", kValueSize));
+    ASSERT_EQ(kNumItems, allocator.compressColdItems(poolId, cid, 100));
+    // one item that is not compressed
+    ASSERT_NE(nullptr, util::allocateAccessible(allocator, poolId, "plain",
+                                                kValueSize));
+
+    auto checkValue = [&](const auto& handle, int i) {
+      ASSERT_NE(nullptr, handle);
+      EXPECT_FALSE(handle->isCompressed());
+      ASSERT_EQ(kValueSize, handle->getSize());
+      const auto* data = reinterpret_cast<const char*>(handle->getMemory());
+      EXPECT_EQ(std::string(kValueSize, 'a' + i),
+                std::string(data, kValueSize));
+    };
+
+    // inspecting a compressed item leaves it compressed in the cache
+    checkValue(allocator.inspectCache("0").first, 0);
+    EXPECT_EQ(0, allocator.getGlobalCacheStats().numItemsDecompressed);
+
+    std::vector<std::string> visited;
+    for (auto it = allocator.begin(); it != allocator.end(); ++it) {
+      EXPECT_FALSE(it->isCompressed());
+      visited.push_back(it->getKey().str());
+    }
+    EXPECT_EQ(std::vector<std::string>{"plain"}, visited);
+
+    int numSampled = 0;
+    for (int i = 0; i < 10000 && numSampled < 10; i++) {
+      auto sample = allocator.getSampleItem();
+      if (!sample.isValid() || sample->getKey() == "plain") {
+        continue;
+      }
+      ASSERT_FALSE(sample->isCompressed());
+      ASSERT_EQ(kValueSize, sample->getSize());
+      const auto* data = reinterpret_cast<const char*>(sample->getMemory());
+      const int key = folly::to<int>(sample->getKey());
+      EXPECT_EQ(std::string(kValueSize, 'a' + key),
+                std::string(data, kValueSize));
+      numSampled++;
+    }
+    EXPECT_GT(numSampled, 0);
+
+    // the replaced value is returned
+    auto handle = allocator.allocate(poolId, "1", kValueSize);
+    ASSERT_NE(nullptr, handle);
+    checkValue(allocator.insertOrReplace(handle), 1);
+
+    EXPECT_EQ(0, allocator.getGlobalCacheStats().numItemDecompressFailures);
+  }
+
+  // Compressed items are moved as they are when their slab is released, and
+  // read back inflated. The move callback never sees them.
+  void testItemCompressionSlabRelease() {
+    const int numSlabs = 4;
+
+    typename AllocatorT::Config config;
+    config.setCacheSize(numSlabs * Slab::kSize);
+    config.itemCompressionConfig.minValueSize = 1000;
+    int numMoveCbs = 0;
+    config.enableMovingOnSlabRelease(
+        [&numMoveCbs](typename AllocatorT::Item& oldItem,
+                      typename AllocatorT::Item& newItem,
+                      typename AllocatorT::Item* /* parentPtr */) {
+          numMoveCbs++;
+          std::memcpy(newItem.getMemory(), oldItem.getMemory(),
+                      oldItem.getSize());
+        });
+
+    AllocatorT allocator(config);
+    const size_t numBytes = allocator.getCacheMemoryStats().ramCacheSize;
+    auto poolId = allocator.addPool("default", numBytes);
+
+    const size_t kValueSize = 5000;
+    const int kNumItems = 10;
+    for (int i = 0; i < kNumItems; i++) {
+      auto handle = util::allocateAccessible(
+          allocator, poolId, folly::to<std::string>(i), kValueSize);
+      ASSERT_NE(nullptr, handle);
+      std::memset(handle->getMemory(), 'a' + i, kValueSize);
+    }
+    const auto cid = allocator.getPool(poolId).getAllocationClassId(
+        AllocatorT::Item::getRequiredSize("0", kValueSize));
+    ASSERT_EQ(kNumItems, allocator.compressColdItems(poolId, cid, 100));
+
+    // the compressed items are the only allocations in a smaller class
+    ClassId compressedCid = Slab::kInvalidClassId;
+    const auto poolStats = allocator.getPoolStats(poolId);
+    for (const auto& [id, acStats] : poolStats.mpStats.acStats) {
+      if (id != cid && acStats.activeAllocs > 0) {
+        compressedCid = id;
+      }
+    }
+    ASSERT_NE(Slab::kInvalidClassId, compressedCid);
+
+    // there is free memory in the pool for the destination of the moves
+    allocator.releaseSlab(poolId, compressedCid, SlabReleaseMode::kRebalance);
+    const auto releaseStats = allocator.getSlabReleaseStats();
+    EXPECT_EQ(kNumItems, releaseStats.numMoveSuccesses);
+    EXPECT_EQ(0, releaseStats.numEvictionSuccesses);
+    EXPECT_EQ(0, numMoveCbs);
+
+    for (int i = 0; i < kNumItems; i++) {
+      auto handle = allocator.find(folly::to<std::string>(i));
+      ASSERT_NE(nullptr, handle);
+      EXPECT_FALSE(handle->isCompressed());
+      ASSERT_EQ(kValueSize, handle->getSize());
+      const auto* data = reinterpret_cast<const char*>(handle->getMemory());
+      EXPECT_EQ(std::string(kValueSize, 'a' + i),
+                std::string(data, kValueSize));
+    }
+    EXPECT_EQ(kNumItems,
+              allocator.getGlobalCacheStats().numItemsDecompressed);
+  }
+
+  void testContentSampling() {
+    const int numSlabs = 4;
+
+    typename AllocatorT::Config config;
+    config.setCacheSize(numSlabs * Slab::kSize);
+    config.enableContentSampling(std::chrono::milliseconds{50},
+                                 {.samplesPerRun = 1000});
+
+    AllocatorT allocator(config);
+    const size_t numBytes = allocator.getCacheMemoryStats().ramCacheSize;
+    auto poolId = allocator.addPool("default", numBytes);
+
+    const size_t kValueSize = 1000;
+    const uint32_t kTTLSecs = 3600;
+    for (int i = 0; i < 1000; i++) {
+      auto handle = util::allocateAccessible(
+          allocator, poolId, folly::to<std::string>(i), kValueSize, kTTLSecs);
+      ASSERT_NE(nullptr, handle);
+    }
+    const auto cid = allocator.getPool(poolId).getAllocationClassId(
+        AllocatorT::Item::getRequiredSize("0", kValueSize));
+
+    ContentSamplingConfig samplingConfig;
+    samplingConfig.samplesPerRun = 20000;
+    samplingConfig.throttlerConfig =
+        util::Throttler::Config::makeNoThrottleConfig();
+    auto report = allocator.sampleContent(samplingConfig);
+    EXPECT_EQ(20000, report.numSamples);
+    ASSERT_EQ(1, report.poolStats.size());
+    const auto& pool = report.poolStats[poolId];
+    EXPECT_EQ("default", pool.poolName);
+    ASSERT_EQ(1, pool.classStats.count(cid));
+
+    // one slab is allocated to the class out of the whole cache, which the
+    // items fill partially
+    const auto& stats = pool.classStats.at(cid);
+    EXPECT_EQ(Slab::kSize, stats.memorySize);
+    EXPECT_GT(stats.numSamples, 0);
+    EXPECT_GT(stats.numItems, 0);
+    EXPECT_LE(stats.numItems, stats.numSamples);
+    EXPECT_EQ(0, stats.numExpired);
+    EXPECT_EQ(stats.numItems, stats.ttlRemainingSecs.total());
+    EXPECT_EQ(4095, stats.ttlRemainingSecs.percentile(0.99));
+    EXPECT_GE(stats.itemSizeBytes.percentile(0.5), kValueSize);
+    EXPECT_LE(stats.ageSecs.percentile(0.99), 3);
+    EXPECT_GT(stats.deadBytes(), 0);
+    EXPECT_LE(stats.deadBytes(), stats.memorySize);
+    EXPECT_EQ(stats.numItems, pool.aggregate().numItems);
+
+    samplingConfig.samplesPerRun = 0;
+    EXPECT_THROW(allocator.sampleContent(samplingConfig),
+                 std::invalid_argument);
+
+    // the background sampler keeps the last report and exports it
+    while (allocator.getContentStats().sampleTime == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    bool exported = false;
+    allocator.exportStats("cachelib.", std::chrono::seconds{60},
+                          [&exported](auto name, auto) {
+                            if (name == "cachelib.pool.default.content.items") {
+                              exported = true;
+                            }
+                          });
+    EXPECT_TRUE(exported);
+    EXPECT_TRUE(allocator.stopContentSampler(std::chrono::seconds{1}));
+  }
+
   void testReaperOutOfBound() {
     // This test is to test a reaper will not crash when it is checking the last
     // item in a slab and it happens to have a large key beyond the end of cache
@@ -25,6 +25,8 @@ using MM2QTest = MMTypeTest<MM2Q>;
 
 TEST_F(MM2QTest, AddBasic) { testAddBasic(MM2Q::Config{}); }
 
+TEST_F(MM2QTest, AddBatch) { testAddBatch(MM2Q::Config{}); }
+
 TEST_F(MM2QTest, RemoveBasic) { testRemoveBasic(MM2Q::Config{}); }
 
 TEST_F(MM2QTest, RemoveWithSmallQueues) {
@@ -26,6 +26,8 @@ using MMLruTest = MMTypeTest<MMLru>;
 
 TEST_F(MMLruTest, AddBasic) { testAddBasic(MMLru::Config{}); }
 
+TEST_F(MMLruTest, AddBatch) { testAddBatch(MMLru::Config{}); }
+
 TEST_F(MMLruTest, RemoveBasic) { testRemoveBasic(MMLru::Config{}); }
 
 TEST_F(MMLruTest, RecordAccessBasic) {
@@ -580,5 +582,89 @@ TEST_F(MMLruTest, CombinedLockingIteration) {
     ASSERT_FALSE(node->isInMMContainer());
   }
 }
+
+TEST_F(MMLruTest, TtlBand) {
+  MMLru::Config config;
+  config.lruRefreshTime = 0;
+  config.ttlBandSecs = 10;
+  Container c(config, {});
+  std::vector<std::unique_ptr<Node>> nodes;
+  for (int i = 0; i < 9; i++) {
+    nodes.emplace_back(new Node{i});
+  }
+  // nodes 4 to 7 have a TTL short enough for the band, node 8 does not
+  for (int i = 4; i < 8; i++) {
+    nodes[i]->setTTL(5);
+  }
+  nodes[8]->setTTL(100);
+  for (int i = 0; i < 4; i++) {
+    ASSERT_TRUE(c.add(*nodes[i]));
+  }
+  for (int i = 4; i < 9; i++) {
+    ASSERT_TRUE(c.add(*nodes[i]));
+  }
+  ASSERT_EQ(9, c.size());
+  ASSERT_EQ(4, c.getTtlBandSize());
+  ASSERT_EQ(9, c.getStats().size);
+
+  auto getEvictionOrder = [&c]() {
+    std::vector<int> order;
+    for (auto it = c.getEvictionIterator(); it; ++it) {
+      order.push_back(it->getId());
+    }
+    return order;
+  };
+
+  const auto now = static_cast<uint32_t>(util::getCurrentTimeSec());
+  auto setUpdateTimes = [&](uint32_t lruTime, uint32_t bandTime) {
+    for (int i = 0; i < 9; i++) {
+      nodes[i]->setUpdateTime(i >= 4 && i < 8 ? bandTime : lruTime);
+    }
+  };
+
+  // the band expires before the lru tail would age out
+  setUpdateTimes(now - 100, now);
+  EXPECT_EQ(std::vector<int>({4, 5, 6, 7, 0, 1, 2, 3, 8}), getEvictionOrder());
+
+  // the lru tail is older and the band is not about to expire
+  setUpdateTimes(now - 1, now);
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 8, 4, 5, 6, 7}), getEvictionOrder());
+
+  // the band tail is older
+  setUpdateTimes(now, now - 1);
+  EXPECT_EQ(std::vector<int>({4, 5, 6, 7, 0, 1, 2, 3, 8}), getEvictionOrder());
+  verifyIterationVariants(c);
+
+  // promotion keeps the node in the band
+  setUpdateTimes(now - 1, now);
+  ASSERT_TRUE(c.recordAccess(*nodes[4], AccessMode::kRead));
+  EXPECT_EQ(4, c.getTtlBandSize());
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 8, 5, 6, 7, 4}), getEvictionOrder());
+
+  // only the expired nodes at the tail of the band are reported
+  nodes[5]->setExpiryTime(now - 10);
+  nodes[6]->setExpiryTime(now - 10);
+  nodes[4]->setExpiryTime(now - 10);
+  EXPECT_EQ(std::vector<std::string>({nodes[5]->getKey().str(),
+                                      nodes[6]->getKey().str()}),
+            c.getExpiredTtlBandKeys(10));
+  EXPECT_EQ(std::vector<std::string>({nodes[5]->getKey().str()}),
+            c.getExpiredTtlBandKeys(1));
+
+  // the band survives a restore
+  Container c2(c.saveState(), {});
+  EXPECT_EQ(9, c2.size());
+  EXPECT_EQ(4, c2.getTtlBandSize());
+  EXPECT_EQ(10, c2.getConfig().ttlBandSecs);
+
+  ASSERT_TRUE(c.remove(*nodes[5]));
+  EXPECT_EQ(3, c.getTtlBandSize());
+  EXPECT_FALSE(nodes[5]->isFlagSet<Node::kMMFlag2>());
+  for (auto it = c.getEvictionIterator(); it;) {
+    c.remove(it);
+  }
+  EXPECT_EQ(0, c.size());
+  EXPECT_EQ(0, c.getTtlBandSize());
+}
 } // namespace cachelib
 } // namespace facebook
@@ -26,6 +26,8 @@ using MMTinyLFUTest = MMTypeTest<MMTinyLFU>;
 
 TEST_F(MMTinyLFUTest, AddBasic) { testAddBasic(MMTinyLFU::Config{}); }
 
+TEST_F(MMTinyLFUTest, AddBatch) { testAddBatch(MMTinyLFU::Config{}); }
+
 TEST_F(MMTinyLFUTest, RemoveBasic) { testRemoveBasic(MMTinyLFU::Config{}); }
 
 TEST_F(MMTinyLFUTest, RecordAccessBasic) {
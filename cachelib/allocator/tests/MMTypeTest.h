@@ -83,6 +83,28 @@ class MMTypeTest : public testing::Test {
 
     bool isTail() { return isFlagSet<kMMFlag0>(); }
 
+    // Mock TTL, only used by the containers supporting TTL bands
+    void setTTL(uint32_t ttlSecs) noexcept {
+      ttlSecs_ = ttlSecs;
+      expiryTime_ =
+          ttlSecs == 0 ? 0 : static_cast<uint32_t>(util::getCurrentTimeSec()) +
+                                 ttlSecs;
+    }
+
+    std::chrono::seconds getConfiguredTTL() const noexcept {
+      return std::chrono::seconds(ttlSecs_);
+    }
+
+    uint32_t getExpiryTime() const noexcept { return expiryTime_; }
+
+    void setExpiryTime(uint32_t expiryTime) noexcept {
+      expiryTime_ = expiryTime;
+    }
+
+    bool isExpired(uint32_t currentTimeSec) const noexcept {
+      return expiryTime_ > 0 && expiryTime_ < currentTimeSec;
+    }
+
     bool isInMMContainer() const noexcept { return inContainer_; }
 
    protected:
@@ -128,6 +150,8 @@ class MMTypeTest : public testing::Test {
     std::string key_;
     bool inContainer_{false};
     uint8_t flags_{0};
+    uint32_t ttlSecs_{0};
+    uint32_t expiryTime_{0};
     friend typename MMType::template Container<Node, &Node::mmHook_>;
     friend class MMTypeTest<MMType>;
   };
@@ -143,6 +167,7 @@ class MMTypeTest : public testing::Test {
   void testAddBasic(Container& c, std::vector<std::unique_ptr<Node>>& nodes);
 
   void testAddBasic(Config c);
+  void testAddBatch(Config c);
   void testRemoveBasic(Config c);
   void testRecordAccessBasic(Config c);
   void testSerializationBasic(Config c);
@@ -205,6 +230,44 @@ void MMTypeTest<MMType>::testAddBasic(Config config) {
   testAddBasic(c, nodes);
 }
 
+template <typename MMType>
+void MMTypeTest<MMType>::testAddBatch(Config config) {
+  Container c(config, {});
+  std::vector<std::unique_ptr<Node>> nodes;
+  std::vector<Node*> batch;
+  for (int i = 0; i < 10; i++) {
+    nodes.emplace_back(new Node{i});
+    batch.push_back(nodes.back().get());
+  }
+  ASSERT_EQ(10, c.addBatch(batch.begin(), batch.end()));
+  for (auto& node : nodes) {
+    ASSERT_TRUE(node->isInMMContainer());
+  }
+  ASSERT_EQ(10, c.size());
+
+  // nodes already in the container are skipped
+  for (int i = 10; i < 15; i++) {
+    nodes.emplace_back(new Node{i});
+    batch.push_back(nodes.back().get());
+  }
+  ASSERT_EQ(5, c.addBatch(batch.begin(), batch.end()));
+  ASSERT_EQ(0, c.addBatch(batch.begin(), batch.end()));
+  ASSERT_EQ(0, c.addBatch(batch.end(), batch.end()));
+
+  std::set<int> foundNodes;
+  for (auto itr = c.getEvictionIterator(); itr; ++itr) {
+    foundNodes.insert(itr->getId());
+  }
+  EXPECT_EQ(nodes.size(), foundNodes.size());
+  EXPECT_EQ(nodes.size(), c.getStats().size);
+  verifyIterationVariants(c);
+
+  for (auto& node : nodes) {
+    ASSERT_TRUE(c.remove(*node));
+  }
+  ASSERT_EQ(0, c.size());
+}
+
 template <typename MMType>
 void MMTypeTest<MMType>::testRemoveBasic(Config config) {
   Container c(config, {});
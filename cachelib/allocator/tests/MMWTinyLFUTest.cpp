@@ -26,6 +26,8 @@ using MMWTinyLFUTest = MMTypeTest<MMWTinyLFU>;
 
 TEST_F(MMWTinyLFUTest, AddBasic) { testAddBasic(MMWTinyLFU::Config{}); }
 
+TEST_F(MMWTinyLFUTest, AddBatch) { testAddBatch(MMWTinyLFU::Config{}); }
+
 TEST_F(MMWTinyLFUTest, RemoveBasic) { testRemoveBasic(MMWTinyLFU::Config{}); }
 
 TEST_F(MMWTinyLFUTest, RecordAccessBasic) {
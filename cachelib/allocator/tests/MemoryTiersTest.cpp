@@ -15,7 +15,9 @@
  */
 
 #include <folly/Random.h>
+#include <folly/ScopeGuard.h>
 
+#include <cstring>
 #include <numeric>
 
 #include "cachelib/allocator/CacheAllocator.h"
@@ -172,6 +174,65 @@ TEST_F(LruMemoryTiersTest, TestInvalid2TierConfigRatioNotSet) {
 TEST_F(LruMemoryTiersTest, TestInvalid2TierConfigSizesNeCacheSize) {
   EXPECT_THROW(createTestCacheConfig({0, 0}), std::invalid_argument);
 }
+
+TEST_F(LruMemoryTiersTest, TestInvalidFileTierConfig) {
+  EXPECT_THROW(MemoryTierCacheConfig::fromFile(""), std::invalid_argument);
+
+  // file backed tiers need the cache to be on shared memory
+  LruAllocatorConfig cfg;
+  cfg.setCacheSize(defaultTotalCacheSize)
+      .configureMemoryTiers({MemoryTierCacheConfig::fromFile("/tmp/tier")});
+  EXPECT_THROW(cfg.validate(), std::invalid_argument);
+  EXPECT_THROW(LruAllocator{cfg}, std::invalid_argument);
+
+  // and can not be bound to numa nodes
+  cfg.enableCachePersistence(defaultCacheDir);
+  EXPECT_NO_THROW(cfg.validate());
+  cfg.configureMemoryTiers({MemoryTierCacheConfig::fromFile("/tmp/tier")
+                                .setMemBind(std::string("0"))});
+  EXPECT_THROW(cfg.validate(), std::invalid_argument);
+}
+
+TEST_F(LruMemoryTiersTest, TestFileTierPersistence) {
+  const size_t nSlabs = 20;
+  const std::string tierFile = this->cacheDir_ + "-tier";
+  SCOPE_EXIT { util::removePath(tierFile); };
+
+  LruAllocatorConfig cfg;
+  cfg.setCacheSize(nSlabs * Slab::kSize)
+      .enableCachePersistence(this->cacheDir_)
+      .configureMemoryTiers({MemoryTierCacheConfig::fromFile(tierFile)});
+
+  const std::string value = "value";
+  {
+    LruAllocator alloc(LruAllocator::SharedMemNew, cfg);
+    ASSERT_TRUE(util::getStatIfExists(tierFile, nullptr));
+    const auto pid = alloc.addPool(
+        "default", alloc.getCacheMemoryStats().ramCacheSize);
+    auto handle = alloc.allocate(pid, "key", value.size());
+    ASSERT_NE(nullptr, handle);
+    std::memcpy(handle->getMemory(), value.data(), value.size());
+    alloc.insertOrReplace(handle);
+    handle.reset();
+    ASSERT_EQ(LruAllocator::ShutDownStatus::kSuccess, alloc.shutDown());
+  }
+
+  {
+    LruAllocator alloc(LruAllocator::SharedMemAttach, cfg);
+    auto handle = alloc.find("key");
+    ASSERT_NE(nullptr, handle);
+    EXPECT_EQ(value, folly::StringPiece(
+                         reinterpret_cast<const char*>(handle->getMemory()),
+                         handle->getSize()));
+    handle.reset();
+    ASSERT_EQ(LruAllocator::ShutDownStatus::kSuccess, alloc.shutDown());
+  }
+
+  // attaching with a different backing file fails
+  cfg.configureMemoryTiers({MemoryTierCacheConfig::fromShm()});
+  EXPECT_THROW(LruAllocator(LruAllocator::SharedMemAttach, cfg),
+               std::invalid_argument);
+}
 } // namespace tests
 } // namespace cachelib
 } // namespace facebook
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "cachelib/allocator/CacheAllocator.h"
+#include "cachelib/allocator/ValueDedup.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+
+using AllocatorT = LruAllocator;
+using Dedup = ValueDedup<AllocatorT>;
+
+class ValueDedupTest : public testing::Test {
+ public:
+  ValueDedupTest() {
+    AllocatorT::Config config;
+    config.setCacheSize(100 * Slab::kSize);
+    config.setRemoveCallback(
+        [this](const AllocatorT::RemoveCbData& data) {
+          if (dedup_) {
+            dedup_->onRemove(data);
+          }
+        });
+    cache_ = std::make_unique<AllocatorT>(config);
+    const auto poolSize = cache_->getCacheMemoryStats().ramCacheSize / 2;
+    pid_ = cache_->addPool("default", poolSize);
+    otherPid_ = cache_->addPool("other", poolSize);
+    Dedup::Config dedupConfig;
+    dedupConfig.minValueSize = 100;
+    dedup_ = std::make_unique<Dedup>(*cache_, pid_, dedupConfig);
+  }
+
+  ~ValueDedupTest() override {
+    // drop the cache first so that its remove callbacks still see the dedup
+    cache_.reset();
+    dedup_.reset();
+  }
+
+ protected:
+  static folly::ByteRange toRange(const std::string& s) {
+    return folly::StringPiece{s};
+  }
+
+  std::string getValue(const std::string& key) {
+    auto res = dedup_->find(key);
+    if (!res) {
+      return "";
+    }
+    return folly::StringPiece{res.value}.str();
+  }
+
+  std::unique_ptr<AllocatorT> cache_;
+  PoolId pid_;
+  // pool not managed by dedup_
+  PoolId otherPid_;
+  std::unique_ptr<Dedup> dedup_;
+};
+
+TEST_F(ValueDedupTest, SmallValuesInline) {
+  const std::string value(10, 'a');
+  ASSERT_TRUE(dedup_->insertOrReplace("key1", toRange(value)));
+  ASSERT_TRUE(dedup_->insertOrReplace("key2", toRange(value)));
+  EXPECT_EQ(value, getValue("key1"));
+  EXPECT_EQ(value, getValue("key2"));
+
+  ASSERT_TRUE(dedup_->insertOrReplace("empty", folly::ByteRange{}));
+  auto res = dedup_->find("empty");
+  ASSERT_TRUE(res);
+  EXPECT_TRUE(res.value.empty());
+
+  const auto stats = dedup_->getStats();
+  EXPECT_EQ(0u, stats.numPayloads);
+  EXPECT_EQ(0u, stats.logicalBytes);
+  EXPECT_EQ(0u, stats.numDedupHits);
+}
+
+TEST_F(ValueDedupTest, SharePayload) {
+  const std::string value(1000, 'a');
+  for (int i = 0; i < 10; i++) {
+    ASSERT_TRUE(
+        dedup_->insertOrReplace(folly::sformat("key{}", i), toRange(value)));
+  }
+  for (int i = 0; i < 10; i++) {
+    EXPECT_EQ(value, getValue(folly::sformat("key{}", i)));
+  }
+
+  auto stats = dedup_->getStats();
+  EXPECT_EQ(1u, stats.numPayloads);
+  EXPECT_EQ(1u, stats.numDedupMisses);
+  EXPECT_EQ(9u, stats.numDedupHits);
+  EXPECT_EQ(10000u, stats.logicalBytes);
+  EXPECT_EQ(1000u, stats.storedBytes);
+  EXPECT_EQ(9000u, stats.bytesSaved());
+  EXPECT_DOUBLE_EQ(10.0, stats.dedupRatio());
+
+  // a different value gets its own payload
+  const std::string other(1000, 'b');
+  ASSERT_TRUE(dedup_->insertOrReplace("key0", toRange(other)));
+  EXPECT_EQ(other, getValue("key0"));
+  EXPECT_EQ(value, getValue("key1"));
+  stats = dedup_->getStats();
+  EXPECT_EQ(2u, stats.numPayloads);
+  EXPECT_EQ(2000u, stats.storedBytes);
+  EXPECT_EQ(10000u, stats.logicalBytes);
+}
+
+TEST_F(ValueDedupTest, PayloadFreedWithLastRef) {
+  const std::string value(1000, 'a');
+  ASSERT_TRUE(dedup_->insertOrReplace("key1", toRange(value)));
+  ASSERT_TRUE(dedup_->insertOrReplace("key2", toRange(value)));
+  EXPECT_EQ(1u, dedup_->getStats().numPayloads);
+
+  dedup_->remove("key1");
+  EXPECT_EQ("", getValue("key1"));
+  EXPECT_EQ(value, getValue("key2"));
+  EXPECT_EQ(1u, dedup_->getStats().numPayloads);
+
+  // replacing the last reference with an inline value frees the payload
+  ASSERT_TRUE(dedup_->insertOrReplace("key2", toRange("small")));
+  EXPECT_EQ("small", getValue("key2"));
+
+  const auto stats = dedup_->getStats();
+  EXPECT_EQ(0u, stats.numPayloads);
+  EXPECT_EQ(0u, stats.storedBytes);
+  EXPECT_EQ(0u, stats.logicalBytes);
+}
+
+TEST_F(ValueDedupTest, LookupHoldsPayload) {
+  const std::string value(1000, 'a');
+  ASSERT_TRUE(dedup_->insertOrReplace("key", toRange(value)));
+  auto res = dedup_->find("key");
+  ASSERT_TRUE(res);
+
+  // the value stays readable through the result after the key is gone
+  dedup_->remove("key");
+  EXPECT_EQ(value, folly::StringPiece{res.value}.str());
+  res = {};
+  EXPECT_EQ(0u, dedup_->getStats().numPayloads);
+}
+
+TEST_F(ValueDedupTest, EvictedPayload) {
+  const std::string value(1000, 'a');
+  ASSERT_TRUE(dedup_->insertOrReplace("key1", toRange(value)));
+  ASSERT_TRUE(dedup_->insertOrReplace("key2", toRange(value)));
+
+  // simulate the payload being evicted while still referenced
+  for (auto it = cache_->begin(); it != cache_->end(); ++it) {
+    if (Dedup::isPayloadKey(it->getKey())) {
+      cache_->remove(it);
+    }
+  }
+
+  EXPECT_EQ("", getValue("key1"));
+  EXPECT_EQ(1u, dedup_->getStats().numDanglingRefs);
+  // stale key is dropped
+  EXPECT_FALSE(cache_->find("key1"));
+
+  // storing the value again creates a fresh payload
+  ASSERT_TRUE(dedup_->insertOrReplace("key1", toRange(value)));
+  EXPECT_EQ(value, getValue("key1"));
+  EXPECT_EQ(1u, dedup_->getStats().numPayloads);
+}
+
+TEST_F(ValueDedupTest, StaleRefAfterEviction) {
+  const std::string value(1000, 'a');
+  ASSERT_TRUE(dedup_->insertOrReplace("key1", toRange(value)));
+  ASSERT_TRUE(dedup_->insertOrReplace("key2", toRange(value)));
+
+  // simulate the payload being evicted while still referenced
+  for (auto it = cache_->begin(); it != cache_->end(); ++it) {
+    if (Dedup::isPayloadKey(it->getKey())) {
+      cache_->remove(it);
+    }
+  }
+
+  // the same value is stored again under the same payload key
+  ASSERT_TRUE(dedup_->insertOrReplace("key3", toRange(value)));
+  EXPECT_EQ(1u, dedup_->getStats().numPayloads);
+
+  // the old references do not resolve to, nor release, the new payload
+  EXPECT_EQ("", getValue("key1"));
+  dedup_->remove("key2");
+  EXPECT_EQ(value, getValue("key3"));
+  EXPECT_EQ(1u, dedup_->getStats().numPayloads);
+
+  dedup_->remove("key3");
+  EXPECT_EQ(0u, dedup_->getStats().numPayloads);
+}
+TEST_F(ValueDedupTest, OtherPoolsIgnored) {
+  const std::string value(1000, 'a');
+  ASSERT_TRUE(dedup_->insertOrReplace("key1", toRange(value)));
+  ASSERT_TRUE(dedup_->insertOrReplace("key2", toRange(value)));
+
+  // items of another pool carrying the bytes of a dedup reference, and a
+  // payload key, must not touch the payloads or the stats when removed.
+  std::string refBytes;
+  {
+    auto handle = cache_->find("key1");
+    ASSERT_NE(nullptr, handle);
+    refBytes.assign(reinterpret_cast<const char*>(handle->getMemory()),
+                    handle->getSize());
+  }
+  std::string payloadKey;
+  for (auto it = cache_->begin(); it != cache_->end(); ++it) {
+    if (Dedup::isPayloadKey(it->getKey())) {
+      payloadKey = it->getKey().str();
+    }
+  }
+  ASSERT_FALSE(payloadKey.empty());
+  for (const auto& key : {std::string{"otherKey"}, payloadKey + "x"}) {
+    auto handle = cache_->allocate(otherPid_, key, refBytes.size());
+    ASSERT_NE(nullptr, handle);
+    std::memcpy(handle->getMemory(), refBytes.data(), refBytes.size());
+    cache_->insertOrReplace(handle);
+    handle.reset();
+    cache_->remove(key);
+  }
+
+  auto stats = dedup_->getStats();
+  EXPECT_EQ(1u, stats.numPayloads);
+  EXPECT_EQ(2000u, stats.logicalBytes);
+  EXPECT_EQ(1000u, stats.storedBytes);
+  EXPECT_EQ(value, getValue("key1"));
+  EXPECT_EQ(value, getValue("key2"));
+
+  dedup_->remove("key1");
+  EXPECT_EQ(value, getValue("key2"));
+  EXPECT_EQ(1u, dedup_->getStats().numPayloads);
+  dedup_->remove("key2");
+  EXPECT_EQ(0u, dedup_->getStats().numPayloads);
+}
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
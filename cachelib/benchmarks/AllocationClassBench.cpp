@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures allocate/free throughput of an allocation class once it is full
+// and churning through freed allocations, and the cost of starting a slab
+// release with many free allocations spread across the class.
+
+#include <folly/Benchmark.h>
+#include <folly/Random.h>
+#include <folly/init/Init.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "cachelib/allocator/memory/MemoryAllocator.h"
+
+using namespace facebook::cachelib;
+
+namespace {
+constexpr size_t kNumSlabs = 64;
+constexpr uint32_t kAllocSize = 128;
+
+std::unique_ptr<MemoryAllocator> makeAllocator(PoolId& pid) {
+  MemoryAllocator::Config c({kAllocSize}, false /* enableZeroedSlabAllocs */,
+                            true /* disableCoredump */,
+                            false /* lockMemory */);
+  auto m = std::make_unique<MemoryAllocator>(c, (kNumSlabs + 2) * Slab::kSize);
+  pid = m->addPool("bench", kNumSlabs * Slab::kSize);
+  return m;
+}
+
+std::vector<void*> fill(MemoryAllocator& m, PoolId pid) {
+  std::vector<void*> allocs;
+  while (auto alloc = m.allocate(pid, kAllocSize)) {
+    allocs.push_back(alloc);
+  }
+  return allocs;
+}
+} // namespace
+
+// free a random allocation and allocate again, with the class full.
+BENCHMARK(AllocFreeChurn, iters) {
+  PoolId pid;
+  std::unique_ptr<MemoryAllocator> m;
+  std::vector<void*> allocs;
+  BENCHMARK_SUSPEND {
+    m = makeAllocator(pid);
+    allocs = fill(*m, pid);
+  }
+
+  for (size_t i = 0; i < iters; i++) {
+    auto& slot = allocs[folly::Random::rand32(allocs.size())];
+    m->free(slot);
+    slot = m->allocate(pid, kAllocSize);
+    folly::doNotOptimizeAway(slot);
+  }
+}
+
+// free a random 10% of the allocations and allocate them back.
+BENCHMARK(AllocFreeBatch, iters) {
+  PoolId pid;
+  std::unique_ptr<MemoryAllocator> m;
+  std::vector<void*> allocs;
+  BENCHMARK_SUSPEND {
+    m = makeAllocator(pid);
+    allocs = fill(*m, pid);
+  }
+
+  const size_t batch = allocs.size() / 10;
+  for (size_t i = 0; i < iters; i++) {
+    BENCHMARK_SUSPEND {
+      std::shuffle(allocs.begin(), allocs.end(), folly::ThreadLocalPRNG());
+    }
+    for (size_t j = 0; j < batch; j++) {
+      m->free(allocs[j]);
+    }
+    for (size_t j = 0; j < batch; j++) {
+      allocs[j] = m->allocate(pid, kAllocSize);
+    }
+  }
+}
+
+// start and abort a slab release while half of all allocations are free.
+BENCHMARK(StartSlabReleaseHalfFree, iters) {
+  PoolId pid;
+  std::unique_ptr<MemoryAllocator> m;
+  BENCHMARK_SUSPEND {
+    m = makeAllocator(pid);
+    auto allocs = fill(*m, pid);
+    for (size_t i = 0; i < allocs.size(); i += 2) {
+      m->free(allocs[i]);
+    }
+  }
+
+  const auto cid = m->getAllocationClassId(pid, kAllocSize);
+  for (size_t i = 0; i < iters; i++) {
+    auto ctx = m->startSlabRelease(pid, cid, Slab::kInvalidClassId,
+                                   SlabReleaseMode::kRebalance);
+    folly::doNotOptimizeAway(ctx.getActiveAllocations().size());
+    BENCHMARK_SUSPEND { m->abortSlabRelease(ctx); }
+  }
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares reading allocations of a chain through getNthInChain, which walks
+// the chain up to the position, with the index built by indexChain(). The
+// index costs a walk of the whole chain and a vector allocation per view, so
+// it only pays off when a view reads several random positions. Reading the
+// first allocation through a fresh view is measured both ways as well.
+
+#include <folly/Benchmark.h>
+#include <folly/Random.h>
+#include <folly/init/Init.h>
+
+#include <vector>
+
+#include "cachelib/allocator/CacheAllocator.h"
+
+using namespace facebook::cachelib;
+
+DEFINE_uint32(chain_length, 1024, "Number of allocations chained to the key");
+DEFINE_uint32(num_positions, 1024, "Number of random positions to read");
+
+namespace {
+constexpr uint32_t kChainedAllocSize = 1000;
+
+std::unique_ptr<LruAllocator> cache;
+LruAllocator::ReadHandle parent;
+std::vector<uint32_t> positions;
+
+void buildChain() {
+  LruAllocator::Config config;
+  config.setCacheSize(
+      (FLAGS_chain_length * kChainedAllocSize / Slab::kSize + 10) *
+      Slab::kSize);
+  config.configureChainedItems();
+  cache = std::make_unique<LruAllocator>(config);
+  const auto pid =
+      cache->addPool("default", cache->getCacheMemoryStats().ramCacheSize);
+
+  auto handle = cache->allocate(pid, "parent", 100);
+  XCHECK(handle);
+  for (uint32_t i = 0; i < FLAGS_chain_length; i++) {
+    auto child = cache->allocateChainedItem(handle, kChainedAllocSize);
+    XCHECK(child);
+    cache->addChainedItem(handle, std::move(child));
+  }
+  cache->insertOrReplace(handle);
+  parent = std::move(handle);
+
+  for (uint32_t i = 0; i < FLAGS_num_positions; i++) {
+    positions.push_back(folly::Random::rand32(FLAGS_chain_length));
+  }
+}
+} // namespace
+
+BENCHMARK(WalkToNthPerView) {
+  for (auto n : positions) {
+    auto allocs = cache->viewAsChainedAllocs(parent);
+    folly::doNotOptimizeAway(allocs.getNthInChain(n));
+  }
+}
+
+BENCHMARK_RELATIVE(IndexedNthPerView) {
+  for (auto n : positions) {
+    auto allocs = cache->viewAsChainedAllocs(parent);
+    allocs.indexChain();
+    folly::doNotOptimizeAway(allocs.getNthInChain(n));
+  }
+}
+
+BENCHMARK_RELATIVE(WalkToNthSameView) {
+  auto allocs = cache->viewAsChainedAllocs(parent);
+  for (auto n : positions) {
+    folly::doNotOptimizeAway(allocs.getNthInChain(n));
+  }
+}
+
+BENCHMARK_RELATIVE(IndexedNthSameView) {
+  auto allocs = cache->viewAsChainedAllocs(parent);
+  allocs.indexChain();
+  for (auto n : positions) {
+    folly::doNotOptimizeAway(allocs.getNthInChain(n));
+  }
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(FirstPerView) {
+  for (size_t i = 0; i < positions.size(); i++) {
+    auto allocs = cache->viewAsChainedAllocs(parent);
+    folly::doNotOptimizeAway(allocs.getNthInChain(0));
+  }
+}
+
+BENCHMARK_RELATIVE(IndexedFirstPerView) {
+  for (size_t i = 0; i < positions.size(); i++) {
+    auto allocs = cache->viewAsChainedAllocs(parent);
+    allocs.indexChain();
+    folly::doNotOptimizeAway(allocs.getNthInChain(0));
+  }
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  buildChain();
+  folly::runBenchmarks();
+  parent.reset();
+  cache.reset();
+  return 0;
+}
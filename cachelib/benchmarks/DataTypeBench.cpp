@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares a cachelib::SortedSet against the common alternative of keeping
+// a leaderboard as a sorted blob in a regular item, which is rewritten on
+// every update.
+
+#include <folly/Benchmark.h>
+#include <folly/Random.h>
+#include <folly/init/Init.h>
+#include <gflags/gflags.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+#include "cachelib/allocator/CacheAllocator.h"
+#include "cachelib/datatype/SortedSet.h"
+
+using namespace facebook::cachelib;
+
+DEFINE_uint32(num_members, 1000, "number of members of the leaderboard");
+DEFINE_uint32(max_score, 1'000'000, "scores are drawn from [0, max_score)");
+
+namespace {
+using SortedSetT = SortedSet<uint64_t, uint32_t, LruAllocator>;
+
+constexpr folly::StringPiece kSetKey = "sorted_set";
+constexpr folly::StringPiece kBlobKey = "sorted_blob";
+
+// Entry of the sorted blob, ordered by score then member like the set
+struct FOLLY_PACK_ATTR BlobEntry {
+  uint32_t score;
+  uint64_t member;
+
+  bool operator<(const BlobEntry& other) const {
+    return score != other.score ? score < other.score : member < other.member;
+  }
+};
+
+std::unique_ptr<LruAllocator> createCache() {
+  LruAllocator::Config config;
+  config.configureChainedItems();
+  config.setCacheSize(1024 * Slab::kSize);
+  auto cache = std::make_unique<LruAllocator>(config);
+  cache->addPool("default", cache->getCacheMemoryStats().ramCacheSize);
+  return cache;
+}
+
+uint32_t randomScore() { return folly::Random::rand32(FLAGS_max_score); }
+
+uint64_t randomMember() { return folly::Random::rand32(FLAGS_num_members); }
+
+void fillSortedSet(LruAllocator& cache) {
+  auto ss = SortedSetT::create(cache, 0, kSetKey);
+  for (uint64_t member = 0; member < FLAGS_num_members; member++) {
+    ss.insertOrUpdate(member, randomScore());
+  }
+  cache.insertOrReplace(ss.viewWriteHandle());
+}
+
+void fillBlob(LruAllocator& cache) {
+  std::vector<BlobEntry> entries;
+  for (uint64_t member = 0; member < FLAGS_num_members; member++) {
+    entries.push_back(BlobEntry{randomScore(), member});
+  }
+  std::sort(entries.begin(), entries.end());
+  const auto size = entries.size() * sizeof(BlobEntry);
+  auto handle = cache.allocate(0, kBlobKey, size);
+  std::memcpy(handle->getMemory(), entries.data(), size);
+  cache.insertOrReplace(handle);
+}
+
+// Move the member to the score by rewriting the whole blob into a new item
+void updateBlob(LruAllocator& cache, uint64_t member, uint32_t score) {
+  auto handle = cache.findToWrite(kBlobKey);
+  const auto* begin = reinterpret_cast<const BlobEntry*>(handle->getMemory());
+  const auto* end = begin + handle->getSize() / sizeof(BlobEntry);
+  std::vector<BlobEntry> entries;
+  entries.reserve(end - begin);
+  std::copy_if(begin, end, std::back_inserter(entries),
+               [member](const BlobEntry& e) { return e.member != member; });
+  const BlobEntry entry{score, member};
+  entries.insert(std::lower_bound(entries.begin(), entries.end(), entry),
+                 entry);
+
+  const auto size = entries.size() * sizeof(BlobEntry);
+  auto newHandle = cache.allocate(0, kBlobKey, size);
+  std::memcpy(newHandle->getMemory(), entries.data(), size);
+  cache.insertOrReplace(newHandle);
+}
+
+uint32_t getBlobRank(LruAllocator& cache, uint64_t member) {
+  auto handle = cache.find(kBlobKey);
+  const auto* begin = reinterpret_cast<const BlobEntry*>(handle->getMemory());
+  const auto* end = begin + handle->getSize() / sizeof(BlobEntry);
+  const auto* itr = std::find_if(
+      begin, end, [member](const BlobEntry& e) { return e.member == member; });
+  return static_cast<uint32_t>(itr - begin);
+}
+} // namespace
+
+BENCHMARK(BlobUpdate, iters) {
+  std::unique_ptr<LruAllocator> cache;
+  BENCHMARK_SUSPEND {
+    cache = createCache();
+    fillBlob(*cache);
+  }
+  for (size_t i = 0; i < iters; i++) {
+    updateBlob(*cache, randomMember(), randomScore());
+  }
+  BENCHMARK_SUSPEND { cache.reset(); }
+}
+
+BENCHMARK_RELATIVE(SortedSetUpdate, iters) {
+  std::unique_ptr<LruAllocator> cache;
+  BENCHMARK_SUSPEND {
+    cache = createCache();
+    fillSortedSet(*cache);
+  }
+  for (size_t i = 0; i < iters; i++) {
+    auto ss = SortedSetT::fromWriteHandle(*cache, cache->findToWrite(kSetKey));
+    ss.insertOrUpdate(randomMember(), randomScore());
+  }
+  BENCHMARK_SUSPEND { cache.reset(); }
+}
+
+BENCHMARK_DRAW_LINE();
+
+BENCHMARK(BlobRank, iters) {
+  std::unique_ptr<LruAllocator> cache;
+  BENCHMARK_SUSPEND {
+    cache = createCache();
+    fillBlob(*cache);
+  }
+  for (size_t i = 0; i < iters; i++) {
+    folly::doNotOptimizeAway(getBlobRank(*cache, randomMember()));
+  }
+  BENCHMARK_SUSPEND { cache.reset(); }
+}
+
+BENCHMARK_RELATIVE(SortedSetRank, iters) {
+  std::unique_ptr<LruAllocator> cache;
+  BENCHMARK_SUSPEND {
+    cache = createCache();
+    fillSortedSet(*cache);
+  }
+  for (size_t i = 0; i < iters; i++) {
+    auto ss = SortedSetT::fromWriteHandle(*cache, cache->findToWrite(kSetKey));
+    folly::doNotOptimizeAway(ss.getRank(randomMember()));
+  }
+  BENCHMARK_SUSPEND { cache.reset(); }
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+}
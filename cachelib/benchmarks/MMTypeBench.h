@@ -59,6 +59,13 @@ struct MMTypeBench {
              (static_cast<uint8_t>(1) << static_cast<uint8_t>(flagBit));
     }
 
+    // the benchmark nodes have no TTL
+    std::chrono::seconds getConfiguredTTL() const noexcept {
+      return std::chrono::seconds(0);
+    }
+
+    uint32_t getExpiryTime() const noexcept { return 0; }
+
    protected:
     bool isInMMContainer() const noexcept { return inContainer_; }
 
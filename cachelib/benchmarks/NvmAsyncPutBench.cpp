@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Time spent by the thread that inserts into a full cache, where every
+// allocation evicts an item to NVM, with the puts done by the evicting
+// thread or handed to the async put threads.
+//
+// With async puts and no encodeCb, the evicting thread builds the NvmItem
+// and hands it over. With a no-op encodeCb, it copies the item for the
+// callback to run in the background and the NvmItem is built from that
+// copy, which is what every async put did before the NvmItem was handed
+// over directly.
+
+#include <folly/Benchmark.h>
+#include <folly/Conv.h>
+#include <folly/init/Init.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cachelib/allocator/CacheAllocator.h"
+
+using namespace facebook::cachelib;
+
+DEFINE_string(navy_file,
+              "/tmp/cachelib_nvm_async_put_bench",
+              "File backing the flash cache");
+DEFINE_uint32(value_size, 4096, "Size of the values inserted");
+DEFINE_uint32(async_put_threads, 4, "Threads of the async put runs");
+
+namespace {
+constexpr size_t kCacheSize = 64 * 1024 * 1024;
+constexpr uint64_t kNavySize = 512 * 1024 * 1024;
+
+void insertEvicting(uint32_t asyncPutThreads, bool encodeCb, size_t iters) {
+  folly::BenchmarkSuspender suspender;
+
+  LruAllocator::Config config;
+  config.setCacheSize(kCacheSize);
+  LruAllocator::NvmCacheConfig nvmConfig;
+  nvmConfig.navyConfig.setSimpleFile(FLAGS_navy_file, kNavySize,
+                                     true /* truncateFile */);
+  nvmConfig.navyConfig.setBlockSize(4096);
+  nvmConfig.navyConfig.blockCache().setRegionSize(16 * 1024 * 1024);
+  nvmConfig.asyncPutThreads = asyncPutThreads;
+  if (encodeCb) {
+    nvmConfig.encodeCb = [](LruAllocator::NvmCacheT::EncodeDecodeContext) {
+      return true;
+    };
+  }
+  config.enableNvmCache(nvmConfig);
+
+  auto cache = std::make_unique<LruAllocator>(config);
+  const auto pid =
+      cache->addPool("default", cache->getCacheMemoryStats().ramCacheSize);
+  const std::string value(FLAGS_value_size, 'a');
+  auto insert = [&](const std::string& key) {
+    auto handle = cache->allocate(pid, key, FLAGS_value_size);
+    if (handle) {
+      std::memcpy(handle->getMemory(), value.data(), value.size());
+      cache->insertOrReplace(handle);
+    }
+  };
+
+  // fill the cache so that every insert below evicts
+  const size_t numToFill = 2 * kCacheSize / FLAGS_value_size;
+  for (size_t i = 0; i < numToFill; i++) {
+    insert(folly::to<std::string>("fill_", i));
+  }
+  cache->flushNvmCache();
+
+  std::vector<std::string> keys;
+  keys.reserve(iters);
+  for (size_t i = 0; i < iters; i++) {
+    keys.push_back(folly::to<std::string>("key_", i));
+  }
+
+  suspender.dismiss();
+  for (const auto& key : keys) {
+    insert(key);
+  }
+  suspender.rehire();
+
+  cache->flushNvmCache();
+  cache.reset();
+}
+} // namespace
+
+BENCHMARK(SyncPut, iters) { insertEvicting(0, false, iters); }
+
+BENCHMARK_RELATIVE(AsyncPutCopiedItem, iters) {
+  insertEvicting(FLAGS_async_put_threads, true, iters);
+}
+
+BENCHMARK_RELATIVE(AsyncPutNvmItem, iters) {
+  insertEvicting(FLAGS_async_put_threads, false, iters);
+}
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  folly::runBenchmarks();
+  return 0;
+}
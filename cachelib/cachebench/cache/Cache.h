@@ -323,6 +323,11 @@ class Cache {
   // Get number of bytes written to NVM.
   double getNvmBytesWritten() const;
 
+  // Get the current counters of the NVM cache, empty if it is not enabled.
+  std::unordered_map<std::string, double> getNvmCounters() const {
+    return cache_->getNvmCacheStatsMap().toMap();
+  }
+
   // return the stats for the pool.
   PoolStats getPoolStats(PoolId pid) const { return cache_->getPoolStats(pid); }
 
@@ -463,14 +468,16 @@ MMConfigType makeMMConfig(CacheConfig const&);
 // LRU
 template <>
 inline typename LruAllocator::MMConfig makeMMConfig(CacheConfig const& config) {
-  return LruAllocator::MMConfig(config.lruRefreshSec,
-                                config.lruRefreshRatio,
-                                config.lruUpdateOnWrite,
-                                config.lruUpdateOnRead,
-                                config.tryLockUpdate,
-                                static_cast<uint8_t>(config.lruIpSpec),
-                                0,
-                                config.useCombinedLockForIterators);
+  LruAllocator::MMConfig mmConfig(config.lruRefreshSec,
+                                  config.lruRefreshRatio,
+                                  config.lruUpdateOnWrite,
+                                  config.lruUpdateOnRead,
+                                  config.tryLockUpdate,
+                                  static_cast<uint8_t>(config.lruIpSpec),
+                                  0,
+                                  config.useCombinedLockForIterators);
+  mmConfig.ttlBandSecs = static_cast<uint32_t>(config.lruTtlBandSecs);
+  return mmConfig;
 }
 
 // LRU
@@ -561,6 +568,9 @@ Cache<Allocator>::Cache(const CacheConfig& config,
   }
 
   allocatorConfig_.setMemoryLocking(config_.lockMemory);
+  if (config_.memoryPrefaultThreads > 0) {
+    allocatorConfig_.enableMemoryPrefault(config_.memoryPrefaultThreads);
+  }
 
   if (!config_.memoryTierConfigs.empty()) {
     allocatorConfig_.configureMemoryTiers(config_.memoryTierConfigs);
@@ -591,7 +601,13 @@ Cache<Allocator>::Cache(const CacheConfig& config,
   if (!isRamOnly()) {
     typename Allocator::NvmCacheConfig nvmConfig;
 
-    if (config_.nvmCachePaths.size() == 1) {
+    if (config_.metadataOnlySimulation) {
+      // the simulation does no device IO, so the paths of the NVM cache are
+      // not used and only its size matters
+      XLOGF(INFO, "Configuring NVM cache: sparse memory file size {} MB",
+            config_.nvmCacheSizeMB);
+      nvmConfig.navyConfig.setSparseMemoryFile(config_.nvmCacheSizeMB * MB);
+    } else if (config_.nvmCachePaths.size() == 1) {
       // if we get a directory, create a file. we will clean it up. If we
       // already have a file, user provided it. We will also keep it around
       // after the tests.
@@ -635,7 +651,13 @@ Cache<Allocator>::Cache(const CacheConfig& config,
       // use memory to mock NVM.
       XLOGF(INFO, "Configuring NVM cache: memory file size {} MB",
             config_.nvmCacheSizeMB);
-      nvmConfig.navyConfig.setMemoryFile(config_.nvmCacheSizeMB * MB);
+      if (config_.navySimulatedDeviceProfile.empty()) {
+        nvmConfig.navyConfig.setMemoryFile(config_.nvmCacheSizeMB * MB);
+      } else {
+        nvmConfig.navyConfig.setSimulatedDevice(
+            config_.nvmCacheSizeMB * MB,
+            loadSimulatedDeviceProfile(config_.navySimulatedDeviceProfile));
+      }
     }
     nvmConfig.navyConfig.setDeviceMetadataSize(config_.nvmCacheMetadataSizeMB *
                                                MB);
@@ -647,9 +669,11 @@ Cache<Allocator>::Cache(const CacheConfig& config,
     nvmConfig.navyConfig.setBlockSize(config_.navyBlockSize);
     nvmConfig.navyConfig.setEnableFDP(config_.deviceEnableFDP);
 
-    // configure BlockCache
+    // configure BlockCache. The values of a metadata-only simulation are
+    // never read, so there is nothing for their checksums to protect.
     auto& bcConfig = nvmConfig.navyConfig.blockCache()
-                         .setDataChecksum(config_.navyDataChecksum)
+                         .setDataChecksum(config_.navyDataChecksum &&
+                                          !config_.metadataOnlySimulation)
                          .setCleanRegions(config_.navyCleanRegions,
                                           config_.navyCleanRegionThreads)
                          .setRegionSize(config_.navyRegionSizeMB * MB);
@@ -662,6 +686,8 @@ Cache<Allocator>::Cache(const CacheConfig& config,
       } else {
         bcConfig.enableSegmentedFifo(config_.navySegmentedFifoSegmentRatio);
       }
+    } else if (config_.navyClockEviction) {
+      bcConfig.enableClock();
     }
 
     if (config_.navyHitsReinsertionThreshold > 0) {
@@ -672,6 +698,11 @@ Cache<Allocator>::Cache(const CacheConfig& config,
       bcConfig.enablePctBasedReinsertion(
           config_.navyProbabilityReinsertionThreshold);
     }
+    if (config_.navyPromotionHitsThreshold > 0) {
+      bcConfig.enablePromotion(
+          static_cast<uint8_t>(config_.navyPromotionHitsThreshold),
+          config_.navyPromotionMaxBytesPerSec);
+    }
 
     // configure BigHash if enabled
     if (config_.navyBigHashSizePct > 0) {
@@ -709,6 +740,11 @@ Cache<Allocator>::Cache(const CacheConfig& config,
 
     nvmConfig.navyConfig.setDeviceMaxWriteSize(config_.deviceMaxWriteSize);
 
+    if (config_.navyCalibrateSimulatedDevice) {
+      writeCalibratedDeviceProfile(nvmConfig.navyConfig,
+                                   config_.navySimulatedDeviceProfile);
+    }
+
     XLOG(INFO) << "Using the following nvm config"
                << folly::toPrettyJson(
                       folly::toDynamic(nvmConfig.navyConfig.serialize()));
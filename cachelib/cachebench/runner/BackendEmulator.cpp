@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/cachebench/runner/BackendEmulator.h"
+
+#include <folly/Format.h>
+#include <folly/Random.h>
+#include <folly/fibers/Baton.h>
+
+#include <cmath>
+#include <random>
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+namespace {
+// z-score of the 99th percentile of the standard normal distribution
+constexpr double kP99ZScore = 2.3263478740408408;
+
+uint64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+double lognormalSigma(const BackendConfig& config) {
+  if (config.latencyMedianUs == 0 ||
+      config.latencyP99Us <= config.latencyMedianUs) {
+    return 0;
+  }
+  return std::log(static_cast<double>(config.latencyP99Us) /
+                  config.latencyMedianUs) /
+         kP99ZScore;
+}
+} // namespace
+
+BackendEmulator::BackendEmulator(const BackendConfig& config)
+    : config_{config},
+      mu_{config.latencyMedianUs == 0
+              ? 0
+              : std::log(static_cast<double>(config.latencyMedianUs))},
+      sigma_{lognormalSigma(config)},
+      windowStartNs_{nowNs()} {
+  if (config_.maxConcurrency > 0) {
+    slots_ =
+        std::make_unique<folly::fibers::Semaphore>(config_.maxConcurrency);
+  }
+}
+
+double BackendEmulator::getOverloadFactor(double utilization) const {
+  if (utilization <= config_.overloadKnee) {
+    return 1.0;
+  }
+  const double overload =
+      (utilization - config_.overloadKnee) / (1 - config_.overloadKnee);
+  return 1.0 + config_.overloadSlope * overload * overload;
+}
+
+double BackendEmulator::getUtilization() const {
+  if (config_.capacityQps == 0) {
+    return 0;
+  }
+  return arrivalRate_.load(std::memory_order_relaxed) / config_.capacityQps;
+}
+
+double BackendEmulator::recordArrival() {
+  numFetches_.inc();
+  const auto arrivals =
+      windowArrivals_.fetch_add(1, std::memory_order_relaxed) + 1;
+  const auto now = nowNs();
+  auto start = windowStartNs_.load(std::memory_order_relaxed);
+  const uint64_t windowNs =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(kRateWindow)
+          .count();
+  // one of the threads closes the window. Arrivals racing with the reset are
+  // counted in either window, which is precise enough for the overload curve.
+  if (now - start >= windowNs &&
+      windowStartNs_.compare_exchange_strong(start, now)) {
+    windowArrivals_.store(0, std::memory_order_relaxed);
+    arrivalRate_.store(arrivals * 1e9 / (now - start),
+                       std::memory_order_relaxed);
+  }
+  return getUtilization();
+}
+
+std::chrono::nanoseconds BackendEmulator::sampleServiceTime() const {
+  double us = static_cast<double>(config_.latencyMedianUs);
+  if (sigma_ > 0) {
+    std::lognormal_distribution<double> dist{mu_, sigma_};
+    folly::ThreadLocalPRNG rng;
+    us = dist(rng);
+  }
+  return std::chrono::nanoseconds{static_cast<uint64_t>(us * 1000)};
+}
+
+bool BackendEmulator::fetch() {
+  const double utilization = recordArrival();
+
+  if (slots_ && !slots_->try_wait()) {
+    const auto queued =
+        numQueued_.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (config_.maxQueueLength > 0 && queued > config_.maxQueueLength) {
+      numQueued_.fetch_sub(1, std::memory_order_relaxed);
+      numRejected_.inc();
+      return false;
+    }
+    numQueuedFetches_.inc();
+    {
+      util::LatencyTracker tracker{queueLatency_};
+      slots_->wait();
+    }
+    numQueued_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  const auto serviceTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      sampleServiceTime() * getOverloadFactor(utilization));
+  {
+    util::LatencyTracker tracker{serviceLatency_};
+    folly::fibers::Baton baton;
+    baton.try_wait_for(serviceTime);
+  }
+  busyNs_.add(serviceTime.count());
+
+  if (slots_) {
+    slots_->signal();
+  }
+  return true;
+}
+
+void BackendEmulator::render(uint64_t elapsedTimeNs, std::ostream& out) const {
+  const double elapsedSecs = elapsedTimeNs / static_cast<double>(1e9);
+  const auto fetches = numFetches_.get();
+  const auto rejected = numRejected_.get();
+
+  out << "== Backend ==" << std::endl;
+  out << folly::sformat("{:15}: {:12,.0f}/s, {:10}: {:6.2f}%", "fetches",
+                        fetches / elapsedSecs, "rejected",
+                        fetches == 0 ? 0.0 : 100.0 * rejected / fetches)
+      << std::endl;
+  if (config_.capacityQps > 0) {
+    out << folly::sformat("{:15}: {:6.2f}% of {:,} qps", "utilization",
+                          100.0 * fetches / elapsedSecs / config_.capacityQps,
+                          config_.capacityQps)
+        << std::endl;
+  }
+  // average number of fetches being served
+  const double busySlots = busyNs_.get() / static_cast<double>(elapsedTimeNs);
+  if (config_.maxConcurrency > 0) {
+    out << folly::sformat(
+               "{:15}: {:8.2f} of {} slots ({:6.2f}%), {:6.2f}% queued",
+               "saturation", busySlots, config_.maxConcurrency,
+               100.0 * busySlots / config_.maxConcurrency,
+               fetches == 0 ? 0.0 : 100.0 * numQueuedFetches_.get() / fetches)
+        << std::endl;
+  } else {
+    out << folly::sformat("{:15}: {:8.2f} busy slots", "saturation",
+                          busySlots)
+        << std::endl;
+  }
+
+  auto outLatency = [&out](folly::StringPiece name,
+                           const util::PercentileStats::Estimates& est) {
+    out << folly::sformat(
+               "{:15}: p50 {:10.1f}us, p90 {:10.1f}us, p99 {:10.1f}us, "
+               "p999 {:10.1f}us",
+               name, est.p50 / 1000.0, est.p90 / 1000.0, est.p99 / 1000.0,
+               est.p999 / 1000.0)
+        << std::endl;
+  };
+  outLatency("queue wait", queueLatency_.estimate());
+  outLatency("service time", serviceLatency_.estimate());
+  outLatency("get end-to-end", requestLatency_.estimate());
+}
+
+void BackendEmulator::render(uint64_t elapsedTimeNs,
+                             folly::UserCounters& counters) const {
+  const double elapsedSecs = elapsedTimeNs / static_cast<double>(1e9);
+  const auto fetches = numFetches_.get();
+  const double busySlots = busyNs_.get() / static_cast<double>(elapsedTimeNs);
+
+  counters["backend_fetches_per_sec"] =
+      static_cast<int64_t>(fetches / elapsedSecs);
+  counters["backend_rejected"] = static_cast<int64_t>(numRejected_.get());
+  counters["backend_busy_slots_x100"] = static_cast<int64_t>(busySlots * 100);
+
+  const std::function<void(folly::StringPiece, double)> toUs =
+      [&counters](folly::StringPiece name, double value) {
+        counters[name.str()] = static_cast<int64_t>(value / 1000.0);
+      };
+  queueLatency_.visitQuantileEstimator(toUs, "backend_queue_latency_us");
+  serviceLatency_.visitQuantileEstimator(toUs, "backend_service_latency_us");
+  requestLatency_.visitQuantileEstimator(toUs, "get_latency_us");
+}
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Benchmark.h>
+#include <folly/fibers/Semaphore.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <ostream>
+
+#include "cachelib/cachebench/util/Config.h"
+#include "cachelib/common/AtomicCounter.h"
+#include "cachelib/common/PercentileStats.h"
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+
+// Stand-in for the backend behind a lookaside cache. Misses fetch from it and
+// really wait for its queueing and service time, so the cost of a miss shows
+// up in the stressor throughput and the end-to-end latency. Waits suspend the
+// calling fiber when called on one, and block the calling thread otherwise.
+//
+// This is thread-safe.
+class BackendEmulator {
+ public:
+  explicit BackendEmulator(const BackendConfig& config);
+
+  // Fetch a value from the backend, waiting for a free slot and the service
+  // time.
+  // @return false if the fetch is rejected because the queue is full
+  bool fetch();
+
+  // Track the end-to-end latency of a request to the cache, including the
+  // backend fetch on a miss, until the tracker is destroyed.
+  util::LatencyTracker trackRequest() {
+    return util::LatencyTracker{requestLatency_};
+  }
+
+  // Multiplier of the service time at the utilization, i.e. the arrival rate
+  // over the capacity
+  double getOverloadFactor(double utilization) const;
+
+  // Arrival rate over the capacity in the last rate window. 0 if the
+  // capacity is not set.
+  double getUtilization() const;
+
+  // Print the backend load and latencies, and the end-to-end latency
+  void render(uint64_t elapsedTimeNs, std::ostream& out) const;
+  void render(uint64_t elapsedTimeNs, folly::UserCounters& counters) const;
+
+ private:
+  // window over which the arrival rate is measured
+  static constexpr std::chrono::milliseconds kRateWindow{100};
+
+  // the percentiles cover this window so the final report is not limited to
+  // the last second of the run
+  static constexpr std::chrono::seconds kLatencyWindow{60};
+
+  // Count the arrival and return the current utilization
+  double recordArrival();
+
+  std::chrono::nanoseconds sampleServiceTime() const;
+
+  const BackendConfig config_;
+
+  // lognormal parameters of the service time in microseconds. sigma is 0
+  // for a fixed service time.
+  const double mu_;
+  const double sigma_;
+
+  // slots of the fetches being served. Null if the concurrency is unlimited.
+  std::unique_ptr<folly::fibers::Semaphore> slots_;
+
+  // fetches waiting for a slot
+  std::atomic<uint32_t> numQueued_{0};
+
+  // arrivals in the current rate window and the rate of the last window
+  std::atomic<uint64_t> windowStartNs_;
+  std::atomic<uint64_t> windowArrivals_{0};
+  std::atomic<double> arrivalRate_{0};
+
+  AtomicCounter numFetches_;
+  AtomicCounter numRejected_;
+  AtomicCounter numQueuedFetches_;
+  // sum of the service times, to compute the average number of busy slots
+  AtomicCounter busyNs_;
+
+  mutable util::PercentileStats queueLatency_{kLatencyWindow};
+  mutable util::PercentileStats serviceLatency_{kLatencyWindow};
+  mutable util::PercentileStats requestLatency_{kLatencyWindow};
+};
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
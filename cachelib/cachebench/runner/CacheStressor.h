@@ -30,6 +30,7 @@
 
 #include "cachelib/cachebench/cache/Cache.h"
 #include "cachelib/cachebench/cache/TimeStampTicker.h"
+#include "cachelib/cachebench/runner/BackendEmulator.h"
 #include "cachelib/cachebench/runner/Stressor.h"
 #include "cachelib/cachebench/util/Config.h"
 #include "cachelib/cachebench/util/Exceptions.h"
@@ -129,6 +130,9 @@ class CacheStressor : public Stressor {
                                     ? config_.opRateBurstSize
                                     : config_.opRatePerSec);
     }
+    if (config_.backendConfig) {
+      backend_ = std::make_unique<BackendEmulator>(*config_.backendConfig);
+    }
   }
 
   ~CacheStressor() override { finish(); }
@@ -208,11 +212,17 @@ class CacheStressor : public Stressor {
   void renderWorkloadGeneratorStats(uint64_t elapsedTimeNs,
                                     std::ostream& out) const override {
     wg_->renderStats(elapsedTimeNs, out);
+    if (backend_) {
+      backend_->render(elapsedTimeNs, out);
+    }
   }
 
   void renderWorkloadGeneratorStats(
       uint64_t elapsedTimeNs, folly::UserCounters& counters) const override {
     wg_->renderStats(elapsedTimeNs, counters);
+    if (backend_) {
+      backend_->render(elapsedTimeNs, counters);
+    }
   }
 
   uint64_t getTestDurationNs() const override {
@@ -354,6 +364,8 @@ class CacheStressor : public Stressor {
           if (ticker_) {
             ticker_->updateTimeStamp(req.timestamp);
           }
+          auto tracker =
+              backend_ ? backend_->trackRequest() : util::LatencyTracker{};
           // TODO currently pure lookaside, we should
           // add a distribution over sequences of requests/access patterns
           // e.g. get-no-set and set-no-get
@@ -368,6 +380,11 @@ class CacheStressor : public Stressor {
               // upgrade access privledges, (lock_upgrade is not
               // appropriate here)
               slock = {};
+              // fetch the value from the backend before taking the lock.
+              // A rejected fetch leaves the key missing.
+              if (backend_ && !backend_->fetch()) {
+                break;
+              }
               xlock = chainedItemAcquireUniqueLock(key);
               setKey(pid, stats, key, *(req.sizeBegin), req.ttlSecs,
                      req.admFeatureMap, req.itemValue);
@@ -589,6 +606,9 @@ class CacheStressor : public Stressor {
   // Token bucket used to limit the operations per second.
   std::unique_ptr<folly::BasicTokenBucket<>> rateLimiter_;
 
+  // backend that lookaside misses fetch from, if configured
+  std::unique_ptr<BackendEmulator> backend_;
+
   // Whether flash cache has been warmed up
   bool hasNvmCacheWarmedUp_{false};
 };
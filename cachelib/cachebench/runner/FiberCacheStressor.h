@@ -0,0 +1,600 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Bits.h>
+#include <folly/Random.h>
+#include <folly/TokenBucket.h>
+#include <folly/fibers/Baton.h>
+#include <folly/fibers/FiberManagerMap.h>
+#include <folly/io/async/EventBase.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <thread>
+
+#include "cachelib/cachebench/cache/Cache.h"
+#include "cachelib/cachebench/runner/BackendEmulator.h"
+#include "cachelib/cachebench/runner/Stressor.h"
+#include "cachelib/cachebench/util/Config.h"
+#include "cachelib/cachebench/util/Exceptions.h"
+#include "cachelib/cachebench/util/Request.h"
+#include "cachelib/cachebench/workload/GeneratorBase.h"
+#include "cachelib/common/AtomicCounter.h"
+#include "cachelib/common/PercentileStats.h"
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+
+constexpr uint32_t kNvmFiberCacheWarmUpCheckRate = 1000;
+
+// Stressor that runs StressorConfig::numFibersPerThread folly fibers on each
+// of its threads. Every fiber issues one operation at a time, and a lookup
+// that has to go to NVM only suspends its fiber while the others keep going.
+// This gives the thousands of outstanding requests of a server on a few
+// threads, which is what fills up the navy queues.
+//
+// On top of the throughput stats, it reports the latency of the operations
+// by the number of operations outstanding in the whole stressor when they
+// were issued, and the depth of the navy queues sampled during the run.
+//
+// Operations that could block a thread (consistency checking and chained
+// items, which take the stressor locks) are not supported.
+template <typename Allocator>
+class FiberCacheStressor : public Stressor {
+ public:
+  using CacheT = Cache<Allocator>;
+  using WriteHandle = typename CacheT::WriteHandle;
+
+  // @param cacheConfig   the config to instantiate the cache instance
+  // @param config        stress test config
+  // @param generator     workload  generator
+  FiberCacheStressor(CacheConfig cacheConfig,
+                     StressorConfig config,
+                     std::unique_ptr<GeneratorBase>&& generator)
+      : config_(std::move(config)),
+        throughputStats_(config_.numThreads),
+        wg_(std::move(generator)),
+        hardcodedString_(genHardcodedString()),
+        endTime_{std::chrono::system_clock::time_point::max()} {
+    if (config_.numFibersPerThread == 0) {
+      throw std::invalid_argument(
+          "Fiber cache stressor needs numFibersPerThread > 0");
+    }
+    if (config_.checkConsistency || config_.usesChainedItems()) {
+      throw std::invalid_argument(
+          "Fiber cache stressor does not support consistency checking or "
+          "chained items");
+    }
+
+    cache_ = std::make_unique<CacheT>(
+        cacheConfig, typename CacheT::ChainedItemMovingSync{}, "",
+        config_.touchValue);
+    if (config_.opPoolDistribution.size() > cache_->numPools()) {
+      throw std::invalid_argument(folly::sformat(
+          "more pools specified in the test than in the cache. "
+          "test: {}, cache: {}",
+          config_.opPoolDistribution.size(), cache_->numPools()));
+    }
+    if (config_.keyPoolDistribution.size() != cache_->numPools()) {
+      throw std::invalid_argument(folly::sformat(
+          "different number of pools in the test from in the cache. "
+          "test: {}, cache: {}",
+          config_.keyPoolDistribution.size(), cache_->numPools()));
+    }
+
+    if (config_.opRatePerSec > 0) {
+      rateLimiter_ = std::make_unique<folly::BasicTokenBucket<>>(
+          config_.opRatePerSec, config_.opRatePerSec);
+    }
+    if (config_.backendConfig) {
+      backend_ = std::make_unique<BackendEmulator>(*config_.backendConfig);
+    }
+  }
+
+  ~FiberCacheStressor() override { finish(); }
+
+  // Start the stress test by spawning the worker threads and their fibers,
+  // and waiting for them to finish the stress operations.
+  void start() override {
+    {
+      std::lock_guard<std::mutex> l(timeMutex_);
+      startTime_ = std::chrono::system_clock::now();
+    }
+    std::cout << folly::sformat(
+                     "Total {:.2f}M ops to be run by {} fibers",
+                     config_.numThreads * config_.numOps / 1e6,
+                     config_.numThreads * config_.numFibersPerThread)
+              << std::endl;
+
+    sampler_ = std::thread([this] { sampleQueueDepths(); });
+    stressWorker_ = std::thread([this] {
+      std::vector<std::thread> workers;
+      for (uint64_t i = 0; i < config_.numThreads; ++i) {
+        workers.push_back(
+            std::thread([this, throughputStats = &throughputStats_.at(i)]() {
+              stressWithFibers(*throughputStats);
+            }));
+      }
+      for (auto& worker : workers) {
+        worker.join();
+      }
+      {
+        std::lock_guard<std::mutex> l(timeMutex_);
+        endTime_ = std::chrono::system_clock::now();
+      }
+      {
+        std::lock_guard<std::mutex> l(samplerMutex_);
+        samplerStop_ = true;
+      }
+      samplerCv_.notify_all();
+    });
+  }
+
+  // Block until all stress workers are finished.
+  void finish() override {
+    if (stressWorker_.joinable()) {
+      stressWorker_.join();
+    }
+    if (sampler_.joinable()) {
+      sampler_.join();
+    }
+    wg_->markShutdown();
+    cache_->clearCache(config_.maxInvalidDestructorCount);
+  }
+
+  // abort the stress run by indicating to the workload generator and
+  // delegating to the base class abort() to stop the test.
+  void abort() override {
+    wg_->markShutdown();
+    Stressor::abort();
+  }
+
+  // obtain stats from the cache instance.
+  Stats getCacheStats() const override { return cache_->getStats(); }
+
+  // obtain aggregated throughput stats for the stress run so far.
+  ThroughputStats aggregateThroughputStats() const override {
+    ThroughputStats res{};
+    for (const auto& stats : throughputStats_) {
+      res += stats;
+    }
+
+    return res;
+  }
+
+  void renderWorkloadGeneratorStats(uint64_t elapsedTimeNs,
+                                    std::ostream& out) const override {
+    wg_->renderStats(elapsedTimeNs, out);
+    renderConcurrencyStats(out);
+    if (backend_) {
+      backend_->render(elapsedTimeNs, out);
+    }
+  }
+
+  void renderWorkloadGeneratorStats(
+      uint64_t elapsedTimeNs, folly::UserCounters& counters) const override {
+    wg_->renderStats(elapsedTimeNs, counters);
+    visitConcurrencyStats([&counters](const std::string& name, double value) {
+      counters[name] = static_cast<int64_t>(value);
+    });
+    if (backend_) {
+      backend_->render(elapsedTimeNs, counters);
+    }
+  }
+
+  uint64_t getTestDurationNs() const override {
+    std::lock_guard<std::mutex> l(timeMutex_);
+    return std::chrono::nanoseconds{
+        std::min(std::chrono::system_clock::now(), endTime_) - startTime_}
+        .count();
+  }
+
+ private:
+  // latencies are bucketed by the power of two of the outstanding operations
+  static constexpr size_t kNumConcurrencyBuckets = 32;
+
+  // stack of the fibers. The lookups that go to navy need more than the
+  // default of the fiber manager.
+  static constexpr size_t kFiberStackSize = 64 * 1024;
+
+  // navy counters that hold a queue depth
+  static bool isQueueDepthCounter(const std::string& name) {
+    return name.find("navy") != std::string::npos &&
+           (name.find("outstanding") != std::string::npos ||
+            name.find("pending_jobs") != std::string::npos ||
+            name.find("queue_len") != std::string::npos ||
+            name.find("spooled.curr") != std::string::npos);
+  }
+
+  struct QueueDepth {
+    double max{0};
+    double sum{0};
+  };
+
+  static std::string genHardcodedString() {
+    const std::string s = "The quick brown fox jumps over the lazy dog. ";
+    std::string val;
+    for (int i = 0; i < 4 * 1024 * 1024; i += s.size()) {
+      val += s;
+    }
+    return val;
+  }
+
+  // populate the input item handle according to the stress setup.
+  void populateItem(WriteHandle& handle) {
+    if (!config_.populateItem) {
+      return;
+    }
+    XDCHECK(handle);
+    XDCHECK_LE(cache_->getSize(handle), 4ULL * 1024 * 1024);
+    cache_->setStringItem(handle, hardcodedString_);
+  }
+
+  // Runs the fibers of a thread on an event base until they have issued
+  // config_.numOps operations between them.
+  //
+  // @param stats       Throughput stats of the thread, shared by its fibers
+  void stressWithFibers(ThroughputStats& stats) {
+    folly::EventBase evb;
+    folly::fibers::FiberManager::Options options;
+    options.stackSize = kFiberStackSize;
+    auto& fm = folly::fibers::getFiberManager(evb, options);
+
+    // the fibers of a thread never run concurrently
+    std::mt19937_64 gen(folly::Random::rand64());
+    std::discrete_distribution<> opPoolDist(config_.opPoolDistribution.begin(),
+                                            config_.opPoolDistribution.end());
+    uint64_t opsIssued = 0;
+    uint64_t fibersRunning = config_.numFibersPerThread;
+    for (uint64_t i = 0; i < config_.numFibersPerThread; i++) {
+      fm.addTask([&]() {
+        while (opsIssued < config_.numOps && !shouldStop()) {
+          ++opsIssued;
+          try {
+            runOp(stats, gen, opPoolDist);
+          } catch (const cachebench::EndOfTrace&) {
+            break;
+          }
+        }
+        if (--fibersRunning == 0) {
+          evb.terminateLoopSoon();
+        }
+      });
+    }
+    evb.loopForever();
+    wg_->markFinish();
+  }
+
+  bool shouldStop() {
+    return cache_->isNvmCacheDisabled() || shouldTestStop();
+  }
+
+  // Issues one operation from the fiber and tracks its latency by the
+  // number of operations outstanding when it was issued.
+  void runOp(ThroughputStats& stats,
+             std::mt19937_64& gen,
+             std::discrete_distribution<>& opPoolDist) {
+    throttle();
+    ++stats.ops;
+
+    const auto pid = static_cast<PoolId>(opPoolDist(gen));
+    std::optional<uint64_t> lastRequestId = std::nullopt;
+    const Request& req(getReq(pid, gen, lastRequestId));
+    const auto requestId = req.requestId;
+    OpType op = req.getOp();
+    std::string_view key = req.key;
+    std::string oneHitKey;
+    if (op == OpType::kLoneGet || op == OpType::kLoneSet) {
+      oneHitKey = Request::getUniqueKey();
+      key = oneHitKey;
+    }
+
+    const auto outstanding =
+        outstandingOps_.fetch_add(1, std::memory_order_relaxed) + 1;
+    const auto start = std::chrono::steady_clock::now();
+
+    OpResultType result(OpResultType::kNop);
+    switch (op) {
+    case OpType::kLoneSet:
+    case OpType::kSet:
+      result = setKey(pid, stats, key, *(req.sizeBegin), req.ttlSecs,
+                      req.admFeatureMap);
+      break;
+    case OpType::kLoneGet:
+    case OpType::kGet: {
+      ++stats.get;
+      auto tracker =
+          backend_ ? backend_->trackRequest() : util::LatencyTracker{};
+      cache_->recordAccess(key);
+      // waiting for the handle only suspends this fiber
+      auto it = cache_->find(key);
+      if (it == nullptr) {
+        ++stats.getMiss;
+        result = OpResultType::kGetMiss;
+        // so does waiting for the backend. A rejected fetch leaves the key
+        // missing.
+        if (config_.enableLookaside && (!backend_ || backend_->fetch())) {
+          setKey(pid, stats, key, *(req.sizeBegin), req.ttlSecs,
+                 req.admFeatureMap);
+        }
+      } else {
+        result = OpResultType::kGetHit;
+      }
+      break;
+    }
+    case OpType::kDel: {
+      ++stats.del;
+      auto res = cache_->remove(key);
+      if (res == CacheT::RemoveRes::kNotFoundInRam) {
+        ++stats.delNotFound;
+      }
+      break;
+    }
+    case OpType::kUpdate: {
+      ++stats.get;
+      ++stats.update;
+      auto it = cache_->findToWrite(key);
+      if (it == nullptr) {
+        ++stats.getMiss;
+        ++stats.updateMiss;
+        break;
+      }
+      cache_->updateItemRecordVersion(it);
+      break;
+    }
+    default:
+      throw std::runtime_error(
+          folly::sformat("invalid operation generated: {}", (int)op));
+    }
+
+    const auto latencyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    outstandingOps_.fetch_sub(1, std::memory_order_relaxed);
+    const auto bucket = std::min<size_t>(folly::findLastSet(outstanding),
+                                         kNumConcurrencyBuckets - 1);
+    latencyByConcurrency_[bucket].trackValue(latencyNs);
+    numOpsByConcurrency_[bucket].inc();
+
+    if (requestId) {
+      wg_->notifyResult(*requestId, result);
+    }
+  }
+
+  // inserts key into the cache if the admission policy also indicates the
+  // key is worthy to be cached.
+  OpResultType setKey(
+      PoolId pid,
+      ThroughputStats& stats,
+      const std::string_view key,
+      size_t size,
+      uint32_t ttlSecs,
+      const std::unordered_map<std::string, std::string>& featureMap) {
+    if (config_.admPolicy && !config_.admPolicy->accept(featureMap)) {
+      return OpResultType::kSetSkip;
+    }
+
+    ++stats.set;
+    auto it = cache_->allocate(pid, key, size, ttlSecs);
+    if (it == nullptr) {
+      ++stats.setFailure;
+      return OpResultType::kSetFailure;
+    }
+    populateItem(it);
+    cache_->insertOrReplace(it);
+    return OpResultType::kSetSuccess;
+  }
+
+  // fetch a request from the workload generator for a particular pool
+  const Request& getReq(const PoolId& pid,
+                        std::mt19937_64& gen,
+                        std::optional<uint64_t>& lastRequestId) {
+    const Request& req(wg_->getReq(pid, gen, lastRequestId));
+    if (config_.checkNvmCacheWarmUp &&
+        folly::Random::oneIn(kNvmFiberCacheWarmUpCheckRate)) {
+      checkNvmCacheWarmedUp(req.timestamp);
+    }
+    return req;
+  }
+
+  void checkNvmCacheWarmedUp(uint64_t requestTimestamp) {
+    if (hasNvmCacheWarmedUp_ || cache_->isNvmCacheDisabled()) {
+      return;
+    }
+    if (cache_->hasNvmCacheWarmedUp()) {
+      wg_->setNvmCacheWarmedUp(requestTimestamp);
+      XLOG(INFO) << "NVM cache has been warmed up";
+      hasNvmCacheWarmedUp_ = true;
+    }
+  }
+
+  // Applies opDelayNs and opRatePerSec. The waits suspend the fiber instead
+  // of sleeping, so that the other fibers of the thread keep running.
+  void throttle() {
+    std::chrono::nanoseconds wait{0};
+    if (config_.opDelayBatch != 0 && config_.opDelayNs != 0 &&
+        folly::Random::oneIn(config_.opDelayBatch)) {
+      wait += std::chrono::nanoseconds{config_.opDelayNs};
+    }
+    if (rateLimiter_) {
+      auto rateWait = rateLimiter_->consumeWithBorrowNonBlocking(1);
+      if (rateWait && *rateWait > 0) {
+        wait += std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::duration<double>(*rateWait));
+      }
+    }
+    if (wait.count() > 0) {
+      folly::fibers::Baton baton;
+      baton.try_wait_for(wait);
+    }
+  }
+
+  // Samples the outstanding operations and the navy queue depths until the
+  // run is done.
+  void sampleQueueDepths() {
+    const auto interval = std::chrono::milliseconds{
+        std::max<uint64_t>(1, config_.samplingIntervalMs / 10)};
+    std::unique_lock<std::mutex> l(samplerMutex_);
+    while (!samplerCv_.wait_for(l, interval, [this] { return samplerStop_; })) {
+      l.unlock();
+      const auto counters = cache_->getNvmCounters();
+      const double outstanding =
+          outstandingOps_.load(std::memory_order_relaxed);
+      {
+        std::lock_guard<std::mutex> depthLock(depthMutex_);
+        numDepthSamples_++;
+        auto addSample = [this](const std::string& name, double value) {
+          auto& depth = queueDepths_[name];
+          depth.max = std::max(depth.max, value);
+          depth.sum += value;
+        };
+        addSample("outstanding_ops", outstanding);
+        for (const auto& [name, value] : counters) {
+          if (isQueueDepthCounter(name)) {
+            addSample(name, value);
+          }
+        }
+      }
+      l.lock();
+    }
+  }
+
+  // Visits the latency percentiles by outstanding operations as
+  // "fiber.latency_us.outstanding_<upper bound>.<percentile>" and the
+  // sampled depths as "fiber.depth.<name>.{avg,max}".
+  void visitConcurrencyStats(
+      const std::function<void(const std::string&, double)>& visitor) const {
+    for (size_t i = 0; i < kNumConcurrencyBuckets; i++) {
+      if (numOpsByConcurrency_[i].get() == 0) {
+        continue;
+      }
+      const auto prefix = folly::sformat("fiber.latency_us.outstanding_{}",
+                                         (uint64_t{1} << i) - 1);
+      visitor(prefix + ".ops", numOpsByConcurrency_[i].get());
+      const std::function<void(folly::StringPiece, double)> toUs =
+          [&visitor](folly::StringPiece name, double value) {
+            visitor(name.str(), value / 1000.0);
+          };
+      latencyByConcurrency_[i].visitQuantileEstimator(toUs, prefix);
+    }
+
+    std::lock_guard<std::mutex> l(depthMutex_);
+    if (numDepthSamples_ == 0) {
+      return;
+    }
+    for (const auto& [name, depth] : queueDepths_) {
+      visitor(folly::sformat("fiber.depth.{}.avg", name),
+              depth.sum / numDepthSamples_);
+      visitor(folly::sformat("fiber.depth.{}.max", name), depth.max);
+    }
+  }
+
+  void renderConcurrencyStats(std::ostream& out) const {
+    out << "== Latency by outstanding ops ==" << std::endl;
+    for (size_t i = 0; i < kNumConcurrencyBuckets; i++) {
+      const auto ops = numOpsByConcurrency_[i].get();
+      if (ops == 0) {
+        continue;
+      }
+      const auto estimates = latencyByConcurrency_[i].estimate();
+      out << folly::sformat(
+                 "outstanding <= {:6}: {:12,} ops, p50 {:8.1f}us, "
+                 "p90 {:8.1f}us, p99 {:8.1f}us, p999 {:8.1f}us",
+                 (uint64_t{1} << i) - 1, ops, estimates.p50 / 1000.0,
+                 estimates.p90 / 1000.0, estimates.p99 / 1000.0,
+                 estimates.p999 / 1000.0)
+          << std::endl;
+    }
+
+    std::lock_guard<std::mutex> l(depthMutex_);
+    if (numDepthSamples_ == 0) {
+      return;
+    }
+    out << "== Sampled queue depths ==" << std::endl;
+    for (const auto& [name, depth] : queueDepths_) {
+      out << folly::sformat("{:50}: avg {:10.1f}, max {:10.0f}", name,
+                            depth.sum / numDepthSamples_, depth.max)
+          << std::endl;
+    }
+  }
+
+  const StressorConfig config_; // config for the stress run
+
+  std::vector<ThroughputStats> throughputStats_; // thread local stats
+
+  std::unique_ptr<GeneratorBase> wg_; // workload generator
+
+  // string used for generating random payloads
+  const std::string hardcodedString_;
+
+  std::unique_ptr<CacheT> cache_;
+
+  // operations issued and not completed over all the fibers
+  std::atomic<uint64_t> outstandingOps_{0};
+
+  // latency of the operations and their number, by the power of two of the
+  // outstanding operations when they were issued
+  mutable std::array<util::PercentileStats, kNumConcurrencyBuckets>
+      latencyByConcurrency_;
+  std::array<AtomicCounter, kNumConcurrencyBuckets> numOpsByConcurrency_;
+
+  // samples of the queue depths by counter name
+  mutable std::mutex depthMutex_;
+  std::map<std::string, QueueDepth> queueDepths_;
+  uint64_t numDepthSamples_{0};
+
+  // thread sampling the queue depths, and its stop signal
+  std::thread sampler_;
+  std::mutex samplerMutex_;
+  std::condition_variable samplerCv_;
+  bool samplerStop_{false};
+
+  // main stressor thread
+  std::thread stressWorker_;
+
+  // mutex to protect reading the timestamps.
+  mutable std::mutex timeMutex_;
+
+  // start time for the stress test
+  std::chrono::time_point<std::chrono::system_clock> startTime_;
+
+  // time when benchmark finished. This is set once the benchmark finishes
+  std::chrono::time_point<std::chrono::system_clock> endTime_;
+
+  // Token bucket used to limit the operations per second.
+  std::unique_ptr<folly::BasicTokenBucket<>> rateLimiter_;
+
+  // backend that lookaside misses fetch from, if configured
+  std::unique_ptr<BackendEmulator> backend_;
+
+  // Whether flash cache has been warmed up
+  std::atomic<bool> hasNvmCacheWarmedUp_{false};
+};
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
@@ -20,6 +20,7 @@
 #include "cachelib/cachebench/runner/AsyncCacheStressor.h"
 #include "cachelib/cachebench/runner/CacheStressor.h"
 #include "cachelib/cachebench/runner/FastShutdown.h"
+#include "cachelib/cachebench/runner/FiberCacheStressor.h"
 #include "cachelib/cachebench/runner/IntegrationStressor.h"
 #include "cachelib/cachebench/workload/BinaryKVReplayGenerator.h"
 #include "cachelib/cachebench/workload/BlockChunkReplayGenerator.h"
@@ -195,6 +196,24 @@ std::unique_ptr<Stressor> Stressor::makeStressor(
       return std::make_unique<AsyncCacheStressor<Lru2QAllocator>>(
           cacheConfig, stressorConfig, std::move(generator));
     }
+  } else if (stressorConfig.name == "fiber") {
+    if (stressorConfig.generator != "workload" &&
+        !stressorConfig.generator.empty()) {
+      // replay generators can block the thread, and all its fibers with it
+      throw std::invalid_argument(folly::sformat(
+          "Fiber cache stressor only works with workload generator. "
+          "generator: {}",
+          stressorConfig.generator));
+    }
+
+    auto generator = makeGenerator(stressorConfig);
+    if (cacheConfig.allocator == "LRU") {
+      return std::make_unique<FiberCacheStressor<LruAllocator>>(
+          cacheConfig, stressorConfig, std::move(generator));
+    } else if (cacheConfig.allocator == "LRU2Q") {
+      return std::make_unique<FiberCacheStressor<Lru2QAllocator>>(
+          cacheConfig, stressorConfig, std::move(generator));
+    }
   } else {
     auto generator = makeGenerator(stressorConfig);
     if (cacheConfig.allocator == "LRU") {
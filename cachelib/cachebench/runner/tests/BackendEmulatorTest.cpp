@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/json/json.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "cachelib/cachebench/runner/BackendEmulator.h"
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+namespace tests {
+TEST(BackendEmulator, Config) {
+  BackendConfig config{folly::parseJson(R"({
+    "latencyMedianUs": 500,
+    "latencyP99Us": 5000,
+    "maxConcurrency": 16,
+    "maxQueueLength": 64,
+    "capacityQps": 10000,
+    "overloadKnee": 0.5,
+    "overloadSlope": 4
+  })")};
+  EXPECT_EQ(500, config.latencyMedianUs);
+  EXPECT_EQ(5000, config.latencyP99Us);
+  EXPECT_EQ(16, config.maxConcurrency);
+  EXPECT_EQ(64, config.maxQueueLength);
+  EXPECT_EQ(10000, config.capacityQps);
+  EXPECT_EQ(0.5, config.overloadKnee);
+  EXPECT_EQ(4, config.overloadSlope);
+
+  EXPECT_THROW(BackendConfig{folly::parseJson(R"({"overloadKnee": 1})")},
+               std::invalid_argument);
+  EXPECT_THROW(BackendConfig{folly::parseJson(R"({"overloadSlope": -1})")},
+               std::invalid_argument);
+}
+
+TEST(BackendEmulator, OverloadFactor) {
+  BackendConfig config;
+  config.capacityQps = 1000;
+  config.overloadKnee = 0.5;
+  config.overloadSlope = 4;
+  BackendEmulator backend{config};
+
+  EXPECT_EQ(1.0, backend.getOverloadFactor(0));
+  EXPECT_EQ(1.0, backend.getOverloadFactor(0.5));
+  EXPECT_DOUBLE_EQ(2.0, backend.getOverloadFactor(0.75));
+  EXPECT_DOUBLE_EQ(5.0, backend.getOverloadFactor(1.0));
+  // keeps growing past the capacity
+  EXPECT_DOUBLE_EQ(17.0, backend.getOverloadFactor(1.5));
+}
+
+TEST(BackendEmulator, FetchWaits) {
+  BackendConfig config;
+  config.latencyMedianUs = 20'000;
+  BackendEmulator backend{config};
+
+  const auto begin = std::chrono::steady_clock::now();
+  EXPECT_TRUE(backend.fetch());
+  EXPECT_GE(std::chrono::steady_clock::now() - begin,
+            std::chrono::milliseconds{20});
+}
+
+TEST(BackendEmulator, QueueLimit) {
+  BackendConfig config;
+  config.latencyMedianUs = 500'000;
+  config.maxConcurrency = 1;
+  config.maxQueueLength = 1;
+  BackendEmulator backend{config};
+
+  // one fetch is served, one waits in the queue and the last one is rejected
+  std::atomic<int> numRejected{0};
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 3; i++) {
+    threads.emplace_back([&] {
+      if (!backend.fetch()) {
+        numRejected++;
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(1, numRejected);
+}
+} // namespace tests
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/FileUtil.h>
+#include <folly/init/Init.h>
+#include <folly/json/json.h>
+#include <gflags/gflags.h>
+
+#include <iostream>
+
+#include "cachelib/cachebench/workload/TraceFitter.h"
+#include "cachelib/common/Utils.h"
+
+DEFINE_string(json_test_config,
+              "",
+              "path to the config of a replay of the trace to fit");
+DEFINE_string(output_config,
+              "",
+              "path to write the cachebench config of the fitted workload to");
+DEFINE_string(report_file,
+              "",
+              "path to write the fidelity report to. If empty, print it");
+DEFINE_double(sample_rate,
+              0.01,
+              "fraction of the keys used to fit the popularity, the sizes, the "
+              "TTLs and the hit ratio curve");
+DEFINE_uint64(max_ops, 0, "requests of the trace to read, 0 to read all");
+DEFINE_uint64(synthetic_ops,
+              0,
+              "requests generated from the fitted workload to compare its hit "
+              "ratio curve with the trace, 0 for as many as the trace");
+DEFINE_double(max_reuse_distance_divergence,
+              0.2,
+              "warn when the reuse distances of the fitted workload diverge "
+              "from the trace by more than this, from 0 to 1");
+DEFINE_double(max_val_size_skew,
+              0.2,
+              "warn when the mean value size per request of the trace differs "
+              "from the mean per key by more than this fraction");
+DEFINE_bool(fail_on_divergence,
+            false,
+            "exit with an error, after writing the config and the report, "
+            "when the fitted workload diverges from the trace");
+
+bool checkArgsValidity() {
+  if (FLAGS_json_test_config.empty() ||
+      !facebook::cachelib::util::pathExists(FLAGS_json_test_config)) {
+    std::cout << "Invalid config file: " << FLAGS_json_test_config
+              << ". pass a valid --json_test_config for trace fitting."
+              << std::endl;
+    return false;
+  }
+  if (FLAGS_output_config.empty()) {
+    std::cout << "pass --output_config for the fitted workload" << std::endl;
+    return false;
+  }
+
+  return true;
+}
+
+int main(int argc, char** argv) {
+  using namespace facebook::cachelib;
+  using namespace facebook::cachelib::cachebench;
+
+  folly::init(&argc, &argv, true);
+  if (!checkArgsValidity()) {
+    return 1;
+  }
+
+  CacheBenchConfig config(FLAGS_json_test_config);
+  std::cout << "Trace Fitter" << std::endl;
+
+  try {
+    TraceFitterConfig fitterConfig;
+    fitterConfig.sampleRate = FLAGS_sample_rate;
+    fitterConfig.numSyntheticOps = FLAGS_synthetic_ops;
+    fitterConfig.maxReuseDistanceDivergence =
+        FLAGS_max_reuse_distance_divergence;
+    fitterConfig.maxValSizeSkew = FLAGS_max_val_size_skew;
+    TraceFitter fitter(fitterConfig);
+
+    const auto numRead =
+        fitter.readTrace(config.getStressorConfig(), FLAGS_max_ops);
+    std::cout << folly::sformat("Read {} requests, {} parse errors", numRead,
+                                fitter.getNumParseErrors())
+              << std::endl;
+
+    const auto workload = fitter.fit();
+    const auto fidelity = fitter.evaluate(workload);
+    for (const auto& warning : fidelity.warnings) {
+      std::cerr << "WARNING: " << warning << std::endl;
+    }
+    const auto report = fidelity.render(workload);
+    if (FLAGS_report_file.empty()) {
+      std::cout << report;
+    } else if (!folly::writeFile(report, FLAGS_report_file.c_str())) {
+      throw std::runtime_error(
+          folly::sformat("could not write file: {}", FLAGS_report_file));
+    }
+
+    // the fitted workload runs with the cache config of the replay
+    std::string configString;
+    folly::readFile(FLAGS_json_test_config.c_str(), configString);
+    const auto inputJson =
+        folly::parseJson(folly::json::stripComments(configString));
+
+    auto testConfig = workload.toTestConfig();
+    testConfig["numThreads"] =
+        static_cast<int64_t>(config.getStressorConfig().numThreads);
+    folly::dynamic outputJson = folly::dynamic::object;
+    outputJson["cache_config"] =
+        inputJson.getDefault("cache_config", folly::dynamic::object);
+    outputJson["test_config"] = std::move(testConfig);
+    if (!folly::writeFile(folly::toPrettyJson(outputJson),
+                          FLAGS_output_config.c_str())) {
+      throw std::runtime_error(
+          folly::sformat("could not write file: {}", FLAGS_output_config));
+    }
+
+    if (FLAGS_fail_on_divergence && !fidelity.warnings.empty()) {
+      std::cout << "The fitted workload diverges from the trace" << std::endl;
+      return 2;
+    }
+  } catch (const std::exception& e) {
+    std::cout << "Failed to fit the trace. Exception: " << e.what()
+              << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
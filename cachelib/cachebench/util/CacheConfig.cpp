@@ -16,6 +16,11 @@
 
 #include "cachelib/cachebench/util/CacheConfig.h"
 
+#include <folly/FileUtil.h>
+#include <folly/Format.h>
+#include <folly/json/json.h>
+#include <folly/logging/xlog.h>
+
 #include "cachelib/allocator/HitsPerSlabStrategy.h"
 #include "cachelib/allocator/LruTailAgeStrategy.h"
 #include "cachelib/allocator/RandomStrategy.h"
@@ -43,6 +48,7 @@ CacheConfig::CacheConfig(const folly::dynamic& configJson) {
   JSONSetVal(configJson, lruUpdateOnRead);
   JSONSetVal(configJson, tryLockUpdate);
   JSONSetVal(configJson, lruIpSpec);
+  JSONSetVal(configJson, lruTtlBandSecs);
   JSONSetVal(configJson, useCombinedLockForIterators);
 
   JSONSetVal(configJson, lru2qHotPct);
@@ -59,11 +65,13 @@ CacheConfig::CacheConfig(const folly::dynamic& configJson) {
   JSONSetVal(configJson, nvmCacheSizeMB);
   JSONSetVal(configJson, nvmCacheMetadataSizeMB);
   JSONSetVal(configJson, nvmCachePaths);
+  JSONSetVal(configJson, navySimulatedDeviceProfile);
   JSONSetVal(configJson, writeAmpDeviceList);
 
   JSONSetVal(configJson, navyBlockSize);
   JSONSetVal(configJson, navyRegionSizeMB);
   JSONSetVal(configJson, navySegmentedFifoSegmentRatio);
+  JSONSetVal(configJson, navyClockEviction);
   JSONSetVal(configJson, navyReqOrderShardsPower);
   JSONSetVal(configJson, navyBigHashSizePct);
   JSONSetVal(configJson, navyBigHashBucketSize);
@@ -72,6 +80,8 @@ CacheConfig::CacheConfig(const folly::dynamic& configJson) {
   JSONSetVal(configJson, navyParcelMemoryMB);
   JSONSetVal(configJson, navyHitsReinsertionThreshold);
   JSONSetVal(configJson, navyProbabilityReinsertionThreshold);
+  JSONSetVal(configJson, navyPromotionHitsThreshold);
+  JSONSetVal(configJson, navyPromotionMaxBytesPerSec);
   JSONSetVal(configJson, navyReaderThreads);
   JSONSetVal(configJson, navyWriterThreads);
   JSONSetVal(configJson, navyMaxNumReads);
@@ -89,11 +99,14 @@ CacheConfig::CacheConfig(const folly::dynamic& configJson) {
   JSONSetVal(configJson, navyEncryption);
   JSONSetVal(configJson, deviceMaxWriteSize);
   JSONSetVal(configJson, deviceEnableFDP);
+  JSONSetVal(configJson, navyCalibrateSimulatedDevice);
+  JSONSetVal(configJson, metadataOnlySimulation);
 
   JSONSetVal(configJson, memoryOnlyTTL);
 
   JSONSetVal(configJson, usePosixShm);
   JSONSetVal(configJson, lockMemory);
+  JSONSetVal(configJson, memoryPrefaultThreads);
   if (configJson.count("memoryTiers")) {
     for (auto& it : configJson["memoryTiers"]) {
       memoryTierConfigs.push_back(
@@ -112,7 +125,18 @@ CacheConfig::CacheConfig(const folly::dynamic& configJson) {
   // if you added new fields to the configuration, update the JSONSetVal
   // to make them available for the json configs and increment the size
   // below
-  checkCorrectSize<CacheConfig, 760>();
+  checkCorrectSize<CacheConfig, 824>();
+
+  if (navyCalibrateSimulatedDevice && navySimulatedDeviceProfile.empty()) {
+    throw std::invalid_argument(
+        "navyCalibrateSimulatedDevice needs navySimulatedDeviceProfile");
+  }
+
+  if (metadataOnlySimulation && !navySimulatedDeviceProfile.empty()) {
+    throw std::invalid_argument(
+        "metadataOnlySimulation runs the NVM cache on a sparse in-memory "
+        "device, without navySimulatedDeviceProfile");
+  }
 
   if (numPools != poolSizes.size()) {
     throw std::invalid_argument(folly::sformat(
@@ -145,8 +169,121 @@ std::shared_ptr<RebalanceStrategy> CacheConfig::getRebalanceStrategy() const {
 MemoryTierConfig::MemoryTierConfig(const folly::dynamic& configJson) {
   JSONSetVal(configJson, ratio);
   JSONSetVal(configJson, memBindNodes);
+  JSONSetVal(configJson, file);
+
+  checkCorrectSize<MemoryTierConfig, 72>();
+}
+
+SimulatedDeviceProfile::SimulatedDeviceProfile(
+    const navy::SimulatedDeviceConfig& config)
+    : numChannels{config.numChannels},
+      channelStripeSize{config.channelStripeSize},
+      readLatencyP50Us{static_cast<uint32_t>(config.readLatencyP50.count())},
+      readLatencyP99Us{static_cast<uint32_t>(config.readLatencyP99.count())},
+      writeLatencyP50Us{static_cast<uint32_t>(config.writeLatencyP50.count())},
+      writeLatencyP99Us{static_cast<uint32_t>(config.writeLatencyP99.count())},
+      channelReadBytesPerSec{config.channelReadBytesPerSec},
+      channelWriteBytesPerSec{config.channelWriteBytesPerSec},
+      overProvisioning{config.overProvisioning},
+      pageSize{config.pageSize},
+      eraseBlockSize{config.eraseBlockSize},
+      eraseLatencyUs{static_cast<uint32_t>(config.eraseLatency.count())},
+      injectLatency{config.injectLatency} {}
+
+SimulatedDeviceProfile::SimulatedDeviceProfile(
+    const folly::dynamic& configJson)
+    : SimulatedDeviceProfile() {
+  JSONSetVal(configJson, numChannels);
+  JSONSetVal(configJson, channelStripeSize);
+  JSONSetVal(configJson, readLatencyP50Us);
+  JSONSetVal(configJson, readLatencyP99Us);
+  JSONSetVal(configJson, writeLatencyP50Us);
+  JSONSetVal(configJson, writeLatencyP99Us);
+  JSONSetVal(configJson, channelReadBytesPerSec);
+  JSONSetVal(configJson, channelWriteBytesPerSec);
+  JSONSetVal(configJson, overProvisioning);
+  JSONSetVal(configJson, pageSize);
+  JSONSetVal(configJson, eraseBlockSize);
+  JSONSetVal(configJson, eraseLatencyUs);
+  JSONSetVal(configJson, injectLatency);
+
+  checkCorrectSize<SimulatedDeviceProfile, 64>();
+}
+
+navy::SimulatedDeviceConfig SimulatedDeviceProfile::getSimulatedDeviceConfig()
+    const {
+  navy::SimulatedDeviceConfig config;
+  config.numChannels = numChannels;
+  config.channelStripeSize = channelStripeSize;
+  config.readLatencyP50 = std::chrono::microseconds{readLatencyP50Us};
+  config.readLatencyP99 = std::chrono::microseconds{readLatencyP99Us};
+  config.writeLatencyP50 = std::chrono::microseconds{writeLatencyP50Us};
+  config.writeLatencyP99 = std::chrono::microseconds{writeLatencyP99Us};
+  config.channelReadBytesPerSec = channelReadBytesPerSec;
+  config.channelWriteBytesPerSec = channelWriteBytesPerSec;
+  config.overProvisioning = overProvisioning;
+  config.pageSize = pageSize;
+  config.eraseBlockSize = eraseBlockSize;
+  config.eraseLatency = std::chrono::microseconds{eraseLatencyUs};
+  config.injectLatency = injectLatency;
+  return config;
+}
+
+folly::dynamic SimulatedDeviceProfile::toJson() const {
+  folly::dynamic json = folly::dynamic::object;
+  json["numChannels"] = numChannels;
+  json["channelStripeSize"] = channelStripeSize;
+  json["readLatencyP50Us"] = readLatencyP50Us;
+  json["readLatencyP99Us"] = readLatencyP99Us;
+  json["writeLatencyP50Us"] = writeLatencyP50Us;
+  json["writeLatencyP99Us"] = writeLatencyP99Us;
+  json["channelReadBytesPerSec"] = channelReadBytesPerSec;
+  json["channelWriteBytesPerSec"] = channelWriteBytesPerSec;
+  json["overProvisioning"] = overProvisioning;
+  json["pageSize"] = pageSize;
+  json["eraseBlockSize"] = eraseBlockSize;
+  json["eraseLatencyUs"] = eraseLatencyUs;
+  json["injectLatency"] = injectLatency;
+  return json;
+}
 
-  checkCorrectSize<MemoryTierConfig, 40>();
+navy::SimulatedDeviceConfig loadSimulatedDeviceProfile(
+    const std::string& path) {
+  std::string profile;
+  if (!folly::readFile(path.c_str(), profile)) {
+    throw std::invalid_argument(
+        folly::sformat("could not read file: {}", path));
+  }
+  return SimulatedDeviceProfile{folly::parseJson(profile)}
+      .getSimulatedDeviceConfig();
+}
+
+void writeCalibratedDeviceProfile(const navy::NavyConfig& navyConfig,
+                                  const std::string& path) {
+  if (!navyConfig.usesSimpleFile() && !navyConfig.usesRaidFiles()) {
+    throw std::invalid_argument(
+        "calibrating a simulated device needs nvmCachePaths");
+  }
+  const bool raid = navyConfig.usesRaidFiles();
+  const uint32_t stripeSize =
+      raid ? navyConfig.blockCache().getRegionSize() : 0;
+  auto device = navy::createFileDevice(
+      raid ? navyConfig.getRaidPaths()
+           : std::vector<std::string>{navyConfig.getFileName()},
+      raid ? navyConfig.getFileSize() / stripeSize * stripeSize
+           : navyConfig.getFileSize(),
+      navyConfig.getTruncateFile(), navyConfig.getBlockSize(), stripeSize,
+      0 /* max device write size */, navy::IoEngine::Sync, 0 /* qDepth */,
+      false /* FDP */, nullptr /* encryptor */, false /* exclusive owner */);
+  const auto config =
+      navy::calibrateSimulatedDevice(*device, navy::CalibrationOptions{});
+  const auto profile =
+      folly::toPrettyJson(SimulatedDeviceProfile{config}.toJson());
+  if (!folly::writeFile(profile, path.c_str())) {
+    throw std::runtime_error(
+        folly::sformat("could not write simulated device profile: {}", path));
+  }
+  XLOGF(INFO, "Wrote simulated device profile to {}", path);
 }
 } // namespace cachebench
 } // namespace cachelib
@@ -23,6 +23,7 @@
 #include "cachelib/cachebench/util/JSONConfig.h"
 #include "cachelib/common/Ticker.h"
 #include "cachelib/navy/common/Device.h"
+#include "cachelib/navy/common/SimulatedDevice.h"
 
 namespace facebook {
 namespace cachelib {
@@ -49,9 +50,13 @@ struct MemoryTierConfig : public JSONConfig {
 
   // Returns MemoryTierCacheConfig parsed from JSON config
   MemoryTierCacheConfig getMemoryTierCacheConfig() {
-    MemoryTierCacheConfig config = MemoryTierCacheConfig::fromShm();
+    MemoryTierCacheConfig config = file.empty()
+                                       ? MemoryTierCacheConfig::fromShm()
+                                       : MemoryTierCacheConfig::fromFile(file);
     config.setRatio(ratio);
-    config.setMemBind(NumaBitMask(memBindNodes));
+    if (!memBindNodes.empty()) {
+      config.setMemBind(NumaBitMask(memBindNodes));
+    }
     return config;
   }
 
@@ -59,8 +64,52 @@ struct MemoryTierConfig : public JSONConfig {
   size_t ratio{0};
   // Allocate memory only from specified NUMA nodes
   std::string memBindNodes{""};
+  // If set, the tier is backed by this file instead of shared memory.
+  // Requires cacheDir to be set.
+  std::string file{""};
 };
 
+// Performance model of a simulated SSD (see navy/common/SimulatedDevice.h),
+// as written by the calibration of a real device. Fields that are not set
+// keep the defaults of navy::SimulatedDeviceConfig.
+struct SimulatedDeviceProfile : public JSONConfig {
+  SimulatedDeviceProfile()
+      : SimulatedDeviceProfile(navy::SimulatedDeviceConfig{}) {}
+
+  explicit SimulatedDeviceProfile(const folly::dynamic& configJson);
+
+  explicit SimulatedDeviceProfile(const navy::SimulatedDeviceConfig& config);
+
+  navy::SimulatedDeviceConfig getSimulatedDeviceConfig() const;
+
+  folly::dynamic toJson() const;
+
+  uint32_t numChannels;
+  uint32_t channelStripeSize;
+  uint32_t readLatencyP50Us;
+  uint32_t readLatencyP99Us;
+  uint32_t writeLatencyP50Us;
+  uint32_t writeLatencyP99Us;
+  uint64_t channelReadBytesPerSec;
+  uint64_t channelWriteBytesPerSec;
+  double overProvisioning;
+  uint32_t pageSize;
+  uint32_t eraseBlockSize;
+  uint32_t eraseLatencyUs;
+  bool injectLatency;
+};
+
+// Reads the simulated device profile at @path
+// @throw std::invalid_argument if the file can not be read
+navy::SimulatedDeviceConfig loadSimulatedDeviceProfile(const std::string& path);
+
+// Calibrates a simulated device on the device(s) of @navyConfig and writes
+// the profile to @path. This overwrites the start of the device.
+// @throw std::invalid_argument if navy does not use files
+// @throw std::runtime_error if the device or the file can not be written
+void writeCalibratedDeviceProfile(const navy::NavyConfig& navyConfig,
+                                  const std::string& path);
+
 struct CacheConfig : public JSONConfig {
   // by defaullt, lru allocator. can be set to LRU-2Q.
   std::string allocator{"LRU"};
@@ -94,9 +143,13 @@ struct CacheConfig : public JSONConfig {
   bool tryLockUpdate{false};
   bool useCombinedLockForIterators{false};
 
-  // LRU param
+  // LRU params
   uint64_t lruIpSpec{0};
 
+  // items with a TTL of at most this many seconds are kept in a separate
+  // queue of the LRU. See MMLru::Config::ttlBandSecs. 0 disables it.
+  uint64_t lruTtlBandSecs{0};
+
   // 2Q params
   size_t lru2qHotPct{20};
   size_t lru2qColdPct{20};
@@ -122,6 +175,12 @@ struct CacheConfig : public JSONConfig {
   // raid0 fashion
   std::vector<std::string> nvmCachePaths{};
 
+  // JSON profile of a simulated SSD (see SimulatedDeviceProfile). When
+  // nvmCachePaths is empty, the in-memory NVM cache uses the latencies,
+  // parallelism and garbage collection of this profile instead of none.
+  // With navyCalibrateSimulatedDevice, the profile is written instead.
+  std::string navySimulatedDeviceProfile{};
+
   // size of the NVM for caching. When more than one device path is
   // specified, this is the size per device path. When this is non-zero and
   // nvmCachePaths is empty, an in-memory block device is used.
@@ -147,6 +206,10 @@ struct CacheConfig : public JSONConfig {
   // appropriate ratios.
   std::vector<unsigned int> navySegmentedFifoSegmentRatio{};
 
+  // If true, configures Navy to use CLOCK instead of LRU. Ignored when
+  // navySegmentedFifoSegmentRatio is set.
+  bool navyClockEviction{false};
+
   // Number of shards expressed as power of two for request ordering in
   // Navy. If 0, the default configuration of Navy(20) is used.
   uint64_t navyReqOrderShardsPower{21};
@@ -178,6 +241,13 @@ struct CacheConfig : public JSONConfig {
   // use a probability based reinsertion policy with navy
   uint64_t navyProbabilityReinsertionThreshold{0};
 
+  // promote the items with at least these many hits to DRAM when their navy
+  // region is reclaimed. 0 disables promotion.
+  uint64_t navyPromotionHitsThreshold{0};
+
+  // rate limit of the promotions to DRAM. 0 for no limit.
+  uint64_t navyPromotionMaxBytesPerSec{0};
+
   // number of asynchronous worker thread for navy read operation.
   uint32_t navyReaderThreads{32};
 
@@ -230,6 +300,21 @@ struct CacheConfig : public JSONConfig {
   // Enable the FDP Data placement mode in the device, if it is capable.
   bool deviceEnableFDP{false};
 
+  // Calibrate a simulated SSD on the device of nvmCachePaths before the run
+  // and write it to navySimulatedDeviceProfile, so that later runs can
+  // approximate this device on machines without one.
+  bool navyCalibrateSimulatedDevice{false};
+
+  // Metadata-only simulation for hit ratio studies: the items keep their
+  // sizes but their values are never populated or read, and the NVM cache
+  // runs on a sparse in-memory device that only stores the pages holding
+  // entry headers and keys. The eviction, rebalancing and admission code is
+  // the same as in a full run. This only removes the device: items still
+  // take their full size in DRAM, and NvmCache and BlockCache still copy
+  // the values of the items they write and read. Data checksums are turned
+  // off. nvmCachePaths are ignored, the sparse device is nvmCacheSizeMB.
+  bool metadataOnlySimulation{false};
+
   // Don't write to flash if cache TTL is smaller than this value.
   // Not used when its value is 0.  In seconds.
   uint32_t memoryOnlyTTL{0};
@@ -240,6 +325,10 @@ struct CacheConfig : public JSONConfig {
   // Lock memory in the RAM
   bool lockMemory{false};
 
+  // Number of threads used to fault in the cache memory at startup.
+  // Disabled when 0.
+  uint32_t memoryPrefaultThreads{0};
+
   // Memory tiers configs
   std::vector<MemoryTierCacheConfig> memoryTierConfigs{};
 
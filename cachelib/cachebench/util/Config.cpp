@@ -40,6 +40,7 @@ StressorConfig::StressorConfig(const folly::dynamic& configJson) {
 
   JSONSetVal(configJson, numOps);
   JSONSetVal(configJson, numThreads);
+  JSONSetVal(configJson, numFibersPerThread);
   JSONSetVal(configJson, numKeys);
 
   JSONSetVal(configJson, opDelayBatch);
@@ -82,6 +83,11 @@ StressorConfig::StressorConfig(const folly::dynamic& configJson) {
         ReplayGeneratorConfig{configJson["replayGeneratorConfig"]};
   }
 
+  if (configJson.count("backendConfig")) {
+    backendConfig =
+        std::make_shared<BackendConfig>(configJson["backendConfig"]);
+  }
+
   if (!traceFileName.empty() && !traceFileNames.empty()) {
     throw std::invalid_argument(
         folly::sformat("set only one of traceFileName or traceFileNames"));
@@ -90,7 +96,7 @@ StressorConfig::StressorConfig(const folly::dynamic& configJson) {
   // If you added new fields to the configuration, update the JSONSetVal
   // to make them available for the json configs and increment the size
   // below
-  checkCorrectSize<StressorConfig, 560>();
+  checkCorrectSize<StressorConfig, 584>();
 }
 
 bool StressorConfig::usesChainedItems() const {
@@ -139,6 +145,16 @@ CacheBenchConfig::CacheBenchConfig(
     cacheConfig_ = cacheConfigCustomizer ? cacheConfigCustomizer(cacheConfig)
                                          : cacheConfig;
   }
+
+  if (cacheConfig_.metadataOnlySimulation) {
+    if (stressorConfig_.checkConsistency) {
+      throw std::invalid_argument(
+          "metadataOnlySimulation does not populate the values to check");
+    }
+    // items only carry their size
+    stressorConfig_.populateItem = false;
+    stressorConfig_.touchValue = false;
+  }
 }
 
 DistributionConfig::DistributionConfig(const folly::dynamic& jsonConfig,
@@ -162,6 +178,9 @@ DistributionConfig::DistributionConfig(const folly::dynamic& jsonConfig,
 
   JSONSetVal(jsonConfig, popDistFile);
 
+  JSONSetVal(jsonConfig, ttlSecs);
+  JSONSetVal(jsonConfig, ttlSecsProbability);
+
   JSONSetVal(jsonConfig, getRatio);
   JSONSetVal(jsonConfig, setRatio);
   JSONSetVal(jsonConfig, delRatio);
@@ -194,7 +213,7 @@ DistributionConfig::DistributionConfig(const folly::dynamic& jsonConfig,
     JSONSetVal(configJsonPop, popularityWeights);
   }
 
-  checkCorrectSize<DistributionConfig, 368>();
+  checkCorrectSize<DistributionConfig, 416>();
 }
 
 ReplayGeneratorConfig::ReplayGeneratorConfig(const folly::dynamic& configJson) {
@@ -239,6 +258,27 @@ ReplayGeneratorConfig::getSerializationMode() const {
   return ReplayGeneratorConfig::SerializeMode::strict;
 }
 
+BackendConfig::BackendConfig(const folly::dynamic& configJson) {
+  JSONSetVal(configJson, latencyMedianUs);
+  JSONSetVal(configJson, latencyP99Us);
+  JSONSetVal(configJson, maxConcurrency);
+  JSONSetVal(configJson, maxQueueLength);
+  JSONSetVal(configJson, capacityQps);
+  JSONSetVal(configJson, overloadKnee);
+  JSONSetVal(configJson, overloadSlope);
+
+  if (overloadKnee < 0 || overloadKnee >= 1) {
+    throw std::invalid_argument(folly::sformat(
+        "overloadKnee must be in [0, 1). Actual: {}", overloadKnee));
+  }
+  if (overloadSlope < 0) {
+    throw std::invalid_argument(folly::sformat(
+        "overloadSlope must not be negative. Actual: {}", overloadSlope));
+  }
+
+  checkCorrectSize<BackendConfig, 48>();
+}
+
 MLAdmissionConfig::MLAdmissionConfig(const folly::dynamic& configJson) {
   JSONSetVal(configJson, modelPath);
   JSONSetVal(configJson, numericFeatures);
@@ -64,6 +64,11 @@ struct DistributionConfig : public JSONConfig {
   // loaded by the distribution
   std::string popDistFile{};
 
+  // TTL distribution. Each key gets one of the ttlSecs, picked with the
+  // matching probability. Keys have no TTL when empty.
+  std::vector<size_t> ttlSecs{};
+  std::vector<double> ttlSecsProbability{};
+
   // Operation distribution
   double getRatio{0.0};
   double setRatio{0.0};
@@ -173,6 +178,38 @@ struct ReplayGeneratorConfig : public JSONConfig {
   SerializeMode getSerializationMode() const;
 };
 
+// Emulated backend that lookaside misses fetch from. Fetches wait for a
+// service time drawn from a lognormal distribution with the given median and
+// p99, stretched by an overload curve once the arrival rate approaches the
+// capacity. At most maxConcurrency fetches are served at once and the rest
+// queue up to maxQueueLength; fetches beyond that are rejected.
+struct BackendConfig : public JSONConfig {
+  BackendConfig() {}
+
+  explicit BackendConfig(const folly::dynamic& configJson);
+
+  // median and 99th percentile of the service time when not overloaded. The
+  // service time is fixed at the median if the p99 is not above it.
+  uint64_t latencyMedianUs{1000};
+  uint64_t latencyP99Us{0};
+
+  // number of fetches served at once. 0 for no limit.
+  uint32_t maxConcurrency{0};
+
+  // number of fetches waiting for a slot before new ones are rejected. 0 for
+  // no limit. Only used with maxConcurrency.
+  uint32_t maxQueueLength{0};
+
+  // fetches per second the backend sustains. 0 for no overload.
+  uint64_t capacityQps{0};
+
+  // the service time is multiplied by
+  //   1 + overloadSlope * ((utilization - overloadKnee) / (1 - overloadKnee))^2
+  // once the utilization, i.e. arrival rate / capacityQps, is above the knee.
+  double overloadKnee{0.7};
+  double overloadSlope{10};
+};
+
 // The class defines the admission policy at stressor level. The stressor
 // checks the admission policy first before inserting an item into cache.
 //
@@ -200,7 +237,7 @@ struct StressorConfig : public JSONConfig {
   // standard stress test using the workload config against an instance of the
   // cache defined by the CacheConfig. Other supported options are
   // "high_refcount", "cachelib_map", cachelib_range_map", "fast_shutdown",
-  // "async"
+  // "async", "fiber"
   std::string name;
 
   // follow get misses with a set
@@ -235,6 +272,8 @@ struct StressorConfig : public JSONConfig {
 
   uint64_t numOps{0};     // operation per thread
   uint64_t numThreads{0}; // number of threads that will run
+  // number of concurrent fibers run by each thread of the "fiber" stressor
+  uint64_t numFibersPerThread{64};
   uint64_t numKeys{0};    // number of keys that will be used
 
   // Req generation throttling delay for each thread; those generated reqs are
@@ -295,6 +334,10 @@ struct StressorConfig : public JSONConfig {
   // admission policy for cache.
   std::shared_ptr<StressorAdmPolicy> admPolicy{};
 
+  // backend that lookaside misses fetch from. Misses are filled at no cost
+  // if not set.
+  std::shared_ptr<BackendConfig> backendConfig;
+
   StressorConfig() {}
   explicit StressorConfig(const folly::dynamic& configJson);
 
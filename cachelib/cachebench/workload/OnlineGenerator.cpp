@@ -47,6 +47,7 @@ OnlineGenerator::OnlineGenerator(const StressorConfig& config)
   generateFirstKeyIndexForPool();
   generateKeyLengths();
   generateSizes();
+  generateTtls();
   generateKeyWorkloadDistributions();
 }
 
@@ -61,6 +62,7 @@ const Request& OnlineGenerator::getReq(uint8_t poolId,
   req_->sizeBegin = sizes->begin();
   req_->sizeEnd = sizes->end();
   req_->key = key;
+  req_->ttlSecs = ttls_[poolId][keyIdx % ttls_[poolId].size()];
   auto op =
       static_cast<OpType>(workloadDist_[workloadIdx(poolId)].sampleOpDist(gen));
   req_->setOp(op);
@@ -125,6 +127,17 @@ void OnlineGenerator::generateSizes() {
   }
 }
 
+void OnlineGenerator::generateTtls() {
+  std::mt19937_64 gen(folly::Random::rand64());
+  for (size_t i = 0; i < config_.keyPoolDistribution.size(); i++) {
+    ttls_.emplace_back();
+    for (size_t j = 0; j < kNumUniqueTtls; j++) {
+      ttls_.back().emplace_back(
+          workloadDist_[workloadIdx(i)].sampleTtlDist(gen));
+    }
+  }
+}
+
 void OnlineGenerator::generateFirstKeyIndexForPool() {
   auto sumProb = std::accumulate(config_.keyPoolDistribution.begin(),
                                  config_.keyPoolDistribution.end(), 0.);
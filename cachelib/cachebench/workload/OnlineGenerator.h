@@ -57,6 +57,7 @@ class OnlineGenerator : public GeneratorBase {
   void generateKeyLengths();
 
   void generateSizes();
+  void generateTtls();
   typename std::vector<std::vector<size_t>>::iterator generateSize(
       uint8_t poolId, size_t idx);
   void generateKeyWorkloadDistributions();
@@ -75,6 +76,9 @@ class OnlineGenerator : public GeneratorBase {
   // the size corresponding to a key id is always the same.
   std::vector<std::vector<size_t>> keyLengths_;
 
+  // TTLs prepopulated per pool, so that a key id always gets the same TTL
+  std::vector<std::vector<uint32_t>> ttls_;
+
   // used for thread local intialization
   std::vector<size_t> dummy_;
 
@@ -95,6 +99,7 @@ class OnlineGenerator : public GeneratorBase {
 
   static constexpr size_t kNumUniqueKeyLengths{1ULL << 15};
   static constexpr size_t kNumUniqueSizes{1ULL << 15};
+  static constexpr size_t kNumUniqueTtls{1ULL << 15};
 };
 
 } // namespace cachebench
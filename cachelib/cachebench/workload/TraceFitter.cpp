@@ -0,0 +1,619 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/cachebench/workload/TraceFitter.h"
+
+#include <folly/Format.h>
+#include <folly/hash/Hash.h>
+#include <folly/hash/SpookyHashV2.h>
+#include <folly/lang/Bits.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+
+#include "cachelib/cachebench/workload/FastDiscrete.h"
+#include "cachelib/cachebench/workload/ReplayGeneratorBase.h"
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+
+namespace {
+// DistributionConfig ratio of each OpType
+constexpr std::array<const char*, static_cast<size_t>(OpType::kSize)>
+    kOpRatioNames = {"setRatio",        "getRatio",     "delRatio",
+                     "addChainedRatio", "loneGetRatio", "loneSetRatio",
+                     "updateRatio",     "couldExistRatio"};
+
+// bounds of the power of two buckets, see ReuseDistanceTracker
+uint64_t bucketLow(size_t i) { return i == 0 ? 0 : 1ULL << (i - 1); }
+uint64_t bucketHigh(size_t i) { return 1ULL << i; }
+
+size_t getBucket(uint64_t value, size_t numBuckets) {
+  return std::min<size_t>(folly::findLastSet(value), numBuckets - 1);
+}
+
+// power of two histogram of sizes
+using SizeHistogram = std::array<double, 64>;
+
+// Fills a piecewise distribution with one range per bucket of the
+// histogram, from its first to its last non empty bucket.
+void toPiecewise(const SizeHistogram& histogram,
+                 std::vector<double>& range,
+                 std::vector<double>& probability) {
+  size_t first = histogram.size();
+  size_t last = 0;
+  double total = 0;
+  for (size_t i = 0; i < histogram.size(); i++) {
+    if (histogram[i] > 0) {
+      first = std::min(first, i);
+      last = i;
+      total += histogram[i];
+    }
+  }
+  if (total == 0) {
+    return;
+  }
+  range.push_back(static_cast<double>(bucketLow(first)));
+  for (size_t i = first; i <= last; i++) {
+    range.push_back(static_cast<double>(bucketHigh(i)));
+    probability.push_back(histogram[i] / total);
+  }
+}
+} // namespace
+
+const TraceFitterConfig& TraceFitterConfig::validate() const {
+  if (sampleRate <= 0 || sampleRate > 1) {
+    throw std::invalid_argument(folly::sformat(
+        "Trace fitter sample rate must be in (0, 1], got {}", sampleRate));
+  }
+  if (maxPopularityBuckets == 0 || maxTtls == 0) {
+    throw std::invalid_argument(
+        "Trace fitter needs at least one popularity bucket and one TTL");
+  }
+  if (maxReuseDistanceDivergence < 0 || maxReuseDistanceDivergence > 1 ||
+      maxValSizeSkew < 0) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid trace fitter tolerances: reuse distance divergence {}, "
+        "value size skew {}",
+        maxReuseDistanceDivergence, maxValSizeSkew));
+  }
+  return *this;
+}
+
+ReuseDistanceTracker::ReuseDistanceTracker(double sampleRate)
+    : sampleRate_(sampleRate),
+      sampleThreshold_(static_cast<uint64_t>(
+          std::ceil(sampleRate * static_cast<double>(kSampleModulus)))) {}
+
+uint64_t ReuseDistanceTracker::countBefore(uint64_t pos) const noexcept {
+  uint64_t count = 0;
+  for (uint64_t i = pos; i > 0; i -= i & (~i + 1)) {
+    count += tree_[i];
+  }
+  return count;
+}
+
+void ReuseDistanceTracker::update(uint64_t pos, int64_t delta) noexcept {
+  for (uint64_t i = pos + 1; i < tree_.size(); i += i & (~i + 1)) {
+    tree_[i] = static_cast<uint32_t>(static_cast<int64_t>(tree_[i]) + delta);
+  }
+}
+
+void ReuseDistanceTracker::makeRoom() {
+  // Only the last access of each key matters for the distances, so the
+  // positions are renumbered densely in the same order.
+  std::vector<std::pair<uint64_t, uint64_t*>> live;
+  live.reserve(lastAccess_.size());
+  for (auto& [keyHash, pos] : lastAccess_) {
+    live.emplace_back(pos, &pos);
+  }
+  std::sort(live.begin(), live.end());
+
+  constexpr uint64_t kMinCapacity = 1024;
+  const uint64_t capacity =
+      std::max<uint64_t>(kMinCapacity, 2 * (live.size() + 1));
+  tree_.assign(capacity + 1, 0);
+  for (uint64_t i = 0; i < live.size(); i++) {
+    *live[i].second = i;
+    tree_[i + 1] = 1;
+  }
+  // builds the fenwick tree in place from the marks
+  for (uint64_t i = 1; i <= capacity; i++) {
+    const uint64_t parent = i + (i & (~i + 1));
+    if (parent <= capacity) {
+      tree_[parent] += tree_[i];
+    }
+  }
+  nextPos_ = live.size();
+}
+
+void ReuseDistanceTracker::access(uint64_t keyHash) {
+  if (!isSampled(keyHash)) {
+    return;
+  }
+  numAccesses_++;
+  if (nextPos_ + 1 >= tree_.size()) {
+    makeRoom();
+  }
+
+  auto [it, inserted] = lastAccess_.try_emplace(keyHash, nextPos_);
+  if (inserted) {
+    numColdMisses_++;
+  } else {
+    const uint64_t last = it->second;
+    // distinct sampled keys accessed since the last access to this one
+    const uint64_t distance = countBefore(nextPos_) - countBefore(last + 1);
+    const auto scaled = static_cast<uint64_t>(static_cast<double>(distance) /
+                                              sampleRate_);
+    distances_[getBucket(scaled, kNumBuckets)]++;
+    update(last, -1);
+    it->second = nextPos_;
+  }
+  update(nextPos_, 1);
+  nextPos_++;
+}
+
+void ReuseDistanceTracker::remove(uint64_t keyHash) {
+  if (!isSampled(keyHash)) {
+    return;
+  }
+  auto it = lastAccess_.find(keyHash);
+  if (it == lastAccess_.end()) {
+    return;
+  }
+  update(it->second, -1);
+  lastAccess_.erase(it);
+}
+
+double ReuseDistanceTracker::hitRatio(uint64_t numItems) const noexcept {
+  if (numAccesses_ == 0) {
+    return 0;
+  }
+  double hits = 0;
+  for (size_t i = 0; i < kNumBuckets; i++) {
+    const auto low = bucketLow(i);
+    const auto high = bucketHigh(i);
+    if (high <= numItems) {
+      hits += static_cast<double>(distances_[i]);
+    } else if (low < numItems) {
+      hits += static_cast<double>(distances_[i]) *
+              static_cast<double>(numItems - low) /
+              static_cast<double>(high - low);
+    }
+  }
+  return hits / static_cast<double>(numAccesses_);
+}
+
+uint64_t ReuseDistanceTracker::percentile(double fraction) const noexcept {
+  const auto total = numAccesses_ - numColdMisses_;
+  if (total == 0) {
+    return 0;
+  }
+  const auto target = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(fraction * total - 1e-6)));
+  uint64_t seen = 0;
+  size_t i = 0;
+  for (; i < kNumBuckets - 1; i++) {
+    seen += distances_[i];
+    if (seen >= target) {
+      break;
+    }
+  }
+  return bucketHigh(i) - 1;
+}
+
+double ReuseDistanceTracker::divergence(
+    const ReuseDistanceTracker& other) const noexcept {
+  const auto total = numAccesses_ - numColdMisses_;
+  const auto otherTotal = other.numAccesses_ - other.numColdMisses_;
+  if (total == 0 || otherTotal == 0) {
+    return total == otherTotal ? 0 : 1;
+  }
+  double diff = 0;
+  for (size_t i = 0; i < kNumBuckets; i++) {
+    diff += std::abs(static_cast<double>(distances_[i]) / total -
+                     static_cast<double>(other.distances_[i]) / otherTotal);
+  }
+  return diff / 2;
+}
+
+folly::dynamic FittedWorkload::toTestConfig() const {
+  auto toArray = [](const std::vector<double>& values) {
+    folly::dynamic array = folly::dynamic::array;
+    for (auto value : values) {
+      array.push_back(value);
+    }
+    return array;
+  };
+  auto toIntArray = [](const std::vector<size_t>& values) {
+    folly::dynamic array = folly::dynamic::array;
+    for (auto value : values) {
+      array.push_back(static_cast<int64_t>(value));
+    }
+    return array;
+  };
+
+  folly::dynamic config = folly::dynamic::object;
+  config["generator"] = "online";
+  config["numOps"] = static_cast<int64_t>(numOps);
+  config["numKeys"] = static_cast<int64_t>(numKeys);
+  config["keySizeRange"] = toArray(keySizeRange);
+  config["keySizeRangeProbability"] = toArray(keySizeRangeProbability);
+  config["valSizeRange"] = toArray(valSizeRange);
+  config["valSizeRangeProbability"] = toArray(valSizeRangeProbability);
+  config["popularityBuckets"] = toIntArray(popularityBuckets);
+  config["popularityWeights"] = toArray(popularityWeights);
+  if (!ttlSecs.empty()) {
+    config["ttlSecs"] = toIntArray(ttlSecs);
+    config["ttlSecsProbability"] = toArray(ttlSecsProbability);
+  }
+  for (size_t i = 0; i < opRatios.size(); i++) {
+    config[kOpRatioNames[i]] = opRatios[i];
+  }
+  return config;
+}
+
+double FidelityReport::meanAbsError() const noexcept {
+  if (hitRatioCurve.empty()) {
+    return 0;
+  }
+  double error = 0;
+  for (const auto& point : hitRatioCurve) {
+    error += std::abs(point.traceHitRatio - point.syntheticHitRatio);
+  }
+  return error / static_cast<double>(hitRatioCurve.size());
+}
+
+std::string FidelityReport::render(const FittedWorkload& workload) const {
+  std::string out;
+  for (const auto& warning : warnings) {
+    out += folly::sformat("WARNING: {}\n", warning);
+  }
+  out += folly::sformat("Fitted workload: {:,} ops over {:,} keys\n",
+                        workload.numOps, workload.numKeys);
+  for (size_t i = 0; i < workload.opRatios.size(); i++) {
+    if (workload.opRatios[i] > 0) {
+      out += folly::sformat("  {:16}: {:6.2f}%\n", kOpRatioNames[i],
+                            workload.opRatios[i] * 100);
+    }
+  }
+
+  out += folly::sformat(
+      "Value size by popularity (not reproduced): mean per key {:.0f}, "
+      "mean per request {:.0f}, skew {:.2f}%\n",
+      workload.meanValSizePerKey, workload.meanValSizePerRequest,
+      valSizeSkew * 100);
+  for (size_t i = 0; i < workload.popularityBuckets.size(); i++) {
+    out += folly::sformat(
+        "  keys {:>14,} requests {:6.2f}% mean value size {:.0f}\n",
+        workload.popularityBuckets[i], workload.popularityWeights[i] * 100,
+        workload.meanValSizeByPopularity[i]);
+  }
+
+  out += folly::sformat(
+      "Reuse distance in items (p50/p90/p99), cold miss ratio. "
+      "Divergence {:.2f}%\n",
+      reuseDistanceDivergence * 100);
+  out += folly::sformat("  trace     : {:>12,} {:>12,} {:>12,} {:6.2f}%\n",
+                        traceReuseDistances[0], traceReuseDistances[1],
+                        traceReuseDistances[2], traceColdMissRatio * 100);
+  out += folly::sformat("  synthetic : {:>12,} {:>12,} {:>12,} {:6.2f}%\n",
+                        syntheticReuseDistances[0], syntheticReuseDistances[1],
+                        syntheticReuseDistances[2],
+                        syntheticColdMissRatio * 100);
+
+  out += "LRU hit ratio by cache size in items (trace / synthetic)\n";
+  for (const auto& point : hitRatioCurve) {
+    out += folly::sformat("  {:>14,} : {:6.2f}% {:6.2f}%\n", point.numItems,
+                          point.traceHitRatio * 100,
+                          point.syntheticHitRatio * 100);
+  }
+  out += folly::sformat("Mean absolute hit ratio error: {:.2f}%\n",
+                        meanAbsError() * 100);
+  return out;
+}
+
+TraceFitter::TraceFitter(const TraceFitterConfig& config)
+    : config_(config.validate()), reuse_(config_.sampleRate) {}
+
+uint64_t TraceFitter::hashKey(folly::StringPiece key) noexcept {
+  return folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), 0);
+}
+
+void TraceFitter::addRequest(folly::StringPiece key,
+                             size_t keySize,
+                             size_t valueSize,
+                             OpType op,
+                             uint32_t ttlSecs,
+                             uint32_t opCount) {
+  const auto opIdx = static_cast<size_t>(op);
+  if (opCount == 0 || opIdx >= opCounts_.size()) {
+    numParseErrors_++;
+    return;
+  }
+  opCounts_[opIdx] += opCount;
+  numRequests_ += opCount;
+
+  const auto keyHash = hashKey(key);
+  if (!reuse_.isSampled(keyHash)) {
+    return;
+  }
+  if (op == OpType::kDel) {
+    reuse_.remove(keyHash);
+  } else {
+    for (uint32_t i = 0; i < opCount; i++) {
+      reuse_.access(keyHash);
+    }
+  }
+
+  auto& stats = sampledKeys_[keyHash];
+  stats.numOps += opCount;
+  stats.keySize = static_cast<uint32_t>(keySize);
+  if (op != OpType::kDel) {
+    stats.valueSize = static_cast<uint32_t>(valueSize);
+    stats.ttlSecs = ttlSecs;
+  }
+}
+
+uint64_t TraceFitter::readTrace(const StressorConfig& stressorConfig,
+                                uint64_t maxOps) {
+  auto config = stressorConfig;
+  config.repeatTraceReplay = false;
+  if (config.generator == "binary-replay") {
+    return readBinaryTrace(config, maxOps);
+  }
+  return readKVTrace(config, maxOps);
+}
+
+uint64_t TraceFitter::readKVTrace(const StressorConfig& config,
+                                  uint64_t maxOps) {
+  // same columns as KVReplayGenerator
+  enum Field : uint8_t { kKey = 0, kOp, kSize, kOpCount, kKeySize, kTtl };
+  const ColumnTable columnTable = {{kKey, true, {"key"}},
+                                   {kKeySize, false, {"key_size"}},
+                                   {kOp, true, {"op"}},
+                                   {kOpCount, false, {"op_count"}},
+                                   {kSize, true, {"size"}},
+                                   {kTtl, false, {"ttl"}}};
+  auto stream = std::make_unique<TraceFileStream>(config, 0, columnTable);
+
+  uint64_t numRead = 0;
+  std::string line;
+  try {
+    while (maxOps == 0 || numRead < maxOps) {
+      stream->getline(line);
+      if (!stream->setNextLine(line)) {
+        numParseErrors_++;
+        continue;
+      }
+      auto key = stream->getField<>(kKey);
+      auto op = stream->getField<>(kOp);
+      auto size = stream->getField<size_t>(kSize);
+      if (!key.hasValue() || !op.hasValue() || !size.hasValue()) {
+        numParseErrors_++;
+        continue;
+      }
+
+      OpType opType;
+      if (*op == "GET" || *op == "GET_LEASE") {
+        opType = OpType::kGet;
+      } else if (*op == "SET" || *op == "SET_LEASE") {
+        opType = OpType::kSet;
+      } else if (*op == "DELETE") {
+        opType = OpType::kDel;
+      } else {
+        numParseErrors_++;
+        continue;
+      }
+
+      // the keys are capped to 256 bytes like in KVReplayGenerator
+      const auto keySize = std::min<size_t>(
+          std::max<size_t>(stream->getField<size_t>(kKeySize).value_or(0),
+                           key->size()),
+          256);
+      addRequest(*key, keySize, *size, opType,
+                 stream->getField<uint32_t>(kTtl).value_or(0),
+                 stream->getField<uint32_t>(kOpCount).value_or(1));
+      numRead++;
+    }
+  } catch (const EndOfTrace&) {
+  }
+  return numRead;
+}
+
+uint64_t TraceFitter::readBinaryTrace(const StressorConfig& config,
+                                      uint64_t maxOps) {
+  BinaryFileStream stream(config);
+  const uint64_t numReqs = maxOps == 0
+                               ? stream.getNumReqs()
+                               : std::min(maxOps, stream.getNumReqs());
+  for (uint64_t i = 0; i < numReqs; i++) {
+    const auto* req = stream.getNextPtr(i);
+    const auto key = req->getKey();
+    addRequest(folly::StringPiece{key.data(), key.size()}, req->keySize_,
+               req->valueSize_, static_cast<OpType>(req->op_), req->ttl_,
+               req->repeats_);
+  }
+  return numReqs;
+}
+
+FittedWorkload TraceFitter::fit() const {
+  if (sampledKeys_.empty()) {
+    throw std::invalid_argument(
+        "No key of the trace was sampled, raise the sample rate");
+  }
+
+  FittedWorkload workload;
+  workload.numOps = numRequests_;
+  for (size_t i = 0; i < opCounts_.size(); i++) {
+    workload.opRatios[i] = static_cast<double>(opCounts_[i]) /
+                           static_cast<double>(numRequests_);
+  }
+
+  std::vector<const KeyStats*> keys;
+  keys.reserve(sampledKeys_.size());
+  SizeHistogram keySizes{};
+  SizeHistogram valueSizes{};
+  std::map<uint32_t, uint64_t> ttls;
+  uint64_t totalOps = 0;
+  double totalValueSize = 0;
+  double totalRequestedSize = 0;
+  for (const auto& [keyHash, stats] : sampledKeys_) {
+    keys.push_back(&stats);
+    keySizes[getBucket(stats.keySize, keySizes.size())]++;
+    valueSizes[getBucket(stats.valueSize, valueSizes.size())]++;
+    ttls[stats.ttlSecs]++;
+    totalOps += stats.numOps;
+    totalValueSize += stats.valueSize;
+    totalRequestedSize += static_cast<double>(stats.valueSize) *
+                          static_cast<double>(stats.numOps);
+  }
+  toPiecewise(keySizes, workload.keySizeRange,
+              workload.keySizeRangeProbability);
+  toPiecewise(valueSizes, workload.valSizeRange,
+              workload.valSizeRangeProbability);
+  workload.meanValSizePerKey = totalValueSize / keys.size();
+  workload.meanValSizePerRequest = totalRequestedSize / totalOps;
+
+  // The keys are grouped by popularity rank in log spaced buckets, so that
+  // the head of the distribution gets the finest buckets.
+  std::sort(keys.begin(), keys.end(), [](const auto* a, const auto* b) {
+    return a->numOps > b->numOps;
+  });
+  const size_t numBuckets = config_.maxPopularityBuckets;
+  size_t start = 0;
+  for (size_t b = 1; b <= numBuckets && start < keys.size(); b++) {
+    const auto bound = static_cast<size_t>(
+        std::floor(std::pow(static_cast<double>(keys.size()),
+                           static_cast<double>(b) / numBuckets)));
+    const size_t end =
+        b == numBuckets ? keys.size()
+                        : std::max(start + 1, std::min(keys.size(), bound));
+    uint64_t ops = 0;
+    double valueSize = 0;
+    for (size_t i = start; i < end; i++) {
+      ops += keys[i]->numOps;
+      valueSize += keys[i]->valueSize;
+    }
+    const auto numKeys = std::max<size_t>(
+        1, static_cast<size_t>(
+               std::llround((end - start) / config_.sampleRate)));
+    workload.popularityBuckets.push_back(numKeys);
+    workload.popularityWeights.push_back(static_cast<double>(ops) / totalOps);
+    workload.meanValSizeByPopularity.push_back(valueSize / (end - start));
+    workload.numKeys += numKeys;
+    start = end;
+  }
+
+  // the most common TTLs, weighted by key
+  if (ttls.size() > 1 || ttls.begin()->first != 0) {
+    std::vector<std::pair<uint64_t, uint32_t>> byCount;
+    for (const auto& [ttl, count] : ttls) {
+      byCount.emplace_back(count, ttl);
+    }
+    std::sort(byCount.rbegin(), byCount.rend());
+    byCount.resize(std::min(byCount.size(), config_.maxTtls));
+    uint64_t total = 0;
+    for (const auto& [count, ttl] : byCount) {
+      total += count;
+    }
+    for (const auto& [count, ttl] : byCount) {
+      workload.ttlSecs.push_back(ttl);
+      workload.ttlSecsProbability.push_back(static_cast<double>(count) /
+                                            total);
+    }
+  }
+  return workload;
+}
+
+FidelityReport TraceFitter::evaluate(const FittedWorkload& workload) const {
+  const uint64_t numOps =
+      config_.numSyntheticOps ? config_.numSyntheticOps : numRequests_;
+  FastDiscreteDistribution popularity(0, workload.numKeys - 1,
+                                      workload.popularityBuckets,
+                                      workload.popularityWeights);
+  std::discrete_distribution<size_t> ops(workload.opRatios.begin(),
+                                         workload.opRatios.end());
+  std::mt19937_64 gen(config_.seed);
+  ReuseDistanceTracker synthetic(config_.sampleRate);
+  for (uint64_t i = 0; i < numOps; i++) {
+    const auto keyHash = folly::hash::twang_mix64(popularity(gen));
+    if (static_cast<OpType>(ops(gen)) == OpType::kDel) {
+      synthetic.remove(keyHash);
+    } else {
+      synthetic.access(keyHash);
+    }
+  }
+
+  FidelityReport report;
+  for (uint64_t numItems = 1;; numItems *= 2) {
+    report.hitRatioCurve.push_back(
+        {numItems, reuse_.hitRatio(numItems), synthetic.hitRatio(numItems)});
+    if (numItems >= workload.numKeys ||
+        report.hitRatioCurve.size() == ReuseDistanceTracker::kNumBuckets) {
+      break;
+    }
+  }
+
+  constexpr std::array<double, 3> kPercentiles = {0.5, 0.9, 0.99};
+  for (size_t i = 0; i < kPercentiles.size(); i++) {
+    report.traceReuseDistances[i] = reuse_.percentile(kPercentiles[i]);
+    report.syntheticReuseDistances[i] = synthetic.percentile(kPercentiles[i]);
+  }
+  auto coldMissRatio = [](const ReuseDistanceTracker& tracker) {
+    return tracker.getNumAccesses() == 0
+               ? 0.
+               : static_cast<double>(tracker.getNumColdMisses()) /
+                     static_cast<double>(tracker.getNumAccesses());
+  };
+  report.traceColdMissRatio = coldMissRatio(reuse_);
+  report.syntheticColdMissRatio = coldMissRatio(synthetic);
+
+  report.reuseDistanceDivergence = reuse_.divergence(synthetic);
+  if (report.reuseDistanceDivergence > config_.maxReuseDistanceDivergence) {
+    report.warnings.push_back(folly::sformat(
+        "the reuse distances of the synthetic workload diverge from the "
+        "trace by {:.2f}% (tolerance {:.2f}%). The trace has temporal "
+        "locality that the generators do not reproduce, replay it instead.",
+        report.reuseDistanceDivergence * 100,
+        config_.maxReuseDistanceDivergence * 100));
+  }
+  report.valSizeSkew =
+      workload.meanValSizePerKey == 0
+          ? 0
+          : std::abs(workload.meanValSizePerRequest /
+                         workload.meanValSizePerKey -
+                     1);
+  if (report.valSizeSkew > config_.maxValSizeSkew) {
+    report.warnings.push_back(folly::sformat(
+        "the mean value size per request of the trace is {:.0f} against "
+        "{:.0f} per key (tolerance {:.2f}%). Value sizes depend on "
+        "popularity and the synthetic workload requests {:.0f} bytes per "
+        "request instead.",
+        workload.meanValSizePerRequest, workload.meanValSizePerKey,
+        config_.maxValSizeSkew * 100, workload.meanValSizePerKey));
+  }
+  return report;
+}
+
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/container/F14Map.h>
+#include <folly/json/dynamic.h>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "cachelib/cachebench/util/Config.h"
+#include "cachelib/cachebench/util/Request.h"
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+
+struct TraceFitterConfig {
+  // fraction of the keys, picked by the hash of the key, whose requests are
+  // used to fit the popularity, the sizes, the TTLs and the reuse distances.
+  // The op mix uses all the requests.
+  double sampleRate{0.01};
+
+  // maximum number of popularity buckets and of TTLs of the fitted workload
+  size_t maxPopularityBuckets{32};
+  size_t maxTtls{8};
+
+  // number of requests generated from the fitted workload to measure its hit
+  // ratio curve. 0 generates as many requests as the trace had.
+  uint64_t numSyntheticOps{0};
+
+  // seed of the generation of the synthetic requests
+  uint64_t seed{0};
+
+  // the fidelity report warns when the reuse distances of the synthetic
+  // requests diverge from the trace by more than this, in total variation
+  // distance between their histograms, from 0 for identical to 1 for
+  // disjoint.
+  double maxReuseDistanceDivergence{0.2};
+
+  // the fidelity report warns when the mean value size per request differs
+  // from the mean per key by more than this fraction. The synthetic workload
+  // picks sizes independently of popularity, so its two means are the same.
+  double maxValSizeSkew{0.2};
+
+  // @throw std::invalid_argument if the config is invalid
+  const TraceFitterConfig& validate() const;
+};
+
+// Estimates the hit ratio curve of a sequence of accesses from their stack
+// distances, i.e. the number of distinct keys accessed since the previous
+// access to the same key. An LRU cache of n items hits every access at a
+// distance below n. Only the keys sampled by their hash are tracked, and
+// their distances are scaled up by the inverse of the sample rate.
+class ReuseDistanceTracker {
+ public:
+  // Bucket 0 counts the distance 0 and bucket i > 0 counts the distances in
+  // [2^(i-1), 2^i).
+  static constexpr size_t kNumBuckets = 48;
+
+  explicit ReuseDistanceTracker(double sampleRate);
+
+  // @return true if the accesses to the key are tracked
+  bool isSampled(uint64_t keyHash) const noexcept {
+    return keyHash % kSampleModulus < sampleThreshold_;
+  }
+
+  // records an access to the key if it is sampled
+  void access(uint64_t keyHash);
+
+  // forgets the key, so that its next access is a cold miss
+  void remove(uint64_t keyHash);
+
+  // @return the fraction of the sampled accesses that hit in an LRU cache of
+  //         this many items. Distances are interpolated within a bucket.
+  double hitRatio(uint64_t numItems) const noexcept;
+
+  // @return the upper bound of the bucket holding this fraction of the
+  //         distances of the accesses that were not cold misses.
+  uint64_t percentile(double fraction) const noexcept;
+
+  // @return the total variation distance between the distributions over the
+  //         buckets of the distances of this tracker and of the other one, in
+  //         [0, 1]. Cold misses are not counted.
+  double divergence(const ReuseDistanceTracker& other) const noexcept;
+
+  uint64_t getNumAccesses() const noexcept { return numAccesses_; }
+  uint64_t getNumColdMisses() const noexcept { return numColdMisses_; }
+
+ private:
+  static constexpr uint64_t kSampleModulus = 1ULL << 24;
+
+  // number of marked positions in [0, pos)
+  uint64_t countBefore(uint64_t pos) const noexcept;
+  void update(uint64_t pos, int64_t delta) noexcept;
+
+  // makes room for the next position, by renumbering the live positions
+  // densely into a tree of twice their number.
+  void makeRoom();
+
+  const double sampleRate_;
+  const uint64_t sampleThreshold_;
+
+  // position of the last access of each tracked key
+  folly::F14FastMap<uint64_t, uint64_t> lastAccess_;
+
+  // fenwick tree over the positions, counting the ones that are the last
+  // access of their key. 1-based, so its size is the capacity plus one.
+  std::vector<uint32_t> tree_;
+  uint64_t nextPos_{0};
+
+  std::array<uint64_t, kNumBuckets> distances_{};
+  uint64_t numAccesses_{0};
+  uint64_t numColdMisses_{0};
+};
+
+// Synthetic workload fitted to a trace, in the terms of DistributionConfig
+struct FittedWorkload {
+  uint64_t numOps{0};
+  uint64_t numKeys{0};
+
+  // share of each OpType in the trace
+  std::array<double, static_cast<size_t>(OpType::kSize)> opRatios{};
+
+  // piecewise distributions of the key and value sizes
+  std::vector<double> keySizeRange;
+  std::vector<double> keySizeRangeProbability;
+  std::vector<double> valSizeRange;
+  std::vector<double> valSizeRangeProbability;
+
+  // keys ordered by decreasing popularity, grouped in log spaced ranks
+  std::vector<size_t> popularityBuckets;
+  std::vector<double> popularityWeights;
+
+  std::vector<size_t> ttlSecs;
+  std::vector<double> ttlSecsProbability;
+
+  // Sizes by popularity, which the synthetic workload does not reproduce
+  // since it picks the size of a key independently of its popularity. The
+  // mean value size per popularity bucket, and the mean over the keys
+  // compared to the mean over the requests, whose skew the fidelity report
+  // checks against TraceFitterConfig::maxValSizeSkew.
+  std::vector<double> meanValSizeByPopularity;
+  double meanValSizePerKey{0};
+  double meanValSizePerRequest{0};
+
+  // @return the test_config of a cachebench config generating this workload
+  //         with the online generator.
+  folly::dynamic toTestConfig() const;
+};
+
+// Hit ratio curves of the trace and of the workload fitted to it
+struct FidelityReport {
+  struct Point {
+    uint64_t numItems{0};
+    double traceHitRatio{0};
+    double syntheticHitRatio{0};
+  };
+  std::vector<Point> hitRatioCurve;
+
+  // reuse distance percentiles, in items
+  std::array<uint64_t, 3> traceReuseDistances{};
+  std::array<uint64_t, 3> syntheticReuseDistances{};
+
+  // fraction of the accesses that are the first to their key
+  double traceColdMissRatio{0};
+  double syntheticColdMissRatio{0};
+
+  // see ReuseDistanceTracker::divergence
+  double reuseDistanceDivergence{0};
+
+  // relative difference of the mean value size per request and per key
+  double valSizeSkew{0};
+
+  // what the fitted workload does not reproduce beyond the tolerances of
+  // TraceFitterConfig. Empty if the workload is faithful to the trace.
+  std::vector<std::string> warnings;
+
+  // mean absolute difference of the hit ratios over the curve
+  double meanAbsError() const noexcept;
+
+  std::string render(const FittedWorkload& workload) const;
+};
+
+// Fits a synthetic workload to a trace: the op mix, the popularity of the
+// keys, the key and value sizes and the TTLs. The temporal locality of the
+// trace, beyond what the popularity explains, and the correlation of value
+// sizes with popularity are not reproduced by the generators. The fidelity
+// report compares the hit ratio curves and reuse distances of the trace and
+// of requests generated from the fitted workload, and warns when either
+// diverges beyond the tolerances of the config.
+class TraceFitter {
+ public:
+  explicit TraceFitter(const TraceFitterConfig& config);
+
+  // records a request of the trace
+  //
+  // @param opCount   number of times the request is repeated
+  void addRequest(folly::StringPiece key,
+                  size_t keySize,
+                  size_t valueSize,
+                  OpType op,
+                  uint32_t ttlSecs,
+                  uint32_t opCount = 1);
+
+  // reads the trace of a replay config. The trace is in the binary format
+  // for the binary-replay generator and in the csv format of the replay
+  // generator otherwise.
+  //
+  // @param maxOps    stop after this many requests, 0 to read all
+  // @return number of requests read
+  uint64_t readTrace(const StressorConfig& config, uint64_t maxOps = 0);
+
+  // @throw std::invalid_argument if no key of the trace was sampled
+  FittedWorkload fit() const;
+
+  // generates requests from the workload and compares their hit ratio curve
+  // to the one of the trace
+  FidelityReport evaluate(const FittedWorkload& workload) const;
+
+  uint64_t getNumRequests() const noexcept { return numRequests_; }
+  uint64_t getNumParseErrors() const noexcept { return numParseErrors_; }
+
+  static uint64_t hashKey(folly::StringPiece key) noexcept;
+
+ private:
+  struct KeyStats {
+    uint64_t numOps{0};
+    uint32_t keySize{0};
+    uint32_t valueSize{0};
+    uint32_t ttlSecs{0};
+  };
+
+  uint64_t readKVTrace(const StressorConfig& config, uint64_t maxOps);
+  uint64_t readBinaryTrace(const StressorConfig& config, uint64_t maxOps);
+
+  const TraceFitterConfig config_;
+
+  std::array<uint64_t, static_cast<size_t>(OpType::kSize)> opCounts_{};
+  uint64_t numRequests_{0};
+  uint64_t numParseErrors_{0};
+
+  // stats of the sampled keys, by the hash of the key
+  folly::F14FastMap<uint64_t, KeyStats> sampledKeys_;
+
+  ReuseDistanceTracker reuse_;
+};
+
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
@@ -50,7 +50,9 @@ class WorkloadDistribution {
                         config_.chainedItemLengthRangeProbability.begin()),
         keySizeDist_(config_.keySizeRange.begin(),
                      config_.keySizeRange.end(),
-                     config_.keySizeRangeProbability.begin()) {
+                     config_.keySizeRangeProbability.begin()),
+        ttlDist_(config_.ttlSecsProbability.begin(),
+                 config_.ttlSecsProbability.end()) {
     if (config_.valSizeRange.size() != config_.valSizeRangeProbability.size() &&
         config_.valSizeRange.size() !=
             config_.valSizeRangeProbability.size() + 1) {
@@ -60,6 +62,12 @@ class WorkloadDistribution {
           "test config.");
     }
 
+    if (config_.ttlSecs.size() != config_.ttlSecsProbability.size()) {
+      throw std::invalid_argument(
+          "TTLs and their probabilities do not match up. Check your test "
+          "config.");
+    }
+
     if (opDist_.probabilities().size() != static_cast<uint8_t>(OpType::kSize)) {
       throw std::invalid_argument(
           "Operation Distribution must cover all possible operations");
@@ -87,6 +95,14 @@ class WorkloadDistribution {
 
   double sampleKeySizeDist(std::mt19937_64& gen) { return keySizeDist_(gen); }
 
+  // @return the TTL in seconds, 0 if no TTL distribution is configured
+  uint32_t sampleTtlDist(std::mt19937_64& gen) {
+    if (config_.ttlSecs.empty()) {
+      return 0;
+    }
+    return static_cast<uint32_t>(config_.ttlSecs[ttlDist_(gen)]);
+  }
+
   // unlike other sources, we let the workload generator directly make copies
   // of the base popularity distribution and sample from that.
   std::unique_ptr<Distribution> getPopDist(size_t left, size_t right) const {
@@ -136,6 +152,7 @@ class WorkloadDistribution {
   std::piecewise_constant_distribution<double> chainedValDist_;
   std::piecewise_constant_distribution<double> chainedLenDist_;
   std::piecewise_constant_distribution<double> keySizeDist_;
+  std::discrete_distribution<size_t> ttlDist_;
 };
 } // namespace cachebench
 } // namespace cachelib
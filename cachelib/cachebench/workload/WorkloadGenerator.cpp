@@ -128,6 +128,7 @@ void WorkloadGenerator::generateReqs() {
       sizes_.emplace_back(chainSizes);
       auto reqSizes = sizes_.end() - 1;
       reqs_.emplace_back(keys_[j], reqSizes->begin(), reqSizes->end());
+      reqs_.back().ttlSecs = workloadDist_[idx].sampleTtlDist(gen);
     }
   }
 }
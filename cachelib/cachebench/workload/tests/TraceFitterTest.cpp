@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Format.h>
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <random>
+
+#include "cachelib/cachebench/util/Config.h"
+#include "cachelib/cachebench/workload/TraceFitter.h"
+
+namespace facebook {
+namespace cachelib {
+namespace cachebench {
+namespace {
+TraceFitterConfig fullSampling() {
+  TraceFitterConfig config;
+  config.sampleRate = 1.0;
+  return config;
+}
+} // namespace
+
+TEST(TraceFitterTest, ReuseDistances) {
+  ReuseDistanceTracker tracker{1.0};
+  // enough rounds to renumber the positions several times
+  for (int round = 0; round < 5000; round++) {
+    for (uint64_t key = 0; key < 10; key++) {
+      tracker.access(key);
+    }
+  }
+  EXPECT_EQ(50000, tracker.getNumAccesses());
+  EXPECT_EQ(10, tracker.getNumColdMisses());
+
+  // every reuse is at a distance of 9, in the bucket [8, 16)
+  EXPECT_EQ(0, tracker.hitRatio(8));
+  EXPECT_DOUBLE_EQ(49990.0 / 50000, tracker.hitRatio(16));
+  EXPECT_EQ(15, tracker.percentile(0.5));
+  EXPECT_EQ(15, tracker.percentile(0.99));
+
+  tracker.remove(3);
+  tracker.access(3);
+  EXPECT_EQ(11, tracker.getNumColdMisses());
+}
+
+TEST(TraceFitterTest, ReuseDistancesMixed) {
+  ReuseDistanceTracker tracker{1.0};
+  // a b a c c b: distances 1, 0 and 2
+  for (uint64_t key : {1, 2, 1, 3, 3, 2}) {
+    tracker.access(key);
+  }
+  EXPECT_EQ(3, tracker.getNumColdMisses());
+  EXPECT_DOUBLE_EQ(1.0 / 6, tracker.hitRatio(1));
+  EXPECT_DOUBLE_EQ(2.0 / 6, tracker.hitRatio(2));
+  EXPECT_DOUBLE_EQ(3.0 / 6, tracker.hitRatio(4));
+  EXPECT_EQ(0, tracker.percentile(0.3));
+  EXPECT_EQ(3, tracker.percentile(1.0));
+}
+
+TEST(TraceFitterTest, InvalidConfig) {
+  TraceFitterConfig config;
+  config.sampleRate = 0;
+  EXPECT_THROW(TraceFitter{config}, std::invalid_argument);
+  config.sampleRate = 1.5;
+  EXPECT_THROW(TraceFitter{config}, std::invalid_argument);
+  config.sampleRate = 1;
+  config.maxReuseDistanceDivergence = 1.5;
+  EXPECT_THROW(TraceFitter{config}, std::invalid_argument);
+
+  TraceFitter fitter{fullSampling()};
+  EXPECT_THROW(fitter.fit(), std::invalid_argument);
+}
+
+TEST(TraceFitterTest, Fit) {
+  TraceFitter fitter{fullSampling()};
+  // key i is set once and read 100 - i times, half of the keys with a TTL
+  for (int i = 0; i < 100; i++) {
+    const auto key = folly::sformat("key{:02}", i);
+    fitter.addRequest(key, key.size(), 100, OpType::kSet, i % 2 ? 0 : 60);
+    fitter.addRequest(key, key.size(), 100, OpType::kGet, i % 2 ? 0 : 60,
+                      100 - i);
+  }
+  fitter.addRequest("key00", 5, 0, OpType::kDel, 0, 50);
+  EXPECT_EQ(5200, fitter.getNumRequests());
+
+  const auto workload = fitter.fit();
+  EXPECT_EQ(5200, workload.numOps);
+  EXPECT_EQ(100, workload.numKeys);
+  EXPECT_DOUBLE_EQ(100.0 / 5200,
+                   workload.opRatios[static_cast<size_t>(OpType::kSet)]);
+  EXPECT_DOUBLE_EQ(5050.0 / 5200,
+                   workload.opRatios[static_cast<size_t>(OpType::kGet)]);
+  EXPECT_DOUBLE_EQ(50.0 / 5200,
+                   workload.opRatios[static_cast<size_t>(OpType::kDel)]);
+
+  EXPECT_EQ((std::vector<double>{4, 8}), workload.keySizeRange);
+  EXPECT_EQ((std::vector<double>{64, 128}), workload.valSizeRange);
+  EXPECT_EQ((std::vector<double>{1.0}), workload.valSizeRangeProbability);
+
+  EXPECT_EQ(100, std::accumulate(workload.popularityBuckets.begin(),
+                                 workload.popularityBuckets.end(), 0UL));
+  EXPECT_NEAR(1.0,
+              std::accumulate(workload.popularityWeights.begin(),
+                              workload.popularityWeights.end(), 0.0),
+              1e-9);
+  // the most popular key is alone in the first bucket
+  EXPECT_EQ(1, workload.popularityBuckets.front());
+  EXPECT_DOUBLE_EQ(151.0 / 5200, workload.popularityWeights.front());
+
+  ASSERT_EQ(2, workload.ttlSecs.size());
+  EXPECT_DOUBLE_EQ(0.5, workload.ttlSecsProbability[0]);
+  EXPECT_DOUBLE_EQ(100, workload.meanValSizePerKey);
+}
+
+TEST(TraceFitterTest, TestConfig) {
+  TraceFitter fitter{fullSampling()};
+  for (int i = 0; i < 1000; i++) {
+    const auto key = folly::sformat("key{}", i % 50);
+    fitter.addRequest(key, key.size(), 1000 + i % 50,
+                      i % 4 ? OpType::kGet : OpType::kSet, 0);
+  }
+  const auto workload = fitter.fit();
+  const auto json = workload.toTestConfig();
+  EXPECT_EQ("online", json["generator"].asString());
+  EXPECT_EQ(0, json.count("ttlSecs"));
+
+  DistributionConfig config{json, ""};
+  EXPECT_DOUBLE_EQ(0.75, config.getRatio);
+  EXPECT_DOUBLE_EQ(0.25, config.setRatio);
+  EXPECT_EQ(workload.popularityBuckets, config.popularityBuckets);
+  EXPECT_EQ(workload.valSizeRange, config.valSizeRange);
+}
+
+TEST(TraceFitterTest, Evaluate) {
+  auto fitterConfig = fullSampling();
+  fitterConfig.seed = 1;
+  TraceFitter fitter{fitterConfig};
+  std::mt19937_64 gen{1};
+  std::geometric_distribution<uint64_t> dist{0.01};
+  for (int i = 0; i < 100000; i++) {
+    const auto key = folly::sformat("key{}", dist(gen));
+    fitter.addRequest(key, key.size(), 100, OpType::kGet, 0);
+  }
+  const auto workload = fitter.fit();
+  const auto report = fitter.evaluate(workload);
+
+  ASSERT_FALSE(report.hitRatioCurve.empty());
+  EXPECT_GE(report.hitRatioCurve.back().numItems, workload.numKeys);
+  for (size_t i = 1; i < report.hitRatioCurve.size(); i++) {
+    EXPECT_GE(report.hitRatioCurve[i].traceHitRatio,
+              report.hitRatioCurve[i - 1].traceHitRatio);
+  }
+  EXPECT_NEAR(1 - report.traceColdMissRatio,
+              report.hitRatioCurve.back().traceHitRatio, 1e-9);
+
+  // the trace has no temporal locality beyond its popularity, which the
+  // fitted workload reproduces
+  EXPECT_LT(report.meanAbsError(), 0.1);
+  EXPECT_LT(report.reuseDistanceDivergence, 0.2);
+  EXPECT_DOUBLE_EQ(0, report.valSizeSkew);
+  EXPECT_TRUE(report.warnings.empty());
+  EXPECT_FALSE(report.render(workload).empty());
+}
+
+TEST(TraceFitterTest, EvaluateDivergence) {
+  TraceFitter fitter{fullSampling()};
+  // every key is read 10 times in a row, so that all the reuse distances of
+  // the trace are 0, and the first 10 keys have values 100 times larger and
+  // are read 10 times more.
+  for (int i = 0; i < 1000; i++) {
+    const auto key = folly::sformat("key{}", i);
+    const bool hot = i < 10;
+    fitter.addRequest(key, key.size(), hot ? 10000 : 100, OpType::kGet, 0,
+                      hot ? 100 : 10);
+  }
+  const auto workload = fitter.fit();
+  const auto report = fitter.evaluate(workload);
+
+  EXPECT_GT(report.reuseDistanceDivergence, 0.5);
+  EXPECT_GT(report.valSizeSkew, 0.2);
+  ASSERT_EQ(2, report.warnings.size());
+  EXPECT_NE(std::string::npos,
+            report.render(workload).find("WARNING: the reuse distances"));
+
+  // no warnings within the tolerances
+  auto config = fullSampling();
+  config.maxReuseDistanceDivergence = 1;
+  config.maxValSizeSkew = 100;
+  TraceFitter tolerant{config};
+  for (int i = 0; i < 1000; i++) {
+    const auto key = folly::sformat("key{}", i);
+    tolerant.addRequest(key, key.size(), i < 10 ? 10000 : 100, OpType::kGet,
+                        0, i < 10 ? 100 : 10);
+  }
+  EXPECT_TRUE(tolerant.evaluate(tolerant.fit()).warnings.empty());
+}
+} // namespace cachebench
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/common/BackgroundExecutor.h"
+
+#include <folly/Format.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+#include <time.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace facebook {
+namespace cachelib {
+
+namespace {
+uint64_t getThreadCpuTimeNs() {
+  timespec ts{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+}
+
+const char* toString(BackgroundExecutor::Priority priority) {
+  switch (priority) {
+  case BackgroundExecutor::Priority::kLow:
+    return "low";
+  case BackgroundExecutor::Priority::kNormal:
+    return "normal";
+  case BackgroundExecutor::Priority::kHigh:
+    return "high";
+  }
+  return "unknown";
+}
+} // namespace
+
+const BackgroundExecutor::Config& BackgroundExecutor::Config::validate()
+    const {
+  if (numThreads == 0) {
+    throw std::invalid_argument(
+        "Background executor needs at least one thread");
+  }
+  if (cpuBudget < 0) {
+    throw std::invalid_argument(
+        folly::sformat("Invalid background CPU budget: {}", cpuBudget));
+  }
+  if (cpuBudget > 0 && burstWindow.count() <= 0) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid background burst window: {}ms", burstWindow.count()));
+  }
+  return *this;
+}
+
+BackgroundExecutor::BackgroundExecutor(Config config)
+    : config_{config.validate()},
+      maxBudgetNs_{config_.cpuBudget *
+                   std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       config_.burstWindow)
+                       .count()},
+      budgetNs_{maxBudgetNs_},
+      lastRefill_{Clock::now()} {
+  for (unsigned int i = 0; i < config_.numThreads; i++) {
+    threads_.emplace_back([this]() { loop(); });
+    folly::setThreadName(threads_.back().native_handle(),
+                         folly::sformat("cachelib_bg_{}", i));
+  }
+  XLOGF(INFO, "Background executor: {} threads, CPU budget: {} cores",
+        config_.numThreads, config_.cpuBudget);
+}
+
+BackgroundExecutor::~BackgroundExecutor() {
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+BackgroundExecutor::TaskId BackgroundExecutor::addTask(folly::StringPiece name,
+                                                       Priority priority,
+                                                       Task task) {
+  auto state = std::make_unique<TaskState>();
+  state->task = std::move(task);
+  state->stats.name = name.str();
+  state->stats.priority = priority;
+  state->due = Clock::now();
+
+  TaskId id;
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    id = nextId_++;
+    tasks_.emplace(id, std::move(state));
+  }
+  cond_.notify_one();
+  return id;
+}
+
+bool BackgroundExecutor::removeTask(TaskId id,
+                                    std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> l(mutex_);
+  auto it = tasks_.find(id);
+  if (it == tasks_.end()) {
+    return true;
+  }
+  auto& state = *it->second;
+  state.removing = true;
+  auto done = [&state]() { return !state.running; };
+  if (timeout == std::chrono::milliseconds::zero()) {
+    runDone_.wait(l, done);
+  } else if (!runDone_.wait_for(l, timeout, done)) {
+    state.removing = false;
+    return false;
+  }
+  tasks_.erase(id);
+  return true;
+}
+
+void BackgroundExecutor::wakeUp(TaskId id) {
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    auto it = tasks_.find(id);
+    if (it == tasks_.end()) {
+      return;
+    }
+    if (it->second->running) {
+      it->second->wakeUp = true;
+      return;
+    }
+    it->second->due = Clock::now();
+  }
+  cond_.notify_one();
+}
+
+void BackgroundExecutor::refillLocked(Clock::time_point now) {
+  if (config_.cpuBudget == 0) {
+    return;
+  }
+  const auto elapsedNs =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastRefill_)
+          .count();
+  if (elapsedNs > 0) {
+    budgetNs_ =
+        std::min(maxBudgetNs_, budgetNs_ + elapsedNs * config_.cpuBudget);
+    lastRefill_ = now;
+  }
+}
+
+BackgroundExecutor::TaskState* BackgroundExecutor::pickLocked(
+    Clock::time_point now, Clock::time_point& waitUntil) {
+  refillLocked(now);
+  const bool overBudget = config_.cpuBudget > 0 && budgetNs_ <= 0;
+
+  TaskState* best = nullptr;
+  for (auto& [id, state] : tasks_) {
+    if (state->running || state->removing) {
+      continue;
+    }
+    if (state->due > now) {
+      waitUntil = std::min(waitUntil, state->due);
+      continue;
+    }
+    if (overBudget && state->stats.priority != Priority::kHigh) {
+      if (!state->throttled) {
+        state->throttled = true;
+        state->stats.numThrottled++;
+        numThrottled_++;
+      }
+      // check again once the budget is back
+      waitUntil = std::min(
+          waitUntil,
+          now + std::chrono::nanoseconds(
+                    static_cast<int64_t>(-budgetNs_ / config_.cpuBudget)) +
+              std::chrono::milliseconds{1});
+      continue;
+    }
+    if (best == nullptr || state->stats.priority > best->stats.priority ||
+        (state->stats.priority == best->stats.priority &&
+         state->due < best->due)) {
+      best = state.get();
+    }
+  }
+  return best;
+}
+
+void BackgroundExecutor::loop() {
+  std::unique_lock<std::mutex> l(mutex_);
+  while (!stop_) {
+    const auto now = Clock::now();
+    auto waitUntil = Clock::time_point::max();
+    auto* state = pickLocked(now, waitUntil);
+    if (state == nullptr) {
+      if (waitUntil == Clock::time_point::max()) {
+        cond_.wait(l);
+      } else {
+        cond_.wait_until(l, waitUntil);
+      }
+      continue;
+    }
+
+    const auto lagMs = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - state->due)
+            .count());
+    state->stats.lastLagMs = lagMs;
+    state->stats.maxLagMs = std::max(state->stats.maxLagMs, lagMs);
+    state->running = true;
+    state->throttled = false;
+    state->wakeUp = false;
+    l.unlock();
+
+    // the state stays around while running, see removeTask()
+    const auto cpuStart = getThreadCpuTimeNs();
+    std::chrono::milliseconds delay = state->lastDelay;
+    try {
+      delay = state->task();
+    } catch (const std::exception& e) {
+      XLOGF(ERR, "Background task {} failed: {}", state->stats.name,
+            e.what());
+    }
+    const auto cpuTimeNs = getThreadCpuTimeNs() - cpuStart;
+
+    l.lock();
+    state->running = false;
+    state->lastDelay = delay;
+    state->due = state->wakeUp ? Clock::now() : Clock::now() + delay;
+    state->stats.numRuns++;
+    state->stats.cpuTimeNs += cpuTimeNs;
+    totalCpuTimeNs_ += cpuTimeNs;
+    if (config_.cpuBudget > 0) {
+      budgetNs_ -= cpuTimeNs;
+    }
+    runDone_.notify_all();
+  }
+}
+
+std::vector<BackgroundExecutor::TaskStats> BackgroundExecutor::getTaskStats()
+    const {
+  std::vector<TaskStats> stats;
+  std::lock_guard<std::mutex> l(mutex_);
+  stats.reserve(tasks_.size());
+  for (const auto& [id, state] : tasks_) {
+    stats.push_back(state->stats);
+  }
+  return stats;
+}
+
+void BackgroundExecutor::getCounters(
+    const util::CounterVisitor& visitor) const {
+  uint64_t totalCpuTimeNs;
+  uint64_t numThrottled;
+  double budgetNs;
+  {
+    std::lock_guard<std::mutex> l(mutex_);
+    totalCpuTimeNs = totalCpuTimeNs_;
+    numThrottled = numThrottled_;
+    budgetNs = budgetNs_;
+  }
+  visitor("cachelib_bg_executor.cpu_time_us", totalCpuTimeNs / 1000,
+          util::CounterVisitor::CounterType::RATE);
+  visitor("cachelib_bg_executor.throttled", numThrottled,
+          util::CounterVisitor::CounterType::RATE);
+  if (config_.cpuBudget > 0) {
+    visitor("cachelib_bg_executor.budget_us", budgetNs / 1000,
+            util::CounterVisitor::CounterType::COUNT);
+  }
+
+  for (const auto& stats : getTaskStats()) {
+    const auto prefix = folly::sformat("cachelib_bg_executor.{}.{}",
+                                       toString(stats.priority), stats.name);
+    visitor(prefix + ".runs", stats.numRuns,
+            util::CounterVisitor::CounterType::RATE);
+    visitor(prefix + ".cpu_time_us", stats.cpuTimeNs / 1000,
+            util::CounterVisitor::CounterType::RATE);
+    visitor(prefix + ".throttled", stats.numThrottled,
+            util::CounterVisitor::CounterType::RATE);
+    visitor(prefix + ".lag_ms", stats.lastLagMs,
+            util::CounterVisitor::CounterType::COUNT);
+    visitor(prefix + ".max_lag_ms", stats.maxLagMs,
+            util::CounterVisitor::CounterType::COUNT);
+  }
+}
+
+} // namespace cachelib
+} // namespace facebook
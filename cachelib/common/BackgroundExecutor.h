@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cachelib/common/Utils.h"
+
+namespace facebook {
+namespace cachelib {
+
+// Runs the periodic background tasks of one or more caches on a small, shared
+// pool of threads, instead of a thread per task. The total CPU time the tasks
+// use can be capped with a budget: once it is used up, only high priority
+// tasks run until it is replenished. Due tasks run in the order of their
+// priority and then of their due time.
+//
+// Tasks are typically PeriodicWorkers started with an executor (see
+// PeriodicWorker::start). A task never runs concurrently with itself.
+class BackgroundExecutor {
+ public:
+  enum class Priority : uint8_t { kLow = 0, kNormal = 1, kHigh = 2 };
+
+  struct Config {
+    // number of threads running the tasks
+    unsigned int numThreads{2};
+
+    // CPU time the tasks may use on average, in cores. e.g. 0.5 allows them
+    // to use half a core. 0 means no limit.
+    double cpuBudget{0};
+
+    // unused budget is accumulated up to this much time, which bounds the
+    // length of a burst
+    std::chrono::milliseconds burstWindow{1000};
+
+    // Checks invariants. Throws exception if failed.
+    const Config& validate() const;
+  };
+
+  // Returns the delay until the next run of the task
+  using Task = std::function<std::chrono::milliseconds()>;
+  using TaskId = uint64_t;
+
+  struct TaskStats {
+    std::string name;
+    Priority priority{Priority::kNormal};
+
+    // number of completed runs
+    uint64_t numRuns{0};
+
+    // CPU time used by all the runs
+    uint64_t cpuTimeNs{0};
+
+    // delay between the time a run was due and the time it started, for the
+    // last run and the largest one
+    uint64_t lastLagMs{0};
+    uint64_t maxLagMs{0};
+
+    // number of times a due run was held back because the budget was used up
+    uint64_t numThrottled{0};
+  };
+
+  // @throw std::invalid_argument on bad config
+  explicit BackgroundExecutor(Config config);
+  BackgroundExecutor(const BackgroundExecutor&) = delete;
+  BackgroundExecutor& operator=(const BackgroundExecutor&) = delete;
+
+  // Stops the threads. Tasks that are still registered are not run anymore.
+  ~BackgroundExecutor();
+
+  // Registers a task that runs as soon as possible and then again after the
+  // delay it returns every time.
+  //
+  // @param name      name of the task in the stats
+  // @param priority  priority of the task
+  // @param task      the work to run
+  // @return  id of the task
+  TaskId addTask(folly::StringPiece name, Priority priority, Task task);
+
+  // Unregisters a task and waits for its current run to finish, if any.
+  //
+  // @param timeout  how long to wait for the current run, 0 means forever
+  // @return  true if the task will not run anymore. false if the current run
+  //          did not finish in time, in which case the task stays registered.
+  bool removeTask(TaskId id,
+                  std::chrono::milliseconds timeout = std::chrono::seconds{0});
+
+  // Makes the task due right away, or right after its current run.
+  void wakeUp(TaskId id);
+
+  // Returns the stats of all registered tasks.
+  std::vector<TaskStats> getTaskStats() const;
+
+  // Exports the stats of all registered tasks and of the budget.
+  void getCounters(const util::CounterVisitor& visitor) const;
+
+  const Config& getConfig() const { return config_; }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct TaskState {
+    Task task;
+    TaskStats stats;
+    Clock::time_point due;
+    std::chrono::milliseconds lastDelay{std::chrono::seconds{1}};
+    bool running{false};
+    // set while removeTask() waits for the current run
+    bool removing{false};
+    // run again as soon as the current run is done
+    bool wakeUp{false};
+    // held back by the budget since it was due
+    bool throttled{false};
+  };
+
+  // Runs the due tasks until stopped
+  void loop();
+
+  // Picks the task to run next with the mutex held. Returns nullptr and the
+  // time to wait until if none can run now.
+  TaskState* pickLocked(Clock::time_point now, Clock::time_point& waitUntil);
+
+  // Adds the budget accumulated since the last refill with the mutex held.
+  void refillLocked(Clock::time_point now);
+
+  const Config config_;
+  // budget in CPU nanoseconds that can be accumulated
+  const double maxBudgetNs_{0};
+
+  mutable std::mutex mutex_;
+  // signals the workers that a task was added or woken up
+  std::condition_variable cond_;
+  // signals removeTask() that a run finished
+  std::condition_variable runDone_;
+  std::map<TaskId, std::unique_ptr<TaskState>> tasks_;
+  TaskId nextId_{0};
+  bool stop_{false};
+
+  // CPU nanoseconds the tasks can use right now. Can go negative since the
+  // cost of a run is only known after it is done.
+  double budgetNs_{0};
+  Clock::time_point lastRefill_;
+  uint64_t totalCpuTimeNs_{0};
+  uint64_t numThrottled_{0};
+
+  std::vector<std::thread> threads_;
+};
+
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/common/LatencyTracer.h"
+
+#include <folly/Format.h>
+#include <folly/Random.h>
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+
+#include <stdexcept>
+
+namespace facebook {
+namespace cachelib {
+
+namespace detail {
+thread_local Trace* tlsCurrentTrace{nullptr};
+} // namespace detail
+
+namespace {
+// Holds the trace in a request context. The fiber manager sets the context
+// of a fiber again whenever it resumes, which keeps the thread local pointer
+// in sync with the fiber running.
+class TraceRequestData : public folly::RequestData {
+ public:
+  explicit TraceRequestData(std::shared_ptr<Trace> trace)
+      : trace_{std::move(trace)} {}
+
+  bool hasCallback() override { return true; }
+
+  void onSet() override { detail::tlsCurrentTrace = trace_.get(); }
+
+  void onUnset() override {
+    if (detail::tlsCurrentTrace == trace_.get()) {
+      detail::tlsCurrentTrace = nullptr;
+    }
+  }
+
+ private:
+  const std::shared_ptr<Trace> trace_;
+};
+
+const folly::RequestToken& traceToken() {
+  static const folly::RequestToken token{"cachelib_trace"};
+  return token;
+}
+
+// keys are truncated in the records since only a few are needed to identify
+// the operation
+constexpr size_t kMaxKeySize = 64;
+} // namespace
+
+folly::StringPiece toString(TraceOp op) {
+  switch (op) {
+  case TraceOp::kFind:
+    return "find";
+  case TraceOp::kInsert:
+    return "insert";
+  default:
+    return "unknown";
+  }
+}
+
+folly::StringPiece toString(TraceStage stage) {
+  switch (stage) {
+  case TraceStage::kAccessContainer:
+    return "access_container";
+  case TraceStage::kMMContainer:
+    return "mm_container";
+  case TraceStage::kNvmFillLock:
+    return "nvm_fill_lock";
+  case TraceStage::kNavyQueue:
+    return "navy_queue";
+  case TraceStage::kNavyIndex:
+    return "navy_index";
+  case TraceStage::kDeviceIo:
+    return "device_io";
+  case TraceStage::kNvmDecode:
+    return "nvm_decode";
+  default:
+    return "unknown";
+  }
+}
+
+Trace::Trace(std::shared_ptr<LatencyTracer> tracer,
+             TraceOp op,
+             folly::StringPiece key)
+    : tracer_{std::move(tracer)},
+      op_{op},
+      key_{key.subpiece(0, kMaxKeySize).str()},
+      startNs_{util::getCurrentTimeNs()} {}
+
+Trace::~Trace() {
+  try {
+    tracer_->finish(*this);
+  } catch (const std::exception& e) {
+    XLOGF(ERR, "Failed to record trace: {}", e.what());
+  }
+}
+
+namespace detail {
+TraceContextScope::TraceContextScope(std::shared_ptr<Trace> trace) {
+  auto* ptr = trace.get();
+  if (trace) {
+    folly::RequestContext::get()->overwriteContextData(
+        traceToken(), std::make_unique<TraceRequestData>(std::move(trace)));
+  } else {
+    folly::RequestContext::get()->clearContextData(traceToken());
+  }
+  // the context is already current, so its callbacks may not have run
+  tlsCurrentTrace = ptr;
+}
+} // namespace detail
+
+void ScopedTrace::start(LatencyTracer& tracer,
+                        TraceOp op,
+                        folly::StringPiece key) {
+  scope_.emplace(std::make_shared<Trace>(tracer.shared_from_this(), op, key));
+}
+
+const LatencyTracer::Config& LatencyTracer::Config::validate() const {
+  if (sampleRate == 0) {
+    throw std::invalid_argument("Latency tracing sample rate must be positive");
+  }
+  if (maxSlowTraces > 0 && slowThreshold.count() <= 0) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid slow trace threshold: {}us", slowThreshold.count()));
+  }
+  return *this;
+}
+
+std::shared_ptr<LatencyTracer> LatencyTracer::create(Config config) {
+  return std::shared_ptr<LatencyTracer>(new LatencyTracer(std::move(config)));
+}
+
+LatencyTracer::LatencyTracer(Config config) : config_{config.validate()} {
+  XLOGF(INFO, "Latency tracing: 1 in {} operations, slow threshold: {}us",
+        config_.sampleRate, config_.slowThreshold.count());
+}
+
+bool LatencyTracer::resetCountdown(int64_t& countdown) noexcept {
+  // the countdown starts at 0 on a new thread
+  const bool sampled = countdown == 0;
+  countdown = folly::Random::rand64(2 * uint64_t{config_.sampleRate} - 1) + 1;
+  return sampled;
+}
+
+void LatencyTracer::finish(const Trace& trace) {
+  TraceRecord record;
+  record.op = trace.op_;
+  record.key = trace.key_;
+  record.totalNs = util::getCurrentTimeNs() - trace.startNs_;
+
+  auto& stats = opStats_[static_cast<size_t>(record.op)];
+  const auto now = std::chrono::steady_clock::now();
+  stats.total.trackValue(record.totalNs / 1000.0, now);
+  for (size_t i = 0; i < record.stageNs.size(); i++) {
+    record.stageNs[i] = trace.stageNs_[i].load(std::memory_order_relaxed);
+    // only the stages the operation went through
+    if (record.stageNs[i] > 0) {
+      stats.stages[i].trackValue(record.stageNs[i] / 1000.0, now);
+    }
+  }
+  numTraces_.fetch_add(1, std::memory_order_relaxed);
+
+  if (config_.maxSlowTraces == 0 ||
+      std::chrono::nanoseconds(record.totalNs) < config_.slowThreshold) {
+    return;
+  }
+  numSlowTraces_.fetch_add(1, std::memory_order_relaxed);
+  auto slowTraces = slowTraces_.wlock();
+  if (slowTraces->size() >= config_.maxSlowTraces) {
+    slowTraces->pop_front();
+  }
+  slowTraces->push_back(std::move(record));
+}
+
+std::vector<LatencyTracer::TraceRecord> LatencyTracer::getSlowTraces() const {
+  auto slowTraces = slowTraces_.rlock();
+  return {slowTraces->begin(), slowTraces->end()};
+}
+
+void LatencyTracer::dumpSlowTraces() {
+  std::deque<TraceRecord> slowTraces;
+  slowTraces_.wlock()->swap(slowTraces);
+  for (const auto& record : slowTraces) {
+    XLOG(INFO) << "Slow trace: " << record.toString();
+  }
+}
+
+void LatencyTracer::getCounters(const util::CounterVisitor& visitor) const {
+  visitor("cachelib_trace.traces", numTraces_.load(std::memory_order_relaxed),
+          util::CounterVisitor::CounterType::RATE);
+  visitor("cachelib_trace.slow_traces",
+          numSlowTraces_.load(std::memory_order_relaxed),
+          util::CounterVisitor::CounterType::RATE);
+  for (size_t op = 0; op < opStats_.size(); op++) {
+    const auto prefix = folly::sformat(
+        "cachelib_trace.{}", toString(static_cast<TraceOp>(op)));
+    auto& stats = opStats_[op];
+    stats.total.visitQuantileEstimator(visitor, prefix + ".total_us");
+    for (size_t i = 0; i < stats.stages.size(); i++) {
+      stats.stages[i].visitQuantileEstimator(
+          visitor, folly::sformat("{}.{}_us", prefix,
+                                  toString(static_cast<TraceStage>(i))));
+    }
+  }
+}
+
+std::string LatencyTracer::TraceRecord::toString() const {
+  auto str = folly::sformat(
+      "op={} key={} total_us={}", cachelib::toString(op),
+      folly::cEscape<std::string>(key), totalNs / 1000);
+  for (size_t i = 0; i < stageNs.size(); i++) {
+    if (stageNs[i] > 0) {
+      str += folly::sformat(" {}_us={}",
+                            cachelib::toString(static_cast<TraceStage>(i)),
+                            stageNs[i] / 1000);
+    }
+  }
+  return str;
+}
+
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,324 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <folly/ThreadLocal.h>
+#include <folly/io/async/Request.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "cachelib/common/PercentileStats.h"
+#include "cachelib/common/Time.h"
+#include "cachelib/common/Utils.h"
+
+// Sampled tracing of where the time of a cache operation goes, from the DRAM
+// cache down to the flash device.
+//
+// A sampled operation gets a Trace that is made current on the thread for
+// the duration of the operation. Code along the path times itself with a
+// ScopedTraceStage, which is a thread local load and a branch when the
+// operation is not sampled. When the operation continues on another thread
+// (e.g. a navy job), the trace is handed over with a TraceHandoff. The trace
+// is finished when the last reference to it goes away, so an operation that
+// completes asynchronously is measured until its last part is done.
+//
+// Finished traces are aggregated into per-stage latency percentiles, and the
+// slow ones are kept for inspection.
+//
+// Fibers: the current trace is kept in the folly request context, which the
+// fiber manager switches along with the fibers. The thread local pointer is
+// updated on every switch, so a fiber that suspends in the middle of an
+// operation (e.g. in device IO) finds its own trace when it resumes, and the
+// fibers interleaved on the thread never see it.
+
+namespace facebook {
+namespace cachelib {
+
+enum class TraceOp : uint8_t { kFind = 0, kInsert, kNumOps };
+
+enum class TraceStage : uint8_t {
+  // lookup or insert in the access container, including the lock wait
+  kAccessContainer = 0,
+  // adding or promoting the item in the MM container
+  kMMContainer,
+  // waiting for the NvmCache fill lock
+  kNvmFillLock,
+  // waiting in the navy job scheduler queue
+  kNavyQueue,
+  // navy index lookup, including the lock wait
+  kNavyIndex,
+  // reads and writes on the device
+  kDeviceIo,
+  // creating the DRAM item from the navy value
+  kNvmDecode,
+  kNumStages
+};
+
+folly::StringPiece toString(TraceOp op);
+folly::StringPiece toString(TraceStage stage);
+
+class LatencyTracer;
+class Trace;
+
+namespace detail {
+// the trace of the operation the thread or the fiber running on it works on,
+// if sampled. It mirrors the trace in the current request context.
+extern thread_local Trace* tlsCurrentTrace;
+
+// Makes a trace current for the scope, or none if it is null. The trace is
+// set in a shallow copy of the request context, and the previous context is
+// restored on exit.
+class TraceContextScope {
+ public:
+  explicit TraceContextScope(std::shared_ptr<Trace> trace);
+  TraceContextScope(const TraceContextScope&) = delete;
+  TraceContextScope& operator=(const TraceContextScope&) = delete;
+
+ private:
+  folly::ShallowCopyRequestContextScopeGuard guard_;
+};
+} // namespace detail
+
+// The timings of one sampled operation. Stages can be timed concurrently by
+// several threads.
+class Trace : public std::enable_shared_from_this<Trace> {
+ public:
+  Trace(std::shared_ptr<LatencyTracer> tracer,
+        TraceOp op,
+        folly::StringPiece key);
+  Trace(const Trace&) = delete;
+  Trace& operator=(const Trace&) = delete;
+
+  // Reports the trace to the tracer.
+  ~Trace();
+
+  void addStage(TraceStage stage, uint64_t ns) noexcept {
+    stageNs_[static_cast<size_t>(stage)].fetch_add(ns,
+                                                   std::memory_order_relaxed);
+  }
+
+  // Returns the trace current on the calling thread or fiber, if any.
+  static Trace* current() noexcept { return detail::tlsCurrentTrace; }
+
+ private:
+  friend class LatencyTracer;
+
+  const std::shared_ptr<LatencyTracer> tracer_;
+  const TraceOp op_;
+  const std::string key_;
+  const uint64_t startNs_;
+  std::array<std::atomic<uint64_t>, static_cast<size_t>(TraceStage::kNumStages)>
+      stageNs_{};
+};
+
+// Samples cache operations and aggregates their traces.
+class LatencyTracer : public std::enable_shared_from_this<LatencyTracer> {
+ public:
+  struct Config {
+    // one in this many operations is traced on average
+    uint32_t sampleRate{1000};
+
+    // traces taking at least this long are kept for inspection
+    std::chrono::microseconds slowThreshold{std::chrono::milliseconds{10}};
+
+    // number of slow traces to keep. The oldest ones are dropped first.
+    size_t maxSlowTraces{100};
+
+    // Checks invariants. Throws exception if failed.
+    const Config& validate() const;
+  };
+
+  // A finished trace
+  struct TraceRecord {
+    TraceOp op;
+    std::string key;
+    // wall clock time of the operation until its last part was done
+    uint64_t totalNs{0};
+    // time spent in each stage. Stages that run concurrently on several
+    // threads can add up to more than the total.
+    std::array<uint64_t, static_cast<size_t>(TraceStage::kNumStages)>
+        stageNs{};
+
+    std::string toString() const;
+  };
+
+  // @throw std::invalid_argument on bad config
+  static std::shared_ptr<LatencyTracer> create(Config config);
+
+  // Whether the next operation of the calling thread should be traced. This
+  // is a thread local decrement for the operations not sampled.
+  bool shouldSample() noexcept {
+    auto& countdown = *sampleCountdown_;
+    if (FOLLY_LIKELY(--countdown > 0)) {
+      return false;
+    }
+    return resetCountdown(countdown);
+  }
+
+  // Returns the slow traces, oldest first.
+  std::vector<TraceRecord> getSlowTraces() const;
+
+  // Logs the slow traces and forgets them.
+  void dumpSlowTraces();
+
+  // Exports the latency percentiles of each op and stage in microseconds.
+  void getCounters(const util::CounterVisitor& visitor) const;
+
+  const Config& getConfig() const noexcept { return config_; }
+
+ private:
+  friend class Trace;
+
+  explicit LatencyTracer(Config config);
+
+  // draws the next countdown. Returns true if this operation is sampled.
+  bool resetCountdown(int64_t& countdown) noexcept;
+
+  void finish(const Trace& trace);
+
+  const Config config_;
+
+  // operations of the thread until the next sampled one. It is drawn at
+  // random around the sample rate so that the sampling does not align with
+  // periodic workloads.
+  folly::ThreadLocal<int64_t> sampleCountdown_;
+
+  // total latency and the latency of each stage, per op
+  struct OpStats {
+    mutable util::PercentileStats total;
+    mutable std::array<util::PercentileStats,
+                       static_cast<size_t>(TraceStage::kNumStages)>
+        stages;
+  };
+  std::array<OpStats, static_cast<size_t>(TraceOp::kNumOps)> opStats_;
+
+  std::atomic<uint64_t> numTraces_{0};
+  std::atomic<uint64_t> numSlowTraces_{0};
+  folly::Synchronized<std::deque<TraceRecord>> slowTraces_;
+};
+
+// Traces the operation on the calling thread if it is sampled. Nesting a
+// ScopedTrace in a traced operation keeps the outer trace.
+class ScopedTrace {
+ public:
+  // @param tracer  the tracer, or nullptr if tracing is disabled
+  ScopedTrace(LatencyTracer* tracer, TraceOp op, folly::StringPiece key) {
+    if (tracer != nullptr && Trace::current() == nullptr &&
+        tracer->shouldSample()) {
+      start(*tracer, op, key);
+    }
+  }
+  ScopedTrace(const ScopedTrace&) = delete;
+  ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+ private:
+  void start(LatencyTracer& tracer, TraceOp op, folly::StringPiece key);
+
+  // set if the operation is sampled
+  std::optional<detail::TraceContextScope> scope_;
+};
+
+// Times the enclosing scope as a stage of the current trace, if any.
+class ScopedTraceStage {
+ public:
+  explicit ScopedTraceStage(TraceStage stage) noexcept : stage_{stage} {
+    if (FOLLY_UNLIKELY(Trace::current() != nullptr)) {
+      trace_ = Trace::current()->shared_from_this();
+      startNs_ = util::getCurrentTimeNs();
+    }
+  }
+  ScopedTraceStage(const ScopedTraceStage&) = delete;
+  ScopedTraceStage& operator=(const ScopedTraceStage&) = delete;
+
+  ~ScopedTraceStage() {
+    if (FOLLY_UNLIKELY(trace_ != nullptr)) {
+      trace_->addStage(stage_, util::getCurrentTimeNs() - startNs_);
+    }
+  }
+
+ private:
+  // held so that the trace outlives the stage even if the operation
+  // finishes on another fiber while this one is suspended in the stage
+  std::shared_ptr<Trace> trace_;
+  const TraceStage stage_;
+  uint64_t startNs_{0};
+};
+
+// Carries the current trace of a thread over to work that continues on
+// another thread, e.g. a job in a queue. Keeps the trace alive.
+class TraceHandoff {
+ public:
+  // Captures the trace current on the calling thread, if any.
+  TraceHandoff()
+      : trace_{Trace::current() ? Trace::current()->shared_from_this()
+                                : nullptr},
+        readyNs_{trace_ ? util::getCurrentTimeNs() : 0} {}
+
+ private:
+  friend class TraceResumeGuard;
+
+  std::shared_ptr<Trace> trace_;
+  // when the work became ready to run
+  uint64_t readyNs_;
+};
+
+// Makes the trace of a handoff current on the running thread for the scope,
+// and records the time the work waited to run as the given stage. Work that
+// runs several times (e.g. a rescheduled job) records each wait.
+//
+// The trace is current even if the handoff has none, so that an unsampled
+// job never runs with a trace inherited from the context it was started in.
+// The previous trace is current again on exit.
+class TraceResumeGuard {
+ public:
+  TraceResumeGuard(TraceHandoff& handoff, TraceStage waitStage)
+      : handoff_{handoff} {
+    if (FOLLY_UNLIKELY(handoff_.trace_ != nullptr)) {
+      handoff_.trace_->addStage(waitStage,
+                                util::getCurrentTimeNs() - handoff_.readyNs_);
+      scope_.emplace(handoff_.trace_);
+    } else if (FOLLY_UNLIKELY(Trace::current() != nullptr)) {
+      scope_.emplace(nullptr);
+    }
+  }
+  TraceResumeGuard(const TraceResumeGuard&) = delete;
+  TraceResumeGuard& operator=(const TraceResumeGuard&) = delete;
+
+  ~TraceResumeGuard() {
+    scope_.reset();
+    if (FOLLY_UNLIKELY(handoff_.trace_ != nullptr)) {
+      handoff_.readyNs_ = util::getCurrentTimeNs();
+    }
+  }
+
+ private:
+  TraceHandoff& handoff_;
+  // set if the trace current for the job differs from the one of the context
+  std::optional<detail::TraceContextScope> scope_;
+};
+
+} // namespace cachelib
+} // namespace facebook
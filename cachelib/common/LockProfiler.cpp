@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/common/LockProfiler.h"
+
+#include <folly/Bits.h>
+#include <folly/Format.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace facebook {
+namespace cachelib {
+
+size_t LockContentionStats::getBucket(uint64_t waitNs) noexcept {
+  const size_t bucket = folly::findLastSet(waitNs >> kMinWaitShift);
+  return std::min(bucket, kNumWaitBuckets - 1);
+}
+
+uint64_t LockContentionStats::waitNsPercentile(double fraction) const {
+  uint64_t total = 0;
+  for (auto count : waitNsHistogram) {
+    total += count;
+  }
+  if (total == 0) {
+    return 0;
+  }
+  // rank of the wait, with some slack for the rounding of the fraction
+  const auto target = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(fraction * total - 1e-6)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < waitNsHistogram.size(); i++) {
+    seen += waitNsHistogram[i];
+    if (seen >= target) {
+      return i + 1 < waitNsHistogram.size()
+                 ? uint64_t{1} << (i + kMinWaitShift)
+                 : uint64_t{1} << (i + kMinWaitShift - 1);
+    }
+  }
+  return uint64_t{1} << (kNumWaitBuckets + kMinWaitShift - 2);
+}
+
+LockContentionStats LockStats::getStats() const {
+  LockContentionStats stats;
+  stats.numAcquisitions = numAcquisitions_.get();
+  stats.numContended = numContended_.load(std::memory_order_relaxed);
+  stats.totalWaitNs = totalWaitNs_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < waitNsHistogram_.size(); i++) {
+    stats.waitNsHistogram[i] =
+        waitNsHistogram_[i].load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+LockStats* LockProfiler::getStats(folly::StringPiece owner) {
+  auto stats = stats_.wlock();
+  auto it = stats->find(owner);
+  if (it == stats->end()) {
+    it = stats->emplace(owner.str(), std::make_unique<LockStats>(owner.str()))
+             .first;
+  }
+  return it->second.get();
+}
+
+std::map<std::string, LockContentionStats> LockProfiler::getContentionStats()
+    const {
+  std::map<std::string, LockContentionStats> result;
+  auto stats = stats_.rlock();
+  for (const auto& [owner, lockStats] : *stats) {
+    auto snapshot = lockStats->getStats();
+    if (snapshot.numAcquisitions > 0) {
+      result.emplace(owner, snapshot);
+    }
+  }
+  return result;
+}
+
+void LockProfiler::getCounters(const util::CounterVisitor& visitor) const {
+  for (const auto& [owner, stats] : getContentionStats()) {
+    const auto prefix = folly::sformat("cachelib_lock.{}", owner);
+    visitor(prefix + ".acquisitions", stats.numAcquisitions,
+            util::CounterVisitor::CounterType::RATE);
+    visitor(prefix + ".contended", stats.numContended,
+            util::CounterVisitor::CounterType::RATE);
+    visitor(prefix + ".wait_us", stats.totalWaitNs / 1000,
+            util::CounterVisitor::CounterType::RATE);
+    visitor(prefix + ".wait_ns_p50", stats.waitNsPercentile(0.5));
+    visitor(prefix + ".wait_ns_p99", stats.waitNsPercentile(0.99));
+    visitor(prefix + ".wait_ns_p999", stats.waitNsPercentile(0.999));
+  }
+}
+
+} // namespace cachelib
+} // namespace facebook
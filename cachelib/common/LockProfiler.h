@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/CPortability.h>
+#include <folly/Range.h>
+#include <folly/ScopeGuard.h>
+#include <folly/Synchronized.h>
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "cachelib/common/AtomicCounter.h"
+#include "cachelib/common/Time.h"
+#include "cachelib/common/Utils.h"
+
+// Opt-in contention profiling of the cache locks.
+//
+// The locks of a logical owner (e.g. the MM container of a pool and class, or
+// the buckets of the navy index) share a LockStats. A profiled acquisition
+// first tries the lock, and only an acquisition that has to wait is timed.
+// When profiling is disabled the stats are nullptr and an acquisition costs
+// one extra branch.
+
+namespace facebook {
+namespace cachelib {
+
+// A snapshot of the contention of the locks of an owner
+struct LockContentionStats {
+  // waits are bucketed by powers of two, starting below 2^kMinWaitShift ns
+  static constexpr size_t kMinWaitShift = 8;
+  static constexpr size_t kNumWaitBuckets = 24;
+
+  // all acquisitions, including the contended ones
+  uint64_t numAcquisitions{0};
+
+  // acquisitions that had to wait for the lock
+  uint64_t numContended{0};
+
+  // total time waited by the contended acquisitions
+  uint64_t totalWaitNs{0};
+
+  // number of contended acquisitions by wait time. Bucket i counts the waits
+  // below 2^(i + kMinWaitShift) ns not counted by the previous buckets. The
+  // last bucket counts all the longer waits.
+  std::array<uint64_t, kNumWaitBuckets> waitNsHistogram{};
+
+  // Returns the upper bound of the wait time of the given fraction (0 to 1)
+  // of the contended acquisitions. The last bucket is reported with its lower
+  // bound.
+  uint64_t waitNsPercentile(double fraction) const;
+
+  static size_t getBucket(uint64_t waitNs) noexcept;
+};
+
+// Contention stats of the locks of an owner. Thread safe.
+class LockStats {
+ public:
+  explicit LockStats(std::string owner) : owner_{std::move(owner)} {}
+  LockStats(const LockStats&) = delete;
+  LockStats& operator=(const LockStats&) = delete;
+
+  void recordAcquisition() noexcept { numAcquisitions_.inc(); }
+
+  void recordContended(uint64_t waitNs) noexcept {
+    numAcquisitions_.inc();
+    numContended_.fetch_add(1, std::memory_order_relaxed);
+    totalWaitNs_.fetch_add(waitNs, std::memory_order_relaxed);
+    waitNsHistogram_[LockContentionStats::getBucket(waitNs)].fetch_add(
+        1, std::memory_order_relaxed);
+  }
+
+  const std::string& getOwner() const noexcept { return owner_; }
+
+  LockContentionStats getStats() const;
+
+ private:
+  const std::string owner_;
+
+  // thread local since the uncontended acquisitions are the common case
+  TLCounter numAcquisitions_;
+  std::atomic<uint64_t> numContended_{0};
+  std::atomic<uint64_t> totalWaitNs_{0};
+  std::array<std::atomic<uint64_t>, LockContentionStats::kNumWaitBuckets>
+      waitNsHistogram_{};
+};
+
+// Registry of the LockStats of a cache, by owner. Pass it to the cache config
+// to enable the profiling.
+class LockProfiler {
+ public:
+  LockProfiler() = default;
+  LockProfiler(const LockProfiler&) = delete;
+  LockProfiler& operator=(const LockProfiler&) = delete;
+
+  // Returns the stats of the locks of an owner, created on first use. Owners
+  // with the same name share the stats. The stats live as long as the
+  // profiler.
+  LockStats* getStats(folly::StringPiece owner);
+
+  // Returns the stats of the owners whose locks were acquired.
+  std::map<std::string, LockContentionStats> getContentionStats() const;
+
+  // Exports the stats of the owners whose locks were acquired.
+  void getCounters(const util::CounterVisitor& visitor) const;
+
+ private:
+  folly::Synchronized<
+      std::map<std::string, std::unique_ptr<LockStats>, std::less<>>>
+      stats_;
+};
+
+namespace util {
+// Acquires a mutex into a lock holder (e.g. std::unique_lock or
+// std::shared_lock), recording the acquisition in the stats if any.
+template <typename Holder, typename Mutex>
+Holder lockProfiled(Mutex& mutex, LockStats* stats) {
+  if (FOLLY_LIKELY(stats == nullptr)) {
+    return Holder{mutex};
+  }
+  Holder holder{mutex, std::try_to_lock};
+  if (holder.owns_lock()) {
+    stats->recordAcquisition();
+    return holder;
+  }
+  const auto startNs = getCurrentTimeNs();
+  holder.lock();
+  stats->recordContended(getCurrentTimeNs() - startNs);
+  return holder;
+}
+
+// Runs the function under a folly::DistributedMutex with lock_combine(),
+// recording the acquisition in the stats if any. The stats are updated after
+// the lock is released, so that a combining thread is not slowed down.
+template <typename Mutex, typename F>
+auto lockCombineProfiled(Mutex& mutex, LockStats* stats, F&& f)
+    -> decltype(f()) {
+  if (FOLLY_LIKELY(stats == nullptr)) {
+    return mutex.lock_combine(std::forward<F>(f));
+  }
+  {
+    std::unique_lock<Mutex> holder{mutex, std::try_to_lock};
+    if (holder.owns_lock()) {
+      stats->recordAcquisition();
+      return f();
+    }
+  }
+  const auto startNs = getCurrentTimeNs();
+  uint64_t acquiredNs = 0;
+  SCOPE_EXIT {
+    if (acquiredNs != 0) {
+      stats->recordContended(acquiredNs - startNs);
+    }
+  };
+  return mutex.lock_combine([&]() -> decltype(auto) {
+    acquiredNs = getCurrentTimeNs();
+    return f();
+  });
+}
+} // namespace util
+
+} // namespace cachelib
+} // namespace facebook
@@ -29,6 +29,7 @@
 #include <system_error>
 
 #include "cachelib/common/Hash.h"
+#include "cachelib/common/LockProfiler.h"
 
 namespace facebook {
 namespace cachelib {
@@ -346,16 +347,20 @@ class RWBucketLocks : public BaseBucketLocks<LockType, LockAlignmentType> {
   RWBucketLocks(uint32_t locksPower, std::shared_ptr<Hash> hasher)
       : Base::BaseBucketLocks(locksPower, std::move(hasher)) {}
 
+  // Records the acquisitions of lockShared() and lockExclusive() in the
+  // stats. Must be set before the locks are used.
+  void setLockStats(LockStats* stats) noexcept { stats_ = stats; }
+
   // Lock for this particular key and return a reader lock
   template <typename... Args>
   ReadLockHolder lockShared(Args... args) {
-    return ReadLockHolder{Base::getLock(args...)};
+    return util::lockProfiled<ReadLockHolder>(Base::getLock(args...), stats_);
   }
 
   // Lock for this particular key and return a writer lock
   template <typename... Args>
   WriteLockHolder lockExclusive(Args... args) {
-    return WriteLockHolder{Base::getLock(args...)};
+    return util::lockProfiled<WriteLockHolder>(Base::getLock(args...), stats_);
   }
 
   template <typename... Args>
@@ -382,6 +387,9 @@ class RWBucketLocks : public BaseBucketLocks<LockType, LockAlignmentType> {
             ? WriteLockHolder(Base::getLock(args...))
             : WriteLockHolder(Base::getLock(args...), timeout);
   }
+
+ private:
+  LockStats* stats_{nullptr};
 };
 using TimedMutexRWBuckets =
     RWBucketLocks<folly::fibers::TimedRWMutex<folly::fibers::Baton>>;
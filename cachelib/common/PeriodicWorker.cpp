@@ -79,7 +79,7 @@ bool PeriodicWorker::start(const std::chrono::milliseconds sleepInterval,
   setInterval(sleepInterval);
 
   LockHolder l(lock_);
-  if (workerThread_) {
+  if (workerThread_ || executor_) {
     return true;
   }
 
@@ -94,6 +94,42 @@ bool PeriodicWorker::start(const std::chrono::milliseconds sleepInterval,
   return true;
 }
 
+bool PeriodicWorker::start(const std::chrono::milliseconds sleepInterval,
+                           const folly::StringPiece name,
+                           std::shared_ptr<BackgroundExecutor> executor,
+                           BackgroundExecutor::Priority priority) {
+  if (!executor) {
+    return start(sleepInterval, name);
+  }
+  if (sleepInterval == std::chrono::milliseconds::zero()) {
+    return false;
+  }
+
+  setInterval(sleepInterval);
+
+  LockHolder l(lock_);
+  if (workerThread_ || executor_) {
+    return true;
+  }
+
+  executor_ = std::move(executor);
+  taskId_ = executor_->addTask(name, priority,
+                               [this]() { return runOnExecutor(); });
+  return true;
+}
+
+std::chrono::milliseconds PeriodicWorker::runOnExecutor() {
+  /* The executor never runs the task concurrently with itself, so there is
+   * no need for the lock here */
+  if (!preWorkDone_) {
+    preWork();
+    preWorkDone_ = true;
+  }
+  work();
+  runCount_.fetch_add(1, std::memory_order_relaxed);
+  return std::chrono::milliseconds(interval_);
+}
+
 bool PeriodicWorker::shouldStopWork() const {
   LockHolder l(lock_);
   return shouldStopWork_;
@@ -104,6 +140,23 @@ bool PeriodicWorker::stop(const std::chrono::milliseconds timeout) {
     return false;
   }
 
+  if (executor_) {
+    /* Let the work observe shouldStopWork() and finish early. The task is
+     * removed without the lock since the current run may need it. */
+    shouldStopWork_ = true;
+    auto executor = executor_;
+    const auto taskId = taskId_;
+    l.unlock();
+    const bool removed = executor->removeTask(taskId, timeout);
+    l.lock();
+    shouldStopWork_ = false;
+    if (removed) {
+      executor_.reset();
+      preWorkDone_ = false;
+    }
+    return removed;
+  }
+
   if (!workerThread_) {
     return true;
   } else {
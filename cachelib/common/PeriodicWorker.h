@@ -25,6 +25,8 @@
 #include <mutex>
 #include <thread>
 
+#include "cachelib/common/BackgroundExecutor.h"
+
 namespace facebook {
 namespace cachelib {
 
@@ -52,6 +54,23 @@ class PeriodicWorker {
   bool start(const std::chrono::milliseconds sleepInterval,
              const folly::StringPiece = "");
 
+  /* Start the work on a shared background executor instead of a dedicated
+   * thread if not already started. The work runs with the given priority
+   * and the sleep interval applies after every run, like with a thread.
+   * Falls back to a dedicated thread if executor is null.
+   *
+   * @param sleepInterval  The sleep interval for the work in milliseconds
+   * @param name           The name of the task in the executor stats
+   * @param executor       The executor to run the work on
+   * @param priority       The priority of the work on the executor
+   * @return   true if the work was scheduled. false if the sleep interval is
+   *           0 or worker was already running
+   */
+  bool start(const std::chrono::milliseconds sleepInterval,
+             const folly::StringPiece name,
+             std::shared_ptr<BackgroundExecutor> executor,
+             BackgroundExecutor::Priority priority);
+
   /* Stop the worker thread and executes the post work fn. On success,
    * this will ensure that the thread is terminated properly.
    *
@@ -94,6 +113,9 @@ class PeriodicWorker {
     {
       std::unique_lock<std::timed_mutex> l(lock_);
       wakeUp_ = true;
+      if (executor_) {
+        executor_->wakeUp(taskId_);
+      }
     }
     cond_.notify_one();
   }
@@ -116,6 +138,15 @@ class PeriodicWorker {
   /* Worker thread which will periodically do the work */
   std::unique_ptr<std::thread> workerThread_;
 
+  /* Executor running the work instead of the worker thread, and the id of
+   * the work on it */
+  std::shared_ptr<BackgroundExecutor> executor_;
+  BackgroundExecutor::TaskId taskId_{0};
+
+  /* Whether preWork() ran on the executor. Only accessed by the task and
+   * while the task is not registered. */
+  bool preWorkDone_ = false;
+
   /* Sleep interval for the worker thread in milliseconds */
   std::atomic<uint64_t> interval_{0};
 
@@ -140,6 +171,9 @@ class PeriodicWorker {
 
   /* The main worker loop that handles the work periodically */
   void loop(void);
+
+  /* One run of the work on the executor. Returns the sleep interval */
+  std::chrono::milliseconds runOnExecutor();
 };
 
 namespace util {
@@ -169,25 +203,30 @@ bool stopPeriodicWorker(folly::StringPiece name,
   return ret;
 }
 
-// Start a periodic worker
+// Start a periodic worker on a background executor
 //
 // @param name       name of the worker
 // @param worker     unique pointer of the worker to start
 // @param interval   the period this worker fires
+// @param executor   executor to run the worker on. The worker gets its own
+//                   thread if null.
+// @param priority   priority of the worker on the executor
 // @param args...    the rest of the arguments to initialize the worker
 // @return true if the worker has been successfully started
 template <typename WorkerT, typename... Args>
-bool startPeriodicWorker(folly::StringPiece name,
-                         std::unique_ptr<WorkerT>& worker,
-                         std::chrono::milliseconds interval,
-                         Args&&... args) {
+bool startPeriodicWorkerOnExecutor(folly::StringPiece name,
+                                   std::unique_ptr<WorkerT>& worker,
+                                   std::chrono::milliseconds interval,
+                                   std::shared_ptr<BackgroundExecutor> executor,
+                                   BackgroundExecutor::Priority priority,
+                                   Args&&... args) {
   if (worker && !stopPeriodicWorker(name, worker)) {
     XLOGF(ERR, "Couldn't restart worker '{}' because it couldn't be stopped",
           name);
     return false;
   }
   worker = std::make_unique<WorkerT>(std::forward<Args>(args)...);
-  bool ret = worker->start(interval, name);
+  bool ret = worker->start(interval, name, std::move(executor), priority);
   if (ret) {
     XLOGF(DBG1, "Started worker '{}'", name);
   } else {
@@ -197,6 +236,24 @@ bool startPeriodicWorker(folly::StringPiece name,
   return ret;
 }
 
+// Start a periodic worker on its own thread
+//
+// @param name       name of the worker
+// @param worker     unique pointer of the worker to start
+// @param interval   the period this worker fires
+// @param args...    the rest of the arguments to initialize the worker
+// @return true if the worker has been successfully started
+template <typename WorkerT, typename... Args>
+bool startPeriodicWorker(folly::StringPiece name,
+                         std::unique_ptr<WorkerT>& worker,
+                         std::chrono::milliseconds interval,
+                         Args&&... args) {
+  return startPeriodicWorkerOnExecutor(name, worker, interval,
+                                       nullptr /* executor */,
+                                       BackgroundExecutor::Priority::kNormal,
+                                       std::forward<Args>(args)...);
+}
+
 } // namespace util
 } // namespace cachelib
 } // namespace facebook
@@ -21,9 +21,12 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
+#include <thread>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wconversion"
@@ -34,6 +37,12 @@
 
 #include "cachelib/common/Utils.h"
 
+/* MADV_POPULATE_WRITE was added in Linux 5.14 and can be missing from older
+ * headers. Kernels that don't support it fail the madvise with EINVAL. */
+#if defined(__linux__) && !defined(MADV_POPULATE_WRITE)
+#define MADV_POPULATE_WRITE 23
+#endif
+
 namespace facebook {
 namespace cachelib {
 namespace util {
@@ -230,6 +239,67 @@ bool isPageAlignedAddr(const void* addr) noexcept {
   return reinterpret_cast<uintptr_t>(addr) % getPageSize() == 0;
 }
 
+void prefaultMemory(void* memory, size_t len) {
+  if (!isPageAlignedAddr(memory)) {
+    throw std::invalid_argument(
+        folly::sformat("addr {} is not page aligned", memory));
+  }
+  if (len == 0) {
+    return;
+  }
+
+#ifdef MADV_POPULATE_WRITE
+  if (madvise(memory, len, MADV_POPULATE_WRITE) == 0) {
+    return;
+  }
+#endif
+
+  // Older kernels do not know about MADV_POPULATE_WRITE. Take a write fault
+  // on every page instead. A relaxed fetch_or of zero dirties the page
+  // without changing its contents, which keeps this safe for memory that
+  // already holds cache state.
+  auto* mem = reinterpret_cast<uint8_t*>(memory);
+  const size_t pageSize = getPageSize();
+  for (size_t offset = 0; offset < len; offset += pageSize) {
+    reinterpret_cast<std::atomic<uint8_t>*>(mem + offset)
+        ->fetch_or(0, std::memory_order_relaxed);
+  }
+}
+
+void prefaultMemoryParallel(
+    void* memory,
+    size_t len,
+    unsigned int numThreads,
+    const std::function<void(unsigned int)>& threadInit) {
+  if (!isPageAlignedAddr(memory)) {
+    throw std::invalid_argument(
+        folly::sformat("addr {} is not page aligned", memory));
+  }
+
+  const size_t numPages = getNumPages(len);
+  numThreads = static_cast<unsigned int>(
+      std::max<size_t>(1, std::min<size_t>(numThreads, numPages)));
+  const size_t pagesPerThread = getDivCeiling(numPages, numThreads);
+  const size_t pageSize = getPageSize();
+
+  std::vector<std::thread> workers;
+  workers.reserve(numThreads);
+  for (unsigned int i = 0; i < numThreads; i++) {
+    const size_t start = std::min(len, i * pagesPerThread * pageSize);
+    const size_t end = std::min(len, (i + 1) * pagesPerThread * pageSize);
+    workers.emplace_back([=, &threadInit]() {
+      if (threadInit) {
+        threadInit(i);
+      }
+      prefaultMemory(reinterpret_cast<uint8_t*>(memory) + start, end - start);
+    });
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
 /* returns true with the file's mode. false if the file does not exist.
  * throws system_error for all other errors */
 bool getStatIfExists(const std::string& name, mode_t* mode) {
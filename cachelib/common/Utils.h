@@ -19,6 +19,7 @@
 #include <folly/Format.h>
 #include <folly/Random.h>
 
+#include <functional>
 #include <unordered_map>
 
 #pragma GCC diagnostic push
@@ -314,6 +315,34 @@ size_t getNumPages(size_t len) noexcept;
 // return true if the memory is page aligned.
 bool isPageAlignedAddr(const void* addr) noexcept;
 
+// Populate the page tables for the given range so that subsequent accesses do
+// not take page faults. Uses MADV_POPULATE_WRITE when the kernel supports it
+// and falls back to touching every page with an atomic no-op write
+// otherwise. Either way, the contents of the memory are preserved.
+//
+// @param mem   memory start which is page aligned
+// @param len   length of the memory.
+//
+// @throw std::invalid_argument if mem is not page aligned
+void prefaultMemory(void* mem, size_t len);
+
+// Split the range into numThreads contiguous pieces and prefault them in
+// parallel. Blocks until all of the memory has been faulted in.
+//
+// @param mem         memory start which is page aligned
+// @param len         length of the memory.
+// @param numThreads  number of threads to spread the page faults over.
+// @param threadInit  optional callback invoked on each worker with its index
+//                    before it starts faulting (e.g. to bind it to a NUMA
+//                    node).
+//
+// @throw std::invalid_argument if mem is not page aligned
+void prefaultMemoryParallel(
+    void* mem,
+    size_t len,
+    unsigned int numThreads,
+    const std::function<void(unsigned int)>& threadInit = {});
+
 /* returns true with the file's mode. false if the file does not exist.
  * throws system_error for all other errors */
 bool getStatIfExists(const std::string& name, mode_t* mode);
@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/synchronization/Baton.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cachelib/common/BackgroundExecutor.h"
+#include "cachelib/common/PeriodicWorker.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+
+namespace {
+using Priority = BackgroundExecutor::Priority;
+using namespace std::chrono_literals;
+
+// burns roughly the given amount of CPU time on the calling thread
+void burnCpu(std::chrono::milliseconds duration) {
+  const auto end = std::chrono::steady_clock::now() + duration;
+  volatile uint64_t x = 0;
+  while (std::chrono::steady_clock::now() < end) {
+    x = x + 1;
+  }
+}
+
+template <typename F>
+bool eventually(F&& f, std::chrono::milliseconds timeout = 10s) {
+  const auto end = std::chrono::steady_clock::now() + timeout;
+  while (std::chrono::steady_clock::now() < end) {
+    if (f()) {
+      return true;
+    }
+    std::this_thread::sleep_for(1ms);
+  }
+  return f();
+}
+
+BackgroundExecutor::TaskStats getStats(const BackgroundExecutor& executor,
+                                       const std::string& name) {
+  for (const auto& stats : executor.getTaskStats()) {
+    if (stats.name == name) {
+      return stats;
+    }
+  }
+  return {};
+}
+
+class CountingWorker : public PeriodicWorker {
+ public:
+  ~CountingWorker() override { stop(0ms); }
+
+  std::atomic<int> preWorkCount{0};
+  std::atomic<int> workCount{0};
+
+ private:
+  void preWork() override { preWorkCount++; }
+  void work() override { workCount++; }
+};
+} // namespace
+
+TEST(BackgroundExecutor, ConfigValidation) {
+  BackgroundExecutor::Config config;
+  config.numThreads = 0;
+  EXPECT_THROW(BackgroundExecutor{config}, std::invalid_argument);
+
+  config.numThreads = 1;
+  config.cpuBudget = -1;
+  EXPECT_THROW(BackgroundExecutor{config}, std::invalid_argument);
+
+  config.cpuBudget = 0.5;
+  config.burstWindow = 0ms;
+  EXPECT_THROW(BackgroundExecutor{config}, std::invalid_argument);
+
+  config.burstWindow = 100ms;
+  EXPECT_NO_THROW(BackgroundExecutor{config});
+}
+
+TEST(BackgroundExecutor, RunsPeriodically) {
+  BackgroundExecutor executor{BackgroundExecutor::Config{}};
+  std::atomic<int> runs{0};
+  auto id = executor.addTask("task", Priority::kNormal, [&runs]() {
+    runs++;
+    return 10ms;
+  });
+  EXPECT_TRUE(eventually([&runs]() { return runs >= 5; }));
+
+  EXPECT_TRUE(executor.removeTask(id));
+  const int total = runs;
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(total, runs);
+  EXPECT_TRUE(executor.getTaskStats().empty());
+
+  // removing an unknown task is a no-op
+  EXPECT_TRUE(executor.removeTask(id));
+}
+
+TEST(BackgroundExecutor, HigherPriorityFirst) {
+  BackgroundExecutor::Config config;
+  config.numThreads = 1;
+  BackgroundExecutor executor{config};
+
+  // keep the only thread busy until all the tasks are registered
+  folly::Baton<> blocked;
+  folly::Baton<> release;
+  auto blocker = executor.addTask("blocker", Priority::kHigh, [&]() {
+    blocked.post();
+    release.wait();
+    return 1h;
+  });
+  blocked.wait();
+
+  std::mutex mutex;
+  std::vector<std::string> order;
+  auto record = [&](std::string name) {
+    return [&, name]() {
+      std::lock_guard<std::mutex> l(mutex);
+      order.push_back(name);
+      return 1h;
+    };
+  };
+  executor.addTask("low", Priority::kLow, record("low"));
+  executor.addTask("normal", Priority::kNormal, record("normal"));
+  executor.addTask("high", Priority::kHigh, record("high"));
+  release.post();
+
+  EXPECT_TRUE(eventually([&]() {
+    std::lock_guard<std::mutex> l(mutex);
+    return order.size() == 3;
+  }));
+  EXPECT_EQ((std::vector<std::string>{"high", "normal", "low"}), order);
+  EXPECT_TRUE(executor.removeTask(blocker));
+}
+
+TEST(BackgroundExecutor, WakeUp) {
+  BackgroundExecutor executor{BackgroundExecutor::Config{}};
+  std::atomic<int> runs{0};
+  auto id = executor.addTask("task", Priority::kNormal, [&runs]() {
+    runs++;
+    return 1h;
+  });
+  EXPECT_TRUE(eventually([&runs]() { return runs == 1; }));
+
+  executor.wakeUp(id);
+  EXPECT_TRUE(eventually([&runs]() { return runs == 2; }));
+  executor.wakeUp(id);
+  EXPECT_TRUE(eventually([&runs]() { return runs == 3; }));
+  EXPECT_EQ(3, getStats(executor, "task").numRuns);
+}
+
+TEST(BackgroundExecutor, RemoveTimeout) {
+  BackgroundExecutor executor{BackgroundExecutor::Config{}};
+  folly::Baton<> started;
+  folly::Baton<> release;
+  std::atomic<int> runs{0};
+  auto id = executor.addTask("task", Priority::kNormal, [&]() {
+    if (runs++ == 0) {
+      started.post();
+      release.wait();
+    }
+    return 1ms;
+  });
+  started.wait();
+
+  // the task is still running, so it stays registered
+  EXPECT_FALSE(executor.removeTask(id, 10ms));
+  EXPECT_EQ(1, executor.getTaskStats().size());
+
+  release.post();
+  EXPECT_TRUE(eventually([&runs]() { return runs > 2; }));
+  EXPECT_TRUE(executor.removeTask(id));
+  EXPECT_TRUE(executor.getTaskStats().empty());
+}
+
+TEST(BackgroundExecutor, TaskThrows) {
+  BackgroundExecutor executor{BackgroundExecutor::Config{}};
+  std::atomic<int> runs{0};
+  executor.addTask("task", Priority::kNormal, [&runs]() {
+    if (runs++ == 0) {
+      throw std::runtime_error("failed");
+    }
+    return 1ms;
+  });
+  // the task keeps running after a failure
+  EXPECT_TRUE(eventually([&runs]() { return runs > 1; }, 5s));
+}
+
+TEST(BackgroundExecutor, CpuBudget) {
+  BackgroundExecutor::Config config;
+  config.numThreads = 2;
+  config.cpuBudget = 0.1;
+  config.burstWindow = 100ms;
+  BackgroundExecutor executor{config};
+
+  std::atomic<int> lowRuns{0};
+  std::atomic<int> highRuns{0};
+  executor.addTask("low", Priority::kLow, [&lowRuns]() {
+    lowRuns++;
+    burnCpu(20ms);
+    return 0ms;
+  });
+  executor.addTask("high", Priority::kHigh, [&highRuns]() {
+    highRuns++;
+    return 10ms;
+  });
+
+  std::this_thread::sleep_for(1s);
+  // within a second, 0.1 cores allow 100ms plus the burst of 10ms. A run can
+  // only start while there is budget left, so the overshoot is one run.
+  EXPECT_LE(lowRuns, 10);
+  EXPECT_GT(lowRuns, 0);
+  EXPECT_GT(getStats(executor, "low").numThrottled, 0);
+
+  // high priority tasks are never held back
+  EXPECT_GT(highRuns, 30);
+  EXPECT_EQ(0, getStats(executor, "high").numThrottled);
+
+  std::map<std::string, uint64_t> counters;
+  executor.getCounters({[&counters](folly::StringPiece name, double value) {
+    counters[name.str()] = static_cast<uint64_t>(value);
+  }});
+  EXPECT_GT(counters["cachelib_bg_executor.throttled"], 0);
+  EXPECT_GT(counters["cachelib_bg_executor.low.low.cpu_time_us"], 0);
+  EXPECT_EQ(1, counters.count("cachelib_bg_executor.high.high.max_lag_ms"));
+}
+
+TEST(BackgroundExecutor, PeriodicWorker) {
+  auto executor =
+      std::make_shared<BackgroundExecutor>(BackgroundExecutor::Config{});
+  CountingWorker worker;
+  EXPECT_FALSE(worker.start(0ms, "worker", executor, Priority::kNormal));
+  EXPECT_TRUE(worker.start(5ms, "worker", executor, Priority::kNormal));
+  // already running
+  EXPECT_TRUE(worker.start(5ms, "worker", executor, Priority::kNormal));
+  EXPECT_TRUE(eventually([&worker]() { return worker.workCount >= 3; }));
+  EXPECT_EQ(1, worker.preWorkCount);
+  EXPECT_EQ(1, executor->getTaskStats().size());
+  EXPECT_GE(worker.getRunCount(), 3);
+
+  // the new interval applies after the current run
+  worker.setInterval(1h);
+  std::this_thread::sleep_for(50ms);
+  const int runs = worker.workCount;
+  worker.wakeUp();
+  EXPECT_TRUE(eventually([&]() { return worker.workCount > runs; }));
+
+  EXPECT_TRUE(worker.stop());
+  EXPECT_TRUE(executor->getTaskStats().empty());
+
+  // can be started again, with preWork running again
+  EXPECT_TRUE(worker.start(5ms, "worker", executor, Priority::kLow));
+  EXPECT_TRUE(eventually([&worker]() { return worker.preWorkCount == 2; }));
+  EXPECT_TRUE(worker.stop());
+}
+
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
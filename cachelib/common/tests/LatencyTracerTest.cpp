@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Conv.h>
+#include <folly/fibers/Baton.h>
+#include <folly/fibers/FiberManager.h>
+#include <folly/fibers/SimpleLoopController.h>
+#include <gtest/gtest.h>
+
+#include <array>
+#include <map>
+#include <thread>
+
+#include "cachelib/common/LatencyTracer.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+
+namespace {
+using namespace std::chrono_literals;
+
+std::shared_ptr<LatencyTracer> makeTracer(uint32_t sampleRate,
+                                          std::chrono::microseconds slow = 1s,
+                                          size_t maxSlowTraces = 10) {
+  LatencyTracer::Config config;
+  config.sampleRate = sampleRate;
+  config.slowThreshold = slow;
+  config.maxSlowTraces = maxSlowTraces;
+  return LatencyTracer::create(config);
+}
+
+uint64_t stageNs(const LatencyTracer::TraceRecord& record, TraceStage stage) {
+  return record.stageNs[static_cast<size_t>(stage)];
+}
+} // namespace
+
+TEST(LatencyTracer, ConfigValidation) {
+  LatencyTracer::Config config;
+  config.sampleRate = 0;
+  EXPECT_THROW(LatencyTracer::create(config), std::invalid_argument);
+
+  config.sampleRate = 10;
+  config.slowThreshold = 0us;
+  EXPECT_THROW(LatencyTracer::create(config), std::invalid_argument);
+  config.maxSlowTraces = 0;
+  EXPECT_NO_THROW(LatencyTracer::create(config));
+}
+
+TEST(LatencyTracer, NoTraceWithoutTracer) {
+  {
+    ScopedTrace trace{nullptr, TraceOp::kFind, "key"};
+    EXPECT_EQ(nullptr, Trace::current());
+    // stages are no-ops
+    ScopedTraceStage stage{TraceStage::kAccessContainer};
+  }
+  EXPECT_EQ(nullptr, Trace::current());
+}
+
+TEST(LatencyTracer, SampleRate) {
+  auto tracer = makeTracer(100);
+  int sampled = 0;
+  for (int i = 0; i < 100000; i++) {
+    ScopedTrace trace{tracer.get(), TraceOp::kFind, "key"};
+    if (Trace::current() != nullptr) {
+      sampled++;
+    }
+  }
+  EXPECT_GT(sampled, 700);
+  EXPECT_LT(sampled, 1300);
+
+  // every operation with a rate of 1
+  auto all = makeTracer(1);
+  for (int i = 0; i < 10; i++) {
+    ScopedTrace trace{all.get(), TraceOp::kFind, "key"};
+    EXPECT_NE(nullptr, Trace::current());
+  }
+}
+
+TEST(LatencyTracer, Stages) {
+  auto tracer = makeTracer(1, 1us);
+  {
+    ScopedTrace trace{tracer.get(), TraceOp::kInsert, "key"};
+    auto* current = Trace::current();
+    ASSERT_NE(nullptr, current);
+    {
+      ScopedTraceStage stage{TraceStage::kMMContainer};
+      std::this_thread::sleep_for(2ms);
+    }
+    {
+      // nested operations keep the outer trace
+      ScopedTrace inner{tracer.get(), TraceOp::kFind, "other"};
+      EXPECT_EQ(current, Trace::current());
+      ScopedTraceStage stage{TraceStage::kAccessContainer};
+    }
+    EXPECT_EQ(current, Trace::current());
+  }
+  EXPECT_EQ(nullptr, Trace::current());
+
+  auto traces = tracer->getSlowTraces();
+  ASSERT_EQ(1, traces.size());
+  EXPECT_EQ(TraceOp::kInsert, traces[0].op);
+  EXPECT_EQ("key", traces[0].key);
+  EXPECT_GE(stageNs(traces[0], TraceStage::kMMContainer), 2'000'000);
+  EXPECT_GT(stageNs(traces[0], TraceStage::kAccessContainer), 0);
+  EXPECT_EQ(0, stageNs(traces[0], TraceStage::kDeviceIo));
+  EXPECT_GE(traces[0].totalNs, stageNs(traces[0], TraceStage::kMMContainer));
+  EXPECT_NE(std::string::npos, traces[0].toString().find("mm_container_us="));
+}
+
+TEST(LatencyTracer, Handoff) {
+  auto tracer = makeTracer(1, 1us);
+  {
+    std::unique_ptr<TraceHandoff> handoff;
+    {
+      ScopedTrace trace{tracer.get(), TraceOp::kFind, "key"};
+      handoff = std::make_unique<TraceHandoff>();
+    }
+    // the trace is not finished while handed off
+    EXPECT_TRUE(tracer->getSlowTraces().empty());
+
+    std::this_thread::sleep_for(2ms);
+    std::thread t{[&handoff]() {
+      TraceResumeGuard guard{*handoff, TraceStage::kNavyQueue};
+      EXPECT_NE(nullptr, Trace::current());
+      ScopedTraceStage stage{TraceStage::kDeviceIo};
+    }};
+    t.join();
+    EXPECT_TRUE(tracer->getSlowTraces().empty());
+  }
+
+  auto traces = tracer->getSlowTraces();
+  ASSERT_EQ(1, traces.size());
+  EXPECT_GE(stageNs(traces[0], TraceStage::kNavyQueue), 2'000'000);
+  EXPECT_GT(stageNs(traces[0], TraceStage::kDeviceIo), 0);
+
+  // an unsampled job never runs with the trace of its context
+  std::unique_ptr<TraceHandoff> empty;
+  std::thread{[&empty]() {
+    empty = std::make_unique<TraceHandoff>();
+  }}.join();
+  ScopedTrace trace{tracer.get(), TraceOp::kFind, "key"};
+  auto* current = Trace::current();
+  ASSERT_NE(nullptr, current);
+  {
+    TraceResumeGuard guard{*empty, TraceStage::kNavyQueue};
+    EXPECT_EQ(nullptr, Trace::current());
+  }
+  EXPECT_EQ(current, Trace::current());
+}
+
+TEST(LatencyTracer, HandoffInterleavedFibers) {
+  auto tracer = makeTracer(1, 1us);
+  std::array<std::unique_ptr<TraceHandoff>, 2> handoffs;
+  for (auto& handoff : handoffs) {
+    ScopedTrace trace{tracer.get(), TraceOp::kFind, "key"};
+    handoff = std::make_unique<TraceHandoff>();
+  }
+
+  // both jobs are suspended in their scope, then the first one to start
+  // exits first
+  folly::fibers::FiberManager fm{
+      std::make_unique<folly::fibers::SimpleLoopController>()};
+  std::array<folly::fibers::Baton, 2> batons;
+  for (size_t i = 0; i < 2; i++) {
+    fm.addTask([&, i]() {
+      TraceResumeGuard guard{*handoffs[i], TraceStage::kNavyQueue};
+      batons[i].wait();
+    });
+  }
+  fm.loopUntilNoReady();
+  batons[0].post();
+  fm.loopUntilNoReady();
+  handoffs[0].reset();
+  batons[1].post();
+  fm.loopUntilNoReady();
+
+  // the finished first job's trace is not left current on the thread
+  EXPECT_EQ(nullptr, Trace::current());
+  handoffs[1].reset();
+  EXPECT_EQ(2, tracer->getSlowTraces().size());
+}
+
+TEST(LatencyTracer, StagesOfInterleavedFibers) {
+  auto tracer = makeTracer(1, 1us);
+  const std::array<TraceStage, 2> stages = {TraceStage::kDeviceIo,
+                                            TraceStage::kNavyIndex};
+  std::array<std::unique_ptr<TraceHandoff>, 2> handoffs;
+  for (size_t i = 0; i < 2; i++) {
+    ScopedTrace trace{tracer.get(), TraceOp::kFind, folly::to<std::string>(i)};
+    handoffs[i] = std::make_unique<TraceHandoff>();
+  }
+
+  // both jobs suspend in the middle of a stage, as in device IO. The second
+  // one finishes and its trace goes away while the first one is suspended.
+  folly::fibers::FiberManager fm{
+      std::make_unique<folly::fibers::SimpleLoopController>()};
+  std::array<folly::fibers::Baton, 2> batons;
+  std::array<Trace*, 2> resumed{};
+  for (size_t i = 0; i < 2; i++) {
+    fm.addTask([&, i]() {
+      TraceResumeGuard guard{*handoffs[i], TraceStage::kNavyQueue};
+      ScopedTraceStage stage{stages[i]};
+      batons[i].wait();
+      resumed[i] = Trace::current();
+    });
+  }
+  fm.loopUntilNoReady();
+  EXPECT_EQ(nullptr, Trace::current());
+
+  std::this_thread::sleep_for(1ms);
+  batons[1].post();
+  fm.loopUntilNoReady();
+  EXPECT_EQ(nullptr, Trace::current());
+  handoffs[1].reset();
+  ASSERT_EQ(1, tracer->getSlowTraces().size());
+
+  std::this_thread::sleep_for(1ms);
+  batons[0].post();
+  fm.loopUntilNoReady();
+  EXPECT_EQ(nullptr, Trace::current());
+  handoffs[0].reset();
+
+  // each fiber found its own trace when it resumed, and the stages went to it
+  EXPECT_NE(nullptr, resumed[0]);
+  EXPECT_NE(nullptr, resumed[1]);
+  EXPECT_NE(resumed[0], resumed[1]);
+  auto traces = tracer->getSlowTraces();
+  ASSERT_EQ(2, traces.size());
+  EXPECT_EQ("1", traces[0].key);
+  EXPECT_GE(stageNs(traces[0], TraceStage::kNavyIndex), 1'000'000);
+  EXPECT_EQ(0, stageNs(traces[0], TraceStage::kDeviceIo));
+  EXPECT_EQ("0", traces[1].key);
+  EXPECT_GE(stageNs(traces[1], TraceStage::kDeviceIo), 2'000'000);
+  EXPECT_EQ(0, stageNs(traces[1], TraceStage::kNavyIndex));
+}
+
+TEST(LatencyTracer, SlowTraces) {
+  auto tracer = makeTracer(1, 1ms, 3);
+  for (int i = 0; i < 5; i++) {
+    ScopedTrace trace{tracer.get(), TraceOp::kFind, folly::to<std::string>(i)};
+    std::this_thread::sleep_for(2ms);
+  }
+  {
+    // fast operations are not kept
+    ScopedTrace trace{tracer.get(), TraceOp::kFind, "fast"};
+  }
+
+  // the oldest are dropped first
+  auto traces = tracer->getSlowTraces();
+  ASSERT_EQ(3, traces.size());
+  EXPECT_EQ("2", traces[0].key);
+  EXPECT_EQ("4", traces[2].key);
+
+  std::map<std::string, double> counters;
+  tracer->getCounters({[&counters](folly::StringPiece name, double value) {
+    counters[name.str()] = value;
+  }});
+  EXPECT_EQ(6, counters["cachelib_trace.traces"]);
+  EXPECT_EQ(5, counters["cachelib_trace.slow_traces"]);
+  EXPECT_EQ(1, counters.count("cachelib_trace.find.total_us_p99"));
+  EXPECT_EQ(1, counters.count("cachelib_trace.insert.device_io_us_p99"));
+
+  tracer->dumpSlowTraces();
+  EXPECT_TRUE(tracer->getSlowTraces().empty());
+}
+
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/SharedMutex.h>
+#include <folly/synchronization/Baton.h>
+#include <folly/synchronization/DistributedMutex.h>
+#include <gtest/gtest.h>
+
+#include <map>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+#include "cachelib/common/LockProfiler.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+
+namespace {
+using namespace std::chrono_literals;
+} // namespace
+
+TEST(LockProfiler, WaitHistogram) {
+  EXPECT_EQ(0, LockContentionStats::getBucket(0));
+  EXPECT_EQ(0, LockContentionStats::getBucket(255));
+  EXPECT_EQ(1, LockContentionStats::getBucket(256));
+  EXPECT_EQ(2, LockContentionStats::getBucket(512));
+  EXPECT_EQ(LockContentionStats::kNumWaitBuckets - 1,
+            LockContentionStats::getBucket(uint64_t{1} << 40));
+
+  LockContentionStats stats;
+  EXPECT_EQ(0, stats.waitNsPercentile(0.99));
+  // 90 short waits and 10 waits of about 1ms
+  stats.waitNsHistogram[0] = 90;
+  stats.waitNsHistogram[LockContentionStats::getBucket(1'000'000)] = 10;
+  EXPECT_EQ(256, stats.waitNsPercentile(0.5));
+  EXPECT_EQ(256, stats.waitNsPercentile(0.9));
+  EXPECT_EQ(uint64_t{1} << 20, stats.waitNsPercentile(0.99));
+  EXPECT_EQ(uint64_t{1} << 20, stats.waitNsPercentile(1));
+}
+
+TEST(LockProfiler, SharedStatsByOwner) {
+  LockProfiler profiler;
+  auto* stats = profiler.getStats("owner");
+  EXPECT_EQ(stats, profiler.getStats("owner"));
+  EXPECT_NE(stats, profiler.getStats("other"));
+  EXPECT_EQ("owner", stats->getOwner());
+
+  // owners whose locks were never acquired are not reported
+  EXPECT_TRUE(profiler.getContentionStats().empty());
+}
+
+TEST(LockProfiler, Uncontended) {
+  LockProfiler profiler;
+  auto* stats = profiler.getStats("mutex");
+  std::mutex mutex;
+  for (int i = 0; i < 10; i++) {
+    auto l = util::lockProfiled<std::unique_lock<std::mutex>>(mutex, stats);
+    EXPECT_TRUE(l.owns_lock());
+  }
+
+  folly::SharedMutex sharedMutex;
+  {
+    auto r1 = util::lockProfiled<std::shared_lock<folly::SharedMutex>>(
+        sharedMutex, stats);
+    // readers do not contend with each other
+    auto r2 = util::lockProfiled<std::shared_lock<folly::SharedMutex>>(
+        sharedMutex, stats);
+    EXPECT_TRUE(r2.owns_lock());
+  }
+
+  // no stats, no profiling
+  auto l = util::lockProfiled<std::unique_lock<std::mutex>>(mutex, nullptr);
+  EXPECT_TRUE(l.owns_lock());
+
+  auto contention = profiler.getContentionStats();
+  ASSERT_EQ(1, contention.size());
+  EXPECT_EQ(12, contention["mutex"].numAcquisitions);
+  EXPECT_EQ(0, contention["mutex"].numContended);
+  EXPECT_EQ(0, contention["mutex"].totalWaitNs);
+}
+
+TEST(LockProfiler, Contended) {
+  LockProfiler profiler;
+  auto* stats = profiler.getStats("mutex");
+  std::mutex mutex;
+
+  folly::Baton<> locked;
+  std::thread holder{[&]() {
+    std::lock_guard<std::mutex> l{mutex};
+    locked.post();
+    std::this_thread::sleep_for(10ms);
+  }};
+  locked.wait();
+  {
+    auto l = util::lockProfiled<std::unique_lock<std::mutex>>(mutex, stats);
+    EXPECT_TRUE(l.owns_lock());
+  }
+  holder.join();
+
+  auto contention = profiler.getContentionStats()["mutex"];
+  EXPECT_EQ(1, contention.numAcquisitions);
+  EXPECT_EQ(1, contention.numContended);
+  EXPECT_GE(contention.totalWaitNs, 1'000'000);
+  EXPECT_GE(contention.waitNsPercentile(0.5), 1'000'000);
+
+  std::map<std::string, double> counters;
+  profiler.getCounters({[&counters](folly::StringPiece name, double value) {
+    counters[name.str()] = value;
+  }});
+  EXPECT_EQ(1, counters["cachelib_lock.mutex.acquisitions"]);
+  EXPECT_EQ(1, counters["cachelib_lock.mutex.contended"]);
+  EXPECT_GE(counters["cachelib_lock.mutex.wait_us"], 1000);
+  EXPECT_EQ(1, counters.count("cachelib_lock.mutex.wait_ns_p99"));
+}
+
+TEST(LockProfiler, LockCombine) {
+  LockProfiler profiler;
+  auto* stats = profiler.getStats("combine");
+  folly::DistributedMutex mutex;
+  int value = 0;
+
+  // uncontended
+  EXPECT_EQ(1, util::lockCombineProfiled(mutex, stats, [&]() {
+              return ++value;
+            }));
+  util::lockCombineProfiled(mutex, nullptr, [&]() { ++value; });
+  EXPECT_EQ(2, value);
+
+  folly::Baton<> locked;
+  std::thread holder{[&]() {
+    std::unique_lock<folly::DistributedMutex> l{mutex};
+    locked.post();
+    std::this_thread::sleep_for(10ms);
+  }};
+  locked.wait();
+  EXPECT_EQ(3, util::lockCombineProfiled(mutex, stats, [&]() {
+              return ++value;
+            }));
+  holder.join();
+
+  auto contention = profiler.getContentionStats()["combine"];
+  EXPECT_EQ(2, contention.numAcquisitions);
+  EXPECT_EQ(1, contention.numContended);
+  EXPECT_GE(contention.totalWaitNs, 1'000'000);
+}
+
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
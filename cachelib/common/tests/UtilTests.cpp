@@ -19,6 +19,7 @@
 #include <sys/mman.h>
 
 #include <atomic>
+#include <cstring>
 #include <unordered_map>
 
 #include "cachelib/common/FastStats.h"
@@ -173,6 +174,26 @@ TEST(Util, SysctlTests) {
 
 TEST(Util, MemAvailable) { EXPECT_GT(util::getMemAvailable(), 0); }
 
+TEST(Util, PrefaultMemory) {
+  const size_t len = 64 * util::getPageSize();
+  void* memory = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(MAP_FAILED, memory);
+  std::memset(memory, 'x', util::getPageSize());
+  ASSERT_EQ(1, util::getNumResidentPages(memory, len));
+
+  util::prefaultMemoryParallel(memory, len, 4);
+  EXPECT_EQ(util::getNumPages(len), util::getNumResidentPages(memory, len));
+  // prefaulting must not change the contents of memory
+  EXPECT_EQ('x', reinterpret_cast<char*>(memory)[0]);
+  EXPECT_EQ(0, reinterpret_cast<char*>(memory)[util::getPageSize()]);
+
+  EXPECT_THROW(
+      util::prefaultMemory(reinterpret_cast<uint8_t*>(memory) + 1, len - 1),
+      std::invalid_argument);
+  munmap(memory, len);
+}
+
 TEST(Util, CounterVisitor) {
   // Uninitialized can be called.
   util::CounterVisitor v;
@@ -43,6 +43,8 @@
 #include <folly/SharedMutex.h>
 #include <folly/logging/xlog.h>
 
+#include <memory>
+#include <mutex>
 #include <type_traits>
 #include <typeinfo>
 
@@ -53,6 +55,7 @@
 #include "cachelib/common/FastStats.h"
 #include "cachelib/common/Hash.h"
 #include "cachelib/common/Mutex.h"
+#include "cachelib/common/Throttler.h"
 #include "cachelib/compact_cache/CCacheFixedLruBucket.h"
 #include "cachelib/compact_cache/CCacheVariableLruBucket.h"
 
@@ -86,8 +89,6 @@ enum class CCacheReturn : int {
   FOUND = 1
 };
 
-enum class RehashOperation { COPY, DELETE };
-
 /**
  * Interface for a compact cache. User should not need to directly reference
  * this type. Instead, use CCacheCreator<...>::type as the Compact Cache type.
@@ -193,20 +194,19 @@ class CompactCache : public ICompactCache {
   ~CompactCache();
 
   /**
-   * Resize the arena of this compact cache.
-   * Shrinking the cache:
-   *  (1) Reduce num_chunks, so new requests only hash to the reduced size
-   *  (2) If currently taking requests, wait for all requests that picked up
-   *      the old num_chunk value to drain out. During this time some requests
-   *      will use the old and others will use the new num_chunk value, which
-   *      is ok because we're using a consistent hash.
-   *  (3) Walk the table and free the entries in the chunks we're not using.
-   *  (4) Free no longer used chunks.
-   * Growing the cache:
-   *  (1) Allocate new chunks
-   *  (2) Update num_chunks, wait for refcount on old value to hit 0
-   *  (3) Walk all the entries in the old table size and see which ones would
-   *      now hash to new chunks and move them.
+   * Resize the arena of this compact cache. The resize is incremental: the
+   * cache keeps serving requests from the new layout right away and buckets
+   * of the old layout are migrated one at a time.
+   *  (1) When growing, allocate the new chunks.
+   *  (2) Switch num_chunks to the new value. From now on, a request first
+   *      migrates the old bucket its key hashed to (if it has not been
+   *      migrated yet) and then operates on the bucket in the new layout.
+   *      Since we use a consistent hash, only entries that change chunks
+   *      need to move and they keep their bucket offset within the chunk.
+   *  (3) Sweep the old layout in the background, throttled, migrating the
+   *      buckets that were not accessed yet.
+   *  (4) Wait for all requests that might have picked up the old layout to
+   *      drain out and free the chunks that are no longer used.
    */
   void resize() override;
 
@@ -371,12 +371,6 @@ class CompactCache : public ICompactCache {
   using BucketCallBack = std::function<bool(Bucket*)>;
   bool forEachBucket(const BucketCallBack& cb);
 
-  /** Move or purge entries that would change which chunk they hash to
-   * based on the specified old and new numbers of chunks. */
-  void tableRehash(size_t oldNumChunks,
-                   size_t newNumChunks,
-                   RehashOperation op);
-
   /** return the current snapshot of all stats */
   CCacheStats getStats() const override { return stats_.getSnapshot(); }
 
@@ -414,12 +408,23 @@ class CompactCache : public ICompactCache {
    * chunk_index_high, exclusive. Used which shrinking the cache. */
   int tableChunksFree(size_t chunkIndexLow, size_t chunkIndexHigh);
 
+  /**
+   * Find the index of the chunk on which the specified key would be located
+   * given the specified number of chunks.
+   *
+   * @param numChunks Total number of chunks.
+   * @param key       Key for which to compute the corresponding chunk.
+   *
+   * @return index of the chunk.
+   */
+  size_t tableFindChunkIdx(size_t numChunks, const Key& key) const;
+
   /**
    * Find the chunk on which the specified key would be located given the
    * specified number of chunks. Used by tableFindBucket for looking update
-   * buckets in the table (in which case numChunks = arena_->num_chunks) and
-   * by tableRehashLarger (in which case numChunks is the new number of
-   * chunks).
+   * buckets in the table (in which case numChunks is the current number of
+   * chunks) and by migrateBucket (in which case numChunks is the number of
+   * chunks we are resizing to).
    *
    * @param numChunks Total number of chunks.
    * @praam key        Key for which to compute the corresponding chunk.
@@ -428,6 +433,12 @@ class CompactCache : public ICompactCache {
    */
   Bucket* tableFindChunk(size_t numChunks, const Key& key);
 
+  /**
+   * Find the offset of the bucket for the key within its chunk. This does
+   * not depend on the number of chunks.
+   */
+  size_t tableFindBucketIdx(const Key& key) const;
+
   /**
    * Find out which bucket an entry might be in. Do this in a 2 step process:
    * 1. Use consistent hashing (furc_hash) to determine the table chunk.
@@ -442,12 +453,12 @@ class CompactCache : public ICompactCache {
    * either still to the 15th bucket of chunk 3, or to the 15th bucket of
    * chunk 10.
    *
+   * @param numChunks  Total number of chunks.
    * @param const Key& key for which to determine the corresponding bucket.
    *
    * @return bucket that maps to the key.
    */
-  Bucket* tableFindBucket(const Key& key);
-  Bucket* tableFindDblWriteBucket(const Key& key);
+  Bucket* tableFindBucket(size_t numChunks, const Key& key);
 
   /**
    * Callback called by the bucket descriptor when an entry is evicted.
@@ -540,6 +551,13 @@ class CompactCache : public ICompactCache {
    */
   EntryHandle bucketFind(Bucket* bucket, const Key& key);
 
+  /**
+   * If a resize is in progress and numChunks is the layout we are resizing
+   * to, make sure the bucket the key hashed to in the old layout has been
+   * migrated. Must be called without holding any bucket lock.
+   */
+  void migrateBucketForKey(const Key& key, size_t numChunks);
+
   /**
    * Data for a compact cache instance.
    * The arena must remain alive (i.e. not free'd) during the lifetime of the
@@ -552,15 +570,83 @@ class CompactCache : public ICompactCache {
   ValidCb validCb_;
   facebook::cachelib::Cohort cohort_;     /**< resize cohort synchronization */
   mutable folly::SharedMutex resizeLock_; /**< Lock to synchronize resize. */
+  std::mutex migrationLock_; /**< serializes migration of buckets */
   const size_t bucketsPerChunk_;
   util::FastStats<CCacheStats> stats_;
   const bool allowPromotions_; /**< Whether promotions are allowed on read
                                     operations */
 
  protected:
-  // expose these two fields for test hack
+  /**
+   * State of an incremental resize. Tracks which buckets of the old layout
+   * have had their entries moved to the new layout.
+   */
+  class Migration {
+   public:
+    Migration(size_t oldChunks, size_t bucketsPerChunk)
+        : oldNumChunks(oldChunks),
+          bucketsPerChunk_(bucketsPerChunk),
+          migrated_(std::make_unique<std::atomic<uint64_t>[]>(
+              (oldChunks * bucketsPerChunk + 63) / 64)) {}
+
+    bool isMigrated(size_t chunkIdx, size_t bucketIdx) const {
+      const size_t bit = chunkIdx * bucketsPerChunk_ + bucketIdx;
+      return migrated_[bit / 64].load(std::memory_order_acquire) &
+             (1ULL << (bit % 64));
+    }
+
+    void markMigrated(size_t chunkIdx, size_t bucketIdx) {
+      const size_t bit = chunkIdx * bucketsPerChunk_ + bucketIdx;
+      migrated_[bit / 64].fetch_or(1ULL << (bit % 64),
+                                   std::memory_order_release);
+    }
+
+    /** number of chunks in the layout we are migrating away from */
+    const size_t oldNumChunks;
+
+   private:
+    const size_t bucketsPerChunk_;
+    std::unique_ptr<std::atomic<uint64_t>[]> migrated_;
+  };
+
+  /**
+   * Publish the migration state and switch requests over to the layout with
+   * newNumChunks chunks. The chunks must already be allocated.
+   */
+  void startMigration(size_t newNumChunks);
+
+  /**
+   * Walk the old layout and migrate all the buckets that have not been
+   * migrated by requests yet. Throttled to limit the cpu spent.
+   */
+  void sweepMigration();
+
+  /**
+   * Tear down the migration state once every bucket has been migrated. Waits
+   * for all requests that might still use the old layout to drain out.
+   */
+  void finishMigration();
+
+  /**
+   * Move the entries of the bucket at bucketIdx in chunk chunkIdx of the old
+   * layout to their buckets in the new layout. When shrinking, only a
+   * fraction of the entries is moved; the rest is evicted.
+   *
+   * @return true if the bucket was migrated by this call, false if it had
+   *         already been migrated.
+   */
+  bool migrateBucket(Migration& migration,
+                     size_t newNumChunks,
+                     size_t chunkIdx,
+                     size_t bucketIdx);
+
+  // expose these fields for test hack
   std::atomic<size_t> numChunks_;
-  std::atomic<size_t> pendingNumChunks_;
+
+  // non-null while an incremental resize is in progress. Owned by
+  // migrationState_.
+  std::atomic<Migration*> migration_{nullptr};
+  std::unique_ptr<Migration> migrationState_;
 };
 
 namespace detail {
@@ -669,8 +755,7 @@ CompactCache<C, A, B>::CompactCache(Allocator& allocator,
       bucketsPerChunk_(allocator_.getChunkSize() / sizeof(Bucket)),
       stats_{},
       allowPromotions_(allowPromotions),
-      numChunks_(allocator_.getNumChunks()),
-      pendingNumChunks_(0) {
+      numChunks_(allocator_.getNumChunks()) {
   allocator_.attach(this);
 }
 
@@ -679,113 +764,146 @@ CompactCache<C, A, B>::~CompactCache() {
   allocator_.detach();
 }
 
-/**
- * Move or purge entries that would change which chunk they hash to based on
- * the specified old and new numbers of chunks.
- *
- * @param oldNumChunks  old size of compact cache
- * @param newNumChunks  new size of compact cache
- * @param op            whether to create new entries COPY or delete
- *                      old ones DELETE in this call
- */
 template <typename C, typename A, typename B>
-void CompactCache<C, A, B>::tableRehash(size_t oldNumChunks,
-                                        size_t newNumChunks,
-                                        RehashOperation op) {
+bool CompactCache<C, A, B>::migrateBucket(Migration& migration,
+                                          size_t newNumChunks,
+                                          size_t chunkIdx,
+                                          size_t bucketIdx) {
   XDCHECK_LE(newNumChunks, allocator_.getNumChunks());
   XDCHECK_GT(newNumChunks, 0u);
-  XDCHECK_GT(oldNumChunks, 0u);
 
-  /* Loop through all entries in all buckets of the hash table. */
-  for (size_t n = 0; n < oldNumChunks; n++) {
-    Bucket* table_chunk = reinterpret_cast<Bucket*>(allocator_.getChunk(n));
-    for (size_t i = 0; i < bucketsPerChunk_; i++) {
-      Bucket* bucket = &table_chunk[i];
-      auto lock = locks_.lockExclusive(bucket);
-
-      const size_t capacity = BucketDescriptor::nEntriesCapacity(*bucket);
-      /* When expanding the cache (newNumChunks > oldNumChunks) move
-       * the entire capacity elements over.
-       * When shrinking cache to some fraction of its former size,
-       * move that fraction of the to-be-deleted chunks in order to
-       * maintain a non-zero cache lifetime throughout */
-      const size_t max_move = std::min(
-          std::max((newNumChunks * capacity) / oldNumChunks, (size_t)1),
-          capacity);
-      size_t moved = 0;
-      EntryHandle entry = BucketDescriptor::first(&table_chunk[i]);
-      while (entry) {
-        const bool valid_entry = !validCb_ || validCb_(entry.key());
-        auto remove_context =
-            valid_entry ? RemoveContext::kEviction : RemoveContext::kNormal;
-        Bucket* new_chunk = tableFindChunk(newNumChunks, entry.key());
-        if (new_chunk == table_chunk) {
-          entry.next();
-          continue;
-        }
+  /* Migrating a bucket is the only place where we hold more than one bucket
+   * lock at a time. Serializing migrations means that there is never more
+   * than one thread waiting on a second lock, so the arbitrary lock order
+   * between old and new buckets cannot deadlock. */
+  std::lock_guard<std::mutex> migrationLock(migrationLock_);
+
+  Bucket* tableChunk = reinterpret_cast<Bucket*>(allocator_.getChunk(chunkIdx));
+  Bucket* bucket = &tableChunk[bucketIdx];
+  auto lock = locks_.lockExclusive(bucket);
+  if (migration.isMigrated(chunkIdx, bucketIdx)) {
+    return false;
+  }
 
-        /* Moving takes two forms. If newNumChunks is bigger, we move
-         * everything to its new place in the newly allocated chunks.
-         * If smaller, we need to preserve read-after-write so we move
-         * a small initial fraction of the newly lost buckets to their
-         * new home, putting them at the head of the LRU.
-         *
-         * This occurs in two stages; first we insert the to-be-moved
-         * entries into their new home and call the removal callbacks
-         * for invalid or excess ones.
-         *
-         * Second, after reads have moved, we delete the old entries
-         * This is done in a new cohort to ensure reads never see
-         * a temporarily disappeared entry in cache.
-         */
-        if (op == RehashOperation::COPY) {
-          if (valid_entry && moved < max_move) {
-            /* Add new entry. Offset is the same, so no need to
-             * re-compute that hash
-             */
-            Bucket* newBucket = &new_chunk[i];
-            // lock ordering is established by the hash function;
-            // old hash -> new hash
-            // However there can be arbitrary hash collisions, so
-            // don't relock the same lock (we don't use recursive
-            // locks in general)
-            bool sameLock = locks_.isSameLock(newBucket, bucket);
-            auto higher_lock //
-                = sameLock   //
-                      ? std::unique_lock<folly::SharedMutex>()
-                      : locks_.lockExclusive(newBucket);
-            if (kHasValues) {
-              if (kValuesFixedSize) {
-                bucketSet(newBucket, entry.key(), entry.val());
-              } else {
-                bucketSet(newBucket, entry.key(), entry.val(), entry.size());
-              }
-            } else {
-              bucketSet(newBucket, entry.key());
-            }
-            moved++;
-          } else {
-            // not moving this one, either invalid or we're full
-            // call evict (or delete if invalid) callback
-            if (removeCb_) {
-              detail::callRemoveCb<SelfType>(
-                  removeCb_, entry.key(), entry.val(), remove_context);
-            }
-          }
-          entry.next();
+  const size_t oldNumChunks = migration.oldNumChunks;
+  const size_t capacity = BucketDescriptor::nEntriesCapacity(*bucket);
+  /* When expanding the cache (newNumChunks > oldNumChunks) move
+   * the entire capacity elements over.
+   * When shrinking cache to some fraction of its former size,
+   * move that fraction of the to-be-deleted chunks in order to
+   * maintain a non-zero cache lifetime throughout */
+  const size_t maxMove = std::min(
+      std::max((newNumChunks * capacity) / oldNumChunks, (size_t)1), capacity);
+  size_t moved = 0;
+  EntryHandle entry = BucketDescriptor::first(bucket);
+  while (entry) {
+    Bucket* newChunk = tableFindChunk(newNumChunks, entry.key());
+    if (newChunk == tableChunk) {
+      entry.next();
+      continue;
+    }
+
+    const bool validEntry = !validCb_ || validCb_(entry.key());
+    if (validEntry && moved < maxMove) {
+      /* Offset is the same, so no need to re-compute that hash. There can
+       * be arbitrary hash collisions on the locks, so don't relock the same
+       * lock (we don't use recursive locks in general). */
+      Bucket* newBucket = &newChunk[bucketIdx];
+      bool sameLock = locks_.isSameLock(newBucket, bucket);
+      auto newLock = sameLock ? std::unique_lock<folly::SharedMutex>()
+                              : locks_.lockExclusive(newBucket);
+      if (kHasValues) {
+        if (kValuesFixedSize) {
+          bucketSet(newBucket, entry.key(), entry.val());
         } else {
-          // on the second pass we run the deletes, to avoid
-          // read requests seeing no data in the interim
-          // actually delete here
-          BucketDescriptor::del(entry);
-          // no entry.next() call as del advances ptr
+          bucketSet(newBucket, entry.key(), entry.val(), entry.size());
         }
+      } else {
+        bucketSet(newBucket, entry.key());
       }
-      XDCHECK(newNumChunks <= oldNumChunks || !entry);
+      moved++;
+    } else if (removeCb_) {
+      // not moving this one, either invalid or we're full
+      // call evict (or delete if invalid) callback
+      detail::callRemoveCb<SelfType>(
+          removeCb_, entry.key(), entry.val(),
+          validEntry ? RemoveContext::kEviction : RemoveContext::kNormal);
     }
+    // no entry.next() call as del advances ptr
+    BucketDescriptor::del(entry);
+  }
+
+  /* Requests that picked up the old layout check whether the number of
+   * chunks changed after locking the bucket, so nothing will be added to
+   * this bucket for the keys we just moved. */
+  migration.markMigrated(chunkIdx, bucketIdx);
+  return true;
+}
+
+template <typename C, typename A, typename B>
+void CompactCache<C, A, B>::migrateBucketForKey(const Key& key,
+                                                size_t numChunks) {
+  Migration* migration = migration_;
+  if (LIKELY(migration == nullptr) || numChunks == migration->oldNumChunks) {
+    return;
+  }
+
+  const size_t oldChunkIdx = tableFindChunkIdx(migration->oldNumChunks, key);
+  if (oldChunkIdx == tableFindChunkIdx(numChunks, key)) {
+    return;
+  }
+
+  const size_t bucketIdx = tableFindBucketIdx(key);
+  if (!migration->isMigrated(oldChunkIdx, bucketIdx) &&
+      migrateBucket(*migration, numChunks, oldChunkIdx, bucketIdx)) {
+    ++stats_.tlStats().resizeLazyMigrations;
   }
 }
 
+template <typename C, typename A, typename B>
+void CompactCache<C, A, B>::startMigration(size_t newNumChunks) {
+  XDCHECK(migration_.load() == nullptr);
+  XDCHECK_LE(newNumChunks, allocator_.getNumChunks());
+
+  /* Publish the migration state before switching the number of chunks so
+   * that every request that picks up the new layout also migrates the old
+   * bucket of its key before touching the new one. */
+  migrationState_ = std::make_unique<Migration>(numChunks_, bucketsPerChunk_);
+  migration_ = migrationState_.get();
+  numChunks_ = newNumChunks;
+}
+
+template <typename C, typename A, typename B>
+void CompactCache<C, A, B>::sweepMigration() {
+  Migration* migration = migration_;
+  XDCHECK(migration != nullptr);
+  const size_t oldNumChunks = migration->oldNumChunks;
+  const size_t newNumChunks = numChunks_;
+
+  /* When shrinking, entries in the chunks we keep don't move because the
+   * hash is consistent. Only the chunks that go away need to be swept. */
+  const size_t firstChunk = newNumChunks < oldNumChunks ? newNumChunks : 0;
+  util::Throttler throttler;
+  for (size_t n = firstChunk; n < oldNumChunks; n++) {
+    for (size_t i = 0; i < bucketsPerChunk_; i++) {
+      if (!migration->isMigrated(n, i) &&
+          migrateBucket(*migration, newNumChunks, n, i)) {
+        ++stats_.tlStats().resizeSweepMigrations;
+      }
+      throttler.throttle();
+    }
+  }
+}
+
+template <typename C, typename A, typename B>
+void CompactCache<C, A, B>::finishMigration() {
+  migration_ = nullptr;
+  /* Wait for all requests that might still be looking at the migration
+   * state or at buckets of the old layout. */
+  cohort_.switchCohorts();
+  migrationState_.reset();
+}
+
 template <typename C, typename A, typename B>
 void CompactCache<C, A, B>::resize() {
   const size_t oldNumChunks = numChunks_;
@@ -817,37 +935,15 @@ void CompactCache<C, A, B>::resize() {
     }
   }
 
-  /* Update the number of chunks so new write requests start hitting both
-   * old and new chunks */
   XDCHECK_NE(newNumChunks, oldNumChunks);
-  XDCHECK_EQ(pendingNumChunks_.load(), 0u);
   /* only bother resharding if not going from/to 0 size */
   if (newNumChunks > 0 && oldNumChunks > 0) {
-    pendingNumChunks_ = newNumChunks;
-    /* Ensure all writes are double writing now */
-    cohort_.switchCohorts();
-
-    /* Sweep through the table and find all buckets that should now rehash.
-     * In offline mode, move entries; online we just delete
-     * to avoid invalidate races
-     */
-    tableRehash(oldNumChunks, newNumChunks, RehashOperation::COPY);
-
-    // now that rehash happened, we can start reading from the new location
-    // don't yet stop double writes as that ordering (no double write, read
-    // from old location) may not be guaranteed
-    // It likely is fine as those are ordered by a lock which should order
-    // the loads of the num_chunks value properly
-    numChunks_ = newNumChunks;
-    cohort_.switchCohorts();
-
-    // now stop double writes and wait for all requests to complete
-    // so that the old chunk locations are totally unused
-    pendingNumChunks_ = 0;
-    cohort_.switchCohorts();
-
-    // now go through again and delete stale entries in the old location
-    tableRehash(oldNumChunks, newNumChunks, RehashOperation::DELETE);
+    /* Requests start using the new layout right away and pull the entries
+     * they need from the old layout on demand. The sweep takes care of the
+     * rest. */
+    startMigration(newNumChunks);
+    sweepMigration();
+    finishMigration();
   } else {
     numChunks_ = newNumChunks;
 
@@ -963,39 +1059,59 @@ int CompactCache<C, A, B>::callBucketFn(
   /* 1) Increase the refcount of the current cohort. */
   Cohort::Token tok = cohort_.incrActiveReqs();
 
-  /* 2) Find the hash table bucket for the key. */
-  Bucket* bucket = tableFindBucket(key);
-
-  /* 3) Lock the bucket. Immutable bucket is a parameter
-   * regarding whether we're allowed to modify the bucket in any way,
-   * meaning we take an exclusive lock, or not, meaning we take a
-   * shared lock for reads without promotion. We may need to promote
-   * in a second pass in the latter case. */
+  /* Immutable bucket is a parameter regarding whether we're allowed to
+   * modify the bucket in any way, meaning we take an exclusive lock, or not,
+   * meaning we take a shared lock for reads without promotion. We may need
+   * to promote in a second pass in the latter case. */
   BucketReturn rv;
+  Bucket* bucket = nullptr;
   bool immutable_bucket = (op == Operation::READ);
 
-  /* 4) Call the request handler. */
-  if (immutable_bucket) {
-    auto lock = locks_.lockShared(timeout, bucket);
-    if (!lock.owns_lock()) {
-      XDCHECK(timeout > std::chrono::microseconds::zero());
-      ++stats_.tlStats().lockTimeout;
-      return -2;
+  for (;;) {
+    const size_t numChunks = numChunks_;
+    if (numChunks == 0) {
+      return -1;
     }
 
-    rv = (this->*f)(bucket, key, args...);
-  } else {
-    auto lock = locks_.lockExclusive(timeout, bucket);
-    if (!lock.owns_lock()) {
-      XDCHECK(timeout > std::chrono::microseconds::zero());
-      ++stats_.tlStats().lockTimeout;
-      return -2;
-    }
+    /* 2) If we are in the middle of a resize, pull the entries for this key
+     * over from the old layout. */
+    migrateBucketForKey(key, numChunks);
+
+    /* 3) Find the hash table bucket for the key. */
+    bucket = tableFindBucket(numChunks, key);
 
-    rv = (this->*f)(bucket, key, args...);
+    /* 4) Lock the bucket and call the request handler. If a resize switched
+     * the layout before we got the lock, the bucket may have been migrated
+     * already; retry with the new layout. */
+    if (immutable_bucket) {
+      auto lock = locks_.lockShared(timeout, bucket);
+      if (!lock.owns_lock()) {
+        XDCHECK(timeout > std::chrono::microseconds::zero());
+        ++stats_.tlStats().lockTimeout;
+        return -2;
+      }
+      if (numChunks != numChunks_) {
+        continue;
+      }
+
+      rv = (this->*f)(bucket, key, args...);
+    } else {
+      auto lock = locks_.lockExclusive(timeout, bucket);
+      if (!lock.owns_lock()) {
+        XDCHECK(timeout > std::chrono::microseconds::zero());
+        ++stats_.tlStats().lockTimeout;
+        return -2;
+      }
+      if (numChunks != numChunks_) {
+        continue;
+      }
+
+      rv = (this->*f)(bucket, key, args...);
+    }
+    break;
   }
 
-  /* 5.5) Promote if necessary from a read operation */
+  /* 5) Promote if necessary from a read operation */
   if (UNLIKELY(rv == BucketReturn::PROMOTE)) {
     XDCHECK(immutable_bucket);
     XDCHECK_EQ(op, Operation::READ);
@@ -1013,65 +1129,39 @@ int CompactCache<C, A, B>::callBucketFn(
     }
   }
   XDCHECK(rv != BucketReturn::PROMOTE);
-
-  /* 6) Do the operation on the new location if necessary
-   * Note that although we release the old lock, the order is very
-   * important. The rehasher will be doing lock old -> read old ->
-   * lock new -> write new -> unlock both
-   * So, we need to make sure that our old update either happens
-   * before the rehasher reads, or if it happens after then the new update
-   * also happens after. IE new update has to be second.
-   */
-  Bucket* bucketDbl =
-      (op == Operation::WRITE) ? tableFindDblWriteBucket(key) : nullptr;
-
-  if (bucketDbl != nullptr) {
-    auto lockDbl = locks_.lockExclusive(bucketDbl);
-    if ((this->*f)(bucketDbl, key, args...) == BucketReturn::ERROR) {
-      rv = BucketReturn::ERROR;
-    }
-  }
   XDCHECK_NE(toInt(rv), 2);
   return toInt(rv);
 }
 
 template <typename C, typename A, typename B>
-typename CompactCache<C, A, B>::Bucket* CompactCache<C, A, B>::tableFindChunk(
-    size_t numChunks, const Key& key) {
+size_t CompactCache<C, A, B>::tableFindChunkIdx(size_t numChunks,
+                                                const Key& key) const {
   XDCHECK_GT(numChunks, 0u);
   XDCHECK_LE(numChunks, allocator_.getNumChunks());
 
   /* furcHash is well behaved; numChunks <= 1 returns 0 for chunkIndex */
-  auto chunkIndex = facebook::cachelib::furcHash(
+  return facebook::cachelib::furcHash(
       reinterpret_cast<const void*>(&key), sizeof(key), numChunks);
-  return reinterpret_cast<Bucket*>(allocator_.getChunk(chunkIndex));
 }
 
 template <typename C, typename A, typename B>
-typename CompactCache<C, A, B>::Bucket* CompactCache<C, A, B>::tableFindBucket(
-    const Key& key) {
-  Bucket* chunk = tableFindChunk(numChunks_, key);
+typename CompactCache<C, A, B>::Bucket* CompactCache<C, A, B>::tableFindChunk(
+    size_t numChunks, const Key& key) {
+  return reinterpret_cast<Bucket*>(
+      allocator_.getChunk(tableFindChunkIdx(numChunks, key)));
+}
 
+template <typename C, typename A, typename B>
+size_t CompactCache<C, A, B>::tableFindBucketIdx(const Key& key) const {
   uint32_t hv = MurmurHash2()(reinterpret_cast<const void*>(&key), sizeof(key));
-  return &chunk[hv % bucketsPerChunk_];
+  return hv % bucketsPerChunk_;
 }
 
 template <typename C, typename A, typename B>
-typename CompactCache<C, A, B>::Bucket*
-CompactCache<C, A, B>::tableFindDblWriteBucket(const Key& key) {
-  // this var is volatile and can be 0, which will cause
-  // asserts later; avoid this case
-  size_t pending = pendingNumChunks_;
-  if (pending == 0) {
-    return nullptr;
-  }
-  Bucket* chunk = tableFindChunk(numChunks_, key);
-  Bucket* chunkNew = tableFindChunk(pending, key);
-  if (chunk == chunkNew) {
-    return nullptr;
-  }
-  uint32_t hv = MurmurHash2()(reinterpret_cast<const void*>(&key), sizeof(key));
-  return &chunkNew[hv % bucketsPerChunk_];
+typename CompactCache<C, A, B>::Bucket* CompactCache<C, A, B>::tableFindBucket(
+    size_t numChunks, const Key& key) {
+  Bucket* chunk = tableFindChunk(numChunks, key);
+  return &chunk[tableFindBucketIdx(key)];
 }
 
 template <typename C, typename A, typename B>
@@ -1205,7 +1295,7 @@ bool CompactCache<C, A, B>::forEachBucket(const BucketCallBack& cb) {
 
   // this obtains a resize lock so it cannot be occuring during an actual
   // resize; assert that
-  XDCHECK_EQ(pendingNumChunks_.load(), 0u);
+  XDCHECK(migration_.load() == nullptr);
 
   /* Loop through all buckets in the table. */
   for (size_t n = 0; n < numChunks_; n++) {
@@ -135,7 +135,12 @@ class CCWrapper : public CC {
  public:
   std::atomic<size_t>& numChunks() { return CC::numChunks_; }
 
-  std::atomic<size_t>& pendingNumChunks() { return CC::pendingNumChunks_; }
+  // drive the steps of an incremental resize individually
+  void startMigration(size_t newNumChunks) {
+    CC::startMigration(newNumChunks);
+  }
+  void sweepMigration() { CC::sweepMigration(); }
+  void finishMigration() { CC::finishMigration(); }
 };
 
 /**
@@ -297,14 +302,22 @@ static void testResizeSmaller(bool allowPromotions) {
   auto ccache = setup.getCache();
 
   ASSERT_EQ(ccache->numChunks(), wantSlabs);
-  ccache->pendingNumChunks() = 1;
   for (int i = 1; i < 100; i++) {
     ASSERT_EQ(CCacheReturn::NOTFOUND, ccache->set(i, &dummyValue));
     ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
   }
 
-  // also find them in the new chunk from the double writing
-  ccache->numChunks() = ccache->pendingNumChunks().load();
+  // switch to the smaller layout without sweeping. Every lookup pulls its
+  // bucket over from the old layout.
+  ccache->startMigration(wantSlabs / 2);
+  for (int i = 1; i < 100; i++) {
+    ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
+  }
+  ASSERT_GT(ccache->getStats().resizeLazyMigrations, 0u);
+
+  ccache->sweepMigration();
+  ccache->finishMigration();
+
   for (int i = 1; i < 100; i++) {
     ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
   }
@@ -321,15 +334,21 @@ static void testResizeLarger(bool allowPromotions) {
   auto ccache = setup.getCache();
 
   ASSERT_EQ(ccache->numChunks(), wantSlabs);
-  ccache->pendingNumChunks() = ccache->numChunks().load();
   ccache->numChunks() = 1;
   for (int i = 1; i < 100; i++) {
     ASSERT_EQ(CCacheReturn::NOTFOUND, ccache->set(i, &dummyValue));
     ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
   }
 
-  // also find them in the new chunk from the double writing
-  ccache->numChunks() = ccache->pendingNumChunks().load();
+  // writes to the new layout must see the entries of the old one
+  ccache->startMigration(wantSlabs);
+  for (int i = 1; i < 100; i++) {
+    ASSERT_EQ(CCacheReturn::FOUND, ccache->set(i, &dummyValue));
+  }
+  ASSERT_GT(ccache->getStats().resizeLazyMigrations, 0u);
+  ccache->sweepMigration();
+  ccache->finishMigration();
+
   for (int i = 1; i < 100; i++) {
     ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
   }
@@ -352,24 +371,13 @@ static void testRehashSmaller(bool allowPromotions) {
     ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
   }
 
-  // also find them in new chunk after rehashing
+  // the sweep alone must move everything over to the new layout
   size_t curChunks = ccache->numChunks();
-
-  ccache->numChunks() = curChunks / 2;
-
-  int hits = 0;
-
-  for (int i = 1; i < 100; i++) {
-    if (ccache->get(i, &out) == CCacheReturn::FOUND) {
-      hits++;
-    }
-  }
-  // expect about half to still hit
-  ASSERT_TRUE(hits < 60);
-  ASSERT_TRUE(hits > 40);
-
-  ccache->tableRehash(
-      curChunks, curChunks / 2, facebook::cachelib::RehashOperation::COPY);
+  ccache->startMigration(curChunks / 2);
+  ccache->sweepMigration();
+  ccache->finishMigration();
+  ASSERT_EQ(0u, ccache->getStats().resizeLazyMigrations);
+  ASSERT_GT(ccache->getStats().resizeSweepMigrations, 0u);
 
   for (int i = 1; i < 100; i++) {
     ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
@@ -398,22 +406,13 @@ static void testRehashLarger(bool allowPromotions) {
     ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
   }
 
-  ccache->numChunks() = curChunks;
-
-  int hits = 0;
-
-  for (int i = 1; i < 100; i++) {
-    if (ccache->get(i, &out) == CCacheReturn::FOUND) {
-      hits++;
-    }
-  }
-  // expect about half to still hit
-  ASSERT_TRUE(hits < 60);
-  ASSERT_TRUE(hits > 40);
-
-  ccache->tableRehash(
-      curChunks / 2, curChunks, facebook::cachelib::RehashOperation::COPY);
+  ccache->startMigration(curChunks);
+  ccache->sweepMigration();
+  ccache->finishMigration();
+  ASSERT_EQ(0u, ccache->getStats().resizeLazyMigrations);
+  ASSERT_GT(ccache->getStats().resizeSweepMigrations, 0u);
 
+  // about half of the keys moved to new chunks; all of them must hit
   for (int i = 1; i < 100; i++) {
     ASSERT_EQ(CCacheReturn::FOUND, ccache->get(i, &out));
   }
@@ -0,0 +1,287 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Format.h>
+#include <folly/lang/Bits.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "cachelib/allocator/TypedHandle.h"
+
+namespace facebook {
+namespace cachelib {
+
+namespace detail {
+// Bitmap stored directly in an item. Like a roaring bitmap, the bits are
+// split into chunks of 2^16 and the number of bits set in each chunk is
+// kept, so counting is O(number of chunks) and merges skip empty chunks.
+// Unlike a roaring bitmap, every chunk is a dense array of words so the
+// size of the bitmap is fixed when it is created.
+//
+// Layout: header, words, then one cardinality per chunk.
+class BitmapLayout {
+ public:
+  static constexpr uint32_t kChunkBits = 1u << 16;
+  static constexpr uint32_t kWordsPerChunk = kChunkBits / 64;
+
+  static uint32_t computeStorageSize(uint32_t numBits) {
+    return static_cast<uint32_t>(sizeof(BitmapLayout)) +
+           computeNumWords(numBits) * sizeof(uint64_t) +
+           computeNumChunks(numBits) * sizeof(uint32_t);
+  }
+
+  // Construct a new layout with all bits cleared
+  explicit BitmapLayout(uint32_t numBits)
+      : numBits_{numBits}, numChunks_{computeNumChunks(numBits)} {
+    clear();
+  }
+
+  uint32_t numBits() const { return numBits_; }
+
+  // Return whether the bit was cleared before
+  bool set(uint32_t index) {
+    checkBounds(index);
+    auto& word = words_[index / 64];
+    const uint64_t mask = uint64_t{1} << (index % 64);
+    if (word & mask) {
+      return false;
+    }
+    word |= mask;
+    cardinalities()[index / kChunkBits]++;
+    return true;
+  }
+
+  // Return whether the bit was set before
+  bool reset(uint32_t index) {
+    checkBounds(index);
+    auto& word = words_[index / 64];
+    const uint64_t mask = uint64_t{1} << (index % 64);
+    if (!(word & mask)) {
+      return false;
+    }
+    word &= ~mask;
+    cardinalities()[index / kChunkBits]--;
+    return true;
+  }
+
+  bool test(uint32_t index) const {
+    checkBounds(index);
+    return words_[index / 64] & (uint64_t{1} << (index % 64));
+  }
+
+  // Number of bits set
+  uint64_t count() const {
+    uint64_t count = 0;
+    for (uint32_t chunk = 0; chunk < numChunks_; chunk++) {
+      count += cardinalities()[chunk];
+    }
+    return count;
+  }
+
+  // Set the bits set in the other bitmap. Chunks empty in the other bitmap
+  // are skipped. The word loops are left for the compiler to vectorize.
+  // @throw std::invalid_argument if the sizes differ
+  void merge(const BitmapLayout& other) {
+    checkSameSize(other);
+    for (uint32_t chunk = 0; chunk < numChunks_; chunk++) {
+      if (other.cardinalities()[chunk] == 0) {
+        continue;
+      }
+      uint32_t cardinality = 0;
+      for (uint32_t i = chunkBegin(chunk); i < chunkEnd(chunk); i++) {
+        words_[i] |= other.words_[i];
+        cardinality += folly::popcount(words_[i]);
+      }
+      cardinalities()[chunk] = cardinality;
+    }
+  }
+
+  // Clear the bits not set in the other bitmap. Chunks empty in either
+  // bitmap are not read.
+  // @throw std::invalid_argument if the sizes differ
+  void intersect(const BitmapLayout& other) {
+    checkSameSize(other);
+    for (uint32_t chunk = 0; chunk < numChunks_; chunk++) {
+      if (cardinalities()[chunk] == 0) {
+        continue;
+      }
+      if (other.cardinalities()[chunk] == 0) {
+        std::fill(words_ + chunkBegin(chunk), words_ + chunkEnd(chunk), 0);
+        cardinalities()[chunk] = 0;
+        continue;
+      }
+      uint32_t cardinality = 0;
+      for (uint32_t i = chunkBegin(chunk); i < chunkEnd(chunk); i++) {
+        words_[i] &= other.words_[i];
+        cardinality += folly::popcount(words_[i]);
+      }
+      cardinalities()[chunk] = cardinality;
+    }
+  }
+
+  void clear() {
+    std::fill(words_, words_ + computeNumWords(numBits_), 0);
+    std::fill(cardinalities(), cardinalities() + numChunks_, 0);
+  }
+
+ private:
+  static uint32_t computeNumWords(uint32_t numBits) {
+    return static_cast<uint32_t>((uint64_t{numBits} + 63) / 64);
+  }
+
+  static uint32_t computeNumChunks(uint32_t numBits) {
+    return static_cast<uint32_t>((uint64_t{numBits} + kChunkBits - 1) /
+                                 kChunkBits);
+  }
+
+  uint32_t chunkBegin(uint32_t chunk) const { return chunk * kWordsPerChunk; }
+  uint32_t chunkEnd(uint32_t chunk) const {
+    return std::min(chunkBegin(chunk) + kWordsPerChunk,
+                    computeNumWords(numBits_));
+  }
+
+  uint32_t* cardinalities() {
+    return reinterpret_cast<uint32_t*>(words_ + computeNumWords(numBits_));
+  }
+  const uint32_t* cardinalities() const {
+    return reinterpret_cast<const uint32_t*>(words_ +
+                                             computeNumWords(numBits_));
+  }
+
+  void checkBounds(uint32_t index) const {
+    if (index >= numBits_) {
+      throw std::out_of_range(
+          folly::sformat("index: {}, numBits: {}", index, numBits_));
+    }
+  }
+
+  void checkSameSize(const BitmapLayout& other) const {
+    if (numBits_ != other.numBits_) {
+      throw std::invalid_argument(
+          folly::sformat("Combining bitmap of {} bits with {} bits",
+                         other.numBits_, numBits_));
+    }
+  }
+
+  const uint32_t numBits_;
+  const uint32_t numChunks_;
+  uint64_t words_[];
+};
+} // namespace detail
+
+// Bitmap of a fixed number of bits. Counting the bits set reads one count
+// per 2^16 bits instead of every word.
+//
+// @param C   this is an instance of CacheAllocator<> or provides
+//            the same functionality
+template <typename C>
+class Bitmap {
+ public:
+  using CacheType = C;
+  using Item = typename CacheType::Item;
+  using WriteHandle = typename Item::WriteHandle;
+
+  using Layout = detail::BitmapLayout;
+  using LayoutHandle = TypedHandleImpl<Item, Layout>;
+
+  // Convert to a bitmap from a WriteHandle
+  // This does not modify anything in the item
+  static Bitmap fromWriteHandle(WriteHandle handle) {
+    return Bitmap{std::move(handle)};
+  }
+
+  // Compute the storage required for the number of bits
+  static uint32_t computeStorageSize(uint32_t numBits) {
+    return Layout::computeStorageSize(numBits);
+  }
+
+  // Construct an empty bitmap from a WriteHandle
+  // This modifies the item's memory
+  // @throw std::invalid_argument  if the item does not have enough memory
+  Bitmap(WriteHandle handle, uint32_t numBits) : layout_{std::move(handle)} {
+    const auto requiredSize = computeStorageSize(numBits);
+    const auto itemSize = layout_.viewWriteHandle()->getSize();
+    if (requiredSize > itemSize) {
+      throw std::invalid_argument(folly::sformat(
+          "Item size too small. Expected at least: {}, Actual: {}",
+          requiredSize, itemSize));
+    }
+    new (layout_.viewWriteHandle()->getMemory()) Layout(numBits);
+  }
+
+  // Bitmap can be moved but not copied
+  Bitmap(Bitmap&& rhs) = default;
+  Bitmap& operator=(Bitmap&& rhs) = default;
+
+  // Set, reset or test a bit
+  // @throw std::out_of_range   if index is out of range
+  bool set(uint32_t index) { return layout_->set(index); }
+  bool reset(uint32_t index) { return layout_->reset(index); }
+  bool test(uint32_t index) const { return layout_->test(index); }
+
+  // Set all the bits of a range of indices, without looking up the item per
+  // bit. Return the number of bits that were cleared before.
+  // @throw std::out_of_range   if an index is out of range. The bits before
+  //                            it are set.
+  template <typename IndexRange>
+  uint32_t setBatch(const IndexRange& indices) {
+    auto& layout = *layout_;
+    uint32_t numSet = 0;
+    for (uint32_t index : indices) {
+      numSet += layout.set(index);
+    }
+    return numSet;
+  }
+
+  // Number of bits set
+  uint64_t count() const { return layout_->count(); }
+
+  // Union and intersection with a bitmap of the same size
+  // @throw std::invalid_argument if the sizes differ
+  void merge(const Bitmap& other) { layout_->merge(*other.layout_); }
+  void intersect(const Bitmap& other) { layout_->intersect(*other.layout_); }
+
+  // Clear all the bits
+  void clear() { layout_->clear(); }
+
+  uint32_t numBits() const { return layout_->numBits(); }
+
+  // This does not modify the content of this structure.
+  // It resets it to a write handle, which can be used with any API in
+  // CacheAllocator that deals with WriteHandle. After invoking this function,
+  // this structure is left in a null state.
+  WriteHandle resetToWriteHandle() && {
+    return std::move(layout_).resetToWriteHandle();
+  }
+
+  // Borrow the write handle underneath this structure. This is useful to
+  // implement insertion into CacheAllocator.
+  const WriteHandle& viewWriteHandle() const {
+    return layout_.viewWriteHandle();
+  }
+
+  bool isNullWriteHandle() const { return layout_ == nullptr; }
+
+ private:
+  LayoutHandle layout_;
+
+  explicit Bitmap(WriteHandle handle) : layout_{std::move(handle)} {}
+};
+} // namespace cachelib
+} // namespace facebook
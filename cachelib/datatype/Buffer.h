@@ -438,13 +438,8 @@ class BufferManagerIterator
  public:
   explicit BufferManagerIterator(const Mgr& mgr)
       : mgr_(mgr),
-        curr_(mgr_.cache_->viewAsWritableChainedAllocs(*mgr_.parent_)
-                  .getNthInChain(index_)
-                  ->template getMemoryAs<Buffer>()
-                  ->begin()),
-        numChainedItems_(static_cast<uint32_t>(
-            mgr_.cache_->viewAsChainedAllocs(*mgr_.parent_)
-                .computeChainLength())) {
+        numChainedItems_(static_cast<uint32_t>(mgr_.buffers_.size())),
+        curr_(getNthBuffer(index_)->begin()) {
     if (curr_ == Buffer::Iterator()) {
       // Currently, curr_ is invalid. So we increment to try to find
       // an valid iterator
@@ -491,21 +486,29 @@ class BufferManagerIterator
  private:
   void incrementIntoNextBuffer() {
     while (curr_ == Buffer::Iterator{}) {
-      auto allocs = mgr_.cache_->viewAsWritableChainedAllocs(*mgr_.parent_);
-      auto* item = allocs.getNthInChain(++index_);
-      if (!item) {
+      auto* buffer = getNthBuffer(++index_);
+      if (!buffer) {
         // we've reached the end of BufferManager
         return;
       }
 
-      curr_ = item->template getMemoryAs<Buffer>()->begin();
+      curr_ = buffer->begin();
     }
   }
 
+  // Buffers are materialized by the manager in reverse chain order. Walking
+  // them from there avoids traversing the chain again for every buffer.
+  Buffer* getNthBuffer(uint32_t n) const {
+    if (n >= numChainedItems_) {
+      return nullptr;
+    }
+    return mgr_.getBuffer(numChainedItems_ - n - 1);
+  }
+
   uint32_t index_{0};
   const Mgr& mgr_;
-  Buffer::Iterator curr_{};
   const uint32_t numChainedItems_{0};
+  Buffer::Iterator curr_{};
 };
 
 template <typename C>
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Format.h>
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include "cachelib/allocator/TypedHandle.h"
+#include "cachelib/common/Hash.h"
+
+namespace facebook {
+namespace cachelib {
+
+namespace detail {
+// Count-min sketch counters stored directly in an item, one row of "width"
+// counters per hash. Rows are hashed the same way as util::CountMinSketch.
+template <typename UINT>
+class CountMinTableLayout {
+ public:
+  static_assert(std::is_unsigned<UINT>::value, "counters must be unsigned");
+
+  static uint32_t computeStorageSize(uint32_t width, uint32_t depth) {
+    return static_cast<uint32_t>(sizeof(CountMinTableLayout) +
+                                 uint64_t{width} * depth * sizeof(UINT));
+  }
+
+  // Construct a new layout with all counters at zero
+  CountMinTableLayout(uint32_t width, uint32_t depth)
+      : width_{width}, depth_{depth} {
+    reset();
+  }
+
+  uint32_t width() const { return width_; }
+  uint32_t depth() const { return depth_; }
+
+  static constexpr UINT getMaxCount() {
+    return std::numeric_limits<UINT>::max();
+  }
+
+  // Add count to the counters of the key, saturating at the maximum count
+  void increment(uint64_t key, UINT count) {
+    for (uint32_t row = 0; row < depth_; row++) {
+      auto& counter = counters_[getIndex(row, key)];
+      counter = saturatingAdd(counter, count);
+    }
+  }
+
+  UINT getCount(uint64_t key) const {
+    UINT count = getMaxCount();
+    for (uint32_t row = 0; row < depth_; row++) {
+      count = std::min(count, counters_[getIndex(row, key)]);
+    }
+    return count;
+  }
+
+  // Add the counters of the other table, saturating at the maximum count.
+  // @throw std::invalid_argument if the dimensions differ
+  void merge(const CountMinTableLayout& other) {
+    if (width_ != other.width_ || depth_ != other.depth_) {
+      throw std::invalid_argument(folly::sformat(
+          "Merging count-min table of {}x{} into {}x{}", other.width_,
+          other.depth_, width_, depth_));
+    }
+    for (uint64_t i = 0; i < numCounters(); i++) {
+      counters_[i] = saturatingAdd(counters_[i], other.counters_[i]);
+    }
+  }
+
+  // count *= decay for all the counters
+  void decayCountsBy(double decay) {
+    for (uint64_t i = 0; i < numCounters(); i++) {
+      counters_[i] = static_cast<UINT>(counters_[i] * decay);
+    }
+  }
+
+  void reset() { std::fill(counters_, counters_ + numCounters(), 0); }
+
+ private:
+  static UINT saturatingAdd(UINT a, UINT b) {
+    const UINT sum = static_cast<UINT>(a + b);
+    return sum < a ? getMaxCount() : sum;
+  }
+
+  uint64_t numCounters() const { return uint64_t{width_} * depth_; }
+
+  uint64_t getIndex(uint32_t row, uint64_t key) const {
+    const auto rowIndex = combineHashes(hashInt(row), key) % width_;
+    return uint64_t{row} * width_ + rowIndex;
+  }
+
+  const uint32_t width_;
+  const uint32_t depth_;
+  UINT counters_[];
+};
+} // namespace detail
+
+// Approximate counts per key in a width x depth table of counters. A count
+// is never lower than the true one until one of its counters saturates.
+//
+// @param UINT  unsigned counter type. Smaller counters save memory but
+//              saturate sooner.
+// @param C     this is an instance of CacheAllocator<> or provides
+//              the same functionality
+template <typename UINT, typename C>
+class CountMinTable {
+ public:
+  using Counter = UINT;
+
+  using CacheType = C;
+  using Item = typename CacheType::Item;
+  using WriteHandle = typename Item::WriteHandle;
+
+  using Layout = detail::CountMinTableLayout<Counter>;
+  using LayoutHandle = TypedHandleImpl<Item, Layout>;
+
+  // Convert to a count-min table from a WriteHandle
+  // This does not modify anything in the item
+  static CountMinTable fromWriteHandle(WriteHandle handle) {
+    return CountMinTable{std::move(handle)};
+  }
+
+  // Compute the storage required for depth rows of width counters
+  static uint32_t computeStorageSize(uint32_t width, uint32_t depth) {
+    return Layout::computeStorageSize(width, depth);
+  }
+
+  // Construct an empty count-min table from a WriteHandle
+  // This modifies the item's memory
+  // @throw std::invalid_argument  if width or depth is 0 or the item does
+  //                               not have enough memory
+  CountMinTable(WriteHandle handle, uint32_t width, uint32_t depth)
+      : layout_{std::move(handle)} {
+    if (width == 0 || depth == 0) {
+      throw std::invalid_argument(folly::sformat(
+          "Width and depth must be greater than 0. Width: {}, Depth: {}",
+          width, depth));
+    }
+    const auto requiredSize = computeStorageSize(width, depth);
+    const auto itemSize = layout_.viewWriteHandle()->getSize();
+    if (requiredSize > itemSize) {
+      throw std::invalid_argument(folly::sformat(
+          "Item size too small. Expected at least: {}, Actual: {}",
+          requiredSize, itemSize));
+    }
+    new (layout_.viewWriteHandle()->getMemory()) Layout(width, depth);
+  }
+
+  // CountMinTable can be moved but not copied
+  CountMinTable(CountMinTable&& rhs) = default;
+  CountMinTable& operator=(CountMinTable&& rhs) = default;
+
+  void increment(uint64_t key, Counter count = 1) {
+    layout_->increment(key, count);
+  }
+
+  // Increment all the keys of a range, without looking up the item per key
+  template <typename KeyRange>
+  void incrementBatch(const KeyRange& keys) {
+    auto& layout = *layout_;
+    for (uint64_t key : keys) {
+      layout.increment(key, 1);
+    }
+  }
+
+  Counter getCount(uint64_t key) const { return layout_->getCount(key); }
+
+  // Add the counts of the other table into this one
+  // @throw std::invalid_argument if the dimensions differ
+  void merge(const CountMinTable& other) { layout_->merge(*other.layout_); }
+
+  // Decays all counts by the given decay rate. count *= decay
+  void decayCountsBy(double decay) { layout_->decayCountsBy(decay); }
+
+  // Sets count for all keys to zero
+  void reset() { layout_->reset(); }
+
+  uint32_t width() const { return layout_->width(); }
+  uint32_t depth() const { return layout_->depth(); }
+
+  // This does not modify the content of this structure.
+  // It resets it to a write handle, which can be used with any API in
+  // CacheAllocator that deals with WriteHandle. After invoking this function,
+  // this structure is left in a null state.
+  WriteHandle resetToWriteHandle() && {
+    return std::move(layout_).resetToWriteHandle();
+  }
+
+  // Borrow the write handle underneath this structure. This is useful to
+  // implement insertion into CacheAllocator.
+  const WriteHandle& viewWriteHandle() const {
+    return layout_.viewWriteHandle();
+  }
+
+  bool isNullWriteHandle() const { return layout_ == nullptr; }
+
+ private:
+  LayoutHandle layout_;
+
+  explicit CountMinTable(WriteHandle handle) : layout_{std::move(handle)} {}
+};
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Format.h>
+#include <folly/lang/Bits.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "cachelib/allocator/TypedHandle.h"
+#include "cachelib/common/Hash.h"
+
+namespace facebook {
+namespace cachelib {
+
+namespace detail {
+// HyperLogLog registers stored directly in an item. One register per bucket
+// keeps the longest run of leading zeros seen among the hashes of the bucket.
+class HyperLogLogLayout {
+ public:
+  static constexpr uint8_t kMinPrecision = 4;
+  static constexpr uint8_t kMaxPrecision = 16;
+
+  static uint32_t computeStorageSize(uint8_t precision) {
+    return static_cast<uint32_t>(sizeof(HyperLogLogLayout)) +
+           (1u << precision);
+  }
+
+  // Construct a new layout with all registers cleared
+  explicit HyperLogLogLayout(uint8_t precision) : precision_{precision} {
+    clear();
+  }
+
+  uint8_t precision() const { return precision_; }
+
+  // Number of registers
+  uint32_t numRegisters() const { return 1u << precision_; }
+
+  // Add a hashed value. Return true if a register changed, i.e. the estimate
+  // may have changed.
+  bool addHash(uint64_t hash) {
+    const uint32_t index = static_cast<uint32_t>(hash >> (64 - precision_));
+    // leading zeros of the remaining bits plus one, capped when all of them
+    // are zero
+    const uint64_t rest = hash << precision_;
+    const uint8_t rank = static_cast<uint8_t>(
+        std::min<uint32_t>(64 - folly::findLastSet(rest), 64 - precision_) +
+        1);
+    if (registers_[index] >= rank) {
+      return false;
+    }
+    registers_[index] = rank;
+    return true;
+  }
+
+  // Estimated number of distinct values added
+  double estimate() const {
+    const double m = numRegisters();
+    double sum = 0;
+    uint32_t numZeros = 0;
+    for (uint32_t i = 0; i < numRegisters(); i++) {
+      sum += std::ldexp(1.0, -registers_[i]);
+      numZeros += registers_[i] == 0;
+    }
+    const double estimate = alpha() * m * m / sum;
+    // linear counting is more accurate while many registers are empty. With
+    // 64 bit hashes there is no need for a large range correction.
+    if (estimate <= 2.5 * m && numZeros != 0) {
+      return m * std::log(m / numZeros);
+    }
+    return estimate;
+  }
+
+  // Take the maximum of each register
+  // @throw std::invalid_argument if the precisions differ
+  void merge(const HyperLogLogLayout& other) {
+    if (precision_ != other.precision_) {
+      throw std::invalid_argument(
+          folly::sformat("Merging HyperLogLog of precision {} into {}",
+                         other.precision_, precision_));
+    }
+    for (uint32_t i = 0; i < numRegisters(); i++) {
+      registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+  }
+
+  void clear() { std::fill(registers_, registers_ + numRegisters(), 0); }
+
+ private:
+  double alpha() const {
+    switch (precision_) {
+    case 4:
+      return 0.673;
+    case 5:
+      return 0.697;
+    case 6:
+      return 0.709;
+    default:
+      return 0.7213 / (1 + 1.079 / numRegisters());
+    }
+  }
+
+  const uint8_t precision_;
+  uint8_t registers_[];
+};
+} // namespace detail
+
+// Estimates how many distinct keys were added, with a relative standard
+// error of 1.04 / sqrt(2^precision) for 2^precision bytes of item memory.
+//
+// @param C   this is an instance of CacheAllocator<> or provides
+//            the same functionality
+template <typename C>
+class HyperLogLog {
+ public:
+  using CacheType = C;
+  using Item = typename CacheType::Item;
+  using WriteHandle = typename Item::WriteHandle;
+
+  using Layout = detail::HyperLogLogLayout;
+  using LayoutHandle = TypedHandleImpl<Item, Layout>;
+
+  // Convert to a HyperLogLog from a WriteHandle
+  // This does not modify anything in the item
+  static HyperLogLog fromWriteHandle(WriteHandle handle) {
+    return HyperLogLog{std::move(handle)};
+  }
+
+  // Compute the storage required for 2^precision registers
+  static uint32_t computeStorageSize(uint8_t precision) {
+    return Layout::computeStorageSize(precision);
+  }
+
+  // Construct an empty HyperLogLog from a WriteHandle
+  // This modifies the item's memory
+  // @throw std::invalid_argument  if the precision is out of range or the
+  //                               item does not have enough memory
+  HyperLogLog(WriteHandle handle, uint8_t precision)
+      : layout_{std::move(handle)} {
+    if (precision < Layout::kMinPrecision ||
+        precision > Layout::kMaxPrecision) {
+      throw std::invalid_argument(
+          folly::sformat("Precision must be in [{}, {}]. Actual: {}",
+                         Layout::kMinPrecision, Layout::kMaxPrecision,
+                         precision));
+    }
+    const auto requiredSize = computeStorageSize(precision);
+    const auto itemSize = layout_.viewWriteHandle()->getSize();
+    if (requiredSize > itemSize) {
+      throw std::invalid_argument(folly::sformat(
+          "Item size too small. Expected at least: {}, Actual: {}",
+          requiredSize, itemSize));
+    }
+    new (layout_.viewWriteHandle()->getMemory()) Layout(precision);
+  }
+
+  // HyperLogLog can be moved but not copied
+  HyperLogLog(HyperLogLog&& rhs) = default;
+  HyperLogLog& operator=(HyperLogLog&& rhs) = default;
+
+  // Add a key. Return true if the estimate may have changed.
+  bool add(folly::StringPiece key) {
+    return layout_->addHash(HashedKey{key}.keyHash());
+  }
+
+  // Add a value that is already hashed with a good 64 bit hash
+  bool addHash(uint64_t hash) { return layout_->addHash(hash); }
+
+  // Add all the keys of a range, without looking up the item per key.
+  // Return the number of keys that changed a register.
+  template <typename KeyRange>
+  uint32_t addBatch(const KeyRange& keys) {
+    auto& layout = *layout_;
+    uint32_t numChanged = 0;
+    for (const auto& key : keys) {
+      numChanged += layout.addHash(HashedKey{key}.keyHash());
+    }
+    return numChanged;
+  }
+
+  // Estimated number of distinct keys added
+  double estimate() const { return layout_->estimate(); }
+
+  // Merge the other HyperLogLog into this one, estimating the union of both
+  // @throw std::invalid_argument if the precisions differ
+  void merge(const HyperLogLog& other) { layout_->merge(*other.layout_); }
+
+  // Remove all the keys
+  void clear() { layout_->clear(); }
+
+  uint8_t precision() const { return layout_->precision(); }
+
+  // This does not modify the content of this structure.
+  // It resets it to a write handle, which can be used with any API in
+  // CacheAllocator that deals with WriteHandle. After invoking this function,
+  // this structure is left in a null state.
+  WriteHandle resetToWriteHandle() && {
+    return std::move(layout_).resetToWriteHandle();
+  }
+
+  // Borrow the write handle underneath this structure. This is useful to
+  // implement insertion into CacheAllocator.
+  const WriteHandle& viewWriteHandle() const {
+    return layout_.viewWriteHandle();
+  }
+
+  bool isNullWriteHandle() const { return layout_ == nullptr; }
+
+ private:
+  LayoutHandle layout_;
+
+  explicit HyperLogLog(WriteHandle handle) : layout_{std::move(handle)} {}
+};
+} // namespace cachelib
+} // namespace facebook
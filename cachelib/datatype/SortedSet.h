@@ -0,0 +1,843 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/Optional.h>
+#include <folly/Range.h>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <vector>
+
+#include "cachelib/allocator/TypedHandle.h"
+#include "cachelib/common/Exceptions.h"
+#include "cachelib/common/Hash.h"
+#include "cachelib/common/Iterators.h"
+#include "cachelib/datatype/Buffer.h"
+#include "cachelib/datatype/DataTypes.h"
+#include "cachelib/datatype/Map.h"
+
+namespace facebook::cachelib {
+// Exception when cachelib::SortedSet's index has maxed out.
+class SortedSetIndexMaxedOut : public std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+namespace detail {
+// Link of a skip list node to the next node on one of its levels. The span
+// is the number of nodes between the two plus one. For the last node of a
+// level, it is the number of nodes after it.
+struct FOLLY_PACK_ATTR SkipListLink {
+  BufferAddr next{nullptr};
+  uint32_t span{0};
+};
+
+// A skip list node, followed by one link per level of the node
+template <typename Member, typename Score>
+struct FOLLY_PACK_ATTR SkipListNode {
+  Member member;
+  Score score;
+  uint8_t level;
+  SkipListLink links[];
+
+  static uint32_t computeStorageSize(uint8_t level) {
+    return static_cast<uint32_t>(sizeof(SkipListNode) +
+                                 level * sizeof(SkipListLink));
+  }
+};
+
+// Index of a sorted set, stored in the parent item: the head of the skip
+// list, followed by a hash table from the members to their nodes.
+template <typename Member>
+class FOLLY_PACK_ATTR SortedSetIndex {
+ public:
+  using HashTable = detail::HashTable<Member>;
+
+  // Highest level of a node. Each level holds a quarter of the nodes of the
+  // level below, which is plenty for the entries an index can hold.
+  static constexpr uint8_t kMaxLevel = 16;
+
+  static uint32_t computeStorageSize(uint32_t capacity) {
+    return static_cast<uint32_t>(sizeof(SortedSetIndex)) +
+           HashTable::computeStorageSize(capacity);
+  }
+
+  explicit SortedSetIndex(uint32_t capacity) {
+    new (&hashTable()) HashTable(capacity);
+  }
+
+  // @throw std::invalid_argument if capacity is smaller than "other"
+  SortedSetIndex(uint32_t capacity, const SortedSetIndex& other)
+      : level(other.level), length(other.length) {
+    std::copy(other.head, other.head + kMaxLevel, head);
+    new (&hashTable()) HashTable(capacity, other.hashTable());
+  }
+
+  HashTable& hashTable() { return *reinterpret_cast<HashTable*>(this + 1); }
+  const HashTable& hashTable() const {
+    return *reinterpret_cast<const HashTable*>(this + 1);
+  }
+
+  // number of levels in use
+  uint8_t level{1};
+  // number of nodes in the skip list
+  uint32_t length{0};
+  SkipListLink head[kMaxLevel]{};
+};
+
+// Iterates the nodes of a skip list in ascending order
+template <typename Node, typename BufManager>
+class SkipListIterator
+    : public IteratorFacade<SkipListIterator<Node, BufManager>,
+                            const Node,
+                            std::forward_iterator_tag> {
+ public:
+  SkipListIterator() = default;
+  SkipListIterator(const BufManager* manager, BufferAddr addr)
+      : manager_{manager}, addr_{addr} {}
+
+  const Node& dereference() const {
+    return *manager_->template get<const Node>(addr_);
+  }
+
+  void increment() {
+    XDCHECK(addr_ != nullptr);
+    addr_ = dereference().links[0].next;
+  }
+
+  bool equal(const SkipListIterator& other) const {
+    return addr_ == other.addr_;
+  }
+
+ private:
+  const BufManager* manager_{nullptr};
+  BufferAddr addr_{nullptr};
+};
+} // namespace detail
+
+// Sorted set data structure for cachelib, ordering unique members by score.
+// Like a sorted set in Redis, it suits leaderboards and time ordered feeds.
+//
+// Members are kept in a skip list whose nodes live in chained items, with a
+// hash table in the parent item to find the node of a member. Insert,
+// remove, score update, rank and range lookups are O(log N) and modify the
+// set in place: updating the score of a member relinks its node without any
+// allocation, and removed nodes are reclaimed by compacting the chained
+// items once enough bytes are wasted.
+//
+// Member and Score need to be fixed size PODs. Members are compared with
+// operator== and operator<, and scores with operator<. Members with equal
+// scores are ordered by member.
+template <typename M, typename S, typename C>
+class SortedSet {
+ public:
+  using EntryMember = M;
+  using EntryScore = S;
+  using Cache = C;
+  using Item = typename Cache::Item;
+  using WriteHandle = typename Item::WriteHandle;
+
+  // An entry of the set, with its "member" and its "score"
+  using Entry = detail::SkipListNode<EntryMember, EntryScore>;
+  using ConstItr =
+      detail::SkipListIterator<Entry, detail::BufferManager<Cache>>;
+
+  // Create a new cachelib::SortedSet
+  // @param cache   cache allocator to allocate from
+  // @param pid     pool where we'll allocate the set from
+  // @param key     key for the item in cache
+  // @param numEntries   number of entries this set can contain initially
+  // @param numBytes     number of bytes allocated for node storage initially
+  // @return  valid cachelib::SortedSet on success,
+  //          cachelib::SortedSet::isNullWriteHandle() == true on failure
+  static SortedSet create(Cache& cache,
+                          PoolId pid,
+                          typename Cache::Key key,
+                          uint32_t numEntries = kDefaultNumEntries,
+                          uint32_t numBytes = kDefaultNumBytes);
+
+  // Convert a write handle to a cachelib::SortedSet
+  // @param cache   cache allocator to allocate from
+  // @param handle  parent handle for this cachelib::SortedSet
+  // @return cachelib::SortedSet
+  static SortedSet fromWriteHandle(Cache& cache, WriteHandle handle);
+
+  // Constructs null cachelib sorted set
+  SortedSet() = default;
+
+  // Move constructor
+  SortedSet(SortedSet&& other);
+  SortedSet& operator=(SortedSet&& other);
+
+  // Copy is disallowed
+  SortedSet(const SortedSet& other) = delete;
+  SortedSet& operator=(const SortedSet& other) = delete;
+
+  // Insert a member with this score, or move an existing member to this
+  // score. Moving a member does not allocate.
+  // @throw std::bad_alloc if we can't allocate for a new member
+  //                       set is still in a valid state. User can re-try.
+  // @throw cachelib::SortedSetIndexMaxedOut if the set has reached its
+  //                                         maximum entry count.
+  enum InsertOrUpdateResult {
+    kInserted,
+    kUpdated,
+  };
+  InsertOrUpdateResult insertOrUpdate(const EntryMember& member,
+                                      const EntryScore& score);
+
+  // Remove member. False if not found. Calling remove invalidates all the
+  // iterators.
+  bool remove(const EntryMember& member);
+
+  // Return the score of the member. Nullptr if not found.
+  // The pointer is valid until the next mutation of the set.
+  const EntryScore* getScore(const EntryMember& member) const;
+
+  // Return the position of the member in ascending score order, starting
+  // at 0. None if not found.
+  folly::Optional<uint32_t> getRank(const EntryMember& member) const;
+
+  // Return an iterator to the entry at this rank. end() if out of range.
+  ConstItr atRank(uint32_t rank) const;
+
+  // Return the entries with a rank in [start, stop). Clipped to the set.
+  folly::Range<ConstItr> rangeByRank(uint32_t start, uint32_t stop) const;
+
+  // Return the entries with a score in [min, max]. Empty if none.
+  folly::Range<ConstItr> rangeByScore(const EntryScore& min,
+                                      const EntryScore& max) const;
+
+  // Iterate through the set in ascending score order
+  ConstItr begin() const;
+  ConstItr end() const;
+
+  // Compact storage to make more room for allocations
+  // Cost: O(N*LOG(N)). Compacting storage is O(N) where N is number of
+  //       entries. Relinking the skip list needs the entries sorted.
+  //
+  // @throw std::runtime_error if unrecoverable error is encountered.
+  //                           this indicates a bug in our code.
+  //                           Set is no longer in a usable state. User
+  //                           should delete the whole set by its key from
+  //                           cache.
+  void compact();
+
+  // Return number of bytes this set is using for the index and the buffers
+  // This doesn't include cachelib item overhead
+  size_t sizeInBytes() const;
+
+  // Return bytes left unused (can be used for future entries)
+  size_t remainingBytes() const { return bufferManager_.remainingBytes(); }
+
+  // Returns bytes left behind by removed entries
+  size_t wastedBytes() const { return bufferManager_.wastedBytes(); }
+
+  // Return number of elements in this set
+  uint32_t size() const { return index()->length; }
+
+  // This does not modify the content of this structure.
+  // It resets it to a write handle, which can be used with any API in
+  // CacheAllocator that deals with ReadHandle/WriteHandle. After invoking this
+  // function, this structure is left in a null state.
+  WriteHandle resetToWriteHandle() && { return std::move(handle_); }
+
+  // Borrow the write handle underneath this structure. This is useful to
+  // implement insertion into CacheAllocator.
+  const WriteHandle& viewWriteHandle() const { return handle_; }
+  WriteHandle& viewWriteHandle() { return handle_; }
+
+  bool isNullWriteHandle() const { return handle_ == nullptr; }
+
+ private:
+  using Index = detail::SortedSetIndex<EntryMember>;
+  using BufferManager = detail::BufferManager<Cache>;
+  using Link = detail::SkipListLink;
+  using BufferAddr = detail::BufferAddr;
+  using Path = std::array<BufferAddr, Index::kMaxLevel>;
+  using PathRanks = std::array<uint32_t, Index::kMaxLevel>;
+
+  static constexpr int kWastedBytesPctThreshold = 50;
+  static constexpr uint32_t kDefaultNumEntries = 20;
+  static constexpr uint32_t kDefaultNumBytes = kDefaultNumEntries * 32;
+
+  // Create a new cachelib::SortedSet
+  // @throw std::bad_alloc if fail to allocate index or storage for a set
+  SortedSet(Cache& cache,
+            PoolId pid,
+            typename Cache::Key key,
+            uint32_t numEntries,
+            uint32_t numBytes);
+
+  // Attach to an existing cachelib::SortedSet
+  SortedSet(Cache& cache, WriteHandle handle);
+
+  Index* index() { return handle_->template getMemoryAs<Index>(); }
+  const Index* index() const {
+    return handle_->template getMemoryAs<const Index>();
+  }
+
+  Entry* getNode(BufferAddr addr) const {
+    return bufferManager_.template get<Entry>(addr);
+  }
+
+  // links of a node, or of the head for a null address
+  Link* getLinks(BufferAddr addr) {
+    return addr ? getNode(addr)->links : index()->head;
+  }
+  const Link* getLinks(BufferAddr addr) const {
+    return addr ? getNode(addr)->links : index()->head;
+  }
+
+  // level of a member's node, derived from its hash so that each level
+  // holds a quarter of the nodes of the level below
+  static uint8_t getNodeLevel(const EntryMember& member);
+
+  // @return true if the node orders before {score, member}
+  static bool isBefore(const Entry& node,
+                       const EntryScore& score,
+                       const EntryMember& member);
+
+  // Find the last node of each level that orders before {score, member},
+  // and their rank.
+  void findPath(const EntryScore& score,
+                const EntryMember& member,
+                Path& path,
+                PathRanks& ranks) const;
+
+  // link the node at its position in the skip list
+  void link(BufferAddr addr);
+
+  // unlink the node from the skip list, without freeing it
+  void unlink(BufferAddr addr);
+
+  // @return address of the last node with a score below the bound, or with
+  //         a score not above it if inclusive. Nullptr for the head.
+  BufferAddr findLastBelow(const EntryScore& bound, bool inclusive) const;
+
+  // allocate a node for a new member, expanding the index or the storage if
+  // there isn't enough room
+  // @throw std::bad_alloc if we can't allocate
+  BufferAddr allocateNode(const EntryMember& member, const EntryScore& score);
+
+  // Move the set to a new parent item whose index can hold this many
+  // entries. The buffers are cloned so that a user holding a handle to the
+  // old parent can still access the old set.
+  // @return false if we can't allocate
+  bool cloneIndex(uint32_t capacity);
+
+  Cache* cache_{nullptr};
+  WriteHandle handle_;
+  BufferManager bufferManager_{nullptr};
+};
+
+template <typename M, typename S, typename C>
+SortedSet<M, S, C> SortedSet<M, S, C>::create(Cache& cache,
+                                              PoolId pid,
+                                              typename Cache::Key key,
+                                              uint32_t numEntries,
+                                              uint32_t numBytes) {
+  try {
+    return SortedSet{cache, pid, key, numEntries, numBytes};
+  } catch (const std::bad_alloc&) {
+    return {};
+  }
+}
+
+template <typename M, typename S, typename C>
+SortedSet<M, S, C> SortedSet<M, S, C>::fromWriteHandle(Cache& cache,
+                                                       WriteHandle handle) {
+  if (!handle) {
+    return {};
+  }
+  return SortedSet{cache, std::move(handle)};
+}
+
+template <typename M, typename S, typename C>
+SortedSet<M, S, C>::SortedSet(Cache& cache,
+                              PoolId pid,
+                              typename Cache::Key key,
+                              uint32_t numEntries,
+                              uint32_t numBytes)
+    : cache_{&cache},
+      handle_{
+          cache_->allocate(pid, key, Index::computeStorageSize(numEntries))} {
+  if (!handle_) {
+    throw cachelib::exception::OutOfMemory(
+        folly::sformat("Failed allocate index for sorted set. Key: {}, "
+                       "numEntries: {}, numBytes: {}",
+                       key, numEntries, numBytes));
+  }
+
+  new (handle_->getMemory()) Index(numEntries);
+  bufferManager_ = BufferManager{*cache_, handle_, numBytes};
+}
+
+template <typename M, typename S, typename C>
+SortedSet<M, S, C>::SortedSet(Cache& cache, WriteHandle handle)
+    : cache_{&cache},
+      handle_{std::move(handle)},
+      bufferManager_{*cache_, handle_} {}
+
+template <typename M, typename S, typename C>
+SortedSet<M, S, C>::SortedSet(SortedSet&& other)
+    : cache_(other.cache_),
+      handle_(std::move(other.handle_)),
+      bufferManager_(*cache_, handle_) {}
+
+template <typename M, typename S, typename C>
+SortedSet<M, S, C>& SortedSet<M, S, C>::operator=(SortedSet&& other) {
+  if (this != &other) {
+    this->~SortedSet();
+    new (this) SortedSet(std::move(other));
+  }
+  return *this;
+}
+
+template <typename M, typename S, typename C>
+uint8_t SortedSet<M, S, C>::getNodeLevel(const EntryMember& member) {
+  uint32_t hash = MurmurHash2{}(&member, sizeof(EntryMember));
+  uint8_t level = 1;
+  while (level < Index::kMaxLevel && (hash & 3) == 0) {
+    ++level;
+    hash >>= 2;
+  }
+  return level;
+}
+
+template <typename M, typename S, typename C>
+bool SortedSet<M, S, C>::isBefore(const Entry& node,
+                                  const EntryScore& score,
+                                  const EntryMember& member) {
+  // copy out of the packed node to compare
+  const EntryScore nodeScore = node.score;
+  if (nodeScore < score) {
+    return true;
+  }
+  if (score < nodeScore) {
+    return false;
+  }
+  const EntryMember nodeMember = node.member;
+  return nodeMember < member;
+}
+
+template <typename M, typename S, typename C>
+void SortedSet<M, S, C>::findPath(const EntryScore& score,
+                                  const EntryMember& member,
+                                  Path& path,
+                                  PathRanks& ranks) const {
+  const auto* idx = index();
+  BufferAddr curr = nullptr;
+  uint32_t rank = 0;
+  for (int i = idx->level - 1; i >= 0; i--) {
+    while (true) {
+      const auto& next = getLinks(curr)[i];
+      if (!next.next || !isBefore(*getNode(next.next), score, member)) {
+        break;
+      }
+      rank += next.span;
+      curr = next.next;
+    }
+    path[i] = curr;
+    ranks[i] = rank;
+  }
+}
+
+template <typename M, typename S, typename C>
+void SortedSet<M, S, C>::link(BufferAddr addr) {
+  auto* node = getNode(addr);
+  const EntryScore score = node->score;
+  const EntryMember member = node->member;
+
+  Path path;
+  PathRanks ranks;
+  findPath(score, member, path, ranks);
+
+  auto* idx = index();
+  const uint8_t level = node->level;
+  if (level > idx->level) {
+    for (uint8_t i = idx->level; i < level; i++) {
+      path[i] = nullptr;
+      ranks[i] = 0;
+      idx->head[i].span = idx->length;
+    }
+    idx->level = level;
+  }
+
+  for (uint8_t i = 0; i < level; i++) {
+    auto& prev = getLinks(path[i])[i];
+    node->links[i].next = prev.next;
+    node->links[i].span = prev.span - (ranks[0] - ranks[i]);
+    prev.next = addr;
+    prev.span = ranks[0] - ranks[i] + 1;
+  }
+  // the levels above the node now skip over it
+  for (uint8_t i = level; i < idx->level; i++) {
+    getLinks(path[i])[i].span++;
+  }
+  idx->length++;
+}
+
+template <typename M, typename S, typename C>
+void SortedSet<M, S, C>::unlink(BufferAddr addr) {
+  const auto* node = getNode(addr);
+  const EntryScore score = node->score;
+  const EntryMember member = node->member;
+
+  Path path;
+  PathRanks ranks;
+  findPath(score, member, path, ranks);
+
+  auto* idx = index();
+  for (uint8_t i = 0; i < idx->level; i++) {
+    auto& prev = getLinks(path[i])[i];
+    if (prev.next == addr) {
+      prev.span += node->links[i].span - 1;
+      prev.next = node->links[i].next;
+    } else {
+      prev.span--;
+    }
+  }
+  while (idx->level > 1 && !idx->head[idx->level - 1].next) {
+    idx->level--;
+  }
+  idx->length--;
+}
+
+template <typename M, typename S, typename C>
+typename SortedSet<M, S, C>::InsertOrUpdateResult
+SortedSet<M, S, C>::insertOrUpdate(const EntryMember& member,
+                                   const EntryScore& score) {
+  if (const auto* entry = index()->hashTable().find(member)) {
+    const BufferAddr addr = entry->addr;
+    auto* node = getNode(addr);
+    const EntryScore oldScore = node->score;
+    if (!(oldScore < score) && !(score < oldScore)) {
+      return kUpdated;
+    }
+    unlink(addr);
+    std::memcpy(&node->score, &score, sizeof(EntryScore));
+    link(addr);
+    return kUpdated;
+  }
+
+  const auto addr = allocateNode(member, score);
+  try {
+    index()->hashTable().insertOrReplace(member, addr);
+  } catch (const std::bad_alloc&) {
+    bufferManager_.remove(addr);
+    throw;
+  }
+  link(addr);
+  return kInserted;
+}
+
+template <typename M, typename S, typename C>
+bool SortedSet<M, S, C>::remove(const EntryMember& member) {
+  const auto* entry = index()->hashTable().find(member);
+  if (!entry) {
+    return false;
+  }
+  const BufferAddr addr = entry->addr;
+  unlink(addr);
+  index()->hashTable().remove(member);
+  bufferManager_.remove(addr);
+
+  if (bufferManager_.wastedBytesPct() > kWastedBytesPctThreshold) {
+    compact();
+  }
+  return true;
+}
+
+template <typename M, typename S, typename C>
+const typename SortedSet<M, S, C>::EntryScore* SortedSet<M, S, C>::getScore(
+    const EntryMember& member) const {
+  const auto* entry = index()->hashTable().find(member);
+  if (!entry) {
+    return nullptr;
+  }
+  return &getNode(entry->addr)->score;
+}
+
+template <typename M, typename S, typename C>
+folly::Optional<uint32_t> SortedSet<M, S, C>::getRank(
+    const EntryMember& member) const {
+  const auto* entry = index()->hashTable().find(member);
+  if (!entry) {
+    return folly::none;
+  }
+  const BufferAddr addr = entry->addr;
+  const EntryScore score = getNode(addr)->score;
+
+  // walk to the last node that does not order after the member, which is
+  // the member's node
+  BufferAddr curr = nullptr;
+  uint32_t rank = 0;
+  for (int i = index()->level - 1; i >= 0; i--) {
+    while (true) {
+      const auto& next = getLinks(curr)[i];
+      if (!next.next || (next.next != addr &&
+                         !isBefore(*getNode(next.next), score, member))) {
+        break;
+      }
+      rank += next.span;
+      curr = next.next;
+      if (curr == addr) {
+        return rank - 1;
+      }
+    }
+  }
+  throw std::runtime_error(folly::sformat(
+      "member is in the index but not in the skip list. rank: {}", rank));
+}
+
+template <typename M, typename S, typename C>
+typename SortedSet<M, S, C>::ConstItr SortedSet<M, S, C>::atRank(
+    uint32_t rank) const {
+  const auto* idx = index();
+  if (rank >= idx->length) {
+    return end();
+  }
+
+  const uint32_t target = rank + 1;
+  BufferAddr curr = nullptr;
+  uint32_t traversed = 0;
+  for (int i = idx->level - 1; i >= 0; i--) {
+    while (true) {
+      const auto& next = getLinks(curr)[i];
+      if (!next.next || traversed + next.span > target) {
+        break;
+      }
+      traversed += next.span;
+      curr = next.next;
+    }
+    if (traversed == target) {
+      return ConstItr{&bufferManager_, curr};
+    }
+  }
+  throw std::runtime_error(folly::sformat(
+      "rank {} is below the length {} but not found", rank, idx->length));
+}
+
+template <typename M, typename S, typename C>
+folly::Range<typename SortedSet<M, S, C>::ConstItr>
+SortedSet<M, S, C>::rangeByRank(uint32_t start, uint32_t stop) const {
+  stop = std::min(stop, size());
+  if (start >= stop) {
+    return {end(), end()};
+  }
+  return {atRank(start), atRank(stop)};
+}
+
+template <typename M, typename S, typename C>
+typename SortedSet<M, S, C>::BufferAddr SortedSet<M, S, C>::findLastBelow(
+    const EntryScore& bound, bool inclusive) const {
+  BufferAddr curr = nullptr;
+  for (int i = index()->level - 1; i >= 0; i--) {
+    while (true) {
+      const auto& next = getLinks(curr)[i];
+      if (!next.next) {
+        break;
+      }
+      const EntryScore score = getNode(next.next)->score;
+      if (inclusive ? bound < score : !(score < bound)) {
+        break;
+      }
+      curr = next.next;
+    }
+  }
+  return curr;
+}
+
+template <typename M, typename S, typename C>
+folly::Range<typename SortedSet<M, S, C>::ConstItr>
+SortedSet<M, S, C>::rangeByScore(const EntryScore& min,
+                                 const EntryScore& max) const {
+  if (max < min) {
+    return {end(), end()};
+  }
+  const auto first = getLinks(findLastBelow(min, false))[0].next;
+  const auto last = getLinks(findLastBelow(max, true))[0].next;
+  return {ConstItr{&bufferManager_, first}, ConstItr{&bufferManager_, last}};
+}
+
+template <typename M, typename S, typename C>
+typename SortedSet<M, S, C>::ConstItr SortedSet<M, S, C>::begin() const {
+  return ConstItr{&bufferManager_, index()->head[0].next};
+}
+
+template <typename M, typename S, typename C>
+typename SortedSet<M, S, C>::ConstItr SortedSet<M, S, C>::end() const {
+  return ConstItr{&bufferManager_, nullptr};
+}
+
+template <typename M, typename S, typename C>
+void SortedSet<M, S, C>::compact() {
+  // The idea below is first we compact all allocations in buffer manager,
+  // which moves the nodes. Afterwards, we point the hash table at the new
+  // address of each node and relink the skip list in order.
+  bufferManager_.compact();
+
+  auto* idx = index();
+  std::vector<BufferAddr> nodes;
+  nodes.reserve(idx->length);
+  using NodeItr = detail::BufferManagerIterator<Entry, BufferManager>;
+  for (auto itr = NodeItr{bufferManager_},
+            endItr = NodeItr{bufferManager_, NodeItr::End};
+       itr != endItr; ++itr) {
+    const EntryMember member = itr->member;
+    auto* entry = const_cast<typename Index::HashTable::Entry*>(
+        idx->hashTable().find(member));
+    if (!entry) {
+      throw std::runtime_error(
+          "old entry is missing, this should never happen");
+    }
+    entry->addr = itr.getAsBufferAddr();
+    nodes.push_back(entry->addr);
+  }
+  if (nodes.size() != idx->length) {
+    throw std::runtime_error(
+        folly::sformat("{} nodes found for a sorted set of length {}",
+                       nodes.size(), idx->length));
+  }
+
+  std::sort(nodes.begin(), nodes.end(), [this](auto a, auto b) {
+    const auto* nodeB = getNode(b);
+    const EntryScore score = nodeB->score;
+    const EntryMember member = nodeB->member;
+    return isBefore(*getNode(a), score, member);
+  });
+
+  Path last;
+  last.fill(nullptr);
+  PathRanks lastRanks{};
+  uint8_t level = 1;
+  for (uint32_t rank = 1; rank <= nodes.size(); rank++) {
+    const auto addr = nodes[rank - 1];
+    const uint8_t nodeLevel = getNode(addr)->level;
+    level = std::max(level, nodeLevel);
+    for (uint8_t i = 0; i < nodeLevel; i++) {
+      auto& prev = getLinks(last[i])[i];
+      prev.next = addr;
+      prev.span = rank - lastRanks[i];
+      last[i] = addr;
+      lastRanks[i] = rank;
+    }
+  }
+  const auto length = static_cast<uint32_t>(nodes.size());
+  for (uint8_t i = 0; i < Index::kMaxLevel; i++) {
+    auto& tail = getLinks(last[i])[i];
+    tail.next = nullptr;
+    tail.span = i < level ? length - lastRanks[i] : 0;
+  }
+  idx->level = level;
+}
+
+template <typename M, typename S, typename C>
+size_t SortedSet<M, S, C>::sizeInBytes() const {
+  size_t numBytes = handle_->getSize();
+  auto allocs = cache_->viewAsChainedAllocs(handle_);
+  for (const auto& c : allocs.getChain()) {
+    numBytes += c.getSize();
+  }
+  return numBytes;
+}
+
+template <typename M, typename S, typename C>
+typename SortedSet<M, S, C>::BufferAddr SortedSet<M, S, C>::allocateNode(
+    const EntryMember& member, const EntryScore& score) {
+  constexpr uint32_t kExpansionFactor = 2;
+  bool chainCloned = false;
+  const auto accessible = handle_->isAccessible();
+  // We try to expand the index if it's full, if we can't do it we have to
+  // abort this insert because we may not be able to insert
+  if (index()->hashTable().overLimit()) {
+    if (!cloneIndex(index()->hashTable().capacity() * kExpansionFactor)) {
+      throw std::bad_alloc();
+    }
+    chainCloned = true;
+  }
+
+  // If wasted space is more than threshold, trigger compaction
+  if (bufferManager_.wastedBytesPct() > kWastedBytesPctThreshold) {
+    compact();
+  }
+
+  const uint8_t level = getNodeLevel(member);
+  const uint32_t allocSize = Entry::computeStorageSize(level);
+  auto addr = bufferManager_.allocate(allocSize);
+  if (!addr) {
+    // Clone the buffers, if we have not already done that in this insert,
+    // so that if a user holds an old handle to the set, that handle will
+    // still allow the user to access the old set.
+    if (!chainCloned) {
+      if (!cloneIndex(index()->hashTable().capacity())) {
+        throw std::bad_alloc();
+      }
+      chainCloned = true;
+    }
+    if (bufferManager_.expand(allocSize)) {
+      addr = bufferManager_.allocate(allocSize);
+    }
+  }
+  if (chainCloned && accessible) {
+    cache_->insertOrReplace(handle_);
+  }
+  if (!addr) {
+    throw std::bad_alloc();
+  }
+
+  auto* node = getNode(addr);
+  std::memset(node, 0, allocSize);
+  std::memcpy(&node->member, &member, sizeof(EntryMember));
+  std::memcpy(&node->score, &score, sizeof(EntryScore));
+  node->level = level;
+  return addr;
+}
+
+template <typename M, typename S, typename C>
+bool SortedSet<M, S, C>::cloneIndex(uint32_t capacity) {
+  // Maximum size for an item
+  // TODO: This is just under 1MB to allow some room for the item header.
+  const auto newSize = Index::computeStorageSize(capacity);
+  const size_t kMaxIndexSize = 1024 * 1024 - Index::computeStorageSize(0) -
+                               Item::getRequiredSize(handle_->getKey(), 0);
+  if (newSize > kMaxIndexSize) {
+    throw SortedSetIndexMaxedOut(folly::sformat(
+        "Index has maxed out for the provided key. Existing entries: {}, New "
+        "requested capacity: {}. New requested size: {}",
+        size(), capacity, newSize));
+  }
+
+  const auto pid = cache_->getAllocInfo(handle_->getMemory()).poolId;
+  auto newHandle = cache_->allocate(pid, handle_->getKey(), newSize);
+  if (!newHandle) {
+    return false;
+  }
+  new (newHandle->getMemory()) Index(capacity, *index());
+
+  auto newBufferManager = bufferManager_.clone(newHandle);
+  if (newBufferManager.empty()) {
+    return false;
+  }
+
+  handle_ = std::move(newHandle);
+  bufferManager_ = BufferManager{*cache_, handle_};
+  return true;
+}
+} // namespace facebook::cachelib
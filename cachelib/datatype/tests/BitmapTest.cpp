@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Random.h>
+
+#include <set>
+#include <vector>
+
+#include "cachelib/allocator/tests/TestBase.h"
+#include "cachelib/datatype/Bitmap.h"
+#include "cachelib/datatype/tests/DataTypeTest.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+namespace {
+using BitmapT = Bitmap<LruAllocator>;
+
+void checkBitmap(const BitmapT& bitmap, const std::set<uint32_t>& expected) {
+  EXPECT_EQ(expected.size(), bitmap.count());
+  for (uint32_t i = 0; i < bitmap.numBits(); i++) {
+    ASSERT_EQ(expected.count(i) == 1, bitmap.test(i));
+  }
+}
+} // namespace
+
+TEST(Bitmap, Basic) {
+  auto cache = DataTypeTest::createCache<LruAllocator>();
+  {
+    auto bitmap =
+        DataTypeTest::createFixedSize<BitmapT>(*cache, "bitmap", 1000);
+    ASSERT_FALSE(bitmap.isNullWriteHandle());
+    EXPECT_EQ(0, bitmap.count());
+    EXPECT_TRUE(bitmap.set(10));
+    EXPECT_FALSE(bitmap.set(10));
+    EXPECT_TRUE(bitmap.set(999));
+    EXPECT_EQ(1, bitmap.setBatch(std::vector<uint32_t>{10, 500}));
+    cache->insertOrReplace(bitmap.viewWriteHandle());
+  }
+
+  auto bitmap = BitmapT::fromWriteHandle(cache->findToWrite("bitmap"));
+  ASSERT_FALSE(bitmap.isNullWriteHandle());
+  EXPECT_EQ(1000, bitmap.numBits());
+  checkBitmap(bitmap, {10, 500, 999});
+
+  EXPECT_TRUE(bitmap.reset(500));
+  EXPECT_FALSE(bitmap.reset(500));
+  checkBitmap(bitmap, {10, 999});
+
+  EXPECT_THROW(bitmap.set(1000), std::out_of_range);
+  EXPECT_THROW(bitmap.test(1000), std::out_of_range);
+
+  bitmap.clear();
+  checkBitmap(bitmap, {});
+}
+
+TEST(Bitmap, InvalidArguments) {
+  auto cache = DataTypeTest::createCache<LruAllocator>();
+  const auto pid = cache->getPoolId(DataTypeTest::kDefaultPool);
+  EXPECT_THROW(
+      BitmapT(cache->allocate(pid, "bitmap", BitmapT::computeStorageSize(64)),
+              65),
+      std::invalid_argument);
+
+  auto bitmap = DataTypeTest::createFixedSize<BitmapT>(*cache, "bitmap", 100);
+  auto other = DataTypeTest::createFixedSize<BitmapT>(*cache, "other", 200);
+  EXPECT_THROW(bitmap.merge(other), std::invalid_argument);
+  EXPECT_THROW(bitmap.intersect(other), std::invalid_argument);
+}
+
+TEST(Bitmap, MergeAndIntersect) {
+  auto cache = DataTypeTest::createCache<LruAllocator>();
+  // several chunks, the last one partial, with the second bitmap only
+  // using the first chunks
+  const uint32_t numBits = 300'000;
+  auto bitmap =
+      DataTypeTest::createFixedSize<BitmapT>(*cache, "bitmap", numBits);
+  auto other = DataTypeTest::createFixedSize<BitmapT>(*cache, "other", numBits);
+
+  std::set<uint32_t> bits;
+  std::set<uint32_t> otherBits;
+  for (int i = 0; i < 10'000; i++) {
+    bits.insert(folly::Random::rand32(numBits));
+    otherBits.insert(folly::Random::rand32(100'000));
+  }
+  bitmap.setBatch(bits);
+  other.setBatch(otherBits);
+
+  auto merged =
+      DataTypeTest::createFixedSize<BitmapT>(*cache, "merged", numBits);
+  merged.merge(bitmap);
+  merged.merge(other);
+  std::set<uint32_t> expected = bits;
+  expected.insert(otherBits.begin(), otherBits.end());
+  checkBitmap(merged, expected);
+
+  bitmap.intersect(other);
+  expected.clear();
+  for (auto bit : bits) {
+    if (otherBits.count(bit)) {
+      expected.insert(bit);
+    }
+  }
+  checkBitmap(bitmap, expected);
+}
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vector>
+
+#include "cachelib/allocator/tests/TestBase.h"
+#include "cachelib/datatype/CountMinTable.h"
+#include "cachelib/datatype/tests/DataTypeTest.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+namespace {
+using Table = CountMinTable<uint32_t, LruAllocator>;
+using Table8 = CountMinTable<uint8_t, LruAllocator>;
+} // namespace
+
+TEST(CountMinTable, Basic) {
+  auto cache = DataTypeTest::createCache<LruAllocator>();
+  {
+    auto table = DataTypeTest::createFixedSize<Table>(*cache, "cms", 1000, 4);
+    ASSERT_FALSE(table.isNullWriteHandle());
+    EXPECT_EQ(1000, table.width());
+    EXPECT_EQ(4, table.depth());
+    table.increment(1);
+    table.increment(2, 10);
+    table.incrementBatch(std::vector<uint64_t>{1, 1, 3});
+    cache->insertOrReplace(table.viewWriteHandle());
+  }
+
+  auto table = Table::fromWriteHandle(cache->findToWrite("cms"));
+  ASSERT_FALSE(table.isNullWriteHandle());
+  EXPECT_EQ(3, table.getCount(1));
+  EXPECT_EQ(10, table.getCount(2));
+  EXPECT_EQ(1, table.getCount(3));
+  EXPECT_EQ(0, table.getCount(4));
+
+  table.decayCountsBy(0.5);
+  EXPECT_EQ(1, table.getCount(1));
+  EXPECT_EQ(5, table.getCount(2));
+
+  table.reset();
+  EXPECT_EQ(0, table.getCount(2));
+}
+
+TEST(CountMinTable, InvalidArguments) {
+  auto cache = DataTypeTest::createCache<LruAllocator>();
+  const auto pid = cache->getPoolId(DataTypeTest::kDefaultPool);
+  EXPECT_THROW(DataTypeTest::createFixedSize<Table>(*cache, "cms", 0, 4),
+               std::invalid_argument);
+  EXPECT_THROW(DataTypeTest::createFixedSize<Table>(*cache, "cms", 10, 0),
+               std::invalid_argument);
+  EXPECT_THROW(
+      Table(cache->allocate(pid, "cms", Table::computeStorageSize(10, 4)), 10,
+            5),
+      std::invalid_argument);
+
+  auto table = DataTypeTest::createFixedSize<Table>(*cache, "cms", 10, 4);
+  auto other = DataTypeTest::createFixedSize<Table>(*cache, "other", 20, 4);
+  EXPECT_THROW(table.merge(other), std::invalid_argument);
+}
+
+TEST(CountMinTable, NeverUndercounts) {
+  auto cache = DataTypeTest::createCache<LruAllocator>();
+  auto table = DataTypeTest::createFixedSize<Table>(*cache, "cms", 100, 3);
+  std::vector<uint32_t> counts(1000);
+  for (uint64_t key = 0; key < counts.size(); key++) {
+    counts[key] = static_cast<uint32_t>(key % 7);
+    table.increment(key, counts[key]);
+  }
+  for (uint64_t key = 0; key < counts.size(); key++) {
+    EXPECT_GE(table.getCount(key), counts[key]);
+  }
+}
+
+TEST(CountMinTable, Merge) {
+  auto cache = DataTypeTest::createCache<LruAllocator>();
+  auto table = DataTypeTest::createFixedSize<Table8>(*cache, "cms", 100, 4);
+  auto other = DataTypeTest::createFixedSize<Table8>(*cache, "other", 100, 4);
+  table.increment(1, 10);
+  other.increment(1, 5);
+  other.increment(2, 200);
+  table.merge(other);
+  EXPECT_EQ(15, table.getCount(1));
+  EXPECT_EQ(200, table.getCount(2));
+
+  // counters saturate instead of wrapping around
+  table.merge(other);
+  EXPECT_EQ(255, table.getCount(2));
+  table.increment(2);
+  EXPECT_EQ(255, table.getCount(2));
+}
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
@@ -38,6 +38,20 @@ struct DataTypeTest {
     cache->addPool(kDefaultPool, numBytes);
     return cache;
   }
+
+  // Allocates an item from the default pool sized for a fixed size data type
+  // and constructs an empty one in it
+  // @param args  the dimensions of the data type, as passed to its
+  //              computeStorageSize()
+  template <typename DataType, typename AllocatorT, typename... Args>
+  static DataType createFixedSize(AllocatorT& cache,
+                                  folly::StringPiece key,
+                                  Args... args) {
+    const auto pid = cache.getPoolId(kDefaultPool);
+    return DataType(
+        cache.allocate(pid, key, DataType::computeStorageSize(args...)),
+        args...);
+  }
 };
 } // namespace tests
 } // namespace cachelib
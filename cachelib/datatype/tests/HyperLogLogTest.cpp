@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Format.h>
+
+#include <cmath>
+#include <vector>
+
+#include "cachelib/allocator/tests/TestBase.h"
+#include "cachelib/datatype/HyperLogLog.h"
+#include "cachelib/datatype/tests/DataTypeTest.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+namespace {
+using HLL = HyperLogLog<LruAllocator>;
+} // namespace
+
+TEST(HyperLogLog, Basic) {
+  auto cache = DataTypeTest::createCache<LruAllocator>();
+  {
+    auto hll = DataTypeTest::createFixedSize<HLL>(*cache, "hll", 12);
+    ASSERT_FALSE(hll.isNullWriteHandle());
+    EXPECT_EQ(0, hll.estimate());
+    EXPECT_TRUE(hll.add("key"));
+    // adding the same key again changes nothing
+    EXPECT_FALSE(hll.add("key"));
+    EXPECT_NEAR(1, hll.estimate(), 0.01);
+    cache->insertOrReplace(hll.viewWriteHandle());
+  }
+
+  // the registers are read in place from the cached item
+  auto hll = HLL::fromWriteHandle(cache->findToWrite("hll"));
+  ASSERT_FALSE(hll.isNullWriteHandle());
+  EXPECT_EQ(12, hll.precision());
+  EXPECT_NEAR(1, hll.estimate(), 0.01);
+
+  hll.clear();
+  EXPECT_EQ(0, hll.estimate());
+}
+
+TEST(HyperLogLog, InvalidArguments) {
+  auto cache = DataTypeTest::createCache<LruAllocator>();
+  const auto pid = cache->getPoolId(DataTypeTest::kDefaultPool);
+  EXPECT_THROW(DataTypeTest::createFixedSize<HLL>(*cache, "hll", 3),
+               std::invalid_argument);
+  EXPECT_THROW(DataTypeTest::createFixedSize<HLL>(*cache, "hll", 17),
+               std::invalid_argument);
+  EXPECT_THROW(
+      HLL(cache->allocate(pid, "hll", HLL::computeStorageSize(10)), 11),
+      std::invalid_argument);
+
+  auto hll = DataTypeTest::createFixedSize<HLL>(*cache, "hll", 10);
+  auto other = DataTypeTest::createFixedSize<HLL>(*cache, "other", 11);
+  EXPECT_THROW(hll.merge(other), std::invalid_argument);
+}
+
+TEST(HyperLogLog, Estimate) {
+  auto cache = DataTypeTest::createCache<LruAllocator>();
+  for (uint32_t numKeys : {100, 10'000, 1'000'000}) {
+    auto hll = DataTypeTest::createFixedSize<HLL>(*cache, "hll", 14);
+    std::vector<std::string> keys;
+    for (uint32_t i = 0; i < numKeys; i++) {
+      keys.push_back(folly::sformat("key_{}", i));
+    }
+    EXPECT_GT(hll.addBatch(keys), 0);
+    // 0.8% standard error for 2^14 registers
+    EXPECT_NEAR(numKeys, hll.estimate(), numKeys * 0.04);
+  }
+}
+
+TEST(HyperLogLog, Merge) {
+  auto cache = DataTypeTest::createCache<LruAllocator>();
+  auto hll = DataTypeTest::createFixedSize<HLL>(*cache, "hll", 12);
+  auto other = DataTypeTest::createFixedSize<HLL>(*cache, "other", 12);
+  for (int i = 0; i < 10'000; i++) {
+    hll.add(folly::sformat("key_{}", i));
+    other.add(folly::sformat("key_{}", i + 5'000));
+  }
+  hll.merge(other);
+  // 1.6% standard error for 2^12 registers
+  EXPECT_NEAR(15'000, hll.estimate(), 15'000 * 0.08);
+
+  // merging is idempotent
+  const auto estimate = hll.estimate();
+  hll.merge(other);
+  EXPECT_EQ(estimate, hll.estimate());
+}
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Random.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+#include "cachelib/allocator/tests/TestBase.h"
+#include "cachelib/datatype/SortedSet.h"
+#include "cachelib/datatype/tests/DataTypeTest.h"
+
+namespace facebook {
+namespace cachelib {
+namespace tests {
+namespace {
+using SS = SortedSet<uint64_t, uint32_t, LruAllocator>;
+using Expected = std::set<std::pair<uint32_t, uint64_t>>;
+
+// checks the order, the ranks and the scores of the set against the expected
+// {score, member} pairs
+void checkSet(const SS& ss, const Expected& expected) {
+  ASSERT_EQ(expected.size(), ss.size());
+  uint32_t rank = 0;
+  auto itr = ss.begin();
+  for (const auto& [score, member] : expected) {
+    ASSERT_NE(ss.end(), itr);
+    // entries are packed, copy their fields out before comparing
+    EXPECT_EQ(member, uint64_t{itr->member});
+    EXPECT_EQ(score, uint32_t{itr->score});
+    EXPECT_EQ(rank, ss.getRank(member).value());
+    EXPECT_EQ(member, uint64_t{ss.atRank(rank)->member});
+    const uint32_t storedScore = *ss.getScore(member);
+    EXPECT_EQ(score, storedScore);
+    ++itr;
+    ++rank;
+  }
+  EXPECT_EQ(ss.end(), itr);
+  EXPECT_EQ(ss.end(), ss.atRank(rank));
+}
+} // namespace
+
+TEST(SortedSet, Basic) {
+  auto cache = DataTypeTest::createCache<LruAllocator>();
+  auto ss = SS::create(*cache, 0, "sorted_set");
+  EXPECT_FALSE(ss.isNullWriteHandle());
+  EXPECT_EQ(0, ss.size());
+  EXPECT_EQ(ss.begin(), ss.end());
+  EXPECT_EQ(nullptr, ss.getScore(1));
+  EXPECT_FALSE(ss.getRank(1).has_value());
+
+  auto ss2 = std::move(ss);
+  EXPECT_FALSE(ss2.isNullWriteHandle());
+
+  EXPECT_EQ(SS::kInserted, ss2.insertOrUpdate(1, 30));
+  EXPECT_EQ(SS::kInserted, ss2.insertOrUpdate(2, 10));
+  EXPECT_EQ(SS::kInserted, ss2.insertOrUpdate(3, 20));
+  checkSet(ss2, {{10, 2}, {20, 3}, {30, 1}});
+
+  // moving a member keeps the set in place
+  const auto sizeInBytes = ss2.sizeInBytes();
+  const auto remainingBytes = ss2.remainingBytes();
+  EXPECT_EQ(SS::kUpdated, ss2.insertOrUpdate(1, 5));
+  EXPECT_EQ(SS::kUpdated, ss2.insertOrUpdate(3, 20));
+  checkSet(ss2, {{5, 1}, {10, 2}, {20, 3}});
+  EXPECT_EQ(sizeInBytes, ss2.sizeInBytes());
+  EXPECT_EQ(remainingBytes, ss2.remainingBytes());
+
+  EXPECT_TRUE(ss2.remove(2));
+  EXPECT_FALSE(ss2.remove(2));
+  checkSet(ss2, {{5, 1}, {20, 3}});
+}
+
+TEST(SortedSet, EqualScores) {
+  auto cache = DataTypeTest::createCache<LruAllocator>();
+  auto ss = SS::create(*cache, 0, "sorted_set");
+  for (uint64_t member = 10; member > 0; member--) {
+    ss.insertOrUpdate(member, member % 2);
+  }
+  Expected expected;
+  for (uint64_t member = 1; member <= 10; member++) {
+    expected.emplace(member % 2, member);
+  }
+  checkSet(ss, expected);
+}
+
+TEST(SortedSet, Ranges) {
+  auto cache = DataTypeTest::createCache<LruAllocator>();
+  auto ss = SS::create(*cache, 0, "sorted_set");
+  // scores 0, 10, ..., 90
+  for (uint64_t member = 0; member < 10; member++) {
+    ss.insertOrUpdate(member, member * 10);
+  }
+
+  auto toMembers = [](auto range) {
+    std::vector<uint64_t> members;
+    for (const auto& entry : range) {
+      members.push_back(uint64_t{entry.member});
+    }
+    return members;
+  };
+  EXPECT_EQ((std::vector<uint64_t>{2, 3, 4}), toMembers(ss.rangeByRank(2, 5)));
+  EXPECT_EQ((std::vector<uint64_t>{8, 9}), toMembers(ss.rangeByRank(8, 100)));
+  EXPECT_TRUE(toMembers(ss.rangeByRank(5, 5)).empty());
+  EXPECT_TRUE(toMembers(ss.rangeByRank(10, 20)).empty());
+
+  EXPECT_EQ((std::vector<uint64_t>{2, 3, 4}),
+            toMembers(ss.rangeByScore(20, 40)));
+  EXPECT_EQ((std::vector<uint64_t>{2, 3}), toMembers(ss.rangeByScore(15, 35)));
+  EXPECT_EQ((std::vector<uint64_t>{0}), toMembers(ss.rangeByScore(0, 0)));
+  EXPECT_EQ((std::vector<uint64_t>{9}), toMembers(ss.rangeByScore(85, 1000)));
+  EXPECT_TRUE(toMembers(ss.rangeByScore(41, 49)).empty());
+  EXPECT_TRUE(toMembers(ss.rangeByScore(100, 200)).empty());
+  EXPECT_TRUE(toMembers(ss.rangeByScore(40, 20)).empty());
+}
+
+TEST(SortedSet, Expansion) {
+  auto cache = DataTypeTest::createCache<LruAllocator>();
+  auto ss = SS::create(*cache, 0, "sorted_set", 2 /* entries */,
+                       50 /* storage bytes */);
+  ASSERT_FALSE(ss.isNullWriteHandle());
+  cache->insertOrReplace(ss.viewWriteHandle());
+
+  Expected expected;
+  for (uint64_t member = 0; member < 1000; member++) {
+    const auto score = static_cast<uint32_t>(member * 7919 % 1000);
+    ss.insertOrUpdate(member, score);
+    expected.emplace(score, member);
+  }
+  checkSet(ss, expected);
+
+  // the expanded set replaced the original one in cache
+  auto ss2 = SS::fromWriteHandle(*cache, cache->findToWrite("sorted_set"));
+  ASSERT_FALSE(ss2.isNullWriteHandle());
+  checkSet(ss2, expected);
+}
+
+TEST(SortedSet, Compaction) {
+  auto cache = DataTypeTest::createCache<LruAllocator>();
+  auto ss = SS::create(*cache, 0, "sorted_set");
+
+  Expected expected;
+  for (uint64_t member = 0; member < 1000; member++) {
+    ss.insertOrUpdate(member, static_cast<uint32_t>(member % 100));
+    expected.emplace(member % 100, member);
+  }
+  const auto sizeInBytes = ss.sizeInBytes();
+
+  // removing most members compacts the buffers in place as the holes grow
+  for (uint64_t member = 0; member < 1000; member++) {
+    if (member % 10 != 0) {
+      EXPECT_TRUE(ss.remove(member));
+      expected.erase({member % 100, member});
+    }
+  }
+  EXPECT_EQ(sizeInBytes, ss.sizeInBytes());
+  EXPECT_GT(ss.remainingBytes(), 0);
+  checkSet(ss, expected);
+
+  ss.compact();
+  EXPECT_EQ(0, ss.wastedBytes());
+  checkSet(ss, expected);
+
+  // the freed bytes are reused without growing the set
+  for (uint64_t member = 1000; member < 1500; member++) {
+    ss.insertOrUpdate(member, static_cast<uint32_t>(member % 100));
+    expected.emplace(member % 100, member);
+  }
+  checkSet(ss, expected);
+  EXPECT_EQ(sizeInBytes, ss.sizeInBytes());
+}
+
+TEST(SortedSet, RandomOps) {
+  auto cache = DataTypeTest::createCache<LruAllocator>();
+  auto ss = SS::create(*cache, 0, "sorted_set");
+
+  std::map<uint64_t, uint32_t> scores;
+  for (int i = 0; i < 20000; i++) {
+    const uint64_t member = folly::Random::rand32(500);
+    if (folly::Random::oneIn(3)) {
+      EXPECT_EQ(scores.erase(member) == 1, ss.remove(member));
+    } else {
+      const uint32_t score = folly::Random::rand32(100);
+      const auto res = ss.insertOrUpdate(member, score);
+      EXPECT_EQ(scores.count(member) ? SS::kUpdated : SS::kInserted, res);
+      scores[member] = score;
+    }
+  }
+
+  Expected expected;
+  for (const auto& [member, score] : scores) {
+    expected.emplace(score, member);
+  }
+  checkSet(ss, expected);
+}
+} // namespace tests
+} // namespace cachelib
+} // namespace facebook
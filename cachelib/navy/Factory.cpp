@@ -25,6 +25,7 @@
 #include "cachelib/navy/admission_policy/RejectRandomAP.h"
 #include "cachelib/navy/bighash/BigHash.h"
 #include "cachelib/navy/block_cache/BlockCache.h"
+#include "cachelib/navy/block_cache/ClockPolicy.h"
 #include "cachelib/navy/block_cache/FifoPolicy.h"
 #include "cachelib/navy/block_cache/LruPolicy.h"
 #include "cachelib/navy/common/Device.h"
@@ -68,6 +69,17 @@ class BlockCacheProtoImpl final : public BlockCacheProto {
     config_.evictionPolicy = std::make_unique<LruPolicy>(numRegions);
   }
 
+  void setClockEvictionPolicy() override {
+    if (!(config_.cacheSize > 0 && config_.regionSize > 0)) {
+      throw std::logic_error("layout is not set");
+    }
+    auto numRegions = config_.getNumRegions();
+    if (config_.evictionPolicy) {
+      throw std::invalid_argument("There's already an eviction policy set");
+    }
+    config_.evictionPolicy = std::make_unique<ClockPolicy>(numRegions);
+  }
+
   void setFifoEvictionPolicy() override {
     if (config_.evictionPolicy) {
       throw std::invalid_argument("There's already an eviction policy set");
@@ -118,12 +130,26 @@ class BlockCacheProtoImpl final : public BlockCacheProto {
     config_.preciseRemove = preciseRemove;
   }
 
+  void setLockProfiler(LockProfiler* lockProfiler) override {
+    config_.lockProfiler = lockProfiler;
+  }
+
+  void setIndexFlash(uint64_t baseOffset,
+                     uint64_t size,
+                     uint64_t dramBudget) override {
+    config_.indexFlashOffset = baseOffset;
+    config_.indexFlashSize = size;
+    config_.indexDramBudget = dramBudget;
+  }
+
   std::unique_ptr<Engine> create(JobScheduler& scheduler,
                                  ExpiredCheck checkExpired,
-                                 DestructorCallback cb) && {
+                                 DestructorCallback cb,
+                                 PromotionCallback promotionCb) && {
     config_.scheduler = &scheduler;
     config_.checkExpired = std::move(checkExpired);
     config_.destructorCb = std::move(cb);
+    config_.promotionCb = std::move(promotionCb);
     config_.validate();
     return std::make_unique<BlockCache>(std::move(config_));
   }
@@ -203,6 +229,7 @@ class EnginePairProtoImpl final : public EnginePairProto {
   EnginePair create(Device* device,
                     ExpiredCheck checkExpired,
                     DestructorCallback destructorCb,
+                    PromotionCallback promotionCb,
                     JobScheduler& scheduler) {
     std::unique_ptr<Engine> bh;
 
@@ -220,7 +247,8 @@ class EnginePairProtoImpl final : public EnginePairProto {
       auto bcProto = dynamic_cast<BlockCacheProtoImpl*>(blockCacheProto_.get());
       if (bcProto != nullptr) {
         bcProto->setDevice(device);
-        bc = std::move(*bcProto).create(scheduler, checkExpired, destructorCb);
+        bc = std::move(*bcProto).create(scheduler, checkExpired, destructorCb,
+                                        promotionCb);
       }
     }
 
@@ -265,6 +293,10 @@ class CacheProtoImpl final : public CacheProto {
     destructorCb_ = std::move(cb);
   }
 
+  void setPromotionCallback(PromotionCallback cb) override {
+    promotionCb_ = std::move(cb);
+  }
+
   void addEnginePair(std::unique_ptr<EnginePairProto> proto) override {
     enginePairsProto_.push_back(std::move(proto));
   }
@@ -326,7 +358,7 @@ class CacheProtoImpl final : public CacheProto {
       config_.enginePairs.push_back(
           dynamic_cast<EnginePairProtoImpl*>(p.get())->create(
               config_.device.get(), checkExpired_, destructorCb_,
-              *config_.scheduler));
+              promotionCb_, *config_.scheduler));
     }
 
     return std::make_unique<Driver>(std::move(config_));
@@ -335,6 +367,7 @@ class CacheProtoImpl final : public CacheProto {
  private:
   ExpiredCheck checkExpired_;
   DestructorCallback destructorCb_;
+  PromotionCallback promotionCb_;
   std::vector<std::unique_ptr<EnginePairProto>> enginePairsProto_;
   Driver::Config config_;
 };
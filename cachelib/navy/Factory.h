@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "cachelib/allocator/nvmcache/NavyConfig.h"
+#include "cachelib/common/LockProfiler.h"
 #include "cachelib/navy/AbstractCache.h"
 #include "cachelib/navy/common/Device.h"
 #include "cachelib/navy/scheduler/JobScheduler.h"
@@ -49,11 +50,15 @@ class BlockCacheProto {
   virtual void setChecksum(bool enable) = 0;
 
   // set*EvictionPolicy function family: sets eviction policy. Supports LRU,
-  // LRU with deferred insert and FIFO. Must set up one of them.
+  // CLOCK, FIFO and segmented FIFO. Must set up one of them.
 
   // Sets LRU eviction policy.
   virtual void setLruEvictionPolicy() = 0;
 
+  // Sets CLOCK eviction policy, an approximate LRU that records hits without
+  // locking.
+  virtual void setClockEvictionPolicy() = 0;
+
   // Sets FIFO eviction policy.
   virtual void setFifoEvictionPolicy() = 0;
 
@@ -84,8 +89,19 @@ class BlockCacheProto {
   // (Optional) Set the fiber stack size of region_manager thread
   virtual void setStackSize(uint32_t stackSize) = 0;
 
+  // (Optional) Keep the cold part of the index on flash, at @size bytes from
+  // @baseOffset on the device, once the index uses more than @dramBudget
+  // bytes of DRAM. Default: the whole index is kept in DRAM.
+  virtual void setIndexFlash(uint64_t baseOffset,
+                             uint64_t size,
+                             uint64_t dramBudget) = 0;
+
   // (Optional) Set if the preciseRemove flag.
   virtual void setPreciseRemove(bool preciseRemove) = 0;
+
+  // (Optional) Record the contention of the block cache locks in
+  // @lockProfiler, which must outlive the cache.
+  virtual void setLockProfiler(LockProfiler* lockProfiler) = 0;
 };
 
 // BigHash engine proto. BigHash is used to cache small objects (under 2KB)
@@ -167,6 +183,11 @@ class CacheProto {
   //   - Callback should be lightweight.
   virtual void setDestructorCallback(DestructorCallback cb) = 0;
 
+  // (Optional) Set promotion callback. BlockCache invokes it on region
+  // reclaim for the entries hot enough to be promoted to DRAM, see
+  // BlockCacheReinsertionConfig::enablePromotion.
+  virtual void setPromotionCallback(PromotionCallback cb) = 0;
+
   // (Optional) Set admission policy to accept a random item with specified
   // probability.
   //
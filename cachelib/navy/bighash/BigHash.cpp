@@ -22,6 +22,7 @@
 #include <chrono>
 
 #include "cachelib/common/Hash.h"
+#include "cachelib/common/LatencyTracer.h"
 #include "cachelib/navy/bighash/Bucket.h"
 #include "cachelib/navy/common/Hash.h"
 #include "cachelib/navy/common/Utils.h"
@@ -109,6 +110,11 @@ void BigHash::reset() {
   validBucketChecker_ = std::make_unique<ValidBucketChecker>(
       numBuckets_, kBigHashValidBucketCheckerBucketsPerBit);
 
+  // None of the buckets are valid after a reset. Let the device know so that
+  // it does not keep their contents around.
+  device_.discard(cacheBaseOffset_, bucketSize_ * numBuckets_,
+                  false /* rateLimited */);
+
   itemCount_.set(0);
   insertCount_.set(0);
   succInsertCount_.set(0);
@@ -402,9 +408,13 @@ Status BigHash::lookup(HashedKey hk, Buffer& value) {
   // bucket. Once the bucket is read, the buffer is local and we can find
   // without holding the lock.
   {
-    std::shared_lock<SharedMutex> lock{getMutex(bid)};
-    if (bfReject(bid, hk.keyHash())) {
-      return Status::NotFound;
+    std::shared_lock<SharedMutex> lock{getMutex(bid), std::defer_lock};
+    {
+      ScopedTraceStage stage{TraceStage::kNavyIndex};
+      lock.lock();
+      if (bfReject(bid, hk.keyHash())) {
+        return Status::NotFound;
+      }
     }
 
     buffer = readBucket(bid);
@@ -62,7 +62,8 @@ std::tuple<RegionDescriptor, uint32_t, RelAddress> Allocator::allocate(
 // written to the slot.
 std::tuple<RegionDescriptor, uint32_t, RelAddress> Allocator::allocateWith(
     RegionAllocator& ra, uint32_t size, bool canWait) {
-  std::unique_lock<TimedMutex> lock{ra.getLock()};
+  auto lock = util::lockProfiled<std::unique_lock<TimedMutex>>(ra.getLock(),
+                                                               lockStats_);
   RegionId rid = ra.getAllocationRegion();
   if (rid.valid()) {
     auto& region = regionManager_.getRegion(rid);
@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "cachelib/common/AtomicCounter.h"
+#include "cachelib/common/LockProfiler.h"
 #include "cachelib/navy/block_cache/RegionManager.h"
 #include "cachelib/navy/common/Buffer.h"
 #include "cachelib/navy/common/Types.h"
@@ -116,6 +117,10 @@ class Allocator {
   // Exports Allocator stats via CounterVisitor.
   void getCounters(const CounterVisitor& visitor) const;
 
+  // Records the acquisitions of the region allocator locks by allocations in
+  // the stats. Must be set before the allocator is used.
+  void setLockStats(LockStats* stats) noexcept { lockStats_ = stats; }
+
  private:
   using LockGuard = std::lock_guard<TimedMutex>;
   Allocator(const Allocator&) = delete;
@@ -135,6 +140,8 @@ class Allocator {
   std::vector<RegionAllocator> allocators_;
 
   mutable AtomicCounter allocRetryWaits_;
+  // stats of the acquisitions of the region allocator locks, if profiled
+  LockStats* lockStats_{nullptr};
 };
 } // namespace navy
 } // namespace cachelib
@@ -24,6 +24,7 @@
 #include <numeric>
 #include <utility>
 
+#include "cachelib/common/LatencyTracer.h"
 #include "cachelib/common/inject_pause.h"
 #include "cachelib/navy/common/Hash.h"
 #include "cachelib/navy/common/Types.h"
@@ -66,6 +67,17 @@ BlockCache::Config& BlockCache::Config::validate() {
   if (numPriorities == 0) {
     throw std::invalid_argument("allocator must have at least one priority");
   }
+  if (indexFlashSize > 0) {
+    if (indexFlashOffset < cacheBaseOffset + cacheSize &&
+        cacheBaseOffset < indexFlashOffset + indexFlashSize) {
+      throw std::invalid_argument(folly::sformat(
+          "Index pages overlap the cache. index offset: {}, index size: {}",
+          indexFlashOffset, indexFlashSize));
+    }
+    if (indexDramBudget == 0) {
+      throw std::invalid_argument("index DRAM budget must be > 0");
+    }
+  }
 
   reinsertionConfig.validate();
 
@@ -117,6 +129,12 @@ BlockCache::BlockCache(Config&& config, ValidConfigTag)
       numPriorities_{config.numPriorities},
       checkExpired_{std::move(config.checkExpired)},
       destructorCb_{std::move(config.destructorCb)},
+      promotionCb_{std::move(config.promotionCb)},
+      promotionHitsThreshold_{
+          promotionCb_
+              ? config.reinsertionConfig.getPromotionHitsThreshold()
+              : uint8_t{0}},
+      reinsertPromoted_{config.reinsertionConfig.getReinsertPromoted()},
       checksumData_{config.checksum},
       device_{*config.device},
       allocAlignSize_{calcAllocAlignSize()},
@@ -126,6 +144,7 @@ BlockCache::BlockCache(Config&& config, ValidConfigTag)
       regionSize_{config.regionSize},
       itemDestructorEnabled_{config.itemDestructorEnabled},
       preciseRemove_{config.preciseRemove},
+      index_{makeIndexFlashConfig(config)},
       regionManager_{config.getNumRegions(),
                      config.regionSize,
                      config.cacheBaseOffset,
@@ -142,9 +161,36 @@ BlockCache::BlockCache(Config&& config, ValidConfigTag)
       allocator_{regionManager_, config.numPriorities},
       reinsertionPolicy_{makeReinsertionPolicy(config.reinsertionConfig)} {
   validate(config);
+  const auto promotionRate =
+      config.reinsertionConfig.getPromotionMaxBytesPerSec();
+  if (promotionHitsThreshold_ > 0 && promotionRate > 0) {
+    const auto rate = static_cast<double>(promotionRate);
+    promotionLimiter_ = std::make_unique<folly::TokenBucket>(rate, rate);
+  }
+  if (config.lockProfiler != nullptr) {
+    auto& profiler = *config.lockProfiler;
+    index_.setLockStats(profiler.getStats("navy.bc_index"));
+    allocator_.setLockStats(profiler.getStats("navy.bc_allocator"));
+    regionManager_.setEvictionPolicyLockStats(
+        profiler.getStats("navy.bc_eviction_policy"));
+  }
   XLOG(INFO, "Block cache created");
   XDCHECK_NE(readBufferSize_, 0u);
 }
+
+Index::FlashConfig BlockCache::makeIndexFlashConfig(const Config& config) {
+  Index::FlashConfig flashConfig;
+  if (config.indexFlashSize > 0) {
+    flashConfig.device = config.device;
+    flashConfig.baseOffset = config.indexFlashOffset;
+    flashConfig.size = config.indexFlashSize;
+    flashConfig.dramBudget = config.indexDramBudget;
+    flashConfig.pageSize =
+        std::max(flashConfig.pageSize, config.device->getIOAlignmentSize());
+  }
+  return flashConfig;
+}
+
 std::shared_ptr<BlockCacheReinsertionPolicy> BlockCache::makeReinsertionPolicy(
     const BlockCacheReinsertionConfig& reinsertionConfig) {
   auto hitsThreshold = reinsertionConfig.getHitsThreshold();
@@ -235,7 +281,10 @@ uint64_t BlockCache::estimateWriteSize(HashedKey hk, BufferView value) const {
 
 Status BlockCache::lookup(HashedKey hk, Buffer& value) {
   const auto seqNumber = regionManager_.getSeqNumber();
-  const auto lr = index_.lookup(hk.keyHash());
+  const auto lr = [this, hk]() {
+    ScopedTraceStage stage{TraceStage::kNavyIndex};
+    return index_.lookup(hk.keyHash());
+  }();
   if (!lr.found()) {
     lookupCount_.inc();
     return Status::NotFound;
@@ -613,6 +662,14 @@ BlockCache::ReinsertionRes BlockCache::reinsertOrRemoveItem(
     return removeItem(true);
   }
 
+  // A promoted entry is now served from DRAM. Unless configured otherwise,
+  // drop the flash copy instead of spending a write on it. The DRAM copy is
+  // written back to flash when DRAM evicts it.
+  if (tryPromote(hk, value, entrySize, lr.currentHits(), currAddr) &&
+      !reinsertPromoted_) {
+    return removeItem(false);
+  }
+
   if (!reinsertionPolicy_ ||
       !reinsertionPolicy_->shouldReinsert(hk.key(), toStringPiece(value))) {
     return removeItem(false);
@@ -668,6 +725,33 @@ BlockCache::ReinsertionRes BlockCache::reinsertOrRemoveItem(
   return ReinsertionRes::kReinserted;
 }
 
+bool BlockCache::tryPromote(HashedKey hk,
+                            BufferView value,
+                            uint32_t entrySize,
+                            uint8_t hits,
+                            RelAddress currAddr) {
+  if (promotionHitsThreshold_ == 0 || hits < promotionHitsThreshold_) {
+    return false;
+  }
+  if (promotionLimiter_ &&
+      !promotionLimiter_->consume(static_cast<double>(entrySize))) {
+    promotionThrottleCount_.inc();
+    return false;
+  }
+  // the entry can be removed or overwritten while DRAM allocates for it
+  auto isCurrent = [this, hk, currAddr]() {
+    const auto lr = index_.peek(hk.keyHash());
+    return lr.found() && decodeRelAddress(lr.address()) == currAddr;
+  };
+  if (!promotionCb_(hk, value, isCurrent)) {
+    promotionRejectCount_.inc();
+    return false;
+  }
+  promotionCount_.inc();
+  promotionBytes_.add(entrySize);
+  return true;
+}
+
 Status BlockCache::writeEntry(RelAddress addr,
                               uint32_t slotSize,
                               HashedKey hk,
@@ -864,6 +948,14 @@ void BlockCache::getCounters(const CounterVisitor& visitor) const {
           CounterVisitor::CounterType::RATE);
   visitor("navy_bc_reinsertion_errors", reinsertionErrorCount_.get(),
           CounterVisitor::CounterType::RATE);
+  visitor("navy_bc_promotions", promotionCount_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_bc_promotion_bytes", promotionBytes_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_bc_promotion_rejects", promotionRejectCount_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_bc_promotion_throttled", promotionThrottleCount_.get(),
+          CounterVisitor::CounterType::RATE);
   visitor("navy_bc_lookup_for_item_destructor_errors",
           lookupForItemDestructorErrorCount_.get(),
           CounterVisitor::CounterType::RATE);
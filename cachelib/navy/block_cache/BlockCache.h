@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <folly/TokenBucket.h>
+
 #include <atomic>
 #include <chrono>
 #include <memory>
@@ -25,6 +27,7 @@
 #include "cachelib/allocator/nvmcache/NavyConfig.h"
 #include "cachelib/common/AtomicCounter.h"
 #include "cachelib/common/CompilerUtils.h"
+#include "cachelib/common/LockProfiler.h"
 #include "cachelib/navy/block_cache/Allocator.h"
 #include "cachelib/navy/block_cache/EvictionPolicy.h"
 #include "cachelib/navy/block_cache/HitsReinsertionPolicy.h"
@@ -50,6 +53,9 @@ class BlockCache final : public Engine {
     Device* device{};
     ExpiredCheck checkExpired;
     DestructorCallback destructorCb;
+    // Promotes hot entries to DRAM on reclaim if the reinsertion config
+    // enables it
+    PromotionCallback promotionCb;
     // Checksum data read/written
     bool checksum{};
     // Base offset and size (in bytes) of cache on the device
@@ -89,6 +95,16 @@ class BlockCache final : public Engine {
     // whether to remove an item by checking the full key.
     bool preciseRemove{false};
 
+    // Range of the device for the index pages and the DRAM budget of the
+    // index. The whole index stays in DRAM if the size is 0.
+    uint64_t indexFlashOffset{};
+    uint64_t indexFlashSize{};
+    uint64_t indexDramBudget{};
+
+    // Records the contention of the index, allocator and eviction policy
+    // locks if set. Must outlive the block cache.
+    LockProfiler* lockProfiler{};
+
     // Calculates the total region number.
     uint32_t getNumRegions() const {
       XDCHECK_EQ(0ul, cacheSize % regionSize);
@@ -341,10 +357,30 @@ class BlockCache final : public Engine {
   std::shared_ptr<BlockCacheReinsertionPolicy> makeReinsertionPolicy(
       const BlockCacheReinsertionConfig& reinsertionConfig);
 
+  // Create the config of the flash part of the index. The index is in DRAM
+  // only if config.indexFlashSize is 0.
+  static Index::FlashConfig makeIndexFlashConfig(const Config& config);
+
+  // Offers a reclaimed entry to the DRAM cache if it is hot enough and the
+  // promotion rate allows it. Returns true if the DRAM cache took it.
+  bool tryPromote(HashedKey hk,
+                  BufferView value,
+                  uint32_t entrySize,
+                  uint8_t hits,
+                  RelAddress currAddr);
+
   const serialization::BlockCacheConfig config_;
   const uint16_t numPriorities_{};
   const ExpiredCheck checkExpired_;
   const DestructorCallback destructorCb_;
+  const PromotionCallback promotionCb_;
+  // entries with at least these many hits are promoted on reclaim. 0 if
+  // promotion is disabled.
+  const uint8_t promotionHitsThreshold_{};
+  // whether promoted entries are still offered to the reinsertion policy
+  const bool reinsertPromoted_{false};
+  // limits the bytes promoted per second if set
+  std::unique_ptr<folly::TokenBucket> promotionLimiter_;
   const bool checksumData_{};
   // reference to the under-lying device.
   const Device& device_;
@@ -404,6 +440,10 @@ class BlockCache final : public Engine {
   mutable AtomicCounter reinsertionErrorCount_;
   mutable AtomicCounter reinsertionCount_;
   mutable AtomicCounter reinsertionBytes_;
+  mutable AtomicCounter promotionCount_;
+  mutable AtomicCounter promotionBytes_;
+  mutable AtomicCounter promotionRejectCount_;
+  mutable AtomicCounter promotionThrottleCount_;
   mutable AtomicCounter reclaimEntryHeaderChecksumErrorCount_;
   mutable AtomicCounter reclaimValueChecksumErrorCount_;
   mutable AtomicCounter removeAttemptCollisions_;
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/navy/block_cache/ClockPolicy.h"
+
+#include <folly/logging/xlog.h>
+
+namespace facebook::cachelib::navy {
+
+constexpr std::chrono::seconds ClockPolicy::kEstimatorWindow;
+
+ClockPolicy::ClockPolicy(uint32_t numRegions)
+    : regions_(numRegions),
+      sweepLengthEstimator_{kEstimatorWindow},
+      secSinceInsertionEstimator_{kEstimatorWindow},
+      hitsEstimator_{kEstimatorWindow} {
+  XLOGF(INFO, "CLOCK policy: {} regions", numRegions);
+}
+
+void ClockPolicy::touch(RegionId rid) {
+  XDCHECK(rid.valid());
+  auto i = rid.index();
+  if (i >= regions_.size()) {
+    return;
+  }
+  auto& state = regions_[i];
+  if (!state.tracked.load(std::memory_order_relaxed)) {
+    return;
+  }
+  state.hits.fetch_add(1, std::memory_order_relaxed);
+  // avoid dirtying the cache line for regions that are already referenced
+  if (!state.referenced.load(std::memory_order_relaxed)) {
+    state.referenced.store(true, std::memory_order_relaxed);
+  }
+}
+
+void ClockPolicy::track(const Region& region) {
+  auto rid = region.id();
+  XDCHECK(rid.valid());
+  auto i = rid.index();
+  std::lock_guard<TimedMutex> lock{mutex_};
+  auto& state = regions_.at(i);
+  state.referenced.store(false, std::memory_order_relaxed);
+  state.hits.store(0, std::memory_order_relaxed);
+  state.trackTime = getSteadyClockSeconds();
+  if (!state.tracked.load(std::memory_order_relaxed)) {
+    state.tracked.store(true, std::memory_order_relaxed);
+    ring_.push_back(i);
+  }
+}
+
+RegionId ClockPolicy::evict() {
+  uint32_t retRegion{0};
+  uint32_t steps{0};
+  uint32_t secsSinceCreate{0};
+  uint32_t hits{0};
+
+  {
+    std::lock_guard<TimedMutex> lock{mutex_};
+    if (ring_.empty()) {
+      return RegionId{};
+    }
+    // After one full turn every region had its bit cleared once. Concurrent
+    // hits can set them again, so we stop there and take whatever is under
+    // the hand.
+    const size_t maxSteps = ring_.size();
+    while (true) {
+      auto i = ring_.front();
+      ring_.pop_front();
+      steps++;
+      auto& state = regions_[i];
+      if (steps <= maxSteps &&
+          state.referenced.exchange(false, std::memory_order_relaxed)) {
+        ring_.push_back(i);
+        continue;
+      }
+      retRegion = i;
+      state.tracked.store(false, std::memory_order_relaxed);
+      secsSinceCreate = (getSteadyClockSeconds() - state.trackTime).count();
+      hits = state.hits.load(std::memory_order_relaxed);
+      break;
+    }
+  }
+
+  sweepSteps_.add(steps);
+  secondChances_.add(steps - 1);
+  sweepLengthEstimator_.trackValue(steps);
+  secSinceInsertionEstimator_.trackValue(secsSinceCreate);
+  hitsEstimator_.trackValue(hits);
+  return RegionId{retRegion};
+}
+
+void ClockPolicy::reset() {
+  std::lock_guard<TimedMutex> lock{mutex_};
+  for (auto i : ring_) {
+    regions_[i].tracked.store(false, std::memory_order_relaxed);
+    regions_[i].referenced.store(false, std::memory_order_relaxed);
+  }
+  ring_.clear();
+}
+
+size_t ClockPolicy::memorySize() const {
+  std::lock_guard<TimedMutex> lock{mutex_};
+  return sizeof(*this) + sizeof(RegionState) * regions_.capacity() +
+         sizeof(uint32_t) * ring_.size();
+}
+
+void ClockPolicy::getCounters(const CounterVisitor& v) const {
+  v("navy_bc_clock_sweep_steps", sweepSteps_.get(),
+    CounterVisitor::CounterType::RATE);
+  v("navy_bc_clock_second_chances", secondChances_.get(),
+    CounterVisitor::CounterType::RATE);
+  sweepLengthEstimator_.visitQuantileEstimator(v,
+                                               "navy_bc_clock_sweep_length");
+  secSinceInsertionEstimator_.visitQuantileEstimator(
+      v, "navy_bc_clock_secs_since_insertion");
+  hitsEstimator_.visitQuantileEstimator(v,
+                                        "navy_bc_clock_region_hits_estimate");
+}
+
+void ClockPolicy::persist(RecordWriter& rw) const {
+  std::ignore = rw;
+  throw std::runtime_error("Not Implemented.");
+}
+
+void ClockPolicy::recover(RecordReader& rr) {
+  std::ignore = rr;
+  throw std::runtime_error("Not Implemented.");
+}
+
+} // namespace facebook::cachelib::navy
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <folly/fibers/TimedMutex.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <vector>
+
+#include "cachelib/common/AtomicCounter.h"
+#include "cachelib/common/PercentileStats.h"
+#include "cachelib/navy/block_cache/EvictionPolicy.h"
+#include "cachelib/navy/common/Utils.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+using folly::fibers::TimedMutex;
+
+// CLOCK (second chance) policy that approximates LRU without taking a lock on
+// hits. A hit only sets the reference bit of the region. Tracked regions are
+// kept in a ring in the order they were tracked and the clock hand sweeps it
+// on eviction: a region with its reference bit set gets the bit cleared and
+// goes back to the end of the ring, the first region without it is evicted.
+//
+// Unlike LruPolicy, the number of regions must be known upfront since the
+// per-region state can not be resized while hits are recorded without a lock.
+class ClockPolicy final : public EvictionPolicy {
+ public:
+  // Constructs CLOCK policy.
+  // @numRegions  number of regions in the cache
+  explicit ClockPolicy(uint32_t numRegions);
+
+  ClockPolicy(const ClockPolicy&) = delete;
+  ClockPolicy& operator=(const ClockPolicy&) = delete;
+
+  ~ClockPolicy() override = default;
+
+  // Records the hit of the region. Lock-free.
+  void touch(RegionId rid) override;
+
+  // Adds a new region to the end of the ring for tracking.
+  // @throw std::out_of_range if the region is beyond @numRegions.
+  void track(const Region& region) override;
+
+  // Sweeps the ring and evicts the first region that was not referenced since
+  // the hand passed it last time.
+  RegionId evict() override;
+
+  // Resets CLOCK policy to the initial state.
+  void reset() override;
+
+  // Gets memory used by CLOCK policy.
+  size_t memorySize() const override;
+
+  // Exports CLOCK policy stats via CounterVisitor.
+  void getCounters(const CounterVisitor& v) const override;
+
+  // Persists metadata associated with CLOCK policy.
+  void persist(RecordWriter& rw) const override;
+
+  // Recovers from previously persisted metadata associated with CLOCK policy.
+  void recover(RecordReader& rr) override;
+
+ private:
+  struct RegionState {
+    // set while the region is in the ring
+    std::atomic<bool> tracked{false};
+    std::atomic<bool> referenced{false};
+    std::atomic<uint32_t> hits{0};
+    // seconds since epoch when the region was tracked. Only accessed with
+    // mutex_ held.
+    std::chrono::seconds trackTime{};
+  };
+
+  static constexpr std::chrono::seconds kEstimatorWindow{5};
+
+  // fixed size so that touch() can access it without the lock
+  std::vector<RegionState> regions_;
+  // tracked regions with the clock hand at the front
+  std::deque<uint32_t> ring_;
+  mutable TimedMutex mutex_;
+
+  // number of regions the hand passed over and the ones that were given a
+  // second chance while doing so
+  AtomicCounter sweepSteps_;
+  AtomicCounter secondChances_;
+
+  // various counters that are populated when we evict a region.
+  mutable util::PercentileStats sweepLengthEstimator_;
+  mutable util::PercentileStats secSinceInsertionEstimator_;
+  mutable util::PercentileStats hitsEstimator_;
+};
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
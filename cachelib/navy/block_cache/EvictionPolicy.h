@@ -19,6 +19,7 @@
 #include <chrono>
 #include <memory>
 
+#include "cachelib/common/LockProfiler.h"
 #include "cachelib/navy/block_cache/Region.h"
 #include "cachelib/navy/block_cache/Types.h"
 #include "cachelib/navy/common/Types.h"
@@ -55,6 +56,10 @@ class EvictionPolicy {
 
   // Recovers from previously persisted metadata associated with this policy.
   virtual void recover(RecordReader& rr) = 0;
+
+  // Records the acquisitions of the policy lock in the stats. Must be set
+  // before the policy is used. No-op for the policies that are not profiled.
+  virtual void setLockStats(LockStats* /* stats */) {}
 };
 } // namespace navy
 } // namespace cachelib
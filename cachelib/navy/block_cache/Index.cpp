@@ -17,7 +17,18 @@
 #include "cachelib/navy/block_cache/Index.h"
 
 #include <folly/Format.h>
+#include <folly/ScopeGuard.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/hash/Hash.h>
+#include <folly/logging/xlog.h>
 
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+
+#include "cachelib/navy/common/Device.h"
+#include "cachelib/navy/common/Hash.h"
 #include "cachelib/navy/serialization/Serialization.h"
 
 namespace facebook::cachelib::navy {
@@ -33,11 +44,523 @@ uint8_t safeInc(uint8_t val) {
 }
 } // namespace
 
+// Keeps the buckets that were written out on flash. Each bucket is a run of
+// pages sorted by key. The state of a bucket is protected by the bucket lock
+// of the Index, while pages, page slots and the page cache are safe to use
+// without it.
+class Index::FlashStore {
+ public:
+  struct FOLLY_PACK_ATTR Entry {
+    uint32_t key{};
+    ItemRecord record;
+  };
+
+  // Location of a page on flash. The page id is never reused, so a page
+  // that was freed and written again in the same slot is detected on read.
+  struct PageRef {
+    uint64_t pageId{};
+    uint32_t slot{};
+    // smallest key on the page
+    uint32_t fence{};
+  };
+
+  // Entries of a page, sorted by key
+  struct Page {
+    std::vector<Entry> entries;
+
+    const Entry* find(uint32_t key) const {
+      auto it = std::lower_bound(
+          entries.begin(), entries.end(), key,
+          [](const Entry& e, uint32_t k) { return e.key < k; });
+      return it != entries.end() && it->key == key ? &*it : nullptr;
+    }
+  };
+
+  // DRAM summary of the pages of a bucket
+  struct Run {
+    std::vector<PageRef> pages;
+    // bloom filter of pages[i] is at [i * filterBytes_, (i + 1) * filterBytes_)
+    std::vector<uint8_t> filters;
+    uint32_t numEntries{0};
+
+    size_t memorySize() const {
+      return pages.capacity() * sizeof(PageRef) + filters.capacity();
+    }
+  };
+
+  enum class FindRes {
+    kNotFound,
+    kFound,
+    // bucket was written out again while reading; look it up again
+    kRetry,
+  };
+
+  explicit FlashStore(const FlashConfig& config)
+      : device_{*config.device},
+        baseOffset_{config.baseOffset},
+        pageSize_{config.pageSize},
+        entriesPerPage_{static_cast<uint32_t>(
+            (config.pageSize - sizeof(PageHeader)) / sizeof(Entry))},
+        // 8 bits per entry keeps false positives around 2% with 3 probes
+        filterBytes_{entriesPerPage_},
+        maxResidentBytes_{config.dramBudget - config.dramBudget / 8},
+        buckets_{new BucketState[kNumBuckets]} {
+    const auto numSlots = static_cast<uint32_t>(config.size / pageSize_);
+    freeSlots_.reserve(numSlots);
+    for (uint32_t i = numSlots; i > 0; i--) {
+      freeSlots_.push_back(i - 1);
+    }
+    const uint64_t cachedPages = config.dramBudget / 8 / pageSize_;
+    for (uint32_t i = 0; i < kNumCacheShards; i++) {
+      cacheShards_.push_back(std::make_unique<CacheShard>(
+          std::max<uint64_t>(1, cachedPages / kNumCacheShards)));
+    }
+    XLOGF(INFO,
+          "Flash index: {} pages of {} bytes at offset {}, DRAM budget {}",
+          numSlots, pageSize_, baseOffset_, config.dramBudget);
+  }
+
+  // Bucket state accessors. Call with the bucket lock held.
+  const Run& getRun(uint32_t b) const { return buckets_[b].run; }
+
+  uint64_t getGeneration(uint32_t b) const { return buckets_[b].generation; }
+
+  void markAccessed(uint32_t b) { buckets_[b].accessed = true; }
+
+  bool testAndClearAccessed(uint32_t b) {
+    return std::exchange(buckets_[b].accessed, false);
+  }
+
+  void setSpilling(uint32_t b, bool spilling) {
+    buckets_[b].spilling = spilling;
+  }
+
+  // Whether @key can be on flash, or will be once the bucket being written
+  // out is done.
+  bool mayContain(uint32_t b, uint32_t key) const {
+    return buckets_[b].spilling || locate(b, key).has_value();
+  }
+
+  // Looks up @key on flash. If the page is not cached, @lock is released
+  // while reading it and @relocked is set.
+  template <typename Lock>
+  FindRes find(
+      uint32_t b, uint32_t key, Lock& lock, ItemRecord& out, bool& relocked) {
+    auto ref = locate(b, key);
+    if (!ref) {
+      return FindRes::kNotFound;
+    }
+    auto page = getCachedPage(ref->pageId);
+    if (!page) {
+      const auto generation = buckets_[b].generation;
+      lock.unlock();
+      page = readPage(b, *ref);
+      lock.lock();
+      relocked = true;
+      if (buckets_[b].generation != generation) {
+        return FindRes::kRetry;
+      }
+      if (!page) {
+        return FindRes::kNotFound;
+      }
+    }
+    const auto* entry = page->find(key);
+    if (!entry) {
+      filterFalsePositives_.inc();
+      return FindRes::kNotFound;
+    }
+    out = entry->record;
+    return FindRes::kFound;
+  }
+
+  // Returns the page from the cache or reads it from flash.
+  //
+  // @return nullptr on IO error or if the page was freed
+  std::shared_ptr<const Page> loadPage(uint32_t b, const PageRef& ref) {
+    if (auto page = getCachedPage(ref.pageId)) {
+      return page;
+    }
+    return readPage(b, ref);
+  }
+
+  // Writes @entries, sorted by key, into new pages of bucket @b and fills
+  // @run with their summary. Does not change the bucket.
+  //
+  // @return false if there is not enough space or on IO error
+  bool writeRun(uint32_t b, const std::vector<Entry>& entries, Run& run) {
+    const size_t numPages =
+        (entries.size() + entriesPerPage_ - 1) / entriesPerPage_;
+    run.pages.reserve(numPages);
+    run.filters.assign(numPages * filterBytes_, 0);
+    for (size_t i = 0; i < numPages; i++) {
+      const size_t begin = i * entriesPerPage_;
+      const size_t end = std::min(entries.size(), begin + entriesPerPage_);
+      auto slot = allocSlot();
+      if (!slot) {
+        freeRun(run);
+        return false;
+      }
+      PageRef ref{nextPageId_.fetch_add(1), *slot, entries[begin].key};
+      run.pages.push_back(ref);
+
+      auto buffer = device_.makeIOBuffer(pageSize_);
+      std::memset(buffer.data(), 0, pageSize_);
+      const size_t dataSize = (end - begin) * sizeof(Entry);
+      auto* data = buffer.data() + sizeof(PageHeader);
+      std::memcpy(data, entries.data() + begin, dataSize);
+      PageHeader header{ref.pageId, b, static_cast<uint32_t>(end - begin),
+                        checksum(BufferView{dataSize, data})};
+      std::memcpy(buffer.data(), &header, sizeof(header));
+      if (!device_.write(slotOffset(ref.slot), std::move(buffer))) {
+        ioErrors_.inc();
+        freeRun(run);
+        return false;
+      }
+      pageWrites_.inc();
+
+      auto* filter = run.filters.data() + i * filterBytes_;
+      for (size_t j = begin; j < end; j++) {
+        setFilter(filter, entries[j].key);
+      }
+    }
+    run.numEntries = static_cast<uint32_t>(entries.size());
+    return true;
+  }
+
+  // Replaces the run of bucket @b and frees the pages of the old one. Call
+  // with the bucket lock held.
+  void replaceRun(uint32_t b, Run&& run) {
+    auto& state = buckets_[b];
+    summaryBytes_.sub(state.run.memorySize());
+    summaryBytes_.add(run.memorySize());
+    auto old = std::exchange(state.run, std::move(run));
+    state.generation++;
+    freeRun(old);
+  }
+
+  // Frees the pages of @run that is not used by any bucket.
+  void freeRun(Run& run) {
+    for (const auto& ref : run.pages) {
+      dropCachedPage(ref.pageId);
+      std::lock_guard<TimedMutex> l{slotMutex_};
+      freeSlots_.push_back(ref.slot);
+    }
+    run = Run{};
+  }
+
+  // Whether the entries in DRAM and the summary exceed the budget.
+  bool overBudget(uint64_t residentEntries) const {
+    return residentBytes(residentEntries) > maxResidentBytes_;
+  }
+
+  // Spilling stops once below this.
+  bool overLowWatermark(uint64_t residentEntries) const {
+    return residentBytes(residentEntries) > maxResidentBytes_ / 10 * 9;
+  }
+
+  void getCounters(const CounterVisitor& visitor) const {
+    visitor("navy_bc_index_flash_summary_bytes", summaryBytes_.get());
+    uint64_t freePages = 0;
+    {
+      std::lock_guard<TimedMutex> l{slotMutex_};
+      freePages = freeSlots_.size();
+    }
+    visitor("navy_bc_index_flash_free_pages", freePages);
+    visitor("navy_bc_index_flash_page_reads", pageReads_.get(),
+            CounterVisitor::CounterType::RATE);
+    visitor("navy_bc_index_flash_page_cache_hits", pageCacheHits_.get(),
+            CounterVisitor::CounterType::RATE);
+    visitor("navy_bc_index_flash_page_writes", pageWrites_.get(),
+            CounterVisitor::CounterType::RATE);
+    visitor("navy_bc_index_flash_filter_false_positives",
+            filterFalsePositives_.get(), CounterVisitor::CounterType::RATE);
+    visitor("navy_bc_index_flash_io_errors", ioErrors_.get(),
+            CounterVisitor::CounterType::RATE);
+  }
+
+ private:
+  struct FOLLY_PACK_ATTR PageHeader {
+    uint64_t pageId{};
+    uint32_t bucket{};
+    uint32_t numEntries{};
+    uint32_t checksum{};
+  };
+
+  struct BucketState {
+    Run run;
+    // changes every time the run is replaced
+    uint64_t generation{0};
+    // accessed since the spiller passed the bucket last time
+    bool accessed{false};
+    // the bucket is being written out
+    bool spilling{false};
+  };
+
+  struct CacheShard {
+    explicit CacheShard(size_t capacity) : pages{capacity} {}
+
+    TimedMutex mutex;
+    folly::EvictingCacheMap<uint64_t, std::shared_ptr<const Page>> pages;
+  };
+
+  // Approximate DRAM used by a sparse_map entry of the Index
+  static constexpr uint64_t kBytesPerEntry{16};
+  static constexpr uint32_t kNumCacheShards{16};
+  static constexpr uint32_t kNumFilterProbes{3};
+
+  uint64_t residentBytes(uint64_t residentEntries) const {
+    return residentEntries * kBytesPerEntry + summaryBytes_.get();
+  }
+
+  uint64_t slotOffset(uint32_t slot) const {
+    return baseOffset_ + static_cast<uint64_t>(slot) * pageSize_;
+  }
+
+  // Finds the page that may contain @key
+  std::optional<PageRef> locate(uint32_t b, uint32_t key) const {
+    const auto& run = buckets_[b].run;
+    auto it = std::upper_bound(
+        run.pages.begin(), run.pages.end(), key,
+        [](uint32_t k, const PageRef& ref) { return k < ref.fence; });
+    if (it == run.pages.begin()) {
+      return std::nullopt;
+    }
+    --it;
+    const auto i = static_cast<size_t>(it - run.pages.begin());
+    if (!testFilter(run.filters.data() + i * filterBytes_, key)) {
+      return std::nullopt;
+    }
+    return *it;
+  }
+
+  void setFilter(uint8_t* filter, uint32_t key) const {
+    auto h = folly::hash::twang_mix64(key);
+    const uint64_t numBits = filterBytes_ * 8ull;
+    for (uint32_t i = 0; i < kNumFilterProbes; i++, h >>= 21) {
+      const auto bit = h % numBits;
+      filter[bit / 8] |= static_cast<uint8_t>(1u << (bit % 8));
+    }
+  }
+
+  bool testFilter(const uint8_t* filter, uint32_t key) const {
+    auto h = folly::hash::twang_mix64(key);
+    const uint64_t numBits = filterBytes_ * 8ull;
+    for (uint32_t i = 0; i < kNumFilterProbes; i++, h >>= 21) {
+      const auto bit = h % numBits;
+      if (!(filter[bit / 8] & (1u << (bit % 8)))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::shared_ptr<const Page> readPage(uint32_t b, const PageRef& ref) {
+    pageReads_.inc();
+    auto buffer = device_.makeIOBuffer(pageSize_);
+    if (!device_.read(slotOffset(ref.slot), pageSize_, buffer.data())) {
+      ioErrors_.inc();
+      return nullptr;
+    }
+    PageHeader header;
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    // the page may have been freed and reused after we looked it up
+    if (header.pageId != ref.pageId || header.bucket != b ||
+        header.numEntries > entriesPerPage_) {
+      return nullptr;
+    }
+    const size_t dataSize = header.numEntries * sizeof(Entry);
+    const auto* data = buffer.data() + sizeof(PageHeader);
+    if (checksum(BufferView{dataSize, data}) != header.checksum) {
+      ioErrors_.inc();
+      return nullptr;
+    }
+    auto page = std::make_shared<Page>();
+    page->entries.resize(header.numEntries);
+    std::memcpy(page->entries.data(), data, dataSize);
+
+    auto& shard = getCacheShard(ref.pageId);
+    std::lock_guard<TimedMutex> l{shard.mutex};
+    shard.pages.set(ref.pageId, page);
+    return page;
+  }
+
+  CacheShard& getCacheShard(uint64_t pageId) const {
+    return *cacheShards_[pageId % kNumCacheShards];
+  }
+
+  std::shared_ptr<const Page> getCachedPage(uint64_t pageId) {
+    auto& shard = getCacheShard(pageId);
+    std::lock_guard<TimedMutex> l{shard.mutex};
+    auto it = shard.pages.find(pageId);
+    if (it == shard.pages.end()) {
+      return nullptr;
+    }
+    pageCacheHits_.inc();
+    return it->second;
+  }
+
+  void dropCachedPage(uint64_t pageId) {
+    auto& shard = getCacheShard(pageId);
+    std::lock_guard<TimedMutex> l{shard.mutex};
+    shard.pages.erase(pageId);
+  }
+
+  std::optional<uint32_t> allocSlot() {
+    std::lock_guard<TimedMutex> l{slotMutex_};
+    if (freeSlots_.empty()) {
+      return std::nullopt;
+    }
+    auto slot = freeSlots_.back();
+    freeSlots_.pop_back();
+    return slot;
+  }
+
+  Device& device_;
+  const uint64_t baseOffset_{};
+  const uint32_t pageSize_{};
+  const uint32_t entriesPerPage_{};
+  const uint32_t filterBytes_{};
+  const uint64_t maxResidentBytes_{};
+
+  std::unique_ptr<BucketState[]> buckets_;
+
+  mutable TimedMutex slotMutex_;
+  std::vector<uint32_t> freeSlots_;
+  std::atomic<uint64_t> nextPageId_{1};
+
+  std::vector<std::unique_ptr<CacheShard>> cacheShards_;
+
+  AtomicCounter summaryBytes_;
+  mutable AtomicCounter pageReads_;
+  mutable AtomicCounter pageCacheHits_;
+  mutable AtomicCounter pageWrites_;
+  mutable AtomicCounter filterFalsePositives_;
+  mutable AtomicCounter ioErrors_;
+};
+
+const Index::FlashConfig& Index::FlashConfig::validate() const {
+  if (!device) {
+    throw std::invalid_argument("flash index requires a device");
+  }
+  if (pageSize == 0 || pageSize % device->getIOAlignmentSize() != 0 ||
+      baseOffset % device->getIOAlignmentSize() != 0) {
+    throw std::invalid_argument(folly::sformat(
+        "flash index page size {} and offset {} must be aligned to {}",
+        pageSize, baseOffset, device->getIOAlignmentSize()));
+  }
+  if (pageSize <= sizeof(FlashStore::Entry) * 2) {
+    throw std::invalid_argument(
+        folly::sformat("flash index page size {} is too small", pageSize));
+  }
+  if (size < pageSize || baseOffset + size > device->getSize()) {
+    throw std::invalid_argument(folly::sformat(
+        "invalid flash index range. offset: {}, size: {}, device size: {}",
+        baseOffset, size, device->getSize()));
+  }
+  if (dramBudget == 0) {
+    throw std::invalid_argument("flash index DRAM budget must be > 0");
+  }
+  return *this;
+}
+
+Index::Index() = default;
+
+Index::Index(const FlashConfig& flashConfig) {
+  if (flashConfig.enabled()) {
+    flash_ = std::make_unique<FlashStore>(flashConfig.validate());
+    spillThread_ = std::make_unique<NavyThread>("index_spill");
+  }
+}
+
+Index::~Index() {
+  if (spillThread_) {
+    spillThread_->drain();
+    spillThread_.reset();
+  }
+}
+
+template <typename Lock>
+Index::Map::iterator Index::findForUpdate(uint64_t key, Lock& lock) {
+  auto& map = getMap(key);
+  const auto sk = subkey(key);
+  auto it = map.find(sk);
+  if (!flash_) {
+    return it;
+  }
+
+  const auto b = bucket(key);
+  flash_->markAccessed(b);
+  while (true) {
+    if (it != map.end()) {
+      return isTombstone(it->second) ? map.end() : it;
+    }
+    ItemRecord record;
+    bool relocked = false;
+    const auto res = flash_->find(b, sk, lock, record, relocked);
+    if (relocked) {
+      // DRAM entry inserted while the lock was released takes precedence
+      it = map.find(sk);
+      if (it != map.end()) {
+        continue;
+      }
+    }
+    if (res == FlashStore::FindRes::kRetry) {
+      continue;
+    }
+    if (res == FlashStore::FindRes::kNotFound) {
+      return map.end();
+    }
+    // keep the entry in DRAM until the bucket is written out again
+    residentEntries_.inc();
+    return map.try_emplace(sk, record).first;
+  }
+}
+
+template <typename Lock>
+std::optional<Index::ItemRecord> Index::findRecord(uint64_t key,
+                                                   Lock& lock) const {
+  const auto& map = getMap(key);
+  const auto sk = subkey(key);
+  while (true) {
+    auto it = map.find(sk);
+    if (it != map.end()) {
+      if (flash_ && isTombstone(it->second)) {
+        return std::nullopt;
+      }
+      return it->second;
+    }
+    if (!flash_) {
+      return std::nullopt;
+    }
+    ItemRecord record;
+    bool relocked = false;
+    const auto res = flash_->find(bucket(key), sk, lock, record, relocked);
+    if ((relocked && map.count(sk)) || res == FlashStore::FindRes::kRetry) {
+      continue;
+    }
+    if (res == FlashStore::FindRes::kNotFound) {
+      return std::nullopt;
+    }
+    return record;
+  }
+}
+
+void Index::eraseEntry(uint64_t key, Map::iterator it) {
+  if (flash_ && flash_->mayContain(bucket(key), subkey(key))) {
+    it.value() = ItemRecord{kTombstoneAddress};
+    return;
+  }
+  getMap(key).erase(it);
+  if (flash_) {
+    residentEntries_.dec();
+  }
+}
+
 void Index::setHits(uint64_t key, uint8_t currentHits, uint8_t totalHits) {
   auto& map = getMap(key);
-  auto lock = std::lock_guard{getMutex(key)};
+  auto lock = lockExclusive(key);
 
-  auto it = map.find(subkey(key));
+  auto it = findForUpdate(key, lock);
   if (it != map.end()) {
     it.value().currentHits = currentHits;
     it.value().totalHits = totalHits;
@@ -47,27 +570,28 @@ void Index::setHits(uint64_t key, uint8_t currentHits, uint8_t totalHits) {
 Index::LookupResult Index::lookup(uint64_t key) {
   LookupResult lr;
   auto& map = getMap(key);
-  auto lock = std::lock_guard{getMutex(key)};
+  {
+    auto lock = lockExclusive(key);
 
-  auto it = map.find(subkey(key));
-  if (it != map.end()) {
-    lr.found_ = true;
-    lr.record_ = it->second;
-    it.value().totalHits = safeInc(lr.record_.totalHits);
-    it.value().currentHits = safeInc(lr.record_.currentHits);
+    auto it = findForUpdate(key, lock);
+    if (it != map.end()) {
+      lr.found_ = true;
+      lr.record_ = it->second;
+      it.value().totalHits = safeInc(lr.record_.totalHits);
+      it.value().currentHits = safeInc(lr.record_.currentHits);
+    }
   }
+  maybeScheduleSpill();
   return lr;
 }
 
 Index::LookupResult Index::peek(uint64_t key) const {
   LookupResult lr;
-  const auto& map = getMap(key);
-  auto lock = std::shared_lock{getMutex(key)};
+  auto lock = lockShared(key);
 
-  auto it = map.find(subkey(key));
-  if (it != map.end()) {
+  if (auto record = findRecord(key, lock)) {
     lr.found_ = true;
-    lr.record_ = it->second;
+    lr.record_ = *record;
   }
   return lr;
 }
@@ -77,20 +601,30 @@ Index::LookupResult Index::insert(uint64_t key,
                                   uint16_t sizeHint) {
   LookupResult lr;
   auto& map = getMap(key);
-  auto lock = std::lock_guard{getMutex(key)};
-  auto it = map.find(subkey(key));
-  if (it != map.end()) {
-    lr.found_ = true;
-    lr.record_ = it->second;
-    trackRemove(it->second.totalHits);
-    // tsl::sparse_map's `it->second` is immutable, while it.value() is mutable
-    it.value().address = address;
-    it.value().currentHits = 0;
-    it.value().totalHits = 0;
-    it.value().sizeHint = sizeHint;
-  } else {
-    map.try_emplace(key, address, sizeHint);
+  {
+    auto lock = lockExclusive(key);
+    auto it = findForUpdate(key, lock);
+    if (it != map.end()) {
+      lr.found_ = true;
+      lr.record_ = it->second;
+      trackRemove(it->second.totalHits);
+      // tsl::sparse_map's `it->second` is immutable, while it.value() is
+      // mutable
+      it.value().address = address;
+      it.value().currentHits = 0;
+      it.value().totalHits = 0;
+      it.value().sizeHint = sizeHint;
+    } else if (flash_) {
+      // overwrites a tombstone if there is one
+      if (map.insert_or_assign(subkey(key), ItemRecord{address, sizeHint})
+              .second) {
+        residentEntries_.inc();
+      }
+    } else {
+      map.try_emplace(key, address, sizeHint);
+    }
   }
+  maybeScheduleSpill();
   return lr;
 }
 
@@ -98,9 +632,9 @@ bool Index::replaceIfMatch(uint64_t key,
                            uint32_t newAddress,
                            uint32_t oldAddress) {
   auto& map = getMap(key);
-  auto lock = std::lock_guard{getMutex(key)};
+  auto lock = lockExclusive(key);
 
-  auto it = map.find(subkey(key));
+  auto it = findForUpdate(key, lock);
   if (it != map.end() && it->second.address == oldAddress) {
     // tsl::sparse_map's `it->second` is immutable, while it.value() is mutable
     it.value().address = newAddress;
@@ -120,27 +654,27 @@ void Index::trackRemove(uint8_t totalHits) {
 Index::LookupResult Index::remove(uint64_t key) {
   LookupResult lr;
   auto& map = getMap(key);
-  auto lock = std::lock_guard{getMutex(key)};
+  auto lock = lockExclusive(key);
 
-  auto it = map.find(subkey(key));
+  auto it = findForUpdate(key, lock);
   if (it != map.end()) {
     lr.found_ = true;
     lr.record_ = it->second;
 
     trackRemove(it->second.totalHits);
-    map.erase(it);
+    eraseEntry(key, it);
   }
   return lr;
 }
 
 bool Index::removeIfMatch(uint64_t key, uint32_t address) {
   auto& map = getMap(key);
-  auto lock = std::lock_guard{getMutex(key)};
+  auto lock = lockExclusive(key);
 
-  auto it = map.find(subkey(key));
+  auto it = findForUpdate(key, lock);
   if (it != map.end() && it->second.address == address) {
     trackRemove(it->second.totalHits);
-    map.erase(it);
+    eraseEntry(key, it);
     return true;
   }
   return false;
@@ -150,8 +684,12 @@ void Index::reset() {
   for (uint32_t i = 0; i < kNumBuckets; i++) {
     auto lock = std::lock_guard{getMutexOfBucket(i)};
     buckets_[i].clear();
+    if (flash_) {
+      flash_->replaceRun(i, FlashStore::Run{});
+    }
   }
   unAccessedItems_.set(0);
+  residentEntries_.set(0);
 }
 
 size_t Index::computeSize() const {
@@ -159,16 +697,136 @@ size_t Index::computeSize() const {
   for (uint32_t i = 0; i < kNumBuckets; i++) {
     auto lock = std::lock_guard{getMutexOfBucket(i)};
     size += buckets_[i].size();
+    if (flash_) {
+      size += flash_->getRun(i).numEntries;
+    }
   }
   return size;
 }
 
+uint32_t Index::spillColdBuckets() {
+  if (!flash_) {
+    return 0;
+  }
+  std::lock_guard<folly::fibers::TimedMutex> guard{spillMutex_};
+  uint32_t numSpilled = 0;
+  // CLOCK over the buckets: the first turn of the hand may only clear the
+  // access bits.
+  for (uint32_t i = 0;
+       i < 2 * kNumBuckets && flash_->overLowWatermark(residentEntries_.get());
+       i++) {
+    const auto b = spillHand_;
+    spillHand_ = (spillHand_ + 1) % kNumBuckets;
+    if (spillBucket(b)) {
+      numSpilled++;
+    }
+  }
+  return numSpilled;
+}
+
+bool Index::spillBucket(uint32_t b) {
+  using Entry = FlashStore::Entry;
+  std::vector<Entry> dramEntries;
+  std::vector<FlashStore::PageRef> oldPages;
+  uint64_t generation{};
+  {
+    auto lock = std::lock_guard{getMutexOfBucket(b)};
+    if (flash_->testAndClearAccessed(b) || buckets_[b].empty()) {
+      return false;
+    }
+    dramEntries.reserve(buckets_[b].size());
+    for (const auto& [key, record] : buckets_[b]) {
+      dramEntries.push_back(Entry{key, record});
+    }
+    oldPages = flash_->getRun(b).pages;
+    generation = flash_->getGeneration(b);
+    // removes leave tombstones until we are done
+    flash_->setSpilling(b, true);
+  }
+  std::sort(dramEntries.begin(), dramEntries.end(),
+            [](const Entry& l, const Entry& r) { return l.key < r.key; });
+
+  // Merge with the entries on flash without holding the lock. DRAM entries
+  // are newer and tombstones drop the entries on flash.
+  std::optional<FlashStore::Run> run;
+  {
+    std::vector<Entry> merged;
+    bool readOk = true;
+    auto dramIt = dramEntries.begin();
+    auto takeDram = [&merged](const Entry& e) {
+      if (!isTombstone(e.record)) {
+        merged.push_back(e);
+      }
+    };
+    for (const auto& ref : oldPages) {
+      auto page = flash_->loadPage(b, ref);
+      if (!page) {
+        readOk = false;
+        break;
+      }
+      for (const auto& e : page->entries) {
+        while (dramIt != dramEntries.end() && dramIt->key < e.key) {
+          takeDram(*dramIt++);
+        }
+        if (dramIt != dramEntries.end() && dramIt->key == e.key) {
+          takeDram(*dramIt++);
+        } else {
+          merged.push_back(e);
+        }
+      }
+    }
+    if (readOk) {
+      for (; dramIt != dramEntries.end(); ++dramIt) {
+        takeDram(*dramIt);
+      }
+      run.emplace();
+      if (!flash_->writeRun(b, merged, *run)) {
+        run.reset();
+      }
+    }
+  }
+
+  auto lock = std::lock_guard{getMutexOfBucket(b)};
+  flash_->setSpilling(b, false);
+  if (!run || flash_->getGeneration(b) != generation) {
+    if (run) {
+      flash_->freeRun(*run);
+    }
+    spillFailures_.inc();
+    return false;
+  }
+  // Drop the DRAM entries that are on flash now. Ones that changed in the
+  // meantime stay and take precedence.
+  auto& map = buckets_[b];
+  for (const auto& e : dramEntries) {
+    auto it = map.find(e.key);
+    if (it != map.end() &&
+        std::memcmp(&it->second, &e.record, sizeof(ItemRecord)) == 0) {
+      map.erase(it);
+      residentEntries_.dec();
+    }
+  }
+  flash_->replaceRun(b, std::move(*run));
+  bucketsSpilled_.inc();
+  return true;
+}
+
+void Index::maybeScheduleSpill() {
+  if (!flash_ || !flash_->overBudget(residentEntries_.get()) ||
+      spillScheduled_.exchange(true)) {
+    return;
+  }
+  spillThread_->addTaskRemote([this]() {
+    spillColdBuckets();
+    spillScheduled_ = false;
+  });
+}
+
 void Index::persist(RecordWriter& rw) const {
   serialization::IndexBucket bucket;
   for (uint32_t i = 0; i < kNumBuckets; i++) {
     *bucket.bucketId() = i;
-    // Convert index entries to thrift objects
-    for (const auto& [key, record] : buckets_[i]) {
+    auto addEntry = [&bucket](uint32_t key, const ItemRecord& record) {
       serialization::IndexEntry entry;
       entry.key() = key;
       entry.address() = record.address;
@@ -176,6 +834,34 @@ void Index::persist(RecordWriter& rw) const {
       entry.totalHits() = record.totalHits;
       entry.currentHits() = record.currentHits;
       bucket.entries()->push_back(entry);
+    };
+    // Convert index entries to thrift objects
+    if (!flash_) {
+      for (const auto& [key, record] : buckets_[i]) {
+        addEntry(key, record);
+      }
+    } else {
+      // Entries on flash are persisted along with the ones in DRAM, so the
+      // pages don't need to survive the restart.
+      auto lock = std::shared_lock{getMutexOfBucket(i)};
+      for (const auto& [key, record] : buckets_[i]) {
+        if (!isTombstone(record)) {
+          addEntry(key, record);
+        }
+      }
+      for (const auto& ref : flash_->getRun(i).pages) {
+        auto page = flash_->loadPage(i, ref);
+        if (!page) {
+          XLOGF(ERR, "Failed to read index page {} of bucket {}", ref.pageId,
+                i);
+          continue;
+        }
+        for (const auto& e : page->entries) {
+          if (buckets_[i].count(e.key) == 0) {
+            addEntry(e.key, e.record);
+          }
+        }
+      }
     }
     // Serialize bucket then clear contents to reuse memory.
     serializeProto(bucket, rw);
@@ -200,11 +886,26 @@ void Index::recover(RecordReader& rr) {
                                *entry.totalHits(),
                                *entry.currentHits());
     }
+    if (flash_) {
+      // write out as we go so that recovery stays within the DRAM budget
+      residentEntries_.add(bucket.entries()->size());
+      if (flash_->overBudget(residentEntries_.get())) {
+        spillColdBuckets();
+      }
+    }
   }
 }
 
 void Index::getCounters(const CounterVisitor& visitor) const {
   hitsEstimator_.visitQuantileEstimator(visitor, "navy_bc_item_hits");
   visitor("navy_bc_item_removed_with_no_access", unAccessedItems_.get());
+  if (flash_) {
+    visitor("navy_bc_index_dram_entries", residentEntries_.get());
+    visitor("navy_bc_index_buckets_spilled", bucketsSpilled_.get(),
+            CounterVisitor::CounterType::RATE);
+    visitor("navy_bc_index_spill_failures", spillFailures_.get(),
+            CounterVisitor::CounterType::RATE);
+    flash_->getCounters(visitor);
+  }
 }
 } // namespace facebook::cachelib::navy
@@ -21,19 +21,25 @@
 #include <folly/stats/QuantileEstimator.h>
 #include <tsl/sparse_map.h>
 
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <utility>
 
 #include "cachelib/common/AtomicCounter.h"
+#include "cachelib/common/LockProfiler.h"
 #include "cachelib/common/PercentileStats.h"
+#include "cachelib/navy/common/NavyThread.h"
 #include "cachelib/navy/serialization/RecordIO.h"
 
 namespace facebook {
 namespace cachelib {
 namespace navy {
+class Device;
+
 // folly::SharedMutex is write priority by default
 using SharedMutex =
     folly::fibers::TimedRWMutexWritePriority<folly::fibers::Baton>;
@@ -41,14 +47,46 @@ using SharedMutex =
 // NVM index: map from key to value. Under the hood, stores key hash to value
 // map. If collision happened, returns undefined value (last inserted actually,
 // but we do not want people to rely on that).
+//
+// By default the whole index lives in DRAM. With a FlashConfig, buckets that
+// were not accessed recently are written to flash as sorted pages once the
+// entries in DRAM exceed the budget. Only a summary (first key and a bloom
+// filter of every page) stays in DRAM, along with a small cache of recently
+// read pages, so that looking up a key costs at most one page read. Entries
+// read from flash on access are kept in DRAM until the bucket is written out
+// again.
 class Index {
  public:
   // Specify 1 second window size for quantile estimator.
   static constexpr std::chrono::seconds kQuantileWindowSize{1};
 
-  Index() = default;
+  // Config to keep the cold part of the index on flash.
+  struct FlashConfig {
+    // device and the range on it where the index pages are written
+    Device* device{};
+    uint64_t baseOffset{};
+    uint64_t size{};
+    // DRAM for the index. 1/8th of it caches pages read from flash, the rest
+    // holds the entries in DRAM and the summary of the pages on flash.
+    uint64_t dramBudget{};
+    // size of an index page. Must be a multiple of the device IO alignment.
+    uint32_t pageSize{4096};
+
+    bool enabled() const { return device != nullptr; }
+
+    // Checks invariants. Throws exception if failed.
+    const FlashConfig& validate() const;
+  };
+
+  Index();
+  // @param flashConfig  config to keep part of the index on flash. The whole
+  //                     index stays in DRAM if it is not enabled.
+  //
+  // @throw std::invalid_argument on bad config
+  explicit Index(const FlashConfig& flashConfig);
   Index(const Index&) = delete;
   Index& operator=(const Index&) = delete;
+  ~Index();
 
   // Writes index to a Thrift object one bucket at a time and passes each bucket
   // to @persistCb. The reason for this is because the index can be very large
@@ -151,18 +189,40 @@ class Index {
   // Resets all the buckets to the initial state.
   void reset();
 
-  // Walks buckets and computes total index entry count
+  // Walks buckets and computes total index entry count. With part of the
+  // index on flash this is an estimate: an entry can be both in DRAM and on
+  // flash until its bucket is written out again.
   size_t computeSize() const;
 
+  // Writes cold buckets to flash until the entries in DRAM fit the budget.
+  // This runs in the background when the budget is exceeded.
+  //
+  // @return number of buckets written to flash
+  uint32_t spillColdBuckets();
+
   // Exports index stats via CounterVisitor.
   void getCounters(const CounterVisitor& visitor) const;
 
+  // Records the acquisitions of the bucket locks by lookups and updates in
+  // the stats. Must be set before the index is used.
+  void setLockStats(LockStats* stats) noexcept { lockStats_ = stats; }
+
  private:
+  class FlashStore;
+
   static constexpr uint32_t kNumBuckets{64 * 1024};
   static constexpr uint32_t kNumMutexes{1024};
 
   using Map = tsl::sparse_map<uint32_t, ItemRecord>;
 
+  // Marks an entry removed from DRAM that may still be on flash. BlockCache
+  // stores the end offset of a slot, which is never 0.
+  static constexpr uint32_t kTombstoneAddress{0};
+
+  static bool isTombstone(const ItemRecord& record) {
+    return record.address == kTombstoneAddress;
+  }
+
   static uint32_t bucket(uint64_t hash) {
     return (hash >> 32) & (kNumBuckets - 1);
   }
@@ -179,6 +239,16 @@ class Index {
     return getMutexOfBucket(b);
   }
 
+  std::unique_lock<SharedMutex> lockExclusive(uint64_t hash) const {
+    return util::lockProfiled<std::unique_lock<SharedMutex>>(getMutex(hash),
+                                                             lockStats_);
+  }
+
+  std::shared_lock<SharedMutex> lockShared(uint64_t hash) const {
+    return util::lockProfiled<std::shared_lock<SharedMutex>>(getMutex(hash),
+                                                             lockStats_);
+  }
+
   Map& getMap(uint64_t hash) const {
     auto b = bucket(hash);
     return buckets_[b];
@@ -186,14 +256,51 @@ class Index {
 
   void trackRemove(uint8_t totalHits);
 
+  // Finds the DRAM entry of @key. If the key is only on flash, the entry is
+  // read into DRAM first. @lock of the bucket is released while reading.
+  //
+  // @return iterator of the DRAM map, end() if the key is not in the index
+  template <typename Lock>
+  Map::iterator findForUpdate(uint64_t key, Lock& lock);
+
+  // Same as findForUpdate but leaves the DRAM map as is.
+  template <typename Lock>
+  std::optional<ItemRecord> findRecord(uint64_t key, Lock& lock) const;
+
+  // Removes the DRAM entry @it of @key. Leaves a tombstone behind if the key
+  // can also be on flash.
+  void eraseEntry(uint64_t key, Map::iterator it);
+
+  // Writes the entries of bucket @b to flash and drops them from DRAM.
+  //
+  // @return true if the bucket was written
+  bool spillBucket(uint32_t b);
+
+  // Schedules spillColdBuckets if the entries in DRAM exceed the budget.
+  void maybeScheduleSpill();
+
   // Experiments with 64 byte alignment didn't show any throughput test
   // performance improvement.
   std::unique_ptr<SharedMutex[]> mutex_{new SharedMutex[kNumMutexes]};
   std::unique_ptr<Map[]> buckets_{new Map[kNumBuckets]};
+  // stats of the acquisitions of the bucket locks, if profiled
+  LockStats* lockStats_{nullptr};
 
   mutable util::PercentileStats hitsEstimator_{kQuantileWindowSize};
   mutable AtomicCounter unAccessedItems_;
 
+  // Only set with a FlashConfig. residentEntries_ counts the entries in DRAM
+  // in that case.
+  std::unique_ptr<FlashStore> flash_;
+  AtomicCounter residentEntries_;
+  AtomicCounter bucketsSpilled_;
+  AtomicCounter spillFailures_;
+  std::atomic<bool> spillScheduled_{false};
+  // serializes spillColdBuckets and protects spillHand_
+  folly::fibers::TimedMutex spillMutex_;
+  uint32_t spillHand_{0};
+  std::unique_ptr<NavyThread> spillThread_;
+
   static_assert((kNumMutexes & (kNumMutexes - 1)) == 0,
                 "number of mutexes must be power of two");
 };
@@ -37,7 +37,7 @@ LruPolicy::LruPolicy(uint32_t expectedNumRegions)
 void LruPolicy::touch(RegionId rid) {
   XDCHECK(rid.valid());
   auto i = rid.index();
-  std::lock_guard<TimedMutex> lock{mutex_};
+  auto lock = lockExclusive();
   if (i >= array_.size()) {
     array_.resize(i + 1);
   }
@@ -53,7 +53,7 @@ void LruPolicy::track(const Region& region) {
   auto rid = region.id();
   XDCHECK(rid.valid());
   auto i = rid.index();
-  std::lock_guard<TimedMutex> lock{mutex_};
+  auto lock = lockExclusive();
   if (i >= array_.size()) {
     array_.resize(i + 1);
   }
@@ -72,7 +72,7 @@ RegionId LruPolicy::evict() {
   uint32_t hits{0};
 
   {
-    std::lock_guard<TimedMutex> lock{mutex_};
+    auto lock = lockExclusive();
     if (tail_ == kInvalidIndex) {
       return RegionId{};
     }
@@ -90,7 +90,7 @@ RegionId LruPolicy::evict() {
 }
 
 void LruPolicy::reset() {
-  std::lock_guard<TimedMutex> lock{mutex_};
+  auto lock = lockExclusive();
   array_.clear();
   head_ = kInvalidIndex;
   tail_ = kInvalidIndex;
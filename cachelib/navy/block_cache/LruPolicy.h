@@ -66,6 +66,8 @@ class LruPolicy final : public EvictionPolicy {
   // Recovers from previously persisted metadata associated with LRU policy.
   void recover(RecordReader& rr) override;
 
+  void setLockStats(LockStats* stats) override { lockStats_ = stats; }
+
  private:
   static constexpr uint32_t kInvalidIndex = 0xffffffffu;
 
@@ -95,6 +97,11 @@ class LruPolicy final : public EvictionPolicy {
   void linkAtHead(uint32_t i);
   void linkAtTail(uint32_t i);
   void dump(uint32_t n) const;
+
+  std::unique_lock<TimedMutex> lockExclusive() const {
+    return util::lockProfiled<std::unique_lock<TimedMutex>>(mutex_,
+                                                            lockStats_);
+  }
   void dumpList(const char* tag,
                 uint32_t n,
                 uint32_t first,
@@ -106,6 +113,8 @@ class LruPolicy final : public EvictionPolicy {
   uint32_t head_{kInvalidIndex};
   uint32_t tail_{kInvalidIndex};
   mutable TimedMutex mutex_;
+  // stats of the acquisitions of mutex_, if profiled
+  LockStats* lockStats_{nullptr};
 
   // various counters that are populated when we evict a region.
   mutable util::PercentileStats secSinceInsertionEstimator_;
@@ -109,6 +109,9 @@ void RegionManager::reset() {
   }
   seqNumber_.store(0, std::memory_order_release);
 
+  // None of the regions hold valid data anymore
+  device_.discard(baseOffset_, getSize(), false /* rateLimited */);
+
   // Reset eviction policy
   resetEvictionPolicy();
 }
@@ -349,6 +352,11 @@ void RegionManager::doReclaim() {
       doEviction(rid, buffer.view());
     }
   }
+  // Nothing in the region is reachable anymore. Discard it so that the device
+  // does not relocate the stale data until the region is written again.
+  if (region.getLastEntryEndOffset() > 0) {
+    device_.discard(physicalOffset(RelAddress{rid, 0}), regionSize_);
+  }
   releaseEvictedRegion(rid, startTime);
   INJECT_PAUSE(pause_reclaim_done);
 }
@@ -228,6 +228,12 @@ class RegionManager {
   // Exports RegionManager stats via CounterVisitor.
   void getCounters(const CounterVisitor& visitor) const;
 
+  // Records the acquisitions of the eviction policy lock in the stats, see
+  // EvictionPolicy::setLockStats.
+  void setEvictionPolicyLockStats(LockStats* stats) {
+    policy_->setLockStats(stats);
+  }
+
   // Opens a region for reading and returns the region descriptor.
   //
   // @param rid         region ID
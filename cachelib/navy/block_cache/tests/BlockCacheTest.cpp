@@ -14,11 +14,15 @@
  * limitations under the License.
  */
 
+#include <folly/Conv.h>
 #include <folly/File.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cstring>
 #include <future>
+#include <random>
 #include <vector>
 
 #include "cachelib/allocator/nvmcache/NavyConfig.h"
@@ -1916,6 +1920,166 @@ TEST(BlockCache, HitsReinsertionPolicy) {
   }
 }
 
+TEST(BlockCache, PromotionOnReclaim) {
+  std::vector<uint32_t> hits(4);
+  auto policy = std::make_unique<NiceMock<MockPolicy>>(&hits);
+  auto device = createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+  auto ex = makeJobScheduler();
+  auto config = makeConfig(*ex, std::move(policy), *device);
+  config.reinsertionConfig = makeHitsReinsertionConfig(1);
+  config.reinsertionConfig.enablePromotion(1);
+
+  // the first accessed key is taken by DRAM, the second one is refused
+  std::string acceptedKey;
+  std::vector<std::string> offeredKeys;
+  config.promotionCb = [&](HashedKey hk,
+                           BufferView /* value */,
+                           folly::FunctionRef<bool()> isCurrent) {
+    EXPECT_TRUE(isCurrent());
+    offeredKeys.push_back(hk.key().str());
+    return hk.key() == acceptedKey;
+  };
+  auto engine = makeEngine(std::move(config));
+  auto driver = makeDriver(std::move(engine), std::move(ex));
+
+  folly::fibers::TimedMutex mutex;
+  bool reclaimStarted = false;
+  size_t numCleanRegions = 0;
+  util::ConditionVariable cv;
+
+  ENABLE_INJECT_PAUSE_IN_SCOPE();
+
+  // Keep the insertions from racing with the reinsertions for the clean
+  // region, same as in HitsReinsertionPolicy
+  injectPauseSet("pause_blockcache_clean_alloc_locked", [&]() {
+    std::unique_lock<folly::fibers::TimedMutex> lk(mutex);
+    XDCHECK_GT(numCleanRegions, 0u);
+    numCleanRegions--;
+  });
+
+  injectPauseSet("pause_blockcache_clean_free_locked", [&]() {
+    std::unique_lock<folly::fibers::TimedMutex> lk(mutex);
+    if (numCleanRegions++ == 0u) {
+      cv.notifyAll();
+    }
+    reclaimStarted = true;
+  });
+
+  injectPauseSet("pause_blockcache_insert_entry", [&]() {
+    std::unique_lock<folly::fibers::TimedMutex> lk(mutex);
+    if (numCleanRegions == 0u && reclaimStarted) {
+      cv.wait(lk);
+    }
+  });
+
+  BufferGen bg;
+  std::vector<CacheEntry> log;
+  for (size_t j = 0; j < 3; j++) {
+    for (size_t i = 0; i < 4; i++) {
+      CacheEntry e{bg.gen(8), bg.gen(800)};
+      EXPECT_EQ(Status::Ok, driver->insertAsync(e.key(), e.value(), nullptr));
+      log.push_back(std::move(e));
+    }
+    driver->flush();
+  }
+  acceptedKey = log[0].key().key().str();
+
+  // Access the first two keys of the first region
+  for (size_t i = 0; i < 2; i++) {
+    Buffer value;
+    EXPECT_EQ(Status::Ok, driver->lookup(log[i].key(), value));
+  }
+
+  // Trigger the reclaim of the first region
+  {
+    CacheEntry e{bg.gen(8), bg.gen(800)};
+    EXPECT_EQ(Status::Ok, driver->insertAsync(e.key(), e.value(), nullptr));
+    log.push_back(std::move(e));
+  }
+  driver->drain();
+
+  // Only the accessed keys were offered to DRAM. The region is reclaimed
+  // from its last entry to its first.
+  EXPECT_EQ((std::vector<std::string>{log[1].key().key().str(),
+                                      log[0].key().key().str()}),
+            offeredKeys);
+
+  // The promoted key is no longer on flash, the refused one is reinserted
+  {
+    Buffer value;
+    EXPECT_EQ(Status::NotFound, driver->lookup(log[0].key(), value));
+    EXPECT_EQ(Status::Ok, driver->lookup(log[1].key(), value));
+    EXPECT_EQ(log[1].value(), value.view());
+  }
+
+  driver->getCounters({[](folly::StringPiece name, double count) {
+    if (name == "navy_bc_promotions") {
+      EXPECT_EQ(1, count);
+    }
+    if (name == "navy_bc_promotion_rejects") {
+      EXPECT_EQ(1, count);
+    }
+    if (name == "navy_bc_promotion_throttled") {
+      EXPECT_EQ(0, count);
+    }
+  }});
+}
+
+// A run whose values are never populated, as in the metadata-only simulation
+// of cachebench, gets the same hits and misses on the sparse device as a run
+// with real values on a regular device, for values from a fraction of a page
+// to almost a region.
+TEST(BlockCache, SparseDeviceHitParity) {
+  auto run = [](bool metadataOnly, uint32_t minSize, uint32_t maxSize) {
+    std::vector<uint32_t> hits(4);
+    auto policy = std::make_unique<NiceMock<MockPolicy>>(&hits);
+    auto device =
+        metadataOnly
+            ? createSparseMemoryDevice(kDeviceSize, nullptr /* encryption */)
+            : createMemoryDevice(kDeviceSize, nullptr /* encryption */);
+    auto ex = makeJobScheduler();
+    auto config = makeConfig(*ex, std::move(policy), *device);
+    config.checksum = true;
+    config.reinsertionConfig = makeHitsReinsertionConfig(1);
+    auto engine = makeEngine(std::move(config));
+    auto driver = makeDriver(std::move(engine), std::move(ex));
+
+    // about three times as many keys as fit in the cache
+    const size_t numKeys =
+        std::max<size_t>(4, 3 * kDeviceSize / (minSize + maxSize));
+    const size_t numOps = std::max<size_t>(2000, 10 * numKeys);
+    BufferGen bg;
+    std::minstd_rand rng{7};
+    std::vector<Status> statuses;
+    for (size_t i = 0; i < numOps; i++) {
+      const auto key = folly::to<std::string>("key_", rng() % numKeys);
+      Buffer value;
+      statuses.push_back(driver->lookup(HashedKey{key}, value));
+      if (statuses.back() == Status::NotFound) {
+        value = bg.gen(minSize, maxSize);
+        if (metadataOnly) {
+          std::memset(value.data(), 0, value.size());
+        }
+        EXPECT_EQ(Status::Ok, driver->insert(HashedKey{key}, value.view()));
+      }
+    }
+    return statuses;
+  };
+
+  const std::vector<std::pair<uint32_t, uint32_t>> sizeRanges = {
+      {10, 100}, {300, 1200}, {2000, 6000}, {6000, 15000}};
+  for (const auto& [minSize, maxSize] : sizeRanges) {
+    SCOPED_TRACE(folly::sformat("value sizes [{}, {})", minSize, maxSize));
+    const auto full = run(false /* metadataOnly */, minSize, maxSize);
+    EXPECT_EQ(full, run(true /* metadataOnly */, minSize, maxSize));
+    // the workload has both hits and misses
+    const auto numHits = static_cast<size_t>(
+        std::count(full.begin(), full.end(), Status::Ok));
+    EXPECT_GT(numHits, 0);
+    EXPECT_LT(numHits, full.size());
+  }
+}
+
 TEST(BlockCache, HitsReinsertionPolicyRecovery) {
   std::vector<uint32_t> hits(4);
   uint32_t ioAlignSize = 4096;
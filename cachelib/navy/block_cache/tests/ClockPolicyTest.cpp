@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "cachelib/navy/block_cache/ClockPolicy.h"
+#include "cachelib/navy/testing/Callbacks.h"
+
+namespace facebook::cachelib::navy::tests {
+namespace {
+const RegionId kNone{};
+const RegionId kR0{0};
+const RegionId kR1{1};
+const RegionId kR2{2};
+const RegionId kR3{3};
+const Region kRegion0{RegionId{0}, 100};
+const Region kRegion1{RegionId{1}, 100};
+const Region kRegion2{RegionId{2}, 100};
+const Region kRegion3{RegionId{3}, 100};
+} // namespace
+
+TEST(EvictionPolicy, ClockOrder) {
+  ClockPolicy policy{4};
+  policy.track(kRegion0);
+  EXPECT_EQ(kR0, policy.evict());
+  EXPECT_EQ(kNone, policy.evict());
+
+  // a referenced region is still evicted when it is the only one
+  policy.track(kRegion0);
+  policy.touch(kR0);
+  EXPECT_EQ(kR0, policy.evict());
+  EXPECT_EQ(kNone, policy.evict());
+
+  // without hits CLOCK is FIFO
+  policy.track(kRegion0);
+  policy.track(kRegion1);
+  EXPECT_EQ(kR0, policy.evict());
+  EXPECT_EQ(kR1, policy.evict());
+  EXPECT_EQ(kNone, policy.evict());
+
+  // R0 gets a second chance
+  policy.track(kRegion0);
+  policy.track(kRegion1);
+  policy.touch(kR0);
+  EXPECT_EQ(kR1, policy.evict());
+  EXPECT_EQ(kR0, policy.evict());
+  EXPECT_EQ(kNone, policy.evict());
+
+  policy.track(kRegion0);
+  policy.track(kRegion1);
+  policy.track(kRegion2);
+  policy.track(kRegion3);
+  policy.touch(kR1);
+  policy.touch(kR2);
+  // R0 is the oldest and not referenced
+  EXPECT_EQ(kR0, policy.evict());
+  // R1 and R2 lose their bit, R3 is evicted
+  EXPECT_EQ(kR3, policy.evict());
+  policy.touch(kR2);
+  EXPECT_EQ(kR1, policy.evict());
+  EXPECT_EQ(kR2, policy.evict());
+  EXPECT_EQ(kNone, policy.evict());
+
+  // touching evicted or untracked regions should cause no harm
+  policy.touch(kR0);
+  policy.touch(RegionId{100});
+  EXPECT_EQ(kNone, policy.evict());
+  policy.track(kRegion0);
+  policy.track(kRegion1);
+  EXPECT_EQ(kR0, policy.evict());
+}
+
+TEST(EvictionPolicy, ClockRetrack) {
+  ClockPolicy policy{4};
+  policy.track(kRegion0);
+  policy.track(kRegion1);
+  policy.touch(kR0);
+  // tracking again clears the hits and keeps the position
+  policy.track(kRegion0);
+  EXPECT_EQ(kR0, policy.evict());
+  EXPECT_EQ(kR1, policy.evict());
+  EXPECT_EQ(kNone, policy.evict());
+
+  EXPECT_THROW(policy.track(Region{RegionId{4}, 100}), std::out_of_range);
+}
+
+TEST(EvictionPolicy, ClockReset) {
+  ClockPolicy policy{4};
+  policy.track(kRegion1);
+  policy.track(kRegion2);
+  policy.track(kRegion3);
+  policy.touch(kR1);
+  policy.touch(kR3);
+  policy.reset();
+  EXPECT_EQ(kNone, policy.evict());
+
+  // no reference bits survive the reset
+  policy.track(kRegion3);
+  policy.track(kRegion1);
+  EXPECT_EQ(kR3, policy.evict());
+  EXPECT_EQ(kR1, policy.evict());
+}
+
+TEST(EvictionPolicy, ClockSweepCounters) {
+  ClockPolicy policy{4};
+  policy.track(kRegion0);
+  policy.track(kRegion1);
+  policy.track(kRegion2);
+  policy.touch(kR0);
+  policy.touch(kR1);
+  EXPECT_EQ(kR2, policy.evict());
+
+  MockCounterVisitor visitor;
+  EXPECT_CALL(visitor, call(testing::_, testing::_))
+      .WillRepeatedly(testing::Return());
+  EXPECT_CALL(visitor, call(strPiece("navy_bc_clock_sweep_steps"), 3));
+  EXPECT_CALL(visitor, call(strPiece("navy_bc_clock_second_chances"), 2));
+  policy.getCounters({toCallback(visitor)});
+}
+
+TEST(EvictionPolicy, ClockConcurrentTouch) {
+  constexpr uint32_t kNumRegions = 64;
+  ClockPolicy policy{kNumRegions};
+  for (uint32_t i = 0; i < kNumRegions; i++) {
+    policy.track(Region{RegionId{i}, 100});
+  }
+
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < 4; t++) {
+    threads.emplace_back([&policy] {
+      for (uint32_t i = 0; i < 100000; i++) {
+        policy.touch(RegionId{i % kNumRegions});
+      }
+    });
+  }
+
+  // the sweep always terminates and evicts every region exactly once
+  std::vector<bool> evicted(kNumRegions, false);
+  for (uint32_t i = 0; i < kNumRegions; i++) {
+    auto rid = policy.evict();
+    ASSERT_TRUE(rid.valid());
+    ASSERT_FALSE(evicted[rid.index()]);
+    evicted[rid.index()] = true;
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  EXPECT_EQ(kNone, policy.evict());
+}
+} // namespace facebook::cachelib::navy::tests
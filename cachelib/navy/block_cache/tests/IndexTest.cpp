@@ -19,8 +19,42 @@
 #include <thread>
 
 #include "cachelib/navy/block_cache/Index.h"
+#include "cachelib/navy/common/Device.h"
 
 namespace facebook::cachelib::navy::tests {
+namespace {
+constexpr uint64_t kFlashSize = 16 * 1024 * 1024;
+// the summary of the pages alone exceeds this, so every spill writes out all
+// the buckets that were not accessed since the last one
+constexpr uint64_t kSmallDramBudget = 64 * 1024;
+
+Index::FlashConfig makeFlashConfig(Device& device, uint64_t dramBudget) {
+  Index::FlashConfig config;
+  config.device = &device;
+  config.baseOffset = 0;
+  config.size = kFlashSize;
+  config.dramBudget = dramBudget;
+  config.pageSize = 4096;
+  return config;
+}
+
+double getCounter(const Index& index, folly::StringPiece name) {
+  double res = -1;
+  index.getCounters({[&res, name](folly::StringPiece n, double v) {
+    if (n == name) {
+      res = v;
+    }
+  }});
+  return res;
+}
+
+// 16 buckets with 10000 entries each. Address 0 is reserved with the index
+// on flash.
+uint64_t makeKey(uint64_t i) { return (i % 16) << 32 | (i / 16); }
+uint32_t makeAddress(uint64_t i) { return i + 1; }
+constexpr uint64_t kNumKeys = 16 * 10000;
+} // namespace
+
 TEST(Index, Recovery) {
   Index index;
   std::vector<std::pair<uint64_t, uint32_t>> log;
@@ -194,4 +228,197 @@ TEST(Index, ThreadSafe) {
   EXPECT_EQ(200, index.peek(key).currentHits());
 }
 
+TEST(Index, FlashConfigValidation) {
+  auto device = createMemoryDevice(kFlashSize, nullptr /* encryption */);
+  auto config = makeFlashConfig(*device, kSmallDramBudget);
+  EXPECT_NO_THROW(config.validate());
+
+  auto badConfig = config;
+  badConfig.device = nullptr;
+  EXPECT_THROW(badConfig.validate(), std::invalid_argument);
+  badConfig = config;
+  badConfig.pageSize = 1000;
+  EXPECT_THROW(Index{badConfig}, std::invalid_argument);
+  badConfig = config;
+  badConfig.baseOffset = 4096;
+  EXPECT_THROW(Index{badConfig}, std::invalid_argument);
+  badConfig = config;
+  badConfig.dramBudget = 0;
+  EXPECT_THROW(Index{badConfig}, std::invalid_argument);
+
+  // DRAM only index without a device
+  Index index{Index::FlashConfig{}};
+  EXPECT_EQ(0, index.spillColdBuckets());
+}
+
+TEST(Index, FlashSpill) {
+  auto device = createMemoryDevice(kFlashSize, nullptr /* encryption */);
+  Index index{makeFlashConfig(*device, kSmallDramBudget)};
+  for (uint64_t i = 0; i < kNumKeys; i++) {
+    index.insert(makeKey(i), makeAddress(i), 100);
+  }
+  EXPECT_EQ(kNumKeys, index.computeSize());
+
+  index.spillColdBuckets();
+  EXPECT_EQ(0, getCounter(index, "navy_bc_index_dram_entries"));
+  EXPECT_LE(16, getCounter(index, "navy_bc_index_buckets_spilled"));
+  EXPECT_LT(0, getCounter(index, "navy_bc_index_flash_page_writes"));
+  EXPECT_EQ(kNumKeys, index.computeSize());
+
+  for (uint64_t i = 0; i < kNumKeys; i++) {
+    auto res = index.peek(makeKey(i));
+    ASSERT_TRUE(res.found());
+    EXPECT_EQ(makeAddress(i), res.address());
+    EXPECT_EQ(100, res.sizeHint());
+  }
+  EXPECT_LT(0, getCounter(index, "navy_bc_index_flash_page_reads"));
+  EXPECT_EQ(0, getCounter(index, "navy_bc_index_flash_io_errors"));
+  // peek does not bring the entries back to DRAM
+  EXPECT_EQ(0, getCounter(index, "navy_bc_index_dram_entries"));
+
+  // keys that were never inserted are mostly filtered without a page read
+  for (uint64_t i = kNumKeys; i < 2 * kNumKeys; i++) {
+    EXPECT_FALSE(index.lookup(makeKey(i)).found());
+  }
+  EXPECT_GT(kNumKeys / 10,
+            getCounter(index, "navy_bc_index_flash_filter_false_positives"));
+
+  // lookup brings the entry back and keeps counting the hits
+  const auto key = makeKey(42);
+  EXPECT_EQ(makeAddress(42), index.lookup(key).address());
+  EXPECT_EQ(1, index.peek(key).totalHits());
+  EXPECT_EQ(1, getCounter(index, "navy_bc_index_dram_entries"));
+  index.spillColdBuckets();
+  EXPECT_EQ(1, index.peek(key).totalHits());
+}
+
+TEST(Index, FlashUpdates) {
+  auto device = createMemoryDevice(kFlashSize, nullptr /* encryption */);
+  Index index{makeFlashConfig(*device, kSmallDramBudget)};
+  for (uint64_t i = 0; i < kNumKeys; i++) {
+    index.insert(makeKey(i), makeAddress(i), 100);
+  }
+  index.spillColdBuckets();
+  ASSERT_EQ(0, getCounter(index, "navy_bc_index_dram_entries"));
+
+  // remove every other key, overwrite every 3rd and match the rest
+  for (uint64_t i = 0; i < kNumKeys; i++) {
+    const auto key = makeKey(i);
+    if (i % 2 == 0) {
+      EXPECT_TRUE(index.remove(key).found());
+    } else if (i % 3 == 0) {
+      EXPECT_TRUE(index.insert(key, makeAddress(i) + 1, 200).found());
+    } else if (i % 5 == 0) {
+      EXPECT_FALSE(index.removeIfMatch(key, makeAddress(i) + 1));
+      EXPECT_TRUE(index.removeIfMatch(key, makeAddress(i)));
+    } else {
+      EXPECT_FALSE(
+          index.replaceIfMatch(key, makeAddress(i) + 2, makeAddress(i) + 1));
+      EXPECT_TRUE(
+          index.replaceIfMatch(key, makeAddress(i) + 2, makeAddress(i)));
+    }
+  }
+
+  auto check = [&index]() {
+    for (uint64_t i = 0; i < kNumKeys; i++) {
+      auto res = index.peek(makeKey(i));
+      if (i % 2 == 0 || (i % 3 != 0 && i % 5 == 0)) {
+        ASSERT_FALSE(res.found()) << i;
+      } else if (i % 3 == 0) {
+        ASSERT_EQ(makeAddress(i) + 1, res.address()) << i;
+        ASSERT_EQ(200, res.sizeHint()) << i;
+      } else {
+        ASSERT_EQ(makeAddress(i) + 2, res.address()) << i;
+      }
+    }
+  };
+  check();
+  // the updates were done in DRAM, access bits need a turn to clear
+  index.spillColdBuckets();
+  EXPECT_EQ(0, getCounter(index, "navy_bc_index_dram_entries"));
+  check();
+
+  // removed keys can be inserted again
+  index.insert(makeKey(0), 7, 0);
+  EXPECT_EQ(7, index.lookup(makeKey(0)).address());
+
+  index.reset();
+  EXPECT_EQ(0, index.computeSize());
+  EXPECT_FALSE(index.lookup(makeKey(1)).found());
+}
+
+TEST(Index, FlashRecovery) {
+  auto device = createMemoryDevice(2 * kFlashSize, nullptr /* encryption */);
+  Index index{makeFlashConfig(*device, kSmallDramBudget)};
+  for (uint64_t i = 0; i < kNumKeys; i++) {
+    index.insert(makeKey(i), makeAddress(i), 0);
+  }
+  index.spillColdBuckets();
+  // some entries both in DRAM and on flash
+  for (uint64_t i = 0; i < kNumKeys; i += 7) {
+    index.insert(makeKey(i), makeAddress(i) + 1, 0);
+  }
+
+  folly::IOBufQueue ioq;
+  auto rw = createMemoryRecordWriter(ioq);
+  index.persist(*rw);
+  auto expected = [](uint64_t i) {
+    return i % 7 == 0 ? makeAddress(i) + 1 : makeAddress(i);
+  };
+
+  {
+    auto rr = createMemoryRecordReader(ioq);
+    Index newIndex;
+    newIndex.recover(*rr);
+    EXPECT_EQ(kNumKeys, newIndex.computeSize());
+    for (uint64_t i = 0; i < kNumKeys; i++) {
+      ASSERT_EQ(expected(i), newIndex.peek(makeKey(i)).address()) << i;
+    }
+  }
+
+  {
+    // recovering into a flash index writes it out as it goes
+    auto rr = createMemoryRecordReader(ioq);
+    auto config = makeFlashConfig(*device, kSmallDramBudget);
+    config.baseOffset = kFlashSize;
+    Index newIndex{config};
+    newIndex.recover(*rr);
+    EXPECT_GT(kNumKeys, getCounter(newIndex, "navy_bc_index_dram_entries"));
+    for (uint64_t i = 0; i < kNumKeys; i++) {
+      ASSERT_EQ(expected(i), newIndex.peek(makeKey(i)).address()) << i;
+    }
+  }
+}
+
+TEST(Index, FlashConcurrentSpill) {
+  auto device = createMemoryDevice(kFlashSize, nullptr /* encryption */);
+  Index index{makeFlashConfig(*device, kSmallDramBudget)};
+  for (uint64_t i = 0; i < kNumKeys; i++) {
+    index.insert(makeKey(i), makeAddress(i), 0);
+  }
+
+  std::atomic<bool> done{false};
+  std::thread spiller{[&] {
+    while (!done) {
+      index.spillColdBuckets();
+    }
+  }};
+  // every update must be visible right away, no matter where the entry is
+  for (uint32_t round = 1; round <= 3; round++) {
+    for (uint64_t i = 0; i < kNumKeys; i += 3) {
+      const auto key = makeKey(i);
+      ASSERT_EQ(makeAddress(i) + round - 1, index.lookup(key).address()) << i;
+      index.insert(key, makeAddress(i) + round, 0);
+      ASSERT_EQ(makeAddress(i) + round, index.peek(key).address()) << i;
+    }
+  }
+  done = true;
+  spiller.join();
+
+  for (uint64_t i = 0; i < kNumKeys; i++) {
+    const uint32_t expected = i % 3 == 0 ? makeAddress(i) + 3 : makeAddress(i);
+    ASSERT_EQ(expected, index.peek(makeKey(i)).address()) << i;
+  }
+  EXPECT_EQ(0, getCounter(index, "navy_bc_index_flash_io_errors"));
+}
 } // namespace facebook::cachelib::navy::tests
@@ -16,6 +16,7 @@
 
 #include <gtest/gtest.h>
 
+#include <cstring>
 #include <memory>
 #include <vector>
 
@@ -217,6 +218,64 @@ TEST(RegionManager, ReadWrite) {
   EXPECT_EQ(buf.view(), bufReadDirect.view());
 }
 
+TEST(RegionManager, Discard) {
+  constexpr uint64_t kBaseOffset = 1024;
+  constexpr uint32_t kNumRegions = 4;
+  constexpr uint32_t kRegionSize = 4 * 1024;
+
+  auto device = createMemoryDevice(kBaseOffset + kNumRegions * kRegionSize,
+                                   nullptr /* encryption */);
+  device->enableDiscard();
+  RegionEvictCallback evictCb{[](RegionId, BufferView) { return 0; }};
+  RegionCleanupCallback cleanupCb{[](RegionId, BufferView) {}};
+  auto rm = std::make_unique<RegionManager>(
+      kNumRegions, kRegionSize, kBaseOffset, *device, 1, 1, 0,
+      std::move(evictCb), std::move(cleanupCb), std::make_unique<LruPolicy>(4),
+      kNumRegions /* numInMemBuffers */, 0, kFlushRetryLimit);
+
+  // reset discards all the regions
+  rm->reset();
+  EXPECT_EQ(kNumRegions * kRegionSize, device->getBytesDiscarded());
+
+  ENABLE_INJECT_PAUSE_IN_SCOPE();
+  injectPauseSet("pause_reclaim_done");
+
+  RegionId rid;
+  rm->startReclaim();
+  EXPECT_TRUE(injectPauseWait("pause_reclaim_done"));
+  ASSERT_EQ(OpenStatus::Ready, rm->getCleanRegion(rid, false).first);
+  ASSERT_EQ(0, rid.index());
+
+  BufferGen bg;
+  auto& region = rm->getRegion(rid);
+  auto [wDesc, addr] = region.openAndAllocate(kRegionSize);
+  EXPECT_EQ(OpenStatus::Ready, wDesc.status());
+  auto buf = bg.gen(kRegionSize);
+  rm->write(addr, buf.copy());
+  region.close(std::move(wDesc));
+  rm->doFlush(rid, false /* async */);
+
+  Buffer bufRead{kRegionSize};
+  EXPECT_TRUE(device->read(kBaseOffset, kRegionSize, bufRead.data()));
+  EXPECT_EQ(buf.view(), bufRead.view());
+
+  // regions that were never written are not discarded on reclaim
+  for (uint32_t i = 1; i < kNumRegions; i++) {
+    rm->startReclaim();
+    EXPECT_TRUE(injectPauseWait("pause_reclaim_done"));
+  }
+  EXPECT_EQ(kNumRegions * kRegionSize, device->getBytesDiscarded());
+
+  // the written region is discarded when it is reclaimed
+  rm->startReclaim();
+  EXPECT_TRUE(injectPauseWait("pause_reclaim_done"));
+  EXPECT_EQ((kNumRegions + 1) * kRegionSize, device->getBytesDiscarded());
+  Buffer zeros{kRegionSize};
+  std::memset(zeros.data(), 0, kRegionSize);
+  EXPECT_TRUE(device->read(kBaseOffset, kRegionSize, bufRead.data()));
+  EXPECT_EQ(zeros.view(), bufRead.view());
+}
+
 TEST(RegionManager, RecoveryLRUOrder) {
   constexpr uint32_t kNumRegions = 4;
   constexpr uint32_t kRegionSize = 4 * 1024;
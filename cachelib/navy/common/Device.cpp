@@ -20,17 +20,25 @@
 #include <folly/Format.h>
 #include <folly/Function.h>
 #include <folly/ThreadLocal.h>
+#include <folly/container/F14Map.h>
 #include <folly/experimental/io/AsyncIO.h>
 #include <folly/experimental/io/IoUring.h>
 #include <folly/fibers/TimedMutex.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/EventBaseManager.h>
 #include <folly/io/async/EventHandler.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <cstring>
+#include <mutex>
 #include <numeric>
 
+#include "cachelib/common/LatencyTracer.h"
 #include "cachelib/navy/common/FdpNvme.h"
 #include "cachelib/navy/common/Utils.h"
 
@@ -323,6 +331,13 @@ class FileDevice : public Device {
 
   void flushImpl() override;
 
+  // Discards the range on each member device that it is striped over
+  bool discardImpl(uint64_t, uint64_t) override;
+
+  // Discards the range of the member device at @idx using BLKDISCARD for block
+  // devices and by punching a hole for regular files.
+  bool discardRange(size_t idx, uint64_t offset, uint64_t size);
+
   int allocatePlacementHandle() override;
 
   // File vector for devices or regular files
@@ -391,8 +406,137 @@ class MemoryDevice final : public Device {
     // Noop
   }
 
+  bool discardImpl(uint64_t offset, uint64_t size) override {
+    XDCHECK_LE(offset + size, getSize());
+    std::memset(buffer_.get() + offset, 0, size);
+    return true;
+  }
+
   std::unique_ptr<uint8_t[]> buffer_;
 };
+
+// Device on memory that keeps only the pages that are not all zeros. Payloads
+// that are never populated (e.g. in cachebench simulations) take no memory as
+// long as the DRAM they are copied from was zeroed, while the entry headers
+// and keys that the engines read back are kept. Values in recycled DRAM still
+// hold stale bytes and their pages are stored like any other.
+class SparseMemoryDevice final : public Device {
+ public:
+  explicit SparseMemoryDevice(uint64_t size,
+                              std::shared_ptr<DeviceEncryptor> encryptor,
+                              uint32_t ioAlignSize)
+      : Device{size, std::move(encryptor), ioAlignSize, 0 /* max IO size */,
+               0 /* max device write size */} {}
+  SparseMemoryDevice(const SparseMemoryDevice&) = delete;
+  SparseMemoryDevice& operator=(const SparseMemoryDevice&) = delete;
+  ~SparseMemoryDevice() override = default;
+
+ private:
+  static constexpr uint32_t kPageSize = 4096;
+  static constexpr size_t kNumShards = 64;
+  using Page = std::array<uint8_t, kPageSize>;
+
+  struct Shard {
+    std::mutex mutex;
+    folly::F14FastMap<uint64_t, std::unique_ptr<Page>> pages;
+  };
+
+  bool writeImpl(uint64_t offset,
+                 uint32_t size,
+                 const void* value,
+                 int /* unused */) override {
+    XDCHECK_LE(offset + size, getSize());
+    const auto* src = reinterpret_cast<const uint8_t*>(value);
+    forEachPage(offset, size,
+                [&](uint64_t page, uint32_t pageOffset, uint32_t len) {
+                  writePage(page, pageOffset, src, len);
+                  src += len;
+                });
+    return true;
+  }
+
+  bool readImpl(uint64_t offset, uint32_t size, void* value) override {
+    XDCHECK_LE(offset + size, getSize());
+    auto* dst = reinterpret_cast<uint8_t*>(value);
+    forEachPage(offset, size,
+                [&](uint64_t page, uint32_t pageOffset, uint32_t len) {
+                  auto& shard = getShard(page);
+                  std::lock_guard<std::mutex> l{shard.mutex};
+                  auto it = shard.pages.find(page);
+                  if (it == shard.pages.end()) {
+                    std::memset(dst, 0, len);
+                  } else {
+                    std::memcpy(dst, it->second->data() + pageOffset, len);
+                  }
+                  dst += len;
+                });
+    return true;
+  }
+
+  int allocatePlacementHandle() override { return -1; }
+
+  void flushImpl() override {
+    // Noop
+  }
+
+  bool discardImpl(uint64_t offset, uint64_t size) override {
+    XDCHECK_LE(offset + size, getSize());
+    static const Page kZeroPage{};
+    forEachPage(offset, size,
+                [&](uint64_t page, uint32_t pageOffset, uint32_t len) {
+                  writePage(page, pageOffset, kZeroPage.data(), len);
+                });
+    return true;
+  }
+
+  void getCountersImpl(const CounterVisitor& visitor) const override {
+    visitor("navy_device_sparse_stored_bytes",
+            storedPages_.load(std::memory_order_relaxed) * kPageSize);
+  }
+
+  template <typename F>
+  static void forEachPage(uint64_t offset, uint64_t size, F&& f) {
+    while (size > 0) {
+      const uint32_t pageOffset = offset % kPageSize;
+      const uint32_t len = std::min<uint64_t>(size, kPageSize - pageOffset);
+      f(offset / kPageSize, pageOffset, len);
+      offset += len;
+      size -= len;
+    }
+  }
+
+  static bool isZero(const uint8_t* data, uint32_t len) {
+    return len == 0 ||
+           (data[0] == 0 && std::memcmp(data, data + 1, len - 1) == 0);
+  }
+
+  Shard& getShard(uint64_t page) { return shards_[page % kNumShards]; }
+
+  void writePage(uint64_t page,
+                 uint32_t pageOffset,
+                 const uint8_t* src,
+                 uint32_t len) {
+    const bool zero = isZero(src, len);
+    auto& shard = getShard(page);
+    std::lock_guard<std::mutex> l{shard.mutex};
+    auto it = shard.pages.find(page);
+    if (it == shard.pages.end()) {
+      if (zero) {
+        return;
+      }
+      it = shard.pages.emplace(page, std::make_unique<Page>()).first;
+      storedPages_.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::memcpy(it->second->data() + pageOffset, src, len);
+    if (zero && isZero(it->second->data(), kPageSize)) {
+      shard.pages.erase(it);
+      storedPages_.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+
+  std::array<Shard, kNumShards> shards_;
+  std::atomic<uint64_t> storedPages_{0};
+};
 } // namespace
 
 bool Device::write(uint64_t offset, BufferView view, int placeHandle) {
@@ -437,7 +581,10 @@ bool Device::writeInternal(uint64_t offset,
     XDCHECK_EQ(writeSize % ioAlignmentSize_, 0ul);
 
     auto timeBegin = getSteadyClock();
-    result = writeImpl(offset, writeSize, data, placeHandle);
+    {
+      ScopedTraceStage stage{TraceStage::kDeviceIo};
+      result = writeImpl(offset, writeSize, data, placeHandle);
+    }
     writeLatencyEstimator_.trackValue(
         toMicros((getSteadyClock() - timeBegin)).count());
 
@@ -477,7 +624,10 @@ bool Device::readInternal(uint64_t offset, uint32_t size, void* value) {
     XDCHECK_EQ(size % ioAlignmentSize_, 0ul);
 
     auto timeBegin = getSteadyClock();
-    result = readImpl(curOffset, readSize, data);
+    {
+      ScopedTraceStage stage{TraceStage::kDeviceIo};
+      result = readImpl(curOffset, readSize, data);
+    }
     readLatencyEstimator_.trackValue(
         toMicros(getSteadyClock() - timeBegin).count());
 
@@ -534,6 +684,37 @@ bool Device::read(uint64_t offset, uint32_t size, void* value) {
   return readInternal(offset, size, value);
 }
 
+void Device::enableDiscard(uint64_t maxBytesPerSec, uint64_t maxDiscardSize) {
+  discardEnabled_ = true;
+  if (maxBytesPerSec > 0) {
+    const auto rate = static_cast<double>(maxBytesPerSec);
+    const auto burst = static_cast<double>(
+        std::max<uint64_t>(maxBytesPerSec, maxDiscardSize));
+    discardLimiter_ = std::make_unique<folly::TokenBucket>(rate, burst);
+  }
+}
+
+bool Device::discard(uint64_t offset, uint64_t size, bool rateLimited) {
+  if (!discardEnabled_ || size == 0) {
+    return false;
+  }
+  XDCHECK_LE(offset + size, size_);
+  XDCHECK_EQ(offset % ioAlignmentSize_, 0ul);
+  XDCHECK_EQ(size % ioAlignmentSize_, 0ul);
+
+  if (rateLimited && discardLimiter_ &&
+      !discardLimiter_->consume(static_cast<double>(size))) {
+    discardsSkipped_.inc();
+    return false;
+  }
+  if (!discardImpl(offset, size)) {
+    discardErrors_.inc();
+    return false;
+  }
+  bytesDiscarded_.add(size);
+  return true;
+}
+
 void Device::getCounters(const CounterVisitor& visitor) const {
   visitor("navy_device_bytes_written", getBytesWritten(),
           CounterVisitor::CounterType::RATE);
@@ -547,6 +728,12 @@ void Device::getCounters(const CounterVisitor& visitor) const {
           CounterVisitor::CounterType::RATE);
   visitor("navy_device_decryption_errors", decryptionErrors_.get(),
           CounterVisitor::CounterType::RATE);
+  visitor("navy_device_bytes_discarded", bytesDiscarded_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_device_discard_errors", discardErrors_.get(),
+          CounterVisitor::CounterType::RATE);
+  visitor("navy_device_discards_skipped", discardsSkipped_.get(),
+          CounterVisitor::CounterType::RATE);
 
   readIOOpDeviceLatencyEstimator_.visitQuantileEstimator(
       visitor, "navy_device_async_io_op_read_device_latency_us");
@@ -556,6 +743,7 @@ void Device::getCounters(const CounterVisitor& visitor) const {
                                                "navy_device_read_latency_us");
   writeLatencyEstimator_.visitQuantileEstimator(visitor,
                                                 "navy_device_write_latency_us");
+  getCountersImpl(visitor);
 }
 
 namespace {
@@ -1026,6 +1214,65 @@ void FileDevice::flushImpl() {
   }
 }
 
+bool FileDevice::discardImpl(uint64_t offset, uint64_t size) {
+  if (fvec_.size() == 1) {
+    return discardRange(0, offset, size);
+  }
+
+  // Consecutive stripes of the range that land on the same member device are
+  // contiguous on that device, so we issue one discard per member device.
+  std::vector<std::pair<uint64_t, uint64_t>> ranges(fvec_.size(), {0, 0});
+  bool result = true;
+  while (size > 0) {
+    const uint64_t stripe = offset / stripeSize_;
+    const size_t fdIdx = stripe % fvec_.size();
+    const uint64_t offsetInStripe = offset % stripeSize_;
+    const uint64_t devOffset =
+        (stripe / fvec_.size()) * stripeSize_ + offsetInStripe;
+    const uint64_t len = std::min(size, stripeSize_ - offsetInStripe);
+
+    auto& range = ranges[fdIdx];
+    if (range.second > 0 && range.first + range.second == devOffset) {
+      range.second += len;
+    } else {
+      if (range.second > 0) {
+        result = discardRange(fdIdx, range.first, range.second) && result;
+      }
+      range = {devOffset, len};
+    }
+    offset += len;
+    size -= len;
+  }
+  for (size_t i = 0; i < ranges.size(); i++) {
+    if (ranges[i].second > 0) {
+      result = discardRange(i, ranges[i].first, ranges[i].second) && result;
+    }
+  }
+  return result;
+}
+
+bool FileDevice::discardRange(size_t idx, uint64_t offset, uint64_t size) {
+  const int fd = fvec_[idx].fd();
+  struct stat st {};
+  int ret = ::fstat(fd, &st);
+  if (ret == 0) {
+    if (S_ISBLK(st.st_mode)) {
+      uint64_t range[2] = {offset, size};
+      ret = ::ioctl(fd, BLKDISCARD, &range);
+    } else {
+      ret = ::fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                        static_cast<off_t>(offset), static_cast<off_t>(size));
+    }
+  }
+  if (ret != 0) {
+    XLOG_EVERY_MS(ERR, 10000) << fmt::format(
+        "Failed to discard device {} offset {} size {}: {}", idx, offset, size,
+        std::strerror(errno));
+    return false;
+  }
+  return true;
+}
+
 IoContext* FileDevice::getIoContext() {
   if (ioEngine_ == IoEngine::Sync) {
     return syncIoContext_.get();
@@ -1200,6 +1447,14 @@ std::unique_ptr<Device> createMemoryDevice(
                                         ioAlignSize);
 }
 
+std::unique_ptr<Device> createSparseMemoryDevice(
+    uint64_t size,
+    std::shared_ptr<DeviceEncryptor> encryptor,
+    uint32_t ioAlignSize) {
+  return std::make_unique<SparseMemoryDevice>(size, std::move(encryptor),
+                                              ioAlignSize);
+}
+
 std::unique_ptr<Device> createDirectIoFileDevice(
     std::vector<folly::File> fVec,
     std::vector<std::string> filePaths,
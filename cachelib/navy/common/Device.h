@@ -17,6 +17,7 @@
 #pragma once
 
 #include <folly/File.h>
+#include <folly/TokenBucket.h>
 #include <folly/io/IOBuf.h>
 
 #include "cachelib/allocator/nvmcache/NavyConfig.h"
@@ -167,12 +168,37 @@ class Device {
   // Everything should be on device after this call returns.
   void flush() { flushImpl(); }
 
+  // Enables discarding (TRIM) of the ranges that the engines no longer use,
+  // so that an SSD does not have to relocate the stale data during its
+  // garbage collection. Must be called before the device is used.
+  //
+  // @param maxBytesPerSec  limit for the rate limited discards. 0 means no
+  //                        limit.
+  // @param maxDiscardSize  size of the largest rate limited discard. The
+  //                        burst of the limiter is at least this size, so
+  //                        that such a discard is not always skipped when
+  //                        the rate is lower.
+  void enableDiscard(uint64_t maxBytesPerSec = 0, uint64_t maxDiscardSize = 0);
+
+  bool isDiscardEnabled() const { return discardEnabled_; }
+
+  // Discards @size bytes at @offset. The contents of the range are undefined
+  // afterwards. This is a no-op if discard is not enabled. When @rateLimited
+  // is set, the discard is skipped if it exceeds the rate limit.
+  // @offset and @size must be ioAlignmentSize_ aligned.
+  //
+  // @return true if the range was discarded
+  bool discard(uint64_t offset, uint64_t size, bool rateLimited = true);
+
   // Return bytes written since device start
   uint64_t getBytesWritten() const { return bytesWritten_.get(); }
 
   // Return bytes read since device start
   uint64_t getBytesRead() const { return bytesRead_.get(); }
 
+  // Return bytes discarded since device start
+  uint64_t getBytesDiscarded() const { return bytesDiscarded_.get(); }
+
   // Export device stats via CounterVisitor
   void getCounters(const CounterVisitor& visitor) const;
 
@@ -190,6 +216,15 @@ class Device {
   virtual bool readImpl(uint64_t offset, uint32_t size, void* value) = 0;
   virtual void flushImpl() = 0;
 
+  // Devices that can not discard keep the default that always fails.
+  virtual bool discardImpl(uint64_t /* offset */, uint64_t /* size */) {
+    return false;
+  }
+
+  // Devices with stats of their own export them in addition to the common
+  // ones.
+  virtual void getCountersImpl(const CounterVisitor& /* visitor */) const {}
+
   // This measures the latency of an individual read or write iop between its
   // submission and completion. Slowdowns in the kernel and the boundary between
   // kernel and userspace will negatively affect this latency metric. For
@@ -205,6 +240,9 @@ class Device {
   mutable AtomicCounter readIOErrors_;
   mutable AtomicCounter encryptionErrors_;
   mutable AtomicCounter decryptionErrors_;
+  mutable AtomicCounter bytesDiscarded_;
+  mutable AtomicCounter discardErrors_;
+  mutable AtomicCounter discardsSkipped_;
 
   // This measures the latency of a read or write request. For synchronous IO,
   // this measures the latency of pread/pwrite. For async IO, this measures
@@ -240,6 +278,11 @@ class Device {
 
   std::shared_ptr<DeviceEncryptor> encryptor_;
 
+  // whether discard is enabled and the rate limit for it; nullptr when not
+  // rate limited
+  bool discardEnabled_{false};
+  std::unique_ptr<folly::TokenBucket> discardLimiter_;
+
   static constexpr uint32_t kDefaultAlignmentSize{1};
 };
 
@@ -251,6 +294,14 @@ std::unique_ptr<Device> createMemoryDevice(
     std::shared_ptr<DeviceEncryptor> encryptor,
     uint32_t ioAlignSize = 1);
 
+// Creates a memory device that only stores the pages that are not all zeros,
+// for simulations whose payloads are never populated. With an encryptor, no
+// page is sparse.
+std::unique_ptr<Device> createSparseMemoryDevice(
+    uint64_t size,
+    std::shared_ptr<DeviceEncryptor> encryptor,
+    uint32_t ioAlignSize = 1);
+
 // Creates a direct IO file device supporting RAID if multiple files are
 // provided. If qDepth = 0, sync IO will be used all the time
 //
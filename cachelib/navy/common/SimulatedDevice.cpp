@@ -0,0 +1,608 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/navy/common/SimulatedDevice.h"
+
+#include <folly/Format.h>
+#include <folly/Random.h>
+#include <folly/fibers/Baton.h>
+#include <folly/fibers/FiberManager.h>
+#include <folly/logging/xlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+
+namespace {
+// z-score of the 99th percentile of a normal distribution
+constexpr double kZ99 = 2.3263478740408408;
+
+// GC starts when the free erase blocks drop below this
+constexpr uint32_t kMinFreeBlocks = 2;
+
+// waits shorter than this spin, since sleeping overshoots by about as much
+constexpr uint64_t kSpinNs = 50'000;
+
+uint64_t nowNs() { return getSteadyClock().count(); }
+
+// Parameters of a log-normal distribution of latencies in ns with the given
+// median and 99th percentile
+struct LogNormal {
+  LogNormal(std::chrono::microseconds p50, std::chrono::microseconds p99)
+      : mu{std::log(std::chrono::nanoseconds{p50}.count())},
+        sigma{std::log(static_cast<double>(p99.count()) / p50.count()) / kZ99} {
+  }
+
+  uint64_t sample() const {
+    if (sigma <= 0) {
+      return static_cast<uint64_t>(std::exp(mu));
+    }
+    folly::ThreadLocalPRNG rng;
+    std::lognormal_distribution<double> dist{mu, sigma};
+    return static_cast<uint64_t>(dist(rng));
+  }
+
+  double mu;
+  double sigma;
+};
+
+// Page mapped flash translation layer with greedy garbage collection. The
+// writes are appended to the active erase block. When the free blocks run
+// out, the block with the fewest valid pages is collected: its valid pages
+// are relocated and it is erased. Not thread safe.
+class Ftl {
+ public:
+  // GC work caused by a write
+  struct GcWork {
+    uint64_t relocatedPages{0};
+    uint64_t erasedBlocks{0};
+  };
+
+  Ftl(uint64_t size, const SimulatedDeviceConfig& config)
+      : pageSize_{config.pageSize},
+        pagesPerBlock_{config.eraseBlockSize / config.pageSize} {
+    const uint64_t numPages = (size + pageSize_ - 1) / pageSize_;
+    const uint64_t logicalBlocks =
+        (numPages + pagesPerBlock_ - 1) / pagesPerBlock_;
+    const uint64_t numBlocks = std::max<uint64_t>(
+        logicalBlocks + kMinFreeBlocks + 2,
+        static_cast<uint64_t>(logicalBlocks * (1 + config.overProvisioning)));
+    if (numBlocks * pagesPerBlock_ >= kInvalid) {
+      throw std::invalid_argument(
+          folly::sformat("Simulated device of {} bytes has too many pages of "
+                         "{} bytes",
+                         size, pageSize_));
+    }
+    l2p_.resize(numPages, kInvalid);
+    p2l_.resize(numBlocks * pagesPerBlock_, kInvalid);
+    validPages_.resize(numBlocks, 0);
+    isFree_.resize(numBlocks, true);
+    for (auto block = static_cast<uint32_t>(numBlocks); block > 0; block--) {
+      freeBlocks_.push_back(block - 1);
+    }
+    activeBlock_ = popFreeBlock();
+  }
+
+  // Writes the pages overlapping [offset, offset + size)
+  GcWork write(uint64_t offset, uint64_t size) {
+    GcWork work;
+    const uint64_t end = (offset + size + pageSize_ - 1) / pageSize_;
+    for (uint64_t page = offset / pageSize_; page < end; page++) {
+      while (freeBlocks_.size() < kMinFreeBlocks) {
+        collect(work);
+      }
+      program(static_cast<uint32_t>(page));
+      hostPages_++;
+    }
+    return work;
+  }
+
+  // Unmaps the pages within [offset, offset + size)
+  void trim(uint64_t offset, uint64_t size) {
+    const uint64_t end = (offset + size) / pageSize_;
+    for (uint64_t page = (offset + pageSize_ - 1) / pageSize_; page < end;
+         page++) {
+      invalidate(static_cast<uint32_t>(page));
+    }
+  }
+
+  uint64_t getHostPages() const { return hostPages_; }
+  uint64_t getFlashPages() const { return flashPages_; }
+  uint64_t getErasedBlocks() const { return erasedBlocks_; }
+
+ private:
+  static constexpr uint32_t kInvalid = std::numeric_limits<uint32_t>::max();
+
+  uint32_t popFreeBlock() {
+    XDCHECK(!freeBlocks_.empty());
+    const auto block = freeBlocks_.back();
+    freeBlocks_.pop_back();
+    isFree_[block] = false;
+    writePointer_ = 0;
+    return block;
+  }
+
+  void invalidate(uint32_t page) {
+    const auto flashPage = l2p_[page];
+    if (flashPage != kInvalid) {
+      p2l_[flashPage] = kInvalid;
+      validPages_[flashPage / pagesPerBlock_]--;
+      l2p_[page] = kInvalid;
+    }
+  }
+
+  void program(uint32_t page) {
+    invalidate(page);
+    if (writePointer_ == pagesPerBlock_) {
+      activeBlock_ = popFreeBlock();
+    }
+    const uint32_t flashPage = activeBlock_ * pagesPerBlock_ + writePointer_++;
+    l2p_[page] = flashPage;
+    p2l_[flashPage] = page;
+    validPages_[activeBlock_]++;
+    flashPages_++;
+  }
+
+  void collect(GcWork& work) {
+    uint32_t victim = kInvalid;
+    for (uint32_t block = 0; block < validPages_.size(); block++) {
+      if (!isFree_[block] && block != activeBlock_ &&
+          (victim == kInvalid || validPages_[block] < validPages_[victim])) {
+        victim = block;
+      }
+    }
+    // the spare blocks guarantee a victim with invalid pages
+    XDCHECK_NE(victim, kInvalid);
+    XDCHECK_LT(validPages_[victim], pagesPerBlock_);
+    const uint32_t first = victim * pagesPerBlock_;
+    for (uint32_t flashPage = first; flashPage < first + pagesPerBlock_;
+         flashPage++) {
+      if (p2l_[flashPage] != kInvalid) {
+        program(p2l_[flashPage]);
+        work.relocatedPages++;
+      }
+    }
+    XDCHECK_EQ(validPages_[victim], 0u);
+    isFree_[victim] = true;
+    freeBlocks_.push_back(victim);
+    work.erasedBlocks++;
+    erasedBlocks_++;
+  }
+
+  const uint32_t pageSize_{};
+  const uint32_t pagesPerBlock_{};
+
+  // logical page to flash page and back
+  std::vector<uint32_t> l2p_;
+  std::vector<uint32_t> p2l_;
+  std::vector<uint32_t> validPages_;
+  std::vector<bool> isFree_;
+  std::vector<uint32_t> freeBlocks_;
+  uint32_t activeBlock_{};
+  uint32_t writePointer_{};
+
+  uint64_t hostPages_{0};
+  uint64_t flashPages_{0};
+  uint64_t erasedBlocks_{0};
+};
+
+class SimulatedDevice final : public Device {
+ public:
+  SimulatedDevice(uint64_t size,
+                  const SimulatedDeviceConfig& config,
+                  std::shared_ptr<DeviceEncryptor> encryptor,
+                  uint32_t ioAlignSize)
+      : Device{size, std::move(encryptor), ioAlignSize, 0 /* max IO size */,
+               0 /* max device write size */},
+        config_{config.validate()},
+        readLatency_{config_.readLatencyP50, config_.readLatencyP99},
+        writeLatency_{config_.writeLatencyP50, config_.writeLatencyP99},
+        buffer_{std::make_unique<uint8_t[]>(size)},
+        ftl_{size, config_},
+        channelBusyUntilNs_(config_.numChannels, 0),
+        channelBytes_(config_.numChannels, 0) {
+    XLOGF(INFO, "Simulated device of {} bytes: {}", size, config_.toString());
+  }
+  SimulatedDevice(const SimulatedDevice&) = delete;
+  SimulatedDevice& operator=(const SimulatedDevice&) = delete;
+  ~SimulatedDevice() override = default;
+
+ private:
+  bool writeImpl(uint64_t offset,
+                 uint32_t size,
+                 const void* value,
+                 int /* unused */) noexcept override {
+    XDCHECK_LE(offset + size, getSize());
+    std::memcpy(buffer_.get() + offset, value, size);
+    waitUntil(schedule(offset, size, true /* isWrite */));
+    return true;
+  }
+
+  bool readImpl(uint64_t offset, uint32_t size, void* value) override {
+    XDCHECK_LE(offset + size, getSize());
+    std::memcpy(value, buffer_.get() + offset, size);
+    waitUntil(schedule(offset, size, false /* isWrite */));
+    return true;
+  }
+
+  int allocatePlacementHandle() override { return -1; }
+
+  void flushImpl() override {
+    // Noop
+  }
+
+  bool discardImpl(uint64_t offset, uint64_t size) override {
+    XDCHECK_LE(offset + size, getSize());
+    std::memset(buffer_.get() + offset, 0, size);
+    std::lock_guard<std::mutex> l{mutex_};
+    ftl_.trim(offset, size);
+    return true;
+  }
+
+  void getCountersImpl(const CounterVisitor& visitor) const override {
+    uint64_t hostPages = 0;
+    uint64_t flashPages = 0;
+    uint64_t erasedBlocks = 0;
+    {
+      std::lock_guard<std::mutex> l{mutex_};
+      hostPages = ftl_.getHostPages();
+      flashPages = ftl_.getFlashPages();
+      erasedBlocks = ftl_.getErasedBlocks();
+    }
+    visitor("navy_device_sim_write_amp",
+            hostPages == 0 ? 0 : static_cast<double>(flashPages) / hostPages);
+    visitor("navy_device_sim_gc_relocated_bytes",
+            (flashPages - hostPages) * config_.pageSize,
+            CounterVisitor::CounterType::RATE);
+    visitor("navy_device_sim_erases", erasedBlocks,
+            CounterVisitor::CounterType::RATE);
+    visitor("navy_device_sim_gc_stall_us",
+            gcStallNs_.load(std::memory_order_relaxed) / 1000,
+            CounterVisitor::CounterType::RATE);
+    visitor("navy_device_sim_queue_wait_us",
+            queueWaitNs_.load(std::memory_order_relaxed) / 1000,
+            CounterVisitor::CounterType::RATE);
+  }
+
+  // Queues the IO on the channels it touches and returns its completion time
+  uint64_t schedule(uint64_t offset, uint32_t size, bool isWrite) {
+    const uint64_t startNs = nowNs();
+    const uint64_t baseNs =
+        isWrite ? writeLatency_.sample() : readLatency_.sample();
+    const double nsPerByte =
+        1e9 / (isWrite ? config_.channelWriteBytesPerSec
+                       : config_.channelReadBytesPerSec);
+
+    std::lock_guard<std::mutex> l{mutex_};
+    if (isWrite) {
+      const auto work = ftl_.write(offset, size);
+      if (work.relocatedPages > 0 || work.erasedBlocks > 0) {
+        // the GC reads and programs the relocated pages and erases the
+        // victims, spread over all the channels
+        const double relocationNs =
+            work.relocatedPages * config_.pageSize * 1e9 *
+            (1.0 / config_.channelReadBytesPerSec +
+             1.0 / config_.channelWriteBytesPerSec);
+        const uint64_t eraseNs =
+            work.erasedBlocks *
+            std::chrono::nanoseconds{config_.eraseLatency}.count();
+        const uint64_t stallNs =
+            static_cast<uint64_t>(relocationNs + eraseNs) / config_.numChannels;
+        for (auto& busyUntilNs : channelBusyUntilNs_) {
+          busyUntilNs = std::max(busyUntilNs, startNs) + stallNs;
+        }
+        gcStallNs_.fetch_add(stallNs, std::memory_order_relaxed);
+      }
+    }
+
+    const uint64_t end = offset + size;
+    for (uint64_t pos = offset; pos < end;) {
+      const uint64_t stripe = pos / config_.channelStripeSize;
+      const uint64_t stripeEnd =
+          std::min(end, (stripe + 1) * config_.channelStripeSize);
+      channelBytes_[stripe % config_.numChannels] += stripeEnd - pos;
+      pos = stripeEnd;
+    }
+
+    uint64_t completionNs = startNs;
+    for (uint32_t channel = 0; channel < config_.numChannels; channel++) {
+      if (channelBytes_[channel] == 0) {
+        continue;
+      }
+      auto& busyUntilNs = channelBusyUntilNs_[channel];
+      const uint64_t channelStartNs = std::max(busyUntilNs, startNs);
+      queueWaitNs_.fetch_add(channelStartNs - startNs,
+                             std::memory_order_relaxed);
+      busyUntilNs = channelStartNs + baseNs +
+                    static_cast<uint64_t>(channelBytes_[channel] * nsPerByte);
+      completionNs = std::max(completionNs, busyUntilNs);
+      channelBytes_[channel] = 0;
+    }
+    return completionNs;
+  }
+
+  // Navy runs its IOs on fibers. A fiber waits on a timer so that the other
+  // fibers of its thread can issue their IOs in the meantime, then yields
+  // until the deadline in case the timer is coarser than the latency. Off a
+  // fiber, the thread sleeps and spins for the last part of the wait.
+  void waitUntil(uint64_t deadlineNs) const {
+    if (!config_.injectLatency) {
+      return;
+    }
+    if (folly::fibers::onFiber()) {
+      const auto now = nowNs();
+      if (now < deadlineNs) {
+        folly::fibers::Baton baton;
+        baton.try_wait_for(std::chrono::nanoseconds{deadlineNs - now});
+      }
+      while (nowNs() < deadlineNs) {
+        folly::fibers::yield();
+      }
+      return;
+    }
+    for (auto now = nowNs(); now < deadlineNs; now = nowNs()) {
+      if (deadlineNs - now > kSpinNs) {
+        std::this_thread::sleep_for(
+            std::chrono::nanoseconds{deadlineNs - now - kSpinNs});
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  const SimulatedDeviceConfig config_;
+  const LogNormal readLatency_;
+  const LogNormal writeLatency_;
+  std::unique_ptr<uint8_t[]> buffer_;
+
+  // protects the FTL and the channels
+  mutable std::mutex mutex_;
+  Ftl ftl_;
+  std::vector<uint64_t> channelBusyUntilNs_;
+  // bytes of the IO being scheduled on each channel
+  std::vector<uint64_t> channelBytes_;
+
+  std::atomic<uint64_t> gcStallNs_{0};
+  std::atomic<uint64_t> queueWaitNs_{0};
+};
+
+// Runs the IO and returns its latency
+template <typename F>
+uint64_t timeIo(F&& io) {
+  const auto startNs = nowNs();
+  if (!io()) {
+    throw std::runtime_error("IO failed while calibrating the device");
+  }
+  return nowNs() - startNs;
+}
+
+uint64_t percentile(std::vector<uint64_t> samples, double fraction) {
+  XDCHECK(!samples.empty());
+  const size_t rank = std::min(
+      samples.size() - 1, static_cast<size_t>(fraction * samples.size()));
+  std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+  return samples[rank];
+}
+
+std::chrono::microseconds toUs(double ns) {
+  return std::chrono::microseconds{
+      std::max<int64_t>(1, static_cast<int64_t>(ns / 1000))};
+}
+
+// Fits the base latency and the channel transfer rate to the latencies of
+// small IOs, on one channel, and of large IOs, spread over @largeChannels.
+void fitLatency(const std::vector<uint64_t>& small,
+                const std::vector<uint64_t>& large,
+                uint32_t smallSize,
+                uint32_t largeSize,
+                uint32_t largeChannels,
+                std::chrono::microseconds& p50,
+                std::chrono::microseconds& p99,
+                uint64_t& channelBytesPerSec) {
+  const double smallNs = percentile(small, 0.5);
+  const double largeNs = percentile(large, 0.5);
+  const double largeChannelBytes =
+      static_cast<double>(largeSize) / largeChannels;
+  if (largeNs > smallNs && largeChannelBytes > smallSize) {
+    channelBytesPerSec = static_cast<uint64_t>(
+        (largeChannelBytes - smallSize) * 1e9 / (largeNs - smallNs));
+  }
+  const double transferNs = smallSize * 1e9 / channelBytesPerSec;
+  p50 = toUs(smallNs - transferNs);
+  p99 = std::max(p50, toUs(percentile(small, 0.99) - transferNs));
+}
+} // namespace
+
+const SimulatedDeviceConfig& SimulatedDeviceConfig::validate() const {
+  if (numChannels == 0 || channelStripeSize == 0) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid simulated device channels: {} stripe size: {}", numChannels,
+        channelStripeSize));
+  }
+  if (readLatencyP50.count() <= 0 || readLatencyP99 < readLatencyP50 ||
+      writeLatencyP50.count() <= 0 || writeLatencyP99 < writeLatencyP50) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid simulated device latencies (us) read p50: {} p99: {} write "
+        "p50: {} p99: {}",
+        readLatencyP50.count(), readLatencyP99.count(),
+        writeLatencyP50.count(), writeLatencyP99.count()));
+  }
+  if (channelReadBytesPerSec == 0 || channelWriteBytesPerSec == 0) {
+    throw std::invalid_argument(
+        folly::sformat("Invalid simulated device channel read rate: {} write "
+                       "rate: {}",
+                       channelReadBytesPerSec, channelWriteBytesPerSec));
+  }
+  if (overProvisioning < 0 || pageSize == 0 || eraseBlockSize < pageSize ||
+      eraseBlockSize % pageSize != 0 || eraseLatency.count() < 0) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid simulated device FTL over provisioning: {} page size: {} "
+        "erase block size: {} erase latency: {}us",
+        overProvisioning, pageSize, eraseBlockSize, eraseLatency.count()));
+  }
+  return *this;
+}
+
+std::string SimulatedDeviceConfig::toString() const {
+  return folly::sformat(
+      "channels={} stripe_size={} read_us(p50/p99)={}/{} "
+      "write_us(p50/p99)={}/{} channel_read_MBps={} channel_write_MBps={} "
+      "over_provisioning={} page_size={} erase_block_size={} erase_us={} "
+      "inject_latency={}",
+      numChannels, channelStripeSize, readLatencyP50.count(),
+      readLatencyP99.count(), writeLatencyP50.count(), writeLatencyP99.count(),
+      channelReadBytesPerSec / (1024 * 1024),
+      channelWriteBytesPerSec / (1024 * 1024), overProvisioning, pageSize,
+      eraseBlockSize, eraseLatency.count(), injectLatency);
+}
+
+std::unique_ptr<Device> createSimulatedDevice(
+    uint64_t size,
+    const SimulatedDeviceConfig& config,
+    std::shared_ptr<DeviceEncryptor> encryptor,
+    uint32_t ioAlignSize) {
+  return std::make_unique<SimulatedDevice>(size, config, std::move(encryptor),
+                                           ioAlignSize);
+}
+
+SimulatedDeviceConfig calibrateSimulatedDevice(
+    Device& device,
+    const CalibrationOptions& options,
+    SimulatedDeviceConfig base) {
+  const uint32_t align = device.getIOAlignmentSize();
+  const uint32_t smallSize = (base.pageSize + align - 1) / align * align;
+  const uint32_t largeSize = options.largeIoSize / align * align;
+  const uint64_t testBytes =
+      largeSize == 0
+          ? 0
+          : std::min(options.testBytes, device.getSize()) / largeSize *
+                largeSize;
+  if (largeSize <= smallSize || testBytes < 2 * uint64_t{largeSize} ||
+      options.numSamples == 0 || options.maxThreads == 0) {
+    throw std::invalid_argument(folly::sformat(
+        "Invalid calibration: {} test bytes with IOs of {} and {} bytes, {} "
+        "samples, {} threads",
+        testBytes, smallSize, largeSize, options.numSamples,
+        options.maxThreads));
+  }
+  XLOGF(INFO, "Calibrating a simulated device on {} bytes", testBytes);
+
+  auto largeBuffer = device.makeIOBuffer(largeSize);
+  for (size_t i = 0; i < largeBuffer.size(); i++) {
+    largeBuffer.data()[i] = static_cast<uint8_t>(folly::Random::rand32());
+  }
+  auto smallBuffer = device.makeIOBuffer(smallSize);
+  auto randomOffset = [testBytes](uint32_t size) {
+    return folly::Random::rand64(testBytes / size) * size;
+  };
+
+  // fill the test range first, since reading unwritten ranges may not touch
+  // the flash
+  std::vector<uint64_t> largeWrites;
+  for (uint64_t offset = 0; offset < testBytes; offset += largeSize) {
+    largeWrites.push_back(timeIo(
+        [&] { return device.write(offset, largeBuffer.view()); }));
+  }
+
+  std::vector<uint64_t> smallReads;
+  std::vector<uint64_t> smallWrites;
+  std::vector<uint64_t> largeReads;
+  for (uint32_t i = 0; i < options.numSamples; i++) {
+    smallReads.push_back(timeIo([&] {
+      return device.read(randomOffset(smallSize), smallSize,
+                         smallBuffer.data());
+    }));
+  }
+  for (uint32_t i = 0; i < options.numSamples; i++) {
+    smallWrites.push_back(timeIo([&] {
+      return device.write(randomOffset(smallSize), smallBuffer.view());
+    }));
+  }
+  const auto numLargeReads = std::min<uint64_t>(options.numSamples,
+                                                testBytes / largeSize);
+  for (uint64_t i = 0; i < numLargeReads; i++) {
+    largeReads.push_back(timeIo([&] {
+      return device.read(randomOffset(largeSize), largeSize,
+                         largeBuffer.data());
+    }));
+  }
+
+  // The internal parallelism is the number of reads in service at the peak
+  // throughput (Little's law), found by doubling the readers until the
+  // throughput stops growing.
+  double peakIops = 0;
+  for (uint32_t numThreads = 1; numThreads <= options.maxThreads;
+       numThreads *= 2) {
+    const uint32_t readsPerThread =
+        std::max<uint32_t>(1, options.numSamples / numThreads);
+    std::atomic<bool> failed{false};
+    const auto startNs = nowNs();
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < numThreads; t++) {
+      threads.emplace_back([&] {
+        auto buffer = device.makeIOBuffer(smallSize);
+        for (uint32_t i = 0; i < readsPerThread; i++) {
+          if (!device.read(randomOffset(smallSize), smallSize,
+                           buffer.data())) {
+            failed = true;
+          }
+        }
+      });
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+    if (failed) {
+      throw std::runtime_error("IO failed while calibrating the device");
+    }
+    const double iops =
+        numThreads * readsPerThread * 1e9 / std::max<uint64_t>(
+                                                1, nowNs() - startNs);
+    if (iops < peakIops * 1.1) {
+      break;
+    }
+    peakIops = std::max(peakIops, iops);
+  }
+  base.numChannels = std::max<uint32_t>(
+      1, std::lround(peakIops * percentile(smallReads, 0.5) / 1e9));
+
+  const auto largeChannels = std::min<uint64_t>(
+      base.numChannels,
+      (largeSize + base.channelStripeSize - 1) / base.channelStripeSize);
+  fitLatency(smallReads, largeReads, smallSize, largeSize, largeChannels,
+             base.readLatencyP50, base.readLatencyP99,
+             base.channelReadBytesPerSec);
+  fitLatency(smallWrites, largeWrites, smallSize, largeSize, largeChannels,
+             base.writeLatencyP50, base.writeLatencyP99,
+             base.channelWriteBytesPerSec);
+
+  XLOGF(INFO, "Calibrated simulated device: {}", base.validate().toString());
+  return base;
+}
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "cachelib/navy/common/Device.h"
+
+// A memory backed device with the performance model of an NVMe SSD, to tune
+// Navy (queue depths, region size, reinsertion, cleaning threads) on machines
+// without one.
+//
+// The address space is striped over the channels of the device, which serve
+// their IOs one at a time. An IO takes a base latency drawn from a log-normal
+// distribution plus the transfer of its bytes on each channel it touches, so
+// the reads queue behind the writes of the same channels. The writes go
+// through a page mapped FTL with greedy garbage collection. The relocations
+// and erases of the garbage collection stall all the channels, and give the
+// write amplification of the workload.
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+
+struct SimulatedDeviceConfig {
+  // number of channels (dies) that serve IOs in parallel
+  uint32_t numChannels{16};
+
+  // bytes of the address space mapped to a channel before the next one
+  uint32_t channelStripeSize{16 * 1024};
+
+  // latency of an IO on an idle channel, without the transfer
+  std::chrono::microseconds readLatencyP50{80};
+  std::chrono::microseconds readLatencyP99{200};
+  std::chrono::microseconds writeLatencyP50{25};
+  std::chrono::microseconds writeLatencyP99{100};
+
+  // transfer rate of a channel
+  uint64_t channelReadBytesPerSec{200 * 1024 * 1024};
+  uint64_t channelWriteBytesPerSec{80 * 1024 * 1024};
+
+  // FTL: spare flash as a fraction of the device size, the unit of mapping
+  // and the unit of erase
+  double overProvisioning{0.07};
+  uint32_t pageSize{4096};
+  uint32_t eraseBlockSize{1024 * 1024};
+  std::chrono::microseconds eraseLatency{3000};
+
+  // If false, IOs complete right away and only the stats of the model are
+  // kept, e.g. to estimate the write amplification in unit tests.
+  bool injectLatency{true};
+
+  // @throw std::invalid_argument on inconsistent parameters
+  const SimulatedDeviceConfig& validate() const;
+
+  std::string toString() const;
+};
+
+// Creates a memory backed device of @size bytes with the performance model
+// of @config.
+// @throw std::invalid_argument if the config is invalid
+std::unique_ptr<Device> createSimulatedDevice(
+    uint64_t size,
+    const SimulatedDeviceConfig& config,
+    std::shared_ptr<DeviceEncryptor> encryptor,
+    uint32_t ioAlignSize = 1);
+
+struct CalibrationOptions {
+  // bytes at the start of the device used by the measurements. This is
+  // overwritten.
+  uint64_t testBytes{256 * 1024 * 1024};
+
+  // IOs measured for each latency distribution
+  uint32_t numSamples{2000};
+
+  // size of the large IOs that measure the transfer rates
+  uint32_t largeIoSize{1024 * 1024};
+
+  // max number of threads issuing reads to find the internal parallelism
+  uint32_t maxThreads{64};
+};
+
+// Fits the performance model of a simulated device to a real device by
+// measuring it. The FTL parameters are not measured and are kept from @base.
+// The first @options.testBytes of @device are overwritten.
+//
+// @throw std::runtime_error if an IO fails
+SimulatedDeviceConfig calibrateSimulatedDevice(
+    Device& device,
+    const CalibrationOptions& options,
+    SimulatedDeviceConfig base = {});
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
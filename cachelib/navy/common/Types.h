@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include <folly/Function.h>
 #include <folly/Range.h>
 
 #include <cstdint>
@@ -68,6 +69,14 @@ using DestructorCallback =
 // Checking NvmItem expired
 using ExpiredCheck = std::function<bool(BufferView value)>;
 
+// Offers an entry that is reclaimed from flash to the DRAM cache. Returns
+// true if the DRAM cache took it. @isCurrent returns false once the entry is
+// removed or overwritten on flash; the DRAM cache must check it after it has
+// serialized itself with removes and before inserting the entry.
+// @key and @value are valid only during this callback invocation
+using PromotionCallback = std::function<bool(
+    HashedKey hk, BufferView value, folly::FunctionRef<bool()> isCurrent)>;
+
 // Get CounterVisitor into navy namespace.
 using CounterVisitor = util::CounterVisitor;
 
@@ -376,6 +376,113 @@ TEST(Device, Stats) {
            0));
   EXPECT_CALL(visitor, call(strPiece("navy_device_encryption_errors"), 0));
   EXPECT_CALL(visitor, call(strPiece("navy_device_decryption_errors"), 0));
+  EXPECT_CALL(visitor, call(strPiece("navy_device_bytes_discarded"), 0));
+  EXPECT_CALL(visitor, call(strPiece("navy_device_discard_errors"), 0));
+  EXPECT_CALL(visitor, call(strPiece("navy_device_discards_skipped"), 0));
+  device.getCounters({toCallback(visitor)});
+}
+
+TEST(Device, Discard) {
+  constexpr uint32_t kSize = 4 * 1024;
+  auto device = createMemoryDevice(kSize, nullptr /* encryptor */);
+  Buffer wbuf = device->makeIOBuffer(kSize);
+  std::memset(wbuf.data(), 'A', kSize);
+  ASSERT_TRUE(device->write(0, wbuf.copy()));
+
+  // no-op unless enabled
+  EXPECT_FALSE(device->isDiscardEnabled());
+  EXPECT_FALSE(device->discard(1024, 1024));
+
+  device->enableDiscard();
+  EXPECT_TRUE(device->discard(1024, 1024));
+  EXPECT_EQ(1024, device->getBytesDiscarded());
+
+  Buffer rbuf = device->makeIOBuffer(kSize);
+  ASSERT_TRUE(device->read(0, kSize, rbuf.data()));
+  for (uint32_t i = 0; i < kSize; i++) {
+    EXPECT_EQ(i >= 1024 && i < 2048 ? 0 : 'A', rbuf.data()[i]) << i;
+  }
+
+  // a rate below the size of a discard still lets it through once the
+  // tokens add up to it
+  auto limited = createMemoryDevice(kSize, nullptr /* encryptor */);
+  limited->enableDiscard(1024 /* maxBytesPerSec */, 2048 /* maxDiscardSize */);
+  EXPECT_TRUE(limited->discard(0, 2048));
+  EXPECT_FALSE(limited->discard(2048, 2048));
+  EXPECT_EQ(2048, limited->getBytesDiscarded());
+
+  MockDevice failing{kSize, 1};
+  failing.enableDiscard();
+  EXPECT_CALL(failing, discardImpl(0, 1024)).WillOnce(testing::Return(false));
+  EXPECT_FALSE(failing.discard(0, 1024));
+  EXPECT_EQ(0, failing.getBytesDiscarded());
+
+  MockCounterVisitor visitor;
+  EXPECT_CALL(visitor, call(_, _)).WillRepeatedly(testing::Return());
+  EXPECT_CALL(visitor, call(strPiece("navy_device_discard_errors"), 1));
+  failing.getCounters({toCallback(visitor)});
+}
+
+TEST(Device, SparseMemory) {
+  constexpr uint32_t kSize = 64 * 1024;
+  auto device = createSparseMemoryDevice(kSize, nullptr /* encryptor */);
+  auto storedBytes = [&device]() {
+    double stored = 0;
+    device->getCounters({[&stored](folly::StringPiece name, double value) {
+      if (name == "navy_device_sparse_stored_bytes") {
+        stored = value;
+      }
+    }});
+    return stored;
+  };
+
+  // zeros are not stored
+  Buffer wbuf = device->makeIOBuffer(4 * 4096);
+  std::memset(wbuf.data(), 0, wbuf.size());
+  ASSERT_TRUE(device->write(0, wbuf.copy()));
+  EXPECT_EQ(0, storedBytes());
+
+  // a header in the last page of an entry stores only that page
+  std::memset(wbuf.data() + 3 * 4096 + 100, 'A', 10);
+  ASSERT_TRUE(device->write(4096, wbuf.copy()));
+  EXPECT_EQ(4096, storedBytes());
+  auto rbuf = device->read(4096, 4 * 4096);
+  EXPECT_EQ(wbuf.view(), rbuf.view());
+
+  // unaligned writes across pages
+  Buffer small = device->makeIOBuffer(200);
+  std::memset(small.data(), 'B', small.size());
+  ASSERT_TRUE(device->write(4096 - 100, small.copy()));
+  EXPECT_EQ(3 * 4096, storedBytes());
+  rbuf = device->read(4096 - 100, 200);
+  EXPECT_EQ(small.view(), rbuf.view());
+
+  // zeroed pages are dropped
+  device->enableDiscard();
+  EXPECT_TRUE(device->discard(0, kSize));
+  EXPECT_EQ(0, storedBytes());
+  rbuf = device->read(4096, 4 * 4096);
+  for (uint32_t i = 0; i < rbuf.size(); i++) {
+    EXPECT_EQ(0, rbuf.data()[i]) << i;
+  }
+}
+
+TEST(Device, DiscardRateLimit) {
+  MockDevice device{4 * 1024, 1};
+  device.enableDiscard(2048 /* bytes per sec */);
+  EXPECT_CALL(device, discardImpl(_, _)).Times(3);
+
+  EXPECT_TRUE(device.discard(0, 1024));
+  EXPECT_TRUE(device.discard(1024, 1024));
+  // over the burst size
+  EXPECT_FALSE(device.discard(2048, 1024));
+  // unless the discard is not rate limited
+  EXPECT_TRUE(device.discard(2048, 1024, false /* rateLimited */));
+  EXPECT_EQ(3 * 1024, device.getBytesDiscarded());
+
+  MockCounterVisitor visitor;
+  EXPECT_CALL(visitor, call(_, _)).WillRepeatedly(testing::Return());
+  EXPECT_CALL(visitor, call(strPiece("navy_device_discards_skipped"), 1));
   device.getCounters({toCallback(visitor)});
 }
 
@@ -528,6 +635,47 @@ TEST_P(DeviceParamTest, RAID0IO) {
   }
 }
 
+TEST_P(DeviceParamTest, RAID0Discard) {
+  auto filePath =
+      folly::sformat("/tmp/DEVICE_RAID0DISCARD_TEST-{}", ::getpid());
+  util::makeDir(filePath);
+  SCOPE_EXIT { util::removePath(filePath); };
+
+  std::vector<std::string> filePaths = {filePath + "/CACHE0",
+                                        filePath + "/CACHE1"};
+
+  int size = 1024 * 1024;
+  int ioAlignSize = 4096;
+  int stripeSize = 8192;
+
+  auto device =
+      createFileDevice(filePaths, size, false /* truncateFile */, ioAlignSize,
+                       stripeSize, 0 /* max device write size */, ioEngine_,
+                       qDepth_, false /* isFDPEnabled */,
+                       nullptr /* encryptor */, false /* isExclusiveOwner */);
+  device->enableDiscard();
+
+  // fill several stripes and discard a range that spans both devices and is
+  // not aligned to the stripes
+  const int ioSize = 8 * stripeSize;
+  Buffer wbuf = device->makeIOBuffer(ioSize);
+  std::memset(wbuf.data(), 'A', ioSize);
+  ASSERT_TRUE(device->write(0, wbuf.copy(ioAlignSize)));
+
+  const int discardOffset = stripeSize + ioAlignSize;
+  const int discardSize = 4 * stripeSize;
+  ASSERT_TRUE(device->discard(discardOffset, discardSize));
+  EXPECT_EQ(discardSize, device->getBytesDiscarded());
+
+  Buffer rbuf = device->makeIOBuffer(ioSize);
+  ASSERT_TRUE(device->read(0, ioSize, rbuf.data()));
+  for (int i = 0; i < ioSize; i++) {
+    const bool discarded =
+        i >= discardOffset && i < discardOffset + discardSize;
+    ASSERT_EQ(discarded ? 0 : 'A', rbuf.data()[i]) << i;
+  }
+}
+
 TEST_P(DeviceParamTest, RAID0IOAlignment) {
   // The goal of this test is to ensure we cannot create a RAID0 device
   // if each individual device is not aligned to stripe size. This is to
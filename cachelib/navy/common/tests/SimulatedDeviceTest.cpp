@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <folly/Random.h>
+#include <folly/fibers/FiberManagerMap.h>
+#include <folly/io/async/EventBase.h>
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <map>
+#include <thread>
+
+#include "cachelib/navy/common/SimulatedDevice.h"
+#include "cachelib/navy/testing/BufferGen.h"
+
+namespace facebook {
+namespace cachelib {
+namespace navy {
+namespace tests {
+namespace {
+using namespace std::chrono_literals;
+
+constexpr uint64_t kDeviceSize = 16 * 1024 * 1024;
+
+SimulatedDeviceConfig statsOnlyConfig() {
+  SimulatedDeviceConfig config;
+  config.injectLatency = false;
+  config.eraseBlockSize = 256 * 1024;
+  return config;
+}
+
+std::map<std::string, double> getCounters(const Device& device) {
+  std::map<std::string, double> counters;
+  device.getCounters({[&counters](folly::StringPiece name, double value) {
+    counters[name.str()] = value;
+  }});
+  return counters;
+}
+
+uint64_t elapsedUs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+} // namespace
+
+TEST(SimulatedDevice, ConfigValidation) {
+  EXPECT_NO_THROW(SimulatedDeviceConfig{}.validate());
+  {
+    SimulatedDeviceConfig config;
+    config.numChannels = 0;
+    EXPECT_THROW(config.validate(), std::invalid_argument);
+  }
+  {
+    SimulatedDeviceConfig config;
+    config.readLatencyP99 = config.readLatencyP50 - 1us;
+    EXPECT_THROW(config.validate(), std::invalid_argument);
+  }
+  {
+    SimulatedDeviceConfig config;
+    config.channelWriteBytesPerSec = 0;
+    EXPECT_THROW(config.validate(), std::invalid_argument);
+  }
+  {
+    SimulatedDeviceConfig config;
+    config.eraseBlockSize = config.pageSize * 3 / 2;
+    EXPECT_THROW(config.validate(), std::invalid_argument);
+    EXPECT_THROW(createSimulatedDevice(kDeviceSize, config, nullptr),
+                 std::invalid_argument);
+  }
+}
+
+TEST(SimulatedDevice, ReadWrite) {
+  auto device = createSimulatedDevice(kDeviceSize, statsOnlyConfig(), nullptr);
+  BufferGen bg;
+  auto buffer = bg.gen(8192);
+  EXPECT_TRUE(device->write(4096, buffer.copy()));
+  auto read = device->read(4096, 8192);
+  EXPECT_EQ(buffer.view(), read.view());
+
+  device->enableDiscard();
+  EXPECT_TRUE(device->discard(4096, 8192));
+  read = device->read(4096, 8192);
+  EXPECT_EQ(0, read.data()[0]);
+}
+
+TEST(SimulatedDevice, WriteAmplification) {
+  // overwriting the device sequentially invalidates whole erase blocks
+  auto sequential =
+      createSimulatedDevice(kDeviceSize, statsOnlyConfig(), nullptr);
+  Buffer region{1024 * 1024};
+  for (int pass = 0; pass < 4; pass++) {
+    for (uint64_t offset = 0; offset < kDeviceSize; offset += region.size()) {
+      EXPECT_TRUE(sequential->write(offset, region.view()));
+    }
+  }
+  auto counters = getCounters(*sequential);
+  EXPECT_DOUBLE_EQ(1, counters["navy_device_sim_write_amp"]);
+  EXPECT_EQ(0, counters["navy_device_sim_gc_relocated_bytes"]);
+  EXPECT_GT(counters["navy_device_sim_erases"], 0);
+
+  // random page overwrites of a full device make the GC relocate pages
+  auto random = createSimulatedDevice(kDeviceSize, statsOnlyConfig(), nullptr);
+  for (uint64_t offset = 0; offset < kDeviceSize; offset += region.size()) {
+    EXPECT_TRUE(random->write(offset, region.view()));
+  }
+  Buffer page{4096};
+  for (uint64_t i = 0; i < 4 * kDeviceSize / page.size(); i++) {
+    const auto offset =
+        folly::Random::rand64(kDeviceSize / page.size()) * page.size();
+    EXPECT_TRUE(random->write(offset, page.view()));
+  }
+  counters = getCounters(*random);
+  EXPECT_GT(counters["navy_device_sim_write_amp"], 2);
+  EXPECT_GT(counters["navy_device_sim_gc_relocated_bytes"], 0);
+}
+
+TEST(SimulatedDevice, Latency) {
+  SimulatedDeviceConfig config;
+  config.numChannels = 2;
+  config.channelStripeSize = 4096;
+  config.readLatencyP50 = 2ms;
+  config.readLatencyP99 = 2ms;
+  config.writeLatencyP50 = 4ms;
+  config.writeLatencyP99 = 4ms;
+  auto device = createSimulatedDevice(kDeviceSize, config, nullptr);
+
+  auto start = std::chrono::steady_clock::now();
+  device->read(0, 4096);
+  EXPECT_GE(elapsedUs(start), 2000);
+
+  // a read queues behind a write of its channel, but not behind one of the
+  // other channel
+  Buffer page{4096};
+  std::thread writer{[&]() { device->write(0, page.view()); }};
+  std::this_thread::sleep_for(500us);
+  start = std::chrono::steady_clock::now();
+  device->read(4096, 4096);
+  EXPECT_LT(elapsedUs(start), 3500);
+  start = std::chrono::steady_clock::now();
+  device->read(2 * 4096, 4096);
+  EXPECT_GE(elapsedUs(start), 4000);
+  writer.join();
+
+  EXPECT_GT(getCounters(*device)["navy_device_sim_queue_wait_us"], 0);
+}
+
+TEST(SimulatedDevice, FibersOverlap) {
+  SimulatedDeviceConfig config;
+  config.numChannels = 8;
+  config.channelStripeSize = 4096;
+  config.readLatencyP50 = 20ms;
+  config.readLatencyP99 = 20ms;
+  auto device = createSimulatedDevice(kDeviceSize, config, nullptr);
+
+  // reads of different channels issued by fibers of one thread are served
+  // concurrently, as they are for navy jobs
+  folly::EventBase evb;
+  auto& fm = folly::fibers::getFiberManager(evb);
+  for (uint32_t i = 0; i < config.numChannels; i++) {
+    fm.addTask([&device, i]() {
+      EXPECT_EQ(4096, device->read(i * 4096, 4096).size());
+    });
+  }
+  const auto start = std::chrono::steady_clock::now();
+  evb.loop();
+  const auto elapsed = elapsedUs(start);
+  EXPECT_GE(elapsed, 20'000);
+  EXPECT_LT(elapsed, 20'000 * config.numChannels / 2);
+}
+
+TEST(SimulatedDevice, Calibration) {
+  SimulatedDeviceConfig real;
+  real.numChannels = 4;
+  real.readLatencyP50 = 400us;
+  real.readLatencyP99 = 800us;
+  auto device = createSimulatedDevice(kDeviceSize, real, nullptr);
+
+  CalibrationOptions options;
+  options.testBytes = 4 * 1024 * 1024;
+  options.numSamples = 50;
+  options.maxThreads = 16;
+  auto calibrated = calibrateSimulatedDevice(*device, options);
+  EXPECT_NO_THROW(calibrated.validate());
+  EXPECT_GE(calibrated.numChannels, 2);
+  EXPECT_LE(calibrated.numChannels, 8);
+  EXPECT_GE(calibrated.readLatencyP50, 300us);
+  EXPECT_LE(calibrated.readLatencyP50, 800us);
+
+  options.testBytes = 1024;
+  EXPECT_THROW(calibrateSimulatedDevice(*device, options),
+               std::invalid_argument);
+}
+} // namespace tests
+} // namespace navy
+} // namespace cachelib
+} // namespace facebook
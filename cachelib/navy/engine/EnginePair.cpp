@@ -16,6 +16,7 @@
 
 #include "cachelib/navy/engine/EnginePair.h"
 
+#include "cachelib/common/LatencyTracer.h"
 #include "cachelib/navy/engine/NoopEngine.h"
 
 namespace facebook::cachelib::navy {
@@ -113,7 +114,9 @@ void EnginePair::scheduleInsert(HashedKey hk,
                                 InsertCallback cb) {
   insertCount_.inc();
   scheduler_->enqueueWithKey(
-      [this, cb = std::move(cb), hk, value, skipInsertion = false]() mutable {
+      [this, cb = std::move(cb), hk, value, skipInsertion = false,
+       trace = TraceHandoff{}]() mutable {
+        TraceResumeGuard traceGuard{trace, TraceStage::kNavyQueue};
         auto status = insertInternal(hk, value, skipInsertion);
         if (status == Status::Retry) {
           return JobExitCode::Reschedule;
@@ -165,7 +168,9 @@ Status EnginePair::lookupInternal(HashedKey hk,
 
 void EnginePair::scheduleLookup(HashedKey hk, LookupCallback cb) {
   scheduler_->enqueueWithKey(
-      [this, cb = std::move(cb), hk, skipLargeItemCache = false]() mutable {
+      [this, cb = std::move(cb), hk, skipLargeItemCache = false,
+       trace = TraceHandoff{}]() mutable {
+        TraceResumeGuard traceGuard{trace, TraceStage::kNavyQueue};
         Buffer value;
         Status status = lookupInternal(hk, value, skipLargeItemCache);
         if (status == Status::Retry) {
@@ -220,7 +225,9 @@ void EnginePair::scheduleRemove(HashedKey hk, RemoveCallback cb) {
       [this,
        cb = std::move(cb),
        hk = hk,
-       skipSmallItemCache = false]() mutable {
+       skipSmallItemCache = false,
+       trace = TraceHandoff{}]() mutable {
+        TraceResumeGuard traceGuard{trace, TraceStage::kNavyQueue};
         auto status = removeHashedKeyInternal(hk, skipSmallItemCache);
         if (status == Status::Retry) {
           return JobExitCode::Reschedule;
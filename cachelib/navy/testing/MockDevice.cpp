@@ -52,6 +52,9 @@ MockDevice::MockDevice(uint64_t deviceSize,
   ON_CALL(*this, allocatePlacementHandle()).WillByDefault(testing::Invoke([]() {
     return -1;
   }));
+
+  ON_CALL(*this, discardImpl(testing::_, testing::_))
+      .WillByDefault(testing::Return(true));
 }
 } // namespace navy
 } // namespace cachelib
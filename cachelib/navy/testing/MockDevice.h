@@ -45,6 +45,7 @@ class MockDevice : public Device {
   MOCK_METHOD4(writeImpl, bool(uint64_t, uint32_t, const void*, int));
   MOCK_METHOD0(flushImpl, void());
   MOCK_METHOD0(allocatePlacementHandle, int());
+  MOCK_METHOD2(discardImpl, bool(uint64_t, uint64_t));
 
   // Returns pointer to the device backing this mock object. This is
   // useful if user wants to bypass the mock to access the real device
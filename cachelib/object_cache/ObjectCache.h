@@ -550,6 +550,7 @@ void ObjectCache<AllocatorT>::init() {
       .setDefaultAllocSizes({l1AllocSize})
       .enableItemReaperInBackground(config_.reaperInterval)
       .setEventTracker(std::move(config_.eventTracker))
+      .setBackgroundExecutor(config_.backgroundExecutor)
       .setEvictionSearchLimit(config_.evictionSearchLimit)
       .setItemDestructor([this](typename AllocatorT::DestructorData data) {
         ObjectCacheDestructorContext ctx;
@@ -634,17 +635,19 @@ template <typename AllocatorT>
 void ObjectCache<AllocatorT>::initWorkers() {
   if (config_.objectSizeTrackingEnabled &&
       config_.sizeControllerIntervalMs != 0) {
-    util::startPeriodicWorker(
+    util::startPeriodicWorkerOnExecutor(
         kSizeControllerName, sizeController_,
-        std::chrono::milliseconds{config_.sizeControllerIntervalMs}, *this,
-        config_.sizeControllerThrottlerConfig);
+        std::chrono::milliseconds{config_.sizeControllerIntervalMs},
+        config_.backgroundExecutor, BackgroundExecutor::Priority::kNormal,
+        *this, config_.sizeControllerThrottlerConfig);
   }
 
   if (config_.objectSizeTrackingEnabled &&
       config_.objectSizeDistributionTrackingEnabled) {
-    util::startPeriodicWorker(
+    util::startPeriodicWorkerOnExecutor(
         kSizeDistTrackerName, sizeDistTracker_,
-        std::chrono::seconds{60} /*default interval to be 60s*/, *this);
+        std::chrono::seconds{60} /*default interval to be 60s*/,
+        config_.backgroundExecutor, BackgroundExecutor::Priority::kLow, *this);
   }
 }
 
@@ -20,6 +20,7 @@
 #include <string>
 
 #include "cachelib/allocator/KAllocation.h"
+#include "cachelib/common/BackgroundExecutor.h"
 #include "cachelib/common/EventInterface.h"
 #include "cachelib/common/Throttler.h"
 
@@ -77,6 +78,11 @@ struct ObjectCacheConfig {
   // Enable event tracker. This will log all relevant cache events.
   ObjectCacheConfig& setEventTracker(EventTrackerSharedPtr&& ptr);
 
+  // Run the background workers of the cache, including the ones of the
+  // underlying allocator, on the given executor instead of a thread each.
+  ObjectCacheConfig& setBackgroundExecutor(
+      std::shared_ptr<BackgroundExecutor> executor);
+
   // You MUST set this callback to release the removed/evicted/expired objects
   // memory; otherwise, memory leak will happen.
   // 1) store a single type Foo
@@ -193,6 +199,10 @@ struct ObjectCacheConfig {
   // Callback for initializing the eventTracker on CacheAllocator construction
   EventTrackerSharedPtr eventTracker{nullptr};
 
+  // Executor running the background workers. Each worker has its own thread
+  // if not set.
+  std::shared_ptr<BackgroundExecutor> backgroundExecutor{nullptr};
+
   // ItemDestructor which is invoked for each item that is evicted
   // or explicitly from cache
   ItemDestructor itemDestructor{};
@@ -310,6 +320,13 @@ ObjectCacheConfig<T>& ObjectCacheConfig<T>::setEventTracker(
   return *this;
 }
 
+template <typename T>
+ObjectCacheConfig<T>& ObjectCacheConfig<T>::setBackgroundExecutor(
+    std::shared_ptr<BackgroundExecutor> executor) {
+  backgroundExecutor = std::move(executor);
+  return *this;
+}
+
 template <typename T>
 ObjectCacheConfig<T>& ObjectCacheConfig<T>::setItemDestructor(
     ItemDestructor destructor) {
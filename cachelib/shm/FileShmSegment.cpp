@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cachelib/shm/FileShmSegment.h"
+
+#include <fcntl.h>
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "cachelib/common/Utils.h"
+
+namespace facebook {
+namespace cachelib {
+
+namespace {
+constexpr mode_t kRWMode = 0666;
+
+const std::string& checkOpts(const ShmSegmentOpts& opts) {
+  if (opts.filePath.empty()) {
+    throw std::invalid_argument("File backed segment needs a file path");
+  }
+  if (opts.pageSize != PageSizeT::NORMAL) {
+    throw std::invalid_argument(folly::sformat(
+        "Huge pages are not supported for file backed segment {}",
+        opts.filePath));
+  }
+  return opts.filePath;
+}
+
+bool isCharDevice(const std::string& path) {
+  mode_t mode = 0;
+  return util::getStatIfExists(path, &mode) && S_ISCHR(mode);
+}
+
+// size of the devdax character device open at fd. Device nodes can not be
+// sized with fstat, so this reads the size the kernel exports in sysfs.
+size_t getCharDeviceSize(int fd, const std::string& path) {
+  struct stat buf = {};
+  detail::fstatImpl(fd, &buf);
+  XDCHECK(S_ISCHR(buf.st_mode));
+  const auto sizePath = folly::sformat("/sys/dev/char/{}:{}/size",
+                                       major(buf.st_rdev), minor(buf.st_rdev));
+  std::string content;
+  if (!folly::readFile(sizePath.c_str(), content)) {
+    throw std::invalid_argument(folly::sformat(
+        "{} is a character device without a size at {}. Only devdax devices "
+        "can back a segment",
+        path, sizePath));
+  }
+  const auto size = folly::to<size_t>(folly::trimWhitespace(content));
+  if (size == 0 || !detail::isPageAlignedSize(size)) {
+    throw std::invalid_argument(
+        folly::sformat("Invalid size {} of device {}", size, path));
+  }
+  return size;
+}
+} // namespace
+
+FileShmSegment::FileShmSegment(ShmAttachT, ShmSegmentOpts opts)
+    : ShmBase(opts, checkOpts(opts)),
+      fd_(openFile(opts_, false /* create */)) {
+  XDCHECK_NE(fd_, kInvalidFD);
+  if (isCharDevice(getName())) {
+    initDeviceSize(0);
+  }
+  markActive();
+  createReferenceMapping();
+}
+
+FileShmSegment::FileShmSegment(ShmNewT, size_t size, ShmSegmentOpts opts)
+    : ShmBase(opts, checkOpts(opts)),
+      fd_(openFile(opts_, true /* create */)) {
+  XDCHECK_NE(fd_, kInvalidFD);
+  const size_t alignedSize = detail::getPageAlignedSize(size);
+  if (isCharDevice(getName())) {
+    // the segment spans the whole device, which can not be resized.
+    initDeviceSize(alignedSize);
+    markActive();
+  } else {
+    markActive();
+    detail::ftruncateImpl(fd_, alignedSize);
+  }
+  // this ensures that the file lives while the object lives.
+  createReferenceMapping();
+}
+
+FileShmSegment::~FileShmSegment() {
+  try {
+    deleteReferenceMapping();
+  } catch (const std::system_error&) {
+  }
+
+  if (fd_ != kInvalidFD) {
+    const int ret = close(fd_);
+    if (ret != 0) {
+      XDCHECK_EQ(errno, EBADF);
+    }
+  }
+}
+
+void FileShmSegment::initDeviceSize(size_t minSize) {
+  try {
+    deviceSize_ = getCharDeviceSize(fd_, getName());
+    if (minSize > deviceSize_) {
+      throw std::invalid_argument(folly::sformat(
+          "Segment of size {} does not fit in device {} of size {}", minSize,
+          getName(), deviceSize_));
+    }
+  } catch (const std::exception&) {
+    // the destructor does not run when the constructor throws
+    close(fd_);
+    throw;
+  }
+}
+
+int FileShmSegment::openFile(const ShmSegmentOpts& opts, bool create) {
+  int flags = O_CLOEXEC;
+  // device nodes are neither created nor truncated, their content is simply
+  // overwritten by the new segment.
+  if (create && !isCharDevice(opts.filePath)) {
+    flags |= O_RDWR | O_CREAT | O_TRUNC;
+  } else {
+    flags |= opts.readOnly ? O_RDONLY : O_RDWR;
+  }
+  const int fd = open(opts.filePath.c_str(), flags, kRWMode);
+  if (fd == -1) {
+    util::throwSystemError(
+        errno, folly::sformat("Failed to open {}", opts.filePath));
+  }
+  return fd;
+}
+
+void FileShmSegment::markForRemoval() {
+  if (isActive()) {
+    // the open fd and any mappings keep the memory alive until this object
+    // is destroyed.
+    removeByPath(getName());
+    markForRemove();
+  } else {
+    XDCHECK(false);
+  }
+}
+
+bool FileShmSegment::removeByPath(const std::string& path) {
+  // never unlink a device node. The memory of the device is reused by the
+  // next segment created on it.
+  if (isCharDevice(path)) {
+    return true;
+  }
+  if (unlink(path.c_str()) == 0) {
+    return true;
+  }
+  if (errno != ENOENT) {
+    util::throwSystemError(errno, folly::sformat("Failed to remove {}", path));
+  }
+  return false;
+}
+
+size_t FileShmSegment::getSize() const {
+  if (isActive() || isMarkedForRemoval()) {
+    if (deviceSize_ != 0) {
+      return deviceSize_;
+    }
+    struct stat buf = {};
+    detail::fstatImpl(fd_, &buf);
+    return buf.st_size;
+  }
+  throw std::runtime_error(folly::sformat(
+      "Trying to get size of segment with path {} in an invalid state",
+      getName()));
+}
+
+void* FileShmSegment::mapAddress(void* addr) const {
+  const size_t size = getSize();
+  if (!detail::isPageAlignedSize(size) || !detail::isPageAlignedAddr(addr)) {
+    util::throwSystemError(EINVAL, "Address/size not aligned");
+  }
+
+  int flags = MAP_SHARED;
+  // If users pass in an address, they must make sure that address is unused.
+  if (addr != nullptr) {
+    flags |= MAP_FIXED;
+  }
+  const int prot = opts_.readOnly ? PROT_READ : PROT_WRITE | PROT_READ;
+
+  void* retAddr = detail::mmapImpl(addr, size, prot, flags, fd_, 0);
+  if (retAddr != nullptr && addr != nullptr && retAddr != addr) {
+    util::throwSystemError(EINVAL, "Address already mapped");
+  }
+  XDCHECK(retAddr == addr || addr == nullptr);
+  return retAddr;
+}
+
+void FileShmSegment::unMap(void* addr) const {
+  detail::munmapImpl(addr, getSize());
+}
+
+void FileShmSegment::createReferenceMapping() {
+  // device nodes are never unlinked and hence need no reference mapping. A
+  // devdax device would also reject a mapping smaller than its alignment.
+  if (deviceSize_ != 0) {
+    return;
+  }
+  // create a mapping that lasts the life of this object. mprotect it to
+  // ensure there are no actual accesses.
+  referenceMapping_ = detail::mmapImpl(nullptr, detail::getPageSize(),
+                                       PROT_NONE, MAP_SHARED, fd_, 0);
+  XDCHECK(referenceMapping_ != nullptr);
+}
+
+void FileShmSegment::deleteReferenceMapping() const {
+  if (referenceMapping_ != nullptr) {
+    detail::munmapImpl(referenceMapping_, detail::getPageSize());
+  }
+}
+} // namespace cachelib
+} // namespace facebook
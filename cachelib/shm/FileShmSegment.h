@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#include <string>
+
+#include "cachelib/shm/PosixShmSegment.h"
+#include "cachelib/shm/ShmCommon.h"
+
+namespace facebook {
+namespace cachelib {
+
+/* This class lets you manage a segment backed by a file at a given path.
+ * Mapping a file on tmpfs behaves like a posix shm segment, while a file on
+ * a DAX mounted file system (eg. persistent memory or CXL memory) or on a
+ * plain file system lets the cache use memory that is cheaper than DRAM. The
+ * file is mapped with MAP_SHARED and hence its contents outlive the process,
+ * which allows re-attaching to it after a restart.
+ *
+ * The path can also be a devdax character device (eg. /dev/dax0.0). Such a
+ * device is never created, truncated or unlinked. The segment always spans
+ * the whole device, whose size is read from sysfs, and the device alignment
+ * (usually 2MB) must divide the alignment of the mapping address.
+ *
+ * The name of the segment is the path of the file. Huge pages and numa
+ * bindings are not supported since the placement of the memory is decided by
+ * the file system backing the path.
+ */
+class FileShmSegment : public ShmBase {
+ public:
+  // attach to the existing file at opts.filePath
+  //
+  // @param opts  the options for attaching to the segment.
+  // @throw std::system_error with ENOENT if the file does not exist.
+  FileShmSegment(ShmAttachT, ShmSegmentOpts opts);
+
+  // create a new file at opts.filePath, truncating any existing content.
+  //
+  // @param size  The size of the segment. This will be rounded up to the
+  //              nearest page size. For a devdax device, this must fit in
+  //              the device and the segment spans the whole device.
+  // @param opts  the options for the segment.
+  // @throw std::invalid_argument if the path is a character device that is
+  //        not a devdax device or is too small.
+  FileShmSegment(ShmNewT, size_t size, ShmSegmentOpts opts);
+
+  // destructor
+  ~FileShmSegment() override;
+
+  std::string getKeyStr() const noexcept override { return getName(); }
+
+  // removes the file. The memory is freed once the segment is no longer
+  // mapped by any process.
+  void markForRemoval() override;
+
+  // return the current size of the segment.
+  size_t getSize() const override;
+
+  // attaches the segment from the start to the address space of the
+  // caller. the address must be page aligned.
+  // @param addr   the start of the address for attaching.
+  //
+  // @return  the address where  the segment was mapped to. This will be same
+  // as addr if addr is not nullptr
+  // @throw std::system_error with EINVAL if the address is not page aligned.
+  void* mapAddress(void* addr) const override;
+
+  // unmaps the memory from addr up to the size of the segment.
+  void unMap(void* addr) const override;
+
+  // useful for removing without attaching. Device nodes are left in place.
+  // @return true if the file existed. false otherwise
+  static bool removeByPath(const std::string& path);
+
+ private:
+  static int openFile(const ShmSegmentOpts& opts, bool create);
+
+  // sets deviceSize_ for a segment backed by a devdax device and closes fd_
+  // if the device is not usable.
+  //
+  // @param minSize  the size the device must at least have.
+  // @throw std::invalid_argument if the device is not a devdax device or is
+  //        smaller than minSize.
+  void initDeviceSize(size_t minSize);
+
+  void createReferenceMapping();
+  void deleteReferenceMapping() const;
+
+  // file descriptor associated with the file. This has FD_CLOEXEC set and
+  // once opened, we close this only on destruction of this object
+  int fd_{kInvalidFD};
+
+  // size of the devdax device backing the segment. 0 for regular files.
+  size_t deviceSize_{0};
+};
+} // namespace cachelib
+} // namespace facebook
@@ -24,6 +24,16 @@ namespace cachelib {
 
 constexpr int kInvalidFD = -1;
 
+namespace detail {
+// wrappers around the system calls for segments backed by a file descriptor.
+// These throw std::system_error with the appropriate errno on failure.
+void ftruncateImpl(int fd, size_t size);
+void fstatImpl(int fd, struct stat* buf);
+void* mmapImpl(
+    void* addr, size_t length, int prot, int flags, int fd, off_t offset);
+void munmapImpl(void* addr, size_t length);
+} // namespace detail
+
 /* This class lets you manage a posix shared memory segment identified by
  * name. This is very similar to the System V shared memory segment, except
  * that it allows for resizing of the segments on the fly. This can let the
@@ -22,6 +22,7 @@
 #include <sys/shm.h>
 #include <sys/stat.h>
 
+#include <string>
 #include <system_error>
 
 #pragma GCC diagnostic push
@@ -128,6 +129,11 @@ struct ShmSegmentOpts {
   bool readOnly{false};
   size_t alignment{1}; // alignment for mapping.
   NumaBitMask memBindNumaNodes;
+  // when set, the segment is backed by the file at this path instead of
+  // anonymous shared memory. Use a path on tmpfs, a DAX mounted file system
+  // or a plain file system, or a devdax device (see FileShmSegment) for
+  // memory that is cheaper than DRAM.
+  std::string filePath{};
 
   explicit ShmSegmentOpts(PageSizeT p) : pageSize(p) {}
   explicit ShmSegmentOpts(PageSizeT p, bool ro) : pageSize(p), readOnly(ro) {}
@@ -145,7 +151,7 @@ struct ShmAddr {
   size_t size{0};      // length from start that actually has a backing shm
 };
 
-/* common interface for both posix and sysv shared memory segments */
+/* common interface for the posix, sysv and file backed segments */
 class ShmBase {
  public:
   ShmBase(ShmSegmentOpts opts, std::string name)
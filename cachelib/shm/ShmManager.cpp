@@ -98,6 +98,7 @@ ShmManager::ShmManager(const std::string& dir, bool usePosix)
   const bool reattach = dropSegments ? false : initFromFile();
   if (!reattach) {
     DCHECK(nameToKey_.empty());
+    DCHECK(nameToFile_.empty());
   }
   // Lock file for exclusive access
   lockMetadataFile(metaFile);
@@ -140,6 +141,9 @@ bool ShmManager::initFromFile() {
   for (const auto& kv : *object.nameToKeyMap()) {
     nameToKey_.insert({kv.first, kv.second});
   }
+  for (const auto& kv : *object.nameToFileMap()) {
+    nameToFile_.insert({kv.first, kv.second});
+  }
 
   return true;
 }
@@ -171,6 +175,10 @@ typename ShmManager::ShutDownRes ShmManager::writeActiveSegmentsToFile() {
     // segment exists and is active.
     if (it != segments_.end() && it->second->isActive()) {
       object.nameToKeyMap()[name] = key;
+      const auto fileIt = nameToFile_.find(name);
+      if (fileIt != nameToFile_.end()) {
+        object.nameToFileMap()[name] = fileIt->second;
+      }
     }
   }
 
@@ -199,6 +207,7 @@ typename ShmManager::ShutDownRes ShmManager::shutDown() {
   // clear our data.
   segments_.clear();
   nameToKey_.clear();
+  nameToFile_.clear();
   return ret;
 }
 
@@ -246,11 +255,20 @@ void ShmManager::cleanup(const std::string& dir, bool posix) {
   ShmManager s(dir, posix);
 }
 
+bool ShmManager::removeSegment(const std::string& shmName) {
+  const auto it = nameToFile_.find(shmName);
+  if (it != nameToFile_.end()) {
+    return FileShmSegment::removeByPath(it->second);
+  }
+  return removeSegByName(usePosix_, uniqueIdForName(shmName));
+}
+
 void ShmManager::removeAllSegments() {
   for (const auto& kv : nameToKey_) {
-    removeSegByName(usePosix_, uniqueIdForName(kv.first));
+    removeSegment(kv.first);
   }
   nameToKey_.clear();
+  nameToFile_.clear();
 }
 
 void ShmManager::removeUnAttachedSegments() {
@@ -259,7 +277,8 @@ void ShmManager::removeUnAttachedSegments() {
     const auto name = it->first;
     // check if the segment is attached.
     if (segments_.find(name) == segments_.end()) { // not attached
-      removeSegByName(usePosix_, uniqueIdForName(name));
+      removeSegment(name);
+      nameToFile_.erase(name);
       it = nameToKey_.erase(it);
     } else {
       ++it;
@@ -278,6 +297,7 @@ ShmAddr ShmManager::createShm(const std::string& shmName,
 
   DCHECK(segments_.find(shmName) == segments_.end());
   DCHECK(nameToKey_.find(shmName) == nameToKey_.end());
+  DCHECK(nameToFile_.find(shmName) == nameToFile_.end());
 
   std::unique_ptr<ShmSegment> newSeg;
   try {
@@ -305,6 +325,9 @@ ShmAddr ShmManager::createShm(const std::string& shmName,
 
   auto ret = newSeg->getCurrentMapping();
   nameToKey_.emplace(shmName, newSeg->getKeyStr());
+  if (!opts.filePath.empty()) {
+    nameToFile_.emplace(shmName, opts.filePath);
+  }
   segments_.emplace(shmName, std::move(newSeg));
   return ret;
 }
@@ -317,6 +340,18 @@ void ShmManager::attachNewShm(const std::string& shmName, ShmSegmentOpts opts) {
         folly::sformat("Unable to find any segment with name {}", shmName));
   }
 
+  // the segment must be attached through the same backing file that it was
+  // created with.
+  const auto fileIt = nameToFile_.find(shmName);
+  const std::string filePath =
+      fileIt == nameToFile_.end() ? std::string{} : fileIt->second;
+  if (filePath != opts.filePath) {
+    throw std::invalid_argument(folly::sformat(
+        "Segment {} was created with backing file '{}', but attaching with "
+        "'{}'",
+        shmName, filePath, opts.filePath));
+  }
+
   // This means the segment exists and we can try to attach it.
   try {
     segments_.emplace(shmName,
@@ -370,17 +405,18 @@ bool ShmManager::removeShm(const std::string& shmName) {
     DCHECK(shm.isInvalid());
   } catch (const std::invalid_argument&) {
     // shm by this name is not attached.
-    const bool wasPresent =
-        removeSegByName(usePosix_, uniqueIdForName(shmName));
+    const bool wasPresent = removeSegment(shmName);
     if (!wasPresent) {
       DCHECK(segments_.end() == segments_.find(shmName));
       DCHECK(nameToKey_.end() == nameToKey_.find(shmName));
+      nameToFile_.erase(shmName);
       return false;
     }
   }
   // not mapped and already removed.
   segments_.erase(shmName);
   nameToKey_.erase(shmName);
+  nameToFile_.erase(shmName);
   return true;
 }
 
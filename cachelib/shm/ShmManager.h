@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "cachelib/common/Utils.h"
+#include "cachelib/shm/FileShmSegment.h"
 #include "cachelib/shm/PosixShmSegment.h"
 #include "cachelib/shm/Shm.h"
 #include "cachelib/shm/SysVShmSegment.h"
@@ -47,7 +48,10 @@ namespace cachelib {
 // segments, new segments can also be created. This class is not thread safe.
 // In general, the approach is to return an invalid value if there is an error
 // that is possible to foresee and throw an exception if state of the instance
-// could be corrupted
+// could be corrupted.
+// Segments created with ShmSegmentOpts::filePath are backed by that file
+// instead of posix/sysv shared memory. The path is persisted along with the
+// segment and attaching to such a segment must pass the same path.
 class ShmManager {
  public:
   ShmManager(const std::string& dirName, bool usePosix);
@@ -89,6 +93,7 @@ class ShmManager {
   // @return ShmAddr for shared memory segment
   //
   // @throw   std::invalid_argument if unable to attach or map shared memory
+  //          or if the segment was created with a different backing file.
   ShmAddr attachShm(const std::string& shmName,
                     void* addr = nullptr,
                     ShmSegmentOpts opts = {});
@@ -126,7 +131,8 @@ class ShmManager {
   ShutDownRes shutDown();
 
   // useful for removing segments by name associated with a given
-  // cacheDir without instanciating.
+  // cacheDir without instanciating. This does not remove file backed
+  // segments, use cleanup() for those.
   static void removeByName(const std::string& cacheDir,
                            const std::string& segName,
                            bool posix);
@@ -205,6 +211,12 @@ class ShmManager {
   //          existed.
   bool removeUnattached(const std::string& shmName);
 
+  // removes the segment by name without attaching to it, from its backing
+  // file if it has one and from posix/sysv shared memory otherwise.
+  //
+  // @return  true if the segment was present, false if it never existed.
+  bool removeSegment(const std::string& shmName);
+
   void attachNewShm(const std::string& name, ShmSegmentOpts opts);
 
   std::string uniqueIdForName(const std::string& name) const {
@@ -227,6 +239,10 @@ class ShmManager {
   // file and used for attaching to the segment.
   folly::F14FastMap<std::string, std::string> nameToKey_{};
 
+  // name to backing file path for the segments created with a file path.
+  // This is persisted along with nameToKey_.
+  folly::F14FastMap<std::string, std::string> nameToFile_{};
+
   // file handle for the metadata file. It remains open throughout the lifetime
   // of the object.
   std::ofstream metadataStream_;
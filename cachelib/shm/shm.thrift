@@ -19,4 +19,6 @@ namespace cpp2 facebook.cachelib.serialization
 struct ShmManagerObject {
   1: required byte shmVal;
   3: required map<string, string> nameToKeyMap;
+  // backing file path for the segments that are backed by a file.
+  4: map<string, string> nameToFileMap;
 }
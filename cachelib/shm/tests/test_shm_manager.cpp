@@ -16,10 +16,12 @@
 
 #include <folly/FileUtil.h>
 #include <folly/Random.h>
+#include <folly/ScopeGuard.h>
 
 #include <fstream>
 
 #include "cachelib/common/Utils.h"
+#include "cachelib/shm/FileShmSegment.h"
 #include "cachelib/shm/PosixShmSegment.h"
 #include "cachelib/shm/ShmCommon.h"
 #include "cachelib/shm/ShmManager.h"
@@ -79,6 +81,7 @@ class ShmManagerTest : public ShmTestBase {
   void testCleanup(bool posix);
   void testAttachReadOnly(bool posix);
   void testMetaFileDeletion(bool posix);
+  void testFileBacked(bool posix);
 
  private:
   const static std::string dirPrefix;
@@ -926,3 +929,117 @@ TEST_F(ShmManagerTestPosix, TestMappingAlignment) {
 TEST_F(ShmManagerTestSysV, TestMappingAlignment) {
   testMappingAlignment(false);
 }
+
+// file backed segments on tmpfs and on a regular file system can be created
+// alongside regular segments, persist their contents across restarts and
+// are removed along with their files.
+void ShmManagerTest::testFileBacked(bool posix) {
+  using facebook::cachelib::FileShmSegment;
+  using facebook::cachelib::ShmSegmentOpts;
+  namespace util = facebook::cachelib::util;
+
+  const std::string segmentPrefix = std::to_string(::getpid());
+  const std::string seg1 = segmentPrefix + "-0";
+  const std::string seg2 = segmentPrefix + "-1";
+  const std::string seg3 = segmentPrefix + "-2";
+  const char magicVal1 = 'f';
+  const char magicVal2 = 'n';
+  const char magicVal3 = 'p';
+
+  ShmSegmentOpts opts1;
+  opts1.filePath = "/dev/shm/" + namePrefix + "-" + segmentPrefix;
+  ShmSegmentOpts opts2;
+  opts2.filePath = cacheDir + "-file";
+  SCOPE_EXIT {
+    FileShmSegment::removeByPath(opts1.filePath);
+    FileShmSegment::removeByPath(opts2.filePath);
+  };
+
+  const size_t seg1Size = getRandomSize();
+  const size_t seg2Size = getRandomSize();
+  {
+    ShmManager s(cacheDir, posix);
+    auto m1 = s.createShm(seg1, seg1Size, nullptr, opts1);
+    ASSERT_EQ(seg1Size, m1.size);
+    writeToMemory(m1.addr, m1.size, magicVal1);
+
+    auto m2 = s.createShm(seg2, seg2Size, nullptr, opts2);
+    ASSERT_EQ(seg2Size, m2.size);
+    writeToMemory(m2.addr, m2.size, magicVal2);
+
+    segmentsToDestroy.push_back(seg3);
+    auto m3 = s.createShm(seg3, getRandomSize());
+    writeToMemory(m3.addr, m3.size, magicVal3);
+
+    ASSERT_EQ(opts1.filePath, s.getShmByName(seg1).getKeyStr());
+    ASSERT_TRUE(util::getStatIfExists(opts1.filePath, nullptr));
+    ASSERT_TRUE(util::getStatIfExists(opts2.filePath, nullptr));
+    ASSERT_TRUE(s.shutDown() == ShutDownRes::kSuccess);
+  }
+
+  {
+    ShmManager s(cacheDir, posix);
+    // the backing file must match the one the segment was created with
+    ASSERT_THROW(s.attachShm(seg1), std::invalid_argument);
+    ASSERT_THROW(s.attachShm(seg1, nullptr, opts2), std::invalid_argument);
+    ASSERT_THROW(s.attachShm(seg3, nullptr, opts1), std::invalid_argument);
+
+    auto m1 = s.attachShm(seg1, nullptr, opts1);
+    ASSERT_EQ(seg1Size, m1.size);
+    checkMemory(m1.addr, m1.size, magicVal1);
+
+    auto m2 = s.attachShm(seg2, nullptr, opts2);
+    ASSERT_EQ(seg2Size, m2.size);
+    checkMemory(m2.addr, m2.size, magicVal2);
+
+    auto m3 = s.attachShm(seg3);
+    checkMemory(m3.addr, m3.size, magicVal3);
+
+    // removing the segment removes its file
+    ASSERT_TRUE(s.removeShm(seg2));
+    ASSERT_FALSE(util::getStatIfExists(opts2.filePath, nullptr));
+    ASSERT_TRUE(s.shutDown() == ShutDownRes::kSuccess);
+  }
+
+  {
+    ShmManager s(cacheDir, posix);
+    ASSERT_THROW(s.attachShm(seg2, nullptr, opts2), std::invalid_argument);
+    ASSERT_NO_THROW(s.attachShm(seg3));
+    // seg1 was not attached and is removed on shutdown
+    ASSERT_TRUE(s.shutDown() == ShutDownRes::kSuccess);
+  }
+  ASSERT_FALSE(util::getStatIfExists(opts1.filePath, nullptr));
+
+  {
+    ShmManager s(cacheDir, posix);
+    ASSERT_THROW(s.attachShm(seg1, nullptr, opts1), std::invalid_argument);
+    // a file backed segment can be created again by the same name
+    auto m1 = s.createShm(seg1, seg1Size, nullptr, opts1);
+    ASSERT_EQ(seg1Size, m1.size);
+    // dont call shutdown
+  }
+  ASSERT_FALSE(util::getStatIfExists(opts1.filePath, nullptr));
+}
+
+TEST_F(ShmManagerTestPosix, FileBacked) { testFileBacked(true); }
+
+TEST_F(ShmManagerTestSysV, FileBacked) { testFileBacked(false); }
+
+// character devices are never truncated or unlinked and only devdax devices,
+// which export their size in sysfs, can back a segment.
+TEST_F(ShmManagerTestPosix, FileBackedCharDevice) {
+  using facebook::cachelib::FileShmSegment;
+  using facebook::cachelib::ShmSegmentOpts;
+  namespace util = facebook::cachelib::util;
+
+  ShmSegmentOpts opts;
+  opts.filePath = "/dev/null";
+  {
+    ShmManager s(cacheDir, true /* posix */);
+    ASSERT_THROW(s.createShm("char-device", getRandomSize(), nullptr, opts),
+                 std::invalid_argument);
+    ASSERT_TRUE(s.shutDown() == ShutDownRes::kSuccess);
+  }
+  ASSERT_TRUE(FileShmSegment::removeByPath(opts.filePath));
+  ASSERT_TRUE(util::getStatIfExists(opts.filePath, nullptr));
+}